@@ -14,6 +14,8 @@
 namespace {
 	const float kRackAnimationTime = 10.0f;
 	const float kCueAnimationTime = 3.0f;
+	const float kFieldOfView = 45.0f * sht::math::kPi / 180.0f; // the same as in projection matrix
+	const unsigned int kBallLevelsOfDetail = 3;
 }
 
 GameScene::GameScene(sht::graphics::Renderer * renderer, sht::utility::EventListenerInterface * event_listener,
@@ -226,6 +228,9 @@ void GameScene::RenderBalls()
 		renderer_->PushMatrix();
 		renderer_->MultMatrix(balls_[i]->matrix());
 		ball_shader_->UniformMatrix4fv("u_model", renderer_->model_matrix());
+		const float distance = (balls_[i]->position() - *camera_manager_->position()).Length();
+		ball_mesh_->SelectLod(sht::graphics::ComputeScreenSize(2.0f * ball_mesh_->bounding_box().extent.Length(),
+			distance, kFieldOfView, (float)renderer_->height()));
 		ball_mesh_->Render();
 		renderer_->PopMatrix();
 	}
@@ -450,6 +455,8 @@ void GameScene::Load()
 	}
 
 	// Create meshes that have been loaded earlier
+	if (ball_mesh_->num_lods() == 1) // converted files may have them already
+		ball_mesh_->GenerateLods(kBallLevelsOfDetail);
 	ball_mesh_->AddFormat(sht::graphics::VertexAttribute(sht::graphics::VertexAttribute::kVertex, 3));
 	ball_mesh_->AddFormat(sht::graphics::VertexAttribute(sht::graphics::VertexAttribute::kNormal, 3));
 	ball_mesh_->AddFormat(sht::graphics::VertexAttribute(sht::graphics::VertexAttribute::kTexcoord, 2));
@@ -1,21 +1,50 @@
 #include "graphics/include/model/complex_mesh.h"
 
 #include <cstdio>
+#include <cstdlib>
+#include <cstring>
 
 static void PrintInfo(const char* app_name)
 {
 	printf("Mesh converter (c) Shtille, 2017\n");
-	printf("Usage:\n%s <file in> <file out>\n", app_name);
+	printf("Usage:\n%s <file in> <file out> [-overdraw] [-lods <count>] [-pack] [-compress]\n", app_name);
+	printf("  -overdraw      also order triangles to reduce overdraw\n");
+	printf("  -lods <count>  generate simplified levels of detail\n");
+	printf("  -pack          store vertices in compact formats\n");
+	printf("  -compress      compress vertex and index data\n");
+	printf("Files in .scm format are always saved in version %u, older versions are converted.\n",
+		sht::graphics::kScmVersion);
 }
 
 int main(int argc, char const *argv[])
 {
-	if (argc != 3)
+	if (argc < 3)
 	{
 		PrintInfo(argv[0]);
 		return 1;
 	}
+	bool overdraw = false;
+	int num_lods = 0;
+	bool pack = false;
+	bool compress = false;
+	for (int i = 3; i < argc; ++i)
+	{
+		if (strcmp(argv[i], "-overdraw") == 0)
+			overdraw = true;
+		else if (strcmp(argv[i], "-lods") == 0 && i + 1 < argc && atoi(argv[i + 1]) > 0)
+			num_lods = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-pack") == 0)
+			pack = true;
+		else if (strcmp(argv[i], "-compress") == 0)
+			compress = true;
+		else
+		{
+			PrintInfo(argv[0]);
+			return 1;
+		}
+	}
 	sht::graphics::ComplexMesh complex_mesh(nullptr/* renderer */, nullptr/* material_binder */);
+	complex_mesh.set_optimization_flags(sht::graphics::kOptimizeNone);
 	const char * file_in = argv[1];
 	const char * file_out = argv[2];
 	printf("Loading file %s\n", file_in);
@@ -24,6 +53,25 @@ int main(int argc, char const *argv[])
 		fprintf(stderr, "File loading failed (%s)\n", file_in);
 		return 2;
 	}
+	const u32 flags = overdraw ? sht::graphics::kOptimizeAll : sht::graphics::kOptimizeDefault;
+	printf("Optimizing meshes\n");
+	complex_mesh.Optimize(flags);
+	const sht::graphics::MeshOptimizationStats& stats = complex_mesh.optimization_stats();
+	printf("  triangles: %u\n", stats.num_triangles);
+	printf("  vertices: %u -> %u\n", stats.num_vertices_before, stats.num_vertices_after);
+	printf("  ACMR: %.3f -> %.3f\n", stats.acmr_before, stats.acmr_after);
+	if (flags & sht::graphics::kOptimizeOverdraw)
+		printf("  overdraw: %.3f -> %.3f\n", stats.overdraw_before, stats.overdraw_after);
+	if (num_lods != 0)
+	{
+		printf("Generating levels of detail\n");
+		complex_mesh.GenerateLods(static_cast<u32>(num_lods));
+		printf("  levels: %u\n", complex_mesh.num_lods());
+	}
+	if (pack)
+		complex_mesh.set_vertex_compression(sht::graphics::kCompressAll);
+	if (compress)
+		complex_mesh.set_scm_compression(sht::graphics::ScmCompression::kFiltered);
 	printf("Saving file %s\n", file_out);
 	if (!complex_mesh.SaveToFile(file_out))
 	{
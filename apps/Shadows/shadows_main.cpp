@@ -3,16 +3,34 @@
 #include "../../sht/graphics/include/model/sphere_model.h"
 #include "../../sht/graphics/include/model/cube_model.h"
 #include "../../sht/graphics/include/renderer/text.h"
+#include "../../sht/graphics/include/renderer/cascaded_shadows.h"
 #include "../../sht/utility/include/camera.h"
 
 #include <cmath>
+#include <cstdio>
+#include <vector>
 
 /*
 The main concept of creating this application is testing cubemap edge artefacts during accessing mipmaps.
+Shadows of directional light are rendered into cascades, casters are culled per cascade.
+All casters are static, so cascades are rerendered only when their light matrices change.
 */
 
 #define APP_NAME ShadowsApp
 
+const int kNumCascades = 4;
+const int kShadowMapSize = 1024;
+const float kFov = 45.0f;
+const float kZNear = 0.1f;
+const float kZFar = 100.0f;
+
+//! Object that throws shadows
+struct ShadowCaster {
+	sht::graphics::Model * model;
+	sht::math::Vector3 position;
+	float scale;
+};
+
 class APP_NAME : public sht::OpenGlApplication
 {
 public:
@@ -22,12 +40,21 @@ public:
 	, cube_(nullptr)
 	, font_(nullptr)
 	, fps_text_(nullptr)
+	, casters_text_(nullptr)
 	, camera_manager_(nullptr)
+	, shadows_(nullptr)
 	, angle_(0.0f)
 	, light_distance_(10.0f)
 	, need_update_projection_matrix_(true)
 	, show_shadow_texture_(false)
+	, rotate_light_(true)
+	, cache_static_casters_(true)
 	{
+		for (int i = 0; i < kNumCascades; ++i)
+		{
+			cascade_rt_[i] = nullptr;
+			casters_drawn_[i] = 0;
+		}
 	}
 	const char* GetTitle() final
 	{
@@ -43,7 +70,13 @@ public:
 
 		object_shader_->Bind();
 		object_shader_->Uniform3fv("u_light.color", kLightColor);
-		object_shader_->Uniform1i("u_shadow_sampler", 0);
+		const int kSamplerUnits[kNumCascades] = { 0, 1, 2, 3 };
+		for (int i = 0; i < kNumCascades; ++i)
+		{
+			char name[32];
+			sprintf(name, "u_shadow_samplers[%d]", i);
+			object_shader_->Uniform1i(name, kSamplerUnits[i]);
+		}
 		object_shader_->Unbind();
 	}
 	void BindShaderVariables()
@@ -65,6 +98,7 @@ public:
 		sphere_ = new sht::graphics::SphereModel(renderer_, 128, 64);
 		sphere_->AddFormat(sht::graphics::VertexAttribute(sht::graphics::VertexAttribute::kVertex, 3));
 		sphere_->AddFormat(sht::graphics::VertexAttribute(sht::graphics::VertexAttribute::kNormal, 3));
+		sphere_->set_vertex_compression(sht::graphics::kCompressNormals);
 		sphere_->Create();
 		if (!sphere_->MakeRenderable())
 			return false;
@@ -73,6 +107,7 @@ public:
 		cube_ = new sht::graphics::CubeModel(renderer_);
 		cube_->AddFormat(sht::graphics::VertexAttribute(sht::graphics::VertexAttribute::kVertex, 3));
 		cube_->AddFormat(sht::graphics::VertexAttribute(sht::graphics::VertexAttribute::kNormal, 3));
+		cube_->set_vertex_compression(sht::graphics::kCompressNormals);
 		cube_->Create();
 		if (!cube_->MakeRenderable())
 			return false;
@@ -84,8 +119,18 @@ public:
 		if (!renderer_->AddShader(object_shadow_shader_, "data/shaders/apps/Shadows/object_shadow")) return false;
 
 		// Render targets
-		const int kFramebufferSize = 1024;
-		renderer_->CreateTextureDepth(shadow_depth_rt_, kFramebufferSize, kFramebufferSize, 32);
+		for (int i = 0; i < kNumCascades; ++i)
+			renderer_->CreateTextureDepth(cascade_rt_[i], kShadowMapSize, kShadowMapSize, 32);
+		shadows_ = new sht::graphics::CascadedShadows(kNumCascades, kShadowMapSize);
+		shadows_->set_caster_distance(20.0f);
+
+		// Scene
+		AddCaster(cube_, vec3(0.0f), 1.0f);
+		AddCaster(cube_, vec3(0.0f, -6.0f, 0.0f), 5.0f);
+		AddCaster(sphere_, vec3(2.0f, 0.0f, 0.0f), 1.0f);
+		AddCaster(sphere_, vec3(-2.0f, 0.0f, 0.0f), 1.0f);
+		AddCaster(sphere_, vec3(0.0f, 0.0f, 2.0f), 1.0f);
+		AddCaster(sphere_, vec3(0.0f, 0.0f, -2.0f), 1.0f);
 
 		// Fonts
 		renderer_->AddFont(font_, "data/fonts/GoodDog.otf");
@@ -96,6 +141,10 @@ public:
 		if (!fps_text_)
 			return false;
 
+		casters_text_ = sht::graphics::DynamicText::Create(renderer_, 40);
+		if (!casters_text_)
+			return false;
+
 		camera_manager_ = new sht::utility::CameraManager();
 		camera_manager_->MakeFree(vec3(5.0f), vec3(0.0f));
 
@@ -106,8 +155,12 @@ public:
 	}
 	void Unload() final
 	{
+		if (shadows_)
+			delete shadows_;
 		if (camera_manager_)
 			delete camera_manager_;
+		if (casters_text_)
+			delete casters_text_;
 		if (fps_text_)
 			delete fps_text_;
 		if (quad_)
@@ -123,7 +176,8 @@ public:
 
 		camera_manager_->Update(kFrameTime);
 
-		angle_ += 0.1f * kFrameTime;
+		if (rotate_light_)
+			angle_ += 0.1f * kFrameTime;
 		light_position_.Set(light_distance_ * cosf(angle_), 1.0f, light_distance_ * sinf(angle_));
 		//light_position_.Set(1.0f, light_distance_, 1.0f);
 
@@ -134,71 +188,61 @@ public:
 
 		BindShaderVariables();
 	}
-	void RenderObjects(sht::graphics::Shader * shader)
+	void AddCaster(sht::graphics::Model * model, const vec3& position, float scale)
+	{
+		ShadowCaster caster;
+		caster.model = model;
+		caster.position = position;
+		caster.scale = scale;
+		casters_.push_back(caster);
+
+		// Both cube and sphere models fit into [-1, 1] box
+		sht::math::BoundingBox box;
+		box.center = position;
+		box.extent = vec3(scale);
+		caster_boxes_.push_back(box);
+	}
+	void RenderCaster(sht::graphics::Shader * shader, const ShadowCaster& caster)
 	{
-		// Render cube
-		renderer_->PushMatrix();
-		shader->UniformMatrix4fv("u_model", renderer_->model_matrix());
-		cube_->Render();
-		renderer_->PopMatrix();
-
-		renderer_->PushMatrix();
-		renderer_->Translate(0.0f, -6.0f, 0.0f);
-		renderer_->Scale(5.0f);
-		shader->UniformMatrix4fv("u_model", renderer_->model_matrix());
-		cube_->Render();
-		renderer_->PopMatrix();
-
-		// Render spheres
-		renderer_->PushMatrix();
-		renderer_->Translate(2.0f, 0.0f, 0.0f);
-		shader->UniformMatrix4fv("u_model", renderer_->model_matrix());
-		sphere_->Render();
-		renderer_->PopMatrix();
-
-		renderer_->PushMatrix();
-		renderer_->Translate(-2.0f, 0.0f, 0.0f);
-		shader->UniformMatrix4fv("u_model", renderer_->model_matrix());
-		sphere_->Render();
-		renderer_->PopMatrix();
-
-		renderer_->PushMatrix();
-		renderer_->Translate(0.0f, 0.0f, 2.0f);
-		shader->UniformMatrix4fv("u_model", renderer_->model_matrix());
-		sphere_->Render();
-		renderer_->PopMatrix();
-
 		renderer_->PushMatrix();
-		renderer_->Translate(0.0f, 0.0f, -2.0f);
+		renderer_->Translate(caster.position);
+		renderer_->Scale(caster.scale);
 		shader->UniformMatrix4fv("u_model", renderer_->model_matrix());
-		sphere_->Render();
+		caster.model->Render();
 		renderer_->PopMatrix();
 	}
+	void RenderObjects(sht::graphics::Shader * shader)
+	{
+		for (const auto& caster : casters_)
+			RenderCaster(shader, caster);
+	}
 	void ShadowPass()
 	{
-		// Generate matrix for shadows
-		// Ortho matrix is used for directional light sources and perspective for spot ones.
-		float znear = light_distance_ - 2.0f;
-		float zfar = light_distance_ + 2.0f;
-		sht::math::Matrix4 depth_projection = sht::math::PerspectiveMatrix(45.0f, 1, 1, znear, zfar);//sht::math::OrthoMatrix()
-		sht::math::Matrix4 depth_view = sht::math::LookAt(light_position_, vec3(0.0f));
-		sht::math::Matrix4 depth_projection_view = depth_projection * depth_view;
-		sht::math::Matrix4 bias_matrix(
-			0.5f, 0.0f, 0.0f, 0.0f,
-			0.0f, 0.5f, 0.0f, 0.0f,
-			0.0f, 0.0f, 0.5f, 0.0f,
-			0.5f, 0.5f, 0.5f, 1.0f
-		);
-		depth_bias_projection_view_matrix_ = bias_matrix * depth_projection_view;
-
-		renderer_->ChangeRenderTarget(nullptr, shadow_depth_rt_);
-		renderer_->ClearColorAndDepthBuffers();
+		const vec3 light_direction = (vec3(0.0f) - light_position_).GetNormalized();
+		shadows_->Update(renderer_->view_matrix(), kFov, renderer_->aspect_ratio(), kZNear, kZFar, light_direction);
 
 		object_shadow_shader_->Bind();
-		object_shadow_shader_->UniformMatrix4fv("u_projection_view", depth_projection_view);
-
-		RenderObjects(object_shadow_shader_);
-
+		for (int i = 0; i < kNumCascades; ++i)
+		{
+			const sht::graphics::CascadedShadows::Cascade& cascade = shadows_->cascade(i);
+			if (cache_static_casters_ && cascade.static_valid)
+			{
+				// Shadow map still holds the same static casters
+				casters_drawn_[i] = 0;
+				continue;
+			}
+			casters_drawn_[i] = shadows_->CullCasters(i, caster_boxes_.data(),
+				static_cast<u32>(caster_boxes_.size()), &visible_casters_);
+
+			renderer_->ChangeRenderTarget(nullptr, cascade_rt_[i]);
+			renderer_->ClearDepthBuffer();
+			object_shadow_shader_->UniformMatrix4fv("u_projection_view", cascade.projection_view);
+			for (auto index : visible_casters_)
+				RenderCaster(object_shadow_shader_, casters_[index]);
+
+			if (cache_static_casters_)
+				shadows_->MarkStaticRendered(i);
+		}
 		object_shadow_shader_->Unbind();
 
 		renderer_->ChangeRenderTarget(nullptr, nullptr);
@@ -215,7 +259,7 @@ public:
 			quad_shader_->Bind();
 			quad_shader_->Uniform1i("u_texture", 0);
 
-			renderer_->ChangeTexture(shadow_depth_rt_, 0);
+			renderer_->ChangeTexture(cascade_rt_[0], 0);
 			quad_->Render();
 			renderer_->ChangeTexture(nullptr, 0);
 
@@ -226,13 +270,24 @@ public:
 			// Render objects
 			object_shader_->Bind();
 			object_shader_->UniformMatrix4fv("u_projection_view", projection_view_matrix_);
-			object_shader_->UniformMatrix4fv("u_depth_bias_projection_view", depth_bias_projection_view_matrix_);
-
-			renderer_->ChangeTexture(shadow_depth_rt_, 0);
+			object_shader_->UniformMatrix4fv("u_view", renderer_->view_matrix());
+			sht::math::Matrix4 shadow_matrices[kNumCascades];
+			float splits[kNumCascades];
+			for (int i = 0; i < kNumCascades; ++i)
+			{
+				shadow_matrices[i] = shadows_->GetShadowMatrix(i);
+				splits[i] = shadows_->cascade(i).split_far;
+			}
+			object_shader_->UniformMatrix4fv("u_shadow_matrices", shadow_matrices[0], false, kNumCascades);
+			object_shader_->Uniform1fv("u_cascade_splits", splits, kNumCascades);
+
+			for (int i = 0; i < kNumCascades; ++i)
+				renderer_->ChangeTexture(cascade_rt_[i], i);
 
 			RenderObjects(object_shader_);
 
-			renderer_->ChangeTexture(nullptr, 0);
+			for (int i = kNumCascades - 1; i >= 0; --i)
+				renderer_->ChangeTexture(nullptr, i);
 
 			object_shader_->Unbind();
 		}
@@ -247,6 +302,9 @@ public:
 		text_shader_->Uniform4f("u_color", 1.0f, 0.5f, 1.0f, 1.0f);
 		fps_text_->SetText(font_, 0.0f, 0.8f, 0.05f, L"fps: %.2f", GetFrameRate());
 		fps_text_->Render();
+		casters_text_->SetText(font_, 0.0f, 0.75f, 0.05f, L"casters: %u %u %u %u",
+			casters_drawn_[0], casters_drawn_[1], casters_drawn_[2], casters_drawn_[3]);
+		casters_text_->Render();
 		text_shader_->Unbind();
 
 		renderer_->ChangeTexture(nullptr);
@@ -297,6 +355,15 @@ public:
 		{
 			show_shadow_texture_ = !show_shadow_texture_;
 		}
+		else if (key == sht::PublicKey::kP)
+		{
+			rotate_light_ = !rotate_light_;
+		}
+		else if (key == sht::PublicKey::kC)
+		{
+			cache_static_casters_ = !cache_static_casters_;
+			shadows_->InvalidateStatic();
+		}
 	}
 	void OnMouseDown(sht::MouseButton button, int modifiers) final
 	{
@@ -318,7 +385,7 @@ public:
 		if (need_update_projection_matrix_ || camera_manager_->animated())
 		{
 			need_update_projection_matrix_ = false;
-			renderer_->SetProjectionMatrix(sht::math::PerspectiveMatrix(45.0f, width(), height(), 0.1f, 100.0f));
+			renderer_->SetProjectionMatrix(sht::math::PerspectiveMatrix(kFov, width(), height(), kZNear, kZFar));
 		}
 	}
 	
@@ -332,14 +399,20 @@ private:
 	sht::graphics::Shader * object_shader_;
 	sht::graphics::Shader * object_shadow_shader_; //!< simplified version for shadows generation
 
-	sht::graphics::Texture * shadow_depth_rt_;
+	sht::graphics::Texture * cascade_rt_[kNumCascades];
 
 	sht::graphics::Font * font_;
 	sht::graphics::DynamicText * fps_text_;
+	sht::graphics::DynamicText * casters_text_;
 	sht::utility::CameraManager * camera_manager_;
+	sht::graphics::CascadedShadows * shadows_;
+
+	std::vector<ShadowCaster> casters_;
+	std::vector<sht::math::BoundingBox> caster_boxes_;
+	std::vector<u32> visible_casters_;
+	u32 casters_drawn_[kNumCascades];	//!< casters rendered into every cascade this frame
 	
 	sht::math::Matrix4 projection_view_matrix_;
-	sht::math::Matrix4 depth_bias_projection_view_matrix_;
 	sht::math::Vector3 light_position_;
 
 	float angle_;
@@ -347,6 +420,8 @@ private:
 
 	bool need_update_projection_matrix_;
 	bool show_shadow_texture_;
+	bool rotate_light_;
+	bool cache_static_casters_;
 };
 
 DECLARE_MAIN(APP_NAME);
\ No newline at end of file
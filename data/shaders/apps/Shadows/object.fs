@@ -8,13 +8,15 @@ struct Light {
 out vec4 out_color;
 
 uniform Light u_light;
-uniform sampler2DShadow u_shadow_sampler;
+uniform sampler2DShadow u_shadow_samplers[4];
+uniform mat4 u_shadow_matrices[4];
+uniform float u_cascade_splits[4];
 
 in DATA
 {
 	vec3 position;
 	vec3 normal;
-	vec4 shadow_coord;
+	float view_depth;
 } fs_in;
 
 const float kScreenGamma = 2.2; // Assume that monitor is in sRGB color space
@@ -44,6 +46,19 @@ float random(vec3 seed, int i)
 	return fract(sin(dot_product) * 43758.5453);
 }
 
+float ShadowTest(int cascade, vec3 coord)
+{
+	// Samplers array may be indexed only by constant expressions
+	if (cascade == 0)
+		return texture(u_shadow_samplers[0], coord);
+	else if (cascade == 1)
+		return texture(u_shadow_samplers[1], coord);
+	else if (cascade == 2)
+		return texture(u_shadow_samplers[2], coord);
+	else
+		return texture(u_shadow_samplers[3], coord);
+}
+
 void main()
 {
 	// Compute ambient term
@@ -59,11 +74,15 @@ void main()
 	float bias = 0.005 * (sqrt(1.0 - lambertian*lambertian)/lambertian);
 	bias = clamp(bias, 0.0, 0.01);
 	float visibility = 1.0;
-	vec4 shadow = fs_in.shadow_coord;
+	int cascade = 3;
+	for (int i = 2; i >= 0; --i)
+		if (fs_in.view_depth < u_cascade_splits[i])
+			cascade = i;
+	vec4 shadow = u_shadow_matrices[cascade] * vec4(fs_in.position, 1.0);
 	for (int i = 0; i < 4; ++i)
 	{
 		int index = int(16.0 * random(gl_FragCoord.xyy, i)) % 16;
-		visibility -= 0.2 * (1.0 - texture(u_shadow_sampler, vec3(shadow.xy + poissonDisk[index] / 700.0, shadow.z - bias)/shadow.w));
+		visibility -= 0.2 * (1.0 - ShadowTest(cascade, vec3(shadow.xy + poissonDisk[index] / 700.0, shadow.z - bias)/shadow.w));
 	}
 
 	vec3 color_linear = ambient + (diffuse) * visibility;
@@ -5,13 +5,13 @@ layout(location = 1) in vec3 a_normal;
 
 uniform mat4 u_projection_view;
 uniform mat4 u_model;
-uniform mat4 u_depth_bias_projection_view;
+uniform mat4 u_view;
 
 out DATA
 {
 	vec3 position;
 	vec3 normal;
-	vec4 shadow_coord;
+	float view_depth;
 } vs_out;
 
 void main()
@@ -21,7 +21,7 @@ void main()
 
 	vs_out.position = vec3(position_world);
 	vs_out.normal = model * a_normal;
-	vs_out.shadow_coord = u_depth_bias_projection_view * position_world;
+	vs_out.view_depth = -(u_view * position_world).z;
 
     gl_Position = u_projection_view * position_world;
 }
\ No newline at end of file
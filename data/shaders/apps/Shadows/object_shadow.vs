@@ -9,4 +9,6 @@ void main()
 {
 	vec4 position_world = u_model * vec4(a_position, 1.0);
     gl_Position = u_projection_view * position_world;
+	// Casters between light and cascade are flattened onto the near plane
+	gl_Position.z = max(gl_Position.z, -gl_Position.w);
 }
\ No newline at end of file
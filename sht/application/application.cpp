@@ -40,9 +40,13 @@ namespace sht {
     {
         return app_;
     }
+    void Application::SetInstance()
+    {
+        app_ = this;
+    }
     int Application::Run(int argc, const char** argv)
 	{
-		app_ = this;
+		SetInstance();
 		
 		// Set proper text encoding to let use non-english characters
 		setlocale(LC_CTYPE, "UTF-8");
@@ -108,6 +108,7 @@ namespace sht {
 
 	protected:
 
+		void SetInstance(); //!< makes GetInstance return this application, Run does it by itself
 		void ComputeFramebufferSize();
 
 		sht::graphics::Renderer *renderer_; //!< our renderer object
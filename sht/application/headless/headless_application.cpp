@@ -0,0 +1,99 @@
+#include "headless_application.h"
+#include "../../graphics/include/renderer/null_renderer.h"
+#include "../../graphics/include/renderer/recording_context.h"
+#include "../../system/include/time/clock.h"
+
+namespace sht {
+
+	HeadlessApplication::HeadlessApplication()
+	: recording_context_(nullptr)
+	, elapsed_seconds_(0.0f)
+	{
+
+	}
+	HeadlessApplication::~HeadlessApplication()
+	{
+
+	}
+	bool HeadlessApplication::ShowStartupOptions()
+	{
+		return true;
+	}
+	bool HeadlessApplication::InitApi()
+	{
+		recording_context_ = new sht::graphics::RecordingContext();
+		renderer_ = new sht::graphics::NullRenderer(width_, height_, recording_context_);
+		return true;
+	}
+	void HeadlessApplication::DeinitApi()
+	{
+		renderer_->CleanUp();
+		delete renderer_; // context is owned by renderer
+		renderer_ = nullptr;
+		recording_context_ = nullptr;
+	}
+	void HeadlessApplication::BeginFrame()
+	{
+		renderer_->context()->NewFrame();
+		renderer_->Defaults();
+	}
+	void HeadlessApplication::EndFrame()
+	{
+		renderer_->EndFrame();
+		recording_context_->EndFrame();
+	}
+	int HeadlessApplication::RunFrames(int num_frames, int width, int height)
+	{
+		SetInstance();
+		width_ = width;
+		height_ = height;
+		aspect_ratio_ = static_cast<float>(width_) / static_cast<float>(height_);
+		ComputeFramebufferSize();
+
+		if (!PreStartInit())
+			return 2;
+		if (!InitApi())
+			return 1;
+
+		int result = 0;
+		InitializeManagers();
+		if (Load())
+		{
+			set_visible(true);
+
+			// Same order as in the main loop, but time is simulated
+			sht::system::Clock clock;
+			const float start_time = clock.GetTime();
+			const float kTickTime = GetFrameTime();
+			for (int frame = 0; frame < num_frames; ++frame)
+			{
+				BeginFrame();
+				Render();
+				EndFrame();
+
+				UpdatePhysics(kTickTime);
+
+				UpdateManagers();
+
+				Update();
+			}
+			elapsed_seconds_ = clock.GetTime() - start_time;
+		}
+		else
+			result = 3;
+		Unload(); // delete allocated objects (may be allocated partially)
+		DeinitializeManagers();
+		DeinitApi();
+
+		return result;
+	}
+	sht::graphics::RecordingContext * HeadlessApplication::recording_context()
+	{
+		return recording_context_;
+	}
+	float HeadlessApplication::elapsed_seconds()
+	{
+		return elapsed_seconds_;
+	}
+
+} // namespace sht
@@ -0,0 +1,44 @@
+#pragma once
+#ifndef __SHT_APPLICATION_HEADLESS_APPLICATION_H__
+#define __SHT_APPLICATION_HEADLESS_APPLICATION_H__
+
+#include "../application.h"
+
+namespace sht {
+
+	// Predeclarations
+	namespace graphics {
+		class RecordingContext;
+	}
+
+	//! Application that runs without window and graphics device.
+	//! Frames are rendered with null renderer into recording context,
+	//! so scenes can be tested and CPU side of rendering can be benchmarked on any machine.
+	//! Link it with headless platform layer (platform/src/headless) instead of the windowed one.
+	class HeadlessApplication : public Application {
+	public:
+		HeadlessApplication();
+		virtual ~HeadlessApplication();
+
+		bool ShowStartupOptions() final;
+		bool InitApi() final;
+		void DeinitApi() final;
+		void BeginFrame() final;
+		void EndFrame() final;
+
+		//! Runs the same loop as the windowed application for given number of frames.
+		//! Every frame advances time by fixed frame time. Returns zero on success.
+		int RunFrames(int num_frames, int width = 800, int height = 600);
+
+		//! Valid between InitApi and DeinitApi, so Load and Unload may use it
+		sht::graphics::RecordingContext * recording_context();
+		float elapsed_seconds();	//!< real time spent in the last RunFrames call
+
+	private:
+		sht::graphics::RecordingContext * recording_context_;
+		float elapsed_seconds_;
+	};
+
+} // namespace sht
+
+#endif
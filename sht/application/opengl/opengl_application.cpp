@@ -40,10 +40,12 @@ namespace sht {
 	}
 	void OpenGlApplication::BeginFrame()
 	{
+		renderer_->context()->NewFrame();
 		renderer_->Defaults();
 	}
 	void OpenGlApplication::EndFrame()
 	{
+		renderer_->EndFrame();
 		PlatformSwapBuffers();
 	}
 
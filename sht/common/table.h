@@ -2,6 +2,7 @@
 #ifndef __SHT_COMMON_TABLE_H__
 #define __SHT_COMMON_TABLE_H__
 
+#include <cstddef>
 #include <unordered_map>
 
 struct EnumClassHash {
@@ -15,4 +16,41 @@ struct EnumClassHash {
 template <typename K, typename T>
 using EnumTable = std::unordered_map<K, T, EnumClassHash>;
 
+//! Table indexed by dense enum class that has kCount as the last value.
+//! Lookup is plain array indexing, so table may be constexpr and used on hot paths.
+template <typename K, typename T>
+class EnumArray {
+public:
+    static const std::size_t kSize = static_cast<std::size_t>(K::kCount);
+    
+    EnumArray()
+    : values_()
+    {
+    }
+    //! Values are listed in order of enum declaration, one for each key
+    template <typename... Args>
+    constexpr EnumArray(T first, Args... rest)
+    : values_{ first, static_cast<T>(rest)... }
+    {
+        static_assert(sizeof...(Args) + 1 == kSize, "number of values doesn't match enum kCount");
+    }
+    
+    constexpr const T& operator[](K key) const
+    {
+        return values_[static_cast<std::size_t>(key)];
+    }
+    T& operator[](K key)
+    {
+        return values_[static_cast<std::size_t>(key)];
+    }
+    
+    static constexpr std::size_t size()
+    {
+        return kSize;
+    }
+    
+private:
+    T values_[kSize];
+};
+
 #endif
\ No newline at end of file
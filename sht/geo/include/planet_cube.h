@@ -6,6 +6,7 @@
 
 #include "../../common/non_copyable.h"
 #include "../../utility/include/camera.h"
+#include "../../graphics/include/renderer/shader.h"
 
 #include <list>
 #include <set>
@@ -111,6 +112,11 @@ namespace sht {
 
 		private:
 			graphics::Shader * shader_;			//!< pointer to shader object
+			graphics::UniformHandle stuv_scale_uniform_;
+			graphics::UniformHandle stuv_position_uniform_;
+			graphics::UniformHandle skirt_height_uniform_;
+			graphics::UniformHandle face_transform_uniform_;
+			graphics::UniformHandle color_uniform_;
 			utility::CameraManager * camera_;	//!< pointer to camera object
 			math::Frustum * frustum_;			//!< pointer to frustum object
 
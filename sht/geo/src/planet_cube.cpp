@@ -47,6 +47,12 @@ namespace sht {
 	            return false;
 			if (!map_->Initialize())
 				return false;
+			// Tiles set these uniforms every frame
+			stuv_scale_uniform_ = shader_->GetUniformHandle("u_stuv_scale");
+			stuv_position_uniform_ = shader_->GetUniformHandle("u_stuv_position");
+			skirt_height_uniform_ = shader_->GetUniformHandle("u_skirt_height");
+			face_transform_uniform_ = shader_->GetUniformHandle("u_face_transform");
+			color_uniform_ = shader_->GetUniformHandle("u_color");
 			return true;
 		}
 		void PlanetCube::SetParameters(float fovy_in_radians, int screen_height)
@@ -295,18 +295,19 @@ namespace sht {
 			if (owner_->cube_->preprocess_)
 				return;
 
-			graphics::Shader * shader = owner_->cube_->shader_;
+			PlanetCube * cube = owner_->cube_;
+			graphics::Shader * shader = cube->shader_;
 
 			math::Matrix3 face_transform = PlanetCube::GetFaceTransform(owner_->face_);
 
 			// Vertex shader
-			shader->Uniform4fv("u_stuv_scale", renderable_->stuv_scale_);
-			shader->Uniform4fv("u_stuv_position", renderable_->stuv_position_);
-			shader->Uniform1f("u_skirt_height", renderable_->distance_);
-			shader->UniformMatrix3fv("u_face_transform", face_transform);
+			shader->Uniform4fv(cube->stuv_scale_uniform_, renderable_->stuv_scale_);
+			shader->Uniform4fv(cube->stuv_position_uniform_, renderable_->stuv_position_);
+			shader->Uniform1f(cube->skirt_height_uniform_, renderable_->distance_);
+			shader->UniformMatrix3fv(cube->face_transform_uniform_, face_transform);
 
 			// Fragment shader
-			shader->Uniform4fv("u_color", renderable_->color_);
+			shader->Uniform4fv(cube->color_uniform_, renderable_->color_);
 
 			renderable_->GetMapTile()->BindTexture();
 
@@ -5,12 +5,36 @@
 #include "../../../common/types.h"
 #include "../../../common/platform.h"
 
+#include <functional>
+#include <future>
+
+// Forward declarations of decoder library structures
+struct jpeg_decompress_struct;
+struct png_struct_def;
+struct png_info_def;
+
 namespace sht {
 	namespace graphics {
 
+		struct DecodeScratch;
+
 		//! Image class
 		class Image {
 		public:
+			//! Options that allow to decode only a part of the image
+			struct DecodeOptions {
+				DecodeOptions();
+
+				int target_width;	//!< desired minimal width, image is downscaled by factor of 2, 4 or 8 to fit it (0 means full size)
+				int target_height;	//!< desired minimal height (0 means full size)
+				int region_x;		//!< region to decode in source image coordinates
+				int region_y;
+				int region_width;	//!< zero width or height means full image
+				int region_height;
+				u8 * buffer;		//!< optional caller-provided buffer that decoded rows are streamed into
+				size_t buffer_size;	//!< size of caller-provided buffer in bytes
+			};
+
 			enum class Format {
 				kNone,
 				kI8, kI16, kI32,
@@ -39,6 +63,7 @@ namespace sht {
 			~Image();
 
 			void SetRowOrder(bool inverted);
+			bool inverted_row_order() const;
 
 			u8* pixels();
 			const u8* pixels() const;
@@ -46,6 +71,8 @@ namespace sht {
 			int width() const;
 			int height() const;
 			int bpp() const;
+			int channels() const;
+			DataType data_type() const;
 
 			u8* Allocate(int w, int h, Format fmt);						//!< allocates a place for image data and returns its data pointer
             void FillWithZeroes();
@@ -54,8 +81,15 @@ namespace sht {
             void SubData(int offset_x, int offset_y, int w, int h, const u8* data);
 			bool Save(const char* filename);							//!< saves image to file with specified format
 
-			bool LoadFromFile(const char* filename);					//!< loads image from file
-			bool LoadFromBuffer(const u8* buffer, size_t length);		//!< loads image from buffer
+			bool LoadFromFile(const char* filename,
+				const DecodeOptions& options = DecodeOptions());		//!< loads image from file
+			bool LoadFromBuffer(const u8* buffer, size_t length,
+				const DecodeOptions& options = DecodeOptions());		//!< loads image from buffer
+			//! Decodes file on a worker thread into this image, which must stay alive until the load is finished.
+			//! Callback is called on the worker thread before the future becomes ready.
+			std::future<bool> LoadAsync(const char* filename,
+				const DecodeOptions& options = DecodeOptions(),
+				const std::function<void(Image*, bool)>& callback = std::function<void(Image*, bool)>());
 			bool LoadNMapFromHMap(const char* filename);				//!< loads normalmap from heightmap file
 			bool LoadNHMapFromHMap(const char* filename);				//!< loads normalheightmap from heightmap file
 			
@@ -66,6 +100,8 @@ namespace sht {
 			static void CreateCube(const Image * images, Image * out);	//!< creates cross cubemap
 			static void DownscaleCube(Image * images);
 
+			static FileFormat DetectFileFormat(const u8* buffer, size_t length); //!< recognizes format by file signature
+
 		protected:
 
 			// Save routines
@@ -77,21 +113,33 @@ namespace sht {
 			bool SaveHdr(const char *filename);
 
 			// Load routines
-			bool LoadJpeg(const char *filename);
-			bool LoadPng(const char *filename);
+			bool LoadJpeg(const char *filename, const DecodeOptions& options);
+			bool LoadPng(const char *filename, const DecodeOptions& options);
 			bool LoadBmp(const char *filename);
 			bool LoadTiff(const char *filename);
 			bool LoadTga(const char *filename);
 			bool LoadHdr(const char *filename);
 
 			// Load from buffer routines
-			bool LoadFromBufferJpeg(const u8* buffer, size_t length);
-			bool LoadFromBufferPng(const u8* buffer, size_t length);
+			bool LoadFromBufferJpeg(const u8* buffer, size_t length, const DecodeOptions& options);
+			bool LoadFromBufferPng(const u8* buffer, size_t length, const DecodeOptions& options);
 			bool LoadFromBufferBmp(const u8* buffer, size_t length);
 			bool LoadFromBufferTiff(const u8* buffer, size_t length);
 			bool LoadFromBufferTga(const u8* buffer, size_t length);
 			bool LoadFromBufferHdr(const u8* buffer, size_t length);
 
+			// Decoding helpers
+			//! Scratch should be created before setjmp, decoders may longjmp out of these functions
+			bool DecodeJpeg(jpeg_decompress_struct * cinfo, const DecodeOptions& options, DecodeScratch * scratch);
+			bool DecodePng(png_struct_def * png, png_info_def * info, const DecodeOptions& options, DecodeScratch * scratch);
+			bool ApplyDecodeOptions(const DecodeOptions& options); //!< applies options to fully decoded image
+			bool SetupDecodeBuffer(int w, int h, const DecodeOptions& options); //!< chooses between own and caller buffer
+
+			// Pixel memory management
+			u8* AllocatePixels(size_t size);
+			void SetPixels(u8 * pixels, size_t capacity, bool owns);
+			void FreePixels();
+
 		private:
 
 			u8 *pixels_;		//!< bytes of the source image
@@ -102,6 +150,8 @@ namespace sht {
 			int channels_;		//!< number of channels in image
 			int bpp_;			//!< number of BYTES per pixel
             bool inverted_row_order_;
+			bool owns_pixels_;	//!< whether pixels have been allocated by image itself
+			size_t capacity_;	//!< size of pixels buffer in bytes
 		};
 
 	} // namespace graphics
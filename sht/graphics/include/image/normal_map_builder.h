@@ -0,0 +1,50 @@
+#pragma once
+#ifndef __SHT_GRAPHICS_NORMAL_MAP_BUILDER_H__
+#define __SHT_GRAPHICS_NORMAL_MAP_BUILDER_H__
+
+#include "image.h"
+
+namespace sht {
+	namespace graphics {
+
+		//! Builds normal map from height map stored in memory.
+		//! Height is taken from the first channel of 8-bit, 16-bit or float images.
+		class NormalMapBuilder {
+		public:
+			//! Kernel used to find height derivatives
+			enum class Kernel {
+				kForward,	//!< two-tap forward difference
+				kCentral,	//!< central difference
+				kSobel		//!< 3x3 Sobel operator, smoothest result
+			};
+			//! Output image layout
+			enum class Output {
+				kRG8,		//!< only X and Y components, Z should be reconstructed in shader
+				kRGB8,		//!< normal
+				kRGBA8		//!< normal and height in alpha channel
+			};
+
+			NormalMapBuilder();
+
+			void set_kernel(Kernel kernel);
+			void set_strength(float strength);			//!< derivatives multiplier
+			void set_wrap(bool wrap_x, bool wrap_y);	//!< whether height map is tileable
+			void set_output(Output output);
+
+			bool Build(const Image& height_map, Image * normal_map) const;
+
+		private:
+			void BuildRows(const Image& height_map, Image * normal_map, int begin_row, int end_row) const;
+			void LoadRow(const Image& height_map, int row, float * heights) const;
+
+			Kernel kernel_;
+			Output output_;
+			float strength_;
+			bool wrap_x_;
+			bool wrap_y_;
+		};
+
+	} // namespace graphics
+} // namespace sht
+
+#endif
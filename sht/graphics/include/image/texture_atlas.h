@@ -0,0 +1,99 @@
+#pragma once
+#ifndef __SHT_GRAPHICS_TEXTURE_ATLAS_H__
+#define __SHT_GRAPHICS_TEXTURE_ATLAS_H__
+
+#include "image.h"
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace sht {
+	namespace graphics {
+
+		//! Location of image in atlas
+		struct AtlasRegion {
+			u32 page;			//!< index of atlas page
+			int x;				//!< position of the image in page, border isn't included
+			int y;
+			int width;
+			int height;
+			f32 u0;				//!< texture coordinates of the image
+			f32 v0;
+			f32 u1;
+			f32 v1;
+		};
+
+		//! Packs many small images into big pages using skyline bottom-left algorithm.
+		//! Every image is surrounded by border of replicated edge pixels, so filtering and
+		//! a few mip levels don't bleed neighbours in. Images may be added at runtime one by one,
+		//! or packed all at once sorted by height for better occupancy and baked into file.
+		class TextureAtlas {
+		public:
+			TextureAtlas(int page_width = 1024, int page_height = 1024, int padding = 2,
+				Image::Format format = Image::Format::kRGBA8);
+			~TextureAtlas();
+
+			//! Adds image with the atlas format, new page is started when it doesn't fit.
+			//! Returns region index or -1 if image is too big, has other format or name is taken.
+			int Insert(const char* name, const Image& image);
+			//! Packs images in order of decreasing height, returns false if any image fails
+			bool Build(const std::vector<std::string>& names, const std::vector<const Image*>& images);
+
+			void Clear();
+
+			int Find(const char* name) const;		//!< region index by name, -1 if not found
+			const AtlasRegion& region(int index) const;
+			u32 num_regions() const;
+
+			u32 num_pages() const;
+			const Image& page(u32 index) const;
+			bool page_dirty(u32 index) const;		//!< page has been changed since the last ClearDirty
+			void ClearDirty();
+
+			f32 occupancy() const;					//!< area of images and borders relative to area of pages
+
+			//! Stores pages and regions into single file, key identifies sources it was built from
+			bool Save(const char* filename, u64 key) const;
+			//! Fails if file doesn't exist, is broken or has been built from other sources
+			bool Load(const char* filename, u64 key);
+
+			int page_width() const;
+			int page_height() const;
+			int padding() const;
+			Image::Format format() const;
+
+		private:
+			//! Top edge of packed area over horizontal segment
+			struct SkylineNode {
+				int x;
+				int y;
+				int width;
+			};
+			struct Page {
+				Image image;
+				std::vector<SkylineNode> skyline;
+				bool dirty;
+			};
+
+			Page * AddPage();
+			bool FindPosition(const Page * page, int width, int height, int * x, int * y, size_t * node_index) const;
+			void AddSkylineLevel(Page * page, size_t node_index, int x, int y, int width, int height);
+			void CopyWithBorder(Image * page, int x, int y, const Image& image);
+			void AddRegion(const char* name, u32 page, int x, int y, int width, int height);
+
+			int page_width_;
+			int page_height_;
+			int padding_;
+			Image::Format format_;
+			std::vector<Page*> pages_;
+			std::vector<AtlasRegion> regions_;
+			std::vector<std::string> names_;			//!< names of regions
+			std::unordered_map<std::string, int> name_map_;
+			u64 used_area_;
+		};
+
+	} // namespace graphics
+} // namespace sht
+
+#endif
@@ -3,8 +3,14 @@
 #define __SHT_GRAPHICS_COMPLEX_MESH_H__
 
 #include "../resource.h"
+#include "../renderer/context.h"
 #include "../renderer/vertex_format.h"
+#include "vertex_packer.h"
+#include "mesh_optimizer.h"
+#include "mesh_simplifier.h"
+#include "scm_file.h"
 #include "math/bounding_box.h"
+#include "math/frustum.h"
 
 #include <vector>
 
@@ -15,6 +21,8 @@ namespace sht {
 		class Mesh;
 		struct Material;
 		class MaterialBinderInterface;
+		class InstanceBatch;
+		class MeshPool;
 		
 		//! Complex mesh class
 		class ComplexMesh : public Resource {
@@ -33,13 +41,43 @@ namespace sht {
 
 			bool SaveToFile(const char* filename);
 			bool LoadFromFile(const char* filename);
+
+			//! Combination of MeshOptimization flags applied to OBJ meshes on load
+			void set_optimization_flags(u32 flags);
+			//! Optimizes triangle list meshes, should be called before MakeRenderable.
+			//! Vertices may be reordered, so levels of detail are dropped.
+			void Optimize(u32 flags);
+			//! Totals of the last optimization
+			const MeshOptimizationStats& optimization_stats() const;
+
+			//! Builds simplified levels of triangle list meshes, should be called before MakeRenderable.
+			//! Max error is a fraction of mesh diameter.
+			void GenerateLods(u32 num_lods, f32 max_relative_error = 0.05f);
+			u32 num_lods() const;		//!< the most among meshes, including full detail
+			//! Chooses levels by projected size of bounding box diagonal in pixels, see ComputeScreenSize.
+			//! Pooled and instanced draws use full detail.
+			void SelectLod(f32 screen_size, f32 max_pixel_error = 1.0f);
 			
 			virtual void Create();
 
 			void AddFormat(const VertexAttribute& attrib);
+			//! Combination of VertexCompression flags, should be set before MakeRenderable.
+			//! Also defines vertex format of saved SCM files.
+			void set_vertex_compression(u32 compression);
+			//! Compression of vertex and index data in saved SCM files
+			void set_scm_compression(ScmCompression compression);
 			bool MakeRenderable();
+			//! Puts all meshes into shared pool, meshes with the same material are rendered by a single call.
+			//! Compression flags are ignored, pool formats are fixed, explicitly set formats are used.
+			bool MakeRenderable(MeshPool * pool);
 			
 			void Render();
+			//! Renders meshes which bounding boxes intersect frustum given in model space
+			void Render(const math::Frustum& frustum);
+
+			//! Attaches per-instance attributes after vertex attributes of every mesh
+			void AttachInstanceBatch(InstanceBatch * batch);
+			void RenderInstanced(u32 num_instances);
 
 			void ScaleVertices(const math::Vector3& scale);
 
@@ -47,6 +85,8 @@ namespace sht {
 			void SetMaterialBinder(MaterialBinderInterface * material_binder);
 
 			const math::BoundingBox& bounding_box() const;
+			//! Transform from stored positions to original ones, identity unless positions are quantized
+			const VertexQuantization& vertex_quantization() const;
 			
 		private:
 			// Save routines
@@ -56,6 +96,20 @@ namespace sht {
 			// Load routines
 			bool LoadFromFileObj(const char *filename);
 			bool LoadFromFileScm(const char *filename);
+			bool LoadFromFileScmVersion1(const char *filename);
+
+			//! Turns meshes loaded in vertex format into plain vertices, frees the file
+			void UnpackMeshes();
+			void BuildHierarchy();
+			bool CreateVertexFormat(VertexPacker * packer);
+			void RenderPooled();
+
+			//! Pooled meshes drawn together
+			struct DrawGroup {
+				Material * material;
+				PrimitiveType mode;
+				std::vector<u32> handles;
+			};
 
 			Renderer * renderer_;
 			MaterialBinderInterface * material_binder_;
@@ -63,8 +117,17 @@ namespace sht {
 			math::BoundingBox bounding_box_;
 
 			std::vector<VertexAttribute> attribs_;
+			u32 vertex_compression_;
+			VertexQuantization quantization_;
 			std::vector<Mesh*> meshes_;
 			std::vector<Material> materials_;
+			std::vector<ScmNode> hierarchy_;	//!< bounding boxes over meshes
+			ScmReader * scm_file_;				//!< source of meshes that are still in vertex format
+			ScmCompression scm_compression_;
+			u32 optimization_flags_;
+			MeshOptimizationStats optimization_stats_;
+			MeshPool * pool_;
+			std::vector<DrawGroup> draw_groups_;
 		};
 		
 	}
@@ -3,6 +3,9 @@
 #define __SHT_GRAPHICS_MESH_H__
 
 #include "vertex.h"
+#include "vertex_packer.h"
+#include "mesh_simplifier.h"
+#include "../../../math/bounding_box.h"
 #include "../renderer/renderer.h"
 #include <vector>
 
@@ -10,6 +13,8 @@ namespace sht {
 	namespace graphics {
 
 		struct Material;
+		class InstanceBatch;
+		class MeshPool;
 		
 		//! Standart mesh class
 		class Mesh {
@@ -19,35 +24,71 @@ namespace sht {
 			Mesh(Renderer * renderer);
 			virtual ~Mesh();
 
-			bool MakeRenderable(VertexFormat * vertex_format, const std::vector<VertexAttribute>& attribs);
+			bool MakeRenderable(VertexFormat * vertex_format, const std::vector<VertexAttribute>& attribs,
+				const VertexPacker& packer);
+			//! Places mesh data into shared pool buffers instead of own ones
+			bool MakeRenderable(MeshPool * pool, VertexFormat * vertex_format, const std::vector<VertexAttribute>& attribs,
+				const VertexPacker& packer);
 			
 			void Render();
 
+			void AttachInstanceBatch(InstanceBatch * batch, u32 first_location);
+			void RenderInstanced(u32 num_instances);
+
 			void ScaleVertices(const math::Vector3& scale);
 			void ScaleTexcoord(const math::Vector2& scale);
+
+			//! Builds simplified levels of triangle list, should be called before MakeRenderable.
+			//! Max error is a fraction of mesh diameter.
+			void GenerateLods(u32 num_lods, f32 max_relative_error);
+			u32 num_lods() const;			//!< including full detail
+			void set_lod(u32 lod);			//!< level used by Render, instanced and pooled draws use full detail
+			u32 lod() const;
+			//! Chooses the coarsest level which error on screen is small enough, see SelectLod
+			void SelectLod(f32 pixels_per_unit, f32 max_pixel_error);
 			
 		protected:            
 			std::vector<Vertex> vertices_;
 			std::vector<u32> indices_;
+			std::vector<MeshLod> lods_;		//!< coarser levels, indices are freed when renderable
 			
 			PrimitiveType primitive_mode_;
 			
 		private:
+			//! Part of index buffer used by level
+			struct LodRange {
+				u32 first_index;
+				u32 num_indices;
+			};
+
 			void FreeArrays();
-			void TransformVertices(VertexFormat * vertex_format, const std::vector<VertexAttribute>& attribs);
+			//! Fills arrays for buffers keeping vertices and indices
+			void PackArrays(u32 vertex_size, const std::vector<VertexAttribute>& attribs, const VertexPacker& packer);
+			void TransformVertices(VertexFormat * vertex_format, const std::vector<VertexAttribute>& attribs,
+				const VertexPacker& packer);
+			//! Decodes data pointed by packed pointers back to vertices, indices and levels
+			void UnpackVertices(const std::vector<VertexAttribute>& attribs, u32 vertex_size,
+				const VertexQuantization& quantization);
+			math::BoundingBox ComputeBoundingBox() const;
 			
 			Renderer * renderer_;
 			Material * material_;
 			VertexBuffer * vertex_buffer_;
 			IndexBuffer * index_buffer_;
 			u32 vertex_array_object_;
+			MeshPool * pool_;
+			u32 pool_handle_;
 			
 			u32 num_vertices_;
 			u8 * vertices_array_;
 			u32 num_indices_;
 			u32 index_size_;
 			u8 * indices_array_;
+			const u8 * packed_vertices_;	//!< buffer ready data owned by complex mesh file, used instead of arrays
+			const u8 * packed_indices_;
 			DataType index_data_type_;
+			std::vector<LodRange> lod_ranges_;
+			u32 lod_;
 		};
 		
 	}
@@ -0,0 +1,63 @@
+#pragma once
+#ifndef __SHT_GRAPHICS_MESH_OPTIMIZER_H__
+#define __SHT_GRAPHICS_MESH_OPTIMIZER_H__
+
+#include "vertex.h"
+#include "../../../common/types.h"
+
+#include <vector>
+
+namespace sht {
+	namespace graphics {
+
+		//! Steps of mesh optimization, meshes should be triangle lists
+		enum MeshOptimization : u32 {
+			kOptimizeNone			= 0,
+			kOptimizeWeld			= 1,	//!< merge equal vertices, unindexed mesh gets indices
+			kOptimizeVertexCache	= 2,	//!< reorder triangles for post-transform cache
+			kOptimizeOverdraw		= 4,	//!< reorder triangle clusters to draw outer ones first
+			kOptimizeVertexFetch	= 8,	//!< reorder vertices in order of use
+			kOptimizeDefault		= kOptimizeWeld | kOptimizeVertexCache | kOptimizeVertexFetch,
+			kOptimizeAll			= kOptimizeDefault | kOptimizeOverdraw
+		};
+
+		struct MeshOptimizationStats {
+			u32 num_vertices_before;
+			u32 num_vertices_after;
+			u32 num_triangles;
+			f32 acmr_before;			//!< average cache miss ratio, transformed vertices per triangle
+			f32 acmr_after;
+			f32 overdraw_before;		//!< shaded pixels per covered pixel, measured only with kOptimizeOverdraw
+			f32 overdraw_after;
+		};
+
+		//! Merges bitwise equal vertices and returns their number.
+		//! If there are no indices, vertices are treated as triangle soup and indices are generated.
+		u32 WeldVertices(std::vector<Vertex> * vertices, std::vector<u32> * indices);
+
+		//! Reorders triangles for vertex cache using Forsyth's linear-speed algorithm
+		void OptimizeVertexCache(u32 * indices, size_t num_indices, u32 num_vertices);
+
+		//! Splits triangles into clusters where cache simulation restarts and sorts clusters
+		//! by how much they face away from the mesh center, so occluders are drawn first.
+		//! Should follow OptimizeVertexCache, cache efficiency stays the same.
+		void OptimizeOverdraw(const std::vector<Vertex>& vertices, u32 * indices, size_t num_indices);
+
+		//! Reorders vertices in order of first use and removes unused ones, returns number of vertices
+		u32 OptimizeVertexFetch(std::vector<Vertex> * vertices, std::vector<u32> * indices);
+
+		//! Simulates FIFO vertex cache, returns transformed vertices per triangle
+		f32 AnalyzeVertexCache(const u32 * indices, size_t num_indices, u32 num_vertices, u32 cache_size = 16);
+
+		//! Rasterizes mesh from six axis directions with back face culling and depth test,
+		//! returns shaded pixels per covered pixel
+		f32 AnalyzeOverdraw(const std::vector<Vertex>& vertices, const u32 * indices, size_t num_indices);
+
+		//! Runs chosen steps in the right order
+		void OptimizeMesh(std::vector<Vertex> * vertices, std::vector<u32> * indices, u32 flags,
+			MeshOptimizationStats * stats);
+
+	} // namespace graphics
+} // namespace sht
+
+#endif
@@ -0,0 +1,46 @@
+#pragma once
+#ifndef __SHT_GRAPHICS_MESH_SIMPLIFIER_H__
+#define __SHT_GRAPHICS_MESH_SIMPLIFIER_H__
+
+#include "vertex.h"
+#include "../../../common/types.h"
+
+#include <vector>
+
+namespace sht {
+	namespace graphics {
+
+		//! Simplified level of detail, shares vertices with the full detail mesh
+		struct MeshLod {
+			std::vector<u32> indices;
+			f32 error;					//!< deviation from full detail surface in model units
+		};
+
+		//! Simplifies triangle list by edge collapses ordered by quadric error, vertices stay untouched.
+		//! Open borders may only shrink along themselves, vertices on attribute seams are locked,
+		//! difference of normals and texture coordinates is added to collapse cost.
+		//! Stops when index count reaches target or next collapse error exceeds target error.
+		//! Returns error of the result in model units.
+		f32 SimplifyMesh(const std::vector<Vertex>& vertices, const u32 * indices, size_t num_indices,
+			size_t target_index_count, f32 target_error, std::vector<u32> * result);
+
+		//! Diagonal of bounding box of vertices
+		f32 ComputeMeshDiameter(const std::vector<Vertex>& vertices);
+
+		//! Builds coarser levels, each one has about half triangles of the previous one.
+		//! Generation stops early when level can't be reduced enough within max error,
+		//! that is given as a fraction of mesh diameter.
+		void GenerateLods(const std::vector<Vertex>& vertices, const std::vector<u32>& indices, u32 num_lods,
+			f32 max_relative_error, std::vector<MeshLod> * lods);
+
+		//! Projected size in pixels of object with given diameter, fov is vertical in radians
+		f32 ComputeScreenSize(f32 diameter, f32 distance, f32 fov, f32 viewport_height);
+
+		//! Returns the coarsest level which error on screen doesn't exceed max pixel error, 0 is full detail.
+		//! Pixels per unit is screen size of object divided by its diameter.
+		u32 SelectLod(const std::vector<MeshLod>& lods, f32 pixels_per_unit, f32 max_pixel_error);
+
+	} // namespace graphics
+} // namespace sht
+
+#endif
@@ -12,6 +12,8 @@ namespace sht {
 		struct MeshVerticesInfo {
 			const Vertex * vertices;
 			unsigned int num_vertices;
+			const unsigned int * indices;	//!< triangle list indices, null if vertices are triangle list themselves
+			unsigned int num_indices;
 		};
 
 		class MeshVerticesEnumerator {
@@ -3,6 +3,8 @@
 #define __SHT_GRAPHICS_MODEL_H__
 
 #include "vertex.h"
+#include "vertex_packer.h"
+#include "mesh_simplifier.h"
 #include "../renderer/vertex_format.h"
 #include "../renderer/renderer.h"
 #include <vector>
@@ -10,6 +12,8 @@
 namespace sht {
     namespace graphics {
         
+        class InstanceBatch;
+        
         //! Standart model class
         class Model {
         public:
@@ -18,26 +22,52 @@ namespace sht {
             
             virtual void Create() = 0;
             void AddFormat(const VertexAttribute& attrib);
+            //! Combination of VertexCompression flags, should be set before MakeRenderable
+            void set_vertex_compression(u32 compression);
             bool MakeRenderable();
             
             bool HasTexture() const;
             
             void Render();
+            
+            //! Attaches per-instance attributes after vertex attributes of the model
+            void AttachInstanceBatch(InstanceBatch * batch);
+            void RenderInstanced(u32 num_instances);
 
             void ScaleVertices(const math::Vector3& scale);
             void ScaleTexcoord(const math::Vector2& scale);
 
             void ComputeTangentBasis();
+
+            //! Builds simplified levels, should be called before MakeRenderable.
+            //! Triangle strips are converted to lists. Max error is a fraction of model diameter.
+            void GenerateLods(u32 num_lods, f32 max_relative_error = 0.05f);
+            u32 num_lods() const;           //!< including full detail
+            void set_lod(u32 lod);          //!< level used by Render, 0 is full detail
+            u32 lod() const;
+            //! Chooses level by projected size of model diameter in pixels, see ComputeScreenSize
+            void SelectLod(f32 screen_size, f32 max_pixel_error = 1.0f);
+
+            //! Transform from stored positions to original ones, identity unless positions are quantized
+            const VertexQuantization& vertex_quantization() const;
             
         protected:            
             std::vector<Vertex> vertices_;
             std::vector<u32> indices_;
+            std::vector<MeshLod> lods_;     //!< coarser levels, indices are freed when renderable
             
             PrimitiveType primitive_mode_;
             
         private:
+            //! Part of index buffer used by level
+            struct LodRange {
+                u32 first_index;
+                u32 num_indices;
+            };
+
             void FreeArrays();
-            void TransformVertices();
+            void TransformVertices(const VertexPacker& packer);
+            void ConvertStripToList();
             
             Renderer * renderer_;
             VertexFormat * vertex_format_;
@@ -53,6 +83,12 @@ namespace sht {
             DataType index_data_type_;
             
             std::vector<VertexAttribute> attribs_;
+            u32 vertex_compression_;
+            VertexQuantization quantization_;
+            
+            std::vector<LodRange> lod_ranges_;
+            u32 lod_;
+            f32 diameter_;                  //!< measured when levels are built
         };
         
     }
@@ -0,0 +1,69 @@
+#pragma once
+#ifndef __SHT_GRAPHICS_OBJ_FILE_H__
+#define __SHT_GRAPHICS_OBJ_FILE_H__
+
+#include "vertex.h"
+#include "../material.h"
+#include "../../../common/types.h"
+#include "../../../math/bounding_box.h"
+
+#include <string>
+#include <vector>
+
+namespace sht {
+	namespace graphics {
+
+		//! Indexed triangle list of all faces with the same material
+		struct ObjMesh {
+			u32 material_index;
+			std::vector<Vertex> vertices;	//!< one per unique position, texcoord and normal triple
+			std::vector<u32> indices;
+		};
+
+		//! Reads Wavefront OBJ file with its material libraries.
+		//! File is mapped and split into line aligned chunks that are parsed in parallel,
+		//! polygons are triangulated as fans. Faces without known material get a default one.
+		class ObjReader {
+		public:
+			ObjReader();
+
+			bool Open(const char *filename);
+
+			const std::vector<Material>& materials() const;
+			std::vector<ObjMesh>& meshes();
+			const math::BoundingBox& bounding_box() const;
+
+		private:
+			bool LoadMaterialLibrary(const std::string& filename, std::vector<std::string> * names);
+
+			std::vector<Material> materials_;
+			std::vector<ObjMesh> meshes_;
+			math::BoundingBox bounding_box_;
+		};
+
+		//! Mesh data to write, vertices and indices should be alive until file is saved
+		struct ObjMeshData {
+			u32 material_index;
+			const Vertex * vertices;
+			u32 num_vertices;
+			const u32 * indices;		//!< triangle list, null if vertices are triangle list themselves
+			u32 num_indices;
+		};
+
+		//! Writes Wavefront OBJ file and material library with the same name next to it
+		class ObjWriter {
+		public:
+			void AddMaterial(const Material& material);
+			void AddMesh(const ObjMeshData& mesh);
+
+			bool Save(const char *filename);
+
+		private:
+			std::vector<Material> materials_;
+			std::vector<ObjMeshData> meshes_;
+		};
+
+	} // namespace graphics
+} // namespace sht
+
+#endif
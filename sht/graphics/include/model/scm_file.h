@@ -0,0 +1,177 @@
+#pragma once
+#ifndef __SHT_GRAPHICS_SCM_FILE_H__
+#define __SHT_GRAPHICS_SCM_FILE_H__
+
+#include "vertex_packer.h"
+#include "../material.h"
+#include "../renderer/vertex_format.h"
+#include "../../../common/types.h"
+#include "../../../math/bounding_box.h"
+#include "../../../system/include/stream/mapped_file.h"
+
+#include <vector>
+
+namespace sht {
+	namespace graphics {
+
+		/*
+		Shtille Complex Mesh file, version 2.
+		Header and section table are followed by sections aligned to kScmAlignment.
+		Vertex sections hold interleaved vertices in file vertex format, index sections hold 16-bit indices
+		if vertices allow, levels of detail follow full detail indices. Uncompressed sections are used right
+		from mapped file, so loading doesn't touch vertex data at all.
+		*/
+
+		const u32 kScmVersion = 2;
+		const u32 kScmAlignment = 16;
+
+		enum class ScmCompression : u32 {
+			kNone,
+			kDeflate,		//!< zlib stream
+			kFiltered		//!< vertex bytes are transposed and delta coded, indices are delta coded, then deflated
+		};
+
+		enum class ScmSectionType : u32 {
+			kAttributes,	//!< ScmAttribute array
+			kMaterials,		//!< Material array
+			kMeshes,		//!< ScmMeshEntry array
+			kLods,			//!< ScmLod array
+			kHierarchy,		//!< ScmNode array
+			kVertices,
+			kIndices
+		};
+
+		struct ScmHeader {
+			u32 signature;
+			u32 version;
+			u32 num_sections;
+			u32 vertex_size;
+			math::BoundingBox bounding_box;
+			VertexQuantization quantization;
+			u32 reserved[2];
+		};
+
+		struct ScmSection {
+			ScmSectionType type;
+			ScmCompression compression;
+			u32 stride;				//!< element size used by filter
+			u32 reserved;
+			u64 offset;
+			u64 size;				//!< stored size
+			u64 raw_size;			//!< size after decompression
+		};
+
+		struct ScmAttribute {
+			u32 type;
+			u32 size;
+			u32 format;
+			u32 reserved;
+		};
+
+		//! Range of level of detail in mesh indices, level 0 is full detail
+		struct ScmLod {
+			u32 first_index;
+			u32 num_indices;
+			f32 error;
+			u32 reserved;
+		};
+
+		struct ScmMeshEntry {
+			u32 material_index;
+			u32 primitive_mode;
+			u32 num_vertices;
+			u32 num_indices;		//!< of all levels
+			u32 index_size;
+			u32 vertex_section;
+			u32 index_section;		//!< invalid if mesh has no indices
+			u32 first_lod;
+			u32 num_lods;
+			u32 reserved;
+			math::BoundingBox bounding_box;
+		};
+
+		//! Node of bounding box hierarchy over meshes stored in depth first order.
+		//! Skip is index of the node following subtree, so hierarchy is traversed without stack.
+		struct ScmNode {
+			math::BoundingBox bounding_box;
+			s32 mesh;				//!< negative for inner nodes
+			u32 skip;
+		};
+
+		//! Mesh data ready for vertex and index buffers
+		struct ScmMesh {
+			u32 material_index;
+			u32 primitive_mode;
+			math::BoundingBox bounding_box;
+			const u8 * vertices;
+			u32 num_vertices;
+			const u8 * indices;		//!< null if mesh has no indices
+			u32 num_indices;		//!< of all levels
+			u32 index_size;
+			std::vector<ScmLod> lods;
+		};
+
+		//! Builds hierarchy by splitting meshes in the middle of the longest axis
+		void BuildScmHierarchy(const std::vector<math::BoundingBox>& boxes, std::vector<ScmNode> * nodes);
+
+		//! Writes version 2 file, data of added meshes should be alive until file is saved
+		class ScmWriter {
+		public:
+			ScmWriter();
+
+			void set_compression(ScmCompression compression);	//!< of vertex and index sections
+			void SetVertexFormat(const std::vector<VertexAttribute>& attribs, u32 vertex_size,
+				const VertexQuantization& quantization);
+			void SetBoundingBox(const math::BoundingBox& bounding_box);
+			void AddMaterial(const Material& material);
+			void AddMesh(const ScmMesh& mesh);
+
+			bool Save(const char *filename);
+
+		private:
+			ScmCompression compression_;
+			ScmHeader header_;
+			std::vector<ScmAttribute> attribs_;
+			std::vector<Material> materials_;
+			std::vector<ScmMesh> meshes_;
+		};
+
+		//! Reads version 2 file. Data stays valid until reader is closed or destroyed.
+		class ScmReader {
+		public:
+			ScmReader();
+
+			bool Open(const char *filename);
+			void Close();
+
+			//! Version of file without opening it, zero if it isn't SCM
+			static u32 ReadVersion(const char *filename);
+
+			const math::BoundingBox& bounding_box() const;
+			const VertexQuantization& quantization() const;
+			u32 vertex_size() const;
+			const std::vector<VertexAttribute>& attribs() const;
+			const std::vector<Material>& materials() const;
+			const std::vector<ScmMesh>& meshes() const;
+			const std::vector<ScmNode>& hierarchy() const;
+			u32 num_decompressed_bytes() const;		//!< zero if all data is used right from file
+
+		private:
+			//! Points at section data, decompresses it if needed
+			const u8 * GetSection(u32 index, u64 expected_size);
+
+			system::MappedFile file_;
+			ScmHeader header_;
+			const ScmSection * sections_;
+			std::vector<VertexAttribute> attribs_;
+			std::vector<Material> materials_;
+			std::vector<ScmMesh> meshes_;
+			std::vector<ScmNode> hierarchy_;
+			std::vector<std::vector<u8>> buffers_;	//!< decompressed sections
+			u32 num_decompressed_bytes_;
+		};
+
+	} // namespace graphics
+} // namespace sht
+
+#endif
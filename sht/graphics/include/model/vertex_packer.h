@@ -0,0 +1,59 @@
+#pragma once
+#ifndef __SHT_GRAPHICS_VERTEX_PACKER_H__
+#define __SHT_GRAPHICS_VERTEX_PACKER_H__
+
+#include "vertex.h"
+#include "../renderer/vertex_format.h"
+
+#include <vector>
+
+namespace sht {
+	namespace graphics {
+
+		//! Attributes to store in compact formats
+		enum VertexCompression : u32 {
+			kCompressNone		= 0,
+			kCompressNormals	= 1,	//!< normals, tangents and binormals as 10-10-10-2 snorm
+			kCompressTexcoords	= 2,	//!< 16-bit normalized if in [0,1] or [-1,1], half float otherwise
+			kQuantizePositions	= 4,	//!< 16-bit snorm relative to bounds, needs dequantization transform
+			kCompressAll		= 7
+		};
+
+		//! Transform of quantized positions: position = packed * scale + offset.
+		//! Scale is uniform, so model matrix multiplied by it keeps normals undistorted.
+		struct VertexQuantization {
+			vec3 offset;
+			f32 scale;
+		};
+
+		//! Converts vertices to vertex buffer data.
+		//! Vertices of all meshes sharing a vertex format should be added before formats are chosen.
+		class VertexPacker {
+		public:
+			explicit VertexPacker(u32 compression = kCompressNone);
+
+			void AddVertices(const std::vector<Vertex>& vertices);	//!< gathers ranges of attributes
+
+			//! Replaces float formats according to compression flags, explicitly set formats are kept.
+			//! Quantization is computed if positions end up in normalized format.
+			void ChooseFormats(std::vector<VertexAttribute> * attribs);
+
+			void Pack(const std::vector<Vertex>& vertices, const std::vector<VertexAttribute>& attribs,
+				u32 vertex_size, u8 * data) const;
+
+			const VertexQuantization& quantization() const;
+
+		private:
+			u32 compression_;
+			vec3 min_position_;
+			vec3 max_position_;
+			vec2 min_texcoord_;
+			vec2 max_texcoord_;
+			u32 num_vertices_;
+			VertexQuantization quantization_;
+		};
+
+	} // namespace graphics
+} // namespace sht
+
+#endif
@@ -0,0 +1,79 @@
+#pragma once
+#ifndef __SHT_GRAPHICS_RENDERER_CASCADED_SHADOWS_H__
+#define __SHT_GRAPHICS_RENDERER_CASCADED_SHADOWS_H__
+
+#include "../../../common/types.h"
+#include "../../../math/sht_math.h"
+#include "../../../math/frustum.h"
+#include "../../../math/bounding_box.h"
+
+#include <vector>
+
+namespace sht {
+	namespace graphics {
+
+		//! Cascaded shadow maps of directional light, CPU side.
+		//! View frustum is split into cascades, each one is covered by orthographic light projection
+		//! fitted to bounding sphere of the slice and snapped to shadow map texels, so shadows don't shimmer
+		//! when camera moves or rotates. Shadow map textures are owned by the user.
+		class CascadedShadows {
+		public:
+			static const int kMaxCascades = 4;
+
+			struct Cascade {
+				math::Matrix4 view;				//!< light view matrix
+				math::Matrix4 projection;		//!< orthographic projection
+				math::Matrix4 projection_view;
+				math::Frustum frustum;			//!< light frustum for caster culling
+				math::Vector3 center;			//!< snapped center in light view space
+				float radius;					//!< radius of bounding sphere of the slice
+				float split_near;				//!< view distance where cascade starts
+				float split_far;				//!< view distance where cascade ends
+				bool static_valid;				//!< static casters rendered last time are still valid
+			};
+
+			CascadedShadows(int num_cascades, int resolution);
+
+			//! Fits cascades to the camera frustum.
+			//! Light direction is direction of light rays, fov is vertical one in degrees.
+			void Update(const math::Matrix4& camera_view, float fov, float aspect, float znear, float zfar,
+				const math::Vector3& light_direction);
+
+			bool IsCasterVisible(int index, const math::BoundingBox& box) const;
+			//! Fills indices of boxes that cast shadows into the cascade, returns their number
+			u32 CullCasters(int index, const math::BoundingBox * boxes, u32 count, std::vector<u32> * visible) const;
+
+			//! Remembers matrices static casters of the cascade have been rendered with.
+			//! Cascade keeps static_valid while its matrices stay the same.
+			void MarkStaticRendered(int index);
+			void InvalidateStatic();					//!< should be called when static casters change
+
+			int SelectCascade(float view_depth) const;	//!< index of cascade covering view depth
+			math::Matrix4 GetShadowMatrix(int index) const; //!< transforms world position into shadow map coordinates
+
+			//! Blend between uniform (0) and logarithmic (1) distribution of splits
+			void set_split_lambda(float lambda);
+			//! Distance behind cascade towards light covered by depth range
+			void set_caster_distance(float distance);
+
+			int num_cascades() const;
+			int resolution() const;
+			const Cascade& cascade(int index) const;
+
+		private:
+			void FitCascade(Cascade& cascade, const math::Matrix4& camera_world, float tan_half_fov, float aspect);
+
+			Cascade cascades_[kMaxCascades];
+			math::Matrix4 static_matrices_[kMaxCascades];	//!< matrices of the last static casters rendering
+			bool static_rendered_[kMaxCascades];
+			math::Vector3 light_direction_;
+			int num_cascades_;
+			int resolution_;
+			float split_lambda_;
+			float caster_distance_;
+		};
+
+	} // namespace graphics
+} // namespace sht
+
+#endif
@@ -3,7 +3,9 @@
 #define __SHT_GRAPHICS_CONTEXT_H__
 
 #include "../../../common/types.h"
-#include "../../../common/table.h"
+
+#include <string>
+#include <vector>
 
 namespace sht {
     namespace graphics {
@@ -21,6 +23,11 @@ namespace sht {
             kUnsignedShort,
             kUnsignedInt,
             kFloat,
+            kByte,
+            kUnsignedByte,
+            kShort,
+            kHalfFloat,
+            kInt2101010Rev,     //!< packed signed 10-10-10-2 components
             kCount
         };
         
@@ -50,8 +57,27 @@ namespace sht {
             kCount
         };
         
+        typedef void * SyncObject; //!< API fence object
+        
+        //! Information about active uniform of linked program
+        struct UniformInfo {
+            std::string name;   //!< name without array suffix
+            s32 location;       //!< uniform location
+            u32 type;           //!< API specific type
+            u32 size;           //!< size of single element in bytes, zero if unknown
+            u32 count;          //!< number of array elements
+        };
+        
+        //! Number of state changing calls per frame
+        struct ContextStateCounters {
+            u32 issued;     //!< calls passed to API
+            u32 filtered;   //!< redundant calls that have been skipped
+        };
+        
         class Context {
         public:
+            static const u32 kMaxTextureUnits = 16;   //!< number of texture units tracked by state cache
+            
             Context();
             virtual ~Context();
             
@@ -60,67 +86,98 @@ namespace sht {
             virtual bool CheckForErrors() = 0;
 			virtual bool CheckFrameBufferStatus() = 0;
             
-            virtual void ClearColor(f32 r, f32 g, f32 b, f32 a) = 0;
+            void ClearColor(f32 r, f32 g, f32 b, f32 a);
             virtual void ClearColorBuffer() = 0;
             virtual void ClearDepthBuffer() = 0;
             virtual void ClearColorAndDepthBuffers() = 0;
             virtual void ClearStencil(s32 value) = 0;
             virtual void ClearStencilBuffer() = 0;
             
-            virtual void Viewport(int w, int h) = 0;
+            void Viewport(int w, int h);
             
-            virtual void EnableBlend() = 0;
-            virtual void DisableBlend() = 0;
+            void EnableBlend();
+            void DisableBlend();
             
-            virtual void EnableDepthTest() = 0;
-            virtual void DisableDepthTest() = 0;
-            virtual void EnableDepthWrite() = 0;
-            virtual void DisableDepthWrite() = 0;
+            void EnableDepthTest();
+            void DisableDepthTest();
+            void EnableDepthWrite();
+            void DisableDepthWrite();
             
-            virtual void EnableStencilTest() = 0;
-            virtual void DisableStencilTest() = 0;
-            virtual void StencilMask(u32 mask) = 0;
+            void EnableStencilTest();
+            void DisableStencilTest();
+            void StencilMask(u32 mask);
             //virtual void StencilFunc() = 0;
             //virtual void StencilOp() = 0;
             
-            virtual void EnableWireframeMode() = 0;
-            virtual void DisableWireframeMode() = 0;
+            void EnableWireframeMode();
+            void DisableWireframeMode();
             
-            virtual void CullFace(CullFaceType mode) = 0;
+            void CullFace(CullFaceType mode);
             
             virtual void DrawArrays(PrimitiveType mode, s32 first, u32 count) = 0;
             virtual void DrawElements(PrimitiveType mode, u32 num_indices, DataType index_type) = 0;
+            virtual void DrawArraysInstanced(PrimitiveType mode, s32 first, u32 count, u32 num_instances) = 0;
+            virtual void DrawElementsInstanced(PrimitiveType mode, u32 num_indices, DataType index_type, u32 num_instances) = 0;
+            //! Draws indices starting from first index, base vertex is added to each index value
+            virtual void DrawElementsBaseVertex(PrimitiveType mode, u32 num_indices, DataType index_type,
+                u32 first_index, s32 base_vertex) = 0;
+            //! Issues a number of base vertex draws in a single call
+            virtual void MultiDrawElementsBaseVertex(PrimitiveType mode, const u32 * num_indices, DataType index_type,
+                const u32 * first_indices, const s32 * base_vertices, u32 draw_count) = 0;
             
             // Vertex array object
             virtual void GenVertexArrayObject(u32 &obj) = 0;
-            virtual void DeleteVertexArrayObject(u32 &obj) = 0;
-            virtual void BindVertexArrayObject(u32 obj) = 0;
+            void DeleteVertexArrayObject(u32 &obj);
+            void BindVertexArrayObject(u32 obj);
             
             // Vertex buffer object
             virtual void GenVertexBuffer(u32& obj) = 0;
-            virtual void DeleteVertexBuffer(u32& obj) = 0;
-            virtual void BindVertexBuffer(u32 obj) = 0;
+            void DeleteVertexBuffer(u32& obj);
+            void BindVertexBuffer(u32 obj);
             virtual void VertexBufferData(u32 size, const void *data, BufferUsage usage) = 0;
-            virtual void VertexBufferSubData(u32 size, const void *data) = 0;
+            virtual void VertexBufferSubData(u32 offset, u32 size, const void *data) = 0;
             virtual void* MapVertexBufferData(DataAccessType access) = 0;
             virtual void UnmapVertexBufferData() = 0;
+            //! Write only mapping without implicit synchronization, caller should make sure range isn't used by GPU
+            virtual void* MapVertexBufferRange(u32 offset, u32 size) = 0;
+            //! Allocates immutable storage mapped for the whole buffer lifetime, returns nullptr if not supported
+            virtual void* MapVertexBufferPersistent(u32 size) = 0;
             
             // Index buffer object
             virtual void GenIndexBuffer(u32& obj) = 0;
-            virtual void DeleteIndexBuffer(u32& obj) = 0;
-            virtual void BindIndexBuffer(u32 obj) = 0;
+            void DeleteIndexBuffer(u32& obj);
+            void BindIndexBuffer(u32 obj);
             virtual void IndexBufferData(u32 size, const void *data, BufferUsage usage) = 0;
-            virtual void IndexBufferSubData(u32 size, const void *data) = 0;
+            virtual void IndexBufferSubData(u32 offset, u32 size, const void *data) = 0;
             virtual void* MapIndexBufferData(DataAccessType access) = 0;
             virtual void UnmapIndexBufferData() = 0;
             
             // Vertex attribs
-            virtual void VertexAttribPointer(u32 index, s32 size, DataType type, u32 stride, const void* ptr) = 0;
+            //! Normalized integer attributes are mapped to [0,1] or [-1,1], others are converted to float as is
+            virtual void VertexAttribPointer(u32 index, s32 size, DataType type, u32 stride, const void* ptr,
+                bool normalized = false) = 0;
             virtual void EnableVertexAttribArray(u32 index) = 0;
+            virtual void VertexAttribDivisor(u32 index, u32 divisor) = 0; //!< zero divisor means per vertex attribute
+            
+            // Synchronization
+            virtual SyncObject FenceSync() = 0;     //!< returns nullptr if fences aren't supported
+            virtual bool ClientWaitSync(SyncObject sync, u64 timeout_ns) = 0; //!< returns true if fence has been signaled
+            virtual void DeleteSync(SyncObject sync) = 0;
+            
+            // Texture
+            void ActiveTexture(u32 unit);
+            void BindTexture(u32 target, u32 obj);  //!< binds texture to active unit
+            void DeleteTexture(u32& obj);
+            virtual void TextureImage2D(u32 target, s32 level, s32 internal_format, s32 w, s32 h,
+                u32 format, u32 type, const void *data) = 0;   //!< (re)allocates texture level storage
+            virtual void TextureSubImage2D(u32 target, s32 level, s32 x, s32 y, s32 w, s32 h,
+                u32 format, u32 type, const void *data) = 0;
+            virtual void GetTextureImage(u32 target, s32 level, u32 format, u32 type, void *data) = 0; //!< rows are tightly packed
+            virtual void GenerateMipmap(u32 target) = 0;
             
             // Shader
-            virtual void DeleteProgram(u32 program) = 0;
-            virtual void BindProgram(u32 program) = 0;
+            void DeleteProgram(u32 program);
+            void BindProgram(u32 program);
             virtual void BindAttribLocation(u32 program, const char *name) = 0;
             virtual void Uniform1i(u32 program, const char *name, int x) = 0;
             virtual void Uniform2i(u32 program, const char *name, int x, int y) = 0;
@@ -137,15 +194,111 @@ namespace sht {
             virtual void UniformMatrix2fv(u32 program, const char *name, const float *v, bool trans = false, int n = 1) = 0;
             virtual void UniformMatrix3fv(u32 program, const char *name, const float *v, bool trans = false, int n = 1) = 0;
             virtual void UniformMatrix4fv(u32 program, const char *name, const float *v, bool trans = false, int n = 1) = 0;
+
+            // Uniform reflection
+            virtual void GetActiveUniforms(u32 program, std::vector<UniformInfo> * uniforms) = 0;
+            
+            // Uniforms by location, program should be bound
+            virtual void SetUniform1i(s32 location, int x) = 0;
+            virtual void SetUniform2i(s32 location, int x, int y) = 0;
+            virtual void SetUniform3i(s32 location, int x, int y, int z) = 0;
+            virtual void SetUniform4i(s32 location, int x, int y, int z, int w) = 0;
+            virtual void SetUniform1f(s32 location, float x) = 0;
+            virtual void SetUniform2f(s32 location, float x, float y) = 0;
+            virtual void SetUniform3f(s32 location, float x, float y, float z) = 0;
+            virtual void SetUniform4f(s32 location, float x, float y, float z, float w) = 0;
+            virtual void SetUniform1fv(s32 location, const float *v, int n = 1) = 0;
+            virtual void SetUniform2fv(s32 location, const float *v, int n = 1) = 0;
+            virtual void SetUniform3fv(s32 location, const float *v, int n = 1) = 0;
+            virtual void SetUniform4fv(s32 location, const float *v, int n = 1) = 0;
+            virtual void SetUniformMatrix2fv(s32 location, const float *v, bool trans = false, int n = 1) = 0;
+            virtual void SetUniformMatrix3fv(s32 location, const float *v, bool trans = false, int n = 1) = 0;
+            virtual void SetUniformMatrix4fv(s32 location, const float *v, bool trans = false, int n = 1) = 0;
+            
+            // Uniform buffer object
+            virtual void GenUniformBuffer(u32& obj) = 0;
+            virtual void DeleteUniformBuffer(u32& obj) = 0;
+            virtual void BindUniformBuffer(u32 obj) = 0;
+            virtual void UniformBufferData(u32 size, const void *data, BufferUsage usage) = 0;
+            virtual void UniformBufferSubData(u32 offset, u32 size, const void *data) = 0;
+            virtual void BindUniformBufferBase(u32 binding, u32 obj) = 0;
+            virtual s32 GetUniformBlockIndex(u32 program, const char *name) = 0;
+            virtual void UniformBlockBinding(u32 program, u32 block_index, u32 binding) = 0;
+            
+            // Pixel pack buffer object, used for asynchronous readback
+            virtual void GenPixelBuffer(u32& obj) = 0;
+            virtual void DeletePixelBuffer(u32& obj) = 0;
+            virtual void BindPixelPackBuffer(u32 obj) = 0;  //!< zero makes ReadPixels write to client memory
+            virtual void PixelPackBufferData(u32 size) = 0; //!< allocates storage of bound buffer for reading
+            //! Reads framebuffer pixels, data is offset in bound pixel pack buffer if any.
+            //! Reading into buffer doesn't wait for GPU, waiting happens on map.
+            virtual void ReadPixels(s32 x, s32 y, s32 w, s32 h, u32 format, u32 type, void *data) = 0;
+            virtual const void* MapPixelPackBuffer(u32 size) = 0;   //!< maps bound buffer for reading
+            virtual void UnmapPixelPackBuffer() = 0;
+            
+            //! Forgets cached state, should be called after API calls made outside of context
+            void InvalidateState();
+            void NewFrame();    //!< finishes state counters of the frame
+            const ContextStateCounters& state_counters() const; //!< counters of the last finished frame
             
         protected:
-            virtual void FillTables() = 0;
+            // State changing functions, they're called only if state actually changes
+            virtual void ApiClearColor(f32 r, f32 g, f32 b, f32 a) = 0;
+            virtual void ApiViewport(int w, int h) = 0;
+            virtual void ApiEnableBlend() = 0;
+            virtual void ApiDisableBlend() = 0;
+            virtual void ApiEnableDepthTest() = 0;
+            virtual void ApiDisableDepthTest() = 0;
+            virtual void ApiEnableDepthWrite() = 0;
+            virtual void ApiDisableDepthWrite() = 0;
+            virtual void ApiEnableStencilTest() = 0;
+            virtual void ApiDisableStencilTest() = 0;
+            virtual void ApiStencilMask(u32 mask) = 0;
+            virtual void ApiEnableWireframeMode() = 0;
+            virtual void ApiDisableWireframeMode() = 0;
+            virtual void ApiCullFace(CullFaceType mode) = 0;
+            virtual void ApiDeleteVertexArrayObject(u32 &obj) = 0;
+            virtual void ApiBindVertexArrayObject(u32 obj) = 0;
+            virtual void ApiDeleteVertexBuffer(u32& obj) = 0;
+            virtual void ApiBindVertexBuffer(u32 obj) = 0;
+            virtual void ApiDeleteIndexBuffer(u32& obj) = 0;
+            virtual void ApiBindIndexBuffer(u32 obj) = 0;
+            virtual void ApiDeleteProgram(u32 program) = 0;
+            virtual void ApiBindProgram(u32 program) = 0;
+            virtual void ApiActiveTexture(u32 unit) = 0;
+            virtual void ApiBindTexture(u32 target, u32 obj) = 0;
+            virtual void ApiDeleteTexture(u32& obj) = 0;
+            
+        private:
+            //! Shadow copy of API state, negative values and kUnknownObject mean unknown state
+            struct State {
+                int blend;
+                int depth_test;
+                int depth_write;
+                int stencil_test;
+                int wireframe;
+                int cull_face;
+                int viewport_width;
+                int viewport_height;
+                u32 stencil_mask;
+                bool stencil_mask_known;
+                f32 clear_color[4];
+                bool clear_color_known;
+                u32 vertex_array_object;
+                u32 vertex_buffer;
+                u32 index_buffer;
+                u32 program;
+                u32 active_texture;
+                u32 textures[kMaxTextureUnits];         //!< textures bound to units
+                u32 texture_targets[kMaxTextureUnits];  //!< targets of bound textures
+            };
+            
+            bool ChangeState(int& current, int value);  //!< returns true if value differs
+            bool ChangeState(u32& current, u32 value);  //!< returns true if value differs
             
-            EnumTable<PrimitiveType, u32> primitive_type_map_;  //!< primitive type map
-            EnumTable<DataType, u32> data_type_map_;            //!< data type map
-            EnumTable<DataAccessType, u32> data_access_map_;    //!< data access map
-            EnumTable<BufferUsage, u32> buffer_usage_map_;      //!< buffer usage map
-            EnumTable<CullFaceType, u32> cull_face_map_;        //!< cull face map
+            State state_;
+            ContextStateCounters counters_;             //!< counters of current frame
+            ContextStateCounters last_frame_counters_;  //!< counters of the last finished frame
         };
         
     }
@@ -2,6 +2,8 @@
 #ifndef __SHT_GRAPHICS_CUBEMAP_FACE_FILLER_H__
 #define __SHT_GRAPHICS_CUBEMAP_FACE_FILLER_H__
 
+#include <vector>
+
 namespace sht {
 	namespace graphics {
 
@@ -15,6 +17,7 @@ namespace sht {
 			virtual ~CubemapFaceFiller();
 
 			virtual bool Fill(int face, Image * image) = 0;
+			virtual bool FillAll(Image * images); //!< fills all six faces
 
 		protected:
 			Image * source_image_;
@@ -28,15 +31,37 @@ namespace sht {
 			bool Fill(int face, Image * image);
 		};
 
-		//! Sphere cubemap face filler
+		//! Sphere (equirectangular) cubemap face filler
 		class SphereCubemapFaceFiller : public CubemapFaceFiller {
 		public:
-			SphereCubemapFaceFiller(Image * source_image, int face_width);
+			enum class Filter {
+				kNearest,
+				kBilinear,
+				kArea		//!< averages source texels covered by face texel footprint
+			};
+
+			SphereCubemapFaceFiller(Image * source_image, int face_width, Filter filter = Filter::kBilinear);
 
 			bool Fill(int face, Image * image);
+			bool FillAll(Image * images);
 
 		private:
+			//! Equirectangular coordinates of face texel, both in [0; 1] range
+			struct TexCoord {
+				float u;
+				float v;
+			};
+
+			void MakeTables();
+			void GetTexCoord(int face, int i, int j, float * u, float * v) const;
+			void FillRows(int face, Image * image, int begin_row, int end_row) const;
+			template <typename T>
+			void FillRows(int face, const T * src_pixels, T * dst_pixels, int begin_row, int end_row) const;
+
 			int face_width_;
+			Filter filter_;
+			std::vector<TexCoord> side_table_;	//!< coordinates for +X face, other side faces differ by longitude
+			std::vector<TexCoord> top_table_;	//!< coordinates for -Y face, +Y face is mirrored
 		};
 
 	} // namespace graphics
@@ -36,6 +36,7 @@ namespace sht {
         class Font : public Resource {
             friend class Renderer;
             friend class OpenGlRenderer;
+            friend class NullRenderer;
             
         public:
             const FontCharInfo* info(u32 charcode) const;
@@ -0,0 +1,88 @@
+#pragma once
+#ifndef __SHT_GRAPHICS_RENDERER_FRAME_GRAPH_H__
+#define __SHT_GRAPHICS_RENDERER_FRAME_GRAPH_H__
+
+#include "../../../common/types.h"
+#include "render_target_pool.h"
+
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace sht {
+	namespace graphics {
+
+		//! Description of frame rendering as passes reading and writing render targets.
+		//! Passes are executed in order of addition. Transient targets live from the first pass that uses them
+		//! to the last one, targets with equal descriptions and non-overlapping lifetimes share memory.
+		//! Passes that don't contribute to imported targets are culled.
+		class FrameGraph {
+		public:
+			typedef u32 ResourceId;
+			typedef u32 PassId;
+			typedef std::function<void(FrameGraph& graph)> ExecuteFunction;
+
+			static const u32 kInvalidIndex = 0xffffffff;
+
+			FrameGraph();
+
+			ResourceId CreateTarget(const char* name, const RenderTargetDesc& desc);	//!< transient target from the pool
+			ResourceId ImportTarget(const char* name, Texture * texture);				//!< external target, never culled or aliased
+			PassId AddPass(const char* name, const ExecuteFunction& execute);
+			void Read(PassId pass, ResourceId resource);
+			void Write(PassId pass, ResourceId resource);
+
+			//! Culls passes, computes lifetimes of targets and assigns them to physical targets.
+			//! Fails if transient target is read before any pass has written it.
+			bool Compile();
+
+			//! Executes compiled passes, physical targets are acquired right before first use
+			//! and returned to the pool right after last use.
+			void Execute(RenderTargetPool * pool);
+
+			Texture * GetTexture(ResourceId resource) const;	//!< valid within execution of passes using the target
+
+			void Clear();								//!< removes all passes and targets, graph is rebuilt every frame
+
+			u32 num_passes() const;
+			u32 num_resources() const;
+			u32 num_physical_targets() const;
+			bool pass_culled(PassId pass) const;
+			u32 first_use(ResourceId resource) const;		//!< index of the first pass using the target
+			u32 last_use(ResourceId resource) const;		//!< index of the last pass using the target
+			u32 physical_index(ResourceId resource) const;	//!< kInvalidIndex for imported and unused targets
+			const std::string& error() const;				//!< description of the last failure
+
+		private:
+			struct Resource {
+				std::string name;
+				RenderTargetDesc desc;
+				Texture * imported;
+				u32 first_use;
+				u32 last_use;
+				u32 physical_index;
+			};
+			struct Pass {
+				std::string name;
+				ExecuteFunction execute;
+				std::vector<ResourceId> reads;
+				std::vector<ResourceId> writes;
+				bool culled;
+			};
+			struct PhysicalTarget {
+				RenderTargetDesc desc;
+				u32 first_use;
+				u32 last_use;
+				Texture * texture;
+			};
+
+			std::vector<Resource> resources_;
+			std::vector<Pass> passes_;
+			std::vector<PhysicalTarget> physical_targets_;
+			std::string error_;
+		};
+
+	} // namespace graphics
+} // namespace sht
+
+#endif
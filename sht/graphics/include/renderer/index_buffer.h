@@ -10,6 +10,7 @@ namespace sht {
         class IndexBuffer final : public VideoMemoryBuffer {
             friend class Renderer;
             friend class OpenGlRenderer;
+            friend class NullRenderer;
             
         protected:
             IndexBuffer(Context * context);
@@ -0,0 +1,53 @@
+#pragma once
+#ifndef __SHT_GRAPHICS_INSTANCE_BATCH_H__
+#define __SHT_GRAPHICS_INSTANCE_BATCH_H__
+
+#include "../../../common/types.h"
+#include "../../../math/matrix.h"
+#include "../../../math/vector.h"
+#include "context.h"
+
+#include <vector>
+
+namespace sht {
+    namespace graphics {
+        
+        //! Stream of per-instance transforms and colors for instanced drawing.
+        //! Instances are collected on CPU and uploaded once per frame,
+        //! so any number of objects sharing the same mesh costs a single draw call.
+        class InstanceBatch {
+        public:
+            //! Number of attribute locations used: four for transform columns and one for color
+            static const u32 kNumLocations = 5;
+            
+            explicit InstanceBatch(Context * context);
+            virtual ~InstanceBatch();
+            
+            //! Sets instance attributes of currently bound vertex array object starting at given location
+            void Attach(u32 first_location);
+            
+            void Clear();
+            void Add(const math::Matrix4& transform, const vec4& color);
+            void Upload();      //!< sends instances to driver if they have changed since last upload
+            
+            u32 num_instances() const;
+            
+        protected:
+            InstanceBatch(const InstanceBatch&) = delete;
+            void operator = (const InstanceBatch&) = delete;
+            
+            struct Instance {
+                f32 transform[16];
+                f32 color[4];
+            };
+            
+            Context * context_;
+            std::vector<Instance> instances_;
+            u32 id_;
+            bool dirty_;
+        };
+        
+    } // namespace graphics
+} // namespace sht
+
+#endif
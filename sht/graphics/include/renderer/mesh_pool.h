@@ -0,0 +1,110 @@
+#pragma once
+#ifndef __SHT_GRAPHICS_MESH_POOL_H__
+#define __SHT_GRAPHICS_MESH_POOL_H__
+
+#include "../../../common/types.h"
+#include "context.h"
+#include "vertex_format.h"
+
+#include <map>
+#include <vector>
+
+namespace sht {
+    namespace graphics {
+
+        //! Shared storage for static meshes of the same vertex format.
+        //! Meshes are suballocated in one vertex and one index buffer and drawn through a single
+        //! vertex array object with base vertex draws, so switching meshes doesn't change buffer state.
+        //! Indices are stored as 32 bit values relative to the first vertex of the mesh.
+        class MeshPool {
+        public:
+            typedef u32 Handle;
+            static const Handle kInvalidHandle = 0xFFFFFFFF;
+
+            //! Buffer occupancy statistics
+            struct Stats {
+                u32 num_meshes;
+                u32 vertex_capacity;            //!< in vertices
+                u32 vertices_used;
+                u32 largest_free_vertex_range;
+                u32 index_capacity;             //!< in indices
+                u32 indices_used;
+                u32 largest_free_index_range;
+                u32 num_free_ranges;            //!< number of free ranges in both buffers
+                f32 fragmentation;              //!< part of free space outside of the largest free range, worse of both buffers
+            };
+
+            //! Buffers storage is allocated at once and doesn't grow
+            MeshPool(Context * context, const VertexAttribute * attribs, u32 num_attribs,
+                u32 vertex_capacity, u32 index_capacity);
+            virtual ~MeshPool();
+
+            //! Copies mesh data into pool. Null indices mean sequential order of vertices.
+            //! Returns kInvalidHandle if there is no contiguous free space for the mesh.
+            Handle Add(const void * vertices, u32 num_vertices, const void * indices, u32 num_indices, DataType index_type);
+            void Remove(Handle handle);
+
+            void Bind();        //!< binds pool vertex array object
+            void Unbind();
+
+            //! Draws single mesh, pool should be bound
+            void Draw(Handle handle, PrimitiveType mode);
+            //! Draws a group of meshes sharing the same state in a single call, pool should be bound
+            void DrawBatch(const Handle * handles, u32 num_handles, PrimitiveType mode);
+
+            u32 vertex_size() const;
+            u32 num_draw_calls() const;    //!< number of draw calls issued since creation
+            Stats GetStats() const;
+
+        protected:
+            MeshPool(const MeshPool&) = delete;
+            void operator = (const MeshPool&) = delete;
+
+            //! First fit allocator of ranges in linear space with coalescing of free neighbours
+            class RangeAllocator {
+            public:
+                explicit RangeAllocator(u32 capacity);
+
+                bool Allocate(u32 size, u32 * offset);
+                void Free(u32 offset, u32 size);
+
+                u32 capacity() const;
+                u32 used() const;
+                u32 largest_free_range() const;
+                u32 num_free_ranges() const;
+
+            private:
+                std::map<u32, u32> free_ranges_;   //!< size by offset
+                u32 capacity_;
+                u32 used_;
+            };
+
+            //! Placement of mesh inside pool buffers
+            struct Range {
+                u32 first_vertex;
+                u32 num_vertices;
+                u32 first_index;
+                u32 num_indices;    //!< zero for free handles
+            };
+
+            Context * context_;
+            RangeAllocator vertex_allocator_;
+            RangeAllocator index_allocator_;
+            std::vector<Range> ranges_;
+            std::vector<Handle> free_handles_;
+            std::vector<u32> scratch_indices_;      //!< indices converted to pool format
+            std::vector<u32> batch_counts_;         //!< temporary arrays for multi draw
+            std::vector<u32> batch_first_indices_;
+            std::vector<s32> batch_base_vertices_;
+            u32 vertex_size_;
+            u32 vertex_array_object_;
+            u32 vertex_buffer_;
+            u32 index_buffer_;
+            u32 num_meshes_;
+            u32 num_draw_calls_;
+        };
+
+    } // namespace graphics
+} // namespace sht
+
+#endif
@@ -0,0 +1,93 @@
+#pragma once
+#ifndef __SHT_GRAPHICS_RENDERER_NULL_RENDERER_H__
+#define __SHT_GRAPHICS_RENDERER_NULL_RENDERER_H__
+
+#include "renderer.h"
+#include "null_context.h"
+#include "shader_preprocessor.h"
+
+namespace sht {
+	namespace graphics {
+
+		//! Renderer that works without a graphics device.
+		//! All calls go to null context, so the frame can be recorded and measured with recording context.
+		class NullRenderer final : public Renderer {
+		public:
+			NullRenderer(int w, int h, NullContext * context); //!< takes ownership of context
+			virtual ~NullRenderer();
+
+			void CreateTextureColor(Texture* &texture, float r, float g, float b, float a);
+			void CreateTextureCubemap(Texture* &texture, int w, int h, Image::Format fmt = Image::Format::kRGB8, Texture::Filter filt = Texture::Filter::kLinear);
+			void CreateTextureDepth(Texture* &texture, int w, int h, u32 depthSize);
+			void CreateTexture(Texture* &texture, int w, int h, Image::Format fmt);
+			void CreateTextureFromData(Texture* &texture, int w, int h, Image::Format fmt, unsigned char *data);
+			void AddRenderTarget(Texture* &texture, int w, int h, Image::Format fmt, Texture::Filter filt = Texture::Filter::kLinear);
+			void AddRenderDepthStencil(Texture* &texture, int w, int h, u32 depthSize, u32 stencilSize);
+			void DeleteTexture(Texture* texture);
+			void ChangeTexture(Texture* texture, u32 layer = 0);
+			void ChangeRenderTargets(u8 nTargets, Texture* *colorRTs, Texture* depthRT);
+			void ChangeRenderTargetsToCube(u8 nTargets, Texture* *colorRTs, Texture* depthRT, int face, int level);
+			void GenerateMipmap(Texture* texture);
+			void CopyToTexture(Texture* texture, u32 layer = 0);
+
+			void AddVertexFormat(VertexFormat* &vf, VertexAttribute *attribs, u32 nAttribs);
+			void ChangeVertexFormat(VertexFormat* vf);
+			void DeleteVertexFormat(VertexFormat* vf);
+
+			void AddVertexBuffer(VertexBuffer* &vb, u32 size, void *data, BufferUsage usage);
+			void DeleteVertexBuffer(VertexBuffer* vb);
+
+			void AddIndexBuffer(IndexBuffer* &ib, u32 nIndices, u32 indexSize, void *data, BufferUsage usage);
+			void DeleteIndexBuffer(IndexBuffer* ib);
+
+			//! Sources are loaded and preprocessed, so missing files fail as with real renderer
+			bool AddShader(Shader* &shader, const char* filename, const char **attribs = NULL, u32 n_attribs = 0);
+			void DeleteShader(Shader* shader);
+
+			void AddFont(Font* &font, const char* fontname);
+			void DeleteFont(Font* font);
+
+			void ReadPixels(int w, int h, u8 *data); //!< fills black image
+
+			void ClearColor(f32 r, f32 g, f32 b, f32 a);
+			void ClearColorBuffer(void);
+			void ClearColorAndDepthBuffers(void);
+			void ClearDepthBuffer(void);
+			void ClearStencil(s32 value);
+			void ClearStencilBuffer();
+
+			void ChangeBlendFunc(u32 source, u32 dest);
+			void EnableBlend(void);
+			void DisableBlend(void);
+
+			void EnableDepthTest(void);
+			void DisableDepthTest(void);
+			void EnableDepthWrite(void);
+			void DisableDepthWrite(void);
+
+			void EnableStencilTest(void);
+			void DisableStencilTest(void);
+
+			void EnableWireframeMode(void);
+			void DisableWireframeMode(void);
+
+			void CullFace(CullFaceType mode);
+
+		private:
+			void SetDefaultStates();
+			void ApiAddTexture(Texture* &tex, const Image &img, Texture::Wrap wrap, Texture::Filter filt);
+			void ApiAddTextureStorage(Texture* &tex, int w, int h, Image::Format fmt, Texture::Wrap wrap, Texture::Filter filt);
+			void ApiAddTextureCubemap(Texture* &tex, Image *imgs, bool use_mipmaps = false);
+			void ApiDeleteTexture(Texture* tex);
+			void ApiViewport(int width, int height);
+			//! Creates texture object and allocates its faces through context
+			void CreateTexture2D(Texture* &tex, int w, int h, Image::Format fmt, u32 target, const u8 * const * faces);
+
+			NullContext * null_context_;			//!< same as context_
+			ShaderPreprocessor preprocessor_;		//!< loads shader sources
+		};
+
+	} // namespace graphics
+} // namespace sht
+
+#endif
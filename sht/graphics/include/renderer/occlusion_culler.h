@@ -0,0 +1,82 @@
+#pragma once
+#ifndef __SHT_GRAPHICS_RENDERER_OCCLUSION_CULLER_H__
+#define __SHT_GRAPHICS_RENDERER_OCCLUSION_CULLER_H__
+
+#include "../../../common/types.h"
+#include "../../../math/sht_math.h"
+#include "../../../math/bounding_box.h"
+#include "../../../system/include/time/clock.h"
+
+#include <vector>
+
+namespace sht {
+	namespace graphics {
+
+		//! Software occlusion culling.
+		//! Occluder meshes are rasterized into low resolution depth buffer on worker threads,
+		//! then bounding boxes are tested against hierarchical max-depth pyramid of it.
+		//! Typical frame: BeginFrame, AddOccluder for big objects, Rasterize,
+		//! then RenderQueue::Cull drops hidden packets before they are sorted and submitted.
+		class OcclusionCuller {
+		public:
+			struct Stats {
+				f32 rasterize_seconds;	//!< time of the last Rasterize call
+				f32 test_seconds;		//!< total time of TestBoxes calls this frame
+				u32 num_occluders;
+				u32 num_triangles;		//!< rasterized triangles after near plane clipping
+				u32 num_tested;			//!< boxes tested this frame
+				u32 num_culled;			//!< boxes found invisible this frame
+			};
+
+			OcclusionCuller(int width = 256, int height = 128);	//!< width is rounded up to multiple of 4
+
+			void BeginFrame(const math::Matrix4& projection_view);	//!< clears occluders and statistics
+
+			//! Adds indexed triangle mesh, vertices are transformed into clip space immediately
+			void AddOccluder(const math::Vector3 * vertices, u32 num_vertices, const u32 * indices, u32 num_indices,
+				const math::Matrix4& model);
+
+			void Rasterize();								//!< renders all occluders and builds depth pyramid
+
+			//! Returns false for boxes that are hidden by occluders or out of screen. Thread safe.
+			bool IsVisible(const math::BoundingBox& box) const;
+			//! Tests boxes on worker threads, visibility flags are written as 0 or 1. Returns number of visible boxes.
+			u32 TestBoxes(const math::BoundingBox * boxes, u32 count, std::vector<u8> * visible);
+
+			int width() const;
+			int height() const;
+			const float * depth_buffer() const;				//!< depth in [0,1], 1 where nothing was rendered
+			int num_levels() const;							//!< levels of depth pyramid including the full resolution one
+			const Stats& stats() const;
+
+		private:
+			struct ScreenTriangle {
+				f32 x[3];
+				f32 y[3];
+				f32 z[3];					//!< depth in [0,1]
+			};
+
+			void SetupTriangle(const math::Vector4& v0, const math::Vector4& v1, const math::Vector4& v2);
+			void AddScreenTriangle(const math::Vector4& v0, const math::Vector4& v1, const math::Vector4& v2);
+			void RasterizeBand(int y_begin, int y_end);
+			void BuildPyramid();
+			const float * level_data(int level) const;
+			int level_width(int level) const;
+			int level_height(int level) const;
+
+			int width_;
+			int height_;
+			math::Matrix4 projection_view_;
+			std::vector<math::Vector4> clip_vertices_;	//!< vertices of all occluders in clip space
+			std::vector<u32> indices_;					//!< indices into clip_vertices_
+			std::vector<ScreenTriangle> triangles_;
+			std::vector<float> depth_;
+			std::vector<std::vector<float> > pyramid_;	//!< max depth of 2x2 blocks of the previous level, starting with level 1
+			system::Clock clock_;
+			Stats stats_;
+		};
+
+	} // namespace graphics
+} // namespace sht
+
+#endif
@@ -15,65 +15,59 @@ namespace sht {
             bool CheckForErrors();
 			bool CheckFrameBufferStatus();
             
-            void ClearColor(f32 r, f32 g, f32 b, f32 a);
             void ClearColorBuffer();
             void ClearDepthBuffer();
             void ClearColorAndDepthBuffers();
             void ClearStencil(s32 value);
             void ClearStencilBuffer();
             
-            void Viewport(int w, int h);
-            
-            void EnableBlend();
-            void DisableBlend();
-            
-            void EnableDepthTest();
-            void DisableDepthTest();
-            void EnableDepthWrite();
-            void DisableDepthWrite();
-            
-            void EnableStencilTest();
-            void DisableStencilTest();
-            void StencilMask(u32 mask);
-            
-            void EnableWireframeMode();
-            void DisableWireframeMode();
-            
-            void CullFace(CullFaceType mode);
-            
             void DrawArrays(PrimitiveType mode, s32 first, u32 count);
             void DrawElements(PrimitiveType mode, u32 num_indices, DataType index_type);
+            void DrawArraysInstanced(PrimitiveType mode, s32 first, u32 count, u32 num_instances);
+            void DrawElementsInstanced(PrimitiveType mode, u32 num_indices, DataType index_type, u32 num_instances);
+            void DrawElementsBaseVertex(PrimitiveType mode, u32 num_indices, DataType index_type,
+                u32 first_index, s32 base_vertex);
+            void MultiDrawElementsBaseVertex(PrimitiveType mode, const u32 * num_indices, DataType index_type,
+                const u32 * first_indices, const s32 * base_vertices, u32 draw_count);
             
             // Vertex array object
             void GenVertexArrayObject(u32 &obj);
-            void DeleteVertexArrayObject(u32 &obj);
-            void BindVertexArrayObject(u32 obj);
             
             // Vertex buffer object
             void GenVertexBuffer(u32& obj);
-            void DeleteVertexBuffer(u32& obj);
-            void BindVertexBuffer(u32 obj);
             void VertexBufferData(u32 size, const void *data, BufferUsage usage);
-            void VertexBufferSubData(u32 size, const void *data);
+            void VertexBufferSubData(u32 offset, u32 size, const void *data);
             void* MapVertexBufferData(DataAccessType access);
             void UnmapVertexBufferData();
+            void* MapVertexBufferRange(u32 offset, u32 size);
+            void* MapVertexBufferPersistent(u32 size);
             
             // Index buffer object
             void GenIndexBuffer(u32& obj);
-            void DeleteIndexBuffer(u32& obj);
-            void BindIndexBuffer(u32 obj);
             void IndexBufferData(u32 size, const void *data, BufferUsage usage);
-            void IndexBufferSubData(u32 size, const void *data);
+            void IndexBufferSubData(u32 offset, u32 size, const void *data);
             void* MapIndexBufferData(DataAccessType access);
             void UnmapIndexBufferData();
             
             // Vertex attribs
-            void VertexAttribPointer(u32 index, s32 size, DataType type, u32 stride, const void* ptr);
+            void VertexAttribPointer(u32 index, s32 size, DataType type, u32 stride, const void* ptr, bool normalized = false);
             void EnableVertexAttribArray(u32 index);
+            void VertexAttribDivisor(u32 index, u32 divisor);
+            
+            // Synchronization
+            SyncObject FenceSync();
+            bool ClientWaitSync(SyncObject sync, u64 timeout_ns);
+            void DeleteSync(SyncObject sync);
+            
+            // Texture
+            void TextureImage2D(u32 target, s32 level, s32 internal_format, s32 w, s32 h,
+                u32 format, u32 type, const void *data);
+            void TextureSubImage2D(u32 target, s32 level, s32 x, s32 y, s32 w, s32 h,
+                u32 format, u32 type, const void *data);
+            void GetTextureImage(u32 target, s32 level, u32 format, u32 type, void *data);
+            void GenerateMipmap(u32 target);
             
             // Shader
-            void DeleteProgram(u32 program);
-            void BindProgram(u32 program);
             void BindAttribLocation(u32 program, const char *name);
             void Uniform1i(u32 program, const char *name, int x);
             void Uniform2i(u32 program, const char *name, int x, int y);
@@ -90,9 +84,76 @@ namespace sht {
             void UniformMatrix2fv(u32 program, const char *name, const float *v, bool trans = false, int n = 1);
             void UniformMatrix3fv(u32 program, const char *name, const float *v, bool trans = false, int n = 1);
             void UniformMatrix4fv(u32 program, const char *name, const float *v, bool trans = false, int n = 1);
+
+            // Uniform reflection
+            void GetActiveUniforms(u32 program, std::vector<UniformInfo> * uniforms);
+            
+            // Uniforms by location, program should be bound
+            void SetUniform1i(s32 location, int x);
+            void SetUniform2i(s32 location, int x, int y);
+            void SetUniform3i(s32 location, int x, int y, int z);
+            void SetUniform4i(s32 location, int x, int y, int z, int w);
+            void SetUniform1f(s32 location, float x);
+            void SetUniform2f(s32 location, float x, float y);
+            void SetUniform3f(s32 location, float x, float y, float z);
+            void SetUniform4f(s32 location, float x, float y, float z, float w);
+            void SetUniform1fv(s32 location, const float *v, int n = 1);
+            void SetUniform2fv(s32 location, const float *v, int n = 1);
+            void SetUniform3fv(s32 location, const float *v, int n = 1);
+            void SetUniform4fv(s32 location, const float *v, int n = 1);
+            void SetUniformMatrix2fv(s32 location, const float *v, bool trans = false, int n = 1);
+            void SetUniformMatrix3fv(s32 location, const float *v, bool trans = false, int n = 1);
+            void SetUniformMatrix4fv(s32 location, const float *v, bool trans = false, int n = 1);
+            
+            // Uniform buffer object
+            void GenUniformBuffer(u32& obj);
+            void DeleteUniformBuffer(u32& obj);
+            void BindUniformBuffer(u32 obj);
+            void UniformBufferData(u32 size, const void *data, BufferUsage usage);
+            void UniformBufferSubData(u32 offset, u32 size, const void *data);
+            void BindUniformBufferBase(u32 binding, u32 obj);
+            s32 GetUniformBlockIndex(u32 program, const char *name);
+            void UniformBlockBinding(u32 program, u32 block_index, u32 binding);
+            
+            // Pixel pack buffer object
+            void GenPixelBuffer(u32& obj);
+            void DeletePixelBuffer(u32& obj);
+            void BindPixelPackBuffer(u32 obj);
+            void PixelPackBufferData(u32 size);
+            void ReadPixels(s32 x, s32 y, s32 w, s32 h, u32 format, u32 type, void *data);
+            const void* MapPixelPackBuffer(u32 size);
+            void UnmapPixelPackBuffer();
             
         protected:
-            void FillTables();
+            // State
+            void ApiClearColor(f32 r, f32 g, f32 b, f32 a);
+            void ApiViewport(int w, int h);
+            void ApiEnableBlend();
+            void ApiDisableBlend();
+            void ApiEnableDepthTest();
+            void ApiDisableDepthTest();
+            void ApiEnableDepthWrite();
+            void ApiDisableDepthWrite();
+            void ApiEnableStencilTest();
+            void ApiDisableStencilTest();
+            void ApiStencilMask(u32 mask);
+            void ApiEnableWireframeMode();
+            void ApiDisableWireframeMode();
+            void ApiCullFace(CullFaceType mode);
+            void ApiDeleteVertexArrayObject(u32 &obj);
+            void ApiBindVertexArrayObject(u32 obj);
+            void ApiDeleteVertexBuffer(u32& obj);
+            void ApiBindVertexBuffer(u32 obj);
+            void ApiDeleteIndexBuffer(u32& obj);
+            void ApiBindIndexBuffer(u32 obj);
+            void ApiDeleteProgram(u32 program);
+            void ApiBindProgram(u32 program);
+            void ApiActiveTexture(u32 unit);
+            void ApiBindTexture(u32 target, u32 obj);
+            void ApiDeleteTexture(u32& obj);
+            
+        private:
+            std::vector<const void*> index_offsets_;    //!< temporary offsets for multi draw calls
         };
         
     }
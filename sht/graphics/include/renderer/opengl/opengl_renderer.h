@@ -37,6 +37,8 @@ namespace sht {
 			void DeleteIndexBuffer(IndexBuffer* ib);
 
 			bool AddShader(Shader* &shader, const char* filename, const char **attribs = NULL, u32 n_attribs = 0);
+			void AddShaderDeferred(Shader* &shader, const char* filename, const char **attribs = NULL, u32 n_attribs = 0);
+			bool CompileShaders();
 			void DeleteShader(Shader* shader);
 
 			void AddFont(Font* &font, const char* fontname);
@@ -71,6 +73,8 @@ namespace sht {
 		private:
 			void SetDefaultStates();
 			void ApiAddTexture(Texture* &tex, const Image &img, Texture::Wrap wrap, Texture::Filter filt);
+			void ApiAddTextureStorage(Texture* &tex, int w, int h, Image::Format fmt, Texture::Wrap wrap, Texture::Filter filt);
+			void ApiCreateTexture2D(Texture* &tex, int w, int h, Image::Format fmt, Texture::Wrap wrap, Texture::Filter filt, const u8 * data);
 			void ApiAddTextureCubemap(Texture* &tex, Image *imgs, bool use_mipmaps = false);
 			void ApiDeleteTexture(Texture* tex);
             void ApiViewport(int width, int height);
@@ -0,0 +1,308 @@
+#pragma once
+#ifndef __SHT_GRAPHICS_RECORDING_CONTEXT_H__
+#define __SHT_GRAPHICS_RECORDING_CONTEXT_H__
+
+#include "null_context.h"
+
+#include <string>
+#include <vector>
+
+namespace sht {
+    namespace graphics {
+
+        //! Null context that records calls reaching the API and gathers per frame statistics.
+        //! Recorded stream may be replayed on another context or compared with another recording.
+        class RecordingContext : public NullContext {
+        public:
+            enum class CommandType : u8 {
+                kClearColor,
+                kClearColorBuffer,
+                kClearDepthBuffer,
+                kClearColorAndDepthBuffers,
+                kClearStencil,
+                kClearStencilBuffer,
+                kViewport,
+                kEnableBlend,
+                kDisableBlend,
+                kEnableDepthTest,
+                kDisableDepthTest,
+                kEnableDepthWrite,
+                kDisableDepthWrite,
+                kEnableStencilTest,
+                kDisableStencilTest,
+                kStencilMask,
+                kEnableWireframeMode,
+                kDisableWireframeMode,
+                kCullFace,
+                kDrawArrays,
+                kDrawElements,
+                kDrawArraysInstanced,
+                kDrawElementsInstanced,
+                kDrawElementsBaseVertex,
+                kMultiDrawElementsBaseVertex,
+                kGenVertexArrayObject,
+                kDeleteVertexArrayObject,
+                kBindVertexArrayObject,
+                kGenVertexBuffer,
+                kDeleteVertexBuffer,
+                kBindVertexBuffer,
+                kVertexBufferData,
+                kVertexBufferSubData,
+                kMapVertexBuffer,           //!< data written through mapping is recorded on unmap
+                kMapVertexBufferPersistent,
+                kGenIndexBuffer,
+                kDeleteIndexBuffer,
+                kBindIndexBuffer,
+                kIndexBufferData,
+                kIndexBufferSubData,
+                kMapIndexBuffer,
+                kVertexAttribPointer,
+                kEnableVertexAttribArray,
+                kVertexAttribDivisor,
+                kFenceSync,
+                kClientWaitSync,
+                kDeleteSync,
+                kActiveTexture,
+                kBindTexture,
+                kDeleteTexture,
+                kTextureImage2D,
+                kTextureSubImage2D,
+                kGetTextureImage,
+                kGenerateMipmap,
+                kDeleteProgram,
+                kBindProgram,
+                kBindAttribLocation,
+                kUniform,                   //!< uniform set by name
+                kSetUniform,                //!< uniform set by location
+                kGenUniformBuffer,
+                kDeleteUniformBuffer,
+                kBindUniformBuffer,
+                kUniformBufferData,
+                kUniformBufferSubData,
+                kBindUniformBufferBase,
+                kUniformBlockBinding,
+                kGenPixelBuffer,
+                kDeletePixelBuffer,
+                kBindPixelPackBuffer,
+                kPixelPackBufferData,
+                kReadPixels,                //!< offset in pixel pack buffer or client memory read
+                kMapPixelPackBuffer,
+                kUnmapPixelPackBuffer,
+                kCount
+            };
+
+            //! Uniform functions are recorded by a single command type each
+            enum class UniformFunction : u8 {
+                k1i, k2i, k3i, k4i,
+                k1f, k2f, k3f, k4f,
+                k1fv, k2fv, k3fv, k4fv,
+                kMatrix2fv, kMatrix3fv, kMatrix4fv,
+                kCount
+            };
+
+            static const u32 kMaxCommandArgs = 8;
+
+            struct Command {
+                CommandType type;
+                u32 args[kMaxCommandArgs];  //!< unused arguments are zero, floats are stored bitwise
+                u32 data_offset;            //!< payload in data buffer
+                u32 data_size;
+            };
+
+            struct FrameStats {
+                u32 commands;
+                u32 draw_calls;
+                u32 vertices;           //!< vertices or indices submitted by draws, including instances
+                u32 binds;              //!< vertex array, buffer, program and texture binds
+                u32 state_changes;      //!< other render state changes
+                u32 uniform_uploads;
+                u32 readbacks;
+                u64 uploaded_bytes;     //!< buffer, texture and mapped data
+            };
+
+            enum class Mode {
+                kStatistics,            //!< only statistics are gathered, for benchmarks
+                kCommands,              //!< commands without uploaded buffer and texture data
+                kCommandsAndData        //!< everything needed for replay
+            };
+
+            RecordingContext();
+            virtual ~RecordingContext();
+
+            void set_mode(Mode mode);
+            Mode mode() const;
+
+            void EndFrame();            //!< finishes statistics of the current frame
+            void Clear();               //!< forgets recorded commands and statistics
+
+            u32 num_commands() const;
+            const Command& command(u32 index) const;
+            const u8 * command_data(u32 index) const;   //!< nullptr if command has no payload
+
+            u32 num_frames() const;                     //!< number of finished frames
+            const FrameStats& frame_stats(u32 frame) const;
+            const FrameStats& current_frame_stats() const;
+            FrameStats GetTotalStats() const;           //!< sum of all finished frames
+
+            //! Issues recorded commands on target context.
+            //! Objects generated through context are remapped, other identifiers (textures, programs) are kept.
+            void Replay(Context * target) const;
+
+            //! Returns true if streams are equal, otherwise index of the first differing command is written
+            bool Compare(const RecordingContext& other, u32 * difference) const;
+
+            std::string DescribeCommand(u32 index) const;   //!< text form for diff reports
+            static const char * GetCommandName(CommandType type);
+
+            // Recorded functions
+            void ClearColorBuffer();
+            void ClearDepthBuffer();
+            void ClearColorAndDepthBuffers();
+            void ClearStencil(s32 value);
+            void ClearStencilBuffer();
+
+            void DrawArrays(PrimitiveType mode, s32 first, u32 count);
+            void DrawElements(PrimitiveType mode, u32 num_indices, DataType index_type);
+            void DrawArraysInstanced(PrimitiveType mode, s32 first, u32 count, u32 num_instances);
+            void DrawElementsInstanced(PrimitiveType mode, u32 num_indices, DataType index_type, u32 num_instances);
+            void DrawElementsBaseVertex(PrimitiveType mode, u32 num_indices, DataType index_type,
+                u32 first_index, s32 base_vertex);
+            void MultiDrawElementsBaseVertex(PrimitiveType mode, const u32 * num_indices, DataType index_type,
+                const u32 * first_indices, const s32 * base_vertices, u32 draw_count);
+
+            void GenVertexArrayObject(u32 &obj);
+
+            void GenVertexBuffer(u32& obj);
+            void VertexBufferData(u32 size, const void *data, BufferUsage usage);
+            void VertexBufferSubData(u32 offset, u32 size, const void *data);
+            void* MapVertexBufferData(DataAccessType access);
+            void UnmapVertexBufferData();
+            void* MapVertexBufferRange(u32 offset, u32 size);
+            void* MapVertexBufferPersistent(u32 size);
+
+            void GenIndexBuffer(u32& obj);
+            void IndexBufferData(u32 size, const void *data, BufferUsage usage);
+            void IndexBufferSubData(u32 offset, u32 size, const void *data);
+            void* MapIndexBufferData(DataAccessType access);
+            void UnmapIndexBufferData();
+
+            void VertexAttribPointer(u32 index, s32 size, DataType type, u32 stride, const void* ptr, bool normalized = false);
+            void EnableVertexAttribArray(u32 index);
+            void VertexAttribDivisor(u32 index, u32 divisor);
+
+            SyncObject FenceSync();
+            bool ClientWaitSync(SyncObject sync, u64 timeout_ns);
+            void DeleteSync(SyncObject sync);
+
+            void TextureImage2D(u32 target, s32 level, s32 internal_format, s32 w, s32 h,
+                u32 format, u32 type, const void *data);
+            void TextureSubImage2D(u32 target, s32 level, s32 x, s32 y, s32 w, s32 h,
+                u32 format, u32 type, const void *data);
+            void GetTextureImage(u32 target, s32 level, u32 format, u32 type, void *data);
+            void GenerateMipmap(u32 target);
+
+            void BindAttribLocation(u32 program, const char *name);
+            void Uniform1i(u32 program, const char *name, int x);
+            void Uniform2i(u32 program, const char *name, int x, int y);
+            void Uniform3i(u32 program, const char *name, int x, int y, int z);
+            void Uniform4i(u32 program, const char *name, int x, int y, int z, int w);
+            void Uniform1f(u32 program, const char *name, float x);
+            void Uniform2f(u32 program, const char *name, float x, float y);
+            void Uniform3f(u32 program, const char *name, float x, float y, float z);
+            void Uniform4f(u32 program, const char *name, float x, float y, float z, float w);
+            void Uniform1fv(u32 program, const char *name, const float *v, int n = 1);
+            void Uniform2fv(u32 program, const char *name, const float *v, int n = 1);
+            void Uniform3fv(u32 program, const char *name, const float *v, int n = 1);
+            void Uniform4fv(u32 program, const char *name, const float *v, int n = 1);
+            void UniformMatrix2fv(u32 program, const char *name, const float *v, bool trans = false, int n = 1);
+            void UniformMatrix3fv(u32 program, const char *name, const float *v, bool trans = false, int n = 1);
+            void UniformMatrix4fv(u32 program, const char *name, const float *v, bool trans = false, int n = 1);
+
+            void SetUniform1i(s32 location, int x);
+            void SetUniform2i(s32 location, int x, int y);
+            void SetUniform3i(s32 location, int x, int y, int z);
+            void SetUniform4i(s32 location, int x, int y, int z, int w);
+            void SetUniform1f(s32 location, float x);
+            void SetUniform2f(s32 location, float x, float y);
+            void SetUniform3f(s32 location, float x, float y, float z);
+            void SetUniform4f(s32 location, float x, float y, float z, float w);
+            void SetUniform1fv(s32 location, const float *v, int n = 1);
+            void SetUniform2fv(s32 location, const float *v, int n = 1);
+            void SetUniform3fv(s32 location, const float *v, int n = 1);
+            void SetUniform4fv(s32 location, const float *v, int n = 1);
+            void SetUniformMatrix2fv(s32 location, const float *v, bool trans = false, int n = 1);
+            void SetUniformMatrix3fv(s32 location, const float *v, bool trans = false, int n = 1);
+            void SetUniformMatrix4fv(s32 location, const float *v, bool trans = false, int n = 1);
+
+            void GenUniformBuffer(u32& obj);
+            void DeleteUniformBuffer(u32& obj);
+            void BindUniformBuffer(u32 obj);
+            void UniformBufferData(u32 size, const void *data, BufferUsage usage);
+            void UniformBufferSubData(u32 offset, u32 size, const void *data);
+            void BindUniformBufferBase(u32 binding, u32 obj);
+            void UniformBlockBinding(u32 program, u32 block_index, u32 binding);
+            
+            // Pixel pack buffer object
+            void GenPixelBuffer(u32& obj);
+            void DeletePixelBuffer(u32& obj);
+            void BindPixelPackBuffer(u32 obj);
+            void PixelPackBufferData(u32 size);
+            void ReadPixels(s32 x, s32 y, s32 w, s32 h, u32 format, u32 type, void *data);
+            const void* MapPixelPackBuffer(u32 size);
+            void UnmapPixelPackBuffer();
+
+        protected:
+            void ApiClearColor(f32 r, f32 g, f32 b, f32 a);
+            void ApiViewport(int w, int h);
+            void ApiEnableBlend();
+            void ApiDisableBlend();
+            void ApiEnableDepthTest();
+            void ApiDisableDepthTest();
+            void ApiEnableDepthWrite();
+            void ApiDisableDepthWrite();
+            void ApiEnableStencilTest();
+            void ApiDisableStencilTest();
+            void ApiStencilMask(u32 mask);
+            void ApiEnableWireframeMode();
+            void ApiDisableWireframeMode();
+            void ApiCullFace(CullFaceType mode);
+            void ApiDeleteVertexArrayObject(u32 &obj);
+            void ApiBindVertexArrayObject(u32 obj);
+            void ApiDeleteVertexBuffer(u32& obj);
+            void ApiBindVertexBuffer(u32 obj);
+            void ApiDeleteIndexBuffer(u32& obj);
+            void ApiBindIndexBuffer(u32 obj);
+            void ApiDeleteProgram(u32 program);
+            void ApiBindProgram(u32 program);
+            void ApiActiveTexture(u32 unit);
+            void ApiBindTexture(u32 target, u32 obj);
+            void ApiDeleteTexture(u32& obj);
+
+        private:
+            //! Adds command and returns it, payload is stored if data isn't null.
+            //! In statistics mode returned command is a scratch one.
+            Command * Record(CommandType type, const void *data = nullptr, u32 size = 0);
+            Command * Record(CommandType type, u32 a0, u32 a1 = 0, u32 a2 = 0, u32 a3 = 0);
+            void RecordUpload(CommandType type, u32 a0, u32 a1, u32 a2, const void *data, u32 size);
+            void RecordUniform(u32 program, const char *name, UniformFunction function, const void *values,
+                u32 size, u32 count, bool transpose);
+            void RecordSetUniform(s32 location, UniformFunction function, const void *values,
+                u32 size, u32 count, bool transpose);
+            void RecordDraw(CommandType type, u32 a0, u32 a1, u32 a2, u32 a3, u32 a4, u32 vertices);
+            void RecordUnmap(CommandType type);
+
+            Mode mode_;
+            std::vector<Command> commands_;
+            std::vector<u8> data_;              //!< payloads of all commands
+            std::vector<FrameStats> frames_;    //!< finished frames
+            FrameStats current_frame_;
+            Command scratch_;                   //!< target of commands in statistics mode
+            u32 map_offset_;                    //!< range of active mapping
+            u32 map_size_;
+            u32 pixel_pack_buffer_;             //!< bound pixel pack buffer
+        };
+
+    }
+}
+
+#endif
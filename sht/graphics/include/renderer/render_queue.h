@@ -0,0 +1,159 @@
+#pragma once
+#ifndef __SHT_GRAPHICS_RENDER_QUEUE_H__
+#define __SHT_GRAPHICS_RENDER_QUEUE_H__
+
+#include "../../../common/types.h"
+#include "../../../math/bounding_box.h"
+#include "context.h"
+#include "shader.h"
+#include "texture.h"
+
+#include <mutex>
+#include <vector>
+
+namespace sht {
+    namespace graphics {
+
+        const u32 kMaxPacketTextures = 4;   //!< number of texture units used by draw packet
+        const u32 kNoBoundingBox = 0xFFFFFFFF;  //!< packet without bounding box is never culled
+
+        // Predeclarations
+        class OcclusionCuller;
+
+        //! Type of uniform value stored in command buffer
+        enum class UniformCommandType {
+            kInt,
+            kFloat,
+            kVec2,
+            kVec3,
+            kVec4,
+            kMat3,
+            kMat4
+        };
+
+        //! Uniform value applied before draw call
+        struct UniformCommand {
+            UniformHandle handle;
+            UniformCommandType type;
+            u32 count;          //!< number of array elements
+            u32 data_offset;    //!< offset in command buffer data
+        };
+
+        //! Draw call recorded into command buffer
+        struct DrawPacket {
+            u64 key;                                //!< sort key
+            Shader * shader;
+            Texture * textures[kMaxPacketTextures]; //!< null textures aren't bound
+            u32 vertex_array_object;
+            PrimitiveType mode;
+            bool indexed;                           //!< whether elements or arrays are drawn
+            DataType index_type;
+            s32 first;                              //!< first vertex for non-indexed draws
+            u32 count;                              //!< number of indices or vertices
+            u32 uniforms_begin;                     //!< first uniform command
+            u32 num_uniforms;
+            u32 bounding_box;                       //!< index of box in command buffer or kNoBoundingBox
+            bool visible;                           //!< cleared by occlusion culling
+        };
+
+        //! Buffer of draw packets recorded by a single thread
+        class CommandBuffer {
+            friend class RenderQueue;
+
+        public:
+            //! Adds indexed draw packet, following calls set its textures and uniforms
+            DrawPacket * AddDrawElements(u64 key, Shader * shader, u32 vertex_array_object,
+                PrimitiveType mode, u32 num_indices, DataType index_type);
+            //! Adds non-indexed draw packet, following calls set its textures and uniforms
+            DrawPacket * AddDrawArrays(u64 key, Shader * shader, u32 vertex_array_object,
+                PrimitiveType mode, s32 first, u32 count);
+
+            // Parameters of the last added packet
+            void SetTexture(u32 unit, Texture * texture);
+            void SetBoundingBox(const math::BoundingBox& box);     //!< world space bounds for occlusion culling
+            void Uniform1i(UniformHandle handle, int x);
+            void Uniform1f(UniformHandle handle, float x);
+            void Uniform2fv(UniformHandle handle, const float *v, int n = 1);
+            void Uniform3fv(UniformHandle handle, const float *v, int n = 1);
+            void Uniform4fv(UniformHandle handle, const float *v, int n = 1);
+            void UniformMatrix3fv(UniformHandle handle, const float *v, int n = 1);
+            void UniformMatrix4fv(UniformHandle handle, const float *v, int n = 1);
+
+            void Clear();
+
+            size_t num_packets() const;
+
+        private:
+            CommandBuffer();
+
+            DrawPacket * AddPacket(u64 key, Shader * shader, u32 vertex_array_object, PrimitiveType mode);
+            void AddUniform(UniformHandle handle, UniformCommandType type, const void *data, u32 size, int n);
+
+            std::vector<DrawPacket> packets_;
+            std::vector<UniformCommand> uniforms_;
+            std::vector<u32> data_;     //!< uniform values
+            std::vector<math::BoundingBox> boxes_;
+        };
+
+        //! Queue that sorts draw packets to minimize state changes and submits them through context.
+        //! Command buffers may be recorded on different threads, sorting and submission
+        //! should be done on render thread.
+        class RenderQueue {
+        public:
+            //! Statistics of the last submission
+            struct Stats {
+                u32 num_draws;
+                u32 num_shader_changes;
+                u32 num_texture_changes;
+                u32 num_culled;         //!< packets hidden by the last Cull
+            };
+
+            explicit RenderQueue(Context * context);
+            ~RenderQueue();
+
+            //! Returns empty command buffer, thread safe.
+            //! Buffer is valid until Reset and shouldn't be shared between threads.
+            CommandBuffer * AcquireCommandBuffer();
+
+            //! Tests bounding boxes of recorded packets against occluders rasterized by culler.
+            //! Hidden packets are skipped by Sort, so they are never submitted. Should be called before Sort.
+            void Cull(OcclusionCuller * culler);
+            void Sort();        //!< sorts visible packets of all acquired buffers by key
+            void Submit();      //!< executes sorted packets
+            void Reset();       //!< returns all buffers to pool
+
+            u32 num_packets() const;
+            const DrawPacket * sorted_packet(u32 index) const;
+            const Stats& stats() const;
+
+            //! Key for opaque geometry: pass, shader, material and depth front to back.
+            //! Only lower bits of parameters are used: 4 bits of pass, 12 bits of shader and 16 bits of material.
+            static u64 MakeOpaqueKey(u32 pass, u32 shader, u32 material, f32 depth);
+            //! Key for translucent geometry: pass, depth back to front, shader and material
+            static u64 MakeTranslucentKey(u32 pass, f32 depth, u32 shader, u32 material);
+
+        private:
+            struct SortEntry {
+                u64 key;
+                const DrawPacket * packet;
+                const CommandBuffer * buffer;   //!< buffer that owns packet
+            };
+
+            void ApplyUniforms(const CommandBuffer * buffer, const DrawPacket * packet);
+
+            Context * context_;
+            std::mutex mutex_;
+            std::vector<CommandBuffer*> buffers_;       //!< acquired buffers
+            std::vector<CommandBuffer*> free_buffers_;
+            std::vector<SortEntry> entries_;
+            std::vector<SortEntry> temp_entries_;       //!< radix sort buffer
+            std::vector<math::BoundingBox> cull_boxes_; //!< boxes of all packets tested by Cull
+            std::vector<DrawPacket*> cull_packets_;
+            std::vector<u8> cull_visibility_;
+            Stats stats_;
+        };
+
+    } // namespace graphics
+} // namespace sht
+
+#endif
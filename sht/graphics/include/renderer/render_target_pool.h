@@ -0,0 +1,79 @@
+#pragma once
+#ifndef __SHT_GRAPHICS_RENDERER_RENDER_TARGET_POOL_H__
+#define __SHT_GRAPHICS_RENDERER_RENDER_TARGET_POOL_H__
+
+#include "../../../common/types.h"
+#include "../image/image.h"
+#include "texture.h"
+
+#include <functional>
+#include <vector>
+
+namespace sht {
+	namespace graphics {
+
+		//! Description of render target, targets with equal descriptions are interchangeable
+		struct RenderTargetDesc {
+			int width;
+			int height;
+			Image::Format format;
+			u32 samples;
+
+			RenderTargetDesc();
+			RenderTargetDesc(int w, int h, Image::Format fmt, u32 samples = 1);
+			bool operator ==(const RenderTargetDesc& other) const;
+			bool operator !=(const RenderTargetDesc& other) const;
+		};
+
+		//! Pool of transient render targets.
+		//! Released targets are handed out again for equal descriptions,
+		//! targets that haven't been used for a few frames are destroyed.
+		class RenderTargetPool {
+		public:
+			typedef std::function<Texture*(const RenderTargetDesc& desc)> CreateFunction;
+			typedef std::function<void(Texture*)> DeleteFunction;
+
+			struct Stats {
+				u32 created;		//!< number of created targets
+				u32 reused;			//!< number of acquisitions served by existing targets
+				u32 destroyed;		//!< number of targets destroyed
+			};
+
+			RenderTargetPool(const CreateFunction& create_function, const DeleteFunction& delete_function);
+			~RenderTargetPool();	//!< doesn't destroy targets, Clear should be called while their owner exists
+
+			Texture * Acquire(const RenderTargetDesc& desc);	//!< returns nullptr if target can't be created
+			void Release(Texture * texture);					//!< returns target to the pool
+
+			//! Destroys free targets that haven't been used for max unused frames.
+			//! Should be called once per frame.
+			void EndFrame();
+
+			void Clear();								//!< destroys all targets, they shouldn't be in use
+
+			void set_max_unused_frames(u32 frames);
+			u32 num_targets() const;
+			u32 num_free_targets() const;
+			u32 used_bytes() const;						//!< memory of all pooled targets
+			const Stats& stats() const;
+
+		private:
+			struct Entry {
+				RenderTargetDesc desc;
+				Texture * texture;
+				u32 last_used_frame;
+				bool in_use;
+			};
+
+			CreateFunction create_function_;
+			DeleteFunction delete_function_;
+			std::vector<Entry> entries_;
+			Stats stats_;
+			u32 frame_;
+			u32 max_unused_frames_;
+		};
+
+	} // namespace graphics
+} // namespace sht
+
+#endif
@@ -13,8 +13,14 @@
 #include "texture.h"
 #include "context.h"
 #include "shader.h"
+#include "shader_manager.h"
 #include "font.h"
 #include "cubemap_fill_type.h"
+#include "texture_upload_queue.h"
+#include "ring_buffer.h"
+#include "residency_manager.h"
+#include "screenshot_queue.h"
+#include "render_target_pool.h"
 
 #include <list>
 #include <stack>
@@ -24,6 +30,7 @@ namespace sht {
 
 		const int kMaxImageUnit = 16;
 		const int kMaxMrt = 4;
+		const u32 kRingBufferSize = 4 << 20;
 
 		//! Base renderer class
 		class Renderer {
@@ -47,17 +54,36 @@ namespace sht {
 			u32 GetUsedTexturesSize(void);
 			u32 GetUsedVertexBuffersSize(void);
 			u32 GetUsedIndexBuffersSize(void);
+			ResidencyManager * residency_manager();			//!< texture memory budget
 
+			//! Queues capture of the current frame, image is saved on worker thread a few frames later
 			bool TakeScreenshot(const char* directory_name);
+			ScreenshotQueue * screenshot_queue();			//!< also records frame sequences
 			void Setup2DMatrix();
 
 			// Texture functions
 			bool AddTexture(Texture* &texture, const char* filename,
 				Texture::Wrap wrap = Texture::Wrap::kRepeat,
 				Texture::Filter filt = Texture::Filter::kTrilinear);
+			//! Texture may lose top mip levels under memory pressure, it's reloaded from file when used again
+			bool AddEvictableTexture(Texture* &texture, const char* filename,
+				Texture::Wrap wrap = Texture::Wrap::kRepeat,
+				Texture::Filter filt = Texture::Filter::kTrilinear);
 			void AddTextureFromImage(Texture* &texture, const Image& image,
 				Texture::Wrap wrap = Texture::Wrap::kRepeat,
 				Texture::Filter filt = Texture::Filter::kTrilinear);
+			//! Decodes image on worker thread, texture is uploaded during ProcessTextureUploads calls
+			void AddTextureAsync(const char* filename, const TextureUploadQueue::ReadyCallback& callback,
+				Texture::Wrap wrap = Texture::Wrap::kRepeat,
+				Texture::Filter filt = Texture::Filter::kTrilinear,
+				const Image::DecodeOptions& options = Image::DecodeOptions());
+			void ProcessTextureUploads(f32 budget_seconds); //!< should be called once per frame
+			TextureUploadQueue * texture_upload_queue();
+			RenderTargetPool * render_target_pool();		//!< transient render targets, depth formats give depth textures
+
+			//! Shared buffer for vertex data that changes every frame
+			RingBuffer * ring_buffer();
+			void EndFrame();								//!< should be called after all draw calls of the frame
 			bool AddTextureCubemap(Texture* &texture, const char* filename, CubemapFillType fill_type, int desired_width);
 			bool AddTextureCubemap(Texture* &texture, const char* filenames[6], bool use_mipmaps = false);
 			bool CreateTextureNormalMapFromHeightMap(Texture* &texture, const char* filename,
@@ -96,6 +122,11 @@ namespace sht {
 
 			// Shader functions
 			virtual bool AddShader(Shader* &shd, const char* filename, const char **attribs = NULL, u32 n_attribs = 0) = 0;
+			//! Shader is created during CompileShaders, all deferred shaders are compiled together.
+			//! Renderers without shader manager create it immediately.
+			virtual void AddShaderDeferred(Shader* &shd, const char* filename, const char **attribs = NULL, u32 n_attribs = 0);
+			virtual bool CompileShaders();					//!< returns false if any deferred shader has failed
+			ShaderManager * shader_manager();
 			virtual void DeleteShader(Shader* shd) = 0;
 
 			// Font functions
@@ -152,10 +183,16 @@ namespace sht {
 
 		protected:
 			virtual void ApiAddTexture(Texture* &tex, const Image &img, Texture::Wrap wrap, Texture::Filter filt) = 0;
+			virtual void ApiAddTextureStorage(Texture* &tex, int w, int h, Image::Format fmt, Texture::Wrap wrap, Texture::Filter filt) = 0;
 			virtual void ApiAddTextureCubemap(Texture* &tex, Image *imgs, bool use_mipmaps = false) = 0;
 			virtual void ApiDeleteTexture(Texture* tex) = 0;
             virtual void ApiViewport(int width, int height) = 0;
             
+            void ReleaseRingBuffer();						//!< should be called while context exists
+			void ReleaseScreenshotQueue();					//!< should be called while context exists
+			void ReleaseRenderTargetPool();					//!< should be called while context exists
+			void RegisterTexture(Texture * texture);		//!< adds created texture to the list and memory accounting
+            
             Context * context_;
 
 			int width_;										//!< owner app's window width
@@ -169,6 +206,15 @@ namespace sht {
             sht::math::Matrix4 model_matrix_;               //!< model matrix
             std::stack<sht::math::Matrix4> matrices_stack_; //!< matrices stack
 
+			TextureUploadQueue * texture_upload_queue_;	//!< created on first use
+			RingBuffer * ring_buffer_;						//!< created on first use
+			ScreenshotQueue * screenshot_queue_;			//!< created on first use
+			RenderTargetPool * render_target_pool_;		//!< created on first use
+			ResidencyManager * residency_manager_;			//!< created with context
+			ShaderManager * shader_manager_;				//!< created with context
+			u32 vertex_buffers_size_;						//!< total size of vertex buffers
+			u32 index_buffers_size_;						//!< total size of index buffers
+
 			std::list<Texture*> textures_;
 			std::list<Shader*> shaders_;
 			std::list<Font*> fonts_;
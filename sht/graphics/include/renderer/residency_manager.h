@@ -0,0 +1,104 @@
+#pragma once
+#ifndef __SHT_GRAPHICS_RENDERER_RESIDENCY_MANAGER_H__
+#define __SHT_GRAPHICS_RENDERER_RESIDENCY_MANAGER_H__
+
+#include "../../../common/types.h"
+#include "../image/image.h"
+#include "texture.h"
+
+#include <functional>
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+namespace sht {
+	namespace graphics {
+
+		// Forward declarations
+		class Context;
+
+		//! Keeps texture memory within budget.
+		//! Memory of all registered textures is accounted, evictable 2D textures that haven't been used
+		//! recently lose their top mip levels in least recently used order until they reach 1x1 size.
+		//! Demoted textures are restored to full size from their source when used again and budget allows.
+		class ResidencyManager {
+		public:
+			typedef std::function<bool(Image * image)> LoadFunction;	//!< loads full size source image of texture
+
+			//! Instrumentation counters, per frame ones are reset on each EndFrame
+			struct Counters {
+				u32 demotions;				//!< mip levels dropped during the last frame
+				u32 evictions;				//!< textures that have reached minimal size during the last frame
+				u32 restores;				//!< textures restored to full size during the last frame
+				u32 failed_restores;		//!< restores that didn't fit budget or failed to load during the last frame
+				u64 freed_bytes;			//!< memory freed by demotions during the last frame
+				u64 loaded_bytes;			//!< memory allocated by restores during the last frame
+				u32 over_budget_frames;		//!< number of frames that have ended over budget since creation
+			};
+
+			explicit ResidencyManager(Context * context);
+			~ResidencyManager();
+
+			void Add(Texture * texture);		//!< starts accounting of texture memory
+			void Remove(Texture * texture);
+			void Clear();
+
+			//! Allows demotion of 2D texture with full mip chain, its data is reloaded by function on restore
+			void SetEvictable(Texture * texture, const LoadFunction& load);
+
+			//! Marks texture as used in the current frame, demoted textures get restore request
+			void Touch(Texture * texture);
+
+			//! Restores requested textures and demotes least recently used ones until budget is met
+			void EndFrame();
+
+			void set_budget(u64 bytes);						//!< zero budget means no limit
+			void set_max_restores_per_frame(u32 count);	//!< restores reload data, so they're limited
+
+			u64 budget() const;
+			u64 used_bytes() const;
+			u32 num_textures() const;
+			u32 num_evictable() const;
+			u32 num_demoted() const;
+			u32 frame() const;
+			int mip_bias(Texture * texture) const;			//!< number of dropped mip levels
+			const Counters& counters() const;
+
+		private:
+			ResidencyManager(const ResidencyManager&) = delete;
+			void operator = (const ResidencyManager&) = delete;
+
+			struct Entry {
+				LoadFunction load;
+				std::list<Texture*>::iterator lru_position;	//!< valid for evictable textures only
+				u32 last_used_frame;
+				int full_width;
+				int full_height;
+				int mip_bias;
+				bool evictable;
+				bool restore_requested;
+			};
+
+			bool Demote(Texture * texture, Entry& entry);
+			bool Restore(Texture * texture, Entry& entry);
+			void MakeRoom(u64 extra_bytes);				//!< demotes textures not used this frame
+			bool OverBudget(u64 extra_bytes) const;
+			void ResetFrameCounters();
+
+			Context * context_;
+			std::unordered_map<Texture*, Entry> entries_;
+			std::list<Texture*> lru_;					//!< evictable textures, least recently used first
+			std::vector<Texture*> restore_requests_;
+			std::vector<u8> staging_;					//!< lower mip read back during demotion
+			Counters counters_;
+			u64 budget_;
+			u64 used_bytes_;
+			u32 max_restores_per_frame_;
+			u32 num_demoted_;
+			u32 frame_;
+		};
+
+	} // namespace graphics
+} // namespace sht
+
+#endif
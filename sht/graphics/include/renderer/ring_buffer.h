@@ -0,0 +1,78 @@
+#pragma once
+#ifndef __SHT_GRAPHICS_RING_BUFFER_H__
+#define __SHT_GRAPHICS_RING_BUFFER_H__
+
+#include "../../../common/types.h"
+#include "context.h"
+
+#include <deque>
+
+namespace sht {
+    namespace graphics {
+        
+        //! Region of ring buffer
+        struct RingAllocation {
+            void * pointer;     //!< memory for data, nullptr if allocation has failed
+            u32 offset;         //!< offset of region in buffer
+        };
+        
+        //! Vertex buffer suballocated for transient data that lives during one frame.
+        //! Regions of finished frames are protected by fences, so writing new data never waits
+        //! for GPU unless the whole buffer is in flight. Storage is mapped persistently if supported,
+        //! otherwise every region is mapped separately. Without fences buffer is orphaned
+        //! each time it wraps around, so data should be drawn before the next Map call.
+        class RingBuffer {
+        public:
+            //! Counters since creation
+            struct Stats {
+                u32 num_allocations;
+                u32 num_waits;      //!< times CPU has waited for GPU
+                u32 num_orphans;    //!< times storage has been orphaned
+            };
+            
+            RingBuffer(Context * context, u32 size);
+            virtual ~RingBuffer();
+            
+            //! Allocates and maps region, it stays valid till the end of current frame.
+            //! Alignment should be a divisor of buffer size.
+            RingAllocation Map(u32 size, u32 alignment = 16);
+            void Unmap();       //!< should be called before drawing
+            void EndFrame();    //!< places fence for regions of the finished frame
+            
+            void Bind();        //!< binds buffer as vertex buffer
+            
+            u32 size() const;
+            u32 frame() const;  //!< number of finished frames
+            bool persistent() const;
+            const Stats& stats() const;
+            
+        protected:
+            RingBuffer(const RingBuffer&) = delete;
+            void operator = (const RingBuffer&) = delete;
+            
+            //! Positions grow monotonically, offset in buffer is position modulo size
+            struct Frame {
+                SyncObject fence;
+                u64 begin;
+                u64 end;
+            };
+            
+            void RetireFrame();
+            
+            Context * context_;
+            u32 id_;
+            u32 size_;
+            u8 * persistent_data_;      //!< null if storage isn't mapped persistently
+            bool use_fences_;
+            bool mapped_;
+            u64 head_;                  //!< position of the next allocation
+            u64 frame_begin_;           //!< position of the first allocation of current frame
+            u32 frame_;
+            std::deque<Frame> frames_;  //!< finished frames that GPU may still use
+            Stats stats_;
+        };
+        
+    } // namespace graphics
+} // namespace sht
+
+#endif
@@ -0,0 +1,96 @@
+#pragma once
+#ifndef __SHT_GRAPHICS_RENDERER_SCREENSHOT_QUEUE_H__
+#define __SHT_GRAPHICS_RENDERER_SCREENSHOT_QUEUE_H__
+
+#include "../../../common/types.h"
+#include "../image/image.h"
+#include "context.h"
+
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace sht {
+	namespace graphics {
+
+		//! Asynchronous framebuffer capture.
+		//! Pixels are read into pixel pack buffers and mapped a few frames later, when GPU has finished them,
+		//! so capture doesn't flush the pipeline. Images are encoded and saved on service pool threads.
+		class ScreenshotQueue {
+		public:
+			struct Stats {
+				u32 captured;		//!< readbacks issued
+				u32 encoded;		//!< images saved
+				u32 failed;			//!< images failed to save
+				u32 stalls;			//!< readbacks that had to wait for GPU
+			};
+
+			//! More buffers allow longer delay before mapping
+			explicit ScreenshotQueue(Context * context, u32 num_buffers = 3);
+			~ScreenshotQueue();		//!< waits for pending images, context should exist
+
+			//! Issues readback of the lower left w x h framebuffer region.
+			//! Image is saved to file later, file format is chosen by extension.
+			void Capture(int w, int h, const char * filename);
+
+			//! Captures every frame into directory/prefix_000000.extension files until StopSequence
+			void StartSequence(const char * directory, const char * prefix, const char * extension = "png");
+			void StopSequence();
+			bool sequence_active() const;
+
+			//! Should be called once per frame after rendering.
+			//! Captures sequence frame and hands finished readbacks over to encoding.
+			void EndFrame(int w, int h);
+
+			void Flush();			//!< finishes all readbacks and waits until images are saved
+
+			//! Readbacks wait for encoding when this number of images is in flight, so memory stays bounded
+			void set_max_pending_encodes(u32 count);
+			u32 num_pending_readbacks() const;
+			u32 num_pending_encodes();
+			Stats stats();			//!< thread safe copy
+
+		private:
+			ScreenshotQueue(const ScreenshotQueue&) = delete;
+			void operator = (const ScreenshotQueue&) = delete;
+
+			class EncodeTask;
+
+			struct Slot {
+				u32 buffer;			//!< pixel pack buffer
+				u32 size;			//!< allocated size of buffer
+				SyncObject fence;
+				int width;
+				int height;
+				std::string filename;
+				u32 frame;			//!< frame of readback
+				bool busy;
+			};
+
+			Slot * AcquireSlot();				//!< finishes the oldest readback if all slots are busy
+			bool FinishSlot(Slot * slot, bool wait); //!< returns false if slot isn't ready and wait is false
+			Image * AcquireImage();				//!< blocks while too many images are being encoded
+			void OnEncoded(Image * image, bool success); //!< called on worker thread
+
+			Context * context_;
+			std::vector<Slot> slots_;
+			u32 frame_;
+			u32 delay_;							//!< frames after which readback is finished anyway
+			std::mutex mutex_;
+			std::condition_variable condition_;
+			std::vector<Image*> images_;		//!< all staging images
+			std::vector<Image*> free_images_;
+			u32 pending_encodes_;
+			u32 max_pending_encodes_;
+			Stats stats_;
+			std::string sequence_prefix_;		//!< directory and file prefix
+			std::string sequence_extension_;
+			u32 sequence_index_;
+			bool sequence_active_;
+		};
+
+	} // namespace graphics
+} // namespace sht
+
+#endif
@@ -6,13 +6,25 @@
 #include "../resource.h"
 #include "context.h"
 
+#include <vector>
+
 namespace sht {
     namespace graphics {
         
+        //! Uniform location resolved at shader link time
+        struct UniformHandle {
+            UniformHandle() : index(-1) {}
+            bool valid() const { return index >= 0; }
+            
+            s32 index;  //!< index in shader uniforms table
+        };
+        
         //! Shader class
         class Shader : public Resource {
             friend class Renderer;
             friend class OpenGlRenderer;
+            friend class NullRenderer;
+            friend class ShaderManager;
             
         public:
             void Bind();
@@ -34,18 +46,55 @@ namespace sht {
             void UniformMatrix3fv(const char *name, const float *v, bool trans = false, int n = 1);
             void UniformMatrix4fv(const char *name, const float *v, bool trans = false, int n = 1);
             
+            //! Returns handle of active uniform, it's invalid if uniform hasn't been found
+            UniformHandle GetUniformHandle(const char *name) const;
+            
+            // Values set by handle are compared to the last sent ones and skipped if unchanged
+            void Uniform1i(UniformHandle handle, int x);
+            void Uniform2i(UniformHandle handle, int x, int y);
+            void Uniform3i(UniformHandle handle, int x, int y, int z);
+            void Uniform4i(UniformHandle handle, int x, int y, int z, int w);
+            void Uniform1f(UniformHandle handle, float x);
+            void Uniform2f(UniformHandle handle, float x, float y);
+            void Uniform3f(UniformHandle handle, float x, float y, float z);
+            void Uniform4f(UniformHandle handle, float x, float y, float z, float w);
+            void Uniform1fv(UniformHandle handle, const float *v, int n = 1);
+            void Uniform2fv(UniformHandle handle, const float *v, int n = 1);
+            void Uniform3fv(UniformHandle handle, const float *v, int n = 1);
+            void Uniform4fv(UniformHandle handle, const float *v, int n = 1);
+            void UniformMatrix2fv(UniformHandle handle, const float *v, bool trans = false, int n = 1);
+            void UniformMatrix3fv(UniformHandle handle, const float *v, bool trans = false, int n = 1);
+            void UniformMatrix4fv(UniformHandle handle, const float *v, bool trans = false, int n = 1);
+            
+            //! Assigns uniform block to uniform buffer binding point
+            bool BindUniformBlock(const char *name, u32 binding);
+            
         protected:
             Shader(Context * context);
             ~Shader();
             Shader(const Shader&) = delete;
             void operator = (const Shader&) = delete;
             
+            void ReflectUniforms();     //!< fills uniforms table, should be called after program linkage
+            
             Context * context_;
+            u32 program_;
             
         private:
-            static Shader * Create(Context * context, const char *filename, const char **attribs, u32 n_attribs);
+            //! Remembers value and returns true if it differs from the last sent one
+            bool NeedsUpdate(UniformHandle handle, const void *data, u32 size);
+            bool ForgetValue(UniformHandle handle);   //!< returns false if handle is invalid
             
-            u32 program_;
+            struct Uniform {
+                u32 hash;           //!< hash of uniform name
+                s32 location;       //!< uniform location
+                u32 size;           //!< size of all elements in bytes, zero if values aren't cached
+                u32 offset;         //!< offset of the last sent value in values buffer
+                u32 valid_size;     //!< number of bytes of the last sent value
+            };
+            
+            std::vector<Uniform> uniforms_; //!< active uniforms sorted by hash
+            std::vector<u8> values_;        //!< last sent values of uniforms
         };
         
     } // namespace graphics
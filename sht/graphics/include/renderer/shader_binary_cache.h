@@ -0,0 +1,34 @@
+#pragma once
+#ifndef __SHT_GRAPHICS_SHADER_BINARY_CACHE_H__
+#define __SHT_GRAPHICS_SHADER_BINARY_CACHE_H__
+
+#include "../../../common/types.h"
+
+#include <string>
+#include <vector>
+
+namespace sht {
+    namespace graphics {
+
+        //! On-disk storage of linked program binaries, one file per key.
+        //! Keys come from ShaderPreprocessor::ComputeKey, so changed sources never hit stale binaries.
+        class ShaderBinaryCache {
+        public:
+            explicit ShaderBinaryCache(const char *directory);
+
+            //! Returns false if there is no valid binary for key
+            bool Load(u64 key, u32 * format, std::vector<u8> * binary) const;
+            bool Store(u64 key, u32 format, const std::vector<u8>& binary) const;
+            void Remove(u64 key) const;     //!< should be called for binaries rejected by driver
+
+            std::string GetFilename(u64 key) const;
+            const std::string& directory() const;
+
+        private:
+            std::string directory_;
+        };
+
+    } // namespace graphics
+} // namespace sht
+
+#endif
@@ -0,0 +1,94 @@
+#pragma once
+#ifndef __SHT_GRAPHICS_SHADER_MANAGER_H__
+#define __SHT_GRAPHICS_SHADER_MANAGER_H__
+
+#include "../../../common/types.h"
+#include "shader.h"
+#include "shader_preprocessor.h"
+#include "shader_binary_cache.h"
+
+#include <string>
+#include <vector>
+
+namespace sht {
+    namespace graphics {
+
+        //! Builds shader programs in batches.
+        //! All compiles and links of a batch are issued before any status query, so driver may process them
+        //! in parallel (KHR_parallel_shader_compile) or at least without pipeline stalls between programs.
+        //! Linked program binaries are stored on disk and reused while sources and driver stay the same.
+        class ShaderManager {
+        public:
+            struct Stats {
+                u32 num_programs;       //!< programs built since creation
+                u32 num_cache_hits;     //!< programs created from stored binaries
+                u32 num_compiled;       //!< programs compiled from sources
+                u32 num_failed;
+            };
+
+            explicit ShaderManager(Context * context);
+            ~ShaderManager();
+
+            //! Enables binary cache in given directory, empty string disables it
+            void set_cache_directory(const char *directory);
+
+            //! Queues program built from filename.vs and filename.fs, shader pointer is set by Finish.
+            //! Shader variable should stay alive until Finish, attribute names are copied.
+            void Add(Shader* &shader, const char *filename, const char **attribs = nullptr, u32 n_attribs = 0);
+
+            //! Issues driver work for all queued programs without waiting for results
+            void Compile();
+
+            //! Returns true if Finish won't block, without parallel compile support it's always true
+            bool IsReady();
+
+            //! Waits for queued programs, reports errors and creates shaders.
+            //! Created shaders are appended to the list. Returns false if any program has failed.
+            bool Finish(std::vector<Shader*> * shaders);
+
+            ShaderPreprocessor * preprocessor();
+            bool parallel_compile_supported();
+            u32 num_pending() const;
+            const Stats& stats() const;
+
+        private:
+            ShaderManager(const ShaderManager&) = delete;
+            void operator = (const ShaderManager&) = delete;
+
+            struct Job {
+                Shader ** shader;
+                std::string filename;
+                std::vector<std::string> attribs;
+                std::string vertex_source;
+                std::string fragment_source;
+                u64 key;
+                u32 vertex_shader;
+                u32 fragment_shader;
+                u32 program;
+                bool issued;
+                bool failed;
+                bool from_cache;
+            };
+
+            void QueryDriver();                 //!< reads capabilities on first use, context should be current
+            bool Prepare(Job& job);             //!< loads sources and tries cached binary
+            void IssueCompile(Job& job);
+            void IssueLink(Job& job);
+            bool CheckStatus(Job& job);         //!< reports errors, falls back to sources for rejected binaries
+            void DeleteObjects(Job& job);
+
+            Context * context_;
+            ShaderPreprocessor preprocessor_;
+            ShaderBinaryCache * cache_;
+            std::vector<Job> jobs_;
+            std::string driver_;                //!< identifies binaries produced by this driver
+            Stats stats_;
+            bool driver_queried_;
+            bool parallel_compile_;
+            bool binaries_supported_;
+        };
+
+    } // namespace graphics
+} // namespace sht
+
+#endif
@@ -0,0 +1,53 @@
+#pragma once
+#ifndef __SHT_GRAPHICS_SHADER_PREPROCESSOR_H__
+#define __SHT_GRAPHICS_SHADER_PREPROCESSOR_H__
+
+#include "../../../common/types.h"
+
+#include <functional>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace sht {
+    namespace graphics {
+
+        //! Inlines #include "file" directives of shader sources.
+        //! Loaded files are cached, so sources shared by many shaders are read once.
+        class ShaderPreprocessor {
+        public:
+            typedef std::function<bool(const char *filename, std::string * source)> LoadFunction;
+
+            ShaderPreprocessor();                                   //!< loads files from disk
+            explicit ShaderPreprocessor(const LoadFunction& load);
+
+            //! Builds source of file with all includes inlined. Include paths are relative to including file,
+            //! every file is inlined once per source, so circular includes are harmless.
+            bool Process(const char *filename, std::string * source);
+
+            void ClearCache();          //!< should be called when files have been changed
+
+            u32 num_cached_files() const;
+            u32 num_loads() const;      //!< number of load function calls
+            const std::string& error() const;   //!< description of the last failure
+
+            //! Key of program binary built from given sources.
+            //! Driver string should identify GPU and driver version, binaries aren't portable between them.
+            static u64 ComputeKey(const std::string& vertex_source, const std::string& fragment_source,
+                const std::vector<std::string>& attribs, const std::string& driver);
+
+        private:
+            bool ProcessFile(const std::string& filename, std::set<std::string> * included, std::string * output);
+            const std::string * Load(const std::string& filename);
+
+            LoadFunction load_;
+            std::unordered_map<std::string, std::string> cache_;    //!< file contents by name
+            std::string error_;
+            u32 num_loads_;
+        };
+
+    } // namespace graphics
+} // namespace sht
+
+#endif
@@ -25,7 +25,7 @@ namespace sht {
             bool SetTextInternal(Font * font, float x, float y, float scale);
             bool MakeRenderable();
             const size_t GetVerticesPerPrimitive() const;
-            virtual void AllocateVertexBuffer() = 0;
+            virtual bool AllocateVertexBuffer() = 0;
             virtual void AllocateBuffer() = 0;
             virtual void* LockBuffer() = 0;
             virtual void UnlockBuffer() = 0;
@@ -47,7 +47,6 @@ namespace sht {
             f32 reference_x_;   //!< text reference point x (in screen coordinates)
             f32 reference_y_;   //!< text reference point y (in screen coordinates)
             
-        private:
             void FreeArrays();
         };
         
@@ -65,13 +64,13 @@ namespace sht {
             
         private:
             StaticText(Renderer * renderer);
-            void AllocateVertexBuffer();
+            bool AllocateVertexBuffer() final;
             void AllocateBuffer() final;
             void* LockBuffer() final;
             void UnlockBuffer() final;
         };
         
-        //! Dynamic text class
+        //! Dynamic text class, its vertices are copied into renderer's ring buffer when rendered
         class DynamicText final : private Text {
         public:
             ~DynamicText();
@@ -82,16 +81,20 @@ namespace sht {
             bool SetText(Font * font, float x, float y, float scale, const wchar_t* str, ...);
             bool SetTextSimple(Font * font, float x, float y, float scale, const wchar_t* str);
             
-            using Text::Render;
+            void Render();
             using Text::GetTextBoundingBox;
             using Text::SetPosition;
             
         private:
             DynamicText(Renderer * renderer, u32 buffer_size);
-            void AllocateVertexBuffer();
+            bool AllocateVertexBuffer() final;
             void AllocateBuffer() final;
             void* LockBuffer() final;
             void UnlockBuffer() final;
+            
+            bool dirty_;            //!< vertices have changed since last upload
+            u32 upload_frame_;      //!< ring buffer frame of last upload
+            u32 first_vertex_;      //!< first vertex in ring buffer
         };
         
     } // namespace graphics
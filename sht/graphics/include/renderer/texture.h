@@ -14,6 +14,10 @@ namespace sht {
             friend class Font;
 			friend class Renderer;
 			friend class OpenGlRenderer;
+			friend class NullRenderer;
+			friend class TextureUploadQueue;
+			friend class RenderQueue;
+			friend class ResidencyManager;
 
 		public:
 
@@ -40,6 +44,7 @@ namespace sht {
 
 			int width() const;
 			int height() const;
+			Image::Format format() const;
 
 			u32 GetSize();			//!< size of image in memory (w*h*bpp)
 
@@ -0,0 +1,76 @@
+#pragma once
+#ifndef __SHT_GRAPHICS_RENDERER_TEXTURE_UPLOAD_QUEUE_H__
+#define __SHT_GRAPHICS_RENDERER_TEXTURE_UPLOAD_QUEUE_H__
+
+#include "../../../common/types.h"
+#include "../../../system/include/time/clock.h"
+#include "../image/image.h"
+#include "texture.h"
+
+#include <functional>
+#include <list>
+#include <mutex>
+#include <vector>
+
+namespace sht {
+	namespace graphics {
+
+		// Forward declarations
+		class Context;
+
+		//! Queue of decoded images waiting for upload into textures.
+		//! Images are added from any thread and uploaded on render thread in row slices
+		//! under per-frame time budget, so big textures don't cause frame hitches.
+		class TextureUploadQueue {
+		public:
+			typedef std::function<void(Texture*)> ReadyCallback;	//!< receives nullptr if loading has failed
+			typedef std::function<Texture*(int w, int h, Image::Format fmt,
+				Texture::Wrap wrap, Texture::Filter filt)> CreateFunction; //!< creates texture with storage only
+
+			TextureUploadQueue(Context * context, const CreateFunction& create_function);
+			~TextureUploadQueue();
+
+			Image * AcquireStagingImage();				//!< returns image with reusable memory, thread safe
+			void ReleaseStagingImage(Image * image);	//!< thread safe
+
+			//! Adds staging image to queue, it will be released after upload. Thread safe.
+			//! Null image reports failed load to callback.
+			void Enqueue(Image * image, Texture::Wrap wrap, Texture::Filter filt, const ReadyCallback& callback);
+
+			//! Uploads pending images until time budget is spent, at least one slice is uploaded per call.
+			//! Should be called on render thread once per frame.
+			void Process(f32 budget_seconds);
+
+			void Clear();								//!< drops all pending uploads
+
+			void set_slice_size(u32 bytes);			//!< maximum size of data uploaded at once
+			u32 num_pending();
+			u32 num_staging_images();					//!< number of allocated staging images
+
+		private:
+			struct Job {
+				Image * image;
+				Texture * texture;
+				Texture::Wrap wrap;
+				Texture::Filter filter;
+				ReadyCallback callback;
+				int next_row;
+			};
+
+			void UploadSlice(Job& job);
+
+			Context * context_;
+			CreateFunction create_function_;
+			system::Clock clock_;
+			std::mutex mutex_;
+			std::list<Job> incoming_jobs_;		//!< jobs added from other threads
+			std::list<Job> jobs_;				//!< jobs owned by render thread
+			std::vector<Image*> free_images_;
+			std::vector<Image*> images_;		//!< all staging images
+			u32 slice_size_;
+		};
+
+	} // namespace graphics
+} // namespace sht
+
+#endif
@@ -0,0 +1,66 @@
+#pragma once
+#ifndef __SHT_GRAPHICS_UNIFORM_BUFFER_H__
+#define __SHT_GRAPHICS_UNIFORM_BUFFER_H__
+
+#include "../../../common/types.h"
+#include "context.h"
+
+#include <vector>
+
+namespace sht {
+    namespace graphics {
+        
+        //! Uniform buffer object with CPU side copy of its contents.
+        //! Only the changed range is sent to driver when buffer is flushed.
+        class UniformBuffer {
+        public:
+            UniformBuffer(Context * context, u32 size);
+            virtual ~UniformBuffer();
+            
+            void SetData(u32 offset, u32 size, const void *data); //!< changes CPU copy only
+            void Flush();               //!< sends changed range to driver
+            void Bind(u32 binding);     //!< flushes and binds buffer to uniform buffer binding point
+            
+            u32 size() const;
+            const u8 * data() const;
+            
+        protected:
+            UniformBuffer(const UniformBuffer&) = delete;
+            void operator = (const UniformBuffer&) = delete;
+            
+            Context * context_;
+            std::vector<u8> shadow_;    //!< copy of buffer contents
+            u32 id_;
+            u32 dirty_begin_;           //!< begin of changed range
+            u32 dirty_end_;             //!< end of changed range
+        };
+        
+        //! Uniform buffer with layout defined by structure.
+        //! Structure should follow std140 rules (use vec4 aligned members).
+        template <class T>
+        class TypedUniformBuffer : public UniformBuffer {
+        public:
+            explicit TypedUniformBuffer(Context * context)
+            : UniformBuffer(context, sizeof(T))
+            {
+            }
+            void Set(const T& value)
+            {
+                SetData(0, sizeof(T), &value);
+            }
+            template <typename M>
+            void Set(M T::* member, const M& value)
+            {
+                const u8 * address = reinterpret_cast<const u8*>(&(this->value().*member));
+                SetData(static_cast<u32>(address - data()), sizeof(M), &value);
+            }
+            const T& value() const
+            {
+                return *reinterpret_cast<const T*>(data());
+            }
+        };
+        
+    } // namespace graphics
+} // namespace sht
+
+#endif
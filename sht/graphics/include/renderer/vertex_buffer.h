@@ -10,8 +10,7 @@ namespace sht {
         class VertexBuffer final : public VideoMemoryBuffer {
             friend class Renderer;
             friend class OpenGlRenderer;
-            
-            friend class DynamicText;
+            friend class NullRenderer;
             
         protected:
             VertexBuffer(Context * context);
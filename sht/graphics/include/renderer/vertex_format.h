@@ -23,21 +23,38 @@ namespace sht {
 				kTangent,
 				kBinormal
 			};
+
+			//! Storage of components in vertex buffer, shaders receive floats anyway
+			enum Format {
+				kFloat,
+				kHalf,			//!< 16-bit float
+				kSnorm16,		//!< [-1,1] in signed short
+				kUnorm16,		//!< [0,1] in unsigned short
+				kSnorm8,		//!< [-1,1] in signed byte
+				kUnorm8,		//!< [0,1] in unsigned byte
+				kSnorm10,		//!< three components in signed 10-10-10-2 integer, w is zero
+				kOctahedral16	//!< unit vector folded to two snorm16 components, should be decoded by shader
+			};
             
-            VertexAttribute(Type type, u32 size)
+            VertexAttribute(Type type, u32 size, u32 divisor = 0, Format format = kFloat)
             : type(type)
             , size(size)
+            , divisor(divisor)
+            , format(format)
             {
             }
 
 			Type type;			//!< Specifies the vertex type.
 			u32 size;			//!< Specifies the vertex format size.
+			u32 divisor;		//!< Number of instances per attribute value, zero for per vertex attributes.
+			Format format;		//!< Specifies storage of components.
 		};
 
 		//! Vertex format class
 		class VertexFormat {
 			friend class Renderer;
 			friend class OpenGlRenderer;
+			friend class NullRenderer;
             
             friend class Model;
             friend class Text;
@@ -45,7 +62,8 @@ namespace sht {
 		public:
 			struct Attrib {
 				int offset;
-				int size;
+				int size;						//!< number of stored components
+				VertexAttribute::Format format;
 			};
             
             bool operator == (const VertexFormat& vf);
@@ -0,0 +1,41 @@
+#pragma once
+#ifndef __SHT_GRAPHICS_VERTEX_PACKING_H__
+#define __SHT_GRAPHICS_VERTEX_PACKING_H__
+
+#include "../../../common/types.h"
+#include "context.h"
+#include "vertex_format.h"
+
+namespace sht {
+    namespace graphics {
+        
+        //! Number of components passed to vertex attrib pointer for given attribute size
+        u32 GetStoredComponents(VertexAttribute::Format format, u32 size);
+        //! Size of attribute in vertex in bytes, every attribute is 4 bytes aligned
+        u32 GetAttributeSize(VertexAttribute::Format format, u32 size);
+        DataType GetAttributeDataType(VertexAttribute::Format format);
+        bool IsAttributeNormalized(VertexAttribute::Format format);
+        
+        //! Writes size float values in given format, it takes GetAttributeSize bytes with padding zeroed.
+        //! Values out of format range are clamped.
+        //! Maximum absolute error of decoded values, up to float rounding:
+        //!  - kHalf: 2^-11 relative
+        //!  - kSnorm16: 1/65534, kUnorm16: 1/131070
+        //!  - kSnorm8: 1/254, kUnorm8: 1/510
+        //!  - kSnorm10: 1/1022
+        //!  - kOctahedral16: 6e-5 per component of unit vector, input is expected to be normalized
+        void PackAttribute(VertexAttribute::Format format, const f32 * values, u32 size, u8 * data);
+        //! Decodes values the same way GPU does
+        void UnpackAttribute(VertexAttribute::Format format, const u8 * data, u32 size, f32 * values);
+        
+        u16 FloatToHalf(f32 value);         //!< rounds to nearest even, overflow gives infinity
+        f32 HalfToFloat(u16 value);
+        
+        //! Folds unit vector to [-1,1] square
+        void EncodeOctahedral(const f32 * vector, f32 * x, f32 * y);
+        void DecodeOctahedral(f32 x, f32 y, f32 * vector);
+        
+    } // namespace graphics
+} // namespace sht
+
+#endif
@@ -1,4 +1,6 @@
 #include "../../include/image/image.h"
+#include "../../include/image/normal_map_builder.h"
+#include "image_decode.h"
 #include "../../../system/include/string/filename.h"
 #include <assert.h>
 #include <math.h>
@@ -91,6 +93,19 @@ namespace sht {
                     return 3;
             }
         }
+		static Image::DataType GetDataType(Image::Format fmt)
+		// Type of single channel value
+		{
+			switch (GetBpp(fmt) / (GetChannels(fmt) << 3))
+			{
+			case 1:
+				return Image::DataType::kUint8;
+			case 2:
+				return Image::DataType::kUint16;
+			default:
+				return Image::DataType::kFloat;
+			}
+		}
 		static Image::FileFormat ExtractFileFormat(const char* filename)
 		{
 			sht::system::Filename fn(filename);
@@ -109,9 +124,22 @@ namespace sht {
 				return Image::FileFormat::kHdr;
 			return Image::FileFormat::kUnknown;
 		}
+		Image::DecodeOptions::DecodeOptions()
+		: target_width(0)
+		, target_height(0)
+		, region_x(0)
+		, region_y(0)
+		, region_width(0)
+		, region_height(0)
+		, buffer(nullptr)
+		, buffer_size(0)
+		{
+		}
 		Image::Image()
         : pixels_(nullptr)
         , inverted_row_order_(true)
+		, owns_pixels_(true)
+		, capacity_(0)
 		{
 		}
 		Image::Image(const Image& other)
@@ -123,19 +151,51 @@ namespace sht {
 		, channels_(other.channels_)
 		, bpp_(other.bpp_)
 		, inverted_row_order_(other.inverted_row_order_)
+		, owns_pixels_(true)
+		, capacity_(0)
 		{
 			size_t size = static_cast<size_t>(width_ * height_ * bpp_);
-			pixels_ = new u8[size];
+			AllocatePixels(size);
 			memcpy(pixels_, other.pixels_, size);
 		}
 		Image::~Image()
 		{
-			if (pixels_) delete[] pixels_;
+			FreePixels();
+		}
+		u8* Image::AllocatePixels(size_t size)
+		{
+			// Reuse own buffer if it's big enough
+			if (pixels_ && owns_pixels_ && capacity_ >= size)
+				return pixels_;
+			FreePixels();
+			pixels_ = new u8[size];
+			capacity_ = size;
+			return pixels_;
+		}
+		void Image::SetPixels(u8 * pixels, size_t capacity, bool owns)
+		{
+			if (pixels != pixels_)
+				FreePixels();
+			pixels_ = pixels;
+			capacity_ = capacity;
+			owns_pixels_ = owns;
+		}
+		void Image::FreePixels()
+		{
+			if (pixels_ && owns_pixels_)
+				delete[] pixels_;
+			pixels_ = nullptr;
+			capacity_ = 0;
+			owns_pixels_ = true;
 		}
 		void Image::SetRowOrder(bool inverted)
 		{
 			inverted_row_order_ = inverted;
 		}
+		bool Image::inverted_row_order() const
+		{
+			return inverted_row_order_;
+		}
 		u8* Image::pixels()
 		{
 			return pixels_;
@@ -160,6 +220,14 @@ namespace sht {
 		{
 			return bpp_;
 		}
+		int Image::channels() const
+		{
+			return channels_;
+		}
+		Image::DataType Image::data_type() const
+		{
+			return data_type_;
+		}
 		void Image::SwapRedBlueChannels()
 		{
 			int unit_size = bpp_ / channels_;
@@ -180,19 +248,83 @@ namespace sht {
 			int bpp = GetBpp(fmt);
 			bpp_ = bpp >> 3; // bits to bytes
             channels_ = GetChannels(fmt);
-			if (pixels_) delete[] pixels_;
-			pixels_ = new u8[width_ * height_ * bpp_];
-			return pixels_;
+			data_type_ = GetDataType(fmt);
+			return AllocatePixels(static_cast<size_t>(width_ * height_ * bpp_));
 		}
         void Image::FillWithZeroes()
         {
             memset(pixels_, 0, width_ * height_ * bpp_);
         }
+		bool Image::SetupDecodeBuffer(int w, int h, const DecodeOptions& options)
+		{
+			width_ = w;
+			height_ = h;
+			size_t size = static_cast<size_t>(w * h * bpp_);
+			if (options.buffer != nullptr && options.buffer_size >= size)
+				SetPixels(options.buffer, options.buffer_size, false);
+			else
+				AllocatePixels(size);
+			return pixels_ != nullptr;
+		}
+		bool Image::ApplyDecodeOptions(const DecodeOptions& options)
+		{
+			if (!pixels_)
+				return false;
+			DecodeRegion region = ResolveDecodeRegion(options, width_, height_);
+			int factor = ChooseDecodeScale(options, region);
+			bool full_region = (region.width == width_ && region.height == height_);
+			if (full_region && factor == 1 && options.buffer == nullptr)
+				return true;
+
+			// Box filter works with bytes, so other types are rescaled after cropping
+			bool box_filter = (data_type_ == DataType::kUint8);
+			int sink_factor = box_filter ? factor : 1;
+			int dst_width = region.width / sink_factor;
+			int dst_height = region.height / sink_factor;
+
+			// Detach source pixels so the new buffer won't reuse them
+			u8 * src_pixels = pixels_;
+			bool owns_src_pixels = owns_pixels_;
+			int src_width = width_;
+			int src_height = height_;
+			pixels_ = nullptr;
+			capacity_ = 0;
+			owns_pixels_ = true;
+
+			if (!SetupDecodeBuffer(dst_width, dst_height, options))
+			{
+				if (owns_src_pixels)
+					delete[] src_pixels;
+				return false;
+			}
+			DecodeScratch scratch;
+			DecodeRowSink sink(region, sink_factor, bpp_, pixels_, dst_width, dst_height, inverted_row_order_, &scratch);
+			const size_t src_stride = static_cast<size_t>(src_width * bpp_);
+			for (int y = region.y; y <= sink.last_needed_row(); ++y)
+			{
+				int memory_row = (inverted_row_order_) ? (src_height - 1 - y) : y;
+				sink.PushRow(y, src_pixels + memory_row * src_stride);
+			}
+			if (owns_src_pixels)
+				delete[] src_pixels;
+
+			if (!box_filter && factor > 1)
+			{
+				Rescale(dst_width / factor, dst_height / factor);
+				// Rescale allocates its own memory, so move data into caller buffer
+				size_t size = static_cast<size_t>(width_ * height_ * bpp_);
+				if (options.buffer != nullptr && options.buffer_size >= size)
+				{
+					memcpy(options.buffer, pixels_, size);
+					SetPixels(options.buffer, options.buffer_size, false);
+				}
+			}
+			return true;
+		}
 		void Image::Copy(const Image& other)
 		{
-			if (pixels_) delete[] pixels_;
-			size_t size = static_cast<size_t>(width_ * height_ * bpp_);
-			pixels_ = new u8[size];
+			size_t size = static_cast<size_t>(other.width_ * other.height_ * other.bpp_);
+			AllocatePixels(size);
 			memcpy(pixels_, other.pixels_, size);
 			format_ = other.format_;
 			data_type_ = other.data_type_;
@@ -249,223 +381,89 @@ namespace sht {
 				return false;
 			}
 		}
-		bool Image::LoadFromFile(const char* filename)
+		bool Image::LoadFromFile(const char* filename, const DecodeOptions& options)
 		{
 			FileFormat fmt = ExtractFileFormat(filename);
 			switch (fmt)
 			{
 			case Image::FileFormat::kBmp:
-				return LoadBmp(filename);
+				return LoadBmp(filename) && ApplyDecodeOptions(options);
 			case Image::FileFormat::kJpg:
-				return LoadJpeg(filename);
+				return LoadJpeg(filename, options);
 			case Image::FileFormat::kPng:
-				return LoadPng(filename);
+				return LoadPng(filename, options);
 			case Image::FileFormat::kTga:
-				return LoadTga(filename);
+				return LoadTga(filename) && ApplyDecodeOptions(options);
 			case Image::FileFormat::kTif:
-				return LoadTiff(filename);
+				return LoadTiff(filename) && ApplyDecodeOptions(options);
 			case Image::FileFormat::kHdr:
-				return LoadHdr(filename);
+				return LoadHdr(filename) && ApplyDecodeOptions(options);
 			default:
 				assert(!"unknown image format");
 				return false;
 			}
 		}
-		bool Image::LoadFromBuffer(const u8* buffer, size_t length)
+		bool Image::LoadFromBuffer(const u8* buffer, size_t length, const DecodeOptions& options)
 		{
-			// TODO: We need to recognize image type from buffer
-			assert(false);
-			FileFormat fmt = Image::FileFormat::kJpg;
+			FileFormat fmt = DetectFileFormat(buffer, length);
 			switch (fmt)
 			{
 			case Image::FileFormat::kBmp:
-				return LoadFromBufferBmp(buffer, length);
+				return LoadFromBufferBmp(buffer, length) && ApplyDecodeOptions(options);
 			case Image::FileFormat::kJpg:
-				return LoadFromBufferJpeg(buffer, length);
+				return LoadFromBufferJpeg(buffer, length, options);
 			case Image::FileFormat::kPng:
-				return LoadFromBufferPng(buffer, length);
+				return LoadFromBufferPng(buffer, length, options);
 			case Image::FileFormat::kTga:
-				return LoadFromBufferTga(buffer, length);
+				return LoadFromBufferTga(buffer, length) && ApplyDecodeOptions(options);
 			case Image::FileFormat::kTif:
-				return LoadFromBufferTiff(buffer, length);
+				return LoadFromBufferTiff(buffer, length) && ApplyDecodeOptions(options);
 			case Image::FileFormat::kHdr:
-				return LoadFromBufferHdr(buffer, length);
+				return LoadFromBufferHdr(buffer, length) && ApplyDecodeOptions(options);
 			default:
 				assert(!"unknown image format");
 				return false;
 			}
 		}
+		Image::FileFormat Image::DetectFileFormat(const u8* buffer, size_t length)
+		{
+			if (length >= 3 && buffer[0] == 0xFF && buffer[1] == 0xD8 && buffer[2] == 0xFF)
+				return FileFormat::kJpg;
+			if (length >= 8 && memcmp(buffer, "\x89PNG\r\n\x1A\n", 8) == 0)
+				return FileFormat::kPng;
+			if (length >= 2 && buffer[0] == 'B' && buffer[1] == 'M')
+				return FileFormat::kBmp;
+			if (length >= 4 && (memcmp(buffer, "II*\0", 4) == 0 || memcmp(buffer, "MM\0*", 4) == 0))
+				return FileFormat::kTif;
+			if (length >= 2 && buffer[0] == '#' && buffer[1] == '?')
+				return FileFormat::kHdr;
+			// TGA has no signature, so check header for sane values
+			if (length >= 18 && buffer[1] <= 1 && (buffer[2] == 1 || buffer[2] == 2 || buffer[2] == 3 ||
+				buffer[2] == 9 || buffer[2] == 10 || buffer[2] == 11))
+				return FileFormat::kTga;
+			return FileFormat::kUnknown;
+		}
 		bool Image::LoadNMapFromHMap(const char* filename)
 		{
-			if (!LoadFromFile(filename))
+			Image height_map;
+			height_map.SetRowOrder(inverted_row_order_);
+			if (!height_map.LoadFromFile(filename))
 				return false;
 
-			int new_bpp = 3;
-			u8 * new_pixels = new u8[width_ * height_ * new_bpp];
-
-			if (data_type_ == DataType::kUint8) // standart bitmap
-			{
-				const float kOneOver255 = 1.0f / 255.0f;
-                                int offs = 0;
-				for (int i = 0; i < height_; i++)
-					for (int j = 0; j < width_; j++)
-					{
-						float c  = (float)pixels_[(i*width_ + j)*channels_];
-						float cx = (float)pixels_[(i*width_ + (j + 1) % width_)*channels_];
-						float cy = (float)pixels_[(((i + 1) % height_)*width_ + j)*channels_];
-						// convert height values to [0,1] range
-						c  *= kOneOver255;
-						cx *= kOneOver255;
-						cy *= kOneOver255;
-
-						// find derivatives
-						float k = 3.0f;
-						float dx = (c - cx) * k;
-						float dy = (c - cy) * k;
-
-						// normalize
-						float len = sqrt(dx*dx + dy*dy + 1);
-
-						// get normal
-						float nx = dy / len;
-						float ny = -dx / len;
-						float nz = 1.0f / len;
-
-						new_pixels[offs    ] = (u8)(128 + 127 * nx);
-						new_pixels[offs + 1] = (u8)(128 + 127 * ny);
-						new_pixels[offs + 2] = (u8)(128 + 127 * nz);
-						offs += 3;
-					}
-			}
-			else if (data_type_ == DataType::kFloat)
-			{
-                                int offs = 0;
-				for (int i = 0; i < height_; i++)
-					for (int j = 0; j < width_; j++)
-					{
-						float c  = reinterpret_cast<float*>(pixels_)[(i*width_ + j)*channels_];
-						float cx = reinterpret_cast<float*>(pixels_)[(i*width_ + (j + 1) % width_)*channels_];
-						float cy = reinterpret_cast<float*>(pixels_)[(((i + 1) % height_)*width_ + j)*channels_];
-
-						// find derivatives
-						float k = 3.0f;
-						float dx = (c - cx) * k;
-						float dy = (c - cy) * k;
-
-						// normalize
-						float len = sqrt(dx*dx + dy*dy + 1);
-
-						// get normal
-						float nx = dy / len;
-						float ny = -dx / len;
-						float nz = 1.0f / len;
-
-						reinterpret_cast<float*>(new_pixels)[offs    ] = nx;
-						reinterpret_cast<float*>(new_pixels)[offs + 1] = ny;
-						reinterpret_cast<float*>(new_pixels)[offs + 2] = nz;
-						offs += 3;
-					}
-			}
-			else // assume its floating point format
-			{
-				assert(!"unknown data type");
-				return false;
-			}
-
-			delete[] pixels_;
-			pixels_ = new_pixels;
-			channels_ = 3;
-			data_type_ = DataType::kUint8;
-			format_ = Format::kRGB8;
-
-			return true;
+			NormalMapBuilder builder;
+			builder.set_output(NormalMapBuilder::Output::kRGB8);
+			return builder.Build(height_map, this);
 		}
 		bool Image::LoadNHMapFromHMap(const char* filename)
 		{
-			if (!LoadFromFile(filename))
+			Image height_map;
+			height_map.SetRowOrder(inverted_row_order_);
+			if (!height_map.LoadFromFile(filename))
 				return false;
 
-			int new_bpp = 4;
-			u8 * new_pixels = new u8[width_ * height_ * new_bpp];
-
-			if (data_type_ == DataType::kUint8) // standart bitmap
-			{
-				const float kOneOver255 = 1.0f / 255.0f;
-                                int offs = 0;
-				for (int i = 0; i < height_; i++)
-					for (int j = 0; j < width_; j++)
-					{
-						float c  = (float)pixels_[(i*width_ + j)*channels_];
-						float cx = (float)pixels_[(i*width_ + (j + 1) % width_)*channels_];
-						float cy = (float)pixels_[(((i + 1) % height_)*width_ + j)*channels_];
-						// convert height values to [0,1] range
-						c  *= kOneOver255;
-						cx *= kOneOver255;
-						cy *= kOneOver255;
-
-						// find derivatives
-						float k = 3.0f;
-						float dx = (c - cx) * k;
-						float dy = (c - cy) * k;
-
-						// normalize
-						float len = sqrt(dx*dx + dy*dy + 1);
-
-						// get normal
-						float nx = dy / len;
-						float ny = -dx / len;
-						float nz = 1.0f / len;
-
-						new_pixels[offs    ] = (unsigned char)(128 + 127 * nx);
-						new_pixels[offs + 1] = (unsigned char)(128 + 127 * ny);
-						new_pixels[offs + 2] = (unsigned char)(128 + 127 * nz);
-						new_pixels[offs + 3] = (unsigned char)(255 * c);
-						offs += 4;
-					}
-			}
-			else if (data_type_ == DataType::kFloat)
-			{
-                                int offs = 0;
-				for (int i = 0; i < height_; i++)
-					for (int j = 0; j < width_; j++)
-					{
-						float c  = reinterpret_cast<float*>(pixels_)[(i*width_ + j)*channels_];
-						float cx = reinterpret_cast<float*>(pixels_)[(i*width_ + (j + 1) % width_)*channels_];
-						float cy = reinterpret_cast<float*>(pixels_)[(((i + 1) % height_)*width_ + j)*channels_];
-
-						// find derivatives
-						float k = 3.0f;
-						float dx = (c - cx) * k;
-						float dy = (c - cy) * k;
-
-						// normalize
-						float len = sqrt(dx*dx + dy*dy + 1);
-
-						// get normal
-						float nx = dy / len;
-						float ny = -dx / len;
-						float nz = 1.0f / len;
-
-						reinterpret_cast<float*>(new_pixels)[offs    ] = nx;
-						reinterpret_cast<float*>(new_pixels)[offs + 1] = ny;
-						reinterpret_cast<float*>(new_pixels)[offs + 2] = nz;
-						reinterpret_cast<float*>(new_pixels)[offs + 3] = c;
-						offs += 4;
-					}
-			}
-			else // assume its floating point format
-			{
-				assert(!"unknown data type");
-				return false;
-			}
-
-			delete[] pixels_;
-			pixels_ = new_pixels;
-			channels_ = 4;
-			data_type_ = DataType::kUint8;
-			format_ = Format::kRGBA8;
-
-			return true;
+			NormalMapBuilder builder;
+			builder.set_output(NormalMapBuilder::Output::kRGBA8);
+			return builder.Build(height_map, this);
 		}
 
 	} // namespace graphics
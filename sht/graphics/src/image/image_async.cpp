@@ -0,0 +1,58 @@
+#include "../../include/image/image.h"
+#include "../../../system/include/tasks/service_pool.h"
+#include "../../../system/include/tasks/service_task_interface.h"
+
+#include <string>
+
+namespace sht {
+	namespace graphics {
+
+		namespace {
+
+			//! Task that decodes image file on service pool thread
+			class ImageLoadTask : public system::ServiceTaskInterface {
+			public:
+				ImageLoadTask(Image * image, const char * filename, const Image::DecodeOptions& options,
+					const std::function<void(Image*, bool)>& callback)
+				: image_(image)
+				, filename_(filename)
+				, options_(options)
+				, callback_(callback)
+				{
+				}
+				std::future<bool> GetFuture()
+				{
+					return promise_.get_future();
+				}
+				bool Execute() final
+				{
+					return image_->LoadFromFile(filename_.c_str(), options_);
+				}
+				void Notify(bool success) final
+				{
+					if (callback_)
+						callback_(image_, success);
+					promise_.set_value(success);
+				}
+
+			private:
+				Image * image_;
+				std::string filename_;
+				Image::DecodeOptions options_;
+				std::function<void(Image*, bool)> callback_;
+				std::promise<bool> promise_;
+			};
+
+		} // namespace
+
+		std::future<bool> Image::LoadAsync(const char* filename, const DecodeOptions& options,
+			const std::function<void(Image*, bool)>& callback)
+		{
+			ImageLoadTask * task = new ImageLoadTask(this, filename, options, callback);
+			std::future<bool> future = task->GetFuture();
+			system::ServicePool::GetShared()->AddTask(task);
+			return future;
+		}
+
+	} // namespace graphics
+} // namespace sht
@@ -0,0 +1,125 @@
+#include "image_decode.h"
+
+#include <cstring>
+#include <algorithm>
+
+namespace sht {
+	namespace graphics {
+
+		DecodeRegion ResolveDecodeRegion(const Image::DecodeOptions& options, int width, int height)
+		{
+			DecodeRegion region;
+			if (options.region_width <= 0 || options.region_height <= 0)
+			{
+				region.x = 0;
+				region.y = 0;
+				region.width = width;
+				region.height = height;
+				return region;
+			}
+			region.x = std::min(std::max(options.region_x, 0), width - 1);
+			region.y = std::min(std::max(options.region_y, 0), height - 1);
+			region.width = std::min(options.region_width, width - region.x);
+			region.height = std::min(options.region_height, height - region.y);
+			return region;
+		}
+		int ChooseDecodeScale(const Image::DecodeOptions& options, const DecodeRegion& region)
+		{
+			if (options.target_width <= 0 && options.target_height <= 0)
+				return 1;
+			int factor = 8;
+			while (factor > 1)
+			{
+				bool fits_width = region.width / factor >= options.target_width;
+				bool fits_height = region.height / factor >= options.target_height;
+				if (fits_width && fits_height)
+					break;
+				factor >>= 1;
+			}
+			// Don't let small regions collapse to nothing
+			while (factor > 1 && (region.width < factor || region.height < factor))
+				factor >>= 1;
+			return factor;
+		}
+		DecodeRowSink::DecodeRowSink(const DecodeRegion& region, int factor, int bpp,
+			u8 * dst_pixels, int dst_width, int dst_height, bool inverted_row_order, DecodeScratch * scratch)
+		: region_(region)
+		, factor_(factor)
+		, bpp_(bpp)
+		, dst_pixels_(dst_pixels)
+		, dst_width_(dst_width)
+		, dst_height_(dst_height)
+		, inverted_row_order_(inverted_row_order)
+		, rows_written_(0)
+		, accumulator_(&scratch->accumulator)
+		{
+			if (factor_ > 1)
+				accumulator_->assign(dst_width_ * bpp_, 0U);
+		}
+		bool DecodeRowSink::NeedsRow(int src_row) const
+		{
+			return src_row >= region_.y && src_row <= last_needed_row();
+		}
+		bool DecodeRowSink::IsFinished() const
+		{
+			return rows_written_ >= dst_height_;
+		}
+		int DecodeRowSink::last_needed_row() const
+		{
+			return region_.y + dst_height_ * factor_ - 1;
+		}
+		u8 * DecodeRowSink::GetDirectRow(int src_row, int src_width) const
+		{
+			if (factor_ != 1 || region_.x != 0 || dst_width_ != src_width || !NeedsRow(src_row))
+				return nullptr;
+			return GetDstRow(src_row - region_.y);
+		}
+		void DecodeRowSink::PushRow(int src_row, const u8 * row)
+		{
+			if (!NeedsRow(src_row))
+				return;
+			int local_row = src_row - region_.y;
+			if (factor_ == 1)
+			{
+				u8 * dst = GetDstRow(local_row);
+				if (dst != row) // row may have been decoded in-place
+					memcpy(dst, row + region_.x * bpp_, dst_width_ * bpp_);
+				++rows_written_;
+				return;
+			}
+			// Accumulate horizontally summed boxes
+			const u8 * src = row + region_.x * bpp_;
+			for (int x = 0; x < dst_width_; ++x)
+			{
+				u32 * sums = &(*accumulator_)[x * bpp_];
+				for (int i = 0; i < factor_; ++i)
+				{
+					for (int c = 0; c < bpp_; ++c)
+						sums[c] += src[c];
+					src += bpp_;
+				}
+			}
+			if (local_row % factor_ == factor_ - 1)
+			{
+				const u32 area = static_cast<u32>(factor_ * factor_);
+				const u32 half = area >> 1;
+				u8 * dst = GetDstRow(local_row / factor_);
+				u32 * sums = &(*accumulator_)[0];
+				const size_t count = accumulator_->size();
+				for (size_t i = 0; i < count; ++i)
+				{
+					dst[i] = static_cast<u8>((sums[i] + half) / area);
+					sums[i] = 0U;
+				}
+				++rows_written_;
+			}
+		}
+		u8 * DecodeRowSink::GetDstRow(int dst_row) const
+		{
+			if (inverted_row_order_)
+				dst_row = dst_height_ - 1 - dst_row;
+			return dst_pixels_ + static_cast<size_t>(dst_row) * dst_width_ * bpp_;
+		}
+
+	} // namespace graphics
+} // namespace sht
@@ -0,0 +1,68 @@
+#pragma once
+#ifndef __SHT_GRAPHICS_IMAGE_DECODE_H__
+#define __SHT_GRAPHICS_IMAGE_DECODE_H__
+
+#include "../../include/image/image.h"
+
+#include <vector>
+
+namespace sht {
+	namespace graphics {
+
+		//! Rectangle of the source image to be decoded
+		struct DecodeRegion {
+			int x;
+			int y;
+			int width;
+			int height;
+		};
+
+		//! Clamps options region to image bounds, empty region means full image
+		DecodeRegion ResolveDecodeRegion(const Image::DecodeOptions& options, int width, int height);
+
+		//! Chooses largest downscale factor among 8, 4, 2, 1 that keeps region not smaller than target
+		int ChooseDecodeScale(const Image::DecodeOptions& options, const DecodeRegion& region);
+
+		//! Work buffers of row decoding.
+		//! Codecs that report errors with longjmp create it before setjmp,
+		//! so buffers are freed when decoding is aborted.
+		struct DecodeScratch {
+			std::vector<u8> row;				//!< row that can't be decoded in-place
+			std::vector<u32> accumulator;		//!< box filter sums of destination row
+			std::vector<u8*> row_pointers;		//!< rows of interlaced image
+		};
+
+		//! Receives decoded 8-bit rows in top-to-bottom order, crops them to region
+		//! and box-filters by integer factor directly into destination pixels
+		class DecodeRowSink {
+		public:
+			DecodeRowSink(const DecodeRegion& region, int factor, int bpp,
+				u8 * dst_pixels, int dst_width, int dst_height, bool inverted_row_order, DecodeScratch * scratch);
+
+			bool NeedsRow(int src_row) const;	//!< whether row with given index affects output
+			bool IsFinished() const;			//!< all destination rows have been written
+			int last_needed_row() const;		//!< last source row affecting output
+
+			//! Returns pointer where full source row may be decoded in-place or nullptr
+			u8 * GetDirectRow(int src_row, int src_width) const;
+
+			void PushRow(int src_row, const u8 * row);	//!< row contains full source width
+
+		private:
+			u8 * GetDstRow(int dst_row) const;
+
+			DecodeRegion region_;
+			int factor_;
+			int bpp_;
+			u8 * dst_pixels_;
+			int dst_width_;
+			int dst_height_;
+			bool inverted_row_order_;
+			int rows_written_;
+			std::vector<u32> * accumulator_;	//!< owned by scratch
+		};
+
+	} // namespace graphics
+} // namespace sht
+
+#endif
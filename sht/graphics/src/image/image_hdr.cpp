@@ -180,8 +180,7 @@ namespace sht {
 			bpp_ = channels_ * sizeof(float);
 			format_ = Format::kRGB32;
 
-			float *cols = new float[width_ * height_ * bpp_];
-			pixels_ = reinterpret_cast<u8*>(cols);
+			float *cols = reinterpret_cast<float*>(AllocatePixels(static_cast<size_t>(width_ * height_ * bpp_)));
 
 			RGBE *scanline = new RGBE[w];
 			if (!scanline)
@@ -1,9 +1,12 @@
 #include "../../include/image/image.h"
+#include "image_decode.h"
 #include "../../../system/include/stream/file_stream.h"
 #include "../../../system/include/stream/log_stream.h"
 #include "../../../thirdparty/libjpeg/include/jpeglib.h"
 
 #include <csetjmp> // for error handling
+#include <vector>
+#include <algorithm>
 
 namespace sht {
 	namespace graphics {
@@ -148,7 +151,84 @@ namespace sht {
 			/* Jump to the setjmp point */
 			longjmp(myerr->setjmp_buffer, 1);
 		}
-		bool Image::LoadJpeg(const char *filename)
+		bool Image::DecodeJpeg(jpeg_decompress_struct * cinfo, const DecodeOptions& options, DecodeScratch * scratch)
+		{
+			/* Use DCT scaling to skip work when smaller image is requested */
+			DecodeRegion region = ResolveDecodeRegion(options, cinfo->image_width, cinfo->image_height);
+			int factor = ChooseDecodeScale(options, region);
+			cinfo->scale_num = 1;
+			cinfo->scale_denom = factor;
+
+			(void)jpeg_start_decompress(cinfo);
+			/* We can ignore the return value since suspension is not possible
+			* with the stdio data source.
+			*/
+
+			/* Region in scaled output coordinates */
+			const int output_width = static_cast<int>(cinfo->output_width);
+			const int output_height = static_cast<int>(cinfo->output_height);
+			DecodeRegion scaled;
+			scaled.x = std::min(region.x / factor, output_width - 1);
+			scaled.y = std::min(region.y / factor, output_height - 1);
+			scaled.width = std::max(1, std::min(region.width / factor, output_width - scaled.x));
+			scaled.height = std::max(1, std::min(region.height / factor, output_height - scaled.y));
+
+			channels_ = cinfo->output_components;
+			data_type_ = DataType::kUint8;
+			switch (channels_)
+			{
+			case 4:
+				bpp_ = 4;
+				format_ = Format::kRGBA8;
+				break;
+			case 3:
+				bpp_ = 3;
+				format_ = Format::kRGB8;
+				break;
+			case 2:
+				bpp_ = 2;
+				format_ = Format::kRG8;
+				break;
+			case 1:
+				bpp_ = 1;
+				format_ = Format::kR8;
+				break;
+
+			default:
+				assert(!"Implement this case");
+				break;
+			}
+
+			if (!SetupDecodeBuffer(scaled.width, scaled.height, options))
+			{
+				jpeg_abort_decompress(cinfo);
+				return false;
+			}
+
+			/* Rows are decoded in-place when possible, otherwise through scratch row.
+			* IJG library can't skip scanlines, so rows above region still get decoded,
+			* but everything below region is never touched.
+			*/
+			DecodeRowSink sink(scaled, 1, bpp_, pixels_, scaled.width, scaled.height, inverted_row_order_, scratch);
+			scratch->row.resize(static_cast<size_t>(output_width * bpp_));
+			JSAMPROW rowptr[1];
+			while (!sink.IsFinished() && cinfo->output_scanline < cinfo->output_height)
+			{
+				int row = static_cast<int>(cinfo->output_scanline);
+				u8 * direct = sink.GetDirectRow(row, output_width);
+				rowptr[0] = (direct != nullptr) ? direct : &scratch->row[0];
+				(void)jpeg_read_scanlines(cinfo, rowptr, 1);
+				sink.PushRow(row, rowptr[0]);
+			}
+
+			/* Stop early if there are rows below region */
+			if (cinfo->output_scanline < cinfo->output_height)
+				jpeg_abort_decompress(cinfo);
+			else
+				(void)jpeg_finish_decompress(cinfo);
+			return true;
+		}
+		bool Image::LoadJpeg(const char *filename, const DecodeOptions& options)
 		{
 			// Get access to error log
 			system::ErrorLogStream * error_log = system::ErrorLogStream::GetInstance();
@@ -164,8 +244,6 @@ namespace sht {
 			jpegErrorManager jerr;
 			/* More stuff */
 			sht::system::FileStream stream;
-			unsigned char * rowptr[1];
-			int row_stride;		/* physical row width in output buffer */
 
 			/* In this example we want to open the input file before doing anything else,
 			* so that the setjmp() error recovery below can assume the file is open.
@@ -184,6 +262,8 @@ namespace sht {
 			/* We set up the normal JPEG error routines, then override error_exit. */
 			cinfo.err = jpeg_std_error(&jerr.pub);
 			jerr.pub.error_exit = jpegErrorExit;
+			/* Decoding buffers are owned here, so longjmp doesn't skip their destructors. */
+			DecodeScratch scratch;
 			/* Establish the setjmp return context for my_error_exit to use. */
 			if (setjmp(jerr.setjmp_buffer)) {
 				/* If we get here, the JPEG code has signaled an error. */
@@ -208,85 +288,9 @@ namespace sht {
 			* See libjpeg.txt for more info.
 			*/
 
-			/* Step 4: set parameters for decompression */
+			/* Steps 4-7: set scaling, decompress needed rows and finish */
 
-			/* In this example, we don't need to change any of the defaults set by
-			* jpeg_read_header(), so we do nothing here.
-			*/
-
-			/* Step 5: Start decompressor */
-
-			(void)jpeg_start_decompress(&cinfo);
-			/* We can ignore the return value since suspension is not possible
-			* with the stdio data source.
-			*/
-
-			width_ = cinfo.output_width;
-			height_ = cinfo.output_height;
-			channels_ = cinfo.num_components;
-			data_type_ = DataType::kUint8;
-            switch (channels_)
-            {
-            case 4:
-                bpp_ = 4;
-                format_ = Format::kRGBA8;
-                break;
-            case 3:
-                bpp_ = 3;
-                format_ = Format::kRGB8;
-                break;
-            case 2:
-                bpp_ = 2;
-                format_ = Format::kRG8;
-                break;
-            case 1:
-                bpp_ = 1;
-                format_ = Format::kR8;
-                break;
-                
-            default:
-                assert(!"Implement this case");
-                break;
-            }
-
-			pixels_ = new u8[width_ * height_ * bpp_];
-
-			/* We may need to do some setup of our own at this point before reading
-			* the data.  After jpeg_start_decompress() we have the correct scaled
-			* output image dimensions available, as well as the output colormap
-			* if we asked for color quantization.
-			* In this example, we need to make an output work buffer of the right size.
-			*/
-			/* JSAMPLEs per row in output buffer */
-			row_stride = cinfo.output_width * cinfo.output_components;
-
-			/* Step 6: while (scan lines remain to be read) */
-			/*           jpeg_read_scanlines(...); */
-
-			/* Here we use the library's state variable cinfo.output_scanline as the
-			* loop counter, so that we don't have to keep track ourselves.
-			*/
-			while (cinfo.output_scanline < cinfo.output_height) {
-                if (inverted_row_order_)
-                {
-                    int row_number = cinfo.output_height - 1 - cinfo.output_scanline;
-                    rowptr[0] = pixels_ + row_stride * row_number;
-                }
-                else // normal row order
-                    rowptr[0] = pixels_ + row_stride * cinfo.output_scanline;
-				/* jpeg_read_scanlines expects an array of pointers to scanlines.
-				* Here the array is only one element long, but you could ask for
-				* more than one scanline at a time if that's more convenient.
-				*/
-				(void)jpeg_read_scanlines(&cinfo, rowptr, 1);
-			}
-
-			/* Step 7: Finish decompression */
-
-			(void)jpeg_finish_decompress(&cinfo);
-			/* We can ignore the return value since suspension is not possible
-			* with the stdio data source.
-			*/
+			bool result = DecodeJpeg(&cinfo, options, &scratch);
 
 			/* Step 8: Release JPEG decompression object */
 
@@ -304,9 +308,9 @@ namespace sht {
 			* warnings occurred (test whether jerr.pub.num_warnings is nonzero).
 			*/
 
-			return true;
+			return result;
 		}
-		bool Image::LoadFromBufferJpeg(const u8* buffer, size_t length)
+		bool Image::LoadFromBufferJpeg(const u8* buffer, size_t length, const DecodeOptions& options)
 		{
 			/* This struct contains the JPEG decompression parameters and pointers to
 			* working space (which is allocated as needed by the JPEG library).
@@ -317,15 +321,14 @@ namespace sht {
 			* struct, to avoid dangling-pointer problems.
 			*/
 			jpegErrorManager jerr;
-			/* More stuff */
-			unsigned char * rowptr[1];
-			int row_stride;		/* physical row width in output buffer */
 
 			/* Step 1: allocate and initialize JPEG decompression object */
 
 			/* We set up the normal JPEG error routines, then override error_exit. */
 			cinfo.err = jpeg_std_error(&jerr.pub);
 			jerr.pub.error_exit = jpegErrorExit;
+			/* Decoding buffers are owned here, so longjmp doesn't skip their destructors. */
+			DecodeScratch scratch;
 			/* Establish the setjmp return context for my_error_exit to use. */
 			if (setjmp(jerr.setjmp_buffer)) {
 				/* If we get here, the JPEG code has signaled an error. */
@@ -358,85 +361,9 @@ namespace sht {
 			* See libjpeg.txt for more info.
 			*/
 
-			/* Step 4: set parameters for decompression */
-
-			/* In this example, we don't need to change any of the defaults set by
-			* jpeg_read_header(), so we do nothing here.
-			*/
-
-			/* Step 5: Start decompressor */
-
-			(void)jpeg_start_decompress(&cinfo);
-			/* We can ignore the return value since suspension is not possible
-			* with the stdio data source.
-			*/
-
-			width_ = cinfo.output_width;
-			height_ = cinfo.output_height;
-			channels_ = cinfo.num_components;
-			data_type_ = DataType::kUint8;
-			switch (channels_)
-			{
-			case 4:
-				bpp_ = 4;
-				format_ = Format::kRGBA8;
-				break;
-			case 3:
-				bpp_ = 3;
-				format_ = Format::kRGB8;
-				break;
-			case 2:
-				bpp_ = 2;
-				format_ = Format::kRG8;
-				break;
-			case 1:
-				bpp_ = 1;
-				format_ = Format::kR8;
-				break;
-
-			default:
-				assert(!"Implement this case");
-				break;
-			}
-
-			pixels_ = new u8[width_ * height_ * bpp_];
-
-			/* We may need to do some setup of our own at this point before reading
-			* the data.  After jpeg_start_decompress() we have the correct scaled
-			* output image dimensions available, as well as the output colormap
-			* if we asked for color quantization.
-			* In this example, we need to make an output work buffer of the right size.
-			*/
-			/* JSAMPLEs per row in output buffer */
-			row_stride = cinfo.output_width * cinfo.output_components;
-
-			/* Step 6: while (scan lines remain to be read) */
-			/*           jpeg_read_scanlines(...); */
-
-			/* Here we use the library's state variable cinfo.output_scanline as the
-			* loop counter, so that we don't have to keep track ourselves.
-			*/
-			while (cinfo.output_scanline < cinfo.output_height) {
-				if (inverted_row_order_)
-				{
-					int row_number = cinfo.output_height - 1 - cinfo.output_scanline;
-					rowptr[0] = pixels_ + row_stride * row_number;
-				}
-				else // normal row order
-					rowptr[0] = pixels_ + row_stride * cinfo.output_scanline;
-				/* jpeg_read_scanlines expects an array of pointers to scanlines.
-				* Here the array is only one element long, but you could ask for
-				* more than one scanline at a time if that's more convenient.
-				*/
-				(void)jpeg_read_scanlines(&cinfo, rowptr, 1);
-			}
-
-			/* Step 7: Finish decompression */
+			/* Steps 4-7: set scaling, decompress needed rows and finish */
 
-			(void)jpeg_finish_decompress(&cinfo);
-			/* We can ignore the return value since suspension is not possible
-			* with the stdio data source.
-			*/
+			bool result = DecodeJpeg(&cinfo, options, &scratch);
 
 			/* Step 8: Release JPEG decompression object */
 
@@ -447,7 +374,7 @@ namespace sht {
 			* warnings occurred (test whether jerr.pub.num_warnings is nonzero).
 			*/
 
-			return true;
+			return result;
 		}
 
 	} // namespace graphics
@@ -1,15 +1,19 @@
 #include "../../include/image/image.h"
+#include "image_decode.h"
 #include "../../../system/include/stream/file_stream.h"
 #include "../../../system/include/stream/log_stream.h"
 #include "../../../thirdparty/libpng/include/png.h"
 
 #include <cstring>
+#include <vector>
 
 namespace sht {
 	namespace graphics {
 
 		bool Image::SavePng(const char *filename)
 		{
+			assert(bpp_ == 4 && channels_ == 4);
+
 			// Get access to error log
 			system::ErrorLogStream * error_log = system::ErrorLogStream::GetInstance();
 
@@ -31,14 +35,14 @@ namespace sht {
 			if (!info)
 			{
 				error_log->PrintString("png_create_info_struct failed during saving '%s'\n", filename);
-				png_destroy_write_struct(&png, NULL);
+				png_destroy_write_struct(&png, &info);
 				return false;
 			}
 
 			if (setjmp(png_jmpbuf(png)))
 			{
 				error_log->PrintString("set_jmp failed during saving '%s'\n", filename);
-				png_destroy_write_struct(&png, NULL);
+				png_destroy_write_struct(&png, &info);
 				return false;
 			}
 
@@ -64,8 +68,8 @@ namespace sht {
 			int row_stride = width_ * bpp_;
             if (inverted_row_order_)
             {
-                for(int y = height_-1; y >= 0; --y)
-                    row_pointers[y] = (png_bytep)(pixels_ + y*row_stride);
+                for(int y = 0; y < height_; ++y)
+                    row_pointers[y] = (png_bytep)(pixels_ + (height_-1-y)*row_stride);
             }
             else // normal row order
             {
@@ -78,50 +82,14 @@ namespace sht {
 			
 			delete[] row_pointers;
 
-			png_destroy_write_struct(&png, NULL);
+			png_destroy_write_struct(&png, &info);
 
             stream.Close();
 
 			return true;
 		}
-		bool Image::LoadPng(const char *filename)
+		bool Image::DecodePng(png_struct_def * png, png_info_def * info, const DecodeOptions& options, DecodeScratch * scratch)
 		{
-			// Get access to error log
-			system::ErrorLogStream * error_log = system::ErrorLogStream::GetInstance();
-
-            sht::system::FileStream stream;
-            if (!stream.Open(filename, sht::system::StreamAccess::kReadBinary))
-            {
-				error_log->PrintString("failed to open file '%s' for loading\n", filename);
-                return false;
-            }
-
-			png_structp png = png_create_read_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
-			if (!png)
-			{
-				error_log->PrintString("png_create_read_struct failed during loading '%s'\n", filename);
-				return false;
-			}
-
-			png_infop info = png_create_info_struct(png);
-			if (!info)
-			{
-				error_log->PrintString("png_create_info_struct failed during loading '%s'\n", filename);
-				png_destroy_read_struct(&png, NULL, NULL);
-				return false;
-			}
-
-			if (setjmp(png_jmpbuf(png)))
-			{
-				error_log->PrintString("setjmp failed during loading '%s'\n", filename);
-				png_destroy_read_struct(&png, NULL, NULL);
-				return false;
-			}
-
-			png_init_io(png, stream.GetFilePointer());
-
-			png_read_info(png, info);
-
 			png_byte color_type = png_get_color_type(png, info);
 			png_byte bit_depth  = png_get_bit_depth(png, info);
 
@@ -151,42 +119,107 @@ namespace sht {
 				color_type == PNG_COLOR_TYPE_GRAY_ALPHA)
 				png_set_gray_to_rgb(png);
 
+			int passes = png_set_interlace_handling(png);
+
 			png_read_update_info(png, info);
-			
-			width_      = png_get_image_width(png, info);
-			height_     = png_get_image_height(png, info);
+
+			int src_width = static_cast<int>(png_get_image_width(png, info));
+			int src_height = static_cast<int>(png_get_image_height(png, info));
 			channels_	= 4;
 			data_type_ 	= DataType::kUint8;
 			bpp_ 		= 4;
 			format_ 	= Format::kRGBA8;
 
-			size_t image_size = png_get_rowbytes(png, info) * height_;
-			pixels_ = new u8[image_size];
-			
-			png_bytepp row_pointers = new png_bytep[height_];
-			int row_stride = width_ * bpp_;
-            
-            if (inverted_row_order_)
-            {
-                for(int y = height_-1; y >= 0; --y)
-                    row_pointers[y] = (png_bytep)(pixels_ + y*row_stride);
-            }
-            else // normal row order
+			if (passes > 1)
+			{
+				// Interlaced image needs all passes, so decode it fully and crop afterwards
+				width_ = src_width;
+				height_ = src_height;
+				AllocatePixels(png_get_rowbytes(png, info) * height_);
+
+				std::vector<u8*>& row_pointers = scratch->row_pointers;
+				row_pointers.resize(height_);
+				int row_stride = width_ * bpp_;
+				for (int y = 0; y < height_; ++y)
+				{
+					int row_number = (inverted_row_order_) ? (height_ - 1 - y) : y;
+					row_pointers[y] = (png_bytep)(pixels_ + row_number * row_stride);
+				}
+				png_read_image(png, &row_pointers[0]);
+				png_read_end(png, NULL);
+
+				return ApplyDecodeOptions(options);
+			}
+
+			// Non-interlaced rows are streamed through sink that crops and box-filters them
+			DecodeRegion region = ResolveDecodeRegion(options, src_width, src_height);
+			int factor = ChooseDecodeScale(options, region);
+			if (!SetupDecodeBuffer(region.width / factor, region.height / factor, options))
+				return false;
+
+			DecodeRowSink sink(region, factor, bpp_, pixels_, width_, height_, inverted_row_order_, scratch);
+			scratch->row.resize(png_get_rowbytes(png, info));
+			int y = 0;
+			for (; y < src_height && !sink.IsFinished(); ++y)
+			{
+				u8 * direct = sink.GetDirectRow(y, src_width);
+				u8 * row = (direct != nullptr) ? direct : &scratch->row[0];
+				png_read_row(png, row, NULL);
+				sink.PushRow(y, row);
+			}
+			// Rows below region are never decoded
+			if (y == src_height)
+				png_read_end(png, NULL);
+
+			return true;
+		}
+		bool Image::LoadPng(const char *filename, const DecodeOptions& options)
+		{
+			// Get access to error log
+			system::ErrorLogStream * error_log = system::ErrorLogStream::GetInstance();
+
+            sht::system::FileStream stream;
+            if (!stream.Open(filename, sht::system::StreamAccess::kReadBinary))
             {
-                for(int y = 0; y < height_; ++y)
-                    row_pointers[y] = (png_bytep)(pixels_ + y*row_stride);
+				error_log->PrintString("failed to open file '%s' for loading\n", filename);
+                return false;
             }
 
-			png_read_image(png, row_pointers);
-			png_read_end(png, NULL);
-			
-			delete[] row_pointers;
+			png_structp png = png_create_read_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
+			if (!png)
+			{
+				error_log->PrintString("png_create_read_struct failed during loading '%s'\n", filename);
+				return false;
+			}
+
+			png_infop info = png_create_info_struct(png);
+			if (!info)
+			{
+				error_log->PrintString("png_create_info_struct failed during loading '%s'\n", filename);
+				png_destroy_read_struct(&png, NULL, NULL);
+				return false;
+			}
+
+			// Decoding buffers are owned here, so longjmp doesn't skip their destructors
+			DecodeScratch scratch;
+			if (setjmp(png_jmpbuf(png)))
+			{
+				error_log->PrintString("setjmp failed during loading '%s'\n", filename);
+				png_destroy_read_struct(&png, &info, NULL);
+				return false;
+			}
 
-			png_destroy_read_struct(&png, NULL, NULL);
+			png_init_io(png, stream.GetFilePointer());
+
+			png_read_info(png, info);
+
+			bool result = DecodePng(png, info, options, &scratch);
+
+			png_destroy_read_struct(&png, &info, NULL);
 
             stream.Close();
 
-			return true;
+			return result;
 		}
 		struct PngReadState {
 			const u8 * buffer;
@@ -204,7 +237,7 @@ namespace sht {
 			else
 				png_error(png_ptr, "read error (ReadDataFromBuffer)");
 		}
-		bool Image::LoadFromBufferPng(const u8* buffer, size_t length)
+		bool Image::LoadFromBufferPng(const u8* buffer, size_t length, const DecodeOptions& options)
 		{
 			// Get access to error log
 			system::ErrorLogStream * error_log = system::ErrorLogStream::GetInstance();
@@ -224,10 +257,12 @@ namespace sht {
 				return false;
 			}
 
+			// Decoding buffers are owned here, so longjmp doesn't skip their destructors
+			DecodeScratch scratch;
 			if (setjmp(png_jmpbuf(png)))
 			{
 				error_log->PrintString("setjmp failed\n");
-				png_destroy_read_struct(&png, NULL, NULL);
+				png_destroy_read_struct(&png, &info, NULL);
 				return false;
 			}
 
@@ -239,69 +274,11 @@ namespace sht {
 
 			png_read_info(png, info);
 
-			png_byte color_type = png_get_color_type(png, info);
-			png_byte bit_depth = png_get_bit_depth(png, info);
-
-			// Read any color_type into 8bit depth, RGBA format.
-			// See http://www.libpng.org/pub/png/libpng-manual.txt
-
-			if (bit_depth == 16)
-				png_set_strip_16(png);
-
-			if (color_type == PNG_COLOR_TYPE_PALETTE)
-				png_set_palette_to_rgb(png);
-
-			// PNG_COLOR_TYPE_GRAY_ALPHA is always 8 or 16bit depth.
-			if (color_type == PNG_COLOR_TYPE_GRAY && bit_depth < 8)
-				png_set_expand_gray_1_2_4_to_8(png);
-
-			if (png_get_valid(png, info, PNG_INFO_tRNS))
-				png_set_tRNS_to_alpha(png);
-
-			// These color_type don't have an alpha channel then fill it with 0xff.
-			if (color_type == PNG_COLOR_TYPE_RGB ||
-				color_type == PNG_COLOR_TYPE_GRAY ||
-				color_type == PNG_COLOR_TYPE_PALETTE)
-				png_set_filler(png, 0xFF, PNG_FILLER_AFTER);
-
-			if (color_type == PNG_COLOR_TYPE_GRAY ||
-				color_type == PNG_COLOR_TYPE_GRAY_ALPHA)
-				png_set_gray_to_rgb(png);
-
-			png_read_update_info(png, info);
-
-			width_ = png_get_image_width(png, info);
-			height_ = png_get_image_height(png, info);
-			channels_ = 4;
-			data_type_ = DataType::kUint8;
-			bpp_ = 4;
-			format_ = Format::kRGBA8;
-
-			size_t image_size = png_get_rowbytes(png, info) * height_;
-			pixels_ = new u8[image_size];
-
-			png_bytepp row_pointers = new png_bytep[height_];
-			int row_stride = width_ * bpp_;
-
-			if (inverted_row_order_)
-			{
-				for (int y = height_ - 1; y >= 0; --y)
-					row_pointers[y] = (png_bytep)(pixels_ + y*row_stride);
-			}
-			else // normal row order
-			{
-				for (int y = 0; y < height_; ++y)
-					row_pointers[y] = (png_bytep)(pixels_ + y*row_stride);
-			}
+			bool result = DecodePng(png, info, options, &scratch);
 
-			png_read_image(png, row_pointers);
-			png_read_end(png, NULL);
+			png_destroy_read_struct(&png, &info, NULL);
 
-			delete[] row_pointers;
-
-			png_destroy_read_struct(&png, NULL, NULL);
-
-			return true;
+			return result;
 		}
 
 	} // namespace graphics
@@ -344,8 +344,7 @@ namespace sht {
 			}
 
 			delete[] samples;
-			delete[] pixels_;
-			pixels_ = new_data;
+			SetPixels(new_data, static_cast<size_t>(w * h * bpp_), true);
 			width_ = w;
 			height_ = h;
 		}
@@ -387,8 +386,7 @@ namespace sht {
 				}
 
 				delete[] samples;
-				delete[] pixels_;
-				pixels_ = new_data;
+				SetPixels(new_data, static_cast<size_t>(w2 * h2 * bpp_), true);
 				width_ = w2;
 				height_ = h2;
 			}
@@ -0,0 +1,272 @@
+#include "../../include/image/normal_map_builder.h"
+
+#include "system/include/tasks/parallel_for.h"
+
+#include <vector>
+#include <cmath>
+#include <assert.h>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define SHT_NORMAL_MAP_SSE
+#include <xmmintrin.h>
+#endif
+
+namespace sht {
+	namespace graphics {
+
+		namespace {
+
+			//! Finds normalized normal components from scaled derivatives, works in place
+			void NormalizeRow(float * nx, float * ny, float * nz, int count)
+			{
+				int i = 0;
+#ifdef SHT_NORMAL_MAP_SSE
+				const __m128 one = _mm_set1_ps(1.0f);
+				const __m128 half = _mm_set1_ps(0.5f);
+				const __m128 three = _mm_set1_ps(3.0f);
+				for (; i + 4 <= count; i += 4)
+				{
+					__m128 x = _mm_loadu_ps(nx + i);
+					__m128 y = _mm_loadu_ps(ny + i);
+					__m128 len2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), one);
+					// Approximate reciprocal square root refined by one Newton-Raphson step
+					__m128 r = _mm_rsqrt_ps(len2);
+					r = _mm_mul_ps(_mm_mul_ps(half, r), _mm_sub_ps(three, _mm_mul_ps(_mm_mul_ps(len2, r), r)));
+					_mm_storeu_ps(nx + i, _mm_mul_ps(x, r));
+					_mm_storeu_ps(ny + i, _mm_mul_ps(y, r));
+					_mm_storeu_ps(nz + i, r);
+				}
+#endif
+				for (; i < count; ++i)
+				{
+					float r = 1.0f / sqrtf(nx[i] * nx[i] + ny[i] * ny[i] + 1.0f);
+					nx[i] *= r;
+					ny[i] *= r;
+					nz[i] = r;
+				}
+			}
+			inline u8 PackComponent(float value)
+			{
+				return static_cast<u8>(128.0f + 127.0f * value);
+			}
+			inline u8 PackHeight(float value)
+			{
+				float clamped = (value < 0.0f) ? 0.0f : ((value > 1.0f) ? 1.0f : value);
+				return static_cast<u8>(255.0f * clamped + 0.5f);
+			}
+
+		} // namespace
+
+		NormalMapBuilder::NormalMapBuilder()
+		: kernel_(Kernel::kSobel)
+		, output_(Output::kRGB8)
+		, strength_(3.0f)
+		, wrap_x_(true)
+		, wrap_y_(true)
+		{
+		}
+		void NormalMapBuilder::set_kernel(Kernel kernel)
+		{
+			kernel_ = kernel;
+		}
+		void NormalMapBuilder::set_strength(float strength)
+		{
+			strength_ = strength;
+		}
+		void NormalMapBuilder::set_wrap(bool wrap_x, bool wrap_y)
+		{
+			wrap_x_ = wrap_x;
+			wrap_y_ = wrap_y;
+		}
+		void NormalMapBuilder::set_output(Output output)
+		{
+			output_ = output;
+		}
+		bool NormalMapBuilder::Build(const Image& height_map, Image * normal_map) const
+		{
+			assert(normal_map != &height_map);
+			if (height_map.pixels() == nullptr || height_map.width() < 1 || height_map.height() < 1)
+				return false;
+			Image::DataType data_type = height_map.data_type();
+			if (data_type != Image::DataType::kUint8 &&
+				data_type != Image::DataType::kUint16 &&
+				data_type != Image::DataType::kFloat)
+			{
+				assert(!"unsupported height map data type");
+				return false;
+			}
+
+			Image::Format format;
+			switch (output_)
+			{
+			case Output::kRG8:
+				format = Image::Format::kRG8;
+				break;
+			case Output::kRGBA8:
+				format = Image::Format::kRGBA8;
+				break;
+			case Output::kRGB8:
+			default:
+				format = Image::Format::kRGB8;
+				break;
+			}
+			normal_map->SetRowOrder(height_map.inverted_row_order());
+			normal_map->Allocate(height_map.width(), height_map.height(), format);
+
+			system::ParallelFor(0, height_map.height(), [this, &height_map, normal_map](int begin, int end)
+			{
+				BuildRows(height_map, normal_map, begin, end);
+			}, 16);
+			return true;
+		}
+		void NormalMapBuilder::LoadRow(const Image& height_map, int row, float * heights) const
+		{
+			// Row has one texel of padding on each side so kernels don't need bounds checks
+			const int width = height_map.width();
+			const int height = height_map.height();
+			if (row < 0)
+				row = (wrap_y_) ? row + height : 0;
+			else if (row >= height)
+				row = (wrap_y_) ? row - height : height - 1;
+
+			const int channels = height_map.channels();
+			const size_t offset = static_cast<size_t>(row) * width * channels;
+			float * dst = heights + 1;
+			switch (height_map.data_type())
+			{
+			case Image::DataType::kUint8:
+			{
+				const float kScale = 1.0f / 255.0f;
+				const u8 * src = height_map.pixels() + offset;
+				for (int x = 0; x < width; ++x)
+					dst[x] = static_cast<float>(src[x * channels]) * kScale;
+				break;
+			}
+			case Image::DataType::kUint16:
+			{
+				const float kScale = 1.0f / 65535.0f;
+				const u16 * src = reinterpret_cast<const u16*>(height_map.pixels()) + offset;
+				for (int x = 0; x < width; ++x)
+					dst[x] = static_cast<float>(src[x * channels]) * kScale;
+				break;
+			}
+			case Image::DataType::kFloat:
+			default:
+			{
+				const float * src = reinterpret_cast<const float*>(height_map.pixels()) + offset;
+				for (int x = 0; x < width; ++x)
+					dst[x] = src[x * channels];
+				break;
+			}
+			}
+			heights[0] = (wrap_x_) ? dst[width - 1] : dst[0];
+			heights[width + 1] = (wrap_x_) ? dst[0] : dst[width - 1];
+		}
+		void NormalMapBuilder::BuildRows(const Image& height_map, Image * normal_map, int begin_row, int end_row) const
+		{
+			const int width = height_map.width();
+			const int padded_width = width + 2;
+
+			std::vector<float> buffer(padded_width * 3 + width * 3);
+			float * rows[3] = { &buffer[0], &buffer[padded_width], &buffer[padded_width * 2] };
+			float * nx = &buffer[padded_width * 3];
+			float * ny = nx + width;
+			float * nz = ny + width;
+
+			// Derivatives of kernels are normalized to the forward difference scale
+			float scale_x, scale_y;
+			switch (kernel_)
+			{
+			case Kernel::kForward:
+				scale_x = scale_y = strength_;
+				break;
+			case Kernel::kCentral:
+				scale_x = scale_y = strength_ * 0.5f;
+				break;
+			case Kernel::kSobel:
+			default:
+				scale_x = scale_y = strength_ * 0.125f;
+				break;
+			}
+
+			LoadRow(height_map, begin_row - 1, rows[0]);
+			LoadRow(height_map, begin_row, rows[1]);
+			const int out_channels = normal_map->channels();
+			for (int y = begin_row; y < end_row; ++y)
+			{
+				LoadRow(height_map, y + 1, rows[2]);
+				// Shift pointers by padding to have valid [-1] and [width] elements
+				const float * prev = rows[0] + 1;
+				const float * curr = rows[1] + 1;
+				const float * next = rows[2] + 1;
+
+				// Signs follow the convention of the original loader: X = -dh/dy, Y = dh/dx
+				switch (kernel_)
+				{
+				case Kernel::kForward:
+					for (int x = 0; x < width; ++x)
+					{
+						nx[x] = (curr[x] - next[x]) * scale_y;
+						ny[x] = (curr[x + 1] - curr[x]) * scale_x;
+					}
+					break;
+				case Kernel::kCentral:
+					for (int x = 0; x < width; ++x)
+					{
+						nx[x] = (prev[x] - next[x]) * scale_y;
+						ny[x] = (curr[x + 1] - curr[x - 1]) * scale_x;
+					}
+					break;
+				case Kernel::kSobel:
+				default:
+					for (int x = 0; x < width; ++x)
+					{
+						float gx = (prev[x + 1] - prev[x - 1]) + 2.0f * (curr[x + 1] - curr[x - 1]) + (next[x + 1] - next[x - 1]);
+						float gy = (next[x - 1] - prev[x - 1]) + 2.0f * (next[x] - prev[x]) + (next[x + 1] - prev[x + 1]);
+						nx[x] = -gy * scale_y;
+						ny[x] = gx * scale_x;
+					}
+					break;
+				}
+				NormalizeRow(nx, ny, nz, width);
+
+				u8 * dst = normal_map->pixels() + static_cast<size_t>(y) * width * out_channels;
+				switch (output_)
+				{
+				case Output::kRG8:
+					for (int x = 0; x < width; ++x, dst += 2)
+					{
+						dst[0] = PackComponent(nx[x]);
+						dst[1] = PackComponent(ny[x]);
+					}
+					break;
+				case Output::kRGBA8:
+					for (int x = 0; x < width; ++x, dst += 4)
+					{
+						dst[0] = PackComponent(nx[x]);
+						dst[1] = PackComponent(ny[x]);
+						dst[2] = PackComponent(nz[x]);
+						dst[3] = PackHeight(curr[x]);
+					}
+					break;
+				case Output::kRGB8:
+				default:
+					for (int x = 0; x < width; ++x, dst += 3)
+					{
+						dst[0] = PackComponent(nx[x]);
+						dst[1] = PackComponent(ny[x]);
+						dst[2] = PackComponent(nz[x]);
+					}
+					break;
+				}
+
+				// Rotate row buffers
+				float * temp = rows[0];
+				rows[0] = rows[1];
+				rows[1] = rows[2];
+				rows[2] = temp;
+			}
+		}
+
+	} // namespace graphics
+} // namespace sht
@@ -0,0 +1,380 @@
+#include "../../include/image/texture_atlas.h"
+#include "../../../system/include/stream/file_stream.h"
+
+#include <algorithm>
+#include <assert.h>
+#include <cstdio>
+#include <cstring>
+
+namespace {
+
+	const u32 kMagic = 0x41544853; // "SHTA"
+	const u32 kVersion = 1;
+
+	struct FileHeader {
+		u32 magic;
+		u32 version;
+		u64 key;				//!< identifies sources
+		u32 format;
+		s32 page_width;
+		s32 page_height;
+		s32 padding;
+		u32 num_pages;
+		u32 num_regions;
+	};
+
+	//! Region record, followed by name characters
+	struct FileRegion {
+		u32 page;
+		s32 x;
+		s32 y;
+		s32 width;
+		s32 height;
+		u32 name_length;
+	};
+
+} // namespace
+
+namespace sht {
+	namespace graphics {
+
+		TextureAtlas::TextureAtlas(int page_width, int page_height, int padding, Image::Format format)
+		: page_width_(page_width)
+		, page_height_(page_height)
+		, padding_(padding)
+		, format_(format)
+		, used_area_(0)
+		{
+			assert(page_width > 0 && page_height > 0 && padding >= 0);
+		}
+		TextureAtlas::~TextureAtlas()
+		{
+			Clear();
+		}
+		int TextureAtlas::Insert(const char* name, const Image& image)
+		{
+			if (image.format() != format_ || name_map_.find(name) != name_map_.end())
+				return -1;
+			const int width = image.width() + 2 * padding_;
+			const int height = image.height() + 2 * padding_;
+			if (width > page_width_ || height > page_height_)
+				return -1;
+
+			// Try existing pages first, the last one is the emptiest
+			int x = 0, y = 0;
+			size_t node_index = 0;
+			Page * target = nullptr;
+			for (auto page : pages_)
+			{
+				if (FindPosition(page, width, height, &x, &y, &node_index))
+				{
+					target = page;
+					break;
+				}
+			}
+			if (target == nullptr)
+			{
+				target = AddPage();
+				bool found = FindPosition(target, width, height, &x, &y, &node_index);
+				assert(found);
+				(void)found;
+			}
+			AddSkylineLevel(target, node_index, x, y, width, height);
+			CopyWithBorder(&target->image, x, y, image);
+			target->dirty = true;
+			used_area_ += static_cast<u64>(width) * height;
+
+			u32 page_index = static_cast<u32>(std::find(pages_.begin(), pages_.end(), target) - pages_.begin());
+			AddRegion(name, page_index, x + padding_, y + padding_, image.width(), image.height());
+			return static_cast<int>(regions_.size()) - 1;
+		}
+		bool TextureAtlas::Build(const std::vector<std::string>& names, const std::vector<const Image*>& images)
+		{
+			assert(names.size() == images.size());
+			std::vector<size_t> order(images.size());
+			for (size_t i = 0; i < order.size(); ++i)
+				order[i] = i;
+			std::stable_sort(order.begin(), order.end(), [&images](size_t a, size_t b) {
+				if (images[a]->height() != images[b]->height())
+					return images[a]->height() > images[b]->height();
+				return images[a]->width() > images[b]->width();
+			});
+			bool result = true;
+			for (auto index : order)
+				if (Insert(names[index].c_str(), *images[index]) < 0)
+					result = false;
+			return result;
+		}
+		void TextureAtlas::Clear()
+		{
+			for (auto page : pages_)
+				delete page;
+			pages_.clear();
+			regions_.clear();
+			names_.clear();
+			name_map_.clear();
+			used_area_ = 0;
+		}
+		int TextureAtlas::Find(const char* name) const
+		{
+			auto it = name_map_.find(name);
+			return (it != name_map_.end()) ? it->second : -1;
+		}
+		const AtlasRegion& TextureAtlas::region(int index) const
+		{
+			assert(index >= 0 && index < static_cast<int>(regions_.size()));
+			return regions_[index];
+		}
+		u32 TextureAtlas::num_regions() const
+		{
+			return static_cast<u32>(regions_.size());
+		}
+		u32 TextureAtlas::num_pages() const
+		{
+			return static_cast<u32>(pages_.size());
+		}
+		const Image& TextureAtlas::page(u32 index) const
+		{
+			assert(index < pages_.size());
+			return pages_[index]->image;
+		}
+		bool TextureAtlas::page_dirty(u32 index) const
+		{
+			assert(index < pages_.size());
+			return pages_[index]->dirty;
+		}
+		void TextureAtlas::ClearDirty()
+		{
+			for (auto page : pages_)
+				page->dirty = false;
+		}
+		f32 TextureAtlas::occupancy() const
+		{
+			if (pages_.empty())
+				return 0.0f;
+			const f32 total_area = static_cast<f32>(pages_.size()) * page_width_ * page_height_;
+			return static_cast<f32>(used_area_) / total_area;
+		}
+		bool TextureAtlas::Save(const char* filename, u64 key) const
+		{
+			system::FileStream stream;
+			if (!stream.Open(filename, system::StreamAccess::kWriteBinary))
+				return false;
+			FileHeader header;
+			header.magic = kMagic;
+			header.version = kVersion;
+			header.key = key;
+			header.format = static_cast<u32>(format_);
+			header.page_width = page_width_;
+			header.page_height = page_height_;
+			header.padding = padding_;
+			header.num_pages = static_cast<u32>(pages_.size());
+			header.num_regions = static_cast<u32>(regions_.size());
+			bool result = stream.Write(&header, sizeof(header));
+			for (size_t i = 0; result && i < pages_.size(); ++i)
+			{
+				const Image& image = pages_[i]->image;
+				result = stream.Write(image.pixels(), static_cast<size_t>(image.width()) * image.height() * image.bpp());
+			}
+			for (size_t i = 0; result && i < regions_.size(); ++i)
+			{
+				FileRegion record;
+				record.page = regions_[i].page;
+				record.x = regions_[i].x;
+				record.y = regions_[i].y;
+				record.width = regions_[i].width;
+				record.height = regions_[i].height;
+				record.name_length = static_cast<u32>(names_[i].size());
+				result = stream.Write(&record, sizeof(record)) &&
+					(record.name_length == 0 || stream.Write(names_[i].c_str(), record.name_length));
+			}
+			stream.Close();
+			if (!result)
+				std::remove(filename);
+			return result;
+		}
+		bool TextureAtlas::Load(const char* filename, u64 key)
+		{
+			system::FileStream stream;
+			if (!stream.Open(filename, system::StreamAccess::kReadBinary))
+				return false;
+			FileHeader header;
+			bool result = stream.Length() >= sizeof(header) && stream.Read(&header, sizeof(header)) &&
+				header.magic == kMagic && header.version == kVersion && header.key == key &&
+				header.page_width > 0 && header.page_height > 0 && header.padding >= 0;
+			if (!result)
+			{
+				stream.Close();
+				return false;
+			}
+			Clear();
+			page_width_ = header.page_width;
+			page_height_ = header.page_height;
+			padding_ = header.padding;
+			format_ = static_cast<Image::Format>(header.format);
+			for (u32 i = 0; result && i < header.num_pages; ++i)
+			{
+				Page * page = AddPage();
+				const Image& image = page->image;
+				result = stream.Read(page->image.pixels(), static_cast<size_t>(image.width()) * image.height() * image.bpp());
+			}
+			std::string name;
+			for (u32 i = 0; result && i < header.num_regions; ++i)
+			{
+				FileRegion record;
+				result = stream.Read(&record, sizeof(record)) && record.page < header.num_pages;
+				if (!result)
+					break;
+				name.resize(record.name_length);
+				result = record.name_length == 0 || stream.Read(&name[0], record.name_length);
+				if (result)
+				{
+					AddRegion(name.c_str(), record.page, record.x, record.y, record.width, record.height);
+					used_area_ += static_cast<u64>(record.width + 2 * padding_) * (record.height + 2 * padding_);
+				}
+			}
+			stream.Close();
+			// Baked atlas is complete, it isn't meant for further insertion
+			for (auto page : pages_)
+			{
+				page->skyline.clear();
+				page->skyline.push_back(SkylineNode{ 0, page_height_, page_width_ });
+			}
+			if (!result)
+				Clear();
+			return result;
+		}
+		int TextureAtlas::page_width() const
+		{
+			return page_width_;
+		}
+		int TextureAtlas::page_height() const
+		{
+			return page_height_;
+		}
+		int TextureAtlas::padding() const
+		{
+			return padding_;
+		}
+		Image::Format TextureAtlas::format() const
+		{
+			return format_;
+		}
+		TextureAtlas::Page * TextureAtlas::AddPage()
+		{
+			Page * page = new Page();
+			page->image.Allocate(page_width_, page_height_, format_);
+			page->image.FillWithZeroes();
+			page->skyline.push_back(SkylineNode{ 0, 0, page_width_ });
+			page->dirty = true;
+			pages_.push_back(page);
+			return page;
+		}
+		bool TextureAtlas::FindPosition(const Page * page, int width, int height, int * x, int * y, size_t * node_index) const
+		{
+			// Bottom-left rule: the lowest top edge, then the narrowest segment
+			int best_top = page_height_ + 1;
+			int best_width = page_width_ + 1;
+			bool found = false;
+			const std::vector<SkylineNode>& skyline = page->skyline;
+			for (size_t i = 0; i < skyline.size(); ++i)
+			{
+				const int left = skyline[i].x;
+				if (left + width > page_width_)
+					break;
+				// Rectangle rests on the highest node it spans
+				int top = 0;
+				int remaining = width;
+				for (size_t j = i; remaining > 0; ++j)
+				{
+					top = std::max(top, skyline[j].y);
+					remaining -= skyline[j].width;
+				}
+				if (top + height > page_height_)
+					continue;
+				if (top + height < best_top || (top + height == best_top && skyline[i].width < best_width))
+				{
+					best_top = top + height;
+					best_width = skyline[i].width;
+					*x = left;
+					*y = top;
+					*node_index = i;
+					found = true;
+				}
+			}
+			return found;
+		}
+		void TextureAtlas::AddSkylineLevel(Page * page, size_t node_index, int x, int y, int width, int height)
+		{
+			std::vector<SkylineNode>& skyline = page->skyline;
+			SkylineNode node = { x, y + height, width };
+			skyline.insert(skyline.begin() + node_index, node);
+
+			// Shrink or remove nodes covered by the new one
+			for (size_t i = node_index + 1; i < skyline.size(); )
+			{
+				const int covered_end = skyline[i - 1].x + skyline[i - 1].width;
+				if (skyline[i].x >= covered_end)
+					break;
+				const int shrink = covered_end - skyline[i].x;
+				if (skyline[i].width <= shrink)
+				{
+					skyline.erase(skyline.begin() + i);
+					continue;
+				}
+				skyline[i].x += shrink;
+				skyline[i].width -= shrink;
+				break;
+			}
+			// Merge neighbours of equal height
+			for (size_t i = 0; i + 1 < skyline.size(); )
+			{
+				if (skyline[i].y == skyline[i + 1].y)
+				{
+					skyline[i].width += skyline[i + 1].width;
+					skyline.erase(skyline.begin() + i + 1);
+				}
+				else
+					++i;
+			}
+		}
+		void TextureAtlas::CopyWithBorder(Image * page, int x, int y, const Image& image)
+		{
+			const int bpp = image.bpp();
+			const int width = image.width();
+			const int height = image.height();
+			const int stride = page->width() * bpp;
+			u8 * pixels = page->pixels();
+			const u8 * source = image.pixels();
+			for (int row = -padding_; row < height + padding_; ++row)
+			{
+				// Border rows replicate the nearest image row
+				const int source_row = std::min(std::max(row, 0), height - 1);
+				const u8 * src = source + static_cast<size_t>(source_row) * width * bpp;
+				u8 * dst = pixels + static_cast<size_t>(y + padding_ + row) * stride + static_cast<size_t>(x) * bpp;
+				for (int i = 0; i < padding_; ++i)
+					memcpy(dst + i * bpp, src, bpp);
+				memcpy(dst + padding_ * bpp, src, static_cast<size_t>(width) * bpp);
+				for (int i = 0; i < padding_; ++i)
+					memcpy(dst + (padding_ + width + i) * bpp, src + (width - 1) * bpp, bpp);
+			}
+		}
+		void TextureAtlas::AddRegion(const char* name, u32 page, int x, int y, int width, int height)
+		{
+			AtlasRegion region;
+			region.page = page;
+			region.x = x;
+			region.y = y;
+			region.width = width;
+			region.height = height;
+			region.u0 = static_cast<f32>(x) / page_width_;
+			region.v0 = static_cast<f32>(y) / page_height_;
+			region.u1 = static_cast<f32>(x + width) / page_width_;
+			region.v1 = static_cast<f32>(y + height) / page_height_;
+			name_map_[name] = static_cast<int>(regions_.size());
+			regions_.push_back(region);
+			names_.push_back(name);
+		}
+
+	} // namespace graphics
+} // namespace sht
@@ -3,9 +3,12 @@
 #include "../../include/model/mesh.h"
 #include "../../include/material.h"
 #include "../../include/renderer/renderer.h"
+#include "../../include/renderer/mesh_pool.h"
 #include "system/include/string/filename.h"
 
+#include <algorithm>
 #include <assert.h>
+#include <cstring>
 
 namespace sht {
 	namespace graphics {
@@ -26,8 +29,15 @@ namespace sht {
 		: renderer_(renderer)
 		, material_binder_(material_binder)
 		, vertex_format_(nullptr)
+		, vertex_compression_(kCompressNone)
+		, scm_file_(nullptr)
+		, scm_compression_(ScmCompression::kNone)
+		, optimization_flags_(kOptimizeDefault)
+		, pool_(nullptr)
 		{
-
+			quantization_.offset = vec3(0.0f);
+			quantization_.scale = 1.0f;
+			memset(&optimization_stats_, 0, sizeof(optimization_stats_));
 		}
 		ComplexMesh::~ComplexMesh()
 		{
@@ -35,6 +45,8 @@ namespace sht {
 			{
 				delete mesh;
 			}
+			if (scm_file_)
+				delete scm_file_;
 			if (vertex_format_)
 				renderer_->DeleteVertexFormat(vertex_format_);
 		}
@@ -74,25 +86,135 @@ namespace sht {
 		{
 			attribs_.push_back(attrib);
 		}
-		bool ComplexMesh::MakeRenderable()
+		void ComplexMesh::set_optimization_flags(u32 flags)
 		{
-			if (attribs_.empty())
+			optimization_flags_ = flags;
+		}
+		void ComplexMesh::Optimize(u32 flags)
+		{
+			UnpackMeshes();
+			memset(&optimization_stats_, 0, sizeof(optimization_stats_));
+			f32 transformed_before = 0.0f;
+			f32 transformed_after = 0.0f;
+			f32 overdraw_before = 0.0f;
+			f32 overdraw_after = 0.0f;
+			for (auto mesh : meshes_)
 			{
-				assert(!"Vertex format hasn't been set.");
+				if (mesh->primitive_mode_ != PrimitiveType::kTriangles || mesh->vertices_.empty())
+					continue;
+				MeshOptimizationStats stats;
+				OptimizeMesh(&mesh->vertices_, &mesh->indices_, flags, &stats);
+				mesh->lods_.clear();
+				optimization_stats_.num_vertices_before += stats.num_vertices_before;
+				optimization_stats_.num_vertices_after += stats.num_vertices_after;
+				optimization_stats_.num_triangles += stats.num_triangles;
+				// Ratios of meshes are weighted by their triangles
+				transformed_before += stats.acmr_before * stats.num_triangles;
+				transformed_after += stats.acmr_after * stats.num_triangles;
+				overdraw_before += stats.overdraw_before * stats.num_triangles;
+				overdraw_after += stats.overdraw_after * stats.num_triangles;
+			}
+			if (optimization_stats_.num_triangles != 0)
+			{
+				const f32 inv_triangles = 1.0f / static_cast<f32>(optimization_stats_.num_triangles);
+				optimization_stats_.acmr_before = transformed_before * inv_triangles;
+				optimization_stats_.acmr_after = transformed_after * inv_triangles;
+				optimization_stats_.overdraw_before = overdraw_before * inv_triangles;
+				optimization_stats_.overdraw_after = overdraw_after * inv_triangles;
+			}
+		}
+		const MeshOptimizationStats& ComplexMesh::optimization_stats() const
+		{
+			return optimization_stats_;
+		}
+		void ComplexMesh::GenerateLods(u32 num_lods, f32 max_relative_error)
+		{
+			UnpackMeshes();
+			for (auto mesh : meshes_)
+				mesh->GenerateLods(num_lods, max_relative_error);
+		}
+		u32 ComplexMesh::num_lods() const
+		{
+			u32 count = 1;
+			for (auto mesh : meshes_)
+				count = std::max(count, mesh->num_lods());
+			return count;
+		}
+		void ComplexMesh::SelectLod(f32 screen_size, f32 max_pixel_error)
+		{
+			const f32 diameter = 2.0f * bounding_box_.extent.Length();
+			if (diameter <= 0.0f)
+				return;
+			for (auto mesh : meshes_)
+				mesh->SelectLod(screen_size / diameter, max_pixel_error);
+		}
+		void ComplexMesh::set_vertex_compression(u32 compression)
+		{
+			vertex_compression_ = compression;
+		}
+		void ComplexMesh::set_scm_compression(ScmCompression compression)
+		{
+			scm_compression_ = compression;
+		}
+		bool ComplexMesh::MakeRenderable()
+		{
+			VertexPacker packer(vertex_compression_);
+			if (!CreateVertexFormat(&packer))
 				return false;
+
+			for (auto mesh : meshes_)
+			{
+				if (!mesh->MakeRenderable(vertex_format_, attribs_, packer))
+					return false;
 			}
-			renderer_->AddVertexFormat(vertex_format_, &attribs_[0], (u32)attribs_.size());
+			if (scm_file_)
+			{
+				delete scm_file_;
+				scm_file_ = nullptr;
+			}
+
+			return true;
+		}
+		bool ComplexMesh::MakeRenderable(MeshPool * pool)
+		{
+			UnpackMeshes();
+			VertexPacker packer(kCompressNone);
+			if (!CreateVertexFormat(&packer))
+				return false;
 
+			pool_ = pool;
+			draw_groups_.clear();
 			for (auto mesh : meshes_)
 			{
-				if (!mesh->MakeRenderable(vertex_format_, attribs_))
+				if (!mesh->MakeRenderable(pool, vertex_format_, attribs_, packer))
 					return false;
+
+				DrawGroup * group = nullptr;
+				for (auto& g : draw_groups_)
+					if (g.material == mesh->material_ && g.mode == mesh->primitive_mode_)
+					{
+						group = &g;
+						break;
+					}
+				if (group == nullptr)
+				{
+					draw_groups_.push_back(DrawGroup());
+					group = &draw_groups_.back();
+					group->material = mesh->material_;
+					group->mode = mesh->primitive_mode_;
+				}
+				group->handles.push_back(mesh->pool_handle_);
 			}
 
 			return true;
 		}
 		void ComplexMesh::Render()
 		{
+			if (pool_)
+			{
+				RenderPooled();
+				return;
+			}
 			for (auto mesh : meshes_)
 			{
 				if (material_binder_)
@@ -100,8 +222,121 @@ namespace sht {
 				mesh->Render();
 			}
 		}
+		void ComplexMesh::Render(const math::Frustum& frustum)
+		{
+			if (pool_ || hierarchy_.empty())
+			{
+				Render();
+				return;
+			}
+			u32 index = 0;
+			while (index < (u32)hierarchy_.size())
+			{
+				const ScmNode& node = hierarchy_[index];
+				if (!frustum.IsBoxIn(node.bounding_box))
+				{
+					index = node.skip;
+					continue;
+				}
+				if (node.mesh >= 0)
+				{
+					Mesh * mesh = meshes_[node.mesh];
+					if (material_binder_)
+						material_binder_->Bind(mesh->material_);
+					mesh->Render();
+				}
+				++index;
+			}
+		}
+		void ComplexMesh::UnpackMeshes()
+		{
+			if (scm_file_ == nullptr)
+				return;
+			for (auto mesh : meshes_)
+				mesh->UnpackVertices(scm_file_->attribs(), scm_file_->vertex_size(), scm_file_->quantization());
+			delete scm_file_;
+			scm_file_ = nullptr;
+		}
+		void ComplexMesh::BuildHierarchy()
+		{
+			std::vector<math::BoundingBox> boxes(meshes_.size());
+			for (size_t i = 0; i < meshes_.size(); ++i)
+				boxes[i] = meshes_[i]->ComputeBoundingBox();
+			BuildScmHierarchy(boxes, &hierarchy_);
+		}
+		bool ComplexMesh::CreateVertexFormat(VertexPacker * packer)
+		{
+			if (scm_file_)
+			{
+				// Stored vertex format is used unless other attributes or formats are requested
+				const std::vector<VertexAttribute>& stored = scm_file_->attribs();
+				if (attribs_.empty())
+					attribs_ = stored;
+				bool same_format = attribs_.size() == stored.size();
+				for (size_t i = 0; i < attribs_.size() && same_format; ++i)
+					same_format = attribs_[i].type == stored[i].type && attribs_[i].size == stored[i].size &&
+						(attribs_[i].format == stored[i].format || attribs_[i].format == VertexAttribute::kFloat);
+				if (same_format)
+				{
+					for (size_t i = 0; i < attribs_.size(); ++i)
+						attribs_[i].format = stored[i].format;
+					quantization_ = scm_file_->quantization();
+					renderer_->AddVertexFormat(vertex_format_, &attribs_[0], (u32)attribs_.size());
+					if (vertex_format_ == nullptr)
+						return false;
+					if (vertex_format_->vertex_size() == scm_file_->vertex_size())
+						return true;
+					renderer_->DeleteVertexFormat(vertex_format_);
+					vertex_format_ = nullptr;
+				}
+				UnpackMeshes();
+			}
+			if (attribs_.empty())
+			{
+				assert(!"Vertex format hasn't been set.");
+				return false;
+			}
+			BuildHierarchy();
+			// Meshes share vertex format, so formats are chosen by ranges of all of them
+			for (auto mesh : meshes_)
+				packer->AddVertices(mesh->vertices_);
+			packer->ChooseFormats(&attribs_);
+			quantization_ = packer->quantization();
+			renderer_->AddVertexFormat(vertex_format_, &attribs_[0], (u32)attribs_.size());
+			return vertex_format_ != nullptr;
+		}
+		void ComplexMesh::RenderPooled()
+		{
+			pool_->Bind();
+			for (const auto& group : draw_groups_)
+			{
+				if (material_binder_)
+					material_binder_->Bind(group.material);
+				pool_->DrawBatch(group.handles.data(), (u32)group.handles.size(), group.mode);
+			}
+			pool_->Unbind();
+		}
+		void ComplexMesh::AttachInstanceBatch(InstanceBatch * batch)
+		{
+			for (auto mesh : meshes_)
+			{
+				mesh->AttachInstanceBatch(batch, (u32)attribs_.size());
+			}
+		}
+		void ComplexMesh::RenderInstanced(u32 num_instances)
+		{
+			if (num_instances == 0)
+				return;
+			for (auto mesh : meshes_)
+			{
+				if (material_binder_)
+					material_binder_->Bind(mesh->material_);
+				mesh->RenderInstanced(num_instances);
+			}
+		}
 		void ComplexMesh::ScaleVertices(const math::Vector3& scale)
 		{
+			UnpackMeshes();
 			for (auto mesh : meshes_)
 			{
 				mesh->ScaleVertices(scale);
@@ -116,6 +351,10 @@ namespace sht {
 		{
 			return bounding_box_;
 		}
+		const VertexQuantization& ComplexMesh::vertex_quantization() const
+		{
+			return quantization_;
+		}
 
 	} // namespace graphics
 } // namespace sht
\ No newline at end of file
@@ -1,152 +1,83 @@
 #include "../../include/model/complex_mesh.h"
 
 #include "../../include/model/mesh.h"
+#include "../../include/model/obj_file.h"
 #include "../../include/material.h"
 
-#include "system/include/stream/log_stream.h"
-#include "system/include/string/filename.h"
-#include "system/include/filesystem/directory.h"
-
-#define TINYOBJLOADER_IMPLEMENTATION
-#include "tiny_obj_loader.h"
-
-#include <map>
-#include <memory>
-#include <cstring>
-#include <assert.h>
-
-#ifdef TINYOBJLOADER_USE_DOUBLE
-	static_assert(false, "disable double precision on tinyobj");
-#endif
+#include <algorithm>
 
 namespace sht {
 	namespace graphics {
 
 		bool ComplexMesh::SaveToFileObj(const char *filename)
 		{
-			assert(!"Haven't been implemented yet");
-			return true;
-		}
-		bool ComplexMesh::LoadFromFileObj(const char *filename)
-		{
-			system::ErrorLogStream * error_log = system::ErrorLogStream::GetInstance();
-
-			tinyobj::attrib_t attrib;
-			std::vector<tinyobj::shape_t> shapes;
-			std::vector<tinyobj::material_t> materials;
-
-			sht::system::Filename fn(filename);
-			std::string base_dir = fn.ExtractPath() + system::GetPathDelimeter();
-
-			std::string err;
-			if (! tinyobj::LoadObj(&attrib, &shapes, &materials, &err, filename, base_dir.c_str(), true))
-			{
-				if (!err.empty())
-					error_log->PrintString("%s\n", err.c_str());
-				error_log->PrintString("can't open %s\n", filename);
-				return false;
-			}
-
-			if (!err.empty())
-				error_log->PrintString("%s\n", err.c_str());
-
-			// Fill materials
-			materials_.resize(materials.size());
-			for (size_t i = 0; i < materials.size(); ++i)
-			{
-				Material& material = materials_[i];
-				const tinyobj::material_t& obj_material = materials[i];
-
-				memcpy(&material.ambient.x, &obj_material.ambient[0], 3 * sizeof(float));
-				memcpy(&material.diffuse.x, &obj_material.diffuse[0], 3 * sizeof(float));
-				memcpy(&material.specular.x, &obj_material.specular[0], 3 * sizeof(float));
-				memcpy(&material.transmittance.x, &obj_material.transmittance[0], 3 * sizeof(float));
-				memcpy(&material.emission.x, &obj_material.emission[0], 3 * sizeof(float));
-				material.shininess = obj_material.shininess;
-				material.dissolve = obj_material.dissolve;
-			}
-
-			math::Vector3 min = math::Vector3(1e8), max = math::Vector3(-1e8);
-
-			// Make unique mesh per material per shape
-			typedef std::map<int, std::unique_ptr<Mesh> > MaterialMap;
-			std::vector< MaterialMap > shape_meshes;
-
-			// Loop over shapes
-			for (const auto& shape : shapes)
+			UnpackMeshes();
+
+			ObjWriter writer;
+			for (const auto& material : materials_)
+				writer.AddMaterial(material);
+			std::vector<std::vector<u32>> strip_indices;
+			strip_indices.reserve(meshes_.size());
+			for (auto mesh : meshes_)
 			{
-				if (shape.mesh.indices.empty())
+				if (mesh->vertices_.empty())
 					continue;
-
-				// Push an empty map at the beginning
-				shape_meshes.push_back(MaterialMap());
-
-				// Loop over faces
-				size_t index_offset = 0;
-				for (size_t f = 0; f < shape.mesh.num_face_vertices.size(); ++f)
+				ObjMeshData data;
+				data.material_index = 0;
+				while ((data.material_index < materials_.size()) && (&materials_[data.material_index] != mesh->material_))
+					++data.material_index;
+				data.vertices = &mesh->vertices_[0];
+				data.num_vertices = static_cast<u32>(mesh->vertices_.size());
+				data.indices = mesh->indices_.empty() ? nullptr : &mesh->indices_[0];
+				data.num_indices = static_cast<u32>(mesh->indices_.size());
+				if (mesh->primitive_mode_ == PrimitiveType::kTriangleStrip)
 				{
-					// Per-face material
-					Mesh * mesh = nullptr;
-					int material_id = shape.mesh.material_ids[f];
-					if (material_id == -1)
-					{
-						error_log->PrintString("some face(s) don't have material(s) in %s\n", filename);
-						return false;
-					}
-					else
+					// Strips are written as lists with every second triangle flipped back
+					const u32 num_corners = mesh->indices_.empty() ? data.num_vertices : data.num_indices;
+					strip_indices.push_back(std::vector<u32>());
+					std::vector<u32>& list = strip_indices.back();
+					for (u32 i = 0; i + 2 < num_corners; ++i)
 					{
-						MaterialMap& materials_map = shape_meshes.back();
-						auto it = materials_map.find(material_id);
-						if (it == materials_map.end())
-						{
-							mesh = new Mesh(renderer_);
-							mesh->primitive_mode_ = PrimitiveType::kTriangles;
-							mesh->material_ = &materials_[material_id];
-							materials_map[material_id].reset(mesh);
-						}
-						else
-							mesh = it->second.get();
+						u32 corners[3] = { i, i + 1, i + 2 };
+						if (i & 1)
+							std::swap(corners[0], corners[1]);
+						for (u32 k = 0; k < 3; ++k)
+							list.push_back(mesh->indices_.empty() ? corners[k] : mesh->indices_[corners[k]]);
 					}
-
-					// Loop over vertices in the face
-					size_t fv = static_cast<size_t>(shape.mesh.num_face_vertices[f]);
-					for (size_t v = 0; v < fv; ++v)
-					{
-						// Access to vertex
-						tinyobj::index_t idx = shape.mesh.indices[index_offset + v];
-						Vertex vertex;
-						if (idx.vertex_index != -1)
-							memcpy(&vertex.position, &attrib.vertices [3*idx.vertex_index  ], 3 * sizeof(float));
-						if (idx.normal_index != -1)
-							memcpy(&vertex.normal,   &attrib.normals  [3*idx.normal_index  ], 3 * sizeof(float));
-						if (idx.texcoord_index != -1)
-							memcpy(&vertex.texcoord, &attrib.texcoords[2*idx.texcoord_index], 2 * sizeof(float));
-
-						min.MakeFloor(vertex.position);
-						max.MakeCeil(vertex.position);
-
-						mesh->vertices_.push_back(vertex);
-						// Indices isn't necessary
-					}
-					index_offset += fv;
+					data.indices = list.empty() ? nullptr : &list[0];
+					data.num_indices = static_cast<u32>(list.size());
 				}
+				else if (mesh->primitive_mode_ != PrimitiveType::kTriangles)
+					continue;
+				writer.AddMesh(data);
 			}
+			return writer.Save(filename);
+		}
+		bool ComplexMesh::LoadFromFileObj(const char *filename)
+		{
+			ObjReader reader;
+			if (!reader.Open(filename))
+				return false;
 
-			bounding_box_.center = 0.5f * (max + min);
-			bounding_box_.extent = 0.5f * (max - min);
+			materials_ = reader.materials();
+			bounding_box_ = reader.bounding_box();
 
-			// Finally fill the meshes
-			for (auto& map : shape_meshes)
+			// Reader gives indexed mesh per material
+			for (auto& obj_mesh : reader.meshes())
 			{
-				for (auto& pair : map)
-				{
-					Mesh * mesh = pair.second.release();
-					meshes_.push_back(mesh);
-				}
+				Mesh * mesh = new Mesh(renderer_);
+				mesh->primitive_mode_ = PrimitiveType::kTriangles;
+				mesh->material_ = &materials_[obj_mesh.material_index];
+				mesh->vertices_.swap(obj_mesh.vertices);
+				mesh->indices_.swap(obj_mesh.indices);
+				meshes_.push_back(mesh);
 			}
 
+			if (optimization_flags_ != kOptimizeNone)
+				Optimize(optimization_flags_);
+
 			return true;
 		}
 
 	} // namespace graphics
-} // namespace sht
\ No newline at end of file
+} // namespace sht
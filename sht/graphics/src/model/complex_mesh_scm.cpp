@@ -2,6 +2,7 @@
 
 #include "../../include/model/mesh.h"
 #include "../../include/material.h"
+#include "../../include/renderer/vertex_packing.h"
 
 #include "system/include/stream/file_stream.h"
 #include "system/include/stream/log_stream.h"
@@ -9,13 +10,14 @@
 #include "utility/include/string_id.h"
 
 namespace {
+	// Version 1 files hold raw vertices and indices, they are only read
 	const uint32_t kSignature = ConstexprStringId("SCM");
 	const uint32_t kVersion = 1;
+	// Optional section after meshes, older readers stop before it
+	const uint32_t kLodSignature = ConstexprStringId("LOD");
 
-	static_assert(sizeof(sht::graphics::Material) == 5 * sizeof(sht::math::Vector3) + 2 * sizeof(float),
-		"material structure has changed, update .scm file version");
 	static_assert(sizeof(sht::graphics::Vertex) == 4 * sizeof(sht::math::Vector3) + sizeof(sht::math::Vector2),
-		"vertex structure has changed, update .scm file version");
+		"vertex structure has changed, version 1 reader should convert vertices");
 }
 
 namespace sht {
@@ -23,51 +25,120 @@ namespace sht {
 
 		bool ComplexMesh::SaveToFileScm(const char *filename)
 		{
-			system::ErrorLogStream * error_log = system::ErrorLogStream::GetInstance();
-			system::FileStream file;
-			if (!file.Open(filename, system::StreamAccess::kWriteBinary))
+			UnpackMeshes();
+
+			// File vertex format is chosen the same way as for rendering
+			std::vector<VertexAttribute> attribs = attribs_;
+			if (attribs.empty())
 			{
-				error_log->PrintString("can't open for write %s\n", filename);
-				return false;
+				attribs.push_back(VertexAttribute(VertexAttribute::kVertex, 3));
+				attribs.push_back(VertexAttribute(VertexAttribute::kNormal, 3));
+				attribs.push_back(VertexAttribute(VertexAttribute::kTexcoord, 2));
+				attribs.push_back(VertexAttribute(VertexAttribute::kTangent, 3));
+				attribs.push_back(VertexAttribute(VertexAttribute::kBinormal, 3));
 			}
-
-			// Write header
-			file.WriteValue(kSignature);
-			file.WriteValue(kVersion);
-
-			// Write bounding box
-			file.Write(&bounding_box_, sizeof(math::BoundingBox));
-
-			// Write materials
-			uint32_t num_materials = static_cast<uint32_t>(materials_.size());
-			file.WriteValue(num_materials);
-			if (num_materials != 0)
-				file.Write(&materials_[0], materials_.size() * sizeof(Material));
-
-			// Write meshes
-			uint32_t num_meshes = static_cast<uint32_t>(meshes_.size());
-			file.WriteValue(num_meshes);
+			VertexPacker packer(vertex_compression_);
+			for (auto mesh : meshes_)
+				packer.AddVertices(mesh->vertices_);
+			packer.ChooseFormats(&attribs);
+			u32 vertex_size = 0;
+			for (const auto& a : attribs)
+				vertex_size += GetAttributeSize(a.format, a.size);
+
+			ScmWriter writer;
+			writer.set_compression(scm_compression_);
+			writer.SetVertexFormat(attribs, vertex_size, packer.quantization());
+			writer.SetBoundingBox(bounding_box_);
+			for (const auto& material : materials_)
+				writer.AddMaterial(material);
 			for (auto mesh : meshes_)
 			{
-				uint32_t material_index = 0;
-				while ((material_index < num_materials) && (&materials_[material_index] != mesh->material_))
-					++material_index;
-				file.WriteValue(material_index);
-				uint32_t primitive_mode = static_cast<uint32_t>(mesh->primitive_mode_);
-				file.WriteValue(primitive_mode);
-				uint32_t num_vertices = static_cast<uint32_t>(mesh->vertices_.size());
-				file.WriteValue(num_vertices);
-				if (num_vertices != 0)
-					file.Write(&mesh->vertices_[0], mesh->vertices_.size() * sizeof(Vertex));
-				uint32_t num_indices = static_cast<uint32_t>(mesh->indices_.size());
-				file.WriteValue(num_indices);
-				if (num_indices != 0)
-					file.Write(&mesh->indices_[0], mesh->indices_.size() * sizeof(uint32_t));
+				mesh->PackArrays(vertex_size, attribs, packer);
+				ScmMesh data;
+				data.material_index = 0;
+				while ((data.material_index < materials_.size()) && (&materials_[data.material_index] != mesh->material_))
+					++data.material_index;
+				data.primitive_mode = static_cast<u32>(mesh->primitive_mode_);
+				data.bounding_box = mesh->ComputeBoundingBox();
+				data.vertices = mesh->vertices_array_;
+				data.num_vertices = mesh->num_vertices_;
+				data.indices = mesh->indices_array_;
+				data.num_indices = 0;
+				data.index_size = mesh->index_size_;
+				for (size_t i = 0; i < mesh->lod_ranges_.size(); ++i)
+				{
+					ScmLod lod;
+					lod.first_index = mesh->lod_ranges_[i].first_index;
+					lod.num_indices = mesh->lod_ranges_[i].num_indices;
+					lod.error = (i == 0) ? 0.0f : mesh->lods_[i - 1].error;
+					lod.reserved = 0;
+					data.lods.push_back(lod);
+					data.num_indices = lod.first_index + lod.num_indices;
+				}
+				writer.AddMesh(data);
+			}
+			bool result = writer.Save(filename);
+			for (auto mesh : meshes_)
+				mesh->FreeArrays();
+			return result;
+		}
+		bool ComplexMesh::LoadFromFileScm(const char *filename)
+		{
+			const u32 version = ScmReader::ReadVersion(filename);
+			if (version == 1)
+				return LoadFromFileScmVersion1(filename);
+
+			scm_file_ = new ScmReader();
+			if (!scm_file_->Open(filename))
+			{
+				delete scm_file_;
+				scm_file_ = nullptr;
+				return false;
+			}
+			bounding_box_ = scm_file_->bounding_box();
+			materials_ = scm_file_->materials();
+			hierarchy_ = scm_file_->hierarchy();
+
+			// Meshes point at file data until they are made renderable
+			const std::vector<ScmMesh>& meshes = scm_file_->meshes();
+			meshes_.resize(meshes.size());
+			for (size_t i = 0; i < meshes.size(); ++i)
+			{
+				const ScmMesh& data = meshes[i];
+				Mesh * mesh = new Mesh(renderer_);
+				meshes_[i] = mesh;
+				mesh->primitive_mode_ = static_cast<PrimitiveType>(data.primitive_mode);
+				mesh->material_ = (data.material_index < materials_.size()) ? &materials_[data.material_index] : nullptr;
+				mesh->packed_vertices_ = data.vertices;
+				mesh->num_vertices_ = data.num_vertices;
+				mesh->packed_indices_ = data.indices;
+				mesh->index_size_ = data.index_size;
+				mesh->index_data_type_ = (data.index_size == sizeof(u32)) ? DataType::kUnsignedInt : DataType::kUnsignedShort;
+				mesh->num_indices_ = data.lods.empty() ? data.num_indices : data.lods[0].num_indices;
+				mesh->lod_ranges_.resize(data.lods.size());
+				for (size_t j = 0; j < data.lods.size(); ++j)
+				{
+					mesh->lod_ranges_[j].first_index = data.lods[j].first_index;
+					mesh->lod_ranges_[j].num_indices = data.lods[j].num_indices;
+				}
+				if (data.indices != nullptr && data.lods.empty())
+				{
+					mesh->lod_ranges_.resize(1);
+					mesh->lod_ranges_[0].first_index = 0;
+					mesh->lod_ranges_[0].num_indices = data.num_indices;
+				}
+				// Coarser levels keep only their errors like renderable meshes do
+				if (data.lods.size() > 1)
+				{
+					mesh->lods_.resize(data.lods.size() - 1);
+					for (size_t j = 1; j < data.lods.size(); ++j)
+						mesh->lods_[j - 1].error = data.lods[j].error;
+				}
 			}
 
 			return true;
 		}
-		bool ComplexMesh::LoadFromFileScm(const char *filename)
+		bool ComplexMesh::LoadFromFileScmVersion1(const char *filename)
 		{
 			system::ErrorLogStream * error_log = system::ErrorLogStream::GetInstance();
 			system::FileStream file;
@@ -130,6 +201,33 @@ namespace sht {
 					file.Read(&mesh->indices_[0], mesh->indices_.size() * sizeof(uint32_t));
 			}
 
+			// Read levels of detail
+			if (file.Tell() < static_cast<long>(file.Length()))
+			{
+				uint32_t section_signature;
+				file.ReadValue(section_signature);
+				if (section_signature != kLodSignature)
+				{
+					error_log->PrintString("unknown section in file (%s)\n", filename);
+					return false;
+				}
+				for (auto mesh : meshes_)
+				{
+					uint32_t num_lods;
+					file.ReadValue(num_lods);
+					mesh->lods_.resize(num_lods);
+					for (auto& lod : mesh->lods_)
+					{
+						file.ReadValue(lod.error);
+						uint32_t num_indices;
+						file.ReadValue(num_indices);
+						lod.indices.resize(num_indices);
+						if (num_indices != 0)
+							file.Read(&lod.indices[0], lod.indices.size() * sizeof(uint32_t));
+					}
+				}
+			}
+
 			return true;
 		}
 
@@ -1,6 +1,12 @@
 #include "../../include/model/mesh.h"
 
 #include "../../include/material.h"
+#include "../../include/renderer/instance_batch.h"
+#include "../../include/renderer/mesh_pool.h"
+#include "../../include/renderer/vertex_packing.h"
+
+#include <algorithm>
+#include <cmath>
 
 namespace sht {
 	namespace graphics {
@@ -12,11 +18,16 @@ namespace sht {
 		, vertex_buffer_(nullptr)
 		, index_buffer_(nullptr)
 		, vertex_array_object_(0)
+		, pool_(nullptr)
+		, pool_handle_(MeshPool::kInvalidHandle)
 		, num_vertices_(0)
 		, vertices_array_(nullptr)
 		, num_indices_(0)
 		, index_size_(0)
 		, indices_array_(nullptr)
+		, packed_vertices_(nullptr)
+		, packed_indices_(nullptr)
+		, lod_(0)
 		{
 			
 		}
@@ -28,6 +39,8 @@ namespace sht {
 				renderer_->DeleteIndexBuffer(index_buffer_);
 			if (vertex_array_object_)
 				renderer_->context()->DeleteVertexArrayObject(vertex_array_object_);
+			if (pool_handle_ != MeshPool::kInvalidHandle)
+				pool_->Remove(pool_handle_);
 			FreeArrays();
 		}
 		void Mesh::FreeArrays()
@@ -43,85 +56,180 @@ namespace sht {
 				indices_array_ = nullptr;
 			}
 		}
-		void Mesh::TransformVertices(VertexFormat * vertex_format, const std::vector<VertexAttribute>& attribs)
+		void Mesh::PackArrays(u32 vertex_size, const std::vector<VertexAttribute>& attribs, const VertexPacker& packer)
 		{
 			num_vertices_ = (u32)vertices_.size();
-			vertices_array_ = new u8[num_vertices_ * vertex_format->vertex_size()];
-			u8 *ptr = vertices_array_;
-			for (auto &v : vertices_)
+			vertices_array_ = new u8[num_vertices_ * vertex_size];
+			packer.Pack(vertices_, attribs, vertex_size, vertices_array_);
+			
+			num_indices_ = (u32)indices_.size();
+			lod_ranges_.clear();
+			if (!indices_.empty())
+			{
+				// Levels of detail follow full detail indices in the same buffer
+				lod_ranges_.resize(lods_.size() + 1);
+				lod_ranges_[0].first_index = 0;
+				lod_ranges_[0].num_indices = num_indices_;
+				u32 total_indices = num_indices_;
+				for (size_t i = 0; i < lods_.size(); ++i)
+				{
+					lod_ranges_[i + 1].first_index = total_indices;
+					lod_ranges_[i + 1].num_indices = (u32)lods_[i].indices.size();
+					total_indices += lod_ranges_[i + 1].num_indices;
+				}
+				// Short indices address up to 65536 vertices
+				if (num_vertices_ > 0x10000)
+				{
+					index_size_ = sizeof(u32);
+					index_data_type_ = DataType::kUnsignedInt;
+				}
+				else
+				{
+					index_size_ = sizeof(u16);
+					index_data_type_ = DataType::kUnsignedShort;
+				}
+				indices_array_ = new u8[total_indices * index_size_];
+				for (size_t level = 0; level < lod_ranges_.size(); ++level)
+				{
+					const std::vector<u32>& source = (level == 0) ? indices_ : lods_[level - 1].indices;
+					if (index_size_ == sizeof(u32))
+					{
+						u32 *indices = reinterpret_cast<u32*>(indices_array_) + lod_ranges_[level].first_index;
+						for (size_t i = 0; i < source.size(); ++i)
+						{
+							indices[i] = static_cast<u32>(source[i]);
+						}
+					}
+					else
+					{
+						u16 *indices = reinterpret_cast<u16*>(indices_array_) + lod_ranges_[level].first_index;
+						for (size_t i = 0; i < source.size(); ++i)
+						{
+							indices[i] = static_cast<u16>(source[i]);
+						}
+					}
+				}
+			}
+		}
+		void Mesh::TransformVertices(VertexFormat * vertex_format, const std::vector<VertexAttribute>& attribs,
+			const VertexPacker& packer)
+		{
+			PackArrays(vertex_format->vertex_size(), attribs, packer);
+			vertices_.clear();
+			vertices_.shrink_to_fit();
+			indices_.clear();
+			indices_.shrink_to_fit();
+			for (auto& lod : lods_)
 			{
-				for (auto &a : attribs)
+				lod.indices.clear();
+				lod.indices.shrink_to_fit();
+			}
+		}
+		void Mesh::UnpackVertices(const std::vector<VertexAttribute>& attribs, u32 vertex_size,
+			const VertexQuantization& quantization)
+		{
+			if (packed_vertices_ == nullptr)
+				return;
+			vertices_.resize(num_vertices_);
+			const u8 * ptr = packed_vertices_;
+			for (auto& v : vertices_)
+			{
+				v = Vertex();
+				const u8 * attrib_ptr = ptr;
+				for (const auto& a : attribs)
 				{
+					// Components beyond attribute size stay zero
+					f32 values[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+					UnpackAttribute(a.format, attrib_ptr, a.size, values);
+					const vec3 value(values[0], values[1], values[2]);
 					switch (a.type)
 					{
 					case VertexAttribute::kVertex:
-						memcpy(ptr, v.position, sizeof(v.position));
+						v.position = value;
+						if (IsAttributeNormalized(a.format))
+							v.position = v.position * quantization.scale + quantization.offset;
 						break;
 					case VertexAttribute::kNormal:
-						memcpy(ptr, v.normal, sizeof(v.normal));
+						v.normal = value;
 						break;
 					case VertexAttribute::kTexcoord:
-						memcpy(ptr, v.texcoord, sizeof(v.texcoord));
+						v.texcoord = vec2(values[0], values[1]);
 						break;
 					case VertexAttribute::kTangent:
-						memcpy(ptr, v.tangent, sizeof(v.tangent));
+						v.tangent = value;
 						break;
 					case VertexAttribute::kBinormal:
-						memcpy(ptr, v.binormal, sizeof(v.binormal));
+						v.binormal = value;
 						break;
 					default:
-						assert(!"Unknown vertex attribute");
+						break;
 					}
-					ptr += a.size * sizeof(float);
+					attrib_ptr += GetAttributeSize(a.format, a.size);
 				}
+				ptr += vertex_size;
 			}
-			vertices_.clear();
-			vertices_.shrink_to_fit();
-			
-			if (!indices_.empty())
+			for (size_t level = 0; level < lod_ranges_.size(); ++level)
 			{
-				num_indices_ = (u32)indices_.size();
-				if (num_indices_ > 0xffff)
+				std::vector<u32>& target = (level == 0) ? indices_ : lods_[level - 1].indices;
+				target.resize(lod_ranges_[level].num_indices);
+				for (size_t i = 0; i < target.size(); ++i)
 				{
-					index_size_ = sizeof(u32);
-					index_data_type_ = DataType::kUnsignedInt;
-					indices_array_ = new u8[num_indices_ * index_size_];
-					u32 *indices = reinterpret_cast<u32*>(indices_array_);
-					for (size_t i = 0; i < indices_.size(); ++i)
-					{
-						indices[i] = static_cast<u32>(indices_[i]);
-					}
+					const size_t index = lod_ranges_[level].first_index + i;
+					if (index_size_ == sizeof(u32))
+						target[i] = reinterpret_cast<const u32*>(packed_indices_)[index];
+					else
+						target[i] = reinterpret_cast<const u16*>(packed_indices_)[index];
 				}
-				else
-				{
-					index_size_ = sizeof(u16);
-					index_data_type_ = DataType::kUnsignedShort;
-					indices_array_ = new u8[num_indices_ * index_size_];
-					u16 *indices = reinterpret_cast<u16*>(indices_array_);
-					for (size_t i = 0; i < indices_.size(); ++i)
-					{
-						indices[i] = static_cast<u16>(indices_[i]);
-					}
-				}
-				indices_.clear();
-				indices_.shrink_to_fit();
 			}
+			packed_vertices_ = nullptr;
+			packed_indices_ = nullptr;
+			lod_ranges_.clear();
 		}
-		bool Mesh::MakeRenderable(VertexFormat * vertex_format, const std::vector<VertexAttribute>& attribs)
+		math::BoundingBox Mesh::ComputeBoundingBox() const
 		{
-			const bool have_indices = !indices_.empty();
+			math::BoundingBox box;
+			box.center = vec3(0.0f);
+			box.extent = vec3(0.0f);
+			if (vertices_.empty())
+				return box;
+			vec3 min = vertices_[0].position;
+			vec3 max = vertices_[0].position;
+			for (const auto& v : vertices_)
+			{
+				min.MakeFloor(v.position);
+				max.MakeCeil(v.position);
+			}
+			box.center = 0.5f * (max + min);
+			box.extent = 0.5f * (max - min);
+			return box;
+		}
+		bool Mesh::MakeRenderable(VertexFormat * vertex_format, const std::vector<VertexAttribute>& attribs,
+			const VertexPacker& packer)
+		{
+			const bool have_indices = !indices_.empty() || packed_indices_ != nullptr;
 
-			TransformVertices(vertex_format, attribs);
+			// Data loaded in vertex format is used as is
+			const u8 * vertices = packed_vertices_;
+			const u8 * indices = packed_indices_;
+			if (vertices == nullptr)
+			{
+				TransformVertices(vertex_format, attribs, packer);
+				vertices = vertices_array_;
+				indices = indices_array_;
+			}
 			
 			renderer_->context()->GenVertexArrayObject(vertex_array_object_);
 			renderer_->context()->BindVertexArrayObject(vertex_array_object_);
 			
-			renderer_->AddVertexBuffer(vertex_buffer_, num_vertices_ * vertex_format->vertex_size(), vertices_array_, BufferUsage::kStaticDraw);
+			renderer_->AddVertexBuffer(vertex_buffer_, num_vertices_ * vertex_format->vertex_size(), const_cast<u8*>(vertices),
+				BufferUsage::kStaticDraw);
 			if (vertex_buffer_ == nullptr) return false;
 			
 			if (have_indices)
 			{
-				renderer_->AddIndexBuffer(index_buffer_, num_indices_, index_size_, indices_array_, BufferUsage::kStaticDraw);
+				const LodRange& last = lod_ranges_.back();
+				renderer_->AddIndexBuffer(index_buffer_, last.first_index + last.num_indices, index_size_, const_cast<u8*>(indices),
+					BufferUsage::kStaticDraw);
 				if (index_buffer_ == nullptr) return false;
 			}
 			
@@ -129,29 +237,79 @@ namespace sht {
 			for (u32 i = 0; i < attribs.size(); ++i)
 			{
 				const VertexFormat::Attrib& generic = vertex_format->generic(i);
-				renderer_->context()->VertexAttribPointer(i, generic.size, DataType::kFloat, vertex_format->vertex_size(), base + generic.offset);
+				renderer_->context()->VertexAttribPointer(i, generic.size, GetAttributeDataType(generic.format),
+					vertex_format->vertex_size(), base + generic.offset, IsAttributeNormalized(generic.format));
 				renderer_->context()->EnableVertexAttribArray(i);
 			}
 			
 			renderer_->context()->BindVertexArrayObject(0);
 			
 			FreeArrays();
+			packed_vertices_ = nullptr;
+			packed_indices_ = nullptr;
 			
 			return true;
 		}
+		bool Mesh::MakeRenderable(MeshPool * pool, VertexFormat * vertex_format, const std::vector<VertexAttribute>& attribs,
+			const VertexPacker& packer)
+		{
+			assert(pool->vertex_size() == vertex_format->vertex_size());
+			assert(packed_vertices_ == nullptr && "Pool has its own vertex format");
+			const bool have_indices = !indices_.empty();
+
+			TransformVertices(vertex_format, attribs, packer);
+
+			pool_ = pool;
+			pool_handle_ = pool->Add(vertices_array_, num_vertices_, have_indices ? indices_array_ : nullptr,
+				num_indices_, index_data_type_);
+
+			FreeArrays();
+
+			return pool_handle_ != MeshPool::kInvalidHandle;
+		}
 		void Mesh::Render()
 		{
+			if (pool_)
+			{
+				pool_->Bind();
+				pool_->Draw(pool_handle_, primitive_mode_);
+				pool_->Unbind();
+				return;
+			}
 			renderer_->context()->BindVertexArrayObject(vertex_array_object_);
 			if (index_buffer_ == nullptr)
 				renderer_->context()->DrawArrays(primitive_mode_, 0, num_vertices_);
-			else
+			else if (lod_ == 0)
 				renderer_->context()->DrawElements(primitive_mode_, num_indices_, index_data_type_);
+			else
+				renderer_->context()->DrawElementsBaseVertex(primitive_mode_, lod_ranges_[lod_].num_indices,
+					index_data_type_, lod_ranges_[lod_].first_index, 0);
+			renderer_->context()->BindVertexArrayObject(0);
+		}
+		void Mesh::AttachInstanceBatch(InstanceBatch * batch, u32 first_location)
+		{
+			assert(pool_ == nullptr && "Pooled meshes share vertex array object");
+			renderer_->context()->BindVertexArrayObject(vertex_array_object_);
+			batch->Attach(first_location);
+			renderer_->context()->BindVertexArrayObject(0);
+		}
+		void Mesh::RenderInstanced(u32 num_instances)
+		{
+			renderer_->context()->BindVertexArrayObject(vertex_array_object_);
+			if (index_buffer_ == nullptr)
+				renderer_->context()->DrawArraysInstanced(primitive_mode_, 0, num_vertices_, num_instances);
+			else
+				renderer_->context()->DrawElementsInstanced(primitive_mode_, num_indices_, index_data_type_, num_instances);
 			renderer_->context()->BindVertexArrayObject(0);
 		}
 		void Mesh::ScaleVertices(const math::Vector3& scale)
 		{
 			for (auto& v : vertices_)
 				v.position *= scale;
+			// Errors are kept for the most stretched axis
+			const f32 max_scale = std::max(fabsf(scale.x), std::max(fabsf(scale.y), fabsf(scale.z)));
+			for (auto& lod : lods_)
+				lod.error *= max_scale;
 		}
 		void Mesh::ScaleTexcoord(const math::Vector2& scale)
 		{
@@ -159,5 +317,28 @@ namespace sht {
 				v.texcoord *= scale;
 		}
 
+		void Mesh::GenerateLods(u32 num_lods, f32 max_relative_error)
+		{
+			if (primitive_mode_ != PrimitiveType::kTriangles || indices_.empty())
+				return;
+			graphics::GenerateLods(vertices_, indices_, num_lods, max_relative_error, &lods_);
+		}
+		u32 Mesh::num_lods() const
+		{
+			return (u32)lods_.size() + 1;
+		}
+		void Mesh::set_lod(u32 lod)
+		{
+			lod_ = std::min(lod, (u32)lods_.size());
+		}
+		u32 Mesh::lod() const
+		{
+			return lod_;
+		}
+		void Mesh::SelectLod(f32 pixels_per_unit, f32 max_pixel_error)
+		{
+			lod_ = graphics::SelectLod(lods_, pixels_per_unit, max_pixel_error);
+		}
+
 	} // namespace graphics
 } // namespace sht
\ No newline at end of file
@@ -0,0 +1,439 @@
+#include "../../include/model/mesh_optimizer.h"
+
+#include <algorithm>
+#include <assert.h>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <unordered_set>
+
+namespace {
+
+	using sht::graphics::Vertex;
+
+	//! Hashes vertex bytes, so only bitwise equal vertices are merged
+	struct VertexHasher {
+		const Vertex * vertices;
+
+		size_t operator()(u32 index) const
+		{
+			const u8 * bytes = reinterpret_cast<const u8*>(&vertices[index]);
+			u32 hash = 2166136261u; // 32-bit FNV-1a
+			for (size_t i = 0; i < sizeof(Vertex); ++i)
+			{
+				hash ^= bytes[i];
+				hash *= 16777619u;
+			}
+			return hash;
+		}
+	};
+	struct VertexEqual {
+		const Vertex * vertices;
+
+		bool operator()(u32 a, u32 b) const
+		{
+			return memcmp(&vertices[a], &vertices[b], sizeof(Vertex)) == 0;
+		}
+	};
+
+	// Forsyth's scoring constants
+	const int kCacheSize = 32;
+	const float kLastTriangleScore = 0.75f;
+	const float kCacheDecayPower = 1.5f;
+	const float kValenceBoostScale = 2.0f;
+	const float kValenceBoostPower = 0.5f;
+
+	float VertexScore(int cache_position, u32 remaining_triangles)
+	{
+		if (remaining_triangles == 0)
+			return -1.0f; // vertex won't be used anymore
+		float score = 0.0f;
+		if (cache_position >= 0)
+		{
+			if (cache_position < 3)
+				score = kLastTriangleScore; // vertices of the last triangle get fixed score
+			else
+			{
+				const float scaler = 1.0f / static_cast<float>(kCacheSize - 3);
+				score = powf(1.0f - static_cast<float>(cache_position - 3) * scaler, kCacheDecayPower);
+			}
+		}
+		// Vertices with few triangles left are preferred, so they are finished soon
+		score += kValenceBoostScale * powf(static_cast<float>(remaining_triangles), -kValenceBoostPower);
+		return score;
+	}
+
+	sht::math::Vector3 TriangleNormal(const Vertex& a, const Vertex& b, const Vertex& c)
+	{
+		return (b.position - a.position) ^ (c.position - a.position);
+	}
+
+} // namespace
+
+namespace sht {
+	namespace graphics {
+
+		u32 WeldVertices(std::vector<Vertex> * vertices, std::vector<u32> * indices)
+		{
+			if (vertices->empty())
+				return 0;
+			if (indices->empty())
+			{
+				indices->resize(vertices->size());
+				for (size_t i = 0; i < indices->size(); ++i)
+					(*indices)[i] = static_cast<u32>(i);
+			}
+			const u32 num_vertices = static_cast<u32>(vertices->size());
+			VertexHasher hasher = { &(*vertices)[0] };
+			VertexEqual equal = { &(*vertices)[0] };
+			std::unordered_set<u32, VertexHasher, VertexEqual> unique(num_vertices, hasher, equal);
+
+			// First occurrence of each vertex becomes its representative
+			std::vector<u32> remap(num_vertices);
+			u32 num_unique = 0;
+			for (u32 i = 0; i < num_vertices; ++i)
+			{
+				auto result = unique.insert(i);
+				remap[i] = result.second ? num_unique++ : remap[*result.first];
+			}
+			std::vector<Vertex> welded(num_unique);
+			for (u32 i = 0; i < num_vertices; ++i)
+				welded[remap[i]] = (*vertices)[i];
+			vertices->swap(welded);
+			for (auto& index : *indices)
+				index = remap[index];
+			return num_unique;
+		}
+		void OptimizeVertexCache(u32 * indices, size_t num_indices, u32 num_vertices)
+		{
+			assert(num_indices % 3 == 0);
+			const size_t num_triangles = num_indices / 3;
+			if (num_triangles == 0)
+				return;
+
+			// Triangles adjacent to every vertex
+			std::vector<u32> offsets(num_vertices + 1, 0);
+			for (size_t i = 0; i < num_indices; ++i)
+				++offsets[indices[i] + 1];
+			for (u32 i = 0; i < num_vertices; ++i)
+				offsets[i + 1] += offsets[i];
+			std::vector<u32> adjacency(num_indices);
+			std::vector<u32> remaining(num_vertices, 0);	//!< triangles not emitted yet
+			for (size_t i = 0; i < num_indices; ++i)
+			{
+				const u32 v = indices[i];
+				adjacency[offsets[v] + remaining[v]++] = static_cast<u32>(i / 3);
+			}
+
+			std::vector<int> cache_position(num_vertices, -1);
+			std::vector<float> vertex_score(num_vertices);
+			for (u32 i = 0; i < num_vertices; ++i)
+				vertex_score[i] = VertexScore(-1, remaining[i]);
+
+			std::vector<u8> emitted(num_triangles, 0);
+			std::vector<u32> result;
+			result.reserve(num_indices);
+			u32 cache[kCacheSize + 3];
+			int cache_count = 0;
+			size_t input_cursor = 0;
+			int best_triangle = 0;
+
+			for (size_t n = 0; n < num_triangles; ++n)
+			{
+				if (best_triangle < 0)
+				{
+					// Dead end, continue with the next triangle in original order
+					while (emitted[input_cursor])
+						++input_cursor;
+					best_triangle = static_cast<int>(input_cursor);
+				}
+				const u32 * triangle = &indices[3 * best_triangle];
+				emitted[best_triangle] = 1;
+				result.insert(result.end(), triangle, triangle + 3);
+
+				// Remove triangle from adjacency of its vertices
+				for (int k = 0; k < 3; ++k)
+				{
+					const u32 v = triangle[k];
+					u32 * list = &adjacency[offsets[v]];
+					for (u32 i = 0; i < remaining[v]; ++i)
+						if (list[i] == static_cast<u32>(best_triangle))
+						{
+							list[i] = list[remaining[v] - 1];
+							break;
+						}
+					--remaining[v];
+				}
+
+				// Triangle vertices go to the front of LRU cache
+				u32 new_cache[kCacheSize + 3];
+				int new_count = 0;
+				for (int k = 0; k < 3; ++k)
+					new_cache[new_count++] = triangle[k];
+				for (int i = 0; i < cache_count; ++i)
+				{
+					const u32 v = cache[i];
+					if (v != triangle[0] && v != triangle[1] && v != triangle[2])
+						new_cache[new_count++] = v;
+				}
+				// Evicted vertices lose cache score
+				for (int i = kCacheSize; i < new_count; ++i)
+				{
+					cache_position[new_cache[i]] = -1;
+					vertex_score[new_cache[i]] = VertexScore(-1, remaining[new_cache[i]]);
+				}
+				cache_count = std::min(new_count, kCacheSize);
+				memcpy(cache, new_cache, cache_count * sizeof(u32));
+				for (int i = 0; i < cache_count; ++i)
+				{
+					cache_position[cache[i]] = i;
+					vertex_score[cache[i]] = VertexScore(i, remaining[cache[i]]);
+				}
+
+				// Best next triangle is adjacent to cached vertices
+				best_triangle = -1;
+				float best_score = -FLT_MAX;
+				for (int i = 0; i < cache_count; ++i)
+				{
+					const u32 v = cache[i];
+					const u32 * list = &adjacency[offsets[v]];
+					for (u32 j = 0; j < remaining[v]; ++j)
+					{
+						const u32 t = list[j];
+						const float score = vertex_score[indices[3*t]] + vertex_score[indices[3*t+1]] + vertex_score[indices[3*t+2]];
+						if (score > best_score)
+						{
+							best_score = score;
+							best_triangle = static_cast<int>(t);
+						}
+					}
+				}
+			}
+			memcpy(indices, &result[0], num_indices * sizeof(u32));
+		}
+		void OptimizeOverdraw(const std::vector<Vertex>& vertices, u32 * indices, size_t num_indices)
+		{
+			assert(num_indices % 3 == 0);
+			const size_t num_triangles = num_indices / 3;
+			if (num_triangles == 0)
+				return;
+
+			// Cluster starts at the triangle whose vertices all miss the cache
+			const u32 cache_size = 16;
+			std::vector<u32> timestamps(vertices.size(), 0);
+			u32 time = cache_size + 1;
+			std::vector<size_t> cluster_starts;
+			for (size_t t = 0; t < num_triangles; ++t)
+			{
+				int misses = 0;
+				for (int k = 0; k < 3; ++k)
+				{
+					const u32 v = indices[3 * t + k];
+					if (time - timestamps[v] > cache_size)
+					{
+						timestamps[v] = time++;
+						++misses;
+					}
+				}
+				if (t == 0 || misses == 3)
+					cluster_starts.push_back(t);
+			}
+			cluster_starts.push_back(num_triangles);
+			const size_t num_clusters = cluster_starts.size() - 1;
+			if (num_clusters < 2)
+				return;
+
+			// Area weighted centers of mesh and clusters
+			struct Cluster {
+				size_t begin;
+				size_t end;
+				f32 sort_key;
+			};
+			std::vector<Cluster> clusters(num_clusters);
+			std::vector<math::Vector3> centers(num_clusters);
+			std::vector<math::Vector3> normals(num_clusters);
+			math::Vector3 mesh_center(0.0f);
+			f32 mesh_area = 0.0f;
+			for (size_t c = 0; c < num_clusters; ++c)
+			{
+				math::Vector3 center(0.0f), normal(0.0f);
+				f32 area = 0.0f;
+				for (size_t t = cluster_starts[c]; t < cluster_starts[c + 1]; ++t)
+				{
+					const Vertex& a = vertices[indices[3 * t + 0]];
+					const Vertex& b = vertices[indices[3 * t + 1]];
+					const Vertex& d = vertices[indices[3 * t + 2]];
+					const math::Vector3 n = TriangleNormal(a, b, d);
+					const f32 triangle_area = n.Length();
+					center += (triangle_area / 3.0f) * (a.position + b.position + d.position);
+					normal += n;
+					area += triangle_area;
+				}
+				mesh_center += center;
+				mesh_area += area;
+				centers[c] = (area > 0.0f) ? center / area : vertices[indices[3 * cluster_starts[c]]].position;
+				normals[c] = normal;
+				clusters[c].begin = cluster_starts[c];
+				clusters[c].end = cluster_starts[c + 1];
+			}
+			if (mesh_area > 0.0f)
+				mesh_center /= mesh_area;
+			for (size_t c = 0; c < num_clusters; ++c)
+			{
+				const f32 length = normals[c].Length();
+				clusters[c].sort_key = (length > 0.0f) ? ((centers[c] - mesh_center) & normals[c]) / length : 0.0f;
+			}
+			std::stable_sort(clusters.begin(), clusters.end(), [](const Cluster& a, const Cluster& b) {
+				return a.sort_key > b.sort_key;
+			});
+
+			std::vector<u32> result;
+			result.reserve(num_indices);
+			for (const auto& cluster : clusters)
+				result.insert(result.end(), indices + 3 * cluster.begin, indices + 3 * cluster.end);
+			memcpy(indices, &result[0], num_indices * sizeof(u32));
+		}
+		u32 OptimizeVertexFetch(std::vector<Vertex> * vertices, std::vector<u32> * indices)
+		{
+			const u32 kUnused = 0xffffffff;
+			std::vector<u32> remap(vertices->size(), kUnused);
+			std::vector<Vertex> ordered;
+			ordered.reserve(vertices->size());
+			for (auto& index : *indices)
+			{
+				if (remap[index] == kUnused)
+				{
+					remap[index] = static_cast<u32>(ordered.size());
+					ordered.push_back((*vertices)[index]);
+				}
+				index = remap[index];
+			}
+			vertices->swap(ordered);
+			return static_cast<u32>(vertices->size());
+		}
+		f32 AnalyzeVertexCache(const u32 * indices, size_t num_indices, u32 num_vertices, u32 cache_size)
+		{
+			if (num_indices < 3)
+				return 0.0f;
+			// Vertex is in FIFO cache if fewer than cache_size vertices were loaded after it
+			std::vector<u32> timestamps(num_vertices, 0);
+			u32 time = cache_size + 1;
+			u32 misses = 0;
+			for (size_t i = 0; i < num_indices; ++i)
+			{
+				const u32 v = indices[i];
+				if (time - timestamps[v] > cache_size)
+				{
+					timestamps[v] = time++;
+					++misses;
+				}
+			}
+			return static_cast<f32>(misses) / static_cast<f32>(num_indices / 3);
+		}
+		f32 AnalyzeOverdraw(const std::vector<Vertex>& vertices, const u32 * indices, size_t num_indices)
+		{
+			const int kResolution = 256;
+			if (num_indices < 3 || vertices.empty())
+				return 0.0f;
+			math::Vector3 min_position(FLT_MAX), max_position(-FLT_MAX);
+			for (const auto& v : vertices)
+			{
+				min_position.MakeFloor(v.position);
+				max_position.MakeCeil(v.position);
+			}
+			const math::Vector3 extent = max_position - min_position;
+			const f32 max_extent = std::max(extent.x, std::max(extent.y, extent.z));
+			if (max_extent <= 0.0f)
+				return 0.0f;
+			const f32 scale = static_cast<f32>(kResolution - 1) / max_extent;
+
+			std::vector<f32> depth(kResolution * kResolution);
+			u64 covered = 0;
+			u64 shaded = 0;
+			for (int axis = 0; axis < 3; ++axis)
+			for (int direction = -1; direction <= 1; direction += 2)
+			{
+				const int axis_u = (axis + 1) % 3;
+				const int axis_v = (axis + 2) % 3;
+				std::fill(depth.begin(), depth.end(), FLT_MAX);
+				for (size_t i = 0; i + 2 < num_indices; i += 3)
+				{
+					const Vertex * tri[3] = { &vertices[indices[i]], &vertices[indices[i + 1]], &vertices[indices[i + 2]] };
+					// Viewer looks along the axis in given direction
+					const math::Vector3 normal = TriangleNormal(*tri[0], *tri[1], *tri[2]);
+					if (normal[axis] * static_cast<f32>(direction) >= 0.0f)
+						continue;
+					f32 x[3], y[3], z[3];
+					for (int k = 0; k < 3; ++k)
+					{
+						x[k] = (tri[k]->position[axis_u] - min_position[axis_u]) * scale;
+						y[k] = (tri[k]->position[axis_v] - min_position[axis_v]) * scale;
+						z[k] = tri[k]->position[axis] * static_cast<f32>(direction);
+					}
+					f32 area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+					if (area == 0.0f)
+						continue;
+					const f32 sign = (area > 0.0f) ? 1.0f : -1.0f;
+					const int min_x = std::max(0, static_cast<int>(floorf(std::min(x[0], std::min(x[1], x[2])))));
+					const int max_x = std::min(kResolution - 1, static_cast<int>(ceilf(std::max(x[0], std::max(x[1], x[2])))));
+					const int min_y = std::max(0, static_cast<int>(floorf(std::min(y[0], std::min(y[1], y[2])))));
+					const int max_y = std::min(kResolution - 1, static_cast<int>(ceilf(std::max(y[0], std::max(y[1], y[2])))));
+					for (int py = min_y; py <= max_y; ++py)
+					for (int px = min_x; px <= max_x; ++px)
+					{
+						const f32 cx = static_cast<f32>(px) + 0.5f;
+						const f32 cy = static_cast<f32>(py) + 0.5f;
+						const f32 w0 = sign * ((x[2] - x[1]) * (cy - y[1]) - (y[2] - y[1]) * (cx - x[1]));
+						const f32 w1 = sign * ((x[0] - x[2]) * (cy - y[2]) - (y[0] - y[2]) * (cx - x[2]));
+						const f32 w2 = sign * ((x[1] - x[0]) * (cy - y[0]) - (y[1] - y[0]) * (cx - x[0]));
+						if (w0 < 0.0f || w1 < 0.0f || w2 < 0.0f)
+							continue;
+						const f32 pixel_depth = (w0 * z[0] + w1 * z[1] + w2 * z[2]) / (w0 + w1 + w2);
+						f32& stored = depth[py * kResolution + px];
+						if (pixel_depth < stored)
+						{
+							if (stored == FLT_MAX)
+								++covered;
+							stored = pixel_depth;
+							++shaded;
+						}
+					}
+				}
+			}
+			return (covered != 0) ? static_cast<f32>(shaded) / static_cast<f32>(covered) : 0.0f;
+		}
+		void OptimizeMesh(std::vector<Vertex> * vertices, std::vector<u32> * indices, u32 flags,
+			MeshOptimizationStats * stats)
+		{
+			// Triangle soup is treated as indexed by its order
+			if (indices->empty())
+			{
+				indices->resize(vertices->size());
+				for (size_t i = 0; i < indices->size(); ++i)
+					(*indices)[i] = static_cast<u32>(i);
+			}
+			if (stats)
+			{
+				stats->num_vertices_before = static_cast<u32>(vertices->size());
+				stats->num_triangles = static_cast<u32>(indices->size() / 3);
+				stats->acmr_before = AnalyzeVertexCache(&(*indices)[0], indices->size(), stats->num_vertices_before);
+				stats->overdraw_before = (flags & kOptimizeOverdraw) ? AnalyzeOverdraw(*vertices, &(*indices)[0], indices->size()) : 0.0f;
+			}
+			if (flags & kOptimizeWeld)
+				WeldVertices(vertices, indices);
+			if (flags & kOptimizeVertexCache)
+				OptimizeVertexCache(&(*indices)[0], indices->size(), static_cast<u32>(vertices->size()));
+			if (flags & kOptimizeOverdraw)
+				OptimizeOverdraw(*vertices, &(*indices)[0], indices->size());
+			if (flags & kOptimizeVertexFetch)
+				OptimizeVertexFetch(vertices, indices);
+			if (stats)
+			{
+				stats->num_vertices_after = static_cast<u32>(vertices->size());
+				stats->acmr_after = AnalyzeVertexCache(&(*indices)[0], indices->size(), stats->num_vertices_after);
+				stats->overdraw_after = (flags & kOptimizeOverdraw) ? AnalyzeOverdraw(*vertices, &(*indices)[0], indices->size()) : 0.0f;
+			}
+		}
+
+	} // namespace graphics
+} // namespace sht
@@ -0,0 +1,504 @@
+#include "../../include/model/mesh_simplifier.h"
+#include "../../include/model/mesh_optimizer.h"
+
+#include <algorithm>
+#include <assert.h>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <unordered_set>
+
+namespace {
+
+	using sht::graphics::Vertex;
+	using sht::math::Vector3;
+
+	// Border planes are heavier than surface ones, so borders keep their shape
+	const double kBorderWeight = 10.0;
+	// Scale of attribute deviation as a fraction of mesh diameter
+	const float kAttributeWeight = 0.01f;
+	// Collapse is rejected when it rotates any triangle more than about 75 degrees
+	const float kMinNormalCosine = 0.25f;
+	// Normal and texcoord components
+	const int kNumAttributes = 5;
+
+	enum VertexKind : u8 {
+		kManifold,		//!< collapses in any direction
+		kBorder,		//!< collapses only along border edges
+		kLocked			//!< shares position with other vertices, so attribute seam stays intact
+	};
+
+	//! Weighted sum of squared distances to planes and of squared deviations of attributes
+	//! from their linear interpolation over triangles
+	struct Quadric {
+		double a00, a11, a22, a01, a02, a12;
+		double b0, b1, b2;
+		double c;
+		double weight;
+		double gradients[kNumAttributes][3];
+		double offsets[kNumAttributes];
+		double attribute_weight;
+	};
+
+	void GetAttributes(const Vertex& vertex, float * attributes)
+	{
+		attributes[0] = vertex.normal.x;
+		attributes[1] = vertex.normal.y;
+		attributes[2] = vertex.normal.z;
+		attributes[3] = vertex.texcoord.x;
+		attributes[4] = vertex.texcoord.y;
+	}
+	void AddPlane(Quadric * q, const Vector3& normal, float distance, double weight)
+	{
+		const double x = normal.x, y = normal.y, z = normal.z, d = distance;
+		q->a00 += weight * x * x;
+		q->a11 += weight * y * y;
+		q->a22 += weight * z * z;
+		q->a01 += weight * x * y;
+		q->a02 += weight * x * z;
+		q->a12 += weight * y * z;
+		q->b0 += weight * x * d;
+		q->b1 += weight * y * d;
+		q->b2 += weight * z * d;
+		q->c += weight * d * d;
+		q->weight += weight;
+	}
+	//! Adds deviation of attributes from linear function over triangle, that is g * p + d.
+	//! Squared deviation (g * p + d - s)^2 is split into quadric of position and terms with attribute value.
+	void AddAttributes(Quadric * q, const Vertex * corners[3], double weight)
+	{
+		const Vector3 e1 = corners[1]->position - corners[0]->position;
+		const Vector3 e2 = corners[2]->position - corners[0]->position;
+		const double d11 = e1 & e1, d12 = e1 & e2, d22 = e2 & e2;
+		const double det = d11 * d22 - d12 * d12;
+		if (det <= 0.0)
+			return;
+		float values[3][kNumAttributes];
+		for (int k = 0; k < 3; ++k)
+			GetAttributes(*corners[k], values[k]);
+		for (int j = 0; j < kNumAttributes; ++j)
+		{
+			// Gradient lies in triangle plane: g = a * e1 + b * e2, g * e1 = ds1, g * e2 = ds2
+			const double ds1 = values[1][j] - values[0][j];
+			const double ds2 = values[2][j] - values[0][j];
+			const double a = (ds1 * d22 - ds2 * d12) / det;
+			const double b = (ds2 * d11 - ds1 * d12) / det;
+			const Vector3 gradient = static_cast<float>(a) * e1 + static_cast<float>(b) * e2;
+			const float offset = values[0][j] - (gradient & corners[0]->position);
+			AddPlane(q, gradient, offset, weight);
+			q->weight -= weight; // attribute planes don't count as surface
+			q->gradients[j][0] += weight * gradient.x;
+			q->gradients[j][1] += weight * gradient.y;
+			q->gradients[j][2] += weight * gradient.z;
+			q->offsets[j] += weight * offset;
+		}
+		q->attribute_weight += weight;
+	}
+	void AddQuadric(Quadric * q, const Quadric& other)
+	{
+		q->a00 += other.a00;
+		q->a11 += other.a11;
+		q->a22 += other.a22;
+		q->a01 += other.a01;
+		q->a02 += other.a02;
+		q->a12 += other.a12;
+		q->b0 += other.b0;
+		q->b1 += other.b1;
+		q->b2 += other.b2;
+		q->c += other.c;
+		q->weight += other.weight;
+		for (int j = 0; j < kNumAttributes; ++j)
+		{
+			for (int k = 0; k < 3; ++k)
+				q->gradients[j][k] += other.gradients[j][k];
+			q->offsets[j] += other.offsets[j];
+		}
+		q->attribute_weight += other.attribute_weight;
+	}
+	//! Weighted error of vertex with given position and attributes
+	double EvaluateQuadric(const Quadric& q, const Vector3& p, const float * attributes)
+	{
+		const double x = p.x, y = p.y, z = p.z;
+		double error = q.a00 * x * x + q.a11 * y * y + q.a22 * z * z
+			+ 2.0 * (q.a01 * x * y + q.a02 * x * z + q.a12 * y * z)
+			+ 2.0 * (q.b0 * x + q.b1 * y + q.b2 * z) + q.c;
+		for (int j = 0; j < kNumAttributes; ++j)
+		{
+			const double s = attributes[j];
+			const double interpolated = q.gradients[j][0] * x + q.gradients[j][1] * y + q.gradients[j][2] * z
+				+ q.offsets[j];
+			error += q.attribute_weight * s * s - 2.0 * s * interpolated;
+		}
+		return error;
+	}
+
+	//! Hashes position bytes, vertices at the same point are wedges of it
+	struct PositionHasher {
+		const Vertex * vertices;
+
+		size_t operator()(u32 index) const
+		{
+			const u8 * bytes = reinterpret_cast<const u8*>(&vertices[index].position);
+			u32 hash = 2166136261u; // 32-bit FNV-1a
+			for (size_t i = 0; i < sizeof(Vector3); ++i)
+			{
+				hash ^= bytes[i];
+				hash *= 16777619u;
+			}
+			return hash;
+		}
+	};
+	struct PositionEqual {
+		const Vertex * vertices;
+
+		bool operator()(u32 a, u32 b) const
+		{
+			return memcmp(&vertices[a].position, &vertices[b].position, sizeof(Vector3)) == 0;
+		}
+	};
+
+	struct Collapse {
+		u32 from;
+		u32 to;
+		double cost;
+
+		bool operator < (const Collapse& other) const
+		{
+			return cost < other.cost;
+		}
+	};
+
+	inline u64 EdgeKey(u32 a, u32 b)
+	{
+		return (static_cast<u64>(a) << 32) | b;
+	}
+
+	//! Working state of simplification
+	class Simplifier {
+	public:
+		Simplifier(const std::vector<Vertex>& vertices, std::vector<u32> * indices)
+		: vertices_(vertices)
+		, indices_(*indices)
+		, num_vertices_(static_cast<u32>(vertices.size()))
+		, wedges_(num_vertices_)
+		, kinds_(num_vertices_, kManifold)
+		, quadrics_(num_vertices_, Quadric())
+		, collapses_(num_vertices_)
+		, touched_(num_vertices_)
+		, max_error_sqr_(0.0)
+		{
+			const float attribute_scale = kAttributeWeight * sht::graphics::ComputeMeshDiameter(vertices);
+			attribute_factor_ = static_cast<double>(attribute_scale) * attribute_scale;
+			for (u32 i = 0; i < num_vertices_; ++i)
+				collapses_[i] = i;
+			FindWedges();
+			ComputeQuadrics();
+		}
+
+		//! Runs collapse passes, may be called again with smaller target to continue
+		void Run(size_t target_index_count, double target_error_sqr)
+		{
+			while (indices_.size() > target_index_count)
+			{
+				const size_t num_triangles = indices_.size() / 3;
+				const size_t target_triangles = target_index_count / 3;
+				BuildAdjacency();
+				FindCollapses();
+				std::sort(candidates_.begin(), candidates_.end());
+				std::fill(touched_.begin(), touched_.end(), 0);
+
+				// Independent collapses in order of cost, neighbourhood of collapsed vertex waits for next pass
+				size_t triangles_left = num_triangles;
+				size_t num_collapsed = 0;
+				for (const auto& collapse : candidates_)
+				{
+					if (triangles_left <= target_triangles || collapse.cost > target_error_sqr)
+						break;
+					if (touched_[collapse.from] || touched_[collapse.to] || FlipsTriangle(collapse.from, collapse.to))
+						continue;
+					for (u32 i = offsets_[collapse.from]; i < offsets_[collapse.from + 1]; ++i)
+					{
+						const u32 * triangle = &indices_[3 * adjacency_[i]];
+						if (triangle[0] == collapse.to || triangle[1] == collapse.to || triangle[2] == collapse.to)
+							--triangles_left;
+						for (int k = 0; k < 3; ++k)
+							touched_[triangle[k]] = 1;
+					}
+					collapses_[collapse.from] = collapse.to;
+					AddQuadric(&quadrics_[collapse.to], quadrics_[collapse.from]);
+					max_error_sqr_ = std::max(max_error_sqr_, collapse.cost);
+					++num_collapsed;
+				}
+				if (num_collapsed == 0)
+					break;
+				ApplyCollapses();
+			}
+		}
+		//! Squared error of all collapses so far
+		double error_sqr() const
+		{
+			return max_error_sqr_;
+		}
+
+	private:
+		void FindWedges()
+		{
+			PositionHasher hasher = { &vertices_[0] };
+			PositionEqual equal = { &vertices_[0] };
+			std::unordered_set<u32, PositionHasher, PositionEqual> unique(num_vertices_, hasher, equal);
+			for (u32 i = 0; i < num_vertices_; ++i)
+			{
+				auto result = unique.insert(i);
+				wedges_[i] = *result.first;
+				if (!result.second)
+				{
+					kinds_[i] = kLocked;
+					kinds_[*result.first] = kLocked;
+				}
+			}
+		}
+		//! Edge of movable vertex is on a border when only one of triangles around vertex has it
+		bool IsBorderEdge(u32 from, u32 to) const
+		{
+			bool forward = false, backward = false;
+			for (u32 i = offsets_[from]; i < offsets_[from + 1]; ++i)
+			{
+				const u32 * triangle = &indices_[3 * adjacency_[i]];
+				const int k = (triangle[0] == from) ? 0 : ((triangle[1] == from) ? 1 : 2);
+				forward = forward || wedges_[triangle[(k + 1) % 3]] == wedges_[to];
+				backward = backward || wedges_[triangle[(k + 2) % 3]] == wedges_[to];
+			}
+			return !(forward && backward);
+		}
+		void ComputeQuadrics()
+		{
+			// Directed edges between positions, edge without opposite one lies on a border
+			std::unordered_set<u64> edges;
+			for (size_t i = 0; i < indices_.size(); i += 3)
+				for (int k = 0; k < 3; ++k)
+					edges.insert(EdgeKey(wedges_[indices_[i + k]], wedges_[indices_[i + (k + 1) % 3]]));
+			for (size_t i = 0; i < indices_.size(); i += 3)
+			{
+				const Vertex * corners[3] = { &vertices_[indices_[i]], &vertices_[indices_[i + 1]], &vertices_[indices_[i + 2]] };
+				const Vector3& p0 = corners[0]->position;
+				Vector3 normal = (corners[1]->position - p0) ^ (corners[2]->position - p0);
+				const float length = normal.Length();
+				if (length == 0.0f)
+					continue;
+				normal /= length;
+				// Planes are weighted by triangle area
+				const double area = 0.5 * length;
+				Quadric triangle_quadric = Quadric();
+				AddPlane(&triangle_quadric, normal, -(normal & p0), area);
+				AddAttributes(&triangle_quadric, corners, area * attribute_factor_);
+				for (int k = 0; k < 3; ++k)
+					AddQuadric(&quadrics_[indices_[i + k]], triangle_quadric);
+
+				// Border edges get plane perpendicular to triangle
+				for (int k = 0; k < 3; ++k)
+				{
+					const u32 a = indices_[i + k];
+					const u32 b = indices_[i + (k + 1) % 3];
+					if (edges.count(EdgeKey(wedges_[b], wedges_[a])) != 0)
+						continue;
+					if (kinds_[a] == kManifold)
+						kinds_[a] = kBorder;
+					if (kinds_[b] == kManifold)
+						kinds_[b] = kBorder;
+					const Vector3 edge = vertices_[b].position - vertices_[a].position;
+					Vector3 border_normal = edge ^ normal;
+					const float border_length = border_normal.Length();
+					if (border_length == 0.0f)
+						continue;
+					border_normal /= border_length;
+					const float border_distance = -(border_normal & vertices_[a].position);
+					const double weight = kBorderWeight * edge.Sqr();
+					AddPlane(&quadrics_[a], border_normal, border_distance, weight);
+					AddPlane(&quadrics_[b], border_normal, border_distance, weight);
+				}
+			}
+		}
+		//! Triangles around every vertex
+		void BuildAdjacency()
+		{
+			offsets_.assign(num_vertices_ + 1, 0);
+			for (auto index : indices_)
+				++offsets_[index + 1];
+			for (u32 i = 0; i < num_vertices_; ++i)
+				offsets_[i + 1] += offsets_[i];
+			adjacency_.resize(indices_.size());
+			std::vector<u32> fill(offsets_.begin(), offsets_.end() - 1);
+			for (size_t i = 0; i < indices_.size(); ++i)
+				adjacency_[fill[indices_[i]]++] = static_cast<u32>(i / 3);
+		}
+		//! Error of moving vertex from into vertex to
+		double CollapseCost(u32 from, u32 to) const
+		{
+			const Quadric& q0 = quadrics_[from];
+			const Quadric& q1 = quadrics_[to];
+			const double weight = q0.weight + q1.weight;
+			if (weight <= 0.0)
+				return 0.0;
+			// Removed vertex takes position and attributes of the remaining one
+			const Vertex& target = vertices_[to];
+			float attributes[kNumAttributes];
+			GetAttributes(target, attributes);
+			const double error = EvaluateQuadric(q0, target.position, attributes) +
+				EvaluateQuadric(q1, target.position, attributes);
+			return std::max(error, 0.0) / weight;
+		}
+		//! The cheapest collapse of every vertex that may move
+		void FindCollapses()
+		{
+			candidates_.clear();
+			for (u32 from = 0; from < num_vertices_; ++from)
+			{
+				if (kinds_[from] == kLocked)
+					continue;
+				Collapse best = { from, from, DBL_MAX };
+				for (u32 i = offsets_[from]; i < offsets_[from + 1]; ++i)
+				{
+					const u32 * triangle = &indices_[3 * adjacency_[i]];
+					for (int k = 0; k < 3; ++k)
+					{
+						const u32 to = triangle[k];
+						if (to == from || (kinds_[from] == kBorder && !IsBorderEdge(from, to)))
+							continue;
+						const double cost = CollapseCost(from, to);
+						if (cost < best.cost)
+						{
+							best.to = to;
+							best.cost = cost;
+						}
+					}
+				}
+				if (best.to != from)
+					candidates_.push_back(best);
+			}
+		}
+		bool FlipsTriangle(u32 from, u32 to) const
+		{
+			const Vector3& target = vertices_[to].position;
+			for (u32 i = offsets_[from]; i < offsets_[from + 1]; ++i)
+			{
+				const u32 * triangle = &indices_[3 * adjacency_[i]];
+				if (triangle[0] == to || triangle[1] == to || triangle[2] == to)
+					continue; // triangle vanishes
+				Vector3 before[3], after[3];
+				for (int k = 0; k < 3; ++k)
+				{
+					before[k] = vertices_[triangle[k]].position;
+					after[k] = (triangle[k] == from) ? target : before[k];
+				}
+				const Vector3 normal_before = (before[1] - before[0]) ^ (before[2] - before[0]);
+				const Vector3 normal_after = (after[1] - after[0]) ^ (after[2] - after[0]);
+				const float cosine_scale = sqrtf(normal_before.Sqr() * normal_after.Sqr());
+				if ((normal_before & normal_after) <= kMinNormalCosine * cosine_scale)
+					return true;
+			}
+			return false;
+		}
+		//! Remaps indices and removes triangles that became degenerate
+		void ApplyCollapses()
+		{
+			size_t count = 0;
+			for (size_t i = 0; i < indices_.size(); i += 3)
+			{
+				const u32 a = collapses_[indices_[i]];
+				const u32 b = collapses_[indices_[i + 1]];
+				const u32 c = collapses_[indices_[i + 2]];
+				if (wedges_[a] == wedges_[b] || wedges_[b] == wedges_[c] || wedges_[a] == wedges_[c])
+					continue;
+				indices_[count++] = a;
+				indices_[count++] = b;
+				indices_[count++] = c;
+			}
+			indices_.resize(count);
+			for (u32 i = 0; i < num_vertices_; ++i)
+				collapses_[i] = i;
+		}
+
+		const std::vector<Vertex>& vertices_;
+		std::vector<u32>& indices_;
+		const u32 num_vertices_;
+		std::vector<u32> wedges_;			//!< representative of vertices at the same position
+		std::vector<u8> kinds_;
+		std::vector<Quadric> quadrics_;
+		std::vector<u32> collapses_;		//!< target of every vertex in current pass
+		std::vector<u8> touched_;
+		std::vector<u32> offsets_;
+		std::vector<u32> adjacency_;
+		std::vector<Collapse> candidates_;
+		double attribute_factor_;
+		double max_error_sqr_;
+	};
+
+} // namespace
+
+namespace sht {
+	namespace graphics {
+
+		f32 SimplifyMesh(const std::vector<Vertex>& vertices, const u32 * indices, size_t num_indices,
+			size_t target_index_count, f32 target_error, std::vector<u32> * result)
+		{
+			assert(num_indices % 3 == 0);
+			result->assign(indices, indices + num_indices);
+			if (num_indices <= target_index_count || vertices.empty())
+				return 0.0f;
+			Simplifier simplifier(vertices, result);
+			simplifier.Run(target_index_count, static_cast<double>(target_error) * target_error);
+			return static_cast<f32>(sqrt(simplifier.error_sqr()));
+		}
+		f32 ComputeMeshDiameter(const std::vector<Vertex>& vertices)
+		{
+			if (vertices.empty())
+				return 0.0f;
+			Vector3 min = vertices[0].position;
+			Vector3 max = vertices[0].position;
+			for (const auto& vertex : vertices)
+			{
+				min.MakeFloor(vertex.position);
+				max.MakeCeil(vertex.position);
+			}
+			return (max - min).Length();
+		}
+		void GenerateLods(const std::vector<Vertex>& vertices, const std::vector<u32>& indices, u32 num_lods,
+			f32 max_relative_error, std::vector<MeshLod> * lods)
+		{
+			lods->clear();
+			if (indices.empty() || vertices.empty())
+				return;
+			const f32 max_error = max_relative_error * ComputeMeshDiameter(vertices);
+			// Levels continue simplification of each other, quadrics keep error against the full detail
+			std::vector<u32> current(indices);
+			Simplifier simplifier(vertices, &current);
+			for (u32 i = 0; i < num_lods; ++i)
+			{
+				const size_t previous_count = current.size();
+				simplifier.Run(previous_count / 6 * 3, static_cast<double>(max_error) * max_error);
+				// Level that is almost the same as the previous one isn't worth its memory
+				if (current.empty() || current.size() * 10 > previous_count * 9)
+					break;
+				lods->push_back(MeshLod());
+				MeshLod& lod = lods->back();
+				lod.indices = current;
+				lod.error = static_cast<f32>(sqrt(simplifier.error_sqr()));
+				OptimizeVertexCache(&lod.indices[0], lod.indices.size(), static_cast<u32>(vertices.size()));
+			}
+		}
+		f32 ComputeScreenSize(f32 diameter, f32 distance, f32 fov, f32 viewport_height)
+		{
+			if (distance <= 0.0f)
+				return FLT_MAX;
+			return diameter * viewport_height / (2.0f * distance * tanf(0.5f * fov));
+		}
+		u32 SelectLod(const std::vector<MeshLod>& lods, f32 pixels_per_unit, f32 max_pixel_error)
+		{
+			for (size_t i = lods.size(); i > 0; --i)
+				if (lods[i - 1].error * pixels_per_unit <= max_pixel_error)
+					return static_cast<u32>(i);
+			return 0;
+		}
+
+	} // namespace graphics
+} // namespace sht
@@ -10,7 +10,8 @@ namespace sht {
 		: complex_mesh_(complex_mesh)
 		, index_(0)
 		{
-
+			// Meshes loaded in vertex format have no plain vertices yet
+			complex_mesh_->UnpackMeshes();
 		}
 		bool MeshVerticesEnumerator::GetNextObject(MeshVerticesInfo * info)
 		{
@@ -27,6 +28,8 @@ namespace sht {
 					info->vertices = nullptr;
 					info->num_vertices = 0;
 				}
+				info->indices = mesh->indices_.empty() ? nullptr : &mesh->indices_[0];
+				info->num_indices = static_cast<unsigned int>(mesh->indices_.size());
 				++index_;
 				return true;
 			}
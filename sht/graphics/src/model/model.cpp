@@ -1,4 +1,9 @@
 #include "../../include/model/model.h"
+#include "../../include/renderer/instance_batch.h"
+#include "../../include/renderer/vertex_packing.h"
+
+#include <algorithm>
+#include <cmath>
 
 namespace sht {
     namespace graphics {
@@ -15,8 +20,12 @@ namespace sht {
         , num_indices_(0)
         , index_size_(0)
         , indices_array_(nullptr)
+        , vertex_compression_(kCompressNone)
+        , lod_(0)
+        , diameter_(0.0f)
         {
-            
+            quantization_.offset = vec3(0.0f);
+            quantization_.scale = 1.0f;
         }
         Model::~Model()
         {
@@ -34,6 +43,10 @@ namespace sht {
         {
             attribs_.push_back(attrib);
         }
+        void Model::set_vertex_compression(u32 compression)
+        {
+            vertex_compression_ = compression;
+        }
         void Model::FreeArrays()
         {
             if (vertices_array_)
@@ -47,45 +60,33 @@ namespace sht {
                 indices_array_ = nullptr;
             }
         }
-        void Model::TransformVertices()
+        void Model::TransformVertices(const VertexPacker& packer)
         {
             num_vertices_ = (u32)vertices_.size();
             vertices_array_ = new u8[num_vertices_ * vertex_format_->vertex_size()];
-            u8 *ptr = vertices_array_;
-            for (auto &v : vertices_)
-            for (auto &a : attribs_)
-            {
-                switch (a.type)
-                {
-                    case VertexAttribute::kVertex:
-                        memcpy(ptr, v.position, sizeof(v.position));
-                        break;
-                    case VertexAttribute::kNormal:
-                        memcpy(ptr, v.normal, sizeof(v.normal));
-                        break;
-                    case VertexAttribute::kTexcoord:
-                        memcpy(ptr, v.texcoord, sizeof(v.texcoord));
-                        break;
-                    case VertexAttribute::kTangent:
-                        memcpy(ptr, v.tangent, sizeof(v.tangent));
-                        break;
-                    case VertexAttribute::kBinormal:
-                        memcpy(ptr, v.binormal, sizeof(v.binormal));
-                        break;
-                    default:
-                        assert(!"Unknown vertex attribute");
-                }
-                ptr += a.size * sizeof(float);
-            }
+            packer.Pack(vertices_, attribs_, vertex_format_->vertex_size(), vertices_array_);
             vertices_.clear();
             vertices_.shrink_to_fit();
             
             num_indices_ = (u32)indices_.size();
-            if (num_indices_ > 0xffff)
+            // Levels of detail follow full detail indices in the same buffer
+            lod_ranges_.resize(lods_.size() + 1);
+            lod_ranges_[0].first_index = 0;
+            lod_ranges_[0].num_indices = num_indices_;
+            for (size_t i = 0; i < lods_.size(); ++i)
+            {
+                lod_ranges_[i + 1].first_index = (u32)indices_.size();
+                lod_ranges_[i + 1].num_indices = (u32)lods_[i].indices.size();
+                indices_.insert(indices_.end(), lods_[i].indices.begin(), lods_[i].indices.end());
+                lods_[i].indices.clear();
+                lods_[i].indices.shrink_to_fit();
+            }
+            const u32 total_indices = (u32)indices_.size();
+            if (total_indices > 0xffff)
             {
                 index_size_ = sizeof(u32);
                 index_data_type_ = DataType::kUnsignedInt;
-                indices_array_ = new u8[num_indices_ * index_size_];
+                indices_array_ = new u8[total_indices * index_size_];
                 u32 *indices = reinterpret_cast<u32*>(indices_array_);
                 for (size_t i = 0; i < indices_.size(); ++i)
                 {
@@ -96,7 +97,7 @@ namespace sht {
             {
                 index_size_ = sizeof(u16);
                 index_data_type_ = DataType::kUnsignedShort;
-                indices_array_ = new u8[num_indices_ * index_size_];
+                indices_array_ = new u8[total_indices * index_size_];
                 u16 *indices = reinterpret_cast<u16*>(indices_array_);
                 for (size_t i = 0; i < indices_.size(); ++i)
                 {
@@ -113,9 +114,14 @@ namespace sht {
                 assert(!"Vertex format hasn't been set.");
                 return false;
             }
+            VertexPacker packer(vertex_compression_);
+            packer.AddVertices(vertices_);
+            packer.ChooseFormats(&attribs_);
+            quantization_ = packer.quantization();
+            
             renderer_->AddVertexFormat(vertex_format_, &attribs_[0], (u32)attribs_.size());
             
-            TransformVertices();
+            TransformVertices(packer);
             
             renderer_->context()->GenVertexArrayObject(vertex_array_object_);
             renderer_->context()->BindVertexArrayObject(vertex_array_object_);
@@ -123,13 +129,17 @@ namespace sht {
             renderer_->AddVertexBuffer(vertex_buffer_, num_vertices_ * vertex_format_->vertex_size(), vertices_array_, BufferUsage::kStaticDraw);
             if (vertex_buffer_ == nullptr) return false;
             
-            renderer_->AddIndexBuffer(index_buffer_, num_indices_, index_size_, indices_array_, BufferUsage::kStaticDraw);
+            const LodRange& last = lod_ranges_.back();
+            renderer_->AddIndexBuffer(index_buffer_, last.first_index + last.num_indices, index_size_, indices_array_,
+                BufferUsage::kStaticDraw);
             if (index_buffer_ == nullptr) return false;
             
             const char* base = (char*)0;
             for (u32 i = 0; i < attribs_.size(); ++i)
             {
-                renderer_->context()->VertexAttribPointer(i, vertex_format_->generic_[i].size, DataType::kFloat, vertex_format_->vertex_size(), base + vertex_format_->generic_[i].offset);
+                const VertexFormat::Attrib& generic = vertex_format_->generic_[i];
+                renderer_->context()->VertexAttribPointer(i, generic.size, GetAttributeDataType(generic.format),
+                    vertex_format_->vertex_size(), base + generic.offset, IsAttributeNormalized(generic.format));
                 renderer_->context()->EnableVertexAttribArray(i);
             }
             
@@ -149,12 +159,34 @@ namespace sht {
         void Model::Render()
         {
             renderer_->context()->BindVertexArrayObject(vertex_array_object_);
-            renderer_->context()->DrawElements(primitive_mode_, num_indices_, index_data_type_);
+            if (lod_ == 0)
+                renderer_->context()->DrawElements(primitive_mode_, num_indices_, index_data_type_);
+            else
+                renderer_->context()->DrawElementsBaseVertex(primitive_mode_, lod_ranges_[lod_].num_indices,
+                    index_data_type_, lod_ranges_[lod_].first_index, 0);
+        }
+        void Model::AttachInstanceBatch(InstanceBatch * batch)
+        {
+            renderer_->context()->BindVertexArrayObject(vertex_array_object_);
+            batch->Attach((u32)attribs_.size());
+            renderer_->context()->BindVertexArrayObject(0);
+        }
+        void Model::RenderInstanced(u32 num_instances)
+        {
+            if (num_instances == 0)
+                return;
+            renderer_->context()->BindVertexArrayObject(vertex_array_object_);
+            renderer_->context()->DrawElementsInstanced(primitive_mode_, num_indices_, index_data_type_, num_instances);
         }
         void Model::ScaleVertices(const math::Vector3& scale)
         {
             for (auto& v : vertices_)
                 v.position *= scale;
+            // Errors are kept for the most stretched axis
+            const f32 max_scale = std::max(fabsf(scale.x), std::max(fabsf(scale.y), fabsf(scale.z)));
+            for (auto& lod : lods_)
+                lod.error *= max_scale;
+            diameter_ *= max_scale;
         }
         void Model::ScaleTexcoord(const math::Vector2& scale)
         {
@@ -165,6 +197,55 @@ namespace sht {
         {
             // TODO
         }
+        const VertexQuantization& Model::vertex_quantization() const
+        {
+            return quantization_;
+        }
+        void Model::ConvertStripToList()
+        {
+            std::vector<u32> list;
+            list.reserve(3 * indices_.size());
+            for (size_t i = 2; i < indices_.size(); ++i)
+            {
+                u32 a = indices_[i - 2], b = indices_[i - 1], c = indices_[i];
+                if (a == b || b == c || a == c)
+                    continue; // degenerate triangle joins strips
+                // Every odd triangle of strip has reversed order
+                if (i & 1)
+                    std::swap(a, b);
+                list.push_back(a);
+                list.push_back(b);
+                list.push_back(c);
+            }
+            indices_.swap(list);
+            primitive_mode_ = PrimitiveType::kTriangles;
+        }
+        void Model::GenerateLods(u32 num_lods, f32 max_relative_error)
+        {
+            if (primitive_mode_ == PrimitiveType::kTriangleStrip)
+                ConvertStripToList();
+            if (primitive_mode_ != PrimitiveType::kTriangles || indices_.empty())
+                return;
+            diameter_ = ComputeMeshDiameter(vertices_);
+            graphics::GenerateLods(vertices_, indices_, num_lods, max_relative_error, &lods_);
+        }
+        u32 Model::num_lods() const
+        {
+            return (u32)lods_.size() + 1;
+        }
+        void Model::set_lod(u32 lod)
+        {
+            lod_ = std::min(lod, (u32)lods_.size());
+        }
+        u32 Model::lod() const
+        {
+            return lod_;
+        }
+        void Model::SelectLod(f32 screen_size, f32 max_pixel_error)
+        {
+            if (diameter_ > 0.0f)
+                lod_ = graphics::SelectLod(lods_, screen_size / diameter_, max_pixel_error);
+        }
 
     } // namespace graphics
 } // namespace sht
\ No newline at end of file
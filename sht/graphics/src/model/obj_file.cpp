@@ -0,0 +1,736 @@
+#include "../../include/model/obj_file.h"
+
+#include "../../../system/include/stream/file_stream.h"
+#include "../../../system/include/stream/log_stream.h"
+#include "../../../system/include/stream/mapped_file.h"
+#include "../../../system/include/string/filename.h"
+#include "../../../system/include/filesystem/directory.h"
+#include "../../../system/include/tasks/parallel_for.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <unordered_map>
+
+namespace {
+
+	using namespace sht::graphics;
+
+	//! Chunks are not made smaller than this, small files are parsed on the calling thread
+	const size_t kMinChunkSize = 1 << 20;
+	//! Negative indices are stored relative to the first element of chunk shifted by this bias
+	const s32 kRelativeBias = 1 << 30;
+	const u32 kEmpty = 0xffffffff;
+
+	const double kPowersOfTen[] = {
+		1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+		1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+	};
+
+	inline bool IsSpace(char c)
+	{
+		return c == ' ' || c == '\t';
+	}
+	inline bool IsDigit(char c)
+	{
+		return c >= '0' && c <= '9';
+	}
+	inline void SkipSpaces(const char *& ptr, const char * end)
+	{
+		while (ptr < end && IsSpace(*ptr))
+			++ptr;
+	}
+
+	//! Parses decimal number, the first 19 significant digits are exact and scaled by a power of ten once
+	bool ParseFloat(const char *& ptr, const char * end, f32 * value)
+	{
+		const char * p = ptr;
+		SkipSpaces(p, end);
+		bool negative = false;
+		if (p < end && (*p == '-' || *p == '+'))
+			negative = (*p++ == '-');
+		u64 mantissa = 0;
+		int digits = 0;
+		int exponent = 0;
+		bool any_digits = false;
+		for (; p < end && IsDigit(*p); ++p)
+		{
+			any_digits = true;
+			if (digits < 19)
+			{
+				mantissa = mantissa * 10 + static_cast<u64>(*p - '0');
+				if (mantissa != 0)
+					++digits;
+			}
+			else
+				++exponent;
+		}
+		if (p < end && *p == '.')
+		{
+			for (++p; p < end && IsDigit(*p); ++p)
+			{
+				any_digits = true;
+				if (digits < 19)
+				{
+					mantissa = mantissa * 10 + static_cast<u64>(*p - '0');
+					--exponent;
+					if (mantissa != 0)
+						++digits;
+				}
+			}
+		}
+		if (!any_digits)
+			return false;
+		if (p < end && (*p == 'e' || *p == 'E'))
+		{
+			const char * q = p + 1;
+			bool negative_exponent = false;
+			if (q < end && (*q == '-' || *q == '+'))
+				negative_exponent = (*q++ == '-');
+			if (q < end && IsDigit(*q))
+			{
+				int explicit_exponent = 0;
+				for (; q < end && IsDigit(*q); ++q)
+					if (explicit_exponent < 10000)
+						explicit_exponent = explicit_exponent * 10 + (*q - '0');
+				exponent += negative_exponent ? -explicit_exponent : explicit_exponent;
+				p = q;
+			}
+		}
+		double result = static_cast<double>(mantissa);
+		if (mantissa != 0 && exponent != 0)
+		{
+			if (exponent < 0 && exponent >= -22)
+				result /= kPowersOfTen[-exponent];
+			else if (exponent > 0 && exponent <= 22)
+				result *= kPowersOfTen[exponent];
+			else
+				result *= pow(10.0, static_cast<double>(exponent));
+		}
+		*value = static_cast<f32>(negative ? -result : result);
+		ptr = p;
+		return true;
+	}
+	bool ParseInt(const char *& ptr, const char * end, s32 * value)
+	{
+		const char * p = ptr;
+		bool negative = false;
+		if (p < end && (*p == '-' || *p == '+'))
+			negative = (*p++ == '-');
+		if (p == end || !IsDigit(*p))
+			return false;
+		s32 result = 0;
+		for (; p < end && IsDigit(*p); ++p)
+		{
+			if (result >= kRelativeBias / 10)
+				return false;
+			result = result * 10 + (*p - '0');
+		}
+		*value = negative ? -result : result;
+		ptr = p;
+		return true;
+	}
+	//! Returns word of line without trailing spaces
+	std::string ParseName(const char *& ptr, const char * end)
+	{
+		SkipSpaces(ptr, end);
+		const char * begin = ptr;
+		while (ptr < end && *ptr != '\r' && *ptr != '\n')
+			++ptr;
+		const char * name_end = ptr;
+		while (name_end > begin && IsSpace(name_end[-1]))
+			--name_end;
+		return std::string(begin, name_end);
+	}
+	inline bool StartsWith(const char * ptr, const char * end, const char * keyword, size_t length)
+	{
+		return static_cast<size_t>(end - ptr) > length && memcmp(ptr, keyword, length) == 0 && IsSpace(ptr[length]);
+	}
+
+	//! Faces after first triangle use the material
+	struct MaterialRun {
+		u32 first_triangle;
+		s32 material;	//!< index of name in chunk until resolved
+	};
+
+	//! Part of file parsed by a single thread
+	struct ObjChunk {
+		const char * begin;
+		const char * end;
+		std::vector<f32> positions;
+		std::vector<f32> texcoords;
+		std::vector<f32> normals;
+		std::vector<s32> corners;			//!< position, texcoord and normal of every triangle corner
+		std::vector<MaterialRun> runs;
+		std::vector<std::string> names;		//!< materials used
+		std::vector<std::string> libraries;
+		u32 first_position;
+		u32 first_texcoord;
+		u32 first_normal;
+		s32 first_material;					//!< material of faces before the first run
+		bool failed;
+	};
+
+	//! Keeps positive indices and turns negative ones into chunk relative
+	inline s32 EncodeIndex(s32 index, size_t count)
+	{
+		return (index > 0) ? index : static_cast<s32>(count) + index - kRelativeBias;
+	}
+	//! Zero based index into file array, -1 if index is absent
+	inline s32 DecodeIndex(s32 index, u32 first, u32 total, bool * valid)
+	{
+		if (index == 0)
+			return -1;
+		const s64 result = (index > 0) ? static_cast<s64>(index) - 1 : static_cast<s64>(first) + index + kRelativeBias;
+		if (result < 0 || result >= total)
+		{
+			*valid = false;
+			return -1;
+		}
+		return static_cast<s32>(result);
+	}
+
+	bool ParseFace(const char * ptr, const char * end, ObjChunk * chunk, std::vector<s32> * polygon)
+	{
+		polygon->clear();
+		for (;;)
+		{
+			SkipSpaces(ptr, end);
+			if (ptr == end || *ptr == '\r' || *ptr == '\n')
+				break;
+			s32 position, texcoord = 0, normal = 0;
+			if (!ParseInt(ptr, end, &position))
+				return false;
+			if (ptr < end && *ptr == '/')
+			{
+				++ptr;
+				if (ptr < end && *ptr != '/' && !ParseInt(ptr, end, &texcoord))
+					return false;
+				if (ptr < end && *ptr == '/')
+				{
+					++ptr;
+					if (!ParseInt(ptr, end, &normal))
+						return false;
+				}
+			}
+			if (position == 0)
+				return false;
+			polygon->push_back(EncodeIndex(position, chunk->positions.size() / 3));
+			polygon->push_back(texcoord == 0 ? 0 : EncodeIndex(texcoord, chunk->texcoords.size() / 2));
+			polygon->push_back(normal == 0 ? 0 : EncodeIndex(normal, chunk->normals.size() / 3));
+		}
+		const size_t num_corners = polygon->size() / 3;
+		if (num_corners < 3)
+			return false;
+		// Triangle fan
+		const s32 * corners = polygon->data();
+		for (size_t i = 2; i < num_corners; ++i)
+		{
+			chunk->corners.insert(chunk->corners.end(), corners, corners + 3);
+			chunk->corners.insert(chunk->corners.end(), corners + 3 * (i - 1), corners + 3 * (i + 1));
+		}
+		return true;
+	}
+
+	void ParseChunk(ObjChunk * chunk)
+	{
+		std::vector<s32> polygon;
+		const char * end = chunk->end;
+		const char * ptr = chunk->begin;
+		chunk->failed = false;
+		while (ptr < end)
+		{
+			SkipSpaces(ptr, end);
+			const char * line_end = static_cast<const char*>(memchr(ptr, '\n', end - ptr));
+			if (line_end == nullptr)
+				line_end = end;
+			if (ptr == line_end)
+			{
+				ptr = line_end + 1;
+				continue;
+			}
+			bool valid = true;
+			if (ptr[0] == 'v' && line_end - ptr > 1)
+			{
+				f32 values[3] = { 0.0f, 0.0f, 0.0f };
+				const char * p = ptr + 2;
+				if (IsSpace(ptr[1]))
+				{
+					valid = ParseFloat(p, line_end, &values[0]) && ParseFloat(p, line_end, &values[1]) &&
+						ParseFloat(p, line_end, &values[2]);
+					chunk->positions.insert(chunk->positions.end(), values, values + 3);
+				}
+				else if (ptr[1] == 'n' && line_end - ptr > 2 && IsSpace(ptr[2]))
+				{
+					++p;
+					valid = ParseFloat(p, line_end, &values[0]) && ParseFloat(p, line_end, &values[1]) &&
+						ParseFloat(p, line_end, &values[2]);
+					chunk->normals.insert(chunk->normals.end(), values, values + 3);
+				}
+				else if (ptr[1] == 't' && line_end - ptr > 2 && IsSpace(ptr[2]))
+				{
+					++p;
+					valid = ParseFloat(p, line_end, &values[0]);
+					ParseFloat(p, line_end, &values[1]); // second coordinate is optional
+					chunk->texcoords.insert(chunk->texcoords.end(), values, values + 2);
+				}
+			}
+			else if (ptr[0] == 'f' && line_end - ptr > 1 && IsSpace(ptr[1]))
+				valid = ParseFace(ptr + 2, line_end, chunk, &polygon);
+			else if (StartsWith(ptr, line_end, "usemtl", 6))
+			{
+				const char * p = ptr + 6;
+				MaterialRun run;
+				run.first_triangle = static_cast<u32>(chunk->corners.size() / 9);
+				run.material = static_cast<s32>(chunk->names.size());
+				chunk->names.push_back(ParseName(p, line_end));
+				chunk->runs.push_back(run);
+			}
+			else if (StartsWith(ptr, line_end, "mtllib", 6))
+			{
+				const char * p = ptr + 6;
+				chunk->libraries.push_back(ParseName(p, line_end));
+			}
+			// Groups, objects, smoothing groups, lines and comments are skipped
+			if (!valid)
+			{
+				chunk->failed = true;
+				return;
+			}
+			ptr = line_end + 1;
+		}
+	}
+
+	//! Position, texcoord and normal indices of vertex
+	struct CornerKey {
+		s32 position;
+		s32 texcoord;
+		s32 normal;
+	};
+	inline u32 HashCorner(const s32 * corner)
+	{
+		u32 hash = static_cast<u32>(corner[0]) * 0x9e3779b1U;
+		hash ^= static_cast<u32>(corner[1]) * 0x85ebca77U;
+		hash ^= static_cast<u32>(corner[2]) * 0xc2b2ae3dU;
+		return hash ^ (hash >> 15);
+	}
+
+	//! Part of chunk that belongs to mesh
+	struct TriangleRange {
+		const ObjChunk * chunk;
+		u32 first_triangle;
+		u32 end_triangle;
+	};
+
+	void MakeDefaultMaterial(Material * material)
+	{
+		*material = Material();
+		material->diffuse = vec3(0.6f);
+		material->shininess = 1.0f;
+		material->dissolve = 1.0f;
+	}
+
+} // namespace
+
+namespace sht {
+	namespace graphics {
+
+		ObjReader::ObjReader()
+		{
+			bounding_box_.center = vec3(0.0f);
+			bounding_box_.extent = vec3(0.0f);
+		}
+		bool ObjReader::LoadMaterialLibrary(const std::string& filename, std::vector<std::string> * names)
+		{
+			system::MappedFile file;
+			if (!file.Open(filename.c_str()))
+				return false;
+			const char * ptr = reinterpret_cast<const char*>(file.data());
+			const char * end = ptr + file.size();
+			Material * material = nullptr;
+			while (ptr < end)
+			{
+				SkipSpaces(ptr, end);
+				const char * line_end = static_cast<const char*>(memchr(ptr, '\n', end - ptr));
+				if (line_end == nullptr)
+					line_end = end;
+				const char * p = ptr + 2;
+				if (StartsWith(ptr, line_end, "newmtl", 6))
+				{
+					p = ptr + 6;
+					names->push_back(ParseName(p, line_end));
+					materials_.push_back(Material());
+					material = &materials_.back();
+					MakeDefaultMaterial(material);
+				}
+				else if (material != nullptr)
+				{
+					vec3 * color = nullptr;
+					if (StartsWith(ptr, line_end, "Ka", 2))
+						color = &material->ambient;
+					else if (StartsWith(ptr, line_end, "Kd", 2))
+						color = &material->diffuse;
+					else if (StartsWith(ptr, line_end, "Ks", 2))
+						color = &material->specular;
+					else if (StartsWith(ptr, line_end, "Kt", 2) || StartsWith(ptr, line_end, "Tf", 2))
+						color = &material->transmittance;
+					else if (StartsWith(ptr, line_end, "Ke", 2))
+						color = &material->emission;
+					else if (StartsWith(ptr, line_end, "Ns", 2))
+						ParseFloat(p, line_end, &material->shininess);
+					else if (StartsWith(ptr, line_end, "d", 1))
+					{
+						p = ptr + 1;
+						ParseFloat(p, line_end, &material->dissolve);
+					}
+					else if (StartsWith(ptr, line_end, "Tr", 2))
+					{
+						f32 transparency;
+						if (ParseFloat(p, line_end, &transparency))
+							material->dissolve = 1.0f - transparency;
+					}
+					if (color != nullptr && ParseFloat(p, line_end, &color->x))
+					{
+						// Single value means gray
+						color->y = color->z = color->x;
+						if (ParseFloat(p, line_end, &color->y))
+							ParseFloat(p, line_end, &color->z);
+					}
+				}
+				ptr = line_end + 1;
+			}
+			return true;
+		}
+		bool ObjReader::Open(const char *filename)
+		{
+			system::ErrorLogStream * error_log = system::ErrorLogStream::GetInstance();
+			materials_.clear();
+			meshes_.clear();
+
+			system::MappedFile file;
+			if (!file.Open(filename))
+			{
+				error_log->PrintString("can't open %s\n", filename);
+				return false;
+			}
+			const char * data = reinterpret_cast<const char*>(file.data());
+			const size_t size = static_cast<size_t>(file.size());
+
+			// Split file into chunks ending at line ends
+			size_t num_chunks = std::max<size_t>(1, size / kMinChunkSize);
+			num_chunks = std::min<size_t>(num_chunks, 4 * static_cast<size_t>(system::GetWorkerThreadCount()));
+			std::vector<ObjChunk> chunks(num_chunks);
+			const char * begin = data;
+			for (size_t i = 0; i < num_chunks; ++i)
+			{
+				const char * end = data + size * (i + 1) / num_chunks;
+				if (end < begin)
+					end = begin;
+				if (i + 1 < num_chunks)
+				{
+					const char * line_end = static_cast<const char*>(memchr(end, '\n', data + size - end));
+					end = (line_end != nullptr) ? line_end + 1 : data + size;
+				}
+				chunks[i].begin = begin;
+				chunks[i].end = end;
+				begin = end;
+			}
+			system::ParallelFor(0, static_cast<int>(num_chunks), [&chunks](int first, int last)
+			{
+				for (int i = first; i < last; ++i)
+					ParseChunk(&chunks[i]);
+			});
+
+			// Chunk offsets in file arrays
+			u32 num_positions = 0, num_texcoords = 0, num_normals = 0;
+			for (auto& chunk : chunks)
+			{
+				if (chunk.failed)
+				{
+					error_log->PrintString("broken line in %s\n", filename);
+					return false;
+				}
+				chunk.first_position = num_positions;
+				chunk.first_texcoord = num_texcoords;
+				chunk.first_normal = num_normals;
+				num_positions += static_cast<u32>(chunk.positions.size() / 3);
+				num_texcoords += static_cast<u32>(chunk.texcoords.size() / 2);
+				num_normals += static_cast<u32>(chunk.normals.size() / 3);
+			}
+
+			// Materials
+			std::string base_dir = system::Filename(filename).ExtractPath();
+			if (!base_dir.empty())
+				base_dir += system::GetPathDelimeter();
+			std::vector<std::string> names;
+			for (const auto& chunk : chunks)
+				for (const auto& library : chunk.libraries)
+					if (!LoadMaterialLibrary(base_dir + library, &names))
+						error_log->PrintString("can't open material library %s\n", library.c_str());
+			std::unordered_map<std::string, s32> material_indices;
+			for (size_t i = 0; i < names.size(); ++i)
+				material_indices.insert(std::make_pair(names[i], static_cast<s32>(i)));
+			s32 material = -1;
+			for (auto& chunk : chunks)
+			{
+				chunk.first_material = material;
+				for (auto& run : chunk.runs)
+				{
+					auto it = material_indices.find(chunk.names[run.material]);
+					if (it == material_indices.end())
+						error_log->PrintString("unknown material %s in %s\n", chunk.names[run.material].c_str(), filename);
+					run.material = (it != material_indices.end()) ? it->second : -1;
+					material = run.material;
+				}
+			}
+
+			// Resolve indices and gather file arrays
+			std::vector<f32> positions(3 * num_positions);
+			std::vector<f32> texcoords(2 * num_texcoords);
+			std::vector<f32> normals(3 * num_normals);
+			system::ParallelFor(0, static_cast<int>(num_chunks), [&](int first, int last)
+			{
+				for (int i = first; i < last; ++i)
+				{
+					ObjChunk& chunk = chunks[i];
+					std::copy(chunk.positions.begin(), chunk.positions.end(), positions.begin() + 3 * chunk.first_position);
+					std::copy(chunk.texcoords.begin(), chunk.texcoords.end(), texcoords.begin() + 2 * chunk.first_texcoord);
+					std::copy(chunk.normals.begin(), chunk.normals.end(), normals.begin() + 3 * chunk.first_normal);
+					std::vector<f32>().swap(chunk.positions);
+					std::vector<f32>().swap(chunk.texcoords);
+					std::vector<f32>().swap(chunk.normals);
+					bool valid = true;
+					for (size_t j = 0; j < chunk.corners.size(); j += 3)
+					{
+						s32 * corner = &chunk.corners[j];
+						corner[0] = DecodeIndex(corner[0], chunk.first_position, num_positions, &valid);
+						corner[1] = DecodeIndex(corner[1], chunk.first_texcoord, num_texcoords, &valid);
+						corner[2] = DecodeIndex(corner[2], chunk.first_normal, num_normals, &valid);
+					}
+					chunk.failed = !valid;
+				}
+			});
+			for (const auto& chunk : chunks)
+				if (chunk.failed)
+				{
+					error_log->PrintString("index out of range in %s\n", filename);
+					return false;
+				}
+
+			// Triangles of every material, faces without material get the default one
+			const u32 default_material = static_cast<u32>(materials_.size());
+			std::vector<std::vector<TriangleRange>> material_ranges(materials_.size() + 1);
+			for (const auto& chunk : chunks)
+			{
+				const u32 num_triangles = static_cast<u32>(chunk.corners.size() / 9);
+				for (size_t i = 0; i <= chunk.runs.size(); ++i)
+				{
+					TriangleRange range;
+					range.chunk = &chunk;
+					range.first_triangle = (i == 0) ? 0 : chunk.runs[i - 1].first_triangle;
+					range.end_triangle = (i == chunk.runs.size()) ? num_triangles : chunk.runs[i].first_triangle;
+					const s32 range_material = (i == 0) ? chunk.first_material : chunk.runs[i - 1].material;
+					if (range.first_triangle < range.end_triangle)
+						material_ranges[(range_material < 0) ? default_material : range_material].push_back(range);
+				}
+			}
+			if (!material_ranges.back().empty())
+			{
+				materials_.push_back(Material());
+				MakeDefaultMaterial(&materials_.back());
+			}
+			std::vector<u32> mesh_materials;
+			for (u32 i = 0; i < material_ranges.size(); ++i)
+				if (!material_ranges[i].empty())
+					mesh_materials.push_back(i);
+
+			// Unique corners become vertices
+			meshes_.resize(mesh_materials.size());
+			std::vector<math::Vector3> mins(meshes_.size()), maxs(meshes_.size());
+			system::ParallelFor(0, static_cast<int>(meshes_.size()), [&](int first, int last)
+			{
+				std::vector<u32> table;
+				std::vector<CornerKey> keys;
+				for (int i = first; i < last; ++i)
+				{
+					ObjMesh& mesh = meshes_[i];
+					mesh.material_index = mesh_materials[i];
+					const std::vector<TriangleRange>& ranges = material_ranges[mesh.material_index];
+					size_t num_corners = 0;
+					for (const auto& range : ranges)
+						num_corners += 3 * (range.end_triangle - range.first_triangle);
+					size_t table_size = 1;
+					while (table_size < 2 * num_corners)
+						table_size *= 2;
+					table.assign(table_size, kEmpty);
+					keys.clear();
+					mesh.indices.reserve(num_corners);
+					vec3 min(1e30f), max(-1e30f);
+					for (const auto& range : ranges)
+					{
+						const s32 * corner = &range.chunk->corners[9 * range.first_triangle];
+						const s32 * corners_end = &range.chunk->corners[0] + 9 * range.end_triangle;
+						for (; corner != corners_end; corner += 3)
+						{
+							size_t slot = HashCorner(corner) & (table_size - 1);
+							while (table[slot] != kEmpty)
+							{
+								const CornerKey& key = keys[table[slot]];
+								if (key.position == corner[0] && key.texcoord == corner[1] && key.normal == corner[2])
+									break;
+								slot = (slot + 1) & (table_size - 1);
+							}
+							if (table[slot] == kEmpty)
+							{
+								table[slot] = static_cast<u32>(keys.size());
+								CornerKey key = { corner[0], corner[1], corner[2] };
+								keys.push_back(key);
+								Vertex vertex = Vertex(); // welding compares all bytes
+								const f32 * position = &positions[3 * corner[0]];
+								vertex.position = vec3(position[0], position[1], position[2]);
+								if (corner[1] >= 0)
+								{
+									const f32 * texcoord = &texcoords[2 * corner[1]];
+									vertex.texcoord = vec2(texcoord[0], texcoord[1]);
+								}
+								if (corner[2] >= 0)
+								{
+									const f32 * normal = &normals[3 * corner[2]];
+									vertex.normal = vec3(normal[0], normal[1], normal[2]);
+								}
+								min.MakeFloor(vertex.position);
+								max.MakeCeil(vertex.position);
+								mesh.vertices.push_back(vertex);
+							}
+							mesh.indices.push_back(table[slot]);
+						}
+					}
+					mins[i] = min;
+					maxs[i] = max;
+				}
+			});
+
+			if (!meshes_.empty())
+			{
+				vec3 min = mins[0], max = maxs[0];
+				for (size_t i = 1; i < meshes_.size(); ++i)
+				{
+					min.MakeFloor(mins[i]);
+					max.MakeCeil(maxs[i]);
+				}
+				bounding_box_.center = 0.5f * (max + min);
+				bounding_box_.extent = 0.5f * (max - min);
+			}
+			return true;
+		}
+		const std::vector<Material>& ObjReader::materials() const
+		{
+			return materials_;
+		}
+		std::vector<ObjMesh>& ObjReader::meshes()
+		{
+			return meshes_;
+		}
+		const math::BoundingBox& ObjReader::bounding_box() const
+		{
+			return bounding_box_;
+		}
+
+		void ObjWriter::AddMaterial(const Material& material)
+		{
+			materials_.push_back(material);
+		}
+		void ObjWriter::AddMesh(const ObjMeshData& mesh)
+		{
+			meshes_.push_back(mesh);
+		}
+		bool ObjWriter::Save(const char *filename)
+		{
+			system::ErrorLogStream * error_log = system::ErrorLogStream::GetInstance();
+
+			// Material library has the same name
+			std::string library_filename = filename;
+			const size_t name_begin = library_filename.find_last_of("/\\") + 1;
+			const size_t dot = library_filename.find_last_of('.');
+			if (dot != std::string::npos && dot >= name_begin)
+				library_filename.resize(dot);
+			library_filename += ".mtl";
+
+			system::FileStream library;
+			if (!library.Open(library_filename.c_str(), system::StreamAccess::kWriteText))
+			{
+				error_log->PrintString("can't open for write %s\n", library_filename.c_str());
+				return false;
+			}
+			bool result = true;
+			for (size_t i = 0; i < materials_.size(); ++i)
+			{
+				const Material& m = materials_[i];
+				result = result && library.PrintString("newmtl material%u\n", static_cast<u32>(i)) &&
+					library.PrintString("Ka %.9g %.9g %.9g\n", m.ambient.x, m.ambient.y, m.ambient.z) &&
+					library.PrintString("Kd %.9g %.9g %.9g\n", m.diffuse.x, m.diffuse.y, m.diffuse.z) &&
+					library.PrintString("Ks %.9g %.9g %.9g\n", m.specular.x, m.specular.y, m.specular.z) &&
+					library.PrintString("Tf %.9g %.9g %.9g\n", m.transmittance.x, m.transmittance.y, m.transmittance.z) &&
+					library.PrintString("Ke %.9g %.9g %.9g\n", m.emission.x, m.emission.y, m.emission.z) &&
+					library.PrintString("Ns %.9g\nd %.9g\n\n", m.shininess, m.dissolve);
+			}
+
+			system::FileStream file;
+			if (!file.Open(filename, system::StreamAccess::kWriteBinary))
+			{
+				error_log->PrintString("can't open for write %s\n", filename);
+				return false;
+			}
+			// Lines are gathered in a buffer to avoid many small writes
+			std::string buffer;
+			const size_t kFlushSize = 1 << 20;
+			char line[128];
+			auto append = [&](int length) {
+				// Truncated line must not be read past its buffer
+				buffer.append(line, std::min(static_cast<size_t>(std::max(length, 0)), sizeof(line) - 1));
+				if (buffer.size() >= kFlushSize)
+				{
+					result = result && file.Write(buffer.data(), buffer.size());
+					buffer.clear();
+				}
+			};
+			// Library name may be longer than line buffer
+			buffer = "mtllib " + library_filename.substr(name_begin) + "\n";
+			u32 first_vertex = 1;
+			for (const auto& mesh : meshes_)
+			{
+				for (u32 i = 0; i < mesh.num_vertices; ++i)
+				{
+					const Vertex& v = mesh.vertices[i];
+					append(snprintf(line, sizeof(line), "v %.9g %.9g %.9g\n", v.position.x, v.position.y, v.position.z));
+					append(snprintf(line, sizeof(line), "vt %.9g %.9g\n", v.texcoord.x, v.texcoord.y));
+					append(snprintf(line, sizeof(line), "vn %.9g %.9g %.9g\n", v.normal.x, v.normal.y, v.normal.z));
+				}
+				append(snprintf(line, sizeof(line), "usemtl material%u\n", mesh.material_index));
+				const u32 num_corners = (mesh.indices != nullptr) ? mesh.num_indices : mesh.num_vertices;
+				for (u32 i = 0; i + 2 < num_corners; i += 3)
+				{
+					u32 a = i, b = i + 1, c = i + 2;
+					if (mesh.indices != nullptr)
+					{
+						a = mesh.indices[a];
+						b = mesh.indices[b];
+						c = mesh.indices[c];
+					}
+					a += first_vertex;
+					b += first_vertex;
+					c += first_vertex;
+					append(snprintf(line, sizeof(line), "f %u/%u/%u %u/%u/%u %u/%u/%u\n", a, a, a, b, b, b, c, c, c));
+				}
+				first_vertex += mesh.num_vertices;
+			}
+			if (!buffer.empty())
+				result = result && file.Write(buffer.data(), buffer.size());
+			if (!result)
+				error_log->PrintString("failed to write %s\n", filename);
+			return result;
+		}
+
+	} // namespace graphics
+} // namespace sht
@@ -0,0 +1,537 @@
+#include "../../include/model/scm_file.h"
+
+#include "../../../system/include/stream/file_stream.h"
+#include "../../../system/include/stream/log_stream.h"
+#include "../../../utility/include/string_id.h"
+#include "../../../thirdparty/zlib/include/zlib.h"
+
+#include <algorithm>
+#include <assert.h>
+#include <cstring>
+
+namespace {
+
+	using namespace sht::graphics;
+
+	const uint32_t kSignature = ConstexprStringId("SCM");
+	// Small sections go first in this order, vertex and index sections follow them
+	const u32 kNumTableSections = 5;
+	const u32 kInvalidSection = 0xffffffff;
+
+	static_assert(sizeof(ScmHeader) == 64, "header should keep sections aligned");
+	static_assert(sizeof(ScmSection) == 40 && sizeof(ScmMeshEntry) == 64 && sizeof(ScmNode) == 32,
+		"scm structure has changed, update .scm file version");
+	static_assert(sizeof(Material) == 5 * sizeof(sht::math::Vector3) + 2 * sizeof(float),
+		"material structure has changed, update .scm file version");
+
+	//! Vertex bytes are grouped by position in vertex and every group is delta coded,
+	//! so slowly changing components turn into runs of small values that deflate well.
+	void FilterVertices(const u8 * data, size_t size, u32 stride, u8 * output)
+	{
+		const size_t count = size / stride;
+		for (u32 b = 0; b < stride; ++b)
+		{
+			u8 previous = 0;
+			u8 * plane = output + b * count;
+			for (size_t i = 0; i < count; ++i)
+			{
+				const u8 value = data[i * stride + b];
+				plane[i] = static_cast<u8>(value - previous);
+				previous = value;
+			}
+		}
+	}
+	void UnfilterVertices(const u8 * data, size_t size, u32 stride, u8 * output)
+	{
+		const size_t count = size / stride;
+		for (u32 b = 0; b < stride; ++b)
+		{
+			u8 previous = 0;
+			const u8 * plane = data + b * count;
+			for (size_t i = 0; i < count; ++i)
+			{
+				previous = static_cast<u8>(previous + plane[i]);
+				output[i * stride + b] = previous;
+			}
+		}
+	}
+	u32 ReadIndex(const u8 * data, u32 stride)
+	{
+		if (stride == sizeof(u16))
+		{
+			u16 value;
+			memcpy(&value, data, sizeof(value));
+			return value;
+		}
+		u32 value;
+		memcpy(&value, data, sizeof(value));
+		return value;
+	}
+	void WriteIndex(u32 value, u32 stride, u8 * data)
+	{
+		if (stride == sizeof(u16))
+		{
+			const u16 short_value = static_cast<u16>(value);
+			memcpy(data, &short_value, sizeof(short_value));
+		}
+		else
+			memcpy(data, &value, sizeof(value));
+	}
+	//! Indices are replaced by differences from previous ones, bytes of differences are grouped like vertex bytes
+	void FilterIndices(const u8 * data, size_t size, u32 stride, u8 * output)
+	{
+		const size_t count = size / stride;
+		u32 previous = 0;
+		u8 delta_bytes[sizeof(u32)];
+		for (size_t i = 0; i < count; ++i)
+		{
+			const u32 index = ReadIndex(data + i * stride, stride);
+			WriteIndex(index - previous, stride, delta_bytes);
+			previous = index;
+			for (u32 b = 0; b < stride; ++b)
+				output[b * count + i] = delta_bytes[b];
+		}
+	}
+	void UnfilterIndices(const u8 * data, size_t size, u32 stride, u8 * output)
+	{
+		const size_t count = size / stride;
+		u32 previous = 0;
+		u8 delta_bytes[sizeof(u32)];
+		for (size_t i = 0; i < count; ++i)
+		{
+			for (u32 b = 0; b < stride; ++b)
+				delta_bytes[b] = data[b * count + i];
+			previous += ReadIndex(delta_bytes, stride);
+			WriteIndex(previous, stride, output + i * stride);
+		}
+	}
+
+	//! Section waiting to be written
+	struct PendingSection {
+		ScmSection section;
+		const u8 * data;
+		std::vector<u8> encoded;	//!< compressed data
+	};
+
+	void AddSection(std::vector<PendingSection> * sections, ScmSectionType type, const void * data, size_t size,
+		u32 stride, ScmCompression compression)
+	{
+		sections->push_back(PendingSection());
+		PendingSection& pending = sections->back();
+		pending.section.type = type;
+		pending.section.compression = ScmCompression::kNone;
+		pending.section.stride = stride;
+		pending.section.reserved = 0;
+		pending.section.offset = 0;
+		pending.section.size = size;
+		pending.section.raw_size = size;
+		pending.data = static_cast<const u8*>(data);
+		if (compression == ScmCompression::kNone || size == 0)
+			return;
+
+		std::vector<u8> filtered;
+		const u8 * source = pending.data;
+		if (compression == ScmCompression::kFiltered)
+		{
+			filtered.resize(size);
+			if (type == ScmSectionType::kIndices)
+				FilterIndices(source, size, stride, &filtered[0]);
+			else
+				FilterVertices(source, size, stride, &filtered[0]);
+			source = &filtered[0];
+		}
+		uLongf compressed_size = compressBound(static_cast<uLong>(size));
+		pending.encoded.resize(compressed_size);
+		if (compress2(&pending.encoded[0], &compressed_size, source, static_cast<uLong>(size), Z_BEST_COMPRESSION) != Z_OK ||
+			compressed_size >= size)
+		{
+			// Data that doesn't shrink is stored as is
+			pending.encoded.clear();
+			return;
+		}
+		pending.encoded.resize(compressed_size);
+		pending.section.compression = compression;
+		pending.section.size = compressed_size;
+		pending.data = &pending.encoded[0];
+	}
+
+	sht::math::BoundingBox UniteBoxes(const std::vector<sht::math::BoundingBox>& boxes, const u32 * items, size_t count)
+	{
+		vec3 min = boxes[items[0]].center - boxes[items[0]].extent;
+		vec3 max = boxes[items[0]].center + boxes[items[0]].extent;
+		for (size_t i = 1; i < count; ++i)
+		{
+			const sht::math::BoundingBox& box = boxes[items[i]];
+			min.MakeFloor(box.center - box.extent);
+			max.MakeCeil(box.center + box.extent);
+		}
+		sht::math::BoundingBox result;
+		result.center = 0.5f * (max + min);
+		result.extent = 0.5f * (max - min);
+		return result;
+	}
+	void BuildNode(const std::vector<sht::math::BoundingBox>& boxes, u32 * items, size_t count,
+		std::vector<ScmNode> * nodes)
+	{
+		const size_t index = nodes->size();
+		nodes->push_back(ScmNode());
+		(*nodes)[index].bounding_box = UniteBoxes(boxes, items, count);
+		if (count == 1)
+		{
+			(*nodes)[index].mesh = static_cast<s32>(items[0]);
+			(*nodes)[index].skip = static_cast<u32>(index + 1);
+			return;
+		}
+		const vec3& extent = (*nodes)[index].bounding_box.extent;
+		const int axis = (extent.x >= extent.y && extent.x >= extent.z) ? 0 : ((extent.y >= extent.z) ? 1 : 2);
+		const size_t half = count / 2;
+		std::nth_element(items, items + half, items + count, [&boxes, axis](u32 a, u32 b) {
+			return boxes[a].center[axis] < boxes[b].center[axis];
+		});
+		BuildNode(boxes, items, half, nodes);
+		BuildNode(boxes, items + half, count - half, nodes);
+		(*nodes)[index].mesh = -1;
+		(*nodes)[index].skip = static_cast<u32>(nodes->size());
+	}
+
+} // namespace
+
+namespace sht {
+	namespace graphics {
+
+		void BuildScmHierarchy(const std::vector<math::BoundingBox>& boxes, std::vector<ScmNode> * nodes)
+		{
+			nodes->clear();
+			if (boxes.empty())
+				return;
+			std::vector<u32> items(boxes.size());
+			for (size_t i = 0; i < items.size(); ++i)
+				items[i] = static_cast<u32>(i);
+			nodes->reserve(2 * boxes.size() - 1);
+			BuildNode(boxes, &items[0], items.size(), nodes);
+		}
+
+		ScmWriter::ScmWriter()
+		: compression_(ScmCompression::kNone)
+		, header_()
+		{
+			header_.signature = kSignature;
+			header_.version = kScmVersion;
+			header_.quantization.scale = 1.0f;
+		}
+		void ScmWriter::set_compression(ScmCompression compression)
+		{
+			compression_ = compression;
+		}
+		void ScmWriter::SetVertexFormat(const std::vector<VertexAttribute>& attribs, u32 vertex_size,
+			const VertexQuantization& quantization)
+		{
+			attribs_.resize(attribs.size());
+			for (size_t i = 0; i < attribs.size(); ++i)
+			{
+				attribs_[i].type = static_cast<u32>(attribs[i].type);
+				attribs_[i].size = attribs[i].size;
+				attribs_[i].format = static_cast<u32>(attribs[i].format);
+				attribs_[i].reserved = 0;
+			}
+			header_.vertex_size = vertex_size;
+			header_.quantization = quantization;
+		}
+		void ScmWriter::SetBoundingBox(const math::BoundingBox& bounding_box)
+		{
+			header_.bounding_box = bounding_box;
+		}
+		void ScmWriter::AddMaterial(const Material& material)
+		{
+			materials_.push_back(material);
+		}
+		void ScmWriter::AddMesh(const ScmMesh& mesh)
+		{
+			meshes_.push_back(mesh);
+		}
+		bool ScmWriter::Save(const char *filename)
+		{
+			system::ErrorLogStream * error_log = system::ErrorLogStream::GetInstance();
+
+			// Describe meshes, their data sections follow table ones
+			std::vector<ScmMeshEntry> entries(meshes_.size());
+			std::vector<ScmLod> lods;
+			std::vector<math::BoundingBox> boxes(meshes_.size());
+			u32 num_sections = kNumTableSections;
+			for (size_t i = 0; i < meshes_.size(); ++i)
+			{
+				const ScmMesh& mesh = meshes_[i];
+				ScmMeshEntry& entry = entries[i]; // value initialized by vector
+				entry.material_index = mesh.material_index;
+				entry.primitive_mode = mesh.primitive_mode;
+				entry.num_vertices = mesh.num_vertices;
+				entry.num_indices = (mesh.indices != nullptr) ? mesh.num_indices : 0;
+				entry.index_size = mesh.index_size;
+				entry.vertex_section = num_sections++;
+				entry.index_section = (entry.num_indices != 0) ? num_sections++ : kInvalidSection;
+				entry.first_lod = static_cast<u32>(lods.size());
+				entry.num_lods = static_cast<u32>(mesh.lods.size());
+				entry.bounding_box = mesh.bounding_box;
+				lods.insert(lods.end(), mesh.lods.begin(), mesh.lods.end());
+				boxes[i] = mesh.bounding_box;
+			}
+			std::vector<ScmNode> hierarchy;
+			BuildScmHierarchy(boxes, &hierarchy);
+
+			std::vector<PendingSection> sections;
+			sections.reserve(num_sections);
+			AddSection(&sections, ScmSectionType::kAttributes, attribs_.data(), attribs_.size() * sizeof(ScmAttribute),
+				sizeof(ScmAttribute), ScmCompression::kNone);
+			AddSection(&sections, ScmSectionType::kMaterials, materials_.data(), materials_.size() * sizeof(Material),
+				sizeof(Material), ScmCompression::kNone);
+			AddSection(&sections, ScmSectionType::kMeshes, entries.data(), entries.size() * sizeof(ScmMeshEntry),
+				sizeof(ScmMeshEntry), ScmCompression::kNone);
+			AddSection(&sections, ScmSectionType::kLods, lods.data(), lods.size() * sizeof(ScmLod),
+				sizeof(ScmLod), ScmCompression::kNone);
+			AddSection(&sections, ScmSectionType::kHierarchy, hierarchy.data(), hierarchy.size() * sizeof(ScmNode),
+				sizeof(ScmNode), ScmCompression::kNone);
+			for (size_t i = 0; i < meshes_.size(); ++i)
+			{
+				const ScmMesh& mesh = meshes_[i];
+				AddSection(&sections, ScmSectionType::kVertices, mesh.vertices,
+					static_cast<size_t>(mesh.num_vertices) * header_.vertex_size, header_.vertex_size, compression_);
+				if (entries[i].index_section != kInvalidSection)
+					AddSection(&sections, ScmSectionType::kIndices, mesh.indices,
+						static_cast<size_t>(mesh.num_indices) * mesh.index_size, mesh.index_size, compression_);
+			}
+			assert(sections.size() == num_sections);
+
+			// Place sections
+			u64 offset = sizeof(ScmHeader) + num_sections * sizeof(ScmSection);
+			for (auto& pending : sections)
+			{
+				offset = (offset + kScmAlignment - 1) / kScmAlignment * kScmAlignment;
+				pending.section.offset = offset;
+				offset += pending.section.size;
+			}
+
+			system::FileStream file;
+			if (!file.Open(filename, system::StreamAccess::kWriteBinary))
+			{
+				error_log->PrintString("can't open for write %s\n", filename);
+				return false;
+			}
+			header_.num_sections = num_sections;
+			bool result = file.Write(&header_, sizeof(header_));
+			for (const auto& pending : sections)
+				result = result && file.Write(&pending.section, sizeof(ScmSection));
+			u64 position = sizeof(ScmHeader) + num_sections * sizeof(ScmSection);
+			const u8 padding[kScmAlignment] = { 0 };
+			for (const auto& pending : sections)
+			{
+				if (pending.section.offset != position)
+					result = result && file.Write(padding, static_cast<size_t>(pending.section.offset - position));
+				if (pending.section.size != 0)
+					result = result && file.Write(pending.data, static_cast<size_t>(pending.section.size));
+				position = pending.section.offset + pending.section.size;
+			}
+			if (!result)
+				error_log->PrintString("failed to write %s\n", filename);
+			return result;
+		}
+
+		ScmReader::ScmReader()
+		: header_()
+		, sections_(nullptr)
+		, num_decompressed_bytes_(0)
+		{
+		}
+		u32 ScmReader::ReadVersion(const char *filename)
+		{
+			system::FileStream file;
+			if (!file.Open(filename, system::StreamAccess::kReadBinary))
+				return 0;
+			uint32_t values[2];
+			if (!file.Read(values, sizeof(values)) || values[0] != kSignature)
+				return 0;
+			return values[1];
+		}
+		bool ScmReader::Open(const char *filename)
+		{
+			system::ErrorLogStream * error_log = system::ErrorLogStream::GetInstance();
+			Close();
+			if (!file_.Open(filename))
+			{
+				error_log->PrintString("can't open %s\n", filename);
+				return false;
+			}
+			if (file_.size() < sizeof(ScmHeader))
+			{
+				error_log->PrintString("file is too small (%s)\n", filename);
+				Close();
+				return false;
+			}
+			header_ = *reinterpret_cast<const ScmHeader*>(file_.data());
+			if (header_.signature != kSignature || header_.version != kScmVersion)
+			{
+				error_log->PrintString("wrong file signature or version (%s)\n", filename);
+				Close();
+				return false;
+			}
+			const u64 table_end = sizeof(ScmHeader) + static_cast<u64>(header_.num_sections) * sizeof(ScmSection);
+			bool valid = header_.num_sections >= kNumTableSections && table_end <= file_.size();
+			if (valid)
+			{
+				sections_ = reinterpret_cast<const ScmSection*>(file_.data() + sizeof(ScmHeader));
+				for (u32 i = 0; i < header_.num_sections && valid; ++i)
+					valid = sections_[i].offset % kScmAlignment == 0 && sections_[i].offset >= table_end &&
+						sections_[i].offset + sections_[i].size <= file_.size();
+			}
+			if (!valid)
+			{
+				error_log->PrintString("broken section table (%s)\n", filename);
+				Close();
+				return false;
+			}
+
+			// Table sections are small, so they are copied
+			const u32 num_attribs = static_cast<u32>(sections_[0].raw_size / sizeof(ScmAttribute));
+			const ScmAttribute * attribs = reinterpret_cast<const ScmAttribute*>(
+				GetSection(0, num_attribs * sizeof(ScmAttribute)));
+			const u32 num_materials = static_cast<u32>(sections_[1].raw_size / sizeof(Material));
+			const Material * materials = reinterpret_cast<const Material*>(
+				GetSection(1, num_materials * sizeof(Material)));
+			const u32 num_meshes = static_cast<u32>(sections_[2].raw_size / sizeof(ScmMeshEntry));
+			const ScmMeshEntry * entries = reinterpret_cast<const ScmMeshEntry*>(
+				GetSection(2, num_meshes * sizeof(ScmMeshEntry)));
+			const u32 num_lods = static_cast<u32>(sections_[3].raw_size / sizeof(ScmLod));
+			const ScmLod * lods = reinterpret_cast<const ScmLod*>(GetSection(3, num_lods * sizeof(ScmLod)));
+			const u32 num_nodes = static_cast<u32>(sections_[4].raw_size / sizeof(ScmNode));
+			const ScmNode * nodes = reinterpret_cast<const ScmNode*>(GetSection(4, num_nodes * sizeof(ScmNode)));
+			if (attribs == nullptr || materials == nullptr || entries == nullptr || lods == nullptr || nodes == nullptr)
+			{
+				error_log->PrintString("broken file tables (%s)\n", filename);
+				Close();
+				return false;
+			}
+			for (u32 i = 0; i < num_attribs; ++i)
+				attribs_.push_back(VertexAttribute(static_cast<VertexAttribute::Type>(attribs[i].type), attribs[i].size,
+					0, static_cast<VertexAttribute::Format>(attribs[i].format)));
+			materials_.assign(materials, materials + num_materials);
+			hierarchy_.assign(nodes, nodes + num_nodes);
+			for (u32 i = 0; i < num_nodes && valid; ++i)
+				valid = nodes[i].mesh < static_cast<s32>(num_meshes) && nodes[i].skip > i && nodes[i].skip <= num_nodes;
+
+			// Meshes point at their data
+			meshes_.resize(num_meshes);
+			for (u32 i = 0; i < num_meshes && valid; ++i)
+			{
+				const ScmMeshEntry& entry = entries[i];
+				ScmMesh& mesh = meshes_[i];
+				mesh.material_index = entry.material_index;
+				mesh.primitive_mode = entry.primitive_mode;
+				mesh.bounding_box = entry.bounding_box;
+				mesh.num_vertices = entry.num_vertices;
+				mesh.num_indices = entry.num_indices;
+				mesh.index_size = entry.index_size;
+				valid = entry.vertex_section < header_.num_sections && entry.first_lod + entry.num_lods <= num_lods;
+				if (!valid)
+					break;
+				mesh.vertices = GetSection(entry.vertex_section,
+					static_cast<u64>(entry.num_vertices) * header_.vertex_size);
+				mesh.indices = nullptr;
+				if (entry.index_section != kInvalidSection)
+				{
+					valid = entry.index_section < header_.num_sections &&
+						(entry.index_size == sizeof(u16) || entry.index_size == sizeof(u32));
+					if (!valid)
+						break;
+					mesh.indices = GetSection(entry.index_section,
+						static_cast<u64>(entry.num_indices) * entry.index_size);
+					valid = mesh.indices != nullptr;
+				}
+				valid = valid && (mesh.vertices != nullptr || entry.num_vertices == 0);
+				mesh.lods.assign(lods + entry.first_lod, lods + entry.first_lod + entry.num_lods);
+				for (const auto& lod : mesh.lods)
+					valid = valid && lod.first_index + lod.num_indices <= entry.num_indices;
+			}
+			if (!valid)
+			{
+				error_log->PrintString("broken mesh data (%s)\n", filename);
+				Close();
+				return false;
+			}
+			return true;
+		}
+		void ScmReader::Close()
+		{
+			file_.Close();
+			sections_ = nullptr;
+			attribs_.clear();
+			materials_.clear();
+			meshes_.clear();
+			hierarchy_.clear();
+			buffers_.clear();
+			num_decompressed_bytes_ = 0;
+		}
+		const u8 * ScmReader::GetSection(u32 index, u64 expected_size)
+		{
+			static const u8 kEmpty = 0;
+			const ScmSection& section = sections_[index];
+			if (section.raw_size != expected_size)
+				return nullptr;
+			if (section.raw_size == 0)
+				return &kEmpty;
+			const u8 * data = file_.data() + section.offset;
+			if (section.compression == ScmCompression::kNone)
+				return (section.size == section.raw_size) ? data : nullptr;
+
+			buffers_.push_back(std::vector<u8>(static_cast<size_t>(section.raw_size)));
+			std::vector<u8>& buffer = buffers_.back();
+			uLongf size = static_cast<uLongf>(section.raw_size);
+			if (uncompress(&buffer[0], &size, data, static_cast<uLong>(section.size)) != Z_OK || size != section.raw_size)
+				return nullptr;
+			if (section.compression == ScmCompression::kFiltered)
+			{
+				if (section.stride == 0 || section.raw_size % section.stride != 0)
+					return nullptr;
+				std::vector<u8> filtered(buffer.size());
+				filtered.swap(buffer);
+				if (section.type == ScmSectionType::kIndices)
+					UnfilterIndices(&filtered[0], filtered.size(), section.stride, &buffer[0]);
+				else
+					UnfilterVertices(&filtered[0], filtered.size(), section.stride, &buffer[0]);
+			}
+			num_decompressed_bytes_ += static_cast<u32>(section.raw_size);
+			return &buffer[0];
+		}
+		const math::BoundingBox& ScmReader::bounding_box() const
+		{
+			return header_.bounding_box;
+		}
+		const VertexQuantization& ScmReader::quantization() const
+		{
+			return header_.quantization;
+		}
+		u32 ScmReader::vertex_size() const
+		{
+			return header_.vertex_size;
+		}
+		const std::vector<VertexAttribute>& ScmReader::attribs() const
+		{
+			return attribs_;
+		}
+		const std::vector<Material>& ScmReader::materials() const
+		{
+			return materials_;
+		}
+		const std::vector<ScmMesh>& ScmReader::meshes() const
+		{
+			return meshes_;
+		}
+		const std::vector<ScmNode>& ScmReader::hierarchy() const
+		{
+			return hierarchy_;
+		}
+		u32 ScmReader::num_decompressed_bytes() const
+		{
+			return num_decompressed_bytes_;
+		}
+
+	} // namespace graphics
+} // namespace sht
@@ -0,0 +1,135 @@
+#include "../../include/model/vertex_packer.h"
+#include "../../include/renderer/vertex_packing.h"
+
+#include <algorithm>
+#include <assert.h>
+#include <cfloat>
+
+namespace sht {
+	namespace graphics {
+
+		VertexPacker::VertexPacker(u32 compression)
+		: compression_(compression)
+		, min_position_(FLT_MAX)
+		, max_position_(-FLT_MAX)
+		, min_texcoord_(FLT_MAX)
+		, max_texcoord_(-FLT_MAX)
+		, num_vertices_(0)
+		{
+			quantization_.offset = vec3(0.0f);
+			quantization_.scale = 1.0f;
+		}
+		void VertexPacker::AddVertices(const std::vector<Vertex>& vertices)
+		{
+			for (const auto& v : vertices)
+			{
+				for (int i = 0; i < 3; ++i)
+				{
+					min_position_[i] = std::min(min_position_[i], v.position[i]);
+					max_position_[i] = std::max(max_position_[i], v.position[i]);
+				}
+				for (int i = 0; i < 2; ++i)
+				{
+					min_texcoord_[i] = std::min(min_texcoord_[i], v.texcoord[i]);
+					max_texcoord_[i] = std::max(max_texcoord_[i], v.texcoord[i]);
+				}
+			}
+			num_vertices_ += static_cast<u32>(vertices.size());
+		}
+		void VertexPacker::ChooseFormats(std::vector<VertexAttribute> * attribs)
+		{
+			for (auto& a : *attribs)
+			{
+				if (a.format != VertexAttribute::kFloat)
+					continue;
+				switch (a.type)
+				{
+				case VertexAttribute::kVertex:
+					if ((compression_ & kQuantizePositions) && num_vertices_ != 0)
+						a.format = VertexAttribute::kSnorm16;
+					break;
+				case VertexAttribute::kNormal:
+				case VertexAttribute::kTangent:
+				case VertexAttribute::kBinormal:
+					if (compression_ & kCompressNormals)
+						a.format = VertexAttribute::kSnorm10;
+					break;
+				case VertexAttribute::kTexcoord:
+					if ((compression_ & kCompressTexcoords) && num_vertices_ != 0)
+					{
+						const f32 min_value = std::min(min_texcoord_.x, min_texcoord_.y);
+						const f32 max_value = std::max(max_texcoord_.x, max_texcoord_.y);
+						if (min_value >= 0.0f && max_value <= 1.0f)
+							a.format = VertexAttribute::kUnorm16;
+						else if (min_value >= -1.0f && max_value <= 1.0f)
+							a.format = VertexAttribute::kSnorm16;
+						else
+							a.format = VertexAttribute::kHalf;
+					}
+					break;
+				default:
+					break;
+				}
+			}
+			quantization_.offset = vec3(0.0f);
+			quantization_.scale = 1.0f;
+			for (const auto& a : *attribs)
+			{
+				if (a.type == VertexAttribute::kVertex && IsAttributeNormalized(a.format) && num_vertices_ != 0)
+				{
+					// Cube around bounds, normalized range is [-1,1]
+					quantization_.offset = 0.5f * (min_position_ + max_position_);
+					const vec3 extent = 0.5f * (max_position_ - min_position_);
+					const f32 scale = std::max(extent.x, std::max(extent.y, extent.z));
+					quantization_.scale = (scale > 0.0f) ? scale : 1.0f;
+				}
+			}
+		}
+		void VertexPacker::Pack(const std::vector<Vertex>& vertices, const std::vector<VertexAttribute>& attribs,
+			u32 vertex_size, u8 * data) const
+		{
+			const f32 inv_scale = 1.0f / quantization_.scale;
+			for (const auto& v : vertices)
+			{
+				u8 * ptr = data;
+				for (const auto& a : attribs)
+				{
+					switch (a.type)
+					{
+					case VertexAttribute::kVertex:
+						if (IsAttributeNormalized(a.format))
+						{
+							vec3 position = (v.position - quantization_.offset) * inv_scale;
+							PackAttribute(a.format, position, a.size, ptr);
+						}
+						else
+							PackAttribute(a.format, v.position, a.size, ptr);
+						break;
+					case VertexAttribute::kNormal:
+						PackAttribute(a.format, v.normal, a.size, ptr);
+						break;
+					case VertexAttribute::kTexcoord:
+						PackAttribute(a.format, v.texcoord, a.size, ptr);
+						break;
+					case VertexAttribute::kTangent:
+						PackAttribute(a.format, v.tangent, a.size, ptr);
+						break;
+					case VertexAttribute::kBinormal:
+						PackAttribute(a.format, v.binormal, a.size, ptr);
+						break;
+					default:
+						assert(!"Unknown vertex attribute");
+					}
+					ptr += GetAttributeSize(a.format, a.size);
+				}
+				assert(ptr == data + vertex_size);
+				data += vertex_size;
+			}
+		}
+		const VertexQuantization& VertexPacker::quantization() const
+		{
+			return quantization_;
+		}
+
+	} // namespace graphics
+} // namespace sht
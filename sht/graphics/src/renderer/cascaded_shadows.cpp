@@ -0,0 +1,174 @@
+#include "../../include/renderer/cascaded_shadows.h"
+
+#include <assert.h>
+#include <cmath>
+
+namespace sht {
+	namespace graphics {
+
+		CascadedShadows::CascadedShadows(int num_cascades, int resolution)
+		: light_direction_(0.0f, -1.0f, 0.0f)
+		, num_cascades_(num_cascades)
+		, resolution_(resolution)
+		, split_lambda_(0.75f)
+		, caster_distance_(50.0f)
+		{
+			assert(num_cascades > 0 && num_cascades <= kMaxCascades);
+			for (int i = 0; i < kMaxCascades; ++i)
+			{
+				cascades_[i].radius = 0.0f;
+				cascades_[i].split_near = 0.0f;
+				cascades_[i].split_far = 0.0f;
+				cascades_[i].static_valid = false;
+				static_rendered_[i] = false;
+			}
+		}
+		void CascadedShadows::Update(const math::Matrix4& camera_view, float fov, float aspect, float znear, float zfar,
+			const math::Vector3& light_direction)
+		{
+			light_direction_ = light_direction.GetNormalized();
+
+			// Practical split scheme: blend of logarithmic and uniform distributions
+			for (int i = 0; i < num_cascades_; ++i)
+			{
+				float t = static_cast<float>(i + 1) / static_cast<float>(num_cascades_);
+				float log_split = znear * powf(zfar / znear, t);
+				float uniform_split = znear + (zfar - znear) * t;
+				cascades_[i].split_near = (i == 0) ? znear : cascades_[i - 1].split_far;
+				cascades_[i].split_far = (i == num_cascades_ - 1) ? zfar
+					: split_lambda_ * log_split + (1.0f - split_lambda_) * uniform_split;
+			}
+
+			const float kDegToRad = 0.0174532925f;
+			const float tan_half_fov = tanf(0.5f * fov * kDegToRad);
+			const math::Matrix4 camera_world = camera_view.GetInverse();
+			for (int i = 0; i < num_cascades_; ++i)
+			{
+				Cascade& cascade = cascades_[i];
+				FitCascade(cascade, camera_world, tan_half_fov, aspect);
+				cascade.static_valid = static_rendered_[i] && static_matrices_[i] == cascade.projection_view;
+			}
+		}
+		void CascadedShadows::FitCascade(Cascade& cascade, const math::Matrix4& camera_world, float tan_half_fov, float aspect)
+		{
+			// Bounding sphere of the slice is computed in camera space, so its radius doesn't depend on camera rotation
+			math::Vector3 corners[8];
+			const float distances[2] = { cascade.split_near, cascade.split_far };
+			for (int d = 0; d < 2; ++d)
+			{
+				float h = distances[d] * tan_half_fov;
+				float w = h * aspect;
+				corners[d * 4 + 0] = math::Vector3(-w, -h, -distances[d]);
+				corners[d * 4 + 1] = math::Vector3( w, -h, -distances[d]);
+				corners[d * 4 + 2] = math::Vector3( w,  h, -distances[d]);
+				corners[d * 4 + 3] = math::Vector3(-w,  h, -distances[d]);
+			}
+			math::Vector3 center(0.0f);
+			for (int i = 0; i < 8; ++i)
+				center += corners[i];
+			center /= 8.0f;
+			float radius = 0.0f;
+			for (int i = 0; i < 8; ++i)
+			{
+				float distance = center.Distance(corners[i]);
+				if (distance > radius)
+					radius = distance;
+			}
+			// Quantize radius to hide float noise of different camera orientations
+			const float kRadiusStep = 1.0f / 16.0f;
+			radius = ceilf(radius / kRadiusStep) * kRadiusStep;
+
+			// Light view has fixed orientation and origin, so the projection only slides in texel steps
+			// Reference axis mustn't be parallel to light, vertical light is the default one
+			const math::Vector3& axis = (fabsf(light_direction_.y) > 0.99f) ? UNIT_X : UNIT_Y;
+			math::Vector3 side = light_direction_ ^ axis;
+			side.Normalize();
+			const math::Vector3 up = side ^ light_direction_;
+			cascade.view = math::ViewMatrix(light_direction_, up, math::Vector3(0.0f));
+			math::Vector3 light_center = cascade.view.TransformPoint(camera_world.TransformPoint(center));
+			const float texel_size = 2.0f * radius / static_cast<float>(resolution_);
+			light_center.x = floorf(light_center.x / texel_size) * texel_size;
+			light_center.y = floorf(light_center.y / texel_size) * texel_size;
+			light_center.z = floorf(light_center.z / texel_size) * texel_size;
+
+			cascade.center = light_center;
+			cascade.radius = radius;
+			cascade.projection = math::OrthoMatrix(
+				light_center.x - radius, light_center.x + radius,
+				light_center.y - radius, light_center.y + radius,
+				-light_center.z - radius - caster_distance_, -light_center.z + radius);
+			cascade.projection_view = cascade.projection * cascade.view;
+			cascade.frustum.Load(cascade.projection_view);
+		}
+		bool CascadedShadows::IsCasterVisible(int index, const math::BoundingBox& box) const
+		{
+			assert(index >= 0 && index < num_cascades_);
+			return cascades_[index].frustum.IsCasterBoxIn(box);
+		}
+		u32 CascadedShadows::CullCasters(int index, const math::BoundingBox * boxes, u32 count, std::vector<u32> * visible) const
+		{
+			assert(index >= 0 && index < num_cascades_);
+			const math::Frustum& frustum = cascades_[index].frustum;
+			visible->clear();
+			for (u32 i = 0; i < count; ++i)
+				if (frustum.IsCasterBoxIn(boxes[i]))
+					visible->push_back(i);
+			return static_cast<u32>(visible->size());
+		}
+		void CascadedShadows::MarkStaticRendered(int index)
+		{
+			assert(index >= 0 && index < num_cascades_);
+			static_matrices_[index] = cascades_[index].projection_view;
+			static_rendered_[index] = true;
+			cascades_[index].static_valid = true;
+		}
+		void CascadedShadows::InvalidateStatic()
+		{
+			for (int i = 0; i < kMaxCascades; ++i)
+			{
+				static_rendered_[i] = false;
+				cascades_[i].static_valid = false;
+			}
+		}
+		int CascadedShadows::SelectCascade(float view_depth) const
+		{
+			for (int i = 0; i < num_cascades_ - 1; ++i)
+				if (view_depth < cascades_[i].split_far)
+					return i;
+			return num_cascades_ - 1;
+		}
+		math::Matrix4 CascadedShadows::GetShadowMatrix(int index) const
+		{
+			assert(index >= 0 && index < num_cascades_);
+			const math::Matrix4 bias_matrix(
+				0.5f, 0.0f, 0.0f, 0.0f,
+				0.0f, 0.5f, 0.0f, 0.0f,
+				0.0f, 0.0f, 0.5f, 0.0f,
+				0.5f, 0.5f, 0.5f, 1.0f
+			);
+			return bias_matrix * cascades_[index].projection_view;
+		}
+		void CascadedShadows::set_split_lambda(float lambda)
+		{
+			split_lambda_ = lambda;
+		}
+		void CascadedShadows::set_caster_distance(float distance)
+		{
+			caster_distance_ = distance;
+		}
+		int CascadedShadows::num_cascades() const
+		{
+			return num_cascades_;
+		}
+		int CascadedShadows::resolution() const
+		{
+			return resolution_;
+		}
+		const CascadedShadows::Cascade& CascadedShadows::cascade(int index) const
+		{
+			assert(index >= 0 && index < num_cascades_);
+			return cascades_[index];
+		}
+
+	} // namespace graphics
+} // namespace sht
@@ -6,9 +6,15 @@
 namespace sht {
     namespace graphics {
         
+        namespace {
+            const u32 kUnknownObject = 0xFFFFFFFF;
+        }
+        
         Context::Context()
         {
-            
+            InvalidateState();
+            counters_.issued = counters_.filtered = 0;
+            last_frame_counters_ = counters_;
         }
         Context::~Context()
         {
@@ -22,6 +28,238 @@ namespace sht {
             fprintf(stdout, "%s\n", message);
 #endif
         }
+        void Context::InvalidateState()
+        {
+            state_.blend = -1;
+            state_.depth_test = -1;
+            state_.depth_write = -1;
+            state_.stencil_test = -1;
+            state_.wireframe = -1;
+            state_.cull_face = -1;
+            state_.viewport_width = -1;
+            state_.viewport_height = -1;
+            state_.stencil_mask = 0;
+            state_.stencil_mask_known = false;
+            state_.clear_color_known = false;
+            state_.vertex_array_object = kUnknownObject;
+            state_.vertex_buffer = kUnknownObject;
+            state_.index_buffer = kUnknownObject;
+            state_.program = kUnknownObject;
+            state_.active_texture = kUnknownObject;
+            for (u32 i = 0; i < kMaxTextureUnits; ++i)
+            {
+                state_.textures[i] = kUnknownObject;
+                state_.texture_targets[i] = kUnknownObject;
+            }
+        }
+        void Context::NewFrame()
+        {
+            last_frame_counters_ = counters_;
+            counters_.issued = counters_.filtered = 0;
+        }
+        const ContextStateCounters& Context::state_counters() const
+        {
+            return last_frame_counters_;
+        }
+        void Context::ClearColor(f32 r, f32 g, f32 b, f32 a)
+        {
+            if (state_.clear_color_known &&
+                state_.clear_color[0] == r && state_.clear_color[1] == g &&
+                state_.clear_color[2] == b && state_.clear_color[3] == a)
+            {
+                ++counters_.filtered;
+                return;
+            }
+            state_.clear_color[0] = r;
+            state_.clear_color[1] = g;
+            state_.clear_color[2] = b;
+            state_.clear_color[3] = a;
+            state_.clear_color_known = true;
+            ++counters_.issued;
+            ApiClearColor(r, g, b, a);
+        }
+        void Context::Viewport(int w, int h)
+        {
+            if (state_.viewport_width == w && state_.viewport_height == h)
+            {
+                ++counters_.filtered;
+                return;
+            }
+            state_.viewport_width = w;
+            state_.viewport_height = h;
+            ++counters_.issued;
+            ApiViewport(w, h);
+        }
+        void Context::EnableBlend()
+        {
+            if (ChangeState(state_.blend, 1))
+                ApiEnableBlend();
+        }
+        void Context::DisableBlend()
+        {
+            if (ChangeState(state_.blend, 0))
+                ApiDisableBlend();
+        }
+        void Context::EnableDepthTest()
+        {
+            if (ChangeState(state_.depth_test, 1))
+                ApiEnableDepthTest();
+        }
+        void Context::DisableDepthTest()
+        {
+            if (ChangeState(state_.depth_test, 0))
+                ApiDisableDepthTest();
+        }
+        void Context::EnableDepthWrite()
+        {
+            if (ChangeState(state_.depth_write, 1))
+                ApiEnableDepthWrite();
+        }
+        void Context::DisableDepthWrite()
+        {
+            if (ChangeState(state_.depth_write, 0))
+                ApiDisableDepthWrite();
+        }
+        void Context::EnableStencilTest()
+        {
+            if (ChangeState(state_.stencil_test, 1))
+                ApiEnableStencilTest();
+        }
+        void Context::DisableStencilTest()
+        {
+            if (ChangeState(state_.stencil_test, 0))
+                ApiDisableStencilTest();
+        }
+        void Context::StencilMask(u32 mask)
+        {
+            if (state_.stencil_mask_known && state_.stencil_mask == mask)
+            {
+                ++counters_.filtered;
+                return;
+            }
+            state_.stencil_mask = mask;
+            state_.stencil_mask_known = true;
+            ++counters_.issued;
+            ApiStencilMask(mask);
+        }
+        void Context::EnableWireframeMode()
+        {
+            if (ChangeState(state_.wireframe, 1))
+                ApiEnableWireframeMode();
+        }
+        void Context::DisableWireframeMode()
+        {
+            if (ChangeState(state_.wireframe, 0))
+                ApiDisableWireframeMode();
+        }
+        void Context::CullFace(CullFaceType mode)
+        {
+            if (ChangeState(state_.cull_face, static_cast<int>(mode)))
+                ApiCullFace(mode);
+        }
+        void Context::DeleteVertexArrayObject(u32 &obj)
+        {
+            // Deleted bound object is replaced by zero binding
+            if (obj == state_.vertex_array_object)
+            {
+                state_.vertex_array_object = 0;
+                state_.index_buffer = kUnknownObject;
+            }
+            ApiDeleteVertexArrayObject(obj);
+        }
+        void Context::BindVertexArrayObject(u32 obj)
+        {
+            if (ChangeState(state_.vertex_array_object, obj))
+            {
+                // Index buffer binding is a part of vertex array object state
+                state_.index_buffer = kUnknownObject;
+                ApiBindVertexArrayObject(obj);
+            }
+        }
+        void Context::DeleteVertexBuffer(u32& obj)
+        {
+            if (obj == state_.vertex_buffer)
+                state_.vertex_buffer = 0;
+            ApiDeleteVertexBuffer(obj);
+        }
+        void Context::BindVertexBuffer(u32 obj)
+        {
+            if (ChangeState(state_.vertex_buffer, obj))
+                ApiBindVertexBuffer(obj);
+        }
+        void Context::DeleteIndexBuffer(u32& obj)
+        {
+            if (obj == state_.index_buffer)
+                state_.index_buffer = 0;
+            ApiDeleteIndexBuffer(obj);
+        }
+        void Context::BindIndexBuffer(u32 obj)
+        {
+            if (ChangeState(state_.index_buffer, obj))
+                ApiBindIndexBuffer(obj);
+        }
+        void Context::DeleteProgram(u32 program)
+        {
+            // Program stays in use until another one is bound, its name may be reused
+            if (program == state_.program)
+                state_.program = kUnknownObject;
+            ApiDeleteProgram(program);
+        }
+        void Context::BindProgram(u32 program)
+        {
+            if (ChangeState(state_.program, program))
+                ApiBindProgram(program);
+        }
+        void Context::ActiveTexture(u32 unit)
+        {
+            if (ChangeState(state_.active_texture, unit))
+                ApiActiveTexture(unit);
+        }
+        void Context::BindTexture(u32 target, u32 obj)
+        {
+            const u32 unit = state_.active_texture;
+            if (unit < kMaxTextureUnits)
+            {
+                if (state_.textures[unit] == obj && state_.texture_targets[unit] == target)
+                {
+                    ++counters_.filtered;
+                    return;
+                }
+                state_.textures[unit] = obj;
+                state_.texture_targets[unit] = target;
+            }
+            ++counters_.issued;
+            ApiBindTexture(target, obj);
+        }
+        void Context::DeleteTexture(u32& obj)
+        {
+            for (u32 i = 0; i < kMaxTextureUnits; ++i)
+                if (state_.textures[i] == obj)
+                    state_.textures[i] = 0;
+            ApiDeleteTexture(obj);
+        }
+        bool Context::ChangeState(int& current, int value)
+        {
+            if (current == value)
+            {
+                ++counters_.filtered;
+                return false;
+            }
+            current = value;
+            ++counters_.issued;
+            return true;
+        }
+        bool Context::ChangeState(u32& current, u32 value)
+        {
+            if (current == value)
+            {
+                ++counters_.filtered;
+                return false;
+            }
+            current = value;
+            ++counters_.issued;
+            return true;
+        }
         
     }
 }
\ No newline at end of file
@@ -2,9 +2,11 @@
 
 #include "../../include/image/image.h"
 #include "math/sht_math.h"
+#include "system/include/tasks/parallel_for.h"
 
 #include <cstring>
 #include <cmath>
+#include <algorithm>
 
 namespace sht {
 	namespace graphics {
@@ -17,6 +19,13 @@ namespace sht {
 		CubemapFaceFiller::~CubemapFaceFiller()
 		{
 		}
+		bool CubemapFaceFiller::FillAll(Image * images)
+		{
+			for (int face = 0; face < 6; ++face)
+				if (!Fill(face, images + face))
+					return false;
+			return true;
+		}
 
 		CrossCubemapFaceFiller::CrossCubemapFaceFiller(Image * source_image)
 		: CubemapFaceFiller(source_image)
@@ -79,84 +88,303 @@ namespace sht {
 			return true;
 		}
 
-		static math::Matrix3 GetFaceTransform(int face)
+		namespace {
+
+			const int kMaxAreaTaps = 4; //!< maximum number of samples per axis for area filter
+
+			template <typename T>
+			inline float ToFloat(T value)
+			{
+				return static_cast<float>(value);
+			}
+			template <typename T>
+			inline T FromFloat(float value, float max_value)
+			{
+				value = math::Clamp(value + 0.5f, 0.0f, max_value);
+				return static_cast<T>(value);
+			}
+			template <>
+			inline float FromFloat<float>(float value, float /*max_value*/)
+			{
+				return value;
+			}
+
+			//! Source equirectangular image view
+			template <typename T>
+			struct SourceView {
+				const T * pixels;
+				int width;
+				int height;
+				int channels;
+
+				const T * Texel(int x, int y) const
+				{
+					// Longitude wraps around, latitude is clamped
+					x %= width;
+					if (x < 0) x += width;
+					y = math::Clamp(y, 0, height - 1);
+					return pixels + (y * width + x) * channels;
+				}
+				void SampleNearest(float u, float v, float * out) const
+				{
+					int x = math::Clamp(static_cast<int>(u * (float)width), 0, width - 1);
+					int y = math::Clamp(static_cast<int>(v * (float)height), 0, height - 1);
+					const T * texel = pixels + (y * width + x) * channels;
+					for (int c = 0; c < channels; ++c)
+						out[c] = ToFloat(texel[c]);
+				}
+				//! Coordinates are in pixels, pixel centers are at half integers
+				void SampleBilinear(float x, float y, float * out) const
+				{
+					x -= 0.5f;
+					y -= 0.5f;
+					float fx0 = floorf(x);
+					float fy0 = floorf(y);
+					float rx = x - fx0;
+					float ry = y - fy0;
+					int x0 = static_cast<int>(fx0);
+					int y0 = static_cast<int>(fy0);
+					const T * t00 = Texel(x0    , y0    );
+					const T * t10 = Texel(x0 + 1, y0    );
+					const T * t01 = Texel(x0    , y0 + 1);
+					const T * t11 = Texel(x0 + 1, y0 + 1);
+					for (int c = 0; c < channels; ++c)
+					{
+						float top    = ToFloat(t00[c]) + (ToFloat(t10[c]) - ToFloat(t00[c])) * rx;
+						float bottom = ToFloat(t01[c]) + (ToFloat(t11[c]) - ToFloat(t01[c])) * rx;
+						out[c] = top + (bottom - top) * ry;
+					}
+				}
+				//! Averages bilinear samples over footprint of size (size_x, size_y) pixels
+				void SampleArea(float x, float y, float size_x, float size_y, float * out) const
+				{
+					int taps_x = math::Clamp(static_cast<int>(ceilf(size_x)), 1, kMaxAreaTaps);
+					int taps_y = math::Clamp(static_cast<int>(ceilf(size_y)), 1, kMaxAreaTaps);
+					if (taps_x == 1 && taps_y == 1)
+					{
+						SampleBilinear(x, y, out);
+						return;
+					}
+					float sample[4];
+					for (int c = 0; c < channels; ++c)
+						out[c] = 0.0f;
+					float step_x = size_x / (float)taps_x;
+					float step_y = size_y / (float)taps_y;
+					float start_x = x - 0.5f * size_x + 0.5f * step_x;
+					float start_y = y - 0.5f * size_y + 0.5f * step_y;
+					for (int ty = 0; ty < taps_y; ++ty)
+						for (int tx = 0; tx < taps_x; ++tx)
+						{
+							SampleBilinear(start_x + step_x * (float)tx, start_y + step_y * (float)ty, sample);
+							for (int c = 0; c < channels; ++c)
+								out[c] += sample[c];
+						}
+					float scale = 1.0f / (float)(taps_x * taps_y);
+					for (int c = 0; c < channels; ++c)
+						out[c] *= scale;
+				}
+			};
+
+			//! Distance between two longitudes taking wrap into account
+			inline float WrappedDistance(float a, float b)
+			{
+				float d = fabsf(a - b);
+				return (d > 0.5f) ? 1.0f - d : d;
+			}
+
+		} // namespace
+
+		SphereCubemapFaceFiller::SphereCubemapFaceFiller(Image * source_image, int face_width, Filter filter)
+		: CubemapFaceFiller(source_image)
+		, face_width_(face_width)
+		, filter_(filter)
+		{
+		}
+		void SphereCubemapFaceFiller::MakeTables()
+		{
+			/*
+			Face texel (i,j) maps to point (a,b) in [-1;1] square. Its direction is:
+			+X: ( 1,-b, a)    -X: (-1,-b,-a)    +Z: ( a,-b,-1)    -Z: (-a,-b, 1)
+			+Y: ( a, 1,-b)    -Y: ( a,-1, b)
+			Side faces are the +X face rotated around Y axis, so they share latitude
+			and differ in longitude by a multiple of Pi/2. +Y face is the -Y face mirrored.
+			Thus we need only two tables per face size.
+			*/
+			if (!side_table_.empty())
+				return;
+
+			const int w = face_width_;
+			side_table_.resize(w * w);
+			top_table_.resize(w * w);
+
+			const float kOneOverPi = 1.0f / math::kPi;
+			const float kOneOverTwoPi = 0.5f / math::kPi;
+			const float scale = (w > 1) ? 2.0f / (float)(w - 1) : 0.0f;
+
+			system::ParallelFor(0, w, [&](int begin, int end)
+			{
+				for (int j = begin; j < end; ++j)
+				{
+					float b = (float)j * scale - 1.0f;
+					for (int i = 0; i < w; ++i)
+					{
+						float a = (float)i * scale - 1.0f;
+						float inv_length = 1.0f / sqrtf(a * a + b * b + 1.0f);
+
+						TexCoord& side = side_table_[j * w + i];
+						side.u = math::FastAtan2(a, 1.0f) * kOneOverTwoPi + 0.5f;
+						side.v = math::FastAsin(b * inv_length) * kOneOverPi + 0.5f;
+
+						TexCoord& top = top_table_[j * w + i];
+						top.u = math::FastAtan2(b, a) * kOneOverTwoPi + 0.5f;
+						top.v = math::FastAsin(inv_length) * kOneOverPi + 0.5f;
+					}
+				}
+			}, 16);
+		}
+		void SphereCubemapFaceFiller::GetTexCoord(int face, int i, int j, float * u, float * v) const
 		{
+			const int index = j * face_width_ + i;
+			float offset;
 			switch (face)
 			{
 			default:
 			case 0: // +X
-				return math::Matrix3(
-					0.0f, 0.0f, 1.0f,
-					0.0f, -1.0f, 0.0f,
-					1.0f, 0.0f, 0.0f);
+				offset = 0.0f;
+				break;
 			case 1: // -X
-				return math::Matrix3(
-					0.0f, 0.0f, -1.0f,
-					0.0f, -1.0f, 0.0f,
-					-1.0f, 0.0f, 0.0f);
+				offset = 0.5f;
+				break;
 			case 2: // +Y
-				return math::Matrix3(
-					1.0f, 0.0f, 0.0f,
-					0.0f, 0.0f, -1.0f,
-					0.0f, 1.0f, 0.0f);
+				*u = 1.0f - top_table_[index].u;
+				*v = 1.0f - top_table_[index].v;
+				return;
 			case 3: // -Y
-				return math::Matrix3(
-					1.0f, 0.0f, 0.0f,
-					0.0f, 0.0f, 1.0f,
-					0.0f, -1.0f, 0.0f);
+				*u = top_table_[index].u;
+				*v = top_table_[index].v;
+				return;
 			case 4: // +Z
-				return math::Matrix3(
-					1.0f, 0.0f, 0.0f,
-					0.0f, -1.0f, 0.0f,
-					0.0f, 0.0f, -1.0f);
+				offset = -0.25f;
+				break;
 			case 5: // -Z
-				return math::Matrix3(
-					-1.0f, 0.0f, 0.0f,
-					0.0f, -1.0f, 0.0f,
-					0.0f, 0.0f, 1.0f);
+				offset = 0.25f;
+				break;
 			}
+			float value = side_table_[index].u + offset;
+			if (value >= 1.0f) value -= 1.0f;
+			if (value < 0.0f) value += 1.0f;
+			*u = value;
+			*v = side_table_[index].v;
 		}
-		SphereCubemapFaceFiller::SphereCubemapFaceFiller(Image * source_image, int face_width)
-		: CubemapFaceFiller(source_image)
-		, face_width_(face_width)
+		template <typename T>
+		void SphereCubemapFaceFiller::FillRows(int face, const T * src_pixels, T * dst_pixels, int begin_row, int end_row) const
 		{
+			SourceView<T> source = { src_pixels, source_image_->width(), source_image_->height(), source_image_->channels() };
+			const int w = face_width_;
+			const float max_value = (sizeof(T) == 1) ? 255.0f : 65535.0f;
+			float color[4];
+			for (int j = begin_row; j < end_row; ++j)
+			{
+				T * dst = dst_pixels + (j * w) * source.channels;
+				for (int i = 0; i < w; ++i, dst += source.channels)
+				{
+					float u, v;
+					GetTexCoord(face, i, j, &u, &v);
+					switch (filter_)
+					{
+					case Filter::kNearest:
+						source.SampleNearest(u, v, color);
+						break;
+					case Filter::kBilinear:
+						source.SampleBilinear(u * (float)source.width, v * (float)source.height, color);
+						break;
+					case Filter::kArea:
+						{
+							// Estimate texel footprint from neighbouring texels
+							int i0 = (i > 0) ? i - 1 : i, i1 = (i + 1 < w) ? i + 1 : i;
+							int j0 = (j > 0) ? j - 1 : j, j1 = (j + 1 < w) ? j + 1 : j;
+							float ux0, vx0, ux1, vx1, uy0, vy0, uy1, vy1;
+							GetTexCoord(face, i0, j, &ux0, &vx0);
+							GetTexCoord(face, i1, j, &ux1, &vx1);
+							GetTexCoord(face, i, j0, &uy0, &vy0);
+							GetTexCoord(face, i, j1, &uy1, &vy1);
+							float inv_dx = (i1 > i0) ? 1.0f / (float)(i1 - i0) : 0.0f;
+							float inv_dy = (j1 > j0) ? 1.0f / (float)(j1 - j0) : 0.0f;
+							float du = std::max(WrappedDistance(ux1, ux0) * inv_dx, WrappedDistance(uy1, uy0) * inv_dy);
+							float dv = std::max(fabsf(vx1 - vx0) * inv_dx, fabsf(vy1 - vy0) * inv_dy);
+							source.SampleArea(u * (float)source.width, v * (float)source.height,
+								du * (float)source.width, dv * (float)source.height, color);
+						}
+						break;
+					}
+					for (int c = 0; c < source.channels; ++c)
+						dst[c] = FromFloat<T>(color[c], max_value);
+				}
+			}
+		}
+		void SphereCubemapFaceFiller::FillRows(int face, Image * image, int begin_row, int end_row) const
+		{
+			const int component_size = source_image_->bpp() / source_image_->channels();
+			switch (component_size)
+			{
+			case 1:
+				FillRows<u8>(face, source_image_->pixels(), image->pixels(), begin_row, end_row);
+				break;
+			case 2:
+				FillRows<u16>(face, reinterpret_cast<const u16*>(source_image_->pixels()),
+					reinterpret_cast<u16*>(image->pixels()), begin_row, end_row);
+				break;
+			case 4:
+				FillRows<float>(face, reinterpret_cast<const float*>(source_image_->pixels()),
+					reinterpret_cast<float*>(image->pixels()), begin_row, end_row);
+				break;
+			default:
+				assert(!"unsupported pixel format");
+				break;
+			}
 		}
 		bool SphereCubemapFaceFiller::Fill(int face, Image * image)
 		{
-			int w = face_width_;
-			int h = face_width_;
+			if (face_width_ <= 0)
+				return false;
 
-			image->Allocate(w, h, source_image_->format());
+			MakeTables();
 
-			unsigned char * src_pixels = source_image_->pixels();
-			unsigned char * dst_pixels = image->pixels();
+			const int w = face_width_;
+			image->Allocate(w, w, source_image_->format());
 
-			int bpp = source_image_->bpp();
+			system::ParallelFor(0, w, [this, face, image](int begin, int end)
+			{
+				FillRows(face, image, begin, end);
+			}, 8);
 
-			math::Matrix3 face_matrix = GetFaceTransform(face);
-			for (int j = 0; j < h; ++j)
+			return true;
+		}
+		bool SphereCubemapFaceFiller::FillAll(Image * images)
+		{
+			if (face_width_ <= 0)
+				return false;
+
+			MakeTables();
+
+			const int w = face_width_;
+			for (int face = 0; face < 6; ++face)
+				images[face].Allocate(w, w, source_image_->format());
+
+			// Rows of all six faces are processed as a single range
+			system::ParallelFor(0, 6 * w, [this, images, w](int begin, int end)
 			{
-				float y = (float)j / (float)(h-1);
-				for (int i = 0; i < w; ++i)
+				for (int row = begin; row < end; )
 				{
-					float x = (float)i / (float)(w-1);
-					vec3 face_point = face_matrix * vec3(2.0f * x - 1.0f, 2.0f * y - 1.0f, 1.0f);
-					face_point.Normalize();
-					float angle_x = (atan2(face_point.z, face_point.x) * 0.5f / math::kPi) + 0.5f; // [-Pi; Pi] -> [0; 1]
-					float angle_y = (asin(-face_point.y) / math::kPi) + 0.5f; // [-Pi/2; Pi/2] -> [0; 1]
-					int src_i = static_cast<int>(angle_x * (float)source_image_->width());
-					int src_j = static_cast<int>(angle_y * (float)source_image_->height());
-					src_i = math::Clamp(src_i, 0, source_image_->width() - 1);
-					src_j = math::Clamp(src_j, 0, source_image_->height() - 1);
-					memcpy(
-						dst_pixels + bpp * (w * j + i),
-						src_pixels + bpp * (source_image_->width() * src_j + src_i),
-						bpp); // copy sample
+					int face = row / w;
+					int face_end = std::min(end, (face + 1) * w);
+					FillRows(face, images + face, row - face * w, face_end - face * w);
+					row = face_end;
 				}
-			}
+			}, 8);
 
 			return true;
 		}
 
 	} // namespace graphics
-} // namespace sht
\ No newline at end of file
+} // namespace sht
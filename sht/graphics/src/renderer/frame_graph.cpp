@@ -0,0 +1,219 @@
+#include "../../include/renderer/frame_graph.h"
+
+#include <algorithm>
+#include <assert.h>
+
+namespace sht {
+	namespace graphics {
+
+		FrameGraph::FrameGraph()
+		{
+		}
+		FrameGraph::ResourceId FrameGraph::CreateTarget(const char* name, const RenderTargetDesc& desc)
+		{
+			Resource resource;
+			resource.name = name;
+			resource.desc = desc;
+			resource.imported = nullptr;
+			resource.first_use = kInvalidIndex;
+			resource.last_use = kInvalidIndex;
+			resource.physical_index = kInvalidIndex;
+			resources_.push_back(resource);
+			return static_cast<ResourceId>(resources_.size() - 1);
+		}
+		FrameGraph::ResourceId FrameGraph::ImportTarget(const char* name, Texture * texture)
+		{
+			assert(texture);
+			ResourceId id = CreateTarget(name, RenderTargetDesc(texture->width(), texture->height(), texture->format()));
+			resources_[id].imported = texture;
+			return id;
+		}
+		FrameGraph::PassId FrameGraph::AddPass(const char* name, const ExecuteFunction& execute)
+		{
+			Pass pass;
+			pass.name = name;
+			pass.execute = execute;
+			pass.culled = false;
+			passes_.push_back(pass);
+			return static_cast<PassId>(passes_.size() - 1);
+		}
+		void FrameGraph::Read(PassId pass, ResourceId resource)
+		{
+			assert(pass < passes_.size() && resource < resources_.size());
+			passes_[pass].reads.push_back(resource);
+		}
+		void FrameGraph::Write(PassId pass, ResourceId resource)
+		{
+			assert(pass < passes_.size() && resource < resources_.size());
+			passes_[pass].writes.push_back(resource);
+		}
+		bool FrameGraph::Compile()
+		{
+			error_.clear();
+			physical_targets_.clear();
+			for (auto& resource : resources_)
+			{
+				resource.first_use = kInvalidIndex;
+				resource.last_use = kInvalidIndex;
+				resource.physical_index = kInvalidIndex;
+			}
+
+			// Walk passes backwards: pass is needed if it writes imported target or target read by needed pass
+			std::vector<bool> needed(resources_.size(), false);
+			for (size_t i = 0; i < resources_.size(); ++i)
+				needed[i] = resources_[i].imported != nullptr;
+			for (size_t i = passes_.size(); i-- > 0; )
+			{
+				Pass& pass = passes_[i];
+				pass.culled = true;
+				for (auto id : pass.writes)
+					if (needed[id])
+						pass.culled = false;
+				if (pass.culled)
+					continue;
+				for (auto id : pass.reads)
+					needed[id] = true;
+			}
+
+			// Lifetimes
+			std::vector<bool> written(resources_.size(), false);
+			for (size_t i = 0; i < passes_.size(); ++i)
+			{
+				const Pass& pass = passes_[i];
+				if (pass.culled)
+					continue;
+				for (auto id : pass.reads)
+				{
+					Resource& resource = resources_[id];
+					if (resource.imported == nullptr && !written[id])
+					{
+						error_ = "Pass " + pass.name + " reads target " + resource.name + " before it has been written";
+						return false;
+					}
+				}
+				for (auto id : pass.writes)
+					written[id] = true;
+				const std::vector<ResourceId> * lists[2] = { &pass.reads, &pass.writes };
+				for (int l = 0; l < 2; ++l)
+					for (auto id : *lists[l])
+					{
+						Resource& resource = resources_[id];
+						if (resource.first_use == kInvalidIndex)
+							resource.first_use = static_cast<u32>(i);
+						resource.last_use = static_cast<u32>(i);
+					}
+			}
+
+			// Assign transient targets to physical ones in order of first use.
+			// Target reuses physical target of equal description that has been free since earlier pass.
+			std::vector<ResourceId> order;
+			for (size_t i = 0; i < resources_.size(); ++i)
+				if (resources_[i].imported == nullptr && resources_[i].first_use != kInvalidIndex)
+					order.push_back(static_cast<ResourceId>(i));
+			std::stable_sort(order.begin(), order.end(), [this](ResourceId a, ResourceId b) {
+				return resources_[a].first_use < resources_[b].first_use;
+			});
+			for (auto id : order)
+			{
+				Resource& resource = resources_[id];
+				u32 best = kInvalidIndex;
+				for (size_t p = 0; p < physical_targets_.size(); ++p)
+				{
+					const PhysicalTarget& target = physical_targets_[p];
+					if (target.desc != resource.desc || target.last_use >= resource.first_use)
+						continue;
+					// The one freed earliest leaves recently freed targets for later resources
+					if (best == kInvalidIndex || target.last_use < physical_targets_[best].last_use)
+						best = static_cast<u32>(p);
+				}
+				if (best == kInvalidIndex)
+				{
+					PhysicalTarget target;
+					target.desc = resource.desc;
+					target.first_use = resource.first_use;
+					target.texture = nullptr;
+					physical_targets_.push_back(target);
+					best = static_cast<u32>(physical_targets_.size() - 1);
+				}
+				physical_targets_[best].last_use = resource.last_use;
+				resource.physical_index = best;
+			}
+			return true;
+		}
+		void FrameGraph::Execute(RenderTargetPool * pool)
+		{
+			assert(pool);
+			for (size_t i = 0; i < passes_.size(); ++i)
+			{
+				Pass& pass = passes_[i];
+				if (pass.culled)
+					continue;
+				for (auto& target : physical_targets_)
+					if (target.first_use == i)
+						target.texture = pool->Acquire(target.desc);
+				if (pass.execute)
+					pass.execute(*this);
+				for (auto& target : physical_targets_)
+					if (target.last_use == i && target.texture != nullptr)
+					{
+						pool->Release(target.texture);
+						target.texture = nullptr;
+					}
+			}
+		}
+		Texture * FrameGraph::GetTexture(ResourceId resource) const
+		{
+			assert(resource < resources_.size());
+			const Resource& res = resources_[resource];
+			if (res.imported != nullptr)
+				return res.imported;
+			if (res.physical_index == kInvalidIndex)
+				return nullptr;
+			return physical_targets_[res.physical_index].texture;
+		}
+		void FrameGraph::Clear()
+		{
+			resources_.clear();
+			passes_.clear();
+			physical_targets_.clear();
+			error_.clear();
+		}
+		u32 FrameGraph::num_passes() const
+		{
+			return static_cast<u32>(passes_.size());
+		}
+		u32 FrameGraph::num_resources() const
+		{
+			return static_cast<u32>(resources_.size());
+		}
+		u32 FrameGraph::num_physical_targets() const
+		{
+			return static_cast<u32>(physical_targets_.size());
+		}
+		bool FrameGraph::pass_culled(PassId pass) const
+		{
+			assert(pass < passes_.size());
+			return passes_[pass].culled;
+		}
+		u32 FrameGraph::first_use(ResourceId resource) const
+		{
+			assert(resource < resources_.size());
+			return resources_[resource].first_use;
+		}
+		u32 FrameGraph::last_use(ResourceId resource) const
+		{
+			assert(resource < resources_.size());
+			return resources_[resource].last_use;
+		}
+		u32 FrameGraph::physical_index(ResourceId resource) const
+		{
+			assert(resource < resources_.size());
+			return resources_[resource].physical_index;
+		}
+		const std::string& FrameGraph::error() const
+		{
+			return error_;
+		}
+
+	} // namespace graphics
+} // namespace sht
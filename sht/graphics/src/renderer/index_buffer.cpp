@@ -30,7 +30,7 @@ namespace sht {
         }
         void IndexBuffer::SubData(u32 size, const void *data)
         {
-            context_->IndexBufferSubData(size, data);
+            context_->IndexBufferSubData(0, size, data);
         }
         void* IndexBuffer::Lock(DataAccessType access)
         {
@@ -0,0 +1,80 @@
+#include "../../include/renderer/instance_batch.h"
+#include "../../include/renderer/vertex_format.h"
+
+#include <cstring>
+
+namespace sht {
+    namespace graphics {
+        
+        namespace {
+            
+            // Matrix is passed by columns, each column is a separate attribute
+            const VertexAttribute kInstanceAttributes[InstanceBatch::kNumLocations] = {
+                VertexAttribute(VertexAttribute::kGeneric, 4, 1),
+                VertexAttribute(VertexAttribute::kGeneric, 4, 1),
+                VertexAttribute(VertexAttribute::kGeneric, 4, 1),
+                VertexAttribute(VertexAttribute::kGeneric, 4, 1),
+                VertexAttribute(VertexAttribute::kColor, 4, 1)
+            };
+            
+        } // namespace
+        
+        InstanceBatch::InstanceBatch(Context * context)
+        : context_(context)
+        , id_(0)
+        , dirty_(false)
+        {
+            context_->GenVertexBuffer(id_);
+        }
+        InstanceBatch::~InstanceBatch()
+        {
+            context_->DeleteVertexBuffer(id_);
+        }
+        void InstanceBatch::Attach(u32 first_location)
+        {
+            context_->BindVertexBuffer(id_);
+            const char* base = (char*)0;
+            u32 offset = 0;
+            for (u32 i = 0; i < kNumLocations; ++i)
+            {
+                const VertexAttribute& attrib = kInstanceAttributes[i];
+                context_->VertexAttribPointer(first_location + i, attrib.size, DataType::kFloat, sizeof(Instance), base + offset);
+                context_->EnableVertexAttribArray(first_location + i);
+                context_->VertexAttribDivisor(first_location + i, attrib.divisor);
+                offset += attrib.size * sizeof(f32);
+            }
+        }
+        void InstanceBatch::Clear()
+        {
+            if (!instances_.empty())
+                dirty_ = true;
+            instances_.clear();
+        }
+        void InstanceBatch::Add(const math::Matrix4& transform, const vec4& color)
+        {
+            instances_.push_back(Instance());
+            Instance& instance = instances_.back();
+            memcpy(instance.transform, static_cast<const float*>(transform), sizeof(instance.transform));
+            instance.color[0] = color.x;
+            instance.color[1] = color.y;
+            instance.color[2] = color.z;
+            instance.color[3] = color.w;
+            dirty_ = true;
+        }
+        void InstanceBatch::Upload()
+        {
+            if (!dirty_)
+                return;
+            dirty_ = false;
+            // Respecifying whole buffer lets driver orphan storage that is still used by previous frame
+            context_->BindVertexBuffer(id_);
+            context_->VertexBufferData(static_cast<u32>(instances_.size() * sizeof(Instance)),
+                instances_.empty() ? nullptr : &instances_[0], BufferUsage::kStreamDraw);
+        }
+        u32 InstanceBatch::num_instances() const
+        {
+            return static_cast<u32>(instances_.size());
+        }
+        
+    } // namespace graphics
+} // namespace sht
@@ -0,0 +1,270 @@
+#include "../../include/renderer/mesh_pool.h"
+#include "../../include/renderer/vertex_packing.h"
+
+#include <assert.h>
+
+namespace sht {
+    namespace graphics {
+
+        MeshPool::RangeAllocator::RangeAllocator(u32 capacity)
+        : capacity_(capacity)
+        , used_(0)
+        {
+            if (capacity_ > 0)
+                free_ranges_[0] = capacity_;
+        }
+        bool MeshPool::RangeAllocator::Allocate(u32 size, u32 * offset)
+        {
+            for (auto it = free_ranges_.begin(); it != free_ranges_.end(); ++it)
+            {
+                if (it->second < size)
+                    continue;
+                *offset = it->first;
+                const u32 rest = it->second - size;
+                free_ranges_.erase(it);
+                if (rest > 0)
+                    free_ranges_[*offset + size] = rest;
+                used_ += size;
+                return true;
+            }
+            return false;
+        }
+        void MeshPool::RangeAllocator::Free(u32 offset, u32 size)
+        {
+            if (size == 0)
+                return;
+            assert(used_ >= size);
+            used_ -= size;
+            auto next = free_ranges_.lower_bound(offset);
+            // Merge with the following range
+            if (next != free_ranges_.end() && offset + size == next->first)
+            {
+                size += next->second;
+                next = free_ranges_.erase(next);
+            }
+            // Merge with the preceding range
+            if (next != free_ranges_.begin())
+            {
+                auto prev = next;
+                --prev;
+                assert(prev->first + prev->second <= offset);
+                if (prev->first + prev->second == offset)
+                {
+                    prev->second += size;
+                    return;
+                }
+            }
+            free_ranges_.insert(next, std::make_pair(offset, size));
+        }
+        u32 MeshPool::RangeAllocator::capacity() const
+        {
+            return capacity_;
+        }
+        u32 MeshPool::RangeAllocator::used() const
+        {
+            return used_;
+        }
+        u32 MeshPool::RangeAllocator::largest_free_range() const
+        {
+            u32 largest = 0;
+            for (const auto& range : free_ranges_)
+                if (range.second > largest)
+                    largest = range.second;
+            return largest;
+        }
+        u32 MeshPool::RangeAllocator::num_free_ranges() const
+        {
+            return static_cast<u32>(free_ranges_.size());
+        }
+
+        MeshPool::MeshPool(Context * context, const VertexAttribute * attribs, u32 num_attribs,
+            u32 vertex_capacity, u32 index_capacity)
+        : context_(context)
+        , vertex_allocator_(vertex_capacity)
+        , index_allocator_(index_capacity)
+        , vertex_size_(0)
+        , vertex_array_object_(0)
+        , vertex_buffer_(0)
+        , index_buffer_(0)
+        , num_meshes_(0)
+        , num_draw_calls_(0)
+        {
+            for (u32 i = 0; i < num_attribs; ++i)
+                vertex_size_ += GetAttributeSize(attribs[i].format, attribs[i].size);
+
+            context_->GenVertexArrayObject(vertex_array_object_);
+            context_->BindVertexArrayObject(vertex_array_object_);
+
+            context_->GenVertexBuffer(vertex_buffer_);
+            context_->BindVertexBuffer(vertex_buffer_);
+            context_->VertexBufferData(vertex_capacity * vertex_size_, nullptr, BufferUsage::kStaticDraw);
+
+            context_->GenIndexBuffer(index_buffer_);
+            context_->BindIndexBuffer(index_buffer_);
+            context_->IndexBufferData(index_capacity * sizeof(u32), nullptr, BufferUsage::kStaticDraw);
+
+            const char* base = (char*)0;
+            u32 offset = 0;
+            for (u32 i = 0; i < num_attribs; ++i)
+            {
+                const VertexAttribute::Format format = attribs[i].format;
+                context_->VertexAttribPointer(i, GetStoredComponents(format, attribs[i].size), GetAttributeDataType(format),
+                    vertex_size_, base + offset, IsAttributeNormalized(format));
+                context_->EnableVertexAttribArray(i);
+                offset += GetAttributeSize(format, attribs[i].size);
+            }
+
+            context_->BindVertexArrayObject(0);
+        }
+        MeshPool::~MeshPool()
+        {
+            context_->DeleteIndexBuffer(index_buffer_);
+            context_->DeleteVertexBuffer(vertex_buffer_);
+            context_->DeleteVertexArrayObject(vertex_array_object_);
+        }
+        MeshPool::Handle MeshPool::Add(const void * vertices, u32 num_vertices, const void * indices, u32 num_indices, DataType index_type)
+        {
+            if (indices == nullptr)
+                num_indices = num_vertices;
+            if (num_vertices == 0 || num_indices == 0)
+                return kInvalidHandle;
+
+            Range range;
+            range.num_vertices = num_vertices;
+            range.num_indices = num_indices;
+            if (!vertex_allocator_.Allocate(num_vertices, &range.first_vertex))
+                return kInvalidHandle;
+            if (!index_allocator_.Allocate(num_indices, &range.first_index))
+            {
+                vertex_allocator_.Free(range.first_vertex, num_vertices);
+                return kInvalidHandle;
+            }
+
+            // Indices stay relative to the mesh, base vertex is applied at draw time
+            const u32 * pool_indices;
+            if (indices == nullptr)
+            {
+                scratch_indices_.resize(num_indices);
+                for (u32 i = 0; i < num_indices; ++i)
+                    scratch_indices_[i] = i;
+                pool_indices = scratch_indices_.data();
+            }
+            else if (index_type == DataType::kUnsignedShort)
+            {
+                const u16 * src = reinterpret_cast<const u16*>(indices);
+                scratch_indices_.assign(src, src + num_indices);
+                pool_indices = scratch_indices_.data();
+            }
+            else
+            {
+                assert(index_type == DataType::kUnsignedInt);
+                pool_indices = reinterpret_cast<const u32*>(indices);
+            }
+
+            // Element buffer binding is a part of vertex array state
+            context_->BindVertexArrayObject(vertex_array_object_);
+            context_->BindVertexBuffer(vertex_buffer_);
+            context_->VertexBufferSubData(range.first_vertex * vertex_size_, num_vertices * vertex_size_, vertices);
+            context_->BindIndexBuffer(index_buffer_);
+            context_->IndexBufferSubData(range.first_index * sizeof(u32), num_indices * sizeof(u32), pool_indices);
+            context_->BindVertexArrayObject(0);
+
+            Handle handle;
+            if (free_handles_.empty())
+            {
+                handle = static_cast<Handle>(ranges_.size());
+                ranges_.push_back(range);
+            }
+            else
+            {
+                handle = free_handles_.back();
+                free_handles_.pop_back();
+                ranges_[handle] = range;
+            }
+            ++num_meshes_;
+            return handle;
+        }
+        void MeshPool::Remove(Handle handle)
+        {
+            assert(handle < ranges_.size() && ranges_[handle].num_indices != 0);
+            Range& range = ranges_[handle];
+            vertex_allocator_.Free(range.first_vertex, range.num_vertices);
+            index_allocator_.Free(range.first_index, range.num_indices);
+            range.num_vertices = 0;
+            range.num_indices = 0;
+            free_handles_.push_back(handle);
+            --num_meshes_;
+        }
+        void MeshPool::Bind()
+        {
+            context_->BindVertexArrayObject(vertex_array_object_);
+        }
+        void MeshPool::Unbind()
+        {
+            context_->BindVertexArrayObject(0);
+        }
+        void MeshPool::Draw(Handle handle, PrimitiveType mode)
+        {
+            assert(handle < ranges_.size());
+            const Range& range = ranges_[handle];
+            context_->DrawElementsBaseVertex(mode, range.num_indices, DataType::kUnsignedInt,
+                range.first_index, static_cast<s32>(range.first_vertex));
+            ++num_draw_calls_;
+        }
+        void MeshPool::DrawBatch(const Handle * handles, u32 num_handles, PrimitiveType mode)
+        {
+            if (num_handles == 0)
+                return;
+            if (num_handles == 1)
+            {
+                Draw(handles[0], mode);
+                return;
+            }
+            batch_counts_.resize(num_handles);
+            batch_first_indices_.resize(num_handles);
+            batch_base_vertices_.resize(num_handles);
+            for (u32 i = 0; i < num_handles; ++i)
+            {
+                assert(handles[i] < ranges_.size());
+                const Range& range = ranges_[handles[i]];
+                batch_counts_[i] = range.num_indices;
+                batch_first_indices_[i] = range.first_index;
+                batch_base_vertices_[i] = static_cast<s32>(range.first_vertex);
+            }
+            context_->MultiDrawElementsBaseVertex(mode, batch_counts_.data(), DataType::kUnsignedInt,
+                batch_first_indices_.data(), batch_base_vertices_.data(), num_handles);
+            ++num_draw_calls_;
+        }
+        u32 MeshPool::vertex_size() const
+        {
+            return vertex_size_;
+        }
+        u32 MeshPool::num_draw_calls() const
+        {
+            return num_draw_calls_;
+        }
+        MeshPool::Stats MeshPool::GetStats() const
+        {
+            Stats stats;
+            stats.num_meshes = num_meshes_;
+            stats.vertex_capacity = vertex_allocator_.capacity();
+            stats.vertices_used = vertex_allocator_.used();
+            stats.largest_free_vertex_range = vertex_allocator_.largest_free_range();
+            stats.index_capacity = index_allocator_.capacity();
+            stats.indices_used = index_allocator_.used();
+            stats.largest_free_index_range = index_allocator_.largest_free_range();
+            stats.num_free_ranges = vertex_allocator_.num_free_ranges() + index_allocator_.num_free_ranges();
+
+            // The worse of both buffers limits the size of mesh that can be added
+            const u32 free_vertices = stats.vertex_capacity - stats.vertices_used;
+            const u32 free_indices = stats.index_capacity - stats.indices_used;
+            f32 vertex_fragmentation = (free_vertices == 0) ? 0.0f :
+                1.0f - static_cast<f32>(stats.largest_free_vertex_range) / static_cast<f32>(free_vertices);
+            f32 index_fragmentation = (free_indices == 0) ? 0.0f :
+                1.0f - static_cast<f32>(stats.largest_free_index_range) / static_cast<f32>(free_indices);
+            stats.fragmentation = (vertex_fragmentation > index_fragmentation) ? vertex_fragmentation : index_fragmentation;
+            return stats;
+        }
+
+    } // namespace graphics
+} // namespace sht
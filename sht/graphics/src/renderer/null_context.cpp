@@ -0,0 +1,384 @@
+#include "../../include/renderer/null_context.h"
+
+#include <cstdint>
+#include <assert.h>
+
+namespace sht {
+    namespace graphics {
+        
+        NullContext::NullContext()
+        : last_object_id_(0)
+        , vertex_buffer_size_(0)
+        , index_buffer_size_(0)
+        {
+            
+        }
+        NullContext::~NullContext()
+        {
+            
+        }
+        bool NullContext::CheckForErrors()
+        {
+            return false;
+        }
+        bool NullContext::CheckFrameBufferStatus()
+        {
+            return true;
+        }
+        u32 NullContext::GenObjectId()
+        {
+            return ++last_object_id_;
+        }
+        void NullContext::ApiClearColor(f32 r, f32 g, f32 b, f32 a)
+        {
+        }
+        void NullContext::ClearColorBuffer()
+        {
+        }
+        void NullContext::ClearDepthBuffer()
+        {
+        }
+        void NullContext::ClearColorAndDepthBuffers()
+        {
+        }
+        void NullContext::ClearStencil(s32 value)
+        {
+        }
+        void NullContext::ClearStencilBuffer()
+        {
+        }
+        void NullContext::ApiViewport(int w, int h)
+        {
+        }
+        void NullContext::ApiEnableBlend()
+        {
+        }
+        void NullContext::ApiDisableBlend()
+        {
+        }
+        void NullContext::ApiEnableDepthTest()
+        {
+        }
+        void NullContext::ApiDisableDepthTest()
+        {
+        }
+        void NullContext::ApiEnableDepthWrite()
+        {
+        }
+        void NullContext::ApiDisableDepthWrite()
+        {
+        }
+        void NullContext::ApiEnableStencilTest()
+        {
+        }
+        void NullContext::ApiDisableStencilTest()
+        {
+        }
+        void NullContext::ApiStencilMask(u32 mask)
+        {
+        }
+        void NullContext::ApiEnableWireframeMode()
+        {
+        }
+        void NullContext::ApiDisableWireframeMode()
+        {
+        }
+        void NullContext::ApiCullFace(CullFaceType mode)
+        {
+        }
+        void NullContext::DrawArrays(PrimitiveType mode, s32 first, u32 count)
+        {
+        }
+        void NullContext::DrawElements(PrimitiveType mode, u32 num_indices, DataType index_type)
+        {
+        }
+        void NullContext::DrawArraysInstanced(PrimitiveType mode, s32 first, u32 count, u32 num_instances)
+        {
+        }
+        void NullContext::DrawElementsInstanced(PrimitiveType mode, u32 num_indices, DataType index_type, u32 num_instances)
+        {
+        }
+        void NullContext::DrawElementsBaseVertex(PrimitiveType mode, u32 num_indices, DataType index_type,
+            u32 first_index, s32 base_vertex)
+        {
+        }
+        void NullContext::MultiDrawElementsBaseVertex(PrimitiveType mode, const u32 * num_indices, DataType index_type,
+            const u32 * first_indices, const s32 * base_vertices, u32 draw_count)
+        {
+        }
+        void NullContext::GenVertexArrayObject(u32 &obj)
+        {
+            obj = ++last_object_id_;
+        }
+        void NullContext::ApiDeleteVertexArrayObject(u32 &obj)
+        {
+            obj = 0;
+        }
+        void NullContext::ApiBindVertexArrayObject(u32 obj)
+        {
+        }
+        void NullContext::GenVertexBuffer(u32& obj)
+        {
+            obj = ++last_object_id_;
+        }
+        void NullContext::ApiDeleteVertexBuffer(u32& obj)
+        {
+            obj = 0;
+        }
+        void NullContext::ApiBindVertexBuffer(u32 obj)
+        {
+        }
+        void NullContext::VertexBufferData(u32 size, const void *data, BufferUsage usage)
+        {
+            vertex_buffer_size_ = size;
+        }
+        void NullContext::VertexBufferSubData(u32 offset, u32 size, const void *data)
+        {
+        }
+        void* NullContext::MapVertexBufferData(DataAccessType access)
+        {
+            mapped_buffer_.resize(vertex_buffer_size_);
+            return mapped_buffer_.empty() ? nullptr : &mapped_buffer_[0];
+        }
+        void NullContext::UnmapVertexBufferData()
+        {
+        }
+        void* NullContext::MapVertexBufferRange(u32 offset, u32 size)
+        {
+            assert(offset + size <= vertex_buffer_size_);
+            mapped_buffer_.resize(vertex_buffer_size_);
+            return mapped_buffer_.empty() ? nullptr : &mapped_buffer_[offset];
+        }
+        void* NullContext::MapVertexBufferPersistent(u32 size)
+        {
+            return nullptr;
+        }
+        void NullContext::GenIndexBuffer(u32& obj)
+        {
+            obj = ++last_object_id_;
+        }
+        void NullContext::ApiDeleteIndexBuffer(u32& obj)
+        {
+            obj = 0;
+        }
+        void NullContext::ApiBindIndexBuffer(u32 obj)
+        {
+        }
+        void NullContext::IndexBufferData(u32 size, const void *data, BufferUsage usage)
+        {
+            index_buffer_size_ = size;
+        }
+        void NullContext::IndexBufferSubData(u32 offset, u32 size, const void *data)
+        {
+        }
+        void* NullContext::MapIndexBufferData(DataAccessType access)
+        {
+            mapped_buffer_.resize(index_buffer_size_);
+            return mapped_buffer_.empty() ? nullptr : &mapped_buffer_[0];
+        }
+        void NullContext::UnmapIndexBufferData()
+        {
+        }
+        void NullContext::VertexAttribPointer(u32 index, s32 size, DataType type, u32 stride, const void* ptr, bool normalized)
+        {
+        }
+        void NullContext::EnableVertexAttribArray(u32 index)
+        {
+        }
+        void NullContext::VertexAttribDivisor(u32 index, u32 divisor)
+        {
+        }
+        SyncObject NullContext::FenceSync()
+        {
+            // There is no GPU, so any fence is signaled immediately
+            return reinterpret_cast<SyncObject>(static_cast<uintptr_t>(++last_object_id_));
+        }
+        bool NullContext::ClientWaitSync(SyncObject sync, u64 timeout_ns)
+        {
+            return true;
+        }
+        void NullContext::DeleteSync(SyncObject sync)
+        {
+        }
+        void NullContext::ApiActiveTexture(u32 unit)
+        {
+        }
+        void NullContext::ApiBindTexture(u32 target, u32 obj)
+        {
+        }
+        void NullContext::ApiDeleteTexture(u32& obj)
+        {
+            obj = 0;
+        }
+        void NullContext::TextureImage2D(u32 target, s32 level, s32 internal_format, s32 w, s32 h,
+            u32 format, u32 type, const void *data)
+        {
+        }
+        void NullContext::TextureSubImage2D(u32 target, s32 level, s32 x, s32 y, s32 w, s32 h, u32 format, u32 type, const void *data)
+        {
+        }
+        void NullContext::GetTextureImage(u32 target, s32 level, u32 format, u32 type, void *data)
+        {
+        }
+        void NullContext::GenerateMipmap(u32 target)
+        {
+        }
+        void NullContext::ApiDeleteProgram(u32 program)
+        {
+        }
+        void NullContext::ApiBindProgram(u32 program)
+        {
+        }
+        void NullContext::BindAttribLocation(u32 program, const char *name)
+        {
+        }
+        void NullContext::Uniform1i(u32 program, const char *name, int x)
+        {
+        }
+        void NullContext::Uniform2i(u32 program, const char *name, int x, int y)
+        {
+        }
+        void NullContext::Uniform3i(u32 program, const char *name, int x, int y, int z)
+        {
+        }
+        void NullContext::Uniform4i(u32 program, const char *name, int x, int y, int z, int w)
+        {
+        }
+        void NullContext::Uniform1f(u32 program, const char *name, float x)
+        {
+        }
+        void NullContext::Uniform2f(u32 program, const char *name, float x, float y)
+        {
+        }
+        void NullContext::Uniform3f(u32 program, const char *name, float x, float y, float z)
+        {
+        }
+        void NullContext::Uniform4f(u32 program, const char *name, float x, float y, float z, float w)
+        {
+        }
+        void NullContext::Uniform1fv(u32 program, const char *name, const float *v, int n)
+        {
+        }
+        void NullContext::Uniform2fv(u32 program, const char *name, const float *v, int n)
+        {
+        }
+        void NullContext::Uniform3fv(u32 program, const char *name, const float *v, int n)
+        {
+        }
+        void NullContext::Uniform4fv(u32 program, const char *name, const float *v, int n)
+        {
+        }
+        void NullContext::UniformMatrix2fv(u32 program, const char *name, const float *v, bool trans, int n)
+        {
+        }
+        void NullContext::UniformMatrix3fv(u32 program, const char *name, const float *v, bool trans, int n)
+        {
+        }
+        void NullContext::UniformMatrix4fv(u32 program, const char *name, const float *v, bool trans, int n)
+        {
+        }
+        
+        void NullContext::GetActiveUniforms(u32 program, std::vector<UniformInfo> * uniforms)
+        {
+            uniforms->clear();
+        }
+        void NullContext::SetUniform1i(s32 location, int x)
+        {
+        }
+        void NullContext::SetUniform2i(s32 location, int x, int y)
+        {
+        }
+        void NullContext::SetUniform3i(s32 location, int x, int y, int z)
+        {
+        }
+        void NullContext::SetUniform4i(s32 location, int x, int y, int z, int w)
+        {
+        }
+        void NullContext::SetUniform1f(s32 location, float x)
+        {
+        }
+        void NullContext::SetUniform2f(s32 location, float x, float y)
+        {
+        }
+        void NullContext::SetUniform3f(s32 location, float x, float y, float z)
+        {
+        }
+        void NullContext::SetUniform4f(s32 location, float x, float y, float z, float w)
+        {
+        }
+        void NullContext::SetUniform1fv(s32 location, const float *v, int n)
+        {
+        }
+        void NullContext::SetUniform2fv(s32 location, const float *v, int n)
+        {
+        }
+        void NullContext::SetUniform3fv(s32 location, const float *v, int n)
+        {
+        }
+        void NullContext::SetUniform4fv(s32 location, const float *v, int n)
+        {
+        }
+        void NullContext::SetUniformMatrix2fv(s32 location, const float *v, bool trans, int n)
+        {
+        }
+        void NullContext::SetUniformMatrix3fv(s32 location, const float *v, bool trans, int n)
+        {
+        }
+        void NullContext::SetUniformMatrix4fv(s32 location, const float *v, bool trans, int n)
+        {
+        }
+        void NullContext::GenUniformBuffer(u32& obj)
+        {
+            obj = ++last_object_id_;
+        }
+        void NullContext::DeleteUniformBuffer(u32& obj)
+        {
+            obj = 0;
+        }
+        void NullContext::BindUniformBuffer(u32 obj)
+        {
+        }
+        void NullContext::UniformBufferData(u32 size, const void *data, BufferUsage usage)
+        {
+        }
+        void NullContext::UniformBufferSubData(u32 offset, u32 size, const void *data)
+        {
+        }
+        void NullContext::BindUniformBufferBase(u32 binding, u32 obj)
+        {
+        }
+        s32 NullContext::GetUniformBlockIndex(u32 program, const char *name)
+        {
+            return -1;
+        }
+        void NullContext::UniformBlockBinding(u32 program, u32 block_index, u32 binding)
+        {
+        }
+        void NullContext::GenPixelBuffer(u32& obj)
+        {
+            obj = ++last_object_id_;
+        }
+        void NullContext::DeletePixelBuffer(u32& obj)
+        {
+            obj = 0;
+        }
+        void NullContext::BindPixelPackBuffer(u32 obj)
+        {
+        }
+        void NullContext::PixelPackBufferData(u32 size)
+        {
+        }
+        void NullContext::ReadPixels(s32 x, s32 y, s32 w, s32 h, u32 format, u32 type, void *data)
+        {
+        }
+        const void* NullContext::MapPixelPackBuffer(u32 size)
+        {
+            mapped_buffer_.resize(size);
+            return mapped_buffer_.empty() ? nullptr : &mapped_buffer_[0];
+        }
+        void NullContext::UnmapPixelPackBuffer()
+        {
+        }
+        
+    }
+}
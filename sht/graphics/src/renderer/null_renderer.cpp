@@ -0,0 +1,535 @@
+#include "../../include/renderer/null_renderer.h"
+
+#include <string>
+#include <cstring>
+#include <algorithm>
+
+namespace {
+
+	// Values of driver enums, so recorded commands look the same as with OpenGL renderer
+	const u32 kTexture2D = 0x0DE1;
+	const u32 kTextureCubeMap = 0x8513;
+	const u32 kTextureCubeMapPositiveX = 0x8515;
+
+} // namespace
+
+namespace sht {
+	namespace graphics {
+
+		//! Texture that describes its formats with OpenGL enum values
+		class NullTexture : public Texture {
+		public:
+			u32 GetSrcFormat()
+			{
+				switch (format_)
+				{
+				case Image::Format::kRGBA8:
+				case Image::Format::kRGBA16:
+				case Image::Format::kRGBA32:
+					return 0x1908; // GL_RGBA
+				case Image::Format::kR8:
+				case Image::Format::kR16:
+				case Image::Format::kR32:
+				case Image::Format::kI8:
+				case Image::Format::kI16:
+				case Image::Format::kI32:
+				case Image::Format::kL8:
+				case Image::Format::kL16:
+				case Image::Format::kL32:
+					return 0x1903; // GL_RED
+				case Image::Format::kRG8:
+				case Image::Format::kRG16:
+				case Image::Format::kRG32:
+				case Image::Format::kLA8:
+				case Image::Format::kLA16:
+				case Image::Format::kLA32:
+					return 0x8227; // GL_RG
+				case Image::Format::kA8:
+				case Image::Format::kA16:
+				case Image::Format::kA32:
+					return 0x1906; // GL_ALPHA
+				case Image::Format::kDepth16:
+				case Image::Format::kDepth24:
+				case Image::Format::kDepth32:
+					return 0x1902; // GL_DEPTH_COMPONENT
+				default:
+					return 0x1907; // GL_RGB
+				}
+			}
+			u32 GetSrcType()
+			{
+				switch (format_)
+				{
+				case Image::Format::kR16:
+				case Image::Format::kRG16:
+				case Image::Format::kRGB16:
+				case Image::Format::kRGBA16:
+				case Image::Format::kA16:
+				case Image::Format::kI16:
+				case Image::Format::kL16:
+				case Image::Format::kLA16:
+					return 0x140B; // GL_HALF_FLOAT
+				case Image::Format::kR32:
+				case Image::Format::kRG32:
+				case Image::Format::kRGB32:
+				case Image::Format::kRGBA32:
+				case Image::Format::kA32:
+				case Image::Format::kI32:
+				case Image::Format::kL32:
+				case Image::Format::kLA32:
+				case Image::Format::kDepth16:
+				case Image::Format::kDepth24:
+				case Image::Format::kDepth32:
+					return 0x1406; // GL_FLOAT
+				default:
+					return 0x1401; // GL_UNSIGNED_BYTE
+				}
+			}
+			s32 GetInternalFormat()
+			{
+				// Unsized formats are enough, there is no storage behind the texture
+				return static_cast<s32>(GetSrcFormat());
+			}
+
+		private:
+			void ChooseTarget()
+			{
+				target_ = kTexture2D;
+			}
+		};
+
+		NullRenderer::NullRenderer(int w, int h, NullContext * context)
+		: Renderer(w, h)
+		, null_context_(context)
+		{
+			context_ = context;
+			residency_manager_ = new ResidencyManager(context_);
+			// Shader manager compiles with the driver, so shaders are created by AddShader only
+
+			SetDefaultStates();
+		}
+		NullRenderer::~NullRenderer()
+		{
+			ReleaseRingBuffer();
+			ReleaseScreenshotQueue();
+			ReleaseRenderTargetPool();
+			delete residency_manager_;
+			delete context_;
+		}
+		void NullRenderer::SetDefaultStates()
+		{
+			context_->ClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+			context_->EnableDepthTest();
+			context_->CullFace(CullFaceType::kBack);
+			context_->EnableBlend();
+		}
+		void NullRenderer::CreateTexture2D(Texture* &tex, int w, int h, Image::Format fmt, u32 target, const u8 * const * faces)
+		{
+			tex = new NullTexture();
+			tex->width_ = w;
+			tex->height_ = h;
+			tex->format_ = fmt;
+			tex->target_ = target;
+			tex->texture_id_ = null_context_->GenObjectId();
+			context_->BindTexture(tex->target_, tex->texture_id_);
+
+			if (target == kTextureCubeMap)
+			{
+				for (u32 face = 0; face < 6; ++face)
+					context_->TextureImage2D(kTextureCubeMapPositiveX + face, 0, tex->GetInternalFormat(),
+						w, h, tex->GetSrcFormat(), tex->GetSrcType(), faces ? faces[face] : nullptr);
+			}
+			else
+				context_->TextureImage2D(tex->target_, 0, tex->GetInternalFormat(),
+					w, h, tex->GetSrcFormat(), tex->GetSrcType(), faces ? faces[0] : nullptr);
+
+			RegisterTexture(tex);
+		}
+		void NullRenderer::ApiAddTexture(Texture* &tex, const Image &img, Texture::Wrap wrap, Texture::Filter filt)
+		{
+			const u8 * pixels = img.pixels();
+			CreateTexture2D(tex, img.width(), img.height(), img.format(), kTexture2D, &pixels);
+			if (filt != Texture::Filter::kPoint && filt != Texture::Filter::kLinear)
+				context_->GenerateMipmap(tex->target_);
+		}
+		void NullRenderer::ApiAddTextureStorage(Texture* &tex, int w, int h, Image::Format fmt, Texture::Wrap wrap, Texture::Filter filt)
+		{
+			CreateTexture2D(tex, w, h, fmt, kTexture2D, nullptr);
+		}
+		void NullRenderer::ApiAddTextureCubemap(Texture* &tex, Image *imgs, bool use_mipmaps)
+		{
+			const u8 * faces[6];
+			for (u32 face = 0; face < 6; ++face)
+				faces[face] = imgs[face].pixels();
+			CreateTexture2D(tex, imgs[0].width(), imgs[0].height(), imgs[0].format(), kTextureCubeMap, faces);
+			if (use_mipmaps)
+				context_->GenerateMipmap(tex->target_);
+		}
+		void NullRenderer::ApiDeleteTexture(Texture* tex)
+		{
+			if (tex->texture_id_)
+			{
+				context_->DeleteTexture(tex->texture_id_);
+				tex->texture_id_ = 0;
+			}
+			tex->depth_id_ = 0;
+			tex->stencil_id_ = 0;
+		}
+		void NullRenderer::CreateTextureColor(Texture* &texture, float r, float g, float b, float a)
+		{
+			const u8 color[4] = {
+				static_cast<u8>(r * 255.0f),
+				static_cast<u8>(g * 255.0f),
+				static_cast<u8>(b * 255.0f),
+				static_cast<u8>(a * 255.0f)
+			};
+			const u8 * pixels = color;
+			CreateTexture2D(texture, 1, 1, Image::Format::kRGBA8, kTexture2D, &pixels);
+		}
+		void NullRenderer::CreateTextureCubemap(Texture* &texture, int w, int h, Image::Format fmt, Texture::Filter filt)
+		{
+			CreateTexture2D(texture, w, h, fmt, kTextureCubeMap, nullptr);
+		}
+		void NullRenderer::CreateTextureDepth(Texture* &texture, int w, int h, u32 depthSize)
+		{
+			Image::Format fmt;
+			switch (depthSize)
+			{
+			case 16: fmt = Image::Format::kDepth16; break;
+			case 24: fmt = Image::Format::kDepth24; break;
+			case 32: fmt = Image::Format::kDepth32; break;
+			default: texture = nullptr; return; // unknown format
+			}
+			CreateTexture2D(texture, w, h, fmt, kTexture2D, nullptr);
+		}
+		void NullRenderer::CreateTexture(Texture* &texture, int w, int h, Image::Format fmt)
+		{
+			CreateTexture2D(texture, w, h, fmt, kTexture2D, nullptr);
+		}
+		void NullRenderer::CreateTextureFromData(Texture* &texture, int w, int h, Image::Format fmt, unsigned char *data)
+		{
+			const u8 * pixels = data;
+			CreateTexture2D(texture, w, h, fmt, kTexture2D, &pixels);
+		}
+		void NullRenderer::AddRenderTarget(Texture* &texture, int w, int h, Image::Format fmt, Texture::Filter filt)
+		{
+			assert(w > 0 && h > 0);
+			CreateTexture2D(texture, w, h, fmt, kTexture2D, nullptr);
+		}
+		void NullRenderer::AddRenderDepthStencil(Texture* &texture, int w, int h, u32 depthSize, u32 stencilSize)
+		{
+			assert(w > 0 && h > 0 && (depthSize > 0 || stencilSize > 0));
+
+			// Renderbuffers aren't known to context, so only identifiers are made
+			texture = new NullTexture();
+			texture->width_ = w;
+			texture->height_ = h;
+			switch (depthSize)
+			{
+			case 16: texture->format_ = Image::Format::kDepth16; break;
+			case 32: texture->format_ = Image::Format::kDepth32; break;
+			default: texture->format_ = Image::Format::kDepth24; break;
+			}
+			texture->target_ = kTexture2D;
+			if (depthSize > 0)
+				texture->depth_id_ = null_context_->GenObjectId();
+			if (stencilSize > 0)
+				texture->stencil_id_ = null_context_->GenObjectId();
+
+			RegisterTexture(texture);
+		}
+		void NullRenderer::DeleteTexture(Texture* texture)
+		{
+			assert(texture);
+			ApiDeleteTexture(texture);
+			auto it = std::find(textures_.begin(), textures_.end(), texture);
+			if (it != textures_.end())
+			{
+				textures_.erase(it);
+				residency_manager_->Remove(texture);
+				delete texture;
+			}
+		}
+		void NullRenderer::ChangeTexture(Texture* texture, u32 layer)
+		{
+			Texture * curTex = current_textures_[layer];
+			if (texture == nullptr)
+			{
+				if (curTex != nullptr)
+				{
+					context_->ActiveTexture(layer);
+					context_->BindTexture(curTex->target_, 0);
+				}
+			}
+			else
+			{
+				context_->ActiveTexture(layer);
+				context_->BindTexture(texture->target_, texture->texture_id_);
+				residency_manager_->Touch(texture);
+			}
+			current_textures_[layer] = texture;
+		}
+		void NullRenderer::ChangeRenderTargets(u8 nTargets, Texture* *colorRTs, Texture* depthRT)
+		{
+			if (nTargets == 1 && colorRTs[0] == nullptr && depthRT == nullptr)
+				context_->Viewport(width_, height_);
+			else
+			{
+				for (u8 i = 0; i < nTargets; i++)
+					current_color_rt_[i] = colorRTs[i];
+				current_depth_rt_ = depthRT;
+				Texture * tex = (colorRTs[0] != nullptr) ? colorRTs[0] : depthRT;
+				context_->Viewport(tex->width_, tex->height_);
+			}
+		}
+		void NullRenderer::ChangeRenderTargetsToCube(u8 nTargets, Texture* *colorRTs, Texture* depthRT, int face, int level)
+		{
+			if (nTargets == 1 && colorRTs[0] == nullptr && depthRT == nullptr)
+				context_->Viewport(width_, height_);
+			else
+			{
+				for (u8 i = 0; i < nTargets; i++)
+					current_color_rt_[i] = colorRTs[i];
+				current_depth_rt_ = depthRT;
+				Texture * tex = (colorRTs[0] != nullptr) ? colorRTs[0] : depthRT;
+				context_->Viewport(tex->width_ >> level, tex->height_ >> level);
+			}
+		}
+		void NullRenderer::GenerateMipmap(Texture* texture)
+		{
+			context_->BindTexture(texture->target_, texture->texture_id_);
+			context_->GenerateMipmap(texture->target_);
+		}
+		void NullRenderer::CopyToTexture(Texture* texture, u32 layer)
+		{
+			ChangeTexture(texture, layer);
+		}
+		void NullRenderer::AddVertexFormat(VertexFormat* &vf, VertexAttribute *attribs, u32 nAttribs)
+		{
+			vf = new VertexFormat();
+
+			vf->Fill(attribs, nAttribs);
+
+			// Try to find same format
+			for (auto &p : vertex_formats_)
+			{
+				auto ptr = p.pointer();
+				if (*ptr == *vf)
+				{
+					delete vf;
+					p.IncreaseCount();
+					vf = ptr;
+					return;
+				}
+			}
+
+			vertex_formats_.push_back(vf);
+		}
+		void NullRenderer::ChangeVertexFormat(VertexFormat* vf)
+		{
+			current_vertex_format_ = vf;
+		}
+		void NullRenderer::DeleteVertexFormat(VertexFormat* vf)
+		{
+			auto it = std::find_if(vertex_formats_.begin(), vertex_formats_.end(), [vf]
+								   (const sht::CountingPointer<VertexFormat>& format)
+			{
+				return format.pointer() == vf;
+			});
+			if (it != vertex_formats_.end())
+			{
+				it->DecreaseCount();
+				if (it->count() == 0)
+				{
+					delete it->pointer();
+					vertex_formats_.erase(it);
+				}
+			}
+		}
+		void NullRenderer::AddVertexBuffer(VertexBuffer* &vb, u32 size, void *data, BufferUsage usage)
+		{
+			vb = new VertexBuffer(context_);
+			vb->size_ = size;
+
+			vb->Bind();
+			vb->SetData(size, data, usage);
+
+			vertex_buffers_.push_back(vb);
+			vertex_buffers_size_ += vb->GetSize();
+		}
+		void NullRenderer::DeleteVertexBuffer(VertexBuffer* vb)
+		{
+			assert(vb);
+			auto it = std::find(vertex_buffers_.begin(), vertex_buffers_.end(), vb);
+			if (it != vertex_buffers_.end())
+			{
+				vertex_buffers_.erase(it);
+				vertex_buffers_size_ -= vb->GetSize();
+				delete vb;
+			}
+		}
+		void NullRenderer::AddIndexBuffer(IndexBuffer* &ib, u32 nIndices, u32 indexSize, void *data, BufferUsage usage)
+		{
+			ib = new IndexBuffer(context_);
+			ib->index_count_ = nIndices;
+			ib->index_size_ = indexSize;
+
+			u32 size = nIndices * indexSize;
+			ib->Bind();
+			ib->SetData(size, data, usage);
+
+			index_buffers_.push_back(ib);
+			index_buffers_size_ += ib->GetSize();
+		}
+		void NullRenderer::DeleteIndexBuffer(IndexBuffer* ib)
+		{
+			assert(ib);
+			auto it = std::find(index_buffers_.begin(), index_buffers_.end(), ib);
+			if (it != index_buffers_.end())
+			{
+				index_buffers_.erase(it);
+				index_buffers_size_ -= ib->GetSize();
+				delete ib;
+			}
+		}
+		bool NullRenderer::AddShader(Shader* &shader, const char* filename, const char **attribs, u32 n_attribs)
+		{
+			shader = nullptr;
+			std::string vertex_source, fragment_source;
+			if (!preprocessor_.Process((std::string(filename) + ".vs").c_str(), &vertex_source) ||
+				!preprocessor_.Process((std::string(filename) + ".fs").c_str(), &fragment_source))
+			{
+				context_->ErrorHandler(preprocessor_.error().c_str());
+				return false;
+			}
+
+			shader = new Shader(context_);
+			shader->program_ = null_context_->GenObjectId();
+			for (u32 i = 0; i < n_attribs; ++i)
+				if (attribs[i])
+					context_->BindAttribLocation(shader->program_, attribs[i]);
+			shader->ReflectUniforms();
+			shaders_.push_back(shader);
+			return true;
+		}
+		void NullRenderer::DeleteShader(Shader* shader)
+		{
+			assert(shader);
+			auto it = std::find(shaders_.begin(), shaders_.end(), shader);
+			if (it != shaders_.end())
+			{
+				shaders_.erase(it);
+				delete shader;
+			}
+		}
+		void NullRenderer::AddFont(Font* &font, const char* fontname)
+		{
+			font = new Font();
+
+			const int kFontHeight = 64;
+
+			Image image;
+			if (font->MakeAtlas(fontname, kFontHeight, &image))
+			{
+				CreateTextureFromData(font->texture_, image.width(), image.height(), image.format(), image.pixels());
+
+				fonts_.push_back(font);
+			}
+			else
+			{
+				delete font;
+				font = nullptr;
+			}
+		}
+		void NullRenderer::DeleteFont(Font* font)
+		{
+			assert(font);
+			auto it = std::find(fonts_.begin(), fonts_.end(), font);
+			if (it != fonts_.end())
+			{
+				fonts_.erase(it);
+				delete font;
+			}
+		}
+		void NullRenderer::ReadPixels(int w, int h, u8 *data)
+		{
+			memset(data, 0, static_cast<size_t>(w) * h * 3);
+		}
+		void NullRenderer::ClearColor(f32 r, f32 g, f32 b, f32 a)
+		{
+			context_->ClearColor(r, g, b, a);
+		}
+		void NullRenderer::ClearColorBuffer(void)
+		{
+			context_->ClearColorBuffer();
+		}
+		void NullRenderer::ClearColorAndDepthBuffers(void)
+		{
+			context_->ClearColorAndDepthBuffers();
+		}
+		void NullRenderer::ClearDepthBuffer(void)
+		{
+			context_->ClearDepthBuffer();
+		}
+		void NullRenderer::ClearStencil(s32 value)
+		{
+			context_->ClearStencil(value);
+		}
+		void NullRenderer::ClearStencilBuffer()
+		{
+			context_->ClearStencilBuffer();
+		}
+		void NullRenderer::ChangeBlendFunc(u32 source, u32 dest)
+		{
+		}
+		void NullRenderer::EnableBlend(void)
+		{
+			context_->EnableBlend();
+		}
+		void NullRenderer::DisableBlend(void)
+		{
+			context_->DisableBlend();
+		}
+		void NullRenderer::EnableDepthTest(void)
+		{
+			context_->EnableDepthTest();
+		}
+		void NullRenderer::DisableDepthTest(void)
+		{
+			context_->DisableDepthTest();
+		}
+		void NullRenderer::EnableDepthWrite(void)
+		{
+			context_->EnableDepthWrite();
+		}
+		void NullRenderer::DisableDepthWrite(void)
+		{
+			context_->DisableDepthWrite();
+		}
+		void NullRenderer::EnableStencilTest(void)
+		{
+			context_->EnableStencilTest();
+		}
+		void NullRenderer::DisableStencilTest(void)
+		{
+			context_->DisableStencilTest();
+		}
+		void NullRenderer::EnableWireframeMode(void)
+		{
+			context_->EnableWireframeMode();
+		}
+		void NullRenderer::DisableWireframeMode(void)
+		{
+			context_->DisableWireframeMode();
+		}
+		void NullRenderer::CullFace(CullFaceType mode)
+		{
+			context_->CullFace(mode);
+		}
+		void NullRenderer::ApiViewport(int width, int height)
+		{
+			context_->Viewport(width, height);
+		}
+
+	} // namespace graphics
+} // namespace sht
@@ -0,0 +1,369 @@
+#include "../../include/renderer/occlusion_culler.h"
+
+#include "../../../system/include/tasks/parallel_for.h"
+
+#include <algorithm>
+#include <assert.h>
+#include <cmath>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define SHT_OCCLUSION_SSE
+#include <xmmintrin.h>
+#endif
+
+namespace {
+
+	const int kBandHeight = 8;			//!< rows rasterized by one task
+	const int kMinBoxesPerTask = 64;
+
+	//! Signed distance to near plane in clip space: z + w >= 0 inside
+	inline float NearDistance(const sht::math::Vector4& v)
+	{
+		return v.z + v.w;
+	}
+
+} // namespace
+
+namespace sht {
+	namespace graphics {
+
+		OcclusionCuller::OcclusionCuller(int width, int height)
+		: width_((width + 3) & ~3)
+		, height_(height)
+		{
+			assert(width > 0 && height > 0);
+			depth_.resize(static_cast<size_t>(width_) * height_, 1.0f);
+			for (int w = width_, h = height_; w > 1 || h > 1; )
+			{
+				w = (w + 1) / 2;
+				h = (h + 1) / 2;
+				pyramid_.push_back(std::vector<float>(static_cast<size_t>(w) * h, 1.0f));
+			}
+			BeginFrame(math::Identity4());
+		}
+		void OcclusionCuller::BeginFrame(const math::Matrix4& projection_view)
+		{
+			projection_view_ = projection_view;
+			clip_vertices_.clear();
+			indices_.clear();
+			stats_.rasterize_seconds = 0.0f;
+			stats_.test_seconds = 0.0f;
+			stats_.num_occluders = 0;
+			stats_.num_triangles = 0;
+			stats_.num_tested = 0;
+			stats_.num_culled = 0;
+		}
+		void OcclusionCuller::AddOccluder(const math::Vector3 * vertices, u32 num_vertices, const u32 * indices, u32 num_indices,
+			const math::Matrix4& model)
+		{
+			const math::Matrix4 transform = projection_view_ * model;
+			const u32 base = static_cast<u32>(clip_vertices_.size());
+			for (u32 i = 0; i < num_vertices; ++i)
+				clip_vertices_.push_back(transform * math::Vector4(vertices[i], 1.0f));
+			for (u32 i = 0; i + 2 < num_indices; i += 3)
+			{
+				assert(indices[i] < num_vertices && indices[i + 1] < num_vertices && indices[i + 2] < num_vertices);
+				indices_.push_back(base + indices[i]);
+				indices_.push_back(base + indices[i + 1]);
+				indices_.push_back(base + indices[i + 2]);
+			}
+			++stats_.num_occluders;
+		}
+		void OcclusionCuller::Rasterize()
+		{
+			clock_.MakeStartPoint();
+
+			triangles_.clear();
+			for (size_t i = 0; i + 2 < indices_.size(); i += 3)
+				SetupTriangle(clip_vertices_[indices_[i]], clip_vertices_[indices_[i + 1]], clip_vertices_[indices_[i + 2]]);
+			stats_.num_triangles = static_cast<u32>(triangles_.size());
+
+			std::fill(depth_.begin(), depth_.end(), 1.0f);
+			const int num_bands = (height_ + kBandHeight - 1) / kBandHeight;
+			system::ParallelFor(0, num_bands, [this](int begin, int end)
+			{
+				RasterizeBand(begin * kBandHeight, std::min(end * kBandHeight, height_));
+			});
+			BuildPyramid();
+
+			stats_.rasterize_seconds = clock_.GetTime();
+		}
+		void OcclusionCuller::SetupTriangle(const math::Vector4& v0, const math::Vector4& v1, const math::Vector4& v2)
+		{
+			const math::Vector4 * in[3] = { &v0, &v1, &v2 };
+			float d[3];
+			int num_inside = 0;
+			for (int i = 0; i < 3; ++i)
+			{
+				d[i] = NearDistance(*in[i]);
+				if (d[i] >= 0.0f)
+					++num_inside;
+			}
+			if (num_inside == 0)
+				return;
+			if (num_inside == 3)
+			{
+				AddScreenTriangle(v0, v1, v2);
+				return;
+			}
+			// Clip polygon by near plane, the result has 3 or 4 vertices
+			math::Vector4 out[4];
+			int num_out = 0;
+			for (int i = 0; i < 3; ++i)
+			{
+				int j = (i + 1) % 3;
+				if (d[i] >= 0.0f)
+					out[num_out++] = *in[i];
+				if ((d[i] >= 0.0f) != (d[j] >= 0.0f))
+				{
+					float t = d[i] / (d[i] - d[j]);
+					out[num_out++] = *in[i] + t * (*in[j] - *in[i]);
+				}
+			}
+			for (int i = 1; i + 1 < num_out; ++i)
+				AddScreenTriangle(out[0], out[i], out[i + 1]);
+		}
+		void OcclusionCuller::AddScreenTriangle(const math::Vector4& v0, const math::Vector4& v1, const math::Vector4& v2)
+		{
+			const math::Vector4 * in[3] = { &v0, &v1, &v2 };
+			ScreenTriangle triangle;
+			for (int i = 0; i < 3; ++i)
+			{
+				// Vertices on the near plane itself have w close to zero only for degenerate projections
+				float w = std::max(in[i]->w, 1e-6f);
+				float inv_w = 1.0f / w;
+				triangle.x[i] = (in[i]->x * inv_w * 0.5f + 0.5f) * width_;
+				triangle.y[i] = (in[i]->y * inv_w * 0.5f + 0.5f) * height_;
+				triangle.z[i] = std::min(std::max(in[i]->z * inv_w * 0.5f + 0.5f, 0.0f), 1.0f);
+			}
+			// Quick rejection of triangles out of screen
+			float min_x = std::min(std::min(triangle.x[0], triangle.x[1]), triangle.x[2]);
+			float max_x = std::max(std::max(triangle.x[0], triangle.x[1]), triangle.x[2]);
+			float min_y = std::min(std::min(triangle.y[0], triangle.y[1]), triangle.y[2]);
+			float max_y = std::max(std::max(triangle.y[0], triangle.y[1]), triangle.y[2]);
+			if (max_x < 0.0f || max_y < 0.0f || min_x >= width_ || min_y >= height_)
+				return;
+			triangles_.push_back(triangle);
+		}
+		void OcclusionCuller::RasterizeBand(int y_begin, int y_end)
+		{
+			for (const auto& t : triangles_)
+			{
+				float min_y = std::min(std::min(t.y[0], t.y[1]), t.y[2]);
+				float max_y = std::max(std::max(t.y[0], t.y[1]), t.y[2]);
+				// Pixel centers within triangle bounds
+				int y0 = std::max(static_cast<int>(ceilf(min_y - 0.5f)), y_begin);
+				int y1 = std::min(static_cast<int>(floorf(max_y - 0.5f)), y_end - 1);
+				if (y0 > y1)
+					continue;
+				float min_x = std::min(std::min(t.x[0], t.x[1]), t.x[2]);
+				float max_x = std::max(std::max(t.x[0], t.x[1]), t.x[2]);
+				int x0 = std::max(static_cast<int>(ceilf(min_x - 0.5f)), 0);
+				int x1 = std::min(static_cast<int>(floorf(max_x - 0.5f)), width_ - 1);
+				if (x0 > x1)
+					continue;
+
+				// Edge functions e(x, y) = a * x + b * y + c, positive inside for both windings
+				float area = (t.x[1] - t.x[0]) * (t.y[2] - t.y[0]) - (t.x[2] - t.x[0]) * (t.y[1] - t.y[0]);
+				if (area == 0.0f)
+					continue;
+				const float sign = (area > 0.0f) ? 1.0f : -1.0f;
+				float a[3], b[3], c[3];
+				for (int i = 0; i < 3; ++i)
+				{
+					int j = (i + 1) % 3;
+					a[i] = sign * (t.y[i] - t.y[j]);
+					b[i] = sign * (t.x[j] - t.x[i]);
+					c[i] = -(a[i] * t.x[i] + b[i] * t.y[i]);
+				}
+				// Depth plane z(x, y) = z0 + dzdx * (x - x0) + dzdy * (y - y0)
+				const float inv_area = 1.0f / area;
+				const float dzdx = ((t.z[1] - t.z[0]) * (t.y[2] - t.y[0]) - (t.z[2] - t.z[0]) * (t.y[1] - t.y[0])) * inv_area;
+				const float dzdy = ((t.z[2] - t.z[0]) * (t.x[1] - t.x[0]) - (t.z[1] - t.z[0]) * (t.x[2] - t.x[0])) * inv_area;
+
+				for (int y = y0; y <= y1; ++y)
+				{
+					const float py = static_cast<float>(y) + 0.5f;
+					float * row = &depth_[static_cast<size_t>(y) * width_];
+					int x = x0;
+#ifdef SHT_OCCLUSION_SSE
+					// Groups of 4 pixels aligned to row start, so they never go out of the row
+					x = x0 & ~3;
+					const __m128 zero = _mm_setzero_ps();
+					const __m128 offsets = _mm_set_ps(3.5f, 2.5f, 1.5f, 0.5f);
+					const __m128 step = _mm_set1_ps(4.0f);
+					__m128 px = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), offsets);
+					__m128 a0 = _mm_set1_ps(a[0]), a1 = _mm_set1_ps(a[1]), a2 = _mm_set1_ps(a[2]);
+					__m128 r0 = _mm_set1_ps(b[0] * py + c[0]);
+					__m128 r1 = _mm_set1_ps(b[1] * py + c[1]);
+					__m128 r2 = _mm_set1_ps(b[2] * py + c[2]);
+					__m128 vdzdx = _mm_set1_ps(dzdx);
+					__m128 rz = _mm_set1_ps(t.z[0] + dzdy * (py - t.y[0]) - dzdx * t.x[0]);
+					for (; x <= x1; x += 4)
+					{
+						__m128 e0 = _mm_add_ps(_mm_mul_ps(a0, px), r0);
+						__m128 e1 = _mm_add_ps(_mm_mul_ps(a1, px), r1);
+						__m128 e2 = _mm_add_ps(_mm_mul_ps(a2, px), r2);
+						__m128 mask = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(e0, zero), _mm_cmpge_ps(e1, zero)),
+							_mm_cmpge_ps(e2, zero));
+						if (_mm_movemask_ps(mask) != 0)
+						{
+							__m128 z = _mm_add_ps(_mm_mul_ps(vdzdx, px), rz);
+							__m128 old_depth = _mm_loadu_ps(row + x);
+							__m128 new_depth = _mm_min_ps(old_depth, z);
+							_mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(mask, new_depth), _mm_andnot_ps(mask, old_depth)));
+						}
+						px = _mm_add_ps(px, step);
+					}
+#endif
+					for (; x <= x1; ++x)
+					{
+						const float px = static_cast<float>(x) + 0.5f;
+						if (a[0] * px + b[0] * py + c[0] < 0.0f ||
+							a[1] * px + b[1] * py + c[1] < 0.0f ||
+							a[2] * px + b[2] * py + c[2] < 0.0f)
+							continue;
+						float z = t.z[0] + dzdx * (px - t.x[0]) + dzdy * (py - t.y[0]);
+						if (z < row[x])
+							row[x] = z;
+					}
+				}
+			}
+		}
+		void OcclusionCuller::BuildPyramid()
+		{
+			for (int level = 1; level < num_levels(); ++level)
+			{
+				const float * src = level_data(level - 1);
+				const int src_width = level_width(level - 1);
+				const int src_height = level_height(level - 1);
+				float * dst = &pyramid_[level - 1][0];
+				const int dst_width = level_width(level);
+				const int dst_height = level_height(level);
+				for (int y = 0; y < dst_height; ++y)
+				{
+					const float * row0 = src + static_cast<size_t>(2 * y) * src_width;
+					const float * row1 = (2 * y + 1 < src_height) ? row0 + src_width : row0;
+					for (int x = 0; x < dst_width; ++x)
+					{
+						int x0 = 2 * x;
+						int x1 = (x0 + 1 < src_width) ? x0 + 1 : x0;
+						dst[y * dst_width + x] = std::max(std::max(row0[x0], row0[x1]), std::max(row1[x0], row1[x1]));
+					}
+				}
+			}
+		}
+		bool OcclusionCuller::IsVisible(const math::BoundingBox& box) const
+		{
+			float min_x = 1e30f, max_x = -1e30f;
+			float min_y = 1e30f, max_y = -1e30f;
+			float min_z = 1e30f;
+			int num_behind = 0;
+			for (int i = 0; i < 8; ++i)
+			{
+				math::Vector4 corner(
+					box.center.x + ((i & 1) ? box.extent.x : -box.extent.x),
+					box.center.y + ((i & 2) ? box.extent.y : -box.extent.y),
+					box.center.z + ((i & 4) ? box.extent.z : -box.extent.z),
+					1.0f);
+				math::Vector4 clip = projection_view_ * corner;
+				if (NearDistance(clip) <= 0.0f || clip.w <= 0.0f)
+				{
+					++num_behind;
+					continue;
+				}
+				float inv_w = 1.0f / clip.w;
+				float x = (clip.x * inv_w * 0.5f + 0.5f) * width_;
+				float y = (clip.y * inv_w * 0.5f + 0.5f) * height_;
+				float z = clip.z * inv_w * 0.5f + 0.5f;
+				min_x = std::min(min_x, x);
+				max_x = std::max(max_x, x);
+				min_y = std::min(min_y, y);
+				max_y = std::max(max_y, y);
+				min_z = std::min(min_z, z);
+			}
+			// Box crossing near plane is too close to be hidden
+			if (num_behind == 8)
+				return false;
+			if (num_behind > 0)
+				return true;
+			if (max_x < 0.0f || max_y < 0.0f || min_x >= width_ || min_y >= height_ || min_z > 1.0f)
+				return false;
+
+			// Every pixel the box touches
+			int x0 = std::max(static_cast<int>(floorf(min_x)), 0);
+			int x1 = std::min(static_cast<int>(floorf(max_x)), width_ - 1);
+			int y0 = std::max(static_cast<int>(floorf(min_y)), 0);
+			int y1 = std::min(static_cast<int>(floorf(max_y)), height_ - 1);
+
+			// Level where the rectangle covers at most 2x2 texels
+			int level = 0;
+			while (level + 1 < num_levels() && ((x1 >> level) - (x0 >> level) > 1 || (y1 >> level) - (y0 >> level) > 1))
+				++level;
+			const float * data = level_data(level);
+			const int row_width = level_width(level);
+			for (int y = y0 >> level; y <= (y1 >> level); ++y)
+				for (int x = x0 >> level; x <= (x1 >> level); ++x)
+					if (data[y * row_width + x] >= min_z)
+						return true;
+			return false;
+		}
+		u32 OcclusionCuller::TestBoxes(const math::BoundingBox * boxes, u32 count, std::vector<u8> * visible)
+		{
+			clock_.MakeStartPoint();
+			visible->resize(count);
+			u8 * flags = visible->data();
+			system::ParallelFor(0, static_cast<int>(count), [this, boxes, flags](int begin, int end)
+			{
+				for (int i = begin; i < end; ++i)
+					flags[i] = IsVisible(boxes[i]) ? 1 : 0;
+			}, kMinBoxesPerTask);
+			u32 num_visible = 0;
+			for (u32 i = 0; i < count; ++i)
+				num_visible += flags[i];
+			stats_.num_tested += count;
+			stats_.num_culled += count - num_visible;
+			stats_.test_seconds += clock_.GetTime();
+			return num_visible;
+		}
+		int OcclusionCuller::width() const
+		{
+			return width_;
+		}
+		int OcclusionCuller::height() const
+		{
+			return height_;
+		}
+		const float * OcclusionCuller::depth_buffer() const
+		{
+			return depth_.data();
+		}
+		int OcclusionCuller::num_levels() const
+		{
+			return static_cast<int>(pyramid_.size()) + 1;
+		}
+		const OcclusionCuller::Stats& OcclusionCuller::stats() const
+		{
+			return stats_;
+		}
+		const float * OcclusionCuller::level_data(int level) const
+		{
+			return (level == 0) ? depth_.data() : pyramid_[level - 1].data();
+		}
+		int OcclusionCuller::level_width(int level) const
+		{
+			int w = width_;
+			for (int i = 0; i < level; ++i)
+				w = (w + 1) / 2;
+			return w;
+		}
+		int OcclusionCuller::level_height(int level) const
+		{
+			int h = height_;
+			for (int i = 0; i < level; ++i)
+				h = (h + 1) / 2;
+			return h;
+		}
+
+	} // namespace graphics
+} // namespace sht
@@ -1,50 +1,85 @@
 # include "../../../include/renderer/opengl/opengl_context.h"
 #include "opengl_include.h"
+#include "../../../../common/table.h"
+
+#include <cstdint>
+
+namespace {
+    
+    using sht::graphics::PrimitiveType;
+    using sht::graphics::DataType;
+    using sht::graphics::DataAccessType;
+    using sht::graphics::BufferUsage;
+    using sht::graphics::CullFaceType;
+    
+    // API values are listed in order of enum declaration
+    constexpr EnumArray<PrimitiveType, u32> kPrimitiveTypes(
+        GL_LINES, GL_LINE_STRIP, GL_TRIANGLES, GL_TRIANGLE_STRIP, GL_QUADS);
+    constexpr EnumArray<DataType, u32> kDataTypes(
+        GL_UNSIGNED_SHORT, GL_UNSIGNED_INT, GL_FLOAT,
+        GL_BYTE, GL_UNSIGNED_BYTE, GL_SHORT, GL_HALF_FLOAT, GL_INT_2_10_10_10_REV);
+    constexpr EnumArray<DataType, u32> kDataTypeSizes(
+        2, 4, 4,
+        1, 1, 2, 2, 4);
+    constexpr EnumArray<DataAccessType, u32> kDataAccessTypes(
+        GL_READ_ONLY, GL_WRITE_ONLY, GL_READ_WRITE);
+    constexpr EnumArray<BufferUsage, u32> kBufferUsages(
+        GL_STATIC_DRAW, GL_STATIC_READ, GL_STATIC_COPY,
+        GL_STREAM_DRAW, GL_STREAM_READ, GL_STREAM_COPY,
+        GL_DYNAMIC_DRAW, GL_DYNAMIC_READ, GL_DYNAMIC_COPY);
+    constexpr EnumArray<CullFaceType, u32> kCullFaces(
+        GL_BACK, GL_FRONT);
+    
+    //! Returns size of uniform element in bytes, zero for types that aren't cached
+    unsigned int GetUniformTypeSize(GLenum type)
+    {
+        switch (type)
+        {
+        case GL_FLOAT:
+        case GL_INT:
+        case GL_UNSIGNED_INT:
+        case GL_BOOL:
+        case GL_SAMPLER_1D:
+        case GL_SAMPLER_2D:
+        case GL_SAMPLER_3D:
+        case GL_SAMPLER_CUBE:
+        case GL_SAMPLER_2D_SHADOW:
+        case GL_SAMPLER_2D_ARRAY:
+            return 4;
+        case GL_FLOAT_VEC2:
+        case GL_INT_VEC2:
+        case GL_BOOL_VEC2:
+            return 8;
+        case GL_FLOAT_VEC3:
+        case GL_INT_VEC3:
+        case GL_BOOL_VEC3:
+            return 12;
+        case GL_FLOAT_VEC4:
+        case GL_INT_VEC4:
+        case GL_BOOL_VEC4:
+        case GL_FLOAT_MAT2:
+            return 16;
+        case GL_FLOAT_MAT3:
+            return 36;
+        case GL_FLOAT_MAT4:
+            return 64;
+        default:
+            return 0;
+        }
+    }
+    
+} // namespace
 
 namespace sht {
     namespace graphics {
         
         OpenGlContext::OpenGlContext()
-        {
-            FillTables();
-        }
-        OpenGlContext::~OpenGlContext()
         {
             
         }
-        void OpenGlContext::FillTables()
+        OpenGlContext::~OpenGlContext()
         {
-            primitive_type_map_[PrimitiveType::kLines] = GL_LINES;
-            primitive_type_map_[PrimitiveType::kLineStrip] = GL_LINE_STRIP;
-            primitive_type_map_[PrimitiveType::kTriangles] = GL_TRIANGLES;
-            primitive_type_map_[PrimitiveType::kTriangleStrip] = GL_TRIANGLE_STRIP;
-            primitive_type_map_[PrimitiveType::kQuads] = GL_QUADS;
-            assert(primitive_type_map_.size() == (size_t)PrimitiveType::kCount);
-            
-            data_type_map_[DataType::kUnsignedShort] = GL_UNSIGNED_SHORT;
-            data_type_map_[DataType::kUnsignedInt] = GL_UNSIGNED_INT;
-            data_type_map_[DataType::kFloat] = GL_FLOAT;
-            assert(data_type_map_.size() == (size_t)DataType::kCount);
-            
-            data_access_map_[DataAccessType::kRead] = GL_READ_ONLY;
-            data_access_map_[DataAccessType::kWrite] = GL_WRITE_ONLY;
-            data_access_map_[DataAccessType::kReadWrite] = GL_READ_WRITE;
-            assert(data_access_map_.size() == (size_t)DataAccessType::kCount);
             
-            buffer_usage_map_[BufferUsage::kStaticDraw] = GL_STATIC_DRAW;
-            buffer_usage_map_[BufferUsage::kStaticRead] = GL_STATIC_READ;
-            buffer_usage_map_[BufferUsage::kStaticCopy] = GL_STATIC_COPY;
-            buffer_usage_map_[BufferUsage::kDynamicDraw] = GL_DYNAMIC_DRAW;
-            buffer_usage_map_[BufferUsage::kDynamicRead] = GL_DYNAMIC_READ;
-            buffer_usage_map_[BufferUsage::kDynamicCopy] = GL_DYNAMIC_COPY;
-            buffer_usage_map_[BufferUsage::kStreamDraw] = GL_STREAM_DRAW;
-            buffer_usage_map_[BufferUsage::kStreamRead] = GL_STREAM_READ;
-            buffer_usage_map_[BufferUsage::kStreamCopy] = GL_STREAM_COPY;
-            assert(buffer_usage_map_.size() == (size_t)BufferUsage::kCount);
-            
-            cull_face_map_[CullFaceType::kBack] = GL_BACK;
-            cull_face_map_[CullFaceType::kFront] = GL_FRONT;
-            assert(cull_face_map_.size() == (size_t)CullFaceType::kCount);
         }
         bool OpenGlContext::CheckForErrors()
         {
@@ -113,7 +148,7 @@ namespace sht {
             return true;
 #endif
         }
-        void OpenGlContext::ClearColor(f32 r, f32 g, f32 b, f32 a)
+        void OpenGlContext::ApiClearColor(f32 r, f32 g, f32 b, f32 a)
         {
             glClearColor(r, g, b, a);
         }
@@ -137,79 +172,114 @@ namespace sht {
         {
             glClear(GL_STENCIL_BUFFER_BIT);
         }
-        void OpenGlContext::Viewport(int w, int h)
+        void OpenGlContext::ApiViewport(int w, int h)
         {
             glViewport(0, 0, w, h);
         }
-        void OpenGlContext::EnableBlend()
+        void OpenGlContext::ApiEnableBlend()
         {
             glEnable(GL_BLEND);
         }
-        void OpenGlContext::DisableBlend()
+        void OpenGlContext::ApiDisableBlend()
         {
             glDisable(GL_BLEND);
         }
-        void OpenGlContext::EnableDepthTest()
+        void OpenGlContext::ApiEnableDepthTest()
         {
             glEnable(GL_DEPTH_TEST);
         }
-        void OpenGlContext::DisableDepthTest()
+        void OpenGlContext::ApiDisableDepthTest()
         {
             glDisable(GL_DEPTH_TEST);
         }
-        void OpenGlContext::EnableDepthWrite()
+        void OpenGlContext::ApiEnableDepthWrite()
         {
             glDepthMask(GL_TRUE);
         }
-        void OpenGlContext::DisableDepthWrite()
+        void OpenGlContext::ApiDisableDepthWrite()
         {
             glDepthMask(GL_FALSE);
         }
-        void OpenGlContext::EnableStencilTest()
+        void OpenGlContext::ApiEnableStencilTest()
         {
             glEnable(GL_STENCIL_TEST);
         }
-        void OpenGlContext::DisableStencilTest()
+        void OpenGlContext::ApiDisableStencilTest()
         {
             glDisable(GL_STENCIL_TEST);
         }
-        void OpenGlContext::StencilMask(u32 mask)
+        void OpenGlContext::ApiStencilMask(u32 mask)
         {
             glStencilMask(mask);
         }
-        void OpenGlContext::EnableWireframeMode()
+        void OpenGlContext::ApiEnableWireframeMode()
         {
             glPolygonMode(GL_FRONT, GL_LINE);
         }
-        void OpenGlContext::DisableWireframeMode()
+        void OpenGlContext::ApiDisableWireframeMode()
         {
             glPolygonMode(GL_FRONT, GL_FILL);
         }
-        void OpenGlContext::CullFace(CullFaceType mode)
+        void OpenGlContext::ApiCullFace(CullFaceType mode)
         {
-            u32 cull_face = cull_face_map_[mode];
+            u32 cull_face = kCullFaces[mode];
             glCullFace(cull_face);
         }
         void OpenGlContext::DrawArrays(PrimitiveType mode, s32 first, u32 count)
         {
-            u32 primitive_type = primitive_type_map_[mode];
+            u32 primitive_type = kPrimitiveTypes[mode];
             glDrawArrays(primitive_type, first, count);
         }
         void OpenGlContext::DrawElements(PrimitiveType mode, u32 num_indices, DataType index_type)
         {
-            u32 primitive_type = primitive_type_map_[mode];
-            u32 data_type = data_type_map_[index_type];
+            u32 primitive_type = kPrimitiveTypes[mode];
+            u32 data_type = kDataTypes[index_type];
             glDrawElements(primitive_type, num_indices, data_type, 0);
         }
+        void OpenGlContext::DrawArraysInstanced(PrimitiveType mode, s32 first, u32 count, u32 num_instances)
+        {
+            u32 primitive_type = kPrimitiveTypes[mode];
+            glDrawArraysInstanced(primitive_type, first, count, num_instances);
+        }
+        void OpenGlContext::DrawElementsInstanced(PrimitiveType mode, u32 num_indices, DataType index_type, u32 num_instances)
+        {
+            u32 primitive_type = kPrimitiveTypes[mode];
+            u32 data_type = kDataTypes[index_type];
+            glDrawElementsInstanced(primitive_type, num_indices, data_type, 0, num_instances);
+        }
+        void OpenGlContext::DrawElementsBaseVertex(PrimitiveType mode, u32 num_indices, DataType index_type,
+            u32 first_index, s32 base_vertex)
+        {
+            u32 primitive_type = kPrimitiveTypes[mode];
+            u32 data_type = kDataTypes[index_type];
+            const uintptr_t offset = static_cast<uintptr_t>(first_index) * kDataTypeSizes[index_type];
+            glDrawElementsBaseVertex(primitive_type, num_indices, data_type,
+                reinterpret_cast<const void*>(offset), base_vertex);
+        }
+        void OpenGlContext::MultiDrawElementsBaseVertex(PrimitiveType mode, const u32 * num_indices, DataType index_type,
+            const u32 * first_indices, const s32 * base_vertices, u32 draw_count)
+        {
+            u32 primitive_type = kPrimitiveTypes[mode];
+            u32 data_type = kDataTypes[index_type];
+            // API takes byte offsets as pointers
+            index_offsets_.resize(draw_count);
+            for (u32 i = 0; i < draw_count; ++i)
+            {
+                const uintptr_t offset = static_cast<uintptr_t>(first_indices[i]) * kDataTypeSizes[index_type];
+                index_offsets_[i] = reinterpret_cast<const void*>(offset);
+            }
+            glMultiDrawElementsBaseVertex(primitive_type, reinterpret_cast<const GLsizei*>(num_indices), data_type,
+                index_offsets_.data(), draw_count, reinterpret_cast<const GLint*>(base_vertices));
+        }
         void OpenGlContext::GenVertexArrayObject(u32 &obj)
         {
             glGenVertexArrays(1, &obj);
         }
-        void OpenGlContext::DeleteVertexArrayObject(u32 &obj)
+        void OpenGlContext::ApiDeleteVertexArrayObject(u32 &obj)
         {
             glDeleteVertexArrays(1, &obj);
         }
-        void OpenGlContext::BindVertexArrayObject(u32 obj)
+        void OpenGlContext::ApiBindVertexArrayObject(u32 obj)
         {
             glBindVertexArray(obj);
         }
@@ -217,76 +287,144 @@ namespace sht {
         {
             glGenBuffers(1, &obj);
         }
-        void OpenGlContext::DeleteVertexBuffer(u32& obj)
+        void OpenGlContext::ApiDeleteVertexBuffer(u32& obj)
         {
             glDeleteBuffers(1, &obj);
         }
-        void OpenGlContext::BindVertexBuffer(u32 obj)
+        void OpenGlContext::ApiBindVertexBuffer(u32 obj)
         {
             glBindBuffer(GL_ARRAY_BUFFER, obj);
         }
         void OpenGlContext::VertexBufferData(u32 size, const void *data, BufferUsage usage)
         {
-            u32 usage_type = buffer_usage_map_[usage];
+            u32 usage_type = kBufferUsages[usage];
             glBufferData(GL_ARRAY_BUFFER, size, data, usage_type);
         }
-        void OpenGlContext::VertexBufferSubData(u32 size, const void *data)
+        void OpenGlContext::VertexBufferSubData(u32 offset, u32 size, const void *data)
         {
-            glBufferSubData(GL_ARRAY_BUFFER, 0, size, data);
+            glBufferSubData(GL_ARRAY_BUFFER, offset, size, data);
         }
         void* OpenGlContext::MapVertexBufferData(DataAccessType access)
         {
-            u32 access_type = data_access_map_[access];
+            u32 access_type = kDataAccessTypes[access];
             return glMapBuffer(GL_ARRAY_BUFFER, access_type);
         }
         void OpenGlContext::UnmapVertexBufferData()
         {
             glUnmapBuffer(GL_ARRAY_BUFFER);
         }
+        void* OpenGlContext::MapVertexBufferRange(u32 offset, u32 size)
+        {
+            return glMapBufferRange(GL_ARRAY_BUFFER, offset, size,
+                GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+        }
+        void* OpenGlContext::MapVertexBufferPersistent(u32 size)
+        {
+#ifdef TARGET_WINDOWS
+            // Buffer storage is available since OpenGL 4.4
+            if (glBufferStorage == nullptr)
+                return nullptr;
+            const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+            glBufferStorage(GL_ARRAY_BUFFER, size, nullptr, flags);
+            return glMapBufferRange(GL_ARRAY_BUFFER, 0, size, flags);
+#else
+            // OpenGL version on macOS is limited to 4.1
+            return nullptr;
+#endif
+        }
         void OpenGlContext::GenIndexBuffer(u32& obj)
         {
             glGenBuffers(1, &obj);
         }
-        void OpenGlContext::DeleteIndexBuffer(u32& obj)
+        void OpenGlContext::ApiDeleteIndexBuffer(u32& obj)
         {
             glDeleteBuffers(1, &obj);
         }
-        void OpenGlContext::BindIndexBuffer(u32 obj)
+        void OpenGlContext::ApiBindIndexBuffer(u32 obj)
         {
             glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, obj);
         }
         void OpenGlContext::IndexBufferData(u32 size, const void *data, BufferUsage usage)
         {
-            u32 usage_type = buffer_usage_map_[usage];
+            u32 usage_type = kBufferUsages[usage];
             glBufferData(GL_ELEMENT_ARRAY_BUFFER, size, data, usage_type);
         }
-        void OpenGlContext::IndexBufferSubData(u32 size, const void *data)
+        void OpenGlContext::IndexBufferSubData(u32 offset, u32 size, const void *data)
         {
-            glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, size, data);
+            glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, offset, size, data);
         }
         void* OpenGlContext::MapIndexBufferData(DataAccessType access)
         {
-            u32 access_type = data_access_map_[access];
+            u32 access_type = kDataAccessTypes[access];
             return glMapBuffer(GL_ELEMENT_ARRAY_BUFFER, access_type);
         }
         void OpenGlContext::UnmapIndexBufferData()
         {
             glUnmapBuffer(GL_ELEMENT_ARRAY_BUFFER);
         }
-        void OpenGlContext::VertexAttribPointer(u32 index, s32 size, DataType type, u32 stride, const void* ptr)
+        void OpenGlContext::VertexAttribPointer(u32 index, s32 size, DataType type, u32 stride, const void* ptr, bool normalized)
         {
-            u32 data_type = data_type_map_[type];
-            glVertexAttribPointer(index, size, data_type, GL_FALSE, stride, ptr);
+            u32 data_type = kDataTypes[type];
+            glVertexAttribPointer(index, size, data_type, normalized ? GL_TRUE : GL_FALSE, stride, ptr);
         }
         void OpenGlContext::EnableVertexAttribArray(u32 index)
         {
             glEnableVertexAttribArray(index);
         }
-        void OpenGlContext::DeleteProgram(u32 program)
+        void OpenGlContext::VertexAttribDivisor(u32 index, u32 divisor)
+        {
+            glVertexAttribDivisor(index, divisor);
+        }
+        SyncObject OpenGlContext::FenceSync()
+        {
+            return glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        }
+        bool OpenGlContext::ClientWaitSync(SyncObject sync, u64 timeout_ns)
+        {
+            GLenum result = glClientWaitSync(static_cast<GLsync>(sync), GL_SYNC_FLUSH_COMMANDS_BIT, timeout_ns);
+            return result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED;
+        }
+        void OpenGlContext::DeleteSync(SyncObject sync)
+        {
+            glDeleteSync(static_cast<GLsync>(sync));
+        }
+        void OpenGlContext::ApiActiveTexture(u32 unit)
+        {
+            glActiveTexture(GL_TEXTURE0 + unit);
+        }
+        void OpenGlContext::ApiBindTexture(u32 target, u32 obj)
+        {
+            glBindTexture(target, obj);
+        }
+        void OpenGlContext::ApiDeleteTexture(u32& obj)
+        {
+            glDeleteTextures(1, &obj);
+        }
+        void OpenGlContext::TextureImage2D(u32 target, s32 level, s32 internal_format, s32 w, s32 h,
+            u32 format, u32 type, const void *data)
+        {
+            glTexImage2D(target, level, internal_format, w, h, 0, format, type, data);
+        }
+        void OpenGlContext::TextureSubImage2D(u32 target, s32 level, s32 x, s32 y, s32 w, s32 h,
+            u32 format, u32 type, const void *data)
+        {
+            glTexSubImage2D(target, level, x, y, w, h, format, type, data);
+        }
+        void OpenGlContext::GetTextureImage(u32 target, s32 level, u32 format, u32 type, void *data)
+        {
+            // Rows are tightly packed, RGB rows aren't always aligned to four bytes
+            glPixelStorei(GL_PACK_ALIGNMENT, 1);
+            glGetTexImage(target, level, format, type, data);
+        }
+        void OpenGlContext::GenerateMipmap(u32 target)
+        {
+            glGenerateMipmap(target);
+        }
+        void OpenGlContext::ApiDeleteProgram(u32 program)
         {
             glDeleteProgram(program);
         }
-        void OpenGlContext::BindProgram(u32 program)
+        void OpenGlContext::ApiBindProgram(u32 program)
         {
             glUseProgram(program);
         }
@@ -387,5 +525,158 @@ namespace sht {
             glUniformMatrix4fv(location, n, trans, v);
         }
         
+        void OpenGlContext::GetActiveUniforms(u32 program, std::vector<UniformInfo> * uniforms)
+        {
+            uniforms->clear();
+            GLint num_uniforms = 0;
+            GLint max_length = 0;
+            glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &num_uniforms);
+            glGetProgramiv(program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &max_length);
+            std::vector<char> name(max_length + 1);
+            for (GLint i = 0; i < num_uniforms; ++i)
+            {
+                GLsizei length = 0;
+                GLint count = 0;
+                GLenum type = 0;
+                glGetActiveUniform(program, (GLuint)i, (GLsizei)name.size(), &length, &count, &type, &name[0]);
+                GLint location = glGetUniformLocation(program, &name[0]);
+                if (location == -1) // uniform block members have no location
+                    continue;
+                UniformInfo info;
+                info.name.assign(&name[0], length);
+                if (info.name.size() > 3 && info.name.compare(info.name.size() - 3, 3, "[0]") == 0)
+                    info.name.resize(info.name.size() - 3);
+                info.location = location;
+                info.type = type;
+                info.size = GetUniformTypeSize(type);
+                info.count = (u32)count;
+                uniforms->push_back(info);
+            }
+        }
+        void OpenGlContext::SetUniform1i(s32 location, int x)
+        {
+            glUniform1i(location, x);
+        }
+        void OpenGlContext::SetUniform2i(s32 location, int x, int y)
+        {
+            glUniform2i(location, x, y);
+        }
+        void OpenGlContext::SetUniform3i(s32 location, int x, int y, int z)
+        {
+            glUniform3i(location, x, y, z);
+        }
+        void OpenGlContext::SetUniform4i(s32 location, int x, int y, int z, int w)
+        {
+            glUniform4i(location, x, y, z, w);
+        }
+        void OpenGlContext::SetUniform1f(s32 location, float x)
+        {
+            glUniform1f(location, x);
+        }
+        void OpenGlContext::SetUniform2f(s32 location, float x, float y)
+        {
+            glUniform2f(location, x, y);
+        }
+        void OpenGlContext::SetUniform3f(s32 location, float x, float y, float z)
+        {
+            glUniform3f(location, x, y, z);
+        }
+        void OpenGlContext::SetUniform4f(s32 location, float x, float y, float z, float w)
+        {
+            glUniform4f(location, x, y, z, w);
+        }
+        void OpenGlContext::SetUniform1fv(s32 location, const float *v, int n)
+        {
+            glUniform1fv(location, n, v);
+        }
+        void OpenGlContext::SetUniform2fv(s32 location, const float *v, int n)
+        {
+            glUniform2fv(location, n, v);
+        }
+        void OpenGlContext::SetUniform3fv(s32 location, const float *v, int n)
+        {
+            glUniform3fv(location, n, v);
+        }
+        void OpenGlContext::SetUniform4fv(s32 location, const float *v, int n)
+        {
+            glUniform4fv(location, n, v);
+        }
+        void OpenGlContext::SetUniformMatrix2fv(s32 location, const float *v, bool trans, int n)
+        {
+            glUniformMatrix2fv(location, n, trans, v);
+        }
+        void OpenGlContext::SetUniformMatrix3fv(s32 location, const float *v, bool trans, int n)
+        {
+            glUniformMatrix3fv(location, n, trans, v);
+        }
+        void OpenGlContext::SetUniformMatrix4fv(s32 location, const float *v, bool trans, int n)
+        {
+            glUniformMatrix4fv(location, n, trans, v);
+        }
+        void OpenGlContext::GenUniformBuffer(u32& obj)
+        {
+            glGenBuffers(1, &obj);
+        }
+        void OpenGlContext::DeleteUniformBuffer(u32& obj)
+        {
+            glDeleteBuffers(1, &obj);
+        }
+        void OpenGlContext::BindUniformBuffer(u32 obj)
+        {
+            glBindBuffer(GL_UNIFORM_BUFFER, obj);
+        }
+        void OpenGlContext::UniformBufferData(u32 size, const void *data, BufferUsage usage)
+        {
+            u32 usage_type = kBufferUsages[usage];
+            glBufferData(GL_UNIFORM_BUFFER, size, data, usage_type);
+        }
+        void OpenGlContext::UniformBufferSubData(u32 offset, u32 size, const void *data)
+        {
+            glBufferSubData(GL_UNIFORM_BUFFER, offset, size, data);
+        }
+        void OpenGlContext::BindUniformBufferBase(u32 binding, u32 obj)
+        {
+            glBindBufferBase(GL_UNIFORM_BUFFER, binding, obj);
+        }
+        s32 OpenGlContext::GetUniformBlockIndex(u32 program, const char *name)
+        {
+            GLuint index = glGetUniformBlockIndex(program, name);
+            return (index == GL_INVALID_INDEX) ? -1 : static_cast<s32>(index);
+        }
+        void OpenGlContext::UniformBlockBinding(u32 program, u32 block_index, u32 binding)
+        {
+            glUniformBlockBinding(program, block_index, binding);
+        }
+        void OpenGlContext::GenPixelBuffer(u32& obj)
+        {
+            glGenBuffers(1, &obj);
+        }
+        void OpenGlContext::DeletePixelBuffer(u32& obj)
+        {
+            glDeleteBuffers(1, &obj);
+        }
+        void OpenGlContext::BindPixelPackBuffer(u32 obj)
+        {
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, obj);
+        }
+        void OpenGlContext::PixelPackBufferData(u32 size)
+        {
+            glBufferData(GL_PIXEL_PACK_BUFFER, size, nullptr, GL_STREAM_READ);
+        }
+        void OpenGlContext::ReadPixels(s32 x, s32 y, s32 w, s32 h, u32 format, u32 type, void *data)
+        {
+            // Rows are tightly packed, RGB rows aren't always aligned to four bytes
+            glPixelStorei(GL_PACK_ALIGNMENT, 1);
+            glReadPixels(x, y, w, h, format, type, data);
+        }
+        const void* OpenGlContext::MapPixelPackBuffer(u32 size)
+        {
+            return glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, size, GL_MAP_READ_BIT);
+        }
+        void OpenGlContext::UnmapPixelPackBuffer()
+        {
+            glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        }
+        
     } // namespace graphics
 } // namespace sht
\ No newline at end of file
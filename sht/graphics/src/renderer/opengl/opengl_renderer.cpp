@@ -17,6 +17,8 @@ namespace sht {
         : Renderer(w, h)
 		{
             context_ = new OpenGlContext();
+            residency_manager_ = new ResidencyManager(context_);
+            shader_manager_ = new ShaderManager(context_);
             
 			framebuffer_ = 0;
 			current_image_unit_ = 0;
@@ -26,6 +28,11 @@ namespace sht {
 		}
 		OpenGlRenderer::~OpenGlRenderer()
 		{
+            ReleaseRingBuffer();
+            ReleaseScreenshotQueue();
+            ReleaseRenderTargetPool();
+            delete residency_manager_;
+            delete shader_manager_;
             delete context_;
             
 			// delete our framebuffer, if it exists
@@ -33,31 +40,40 @@ namespace sht {
 		}
 		void OpenGlRenderer::SetDefaultStates()
 		{
-			glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+			// States cached by context are changed through it
+			context_->ClearColor(0.0f, 0.0f, 0.0f, 0.0f);
 			glClearDepth(1.0f);
 
 			glDepthFunc(GL_LEQUAL);
-			glEnable(GL_DEPTH_TEST);
+			context_->EnableDepthTest();
 
-			glCullFace(GL_BACK);
+			context_->CullFace(CullFaceType::kBack);
 			glFrontFace(GL_CCW);
 			glEnable(GL_CULL_FACE);
 
 			glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-			glEnable(GL_BLEND);
+			context_->EnableBlend();
 
 			glHint(GL_POLYGON_SMOOTH_HINT, GL_NICEST);
 		}
 		void OpenGlRenderer::ApiAddTexture(Texture* &tex, const Image &img, Texture::Wrap wrap, Texture::Filter filt)
+		{
+			ApiCreateTexture2D(tex, img.width(), img.height(), img.format(), wrap, filt, img.pixels());
+		}
+		void OpenGlRenderer::ApiAddTextureStorage(Texture* &tex, int w, int h, Image::Format fmt, Texture::Wrap wrap, Texture::Filter filt)
+		{
+			ApiCreateTexture2D(tex, w, h, fmt, wrap, filt, nullptr);
+		}
+		void OpenGlRenderer::ApiCreateTexture2D(Texture* &tex, int w, int h, Image::Format fmt, Texture::Wrap wrap, Texture::Filter filt, const u8 * data)
 		{
 			tex = new OpenGlTexture();
-			tex->width_ = img.width();
-			tex->height_ = img.height();
-			tex->format_ = img.format();
+			tex->width_ = w;
+			tex->height_ = h;
+			tex->format_ = fmt;
 			tex->ChooseTarget();
 
 			glGenTextures(1, &tex->texture_id_);
-			glBindTexture(tex->target_, tex->texture_id_);
+			context_->BindTexture(tex->target_, tex->texture_id_);
 
 			switch (wrap)
 			{
@@ -111,12 +127,14 @@ namespace sht {
                 0,              // border
 				tex->GetSrcFormat(), // the format of the pixel data
 				tex->GetSrcType(), // the data type of the pixel data
-				img.pixels());
-            glGenerateMipmap(tex->target_);
+				data);
+			// Storage-only textures get mipmaps after their data has been uploaded
+			if (data)
+				glGenerateMipmap(tex->target_);
 
 			context_->CheckForErrors();
 
-			textures_.push_back(tex);
+			RegisterTexture(tex);
 		}
 		void OpenGlRenderer::ApiAddTextureCubemap(Texture* &tex, Image *imgs, bool use_mipmaps)
 		{
@@ -127,7 +145,7 @@ namespace sht {
 			tex->target_ = GL_TEXTURE_CUBE_MAP;
 
 			glGenTextures(1, &tex->texture_id_);
-			glBindTexture(tex->target_, tex->texture_id_);
+			context_->BindTexture(tex->target_, tex->texture_id_);
 
 			glTexParameterf(tex->target_, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 			if (use_mipmaps)
@@ -182,13 +200,13 @@ namespace sht {
 
 			context_->CheckForErrors();
 
-			textures_.push_back(tex);
+			RegisterTexture(tex);
 		}
 		void OpenGlRenderer::ApiDeleteTexture(Texture* tex)
 		{
 			if (tex->texture_id_)
 			{
-				glDeleteTextures(1, &tex->texture_id_);
+				context_->DeleteTexture(tex->texture_id_);
 				tex->texture_id_ = 0;
 			}
 			if (tex->depth_id_)
@@ -211,7 +229,7 @@ namespace sht {
 			texture->target_ = GL_TEXTURE_2D;
 
 			glGenTextures(1, &texture->texture_id_);
-			glBindTexture(texture->target_, texture->texture_id_);
+			context_->BindTexture(texture->target_, texture->texture_id_);
 
 			glTexParameteri(texture->target_, GL_TEXTURE_WRAP_S, GL_REPEAT);
 			glTexParameteri(texture->target_, GL_TEXTURE_WRAP_T, GL_REPEAT);
@@ -243,7 +261,7 @@ namespace sht {
 
 			context_->CheckForErrors();
 
-			textures_.push_back(texture);
+			RegisterTexture(texture);
 		}
 		void OpenGlRenderer::CreateTextureCubemap(Texture* &texture, int w, int h, Image::Format fmt, Texture::Filter filt)
 		{
@@ -254,7 +272,7 @@ namespace sht {
 			texture->target_ = GL_TEXTURE_CUBE_MAP;
 
 			glGenTextures(1, &texture->texture_id_);
-			glBindTexture(texture->target_, texture->texture_id_);
+			context_->BindTexture(texture->target_, texture->texture_id_);
 
 			glTexParameterf(texture->target_, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 			switch (filt)
@@ -293,7 +311,7 @@ namespace sht {
 
 			context_->CheckForErrors();
 
-			textures_.push_back(texture);
+			RegisterTexture(texture);
 		}
 		void OpenGlRenderer::CreateTextureDepth(Texture* &texture, int w, int h, u32 depthSize)
 		{
@@ -310,7 +328,7 @@ namespace sht {
 			texture->target_ = GL_TEXTURE_2D;
 
 			glGenTextures(1, &texture->texture_id_);
-			glBindTexture(texture->target_, texture->texture_id_);
+			context_->BindTexture(texture->target_, texture->texture_id_);
 
 			glTexParameterf(texture->target_, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
 			glTexParameterf(texture->target_, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
@@ -334,7 +352,7 @@ namespace sht {
 
 			context_->CheckForErrors();
 
-			textures_.push_back(texture);
+			RegisterTexture(texture);
 		}
 		void OpenGlRenderer::CreateTexture(Texture* &texture, int w, int h, Image::Format fmt)
 		{
@@ -345,7 +363,7 @@ namespace sht {
 			texture->target_ = GL_TEXTURE_2D;
 
 			glGenTextures(1, &texture->texture_id_);
-			glBindTexture(texture->target_, texture->texture_id_);
+			context_->BindTexture(texture->target_, texture->texture_id_);
 
 			glTexParameterf(texture->target_, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
 			glTexParameterf(texture->target_, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
@@ -366,7 +384,7 @@ namespace sht {
 
 			context_->CheckForErrors();
 
-			textures_.push_back(texture);
+			RegisterTexture(texture);
 		}
 		void OpenGlRenderer::CreateTextureFromData(Texture* &texture, int w, int h, Image::Format fmt, unsigned char *data)
 		{
@@ -377,7 +395,7 @@ namespace sht {
 			texture->target_ = GL_TEXTURE_2D;
 
 			glGenTextures(1, &texture->texture_id_);
-			glBindTexture(texture->target_, texture->texture_id_);
+			context_->BindTexture(texture->target_, texture->texture_id_);
             
             glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
 
@@ -400,7 +418,7 @@ namespace sht {
 
 			context_->CheckForErrors();
 
-			textures_.push_back(texture);
+			RegisterTexture(texture);
 		}
 		void OpenGlRenderer::AddRenderTarget(Texture* &texture, int w, int h, Image::Format fmt, Texture::Filter filt)
 		{
@@ -413,7 +431,7 @@ namespace sht {
 			texture->target_ = GL_TEXTURE_2D;
 
 			glGenTextures(1, &texture->texture_id_);
-			glBindTexture(texture->target_, texture->texture_id_);
+			context_->BindTexture(texture->target_, texture->texture_id_);
 
 			switch (filt)
 			{
@@ -444,7 +462,7 @@ namespace sht {
 
 			context_->CheckForErrors();
 
-			textures_.push_back(texture);
+			RegisterTexture(texture);
 		}
 		void OpenGlRenderer::AddRenderDepthStencil(Texture* &texture, int w, int h, u32 depthSize, u32 stencilSize)
 		{
@@ -487,7 +505,7 @@ namespace sht {
 
 			context_->CheckForErrors();
 
-			textures_.push_back(texture);
+			RegisterTexture(texture);
 		}
 		void OpenGlRenderer::DeleteTexture(Texture* texture)
 		{
@@ -497,59 +515,43 @@ namespace sht {
 			if (it != textures_.end())
 			{
 				textures_.erase(it);
+				residency_manager_->Remove(texture);
 				delete texture;
 			}
 		}
 		void OpenGlRenderer::ChangeImageUnit(u32 unit)
 		{
-			if (unit != current_image_unit_)
-			{
-				glActiveTexture(GL_TEXTURE0 + unit);
-				current_image_unit_ = unit;
-			}
+			context_->ActiveTexture(unit);
+			current_image_unit_ = unit;
 		}
 		void OpenGlRenderer::ChangeTexture(Texture* texture, u32 layer)
 		{
+			// Textures may be bound through context by other subsystems,
+			// so redundant binds are filtered there rather than here
 			Texture * curTex = current_textures_[layer];
-			if (texture != curTex)
+			if (texture == nullptr)
 			{
-				// change image unit
-				ChangeImageUnit(layer);
-				if (texture == nullptr)
+				// No texture wanted, so just unbind the target
+				if (curTex != nullptr)
 				{
-					// No texture wanted, so just disable the target
-#if 0 // deprecated in core
-					glDisable(curTex->target_);
-#endif
-                    glBindTexture(curTex->target_, 0);
+					ChangeImageUnit(layer);
+					context_->BindTexture(curTex->target_, 0);
 				}
-				else
-				{
-#if 0 // deprecated in core
-					if (curTex == nullptr)
-					{
-						// No texture currently bound, so enable the target
-						glEnable(texture->target_);
-					}
-					else if (texture->target_ != curTex->target_)
-					{
-						// Change enabled target
-						glDisable(curTex->target_);
-						glEnable(texture->target_);
-					}
-#endif
-					// Bind the texture
-					glBindTexture(texture->target_, texture->texture_id_);
-				}
-				current_textures_[layer] = texture;
 			}
+			else
+			{
+				ChangeImageUnit(layer);
+				context_->BindTexture(texture->target_, texture->texture_id_);
+				residency_manager_->Touch(texture);
+			}
+			current_textures_[layer] = texture;
 		}
 		void OpenGlRenderer::ChangeRenderTargets(u8 nTargets, Texture* *colorRTs, Texture* depthRT)
 		{
 			if (nTargets == 1 && colorRTs[0] == nullptr && depthRT == nullptr)
 			{
 				glBindFramebuffer(GL_FRAMEBUFFER, 0);
-				glViewport(0, 0, width_, height_);
+				context_->Viewport(width_, height_);
 			}
 			else
 			{
@@ -604,7 +606,7 @@ namespace sht {
 				}
 
 				Texture * tex = (colorRTs[0] != nullptr) ? colorRTs[0] : depthRT;
-				glViewport(0, 0, tex->width_, tex->height_);
+				context_->Viewport(tex->width_, tex->height_);
 			}
 
 			context_->CheckFrameBufferStatus();
@@ -614,7 +616,7 @@ namespace sht {
 			if (nTargets == 1 && colorRTs[0] == nullptr && depthRT == nullptr)
 			{
 				glBindFramebuffer(GL_FRAMEBUFFER, 0);
-				glViewport(0, 0, width_, height_);
+				context_->Viewport(width_, height_);
 			}
 			else
 			{
@@ -666,7 +668,7 @@ namespace sht {
 				}
 
 				Texture * tex = (colorRTs[0] != nullptr) ? colorRTs[0] : depthRT;
-				glViewport(0, 0, tex->width_ >> level, tex->height_ >> level);
+				context_->Viewport(tex->width_ >> level, tex->height_ >> level);
 			}
 
 			context_->CheckFrameBufferStatus();
@@ -676,9 +678,9 @@ namespace sht {
 			Texture * curtex = current_textures_[current_image_unit_];
 			if (texture != curtex && curtex != nullptr)
 			{
-				glBindTexture(texture->target_, texture->texture_id_);
+				context_->BindTexture(texture->target_, texture->texture_id_);
 				glGenerateMipmap(texture->target_);
-				glBindTexture(curtex->target_, curtex->texture_id_);
+				context_->BindTexture(curtex->target_, curtex->texture_id_);
 			}
 			else
 				glGenerateMipmap(texture->target_);
@@ -759,6 +761,7 @@ namespace sht {
 			context_->CheckForErrors();
 
 			vertex_buffers_.push_back(vb);
+			vertex_buffers_size_ += vb->GetSize();
 		}
 		void OpenGlRenderer::DeleteVertexBuffer(VertexBuffer* vb)
 		{
@@ -767,6 +770,7 @@ namespace sht {
 			if (it != vertex_buffers_.end())
 			{
 				vertex_buffers_.erase(it);
+				vertex_buffers_size_ -= vb->GetSize();
 				delete vb;
 			}
 		}
@@ -784,6 +788,7 @@ namespace sht {
 			context_->CheckForErrors();
 
 			index_buffers_.push_back(ib);
+			index_buffers_size_ += ib->GetSize();
 		}
 		void OpenGlRenderer::DeleteIndexBuffer(IndexBuffer* ib)
 		{
@@ -792,19 +797,27 @@ namespace sht {
 			if (it != index_buffers_.end())
 			{
 				index_buffers_.erase(it);
+				index_buffers_size_ -= ib->GetSize();
 				delete ib;
 			}
 		}
 		bool OpenGlRenderer::AddShader(Shader* &shader, const char* filename, const char **attribs, u32 n_attribs)
 		{
-            shader = Shader::Create(context_, filename, attribs, n_attribs);
-            if (shader == nullptr)
-                return false;
-
-			// Done with shader loading
-			shaders_.push_back(shader);
-
-			return true;
+			// Shaders deferred before are finished too
+			AddShaderDeferred(shader, filename, attribs, n_attribs);
+			CompileShaders();
+			return shader != nullptr;
+		}
+		void OpenGlRenderer::AddShaderDeferred(Shader* &shader, const char* filename, const char **attribs, u32 n_attribs)
+		{
+			shader_manager_->Add(shader, filename, attribs, n_attribs);
+		}
+		bool OpenGlRenderer::CompileShaders()
+		{
+			std::vector<Shader*> shaders;
+			bool result = shader_manager_->Finish(&shaders);
+			shaders_.insert(shaders_.end(), shaders.begin(), shaders.end());
+			return result;
 		}
 		void OpenGlRenderer::DeleteShader(Shader* shader)
 		{
@@ -847,7 +860,7 @@ namespace sht {
 		}
 		void OpenGlRenderer::ReadPixels(int w, int h, u8 *data)
 		{
-			glReadPixels(0, 0, w, h, GL_RGB, GL_UNSIGNED_BYTE, data);
+			context_->ReadPixels(0, 0, w, h, GL_RGB, GL_UNSIGNED_BYTE, data);
 		}
         void OpenGlRenderer::ClearColor(f32 r, f32 g, f32 b, f32 a)
         {
@@ -0,0 +1,1192 @@
+#include "../../include/renderer/recording_context.h"
+#include "../../../common/table.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <unordered_map>
+#include <assert.h>
+
+namespace {
+
+    using sht::graphics::RecordingContext;
+    typedef RecordingContext::CommandType CommandType;
+    typedef RecordingContext::UniformFunction UniformFunction;
+
+    constexpr EnumArray<CommandType, const char*> kCommandNames(
+        "ClearColor", "ClearColorBuffer", "ClearDepthBuffer", "ClearColorAndDepthBuffers",
+        "ClearStencil", "ClearStencilBuffer", "Viewport",
+        "EnableBlend", "DisableBlend", "EnableDepthTest", "DisableDepthTest",
+        "EnableDepthWrite", "DisableDepthWrite", "EnableStencilTest", "DisableStencilTest",
+        "StencilMask", "EnableWireframeMode", "DisableWireframeMode", "CullFace",
+        "DrawArrays", "DrawElements", "DrawArraysInstanced", "DrawElementsInstanced",
+        "DrawElementsBaseVertex", "MultiDrawElementsBaseVertex",
+        "GenVertexArrayObject", "DeleteVertexArrayObject", "BindVertexArrayObject",
+        "GenVertexBuffer", "DeleteVertexBuffer", "BindVertexBuffer", "VertexBufferData", "VertexBufferSubData",
+        "MapVertexBuffer", "MapVertexBufferPersistent",
+        "GenIndexBuffer", "DeleteIndexBuffer", "BindIndexBuffer", "IndexBufferData", "IndexBufferSubData",
+        "MapIndexBuffer",
+        "VertexAttribPointer", "EnableVertexAttribArray", "VertexAttribDivisor",
+        "FenceSync", "ClientWaitSync", "DeleteSync",
+        "ActiveTexture", "BindTexture", "DeleteTexture", "TextureImage2D", "TextureSubImage2D",
+        "GetTextureImage", "GenerateMipmap",
+        "DeleteProgram", "BindProgram", "BindAttribLocation", "Uniform", "SetUniform",
+        "GenUniformBuffer", "DeleteUniformBuffer", "BindUniformBuffer", "UniformBufferData",
+        "UniformBufferSubData", "BindUniformBufferBase", "UniformBlockBinding",
+        "GenPixelBuffer", "DeletePixelBuffer", "BindPixelPackBuffer", "PixelPackBufferData", "ReadPixels",
+        "MapPixelPackBuffer", "UnmapPixelPackBuffer");
+
+    //! Number of values passed to uniform function, vector functions multiply it by count
+    constexpr EnumArray<UniformFunction, u32> kUniformComponents(
+        1, 2, 3, 4,
+        1, 2, 3, 4,
+        1, 2, 3, 4,
+        4, 9, 16);
+
+    u32 FloatBits(float value)
+    {
+        u32 bits;
+        memcpy(&bits, &value, sizeof(bits));
+        return bits;
+    }
+    float BitsFloat(u32 bits)
+    {
+        float value;
+        memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    //! Size of pixel described by API format and type enums, zero if unknown
+    u32 GetPixelSize(u32 format, u32 type)
+    {
+        u32 components;
+        switch (format)
+        {
+        case 0x1902: // GL_DEPTH_COMPONENT
+        case 0x1903: // GL_RED
+        case 0x1906: // GL_ALPHA
+        case 0x1909: // GL_LUMINANCE
+            components = 1;
+            break;
+        case 0x190A: // GL_LUMINANCE_ALPHA
+        case 0x8227: // GL_RG
+            components = 2;
+            break;
+        case 0x1907: // GL_RGB
+            components = 3;
+            break;
+        case 0x1908: // GL_RGBA
+        case 0x80E1: // GL_BGRA
+            components = 4;
+            break;
+        default:
+            return 0;
+        }
+        switch (type)
+        {
+        case 0x1400: // GL_BYTE
+        case 0x1401: // GL_UNSIGNED_BYTE
+            return components;
+        case 0x1402: // GL_SHORT
+        case 0x1403: // GL_UNSIGNED_SHORT
+        case 0x140B: // GL_HALF_FLOAT
+            return components * 2;
+        case 0x1404: // GL_INT
+        case 0x1405: // GL_UNSIGNED_INT
+        case 0x1406: // GL_FLOAT
+            return components * 4;
+        default:
+            return 0;
+        }
+    }
+
+    void ReplayUniform(sht::graphics::Context * target, u32 program, const char *name, UniformFunction function,
+        const void *values, u32 count, bool transpose)
+    {
+        const int * i = reinterpret_cast<const int*>(values);
+        const float * f = reinterpret_cast<const float*>(values);
+        const int n = static_cast<int>(count);
+        switch (function)
+        {
+        case UniformFunction::k1i: target->Uniform1i(program, name, i[0]); break;
+        case UniformFunction::k2i: target->Uniform2i(program, name, i[0], i[1]); break;
+        case UniformFunction::k3i: target->Uniform3i(program, name, i[0], i[1], i[2]); break;
+        case UniformFunction::k4i: target->Uniform4i(program, name, i[0], i[1], i[2], i[3]); break;
+        case UniformFunction::k1f: target->Uniform1f(program, name, f[0]); break;
+        case UniformFunction::k2f: target->Uniform2f(program, name, f[0], f[1]); break;
+        case UniformFunction::k3f: target->Uniform3f(program, name, f[0], f[1], f[2]); break;
+        case UniformFunction::k4f: target->Uniform4f(program, name, f[0], f[1], f[2], f[3]); break;
+        case UniformFunction::k1fv: target->Uniform1fv(program, name, f, n); break;
+        case UniformFunction::k2fv: target->Uniform2fv(program, name, f, n); break;
+        case UniformFunction::k3fv: target->Uniform3fv(program, name, f, n); break;
+        case UniformFunction::k4fv: target->Uniform4fv(program, name, f, n); break;
+        case UniformFunction::kMatrix2fv: target->UniformMatrix2fv(program, name, f, transpose, n); break;
+        case UniformFunction::kMatrix3fv: target->UniformMatrix3fv(program, name, f, transpose, n); break;
+        case UniformFunction::kMatrix4fv: target->UniformMatrix4fv(program, name, f, transpose, n); break;
+        default: assert(!"unknown uniform function"); break;
+        }
+    }
+    void ReplaySetUniform(sht::graphics::Context * target, s32 location, UniformFunction function,
+        const void *values, u32 count, bool transpose)
+    {
+        const int * i = reinterpret_cast<const int*>(values);
+        const float * f = reinterpret_cast<const float*>(values);
+        const int n = static_cast<int>(count);
+        switch (function)
+        {
+        case UniformFunction::k1i: target->SetUniform1i(location, i[0]); break;
+        case UniformFunction::k2i: target->SetUniform2i(location, i[0], i[1]); break;
+        case UniformFunction::k3i: target->SetUniform3i(location, i[0], i[1], i[2]); break;
+        case UniformFunction::k4i: target->SetUniform4i(location, i[0], i[1], i[2], i[3]); break;
+        case UniformFunction::k1f: target->SetUniform1f(location, f[0]); break;
+        case UniformFunction::k2f: target->SetUniform2f(location, f[0], f[1]); break;
+        case UniformFunction::k3f: target->SetUniform3f(location, f[0], f[1], f[2]); break;
+        case UniformFunction::k4f: target->SetUniform4f(location, f[0], f[1], f[2], f[3]); break;
+        case UniformFunction::k1fv: target->SetUniform1fv(location, f, n); break;
+        case UniformFunction::k2fv: target->SetUniform2fv(location, f, n); break;
+        case UniformFunction::k3fv: target->SetUniform3fv(location, f, n); break;
+        case UniformFunction::k4fv: target->SetUniform4fv(location, f, n); break;
+        case UniformFunction::kMatrix2fv: target->SetUniformMatrix2fv(location, f, transpose, n); break;
+        case UniformFunction::kMatrix3fv: target->SetUniformMatrix3fv(location, f, transpose, n); break;
+        case UniformFunction::kMatrix4fv: target->SetUniformMatrix4fv(location, f, transpose, n); break;
+        default: assert(!"unknown uniform function"); break;
+        }
+    }
+
+} // namespace
+
+namespace sht {
+    namespace graphics {
+
+        RecordingContext::RecordingContext()
+        : mode_(Mode::kCommandsAndData)
+        , map_offset_(0)
+        , map_size_(0)
+        , pixel_pack_buffer_(0)
+        {
+            memset(&current_frame_, 0, sizeof(current_frame_));
+        }
+        RecordingContext::~RecordingContext()
+        {
+        }
+        void RecordingContext::set_mode(Mode mode)
+        {
+            mode_ = mode;
+        }
+        RecordingContext::Mode RecordingContext::mode() const
+        {
+            return mode_;
+        }
+        void RecordingContext::EndFrame()
+        {
+            frames_.push_back(current_frame_);
+            memset(&current_frame_, 0, sizeof(current_frame_));
+        }
+        void RecordingContext::Clear()
+        {
+            commands_.clear();
+            data_.clear();
+            frames_.clear();
+            memset(&current_frame_, 0, sizeof(current_frame_));
+        }
+        u32 RecordingContext::num_commands() const
+        {
+            return static_cast<u32>(commands_.size());
+        }
+        const RecordingContext::Command& RecordingContext::command(u32 index) const
+        {
+            return commands_[index];
+        }
+        const u8 * RecordingContext::command_data(u32 index) const
+        {
+            const Command& command = commands_[index];
+            return (command.data_size != 0) ? &data_[command.data_offset] : nullptr;
+        }
+        u32 RecordingContext::num_frames() const
+        {
+            return static_cast<u32>(frames_.size());
+        }
+        const RecordingContext::FrameStats& RecordingContext::frame_stats(u32 frame) const
+        {
+            return frames_[frame];
+        }
+        const RecordingContext::FrameStats& RecordingContext::current_frame_stats() const
+        {
+            return current_frame_;
+        }
+        RecordingContext::FrameStats RecordingContext::GetTotalStats() const
+        {
+            FrameStats total;
+            memset(&total, 0, sizeof(total));
+            for (const auto& frame : frames_)
+            {
+                total.commands += frame.commands;
+                total.draw_calls += frame.draw_calls;
+                total.vertices += frame.vertices;
+                total.binds += frame.binds;
+                total.state_changes += frame.state_changes;
+                total.uniform_uploads += frame.uniform_uploads;
+                total.readbacks += frame.readbacks;
+                total.uploaded_bytes += frame.uploaded_bytes;
+            }
+            return total;
+        }
+        void RecordingContext::Replay(Context * target) const
+        {
+            std::unordered_map<u32, u32> objects;   // recorded identifier -> target identifier
+            std::unordered_map<u32, SyncObject> syncs;
+            auto map = [&objects](u32 obj) -> u32
+            {
+                auto it = objects.find(obj);
+                return (it != objects.end()) ? it->second : obj;
+            };
+            std::vector<u8> readback;
+            for (u32 index = 0; index < num_commands(); ++index)
+            {
+                const Command& command = commands_[index];
+                const u32 * a = command.args;
+                const u8 * data = command_data(index);
+                u32 obj;
+                switch (command.type)
+                {
+                case CommandType::kClearColor:
+                    target->ClearColor(BitsFloat(a[0]), BitsFloat(a[1]), BitsFloat(a[2]), BitsFloat(a[3]));
+                    break;
+                case CommandType::kClearColorBuffer: target->ClearColorBuffer(); break;
+                case CommandType::kClearDepthBuffer: target->ClearDepthBuffer(); break;
+                case CommandType::kClearColorAndDepthBuffers: target->ClearColorAndDepthBuffers(); break;
+                case CommandType::kClearStencil: target->ClearStencil(static_cast<s32>(a[0])); break;
+                case CommandType::kClearStencilBuffer: target->ClearStencilBuffer(); break;
+                case CommandType::kViewport: target->Viewport(static_cast<int>(a[0]), static_cast<int>(a[1])); break;
+                case CommandType::kEnableBlend: target->EnableBlend(); break;
+                case CommandType::kDisableBlend: target->DisableBlend(); break;
+                case CommandType::kEnableDepthTest: target->EnableDepthTest(); break;
+                case CommandType::kDisableDepthTest: target->DisableDepthTest(); break;
+                case CommandType::kEnableDepthWrite: target->EnableDepthWrite(); break;
+                case CommandType::kDisableDepthWrite: target->DisableDepthWrite(); break;
+                case CommandType::kEnableStencilTest: target->EnableStencilTest(); break;
+                case CommandType::kDisableStencilTest: target->DisableStencilTest(); break;
+                case CommandType::kStencilMask: target->StencilMask(a[0]); break;
+                case CommandType::kEnableWireframeMode: target->EnableWireframeMode(); break;
+                case CommandType::kDisableWireframeMode: target->DisableWireframeMode(); break;
+                case CommandType::kCullFace: target->CullFace(static_cast<CullFaceType>(a[0])); break;
+                case CommandType::kDrawArrays:
+                    target->DrawArrays(static_cast<PrimitiveType>(a[0]), static_cast<s32>(a[1]), a[2]);
+                    break;
+                case CommandType::kDrawElements:
+                    target->DrawElements(static_cast<PrimitiveType>(a[0]), a[1], static_cast<DataType>(a[2]));
+                    break;
+                case CommandType::kDrawArraysInstanced:
+                    target->DrawArraysInstanced(static_cast<PrimitiveType>(a[0]), static_cast<s32>(a[1]), a[2], a[3]);
+                    break;
+                case CommandType::kDrawElementsInstanced:
+                    target->DrawElementsInstanced(static_cast<PrimitiveType>(a[0]), a[1], static_cast<DataType>(a[2]), a[3]);
+                    break;
+                case CommandType::kDrawElementsBaseVertex:
+                    target->DrawElementsBaseVertex(static_cast<PrimitiveType>(a[0]), a[1], static_cast<DataType>(a[2]),
+                        a[3], static_cast<s32>(a[4]));
+                    break;
+                case CommandType::kMultiDrawElementsBaseVertex:
+                {
+                    // Payload holds counts, first indices and base vertices
+                    const u32 draw_count = a[3];
+                    std::vector<u32> arrays(draw_count * 3);
+                    if (draw_count != 0)
+                        memcpy(&arrays[0], data, draw_count * 3 * sizeof(u32));
+                    target->MultiDrawElementsBaseVertex(static_cast<PrimitiveType>(a[0]), draw_count ? &arrays[0] : nullptr,
+                        static_cast<DataType>(a[2]), draw_count ? &arrays[draw_count] : nullptr,
+                        draw_count ? reinterpret_cast<const s32*>(&arrays[draw_count * 2]) : nullptr, draw_count);
+                    break;
+                }
+                case CommandType::kGenVertexArrayObject:
+                    target->GenVertexArrayObject(obj);
+                    objects[a[0]] = obj;
+                    break;
+                case CommandType::kDeleteVertexArrayObject:
+                    obj = map(a[0]);
+                    target->DeleteVertexArrayObject(obj);
+                    break;
+                case CommandType::kBindVertexArrayObject: target->BindVertexArrayObject(map(a[0])); break;
+                case CommandType::kGenVertexBuffer:
+                    target->GenVertexBuffer(obj);
+                    objects[a[0]] = obj;
+                    break;
+                case CommandType::kDeleteVertexBuffer:
+                    obj = map(a[0]);
+                    target->DeleteVertexBuffer(obj);
+                    break;
+                case CommandType::kBindVertexBuffer: target->BindVertexBuffer(map(a[0])); break;
+                case CommandType::kVertexBufferData:
+                    target->VertexBufferData(a[0], data, static_cast<BufferUsage>(a[1]));
+                    break;
+                case CommandType::kVertexBufferSubData:
+                    if (data)
+                        target->VertexBufferSubData(a[0], a[1], data);
+                    break;
+                case CommandType::kMapVertexBuffer:
+                {
+                    // Whole buffer or range mapping, written data is stored as payload
+                    void * pointer = (a[2] != 0) ? target->MapVertexBufferRange(a[0], a[1])
+                                                 : target->MapVertexBufferData(static_cast<DataAccessType>(a[3]));
+                    if (pointer && data)
+                        memcpy(pointer, data, command.data_size);
+                    target->UnmapVertexBufferData();
+                    break;
+                }
+                case CommandType::kMapVertexBufferPersistent: target->MapVertexBufferPersistent(a[0]); break;
+                case CommandType::kGenIndexBuffer:
+                    target->GenIndexBuffer(obj);
+                    objects[a[0]] = obj;
+                    break;
+                case CommandType::kDeleteIndexBuffer:
+                    obj = map(a[0]);
+                    target->DeleteIndexBuffer(obj);
+                    break;
+                case CommandType::kBindIndexBuffer: target->BindIndexBuffer(map(a[0])); break;
+                case CommandType::kIndexBufferData:
+                    target->IndexBufferData(a[0], data, static_cast<BufferUsage>(a[1]));
+                    break;
+                case CommandType::kIndexBufferSubData:
+                    if (data)
+                        target->IndexBufferSubData(a[0], a[1], data);
+                    break;
+                case CommandType::kMapIndexBuffer:
+                {
+                    void * pointer = target->MapIndexBufferData(static_cast<DataAccessType>(a[3]));
+                    if (pointer && data)
+                        memcpy(pointer, data, command.data_size);
+                    target->UnmapIndexBufferData();
+                    break;
+                }
+                case CommandType::kVertexAttribPointer:
+                    target->VertexAttribPointer(a[0], static_cast<s32>(a[1]), static_cast<DataType>(a[2]), a[3],
+                        reinterpret_cast<const void*>(static_cast<uintptr_t>(a[4])), a[5] != 0);
+                    break;
+                case CommandType::kEnableVertexAttribArray: target->EnableVertexAttribArray(a[0]); break;
+                case CommandType::kVertexAttribDivisor: target->VertexAttribDivisor(a[0], a[1]); break;
+                case CommandType::kFenceSync: syncs[a[0]] = target->FenceSync(); break;
+                case CommandType::kClientWaitSync:
+                    target->ClientWaitSync(syncs[a[0]], (static_cast<u64>(a[2]) << 32) | a[1]);
+                    break;
+                case CommandType::kDeleteSync:
+                    target->DeleteSync(syncs[a[0]]);
+                    syncs.erase(a[0]);
+                    break;
+                case CommandType::kActiveTexture: target->ActiveTexture(a[0]); break;
+                case CommandType::kBindTexture: target->BindTexture(a[0], a[1]); break;
+                case CommandType::kDeleteTexture:
+                    obj = a[0];
+                    target->DeleteTexture(obj);
+                    break;
+                case CommandType::kTextureImage2D:
+                    target->TextureImage2D(a[0], static_cast<s32>(a[1]), static_cast<s32>(a[2]), static_cast<s32>(a[3]),
+                        static_cast<s32>(a[4]), a[5], a[6], data);
+                    break;
+                case CommandType::kTextureSubImage2D:
+                    target->TextureSubImage2D(a[0], static_cast<s32>(a[1]), static_cast<s32>(a[2]), static_cast<s32>(a[3]),
+                        static_cast<s32>(a[4]), static_cast<s32>(a[5]), a[6], a[7], data);
+                    break;
+                case CommandType::kGetTextureImage:
+                    // Readback goes to scratch memory, its size has been recorded
+                    readback.resize(a[4]);
+                    if (!readback.empty())
+                        target->GetTextureImage(a[0], static_cast<s32>(a[1]), a[2], a[3], &readback[0]);
+                    break;
+                case CommandType::kGenerateMipmap: target->GenerateMipmap(a[0]); break;
+                case CommandType::kDeleteProgram: target->DeleteProgram(a[0]); break;
+                case CommandType::kBindProgram: target->BindProgram(a[0]); break;
+                case CommandType::kBindAttribLocation:
+                    target->BindAttribLocation(a[0], reinterpret_cast<const char*>(data));
+                    break;
+                case CommandType::kUniform:
+                {
+                    // Payload holds name and values
+                    const char * name = reinterpret_cast<const char*>(data);
+                    const u32 name_size = static_cast<u32>(strlen(name)) + 1;
+                    std::vector<u32> values((command.data_size - name_size + 3) / 4 + 1);
+                    memcpy(&values[0], data + name_size, command.data_size - name_size);
+                    ReplayUniform(target, a[0], name, static_cast<UniformFunction>(a[1]), &values[0], a[2], a[3] != 0);
+                    break;
+                }
+                case CommandType::kSetUniform:
+                {
+                    std::vector<u32> values(command.data_size / 4 + 1);
+                    if (data)
+                        memcpy(&values[0], data, command.data_size);
+                    ReplaySetUniform(target, static_cast<s32>(a[0]), static_cast<UniformFunction>(a[1]), &values[0],
+                        a[2], a[3] != 0);
+                    break;
+                }
+                case CommandType::kGenUniformBuffer:
+                    target->GenUniformBuffer(obj);
+                    objects[a[0]] = obj;
+                    break;
+                case CommandType::kDeleteUniformBuffer:
+                    obj = map(a[0]);
+                    target->DeleteUniformBuffer(obj);
+                    break;
+                case CommandType::kBindUniformBuffer: target->BindUniformBuffer(map(a[0])); break;
+                case CommandType::kUniformBufferData:
+                    target->UniformBufferData(a[0], data, static_cast<BufferUsage>(a[1]));
+                    break;
+                case CommandType::kUniformBufferSubData:
+                    if (data)
+                        target->UniformBufferSubData(a[0], a[1], data);
+                    break;
+                case CommandType::kBindUniformBufferBase: target->BindUniformBufferBase(a[0], map(a[1])); break;
+                case CommandType::kUniformBlockBinding: target->UniformBlockBinding(a[0], a[1], a[2]); break;
+                case CommandType::kGenPixelBuffer:
+                    target->GenPixelBuffer(obj);
+                    objects[a[0]] = obj;
+                    break;
+                case CommandType::kDeletePixelBuffer:
+                    obj = map(a[0]);
+                    target->DeletePixelBuffer(obj);
+                    break;
+                case CommandType::kBindPixelPackBuffer: target->BindPixelPackBuffer(map(a[0])); break;
+                case CommandType::kPixelPackBufferData: target->PixelPackBufferData(a[0]); break;
+                case CommandType::kReadPixels:
+                    // Client memory reads go to scratch memory, its size has been recorded
+                    if (a[7] != 0)
+                    {
+                        readback.resize(a[7]);
+                        target->ReadPixels(static_cast<s32>(a[0]), static_cast<s32>(a[1]), static_cast<s32>(a[2]),
+                            static_cast<s32>(a[3]), a[4], a[5], &readback[0]);
+                    }
+                    else
+                        target->ReadPixels(static_cast<s32>(a[0]), static_cast<s32>(a[1]), static_cast<s32>(a[2]),
+                            static_cast<s32>(a[3]), a[4], a[5], reinterpret_cast<void*>(static_cast<uintptr_t>(a[6])));
+                    break;
+                case CommandType::kMapPixelPackBuffer: target->MapPixelPackBuffer(a[0]); break;
+                case CommandType::kUnmapPixelPackBuffer: target->UnmapPixelPackBuffer(); break;
+                default:
+                    assert(!"unknown command");
+                    break;
+                }
+            }
+        }
+        bool RecordingContext::Compare(const RecordingContext& other, u32 * difference) const
+        {
+            const u32 count = std::min(num_commands(), other.num_commands());
+            for (u32 index = 0; index < count; ++index)
+            {
+                const Command& a = commands_[index];
+                const Command& b = other.commands_[index];
+                if (a.type != b.type || memcmp(a.args, b.args, sizeof(a.args)) != 0 || a.data_size != b.data_size ||
+                    (a.data_size != 0 && memcmp(command_data(index), other.command_data(index), a.data_size) != 0))
+                {
+                    *difference = index;
+                    return false;
+                }
+            }
+            if (num_commands() != other.num_commands())
+            {
+                *difference = count;
+                return false;
+            }
+            return true;
+        }
+        std::string RecordingContext::DescribeCommand(u32 index) const
+        {
+            const Command& command = commands_[index];
+            std::string text = GetCommandName(command.type);
+            u32 num_args = kMaxCommandArgs;
+            while (num_args > 0 && command.args[num_args - 1] == 0)
+                --num_args;
+            char buffer[32];
+            text += '(';
+            for (u32 i = 0; i < num_args; ++i)
+            {
+                sprintf(buffer, (i == 0) ? "%u" : ", %u", command.args[i]);
+                text += buffer;
+            }
+            text += ')';
+            if (command.data_size != 0)
+            {
+                if (command.type == CommandType::kUniform || command.type == CommandType::kBindAttribLocation)
+                {
+                    text += " \"";
+                    text += reinterpret_cast<const char*>(command_data(index));
+                    text += '"';
+                }
+                sprintf(buffer, " [%u bytes]", command.data_size);
+                text += buffer;
+            }
+            return text;
+        }
+        const char * RecordingContext::GetCommandName(CommandType type)
+        {
+            return kCommandNames[type];
+        }
+        RecordingContext::Command * RecordingContext::Record(CommandType type, const void *data, u32 size)
+        {
+            ++current_frame_.commands;
+            switch (type)
+            {
+            case CommandType::kBindVertexArrayObject:
+            case CommandType::kBindVertexBuffer:
+            case CommandType::kBindIndexBuffer:
+            case CommandType::kBindTexture:
+            case CommandType::kBindProgram:
+            case CommandType::kBindUniformBuffer:
+            case CommandType::kBindUniformBufferBase:
+            case CommandType::kBindPixelPackBuffer:
+                ++current_frame_.binds;
+                break;
+            case CommandType::kClearColor:
+            case CommandType::kViewport:
+            case CommandType::kEnableBlend:
+            case CommandType::kDisableBlend:
+            case CommandType::kEnableDepthTest:
+            case CommandType::kDisableDepthTest:
+            case CommandType::kEnableDepthWrite:
+            case CommandType::kDisableDepthWrite:
+            case CommandType::kEnableStencilTest:
+            case CommandType::kDisableStencilTest:
+            case CommandType::kStencilMask:
+            case CommandType::kEnableWireframeMode:
+            case CommandType::kDisableWireframeMode:
+            case CommandType::kCullFace:
+            case CommandType::kActiveTexture:
+            case CommandType::kVertexAttribPointer:
+            case CommandType::kEnableVertexAttribArray:
+            case CommandType::kVertexAttribDivisor:
+                ++current_frame_.state_changes;
+                break;
+            default:
+                break;
+            }
+
+            Command * command = &scratch_;
+            if (mode_ != Mode::kStatistics)
+            {
+                commands_.push_back(Command());
+                command = &commands_.back();
+            }
+            command->type = type;
+            memset(command->args, 0, sizeof(command->args));
+            command->data_offset = 0;
+            command->data_size = 0;
+            if (mode_ != Mode::kStatistics && data != nullptr && size != 0)
+            {
+                command->data_offset = static_cast<u32>(data_.size());
+                command->data_size = size;
+                const u8 * bytes = reinterpret_cast<const u8*>(data);
+                data_.insert(data_.end(), bytes, bytes + size);
+            }
+            return command;
+        }
+        RecordingContext::Command * RecordingContext::Record(CommandType type, u32 a0, u32 a1, u32 a2, u32 a3)
+        {
+            Command * command = Record(type);
+            command->args[0] = a0;
+            command->args[1] = a1;
+            command->args[2] = a2;
+            command->args[3] = a3;
+            return command;
+        }
+        void RecordingContext::RecordUpload(CommandType type, u32 a0, u32 a1, u32 a2, const void *data, u32 size)
+        {
+            if (data)
+                current_frame_.uploaded_bytes += size;
+            const bool store = (mode_ == Mode::kCommandsAndData);
+            Command * command = Record(type, store ? data : nullptr, size);
+            command->args[0] = a0;
+            command->args[1] = a1;
+            command->args[2] = a2;
+        }
+        void RecordingContext::RecordUniform(u32 program, const char *name, UniformFunction function, const void *values,
+            u32 size, u32 count, bool transpose)
+        {
+            ++current_frame_.uniform_uploads;
+            std::vector<u8> payload;
+            if (mode_ != Mode::kStatistics)
+            {
+                // Name goes first, values follow it
+                const u32 name_size = static_cast<u32>(strlen(name)) + 1;
+                payload.resize(name_size + size);
+                memcpy(&payload[0], name, name_size);
+                memcpy(&payload[name_size], values, size);
+            }
+            Command * command = Record(CommandType::kUniform, payload.empty() ? nullptr : &payload[0],
+                static_cast<u32>(payload.size()));
+            command->args[0] = program;
+            command->args[1] = static_cast<u32>(function);
+            command->args[2] = count;
+            command->args[3] = transpose ? 1 : 0;
+        }
+        void RecordingContext::RecordSetUniform(s32 location, UniformFunction function, const void *values,
+            u32 size, u32 count, bool transpose)
+        {
+            ++current_frame_.uniform_uploads;
+            Command * command = Record(CommandType::kSetUniform, values, size);
+            command->args[0] = static_cast<u32>(location);
+            command->args[1] = static_cast<u32>(function);
+            command->args[2] = count;
+            command->args[3] = transpose ? 1 : 0;
+        }
+        void RecordingContext::RecordDraw(CommandType type, u32 a0, u32 a1, u32 a2, u32 a3, u32 a4, u32 vertices)
+        {
+            ++current_frame_.draw_calls;
+            current_frame_.vertices += vertices;
+            Command * command = Record(type, a0, a1, a2, a3);
+            command->args[4] = a4;
+        }
+        void RecordingContext::RecordUnmap(CommandType type)
+        {
+            // Mapped memory belongs to null context, its contents are final now
+            const u8 * mapped = mapped_buffer_.empty() ? nullptr : &mapped_buffer_[map_offset_];
+            current_frame_.uploaded_bytes += map_size_;
+            const bool store = (mode_ == Mode::kCommandsAndData) && mapped != nullptr;
+            Command * command = Record(type, store ? mapped : nullptr, map_size_);
+            command->args[0] = map_offset_;
+            command->args[1] = map_size_;
+        }
+
+        // --- Recorded functions ---
+
+        void RecordingContext::ApiClearColor(f32 r, f32 g, f32 b, f32 a)
+        {
+            Record(CommandType::kClearColor, FloatBits(r), FloatBits(g), FloatBits(b), FloatBits(a));
+        }
+        void RecordingContext::ClearColorBuffer()
+        {
+            Record(CommandType::kClearColorBuffer);
+        }
+        void RecordingContext::ClearDepthBuffer()
+        {
+            Record(CommandType::kClearDepthBuffer);
+        }
+        void RecordingContext::ClearColorAndDepthBuffers()
+        {
+            Record(CommandType::kClearColorAndDepthBuffers);
+        }
+        void RecordingContext::ClearStencil(s32 value)
+        {
+            Record(CommandType::kClearStencil, static_cast<u32>(value));
+        }
+        void RecordingContext::ClearStencilBuffer()
+        {
+            Record(CommandType::kClearStencilBuffer);
+        }
+        void RecordingContext::ApiViewport(int w, int h)
+        {
+            Record(CommandType::kViewport, static_cast<u32>(w), static_cast<u32>(h));
+        }
+        void RecordingContext::ApiEnableBlend()
+        {
+            Record(CommandType::kEnableBlend);
+        }
+        void RecordingContext::ApiDisableBlend()
+        {
+            Record(CommandType::kDisableBlend);
+        }
+        void RecordingContext::ApiEnableDepthTest()
+        {
+            Record(CommandType::kEnableDepthTest);
+        }
+        void RecordingContext::ApiDisableDepthTest()
+        {
+            Record(CommandType::kDisableDepthTest);
+        }
+        void RecordingContext::ApiEnableDepthWrite()
+        {
+            Record(CommandType::kEnableDepthWrite);
+        }
+        void RecordingContext::ApiDisableDepthWrite()
+        {
+            Record(CommandType::kDisableDepthWrite);
+        }
+        void RecordingContext::ApiEnableStencilTest()
+        {
+            Record(CommandType::kEnableStencilTest);
+        }
+        void RecordingContext::ApiDisableStencilTest()
+        {
+            Record(CommandType::kDisableStencilTest);
+        }
+        void RecordingContext::ApiStencilMask(u32 mask)
+        {
+            Record(CommandType::kStencilMask, mask);
+        }
+        void RecordingContext::ApiEnableWireframeMode()
+        {
+            Record(CommandType::kEnableWireframeMode);
+        }
+        void RecordingContext::ApiDisableWireframeMode()
+        {
+            Record(CommandType::kDisableWireframeMode);
+        }
+        void RecordingContext::ApiCullFace(CullFaceType mode)
+        {
+            Record(CommandType::kCullFace, static_cast<u32>(mode));
+        }
+        void RecordingContext::DrawArrays(PrimitiveType mode, s32 first, u32 count)
+        {
+            RecordDraw(CommandType::kDrawArrays, static_cast<u32>(mode), static_cast<u32>(first), count, 0, 0, count);
+        }
+        void RecordingContext::DrawElements(PrimitiveType mode, u32 num_indices, DataType index_type)
+        {
+            RecordDraw(CommandType::kDrawElements, static_cast<u32>(mode), num_indices, static_cast<u32>(index_type), 0, 0,
+                num_indices);
+        }
+        void RecordingContext::DrawArraysInstanced(PrimitiveType mode, s32 first, u32 count, u32 num_instances)
+        {
+            RecordDraw(CommandType::kDrawArraysInstanced, static_cast<u32>(mode), static_cast<u32>(first), count,
+                num_instances, 0, count * num_instances);
+        }
+        void RecordingContext::DrawElementsInstanced(PrimitiveType mode, u32 num_indices, DataType index_type, u32 num_instances)
+        {
+            RecordDraw(CommandType::kDrawElementsInstanced, static_cast<u32>(mode), num_indices,
+                static_cast<u32>(index_type), num_instances, 0, num_indices * num_instances);
+        }
+        void RecordingContext::DrawElementsBaseVertex(PrimitiveType mode, u32 num_indices, DataType index_type,
+            u32 first_index, s32 base_vertex)
+        {
+            RecordDraw(CommandType::kDrawElementsBaseVertex, static_cast<u32>(mode), num_indices,
+                static_cast<u32>(index_type), first_index, static_cast<u32>(base_vertex), num_indices);
+        }
+        void RecordingContext::MultiDrawElementsBaseVertex(PrimitiveType mode, const u32 * num_indices, DataType index_type,
+            const u32 * first_indices, const s32 * base_vertices, u32 draw_count)
+        {
+            ++current_frame_.draw_calls;
+            std::vector<u32> arrays;
+            if (mode_ != Mode::kStatistics)
+                arrays.reserve(draw_count * 3);
+            for (u32 i = 0; i < draw_count; ++i)
+            {
+                current_frame_.vertices += num_indices[i];
+                if (mode_ != Mode::kStatistics)
+                    arrays.push_back(num_indices[i]);
+            }
+            if (mode_ != Mode::kStatistics)
+            {
+                arrays.insert(arrays.end(), first_indices, first_indices + draw_count);
+                for (u32 i = 0; i < draw_count; ++i)
+                    arrays.push_back(static_cast<u32>(base_vertices[i]));
+            }
+            Command * command = Record(CommandType::kMultiDrawElementsBaseVertex, arrays.empty() ? nullptr : &arrays[0],
+                static_cast<u32>(arrays.size() * sizeof(u32)));
+            command->args[0] = static_cast<u32>(mode);
+            command->args[2] = static_cast<u32>(index_type);
+            command->args[3] = draw_count;
+        }
+        void RecordingContext::GenVertexArrayObject(u32 &obj)
+        {
+            NullContext::GenVertexArrayObject(obj);
+            Record(CommandType::kGenVertexArrayObject, obj);
+        }
+        void RecordingContext::ApiDeleteVertexArrayObject(u32 &obj)
+        {
+            Record(CommandType::kDeleteVertexArrayObject, obj);
+            NullContext::ApiDeleteVertexArrayObject(obj);
+        }
+        void RecordingContext::ApiBindVertexArrayObject(u32 obj)
+        {
+            Record(CommandType::kBindVertexArrayObject, obj);
+        }
+        void RecordingContext::GenVertexBuffer(u32& obj)
+        {
+            NullContext::GenVertexBuffer(obj);
+            Record(CommandType::kGenVertexBuffer, obj);
+        }
+        void RecordingContext::ApiDeleteVertexBuffer(u32& obj)
+        {
+            Record(CommandType::kDeleteVertexBuffer, obj);
+            NullContext::ApiDeleteVertexBuffer(obj);
+        }
+        void RecordingContext::ApiBindVertexBuffer(u32 obj)
+        {
+            Record(CommandType::kBindVertexBuffer, obj);
+        }
+        void RecordingContext::VertexBufferData(u32 size, const void *data, BufferUsage usage)
+        {
+            NullContext::VertexBufferData(size, data, usage);
+            RecordUpload(CommandType::kVertexBufferData, size, static_cast<u32>(usage), 0, data, size);
+        }
+        void RecordingContext::VertexBufferSubData(u32 offset, u32 size, const void *data)
+        {
+            RecordUpload(CommandType::kVertexBufferSubData, offset, size, 0, data, size);
+        }
+        void* RecordingContext::MapVertexBufferData(DataAccessType access)
+        {
+            void * pointer = NullContext::MapVertexBufferData(access);
+            map_offset_ = 0;
+            map_size_ = vertex_buffer_size_;
+            // Command is recorded on unmap, access type is kept until then
+            scratch_.args[3] = static_cast<u32>(access);
+            scratch_.args[2] = 0;
+            return pointer;
+        }
+        void RecordingContext::UnmapVertexBufferData()
+        {
+            const u32 range = scratch_.args[2];
+            const u32 access = scratch_.args[3];
+            RecordUnmap(CommandType::kMapVertexBuffer);
+            Command * command = (mode_ != Mode::kStatistics) ? &commands_.back() : &scratch_;
+            command->args[2] = range;
+            command->args[3] = access;
+        }
+        void* RecordingContext::MapVertexBufferRange(u32 offset, u32 size)
+        {
+            void * pointer = NullContext::MapVertexBufferRange(offset, size);
+            map_offset_ = offset;
+            map_size_ = size;
+            scratch_.args[2] = 1;
+            scratch_.args[3] = 0;
+            return pointer;
+        }
+        void* RecordingContext::MapVertexBufferPersistent(u32 size)
+        {
+            Record(CommandType::kMapVertexBufferPersistent, size);
+            return NullContext::MapVertexBufferPersistent(size);
+        }
+        void RecordingContext::GenIndexBuffer(u32& obj)
+        {
+            NullContext::GenIndexBuffer(obj);
+            Record(CommandType::kGenIndexBuffer, obj);
+        }
+        void RecordingContext::ApiDeleteIndexBuffer(u32& obj)
+        {
+            Record(CommandType::kDeleteIndexBuffer, obj);
+            NullContext::ApiDeleteIndexBuffer(obj);
+        }
+        void RecordingContext::ApiBindIndexBuffer(u32 obj)
+        {
+            Record(CommandType::kBindIndexBuffer, obj);
+        }
+        void RecordingContext::IndexBufferData(u32 size, const void *data, BufferUsage usage)
+        {
+            NullContext::IndexBufferData(size, data, usage);
+            RecordUpload(CommandType::kIndexBufferData, size, static_cast<u32>(usage), 0, data, size);
+        }
+        void RecordingContext::IndexBufferSubData(u32 offset, u32 size, const void *data)
+        {
+            RecordUpload(CommandType::kIndexBufferSubData, offset, size, 0, data, size);
+        }
+        void* RecordingContext::MapIndexBufferData(DataAccessType access)
+        {
+            void * pointer = NullContext::MapIndexBufferData(access);
+            map_offset_ = 0;
+            map_size_ = index_buffer_size_;
+            scratch_.args[3] = static_cast<u32>(access);
+            return pointer;
+        }
+        void RecordingContext::UnmapIndexBufferData()
+        {
+            const u32 access = scratch_.args[3];
+            RecordUnmap(CommandType::kMapIndexBuffer);
+            Command * command = (mode_ != Mode::kStatistics) ? &commands_.back() : &scratch_;
+            command->args[3] = access;
+        }
+        void RecordingContext::VertexAttribPointer(u32 index, s32 size, DataType type, u32 stride, const void* ptr, bool normalized)
+        {
+            // Pointer is an offset in the bound buffer
+            Command * command = Record(CommandType::kVertexAttribPointer, index, static_cast<u32>(size),
+                static_cast<u32>(type), stride);
+            command->args[4] = static_cast<u32>(reinterpret_cast<uintptr_t>(ptr));
+            command->args[5] = normalized ? 1 : 0;
+        }
+        void RecordingContext::EnableVertexAttribArray(u32 index)
+        {
+            Record(CommandType::kEnableVertexAttribArray, index);
+        }
+        void RecordingContext::VertexAttribDivisor(u32 index, u32 divisor)
+        {
+            Record(CommandType::kVertexAttribDivisor, index, divisor);
+        }
+        SyncObject RecordingContext::FenceSync()
+        {
+            SyncObject sync = NullContext::FenceSync();
+            Record(CommandType::kFenceSync, static_cast<u32>(reinterpret_cast<uintptr_t>(sync)));
+            return sync;
+        }
+        bool RecordingContext::ClientWaitSync(SyncObject sync, u64 timeout_ns)
+        {
+            Record(CommandType::kClientWaitSync, static_cast<u32>(reinterpret_cast<uintptr_t>(sync)),
+                static_cast<u32>(timeout_ns), static_cast<u32>(timeout_ns >> 32));
+            return NullContext::ClientWaitSync(sync, timeout_ns);
+        }
+        void RecordingContext::DeleteSync(SyncObject sync)
+        {
+            Record(CommandType::kDeleteSync, static_cast<u32>(reinterpret_cast<uintptr_t>(sync)));
+        }
+        void RecordingContext::ApiActiveTexture(u32 unit)
+        {
+            Record(CommandType::kActiveTexture, unit);
+        }
+        void RecordingContext::ApiBindTexture(u32 target, u32 obj)
+        {
+            Record(CommandType::kBindTexture, target, obj);
+        }
+        void RecordingContext::ApiDeleteTexture(u32& obj)
+        {
+            Record(CommandType::kDeleteTexture, obj);
+            NullContext::ApiDeleteTexture(obj);
+        }
+        void RecordingContext::TextureImage2D(u32 target, s32 level, s32 internal_format, s32 w, s32 h,
+            u32 format, u32 type, const void *data)
+        {
+            const u32 size = static_cast<u32>(w) * static_cast<u32>(h) * GetPixelSize(format, type);
+            if (data)
+                current_frame_.uploaded_bytes += size;
+            const bool store = (mode_ == Mode::kCommandsAndData);
+            Command * command = Record(CommandType::kTextureImage2D, store ? data : nullptr, size);
+            const u32 args[7] = { target, static_cast<u32>(level), static_cast<u32>(internal_format),
+                static_cast<u32>(w), static_cast<u32>(h), format, type };
+            memcpy(command->args, args, sizeof(args));
+        }
+        void RecordingContext::TextureSubImage2D(u32 target, s32 level, s32 x, s32 y, s32 w, s32 h,
+            u32 format, u32 type, const void *data)
+        {
+            const u32 size = static_cast<u32>(w) * static_cast<u32>(h) * GetPixelSize(format, type);
+            if (data)
+                current_frame_.uploaded_bytes += size;
+            const bool store = (mode_ == Mode::kCommandsAndData);
+            Command * command = Record(CommandType::kTextureSubImage2D, store ? data : nullptr, size);
+            const u32 args[8] = { target, static_cast<u32>(level), static_cast<u32>(x), static_cast<u32>(y),
+                static_cast<u32>(w), static_cast<u32>(h), format, type };
+            memcpy(command->args, args, sizeof(args));
+        }
+        void RecordingContext::GetTextureImage(u32 target, s32 level, u32 format, u32 type, void *data)
+        {
+            // Size of level isn't known to context, so it's taken from the last upload of the level
+            u32 size = 0;
+            for (auto it = commands_.rbegin(); it != commands_.rend(); ++it)
+            {
+                if (it->type == CommandType::kTextureImage2D && it->args[1] == static_cast<u32>(level))
+                {
+                    size = it->args[3] * it->args[4] * GetPixelSize(format, type);
+                    break;
+                }
+            }
+            ++current_frame_.readbacks;
+            Command * command = Record(CommandType::kGetTextureImage, target, static_cast<u32>(level), format, type);
+            command->args[4] = size;
+            NullContext::GetTextureImage(target, level, format, type, data);
+        }
+        void RecordingContext::GenerateMipmap(u32 target)
+        {
+            Record(CommandType::kGenerateMipmap, target);
+        }
+        void RecordingContext::ApiDeleteProgram(u32 program)
+        {
+            Record(CommandType::kDeleteProgram, program);
+        }
+        void RecordingContext::ApiBindProgram(u32 program)
+        {
+            Record(CommandType::kBindProgram, program);
+        }
+        void RecordingContext::BindAttribLocation(u32 program, const char *name)
+        {
+            Command * command = Record(CommandType::kBindAttribLocation, name, static_cast<u32>(strlen(name)) + 1);
+            command->args[0] = program;
+        }
+        void RecordingContext::Uniform1i(u32 program, const char *name, int x)
+        {
+            RecordUniform(program, name, UniformFunction::k1i, &x, sizeof(x), 1, false);
+        }
+        void RecordingContext::Uniform2i(u32 program, const char *name, int x, int y)
+        {
+            const int v[2] = { x, y };
+            RecordUniform(program, name, UniformFunction::k2i, v, sizeof(v), 1, false);
+        }
+        void RecordingContext::Uniform3i(u32 program, const char *name, int x, int y, int z)
+        {
+            const int v[3] = { x, y, z };
+            RecordUniform(program, name, UniformFunction::k3i, v, sizeof(v), 1, false);
+        }
+        void RecordingContext::Uniform4i(u32 program, const char *name, int x, int y, int z, int w)
+        {
+            const int v[4] = { x, y, z, w };
+            RecordUniform(program, name, UniformFunction::k4i, v, sizeof(v), 1, false);
+        }
+        void RecordingContext::Uniform1f(u32 program, const char *name, float x)
+        {
+            RecordUniform(program, name, UniformFunction::k1f, &x, sizeof(x), 1, false);
+        }
+        void RecordingContext::Uniform2f(u32 program, const char *name, float x, float y)
+        {
+            const float v[2] = { x, y };
+            RecordUniform(program, name, UniformFunction::k2f, v, sizeof(v), 1, false);
+        }
+        void RecordingContext::Uniform3f(u32 program, const char *name, float x, float y, float z)
+        {
+            const float v[3] = { x, y, z };
+            RecordUniform(program, name, UniformFunction::k3f, v, sizeof(v), 1, false);
+        }
+        void RecordingContext::Uniform4f(u32 program, const char *name, float x, float y, float z, float w)
+        {
+            const float v[4] = { x, y, z, w };
+            RecordUniform(program, name, UniformFunction::k4f, v, sizeof(v), 1, false);
+        }
+        void RecordingContext::Uniform1fv(u32 program, const char *name, const float *v, int n)
+        {
+            RecordUniform(program, name, UniformFunction::k1fv, v, n * 1 * sizeof(float), n, false);
+        }
+        void RecordingContext::Uniform2fv(u32 program, const char *name, const float *v, int n)
+        {
+            RecordUniform(program, name, UniformFunction::k2fv, v, n * 2 * sizeof(float), n, false);
+        }
+        void RecordingContext::Uniform3fv(u32 program, const char *name, const float *v, int n)
+        {
+            RecordUniform(program, name, UniformFunction::k3fv, v, n * 3 * sizeof(float), n, false);
+        }
+        void RecordingContext::Uniform4fv(u32 program, const char *name, const float *v, int n)
+        {
+            RecordUniform(program, name, UniformFunction::k4fv, v, n * 4 * sizeof(float), n, false);
+        }
+        void RecordingContext::UniformMatrix2fv(u32 program, const char *name, const float *v, bool trans, int n)
+        {
+            RecordUniform(program, name, UniformFunction::kMatrix2fv, v, n * 4 * sizeof(float), n, trans);
+        }
+        void RecordingContext::UniformMatrix3fv(u32 program, const char *name, const float *v, bool trans, int n)
+        {
+            RecordUniform(program, name, UniformFunction::kMatrix3fv, v, n * 9 * sizeof(float), n, trans);
+        }
+        void RecordingContext::UniformMatrix4fv(u32 program, const char *name, const float *v, bool trans, int n)
+        {
+            RecordUniform(program, name, UniformFunction::kMatrix4fv, v, n * 16 * sizeof(float), n, trans);
+        }
+        void RecordingContext::SetUniform1i(s32 location, int x)
+        {
+            RecordSetUniform(location, UniformFunction::k1i, &x, sizeof(x), 1, false);
+        }
+        void RecordingContext::SetUniform2i(s32 location, int x, int y)
+        {
+            const int v[2] = { x, y };
+            RecordSetUniform(location, UniformFunction::k2i, v, sizeof(v), 1, false);
+        }
+        void RecordingContext::SetUniform3i(s32 location, int x, int y, int z)
+        {
+            const int v[3] = { x, y, z };
+            RecordSetUniform(location, UniformFunction::k3i, v, sizeof(v), 1, false);
+        }
+        void RecordingContext::SetUniform4i(s32 location, int x, int y, int z, int w)
+        {
+            const int v[4] = { x, y, z, w };
+            RecordSetUniform(location, UniformFunction::k4i, v, sizeof(v), 1, false);
+        }
+        void RecordingContext::SetUniform1f(s32 location, float x)
+        {
+            RecordSetUniform(location, UniformFunction::k1f, &x, sizeof(x), 1, false);
+        }
+        void RecordingContext::SetUniform2f(s32 location, float x, float y)
+        {
+            const float v[2] = { x, y };
+            RecordSetUniform(location, UniformFunction::k2f, v, sizeof(v), 1, false);
+        }
+        void RecordingContext::SetUniform3f(s32 location, float x, float y, float z)
+        {
+            const float v[3] = { x, y, z };
+            RecordSetUniform(location, UniformFunction::k3f, v, sizeof(v), 1, false);
+        }
+        void RecordingContext::SetUniform4f(s32 location, float x, float y, float z, float w)
+        {
+            const float v[4] = { x, y, z, w };
+            RecordSetUniform(location, UniformFunction::k4f, v, sizeof(v), 1, false);
+        }
+        void RecordingContext::SetUniform1fv(s32 location, const float *v, int n)
+        {
+            RecordSetUniform(location, UniformFunction::k1fv, v, n * 1 * sizeof(float), n, false);
+        }
+        void RecordingContext::SetUniform2fv(s32 location, const float *v, int n)
+        {
+            RecordSetUniform(location, UniformFunction::k2fv, v, n * 2 * sizeof(float), n, false);
+        }
+        void RecordingContext::SetUniform3fv(s32 location, const float *v, int n)
+        {
+            RecordSetUniform(location, UniformFunction::k3fv, v, n * 3 * sizeof(float), n, false);
+        }
+        void RecordingContext::SetUniform4fv(s32 location, const float *v, int n)
+        {
+            RecordSetUniform(location, UniformFunction::k4fv, v, n * 4 * sizeof(float), n, false);
+        }
+        void RecordingContext::SetUniformMatrix2fv(s32 location, const float *v, bool trans, int n)
+        {
+            RecordSetUniform(location, UniformFunction::kMatrix2fv, v, n * 4 * sizeof(float), n, trans);
+        }
+        void RecordingContext::SetUniformMatrix3fv(s32 location, const float *v, bool trans, int n)
+        {
+            RecordSetUniform(location, UniformFunction::kMatrix3fv, v, n * 9 * sizeof(float), n, trans);
+        }
+        void RecordingContext::SetUniformMatrix4fv(s32 location, const float *v, bool trans, int n)
+        {
+            RecordSetUniform(location, UniformFunction::kMatrix4fv, v, n * 16 * sizeof(float), n, trans);
+        }
+        void RecordingContext::GenUniformBuffer(u32& obj)
+        {
+            NullContext::GenUniformBuffer(obj);
+            Record(CommandType::kGenUniformBuffer, obj);
+        }
+        void RecordingContext::DeleteUniformBuffer(u32& obj)
+        {
+            Record(CommandType::kDeleteUniformBuffer, obj);
+            NullContext::DeleteUniformBuffer(obj);
+        }
+        void RecordingContext::BindUniformBuffer(u32 obj)
+        {
+            Record(CommandType::kBindUniformBuffer, obj);
+        }
+        void RecordingContext::UniformBufferData(u32 size, const void *data, BufferUsage usage)
+        {
+            RecordUpload(CommandType::kUniformBufferData, size, static_cast<u32>(usage), 0, data, size);
+        }
+        void RecordingContext::UniformBufferSubData(u32 offset, u32 size, const void *data)
+        {
+            RecordUpload(CommandType::kUniformBufferSubData, offset, size, 0, data, size);
+        }
+        void RecordingContext::BindUniformBufferBase(u32 binding, u32 obj)
+        {
+            Record(CommandType::kBindUniformBufferBase, binding, obj);
+        }
+        void RecordingContext::UniformBlockBinding(u32 program, u32 block_index, u32 binding)
+        {
+            Record(CommandType::kUniformBlockBinding, program, block_index, binding);
+        }
+
+        void RecordingContext::GenPixelBuffer(u32& obj)
+        {
+            NullContext::GenPixelBuffer(obj);
+            Record(CommandType::kGenPixelBuffer, obj);
+        }
+        void RecordingContext::DeletePixelBuffer(u32& obj)
+        {
+            Record(CommandType::kDeletePixelBuffer, obj);
+            NullContext::DeletePixelBuffer(obj);
+        }
+        void RecordingContext::BindPixelPackBuffer(u32 obj)
+        {
+            pixel_pack_buffer_ = obj;
+            Record(CommandType::kBindPixelPackBuffer, obj);
+        }
+        void RecordingContext::PixelPackBufferData(u32 size)
+        {
+            Record(CommandType::kPixelPackBufferData, size);
+        }
+        void RecordingContext::ReadPixels(s32 x, s32 y, s32 w, s32 h, u32 format, u32 type, void *data)
+        {
+            ++current_frame_.readbacks;
+            Command * command = Record(CommandType::kReadPixels, static_cast<u32>(x), static_cast<u32>(y),
+                static_cast<u32>(w), static_cast<u32>(h));
+            command->args[4] = format;
+            command->args[5] = type;
+            if (pixel_pack_buffer_ != 0)
+                command->args[6] = static_cast<u32>(reinterpret_cast<uintptr_t>(data));
+            else
+                command->args[7] = static_cast<u32>(w) * static_cast<u32>(h) * GetPixelSize(format, type);
+            NullContext::ReadPixels(x, y, w, h, format, type, data);
+        }
+        const void* RecordingContext::MapPixelPackBuffer(u32 size)
+        {
+            Record(CommandType::kMapPixelPackBuffer, size);
+            return NullContext::MapPixelPackBuffer(size);
+        }
+        void RecordingContext::UnmapPixelPackBuffer()
+        {
+            Record(CommandType::kUnmapPixelPackBuffer);
+        }
+
+    }
+}
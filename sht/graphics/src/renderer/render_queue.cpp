@@ -0,0 +1,336 @@
+#include "../../include/renderer/render_queue.h"
+#include "../../include/renderer/occlusion_culler.h"
+
+#include <cstring>
+#include <assert.h>
+
+namespace sht {
+    namespace graphics {
+
+        namespace {
+
+            //! Quantizes depth in range [0; 1] into 24 bits
+            u64 QuantizeDepth(f32 depth)
+            {
+                if (!(depth > 0.0f)) // handles NaN too
+                    return 0;
+                if (depth >= 1.0f)
+                    return 0xFFFFFF;
+                return static_cast<u64>(depth * static_cast<f32>(0xFFFFFF));
+            }
+
+        } // namespace
+
+        CommandBuffer::CommandBuffer()
+        {
+        }
+        DrawPacket * CommandBuffer::AddDrawElements(u64 key, Shader * shader, u32 vertex_array_object,
+            PrimitiveType mode, u32 num_indices, DataType index_type)
+        {
+            DrawPacket * packet = AddPacket(key, shader, vertex_array_object, mode);
+            packet->indexed = true;
+            packet->index_type = index_type;
+            packet->count = num_indices;
+            return packet;
+        }
+        DrawPacket * CommandBuffer::AddDrawArrays(u64 key, Shader * shader, u32 vertex_array_object,
+            PrimitiveType mode, s32 first, u32 count)
+        {
+            DrawPacket * packet = AddPacket(key, shader, vertex_array_object, mode);
+            packet->first = first;
+            packet->count = count;
+            return packet;
+        }
+        void CommandBuffer::SetTexture(u32 unit, Texture * texture)
+        {
+            assert(!packets_.empty() && unit < kMaxPacketTextures);
+            packets_.back().textures[unit] = texture;
+        }
+        void CommandBuffer::SetBoundingBox(const math::BoundingBox& box)
+        {
+            assert(!packets_.empty());
+            packets_.back().bounding_box = static_cast<u32>(boxes_.size());
+            boxes_.push_back(box);
+        }
+        void CommandBuffer::Uniform1i(UniformHandle handle, int x)
+        {
+            AddUniform(handle, UniformCommandType::kInt, &x, sizeof(x), 1);
+        }
+        void CommandBuffer::Uniform1f(UniformHandle handle, float x)
+        {
+            AddUniform(handle, UniformCommandType::kFloat, &x, sizeof(x), 1);
+        }
+        void CommandBuffer::Uniform2fv(UniformHandle handle, const float *v, int n)
+        {
+            AddUniform(handle, UniformCommandType::kVec2, v, sizeof(float) * 2, n);
+        }
+        void CommandBuffer::Uniform3fv(UniformHandle handle, const float *v, int n)
+        {
+            AddUniform(handle, UniformCommandType::kVec3, v, sizeof(float) * 3, n);
+        }
+        void CommandBuffer::Uniform4fv(UniformHandle handle, const float *v, int n)
+        {
+            AddUniform(handle, UniformCommandType::kVec4, v, sizeof(float) * 4, n);
+        }
+        void CommandBuffer::UniformMatrix3fv(UniformHandle handle, const float *v, int n)
+        {
+            AddUniform(handle, UniformCommandType::kMat3, v, sizeof(float) * 9, n);
+        }
+        void CommandBuffer::UniformMatrix4fv(UniformHandle handle, const float *v, int n)
+        {
+            AddUniform(handle, UniformCommandType::kMat4, v, sizeof(float) * 16, n);
+        }
+        void CommandBuffer::Clear()
+        {
+            packets_.clear();
+            uniforms_.clear();
+            data_.clear();
+            boxes_.clear();
+        }
+        size_t CommandBuffer::num_packets() const
+        {
+            return packets_.size();
+        }
+        DrawPacket * CommandBuffer::AddPacket(u64 key, Shader * shader, u32 vertex_array_object, PrimitiveType mode)
+        {
+            assert(shader);
+            packets_.push_back(DrawPacket());
+            DrawPacket * packet = &packets_.back();
+            packet->key = key;
+            packet->shader = shader;
+            for (u32 i = 0; i < kMaxPacketTextures; ++i)
+                packet->textures[i] = nullptr;
+            packet->vertex_array_object = vertex_array_object;
+            packet->mode = mode;
+            packet->indexed = false;
+            packet->index_type = DataType::kUnsignedInt;
+            packet->first = 0;
+            packet->count = 0;
+            packet->uniforms_begin = static_cast<u32>(uniforms_.size());
+            packet->num_uniforms = 0;
+            packet->bounding_box = kNoBoundingBox;
+            packet->visible = true;
+            return packet;
+        }
+        void CommandBuffer::AddUniform(UniformHandle handle, UniformCommandType type, const void *data, u32 size, int n)
+        {
+            assert(!packets_.empty());
+            UniformCommand command;
+            command.handle = handle;
+            command.type = type;
+            command.count = static_cast<u32>(n);
+            command.data_offset = static_cast<u32>(data_.size());
+            uniforms_.push_back(command);
+            ++packets_.back().num_uniforms;
+
+            // All uniform types consist of 4 byte words
+            const u32 num_words = size / sizeof(u32) * command.count;
+            data_.resize(data_.size() + num_words);
+            memcpy(&data_[command.data_offset], data, num_words * sizeof(u32));
+        }
+
+        RenderQueue::RenderQueue(Context * context)
+        : context_(context)
+        {
+            memset(&stats_, 0, sizeof(stats_));
+        }
+        RenderQueue::~RenderQueue()
+        {
+            for (auto buffer : buffers_)
+                delete buffer;
+            for (auto buffer : free_buffers_)
+                delete buffer;
+        }
+        CommandBuffer * RenderQueue::AcquireCommandBuffer()
+        {
+            std::lock_guard<std::mutex> guard(mutex_);
+            CommandBuffer * buffer;
+            if (free_buffers_.empty())
+                buffer = new CommandBuffer();
+            else
+            {
+                buffer = free_buffers_.back();
+                free_buffers_.pop_back();
+            }
+            buffers_.push_back(buffer);
+            return buffer;
+        }
+        void RenderQueue::Cull(OcclusionCuller * culler)
+        {
+            cull_boxes_.clear();
+            cull_packets_.clear();
+            for (auto buffer : buffers_)
+                for (auto& packet : buffer->packets_)
+                    if (packet.bounding_box != kNoBoundingBox)
+                    {
+                        cull_boxes_.push_back(buffer->boxes_[packet.bounding_box]);
+                        cull_packets_.push_back(&packet);
+                    }
+            const u32 count = static_cast<u32>(cull_boxes_.size());
+            const u32 num_visible = culler->TestBoxes(cull_boxes_.data(), count, &cull_visibility_);
+            for (u32 i = 0; i < count; ++i)
+                cull_packets_[i]->visible = cull_visibility_[i] != 0;
+            stats_.num_culled = count - num_visible;
+        }
+        void RenderQueue::Sort()
+        {
+            entries_.clear();
+            for (auto buffer : buffers_)
+                for (const auto& packet : buffer->packets_)
+                {
+                    if (!packet.visible)
+                        continue;
+                    SortEntry entry;
+                    entry.key = packet.key;
+                    entry.packet = &packet;
+                    entry.buffer = buffer;
+                    entries_.push_back(entry);
+                }
+            const size_t num_entries = entries_.size();
+            if (num_entries < 2)
+                return;
+
+            // LSD radix sort by bytes, histograms of all digits are made in one pass
+            u32 histograms[8][256];
+            memset(histograms, 0, sizeof(histograms));
+            for (const auto& entry : entries_)
+                for (int digit = 0; digit < 8; ++digit)
+                    ++histograms[digit][(entry.key >> (digit * 8)) & 0xFF];
+
+            temp_entries_.resize(num_entries);
+            std::vector<SortEntry> * src = &entries_;
+            std::vector<SortEntry> * dst = &temp_entries_;
+            for (int digit = 0; digit < 8; ++digit)
+            {
+                u32 * histogram = histograms[digit];
+                const int shift = digit * 8;
+                // Digit that is the same for all keys doesn't change order
+                if (histogram[((*src)[0].key >> shift) & 0xFF] == num_entries)
+                    continue;
+                u32 offset = 0;
+                for (int i = 0; i < 256; ++i)
+                {
+                    u32 count = histogram[i];
+                    histogram[i] = offset;
+                    offset += count;
+                }
+                for (const auto& entry : *src)
+                    (*dst)[histogram[(entry.key >> shift) & 0xFF]++] = entry;
+                std::swap(src, dst);
+            }
+            if (src != &entries_)
+                entries_.swap(temp_entries_);
+        }
+        void RenderQueue::Submit()
+        {
+            stats_.num_draws = 0;
+            stats_.num_shader_changes = 0;
+            stats_.num_texture_changes = 0;
+            Shader * current_shader = nullptr;
+            Texture * current_textures[kMaxPacketTextures] = { nullptr };
+            for (const auto& entry : entries_)
+            {
+                const DrawPacket * packet = entry.packet;
+                if (packet->shader != current_shader)
+                {
+                    current_shader = packet->shader;
+                    current_shader->Bind();
+                    ++stats_.num_shader_changes;
+                }
+                for (u32 unit = 0; unit < kMaxPacketTextures; ++unit)
+                {
+                    Texture * texture = packet->textures[unit];
+                    if (texture != nullptr && texture != current_textures[unit])
+                    {
+                        current_textures[unit] = texture;
+                        context_->ActiveTexture(unit);
+                        context_->BindTexture(texture->target_, texture->texture_id_);
+                        ++stats_.num_texture_changes;
+                    }
+                }
+                ApplyUniforms(entry.buffer, packet);
+                context_->BindVertexArrayObject(packet->vertex_array_object);
+                if (packet->indexed)
+                    context_->DrawElements(packet->mode, packet->count, packet->index_type);
+                else
+                    context_->DrawArrays(packet->mode, packet->first, packet->count);
+                ++stats_.num_draws;
+            }
+        }
+        void RenderQueue::Reset()
+        {
+            std::lock_guard<std::mutex> guard(mutex_);
+            for (auto buffer : buffers_)
+            {
+                buffer->Clear();
+                free_buffers_.push_back(buffer);
+            }
+            buffers_.clear();
+            entries_.clear();
+            stats_.num_culled = 0;
+        }
+        u32 RenderQueue::num_packets() const
+        {
+            return static_cast<u32>(entries_.size());
+        }
+        const DrawPacket * RenderQueue::sorted_packet(u32 index) const
+        {
+            return entries_[index].packet;
+        }
+        const RenderQueue::Stats& RenderQueue::stats() const
+        {
+            return stats_;
+        }
+        u64 RenderQueue::MakeOpaqueKey(u32 pass, u32 shader, u32 material, f32 depth)
+        {
+            return (static_cast<u64>(pass & 0xF) << 60) |
+                (static_cast<u64>(shader & 0xFFF) << 48) |
+                (static_cast<u64>(material & 0xFFFF) << 32) |
+                (QuantizeDepth(depth) << 8);
+        }
+        u64 RenderQueue::MakeTranslucentKey(u32 pass, f32 depth, u32 shader, u32 material)
+        {
+            return (static_cast<u64>(pass & 0xF) << 60) |
+                ((0xFFFFFF - QuantizeDepth(depth)) << 36) |
+                (static_cast<u64>(shader & 0xFFF) << 24) |
+                (static_cast<u64>(material & 0xFFFF) << 8);
+        }
+        void RenderQueue::ApplyUniforms(const CommandBuffer * buffer, const DrawPacket * packet)
+        {
+            Shader * shader = packet->shader;
+            const u32 end = packet->uniforms_begin + packet->num_uniforms;
+            for (u32 i = packet->uniforms_begin; i < end; ++i)
+            {
+                const UniformCommand& command = buffer->uniforms_[i];
+                const u32 * data = &buffer->data_[command.data_offset];
+                const float * values = reinterpret_cast<const float*>(data);
+                const int n = static_cast<int>(command.count);
+                switch (command.type)
+                {
+                case UniformCommandType::kInt:
+                    shader->Uniform1i(command.handle, *reinterpret_cast<const int*>(data));
+                    break;
+                case UniformCommandType::kFloat:
+                    shader->Uniform1f(command.handle, values[0]);
+                    break;
+                case UniformCommandType::kVec2:
+                    shader->Uniform2fv(command.handle, values, n);
+                    break;
+                case UniformCommandType::kVec3:
+                    shader->Uniform3fv(command.handle, values, n);
+                    break;
+                case UniformCommandType::kVec4:
+                    shader->Uniform4fv(command.handle, values, n);
+                    break;
+                case UniformCommandType::kMat3:
+                    shader->UniformMatrix3fv(command.handle, values, false, n);
+                    break;
+                case UniformCommandType::kMat4:
+                    shader->UniformMatrix4fv(command.handle, values, false, n);
+                    break;
+                }
+            }
+        }
+
+    } // namespace graphics
+} // namespace sht
@@ -0,0 +1,144 @@
+#include "../../include/renderer/render_target_pool.h"
+
+#include <assert.h>
+
+namespace sht {
+	namespace graphics {
+
+		RenderTargetDesc::RenderTargetDesc()
+		: width(0)
+		, height(0)
+		, format(Image::Format::kRGBA8)
+		, samples(1)
+		{
+		}
+		RenderTargetDesc::RenderTargetDesc(int w, int h, Image::Format fmt, u32 samples)
+		: width(w)
+		, height(h)
+		, format(fmt)
+		, samples(samples)
+		{
+		}
+		bool RenderTargetDesc::operator ==(const RenderTargetDesc& other) const
+		{
+			return width == other.width && height == other.height &&
+				format == other.format && samples == other.samples;
+		}
+		bool RenderTargetDesc::operator !=(const RenderTargetDesc& other) const
+		{
+			return !(*this == other);
+		}
+		RenderTargetPool::RenderTargetPool(const CreateFunction& create_function, const DeleteFunction& delete_function)
+		: create_function_(create_function)
+		, delete_function_(delete_function)
+		, frame_(0)
+		, max_unused_frames_(3)
+		{
+			stats_.created = 0;
+			stats_.reused = 0;
+			stats_.destroyed = 0;
+		}
+		RenderTargetPool::~RenderTargetPool()
+		{
+		}
+		Texture * RenderTargetPool::Acquire(const RenderTargetDesc& desc)
+		{
+			// Prefer the most recently used target, so the others can expire
+			Entry * best = nullptr;
+			for (auto& entry : entries_)
+			{
+				if (entry.in_use || entry.desc != desc)
+					continue;
+				if (best == nullptr || entry.last_used_frame > best->last_used_frame)
+					best = &entry;
+			}
+			if (best != nullptr)
+			{
+				best->in_use = true;
+				best->last_used_frame = frame_;
+				++stats_.reused;
+				return best->texture;
+			}
+			Texture * texture = create_function_(desc);
+			if (texture == nullptr)
+				return nullptr;
+			Entry entry;
+			entry.desc = desc;
+			entry.texture = texture;
+			entry.last_used_frame = frame_;
+			entry.in_use = true;
+			entries_.push_back(entry);
+			++stats_.created;
+			return texture;
+		}
+		void RenderTargetPool::Release(Texture * texture)
+		{
+			for (auto& entry : entries_)
+			{
+				if (entry.texture == texture)
+				{
+					assert(entry.in_use);
+					entry.in_use = false;
+					entry.last_used_frame = frame_;
+					return;
+				}
+			}
+			assert(!"texture doesn't belong to the pool");
+		}
+		void RenderTargetPool::EndFrame()
+		{
+			++frame_;
+			for (size_t i = 0; i < entries_.size(); )
+			{
+				Entry& entry = entries_[i];
+				if (!entry.in_use && frame_ - entry.last_used_frame > max_unused_frames_)
+				{
+					delete_function_(entry.texture);
+					++stats_.destroyed;
+					entries_[i] = entries_.back();
+					entries_.pop_back();
+				}
+				else
+					++i;
+			}
+		}
+		void RenderTargetPool::Clear()
+		{
+			for (auto& entry : entries_)
+			{
+				assert(!entry.in_use);
+				delete_function_(entry.texture);
+				++stats_.destroyed;
+			}
+			entries_.clear();
+		}
+		void RenderTargetPool::set_max_unused_frames(u32 frames)
+		{
+			max_unused_frames_ = frames;
+		}
+		u32 RenderTargetPool::num_targets() const
+		{
+			return static_cast<u32>(entries_.size());
+		}
+		u32 RenderTargetPool::num_free_targets() const
+		{
+			u32 count = 0;
+			for (const auto& entry : entries_)
+				if (!entry.in_use)
+					++count;
+			return count;
+		}
+		u32 RenderTargetPool::used_bytes() const
+		{
+			u32 size = 0;
+			for (const auto& entry : entries_)
+				size += entry.texture->GetSize();
+			return size;
+		}
+		const RenderTargetPool::Stats& RenderTargetPool::stats() const
+		{
+			return stats_;
+		}
+
+	} // namespace graphics
+} // namespace sht
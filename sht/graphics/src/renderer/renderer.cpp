@@ -2,14 +2,25 @@
 
 #include "../../include/renderer/cubemap_face_filler.h"
 #include "../../../system/include/filesystem/directory.h"
+#include "../../../system/include/tasks/service_pool.h"
 
 #include <ctime>
+#include <string>
 #include <algorithm>
+#include <vector>
 
 namespace sht {
 	namespace graphics {
 
 		Renderer::Renderer(int w, int h)
+		: texture_upload_queue_(nullptr)
+		, ring_buffer_(nullptr)
+		, screenshot_queue_(nullptr)
+		, render_target_pool_(nullptr)
+		, residency_manager_(nullptr)
+		, shader_manager_(nullptr)
+		, vertex_buffers_size_(0)
+		, index_buffers_size_(0)
 		{
 			UpdateSizes(w, h);
 			Setup2DMatrix();
@@ -23,6 +34,12 @@ namespace sht {
 		Renderer::~Renderer()
 		{
 			// Don't call any functions with virtual table here!
+			if (texture_upload_queue_)
+			{
+				// Pending decode callbacks reference the queue
+				system::ServicePool::GetShared()->WaitIdle();
+				delete texture_upload_queue_;
+			}
 		}
         Context * Renderer::context()
         {
@@ -62,6 +79,16 @@ namespace sht {
 		}
 		void Renderer::CleanUp(void)
 		{
+			// Drop pending uploads, their textures are deleted with the others
+			if (texture_upload_queue_)
+			{
+				system::ServicePool::GetShared()->WaitIdle();
+				texture_upload_queue_->Clear();
+			}
+
+			ReleaseRingBuffer();
+			ReleaseRenderTargetPool();
+
 			// Clean up textures
 			for (auto &obj : textures_)
 			{
@@ -69,6 +96,8 @@ namespace sht {
 				delete obj;
 			}
 			textures_.clear();
+			if (residency_manager_)
+				residency_manager_->Clear();
 
 			// Clean up shaders
 			for (auto &obj : shaders_)
@@ -97,6 +126,7 @@ namespace sht {
 				delete obj;
 			}
 			vertex_buffers_.clear();
+			vertex_buffers_size_ = 0;
 
 			// Clean up index buffers
 			for (auto &obj : index_buffers_)
@@ -104,6 +134,7 @@ namespace sht {
 				delete obj;
 			}
 			index_buffers_.clear();
+			index_buffers_size_ = 0;
 		}
 		void Renderer::CheckForUsing(void)
 		{
@@ -120,53 +151,54 @@ namespace sht {
 		}
 		u32 Renderer::GetUsedTexturesSize(void)
 		{
-			u32 s = 0;
-			for (auto &t : textures_)
-				s += t->GetSize();
-			return s;
+			return static_cast<u32>(residency_manager_->used_bytes());
 		}
 		u32 Renderer::GetUsedVertexBuffersSize(void)
 		{
-			u32 s = 0;
-			for (auto &vb : vertex_buffers_)
-				s += vb->GetSize();
-			return s;
+			return vertex_buffers_size_;
 		}
 		u32 Renderer::GetUsedIndexBuffersSize(void)
 		{
-			u32 s = 0;
-			for (auto &ib : index_buffers_)
-				s += ib->GetSize();
-			return s;
+			return index_buffers_size_;
+		}
+		ResidencyManager * Renderer::residency_manager()
+		{
+			return residency_manager_;
+		}
+		void Renderer::AddShaderDeferred(Shader* &shader, const char* filename, const char **attribs, u32 n_attribs)
+		{
+			// Renderers without shader manager have nothing to batch
+			AddShader(shader, filename, attribs, n_attribs);
+		}
+		bool Renderer::CompileShaders()
+		{
+			return true;
+		}
+		ShaderManager * Renderer::shader_manager()
+		{
+			return shader_manager_;
 		}
 		bool Renderer::TakeScreenshot(const char* directory_name)
 		{
-			// Fill our path string
 			char filename[50];
 			time_t now = time(nullptr);
-			strftime(filename, _countof(filename), "SS.%Y.%m.%d.%H.%M.%S.jpg", localtime(&now));
-			char delimeter[2] = { system::GetPathDelimeter(), '\0' };
-			size_t size = strlen(directory_name) + strlen(filename) + 2; // 1 is for delimeter, another 1 is for \0
-			char *full_filename = new char[size];
-			strcpy(full_filename, directory_name);
-			strcat(full_filename, delimeter);
-			strcat(full_filename, filename);
+			if (strftime(filename, _countof(filename), "SS.%Y.%m.%d.%H.%M.%S.jpg", localtime(&now)) == 0)
+				return false;
 
 			system::CreateDirectory(directory_name); // create directory if it doesn't exist
 
-			Image image;
-			// allocate memory and read pixels
-			u8 *data = image.Allocate(width_, height_, Image::Format::kRGB8);
-			ReadPixels(width_, height_, data);
-			if (!image.Save(full_filename))
-			{
-				delete[] full_filename;
-				return false;
-			}
-
-			delete[] full_filename;
+			std::string full_filename(directory_name);
+			full_filename += system::GetPathDelimeter();
+			full_filename += filename;
+			screenshot_queue()->Capture(width_, height_, full_filename.c_str());
 			return true;
 		}
+		ScreenshotQueue * Renderer::screenshot_queue()
+		{
+			if (screenshot_queue_ == nullptr)
+				screenshot_queue_ = new ScreenshotQueue(context_);
+			return screenshot_queue_;
+		}
 		void Renderer::Setup2DMatrix()
 		{
 			standart_2d_matrix_ = sht::math::OrthoMatrix(0.0f, aspect_ratio_, 0.0f, 1.0f, -1.0f, 1.0f);
@@ -178,10 +210,128 @@ namespace sht {
 				ApiAddTexture(texture, image, wrap, filt);
 			return texture != nullptr;
 		}
+		bool Renderer::AddEvictableTexture(Texture* &texture, const char* filename, Texture::Wrap wrap, Texture::Filter filt)
+		{
+			if (!AddTexture(texture, filename, wrap, filt))
+				return false;
+			std::string source(filename);
+			residency_manager_->SetEvictable(texture, [source](Image * image)
+			{
+				return image->LoadFromFile(source.c_str());
+			});
+			return true;
+		}
 		void Renderer::AddTextureFromImage(Texture* &texture, const Image& image, Texture::Wrap wrap, Texture::Filter filt)
 		{
 			ApiAddTexture(texture, image, wrap, filt);
 		}
+		void Renderer::AddTextureAsync(const char* filename, const TextureUploadQueue::ReadyCallback& callback,
+			Texture::Wrap wrap, Texture::Filter filt, const Image::DecodeOptions& options)
+		{
+			TextureUploadQueue * queue = texture_upload_queue();
+			Image * image = queue->AcquireStagingImage();
+			image->LoadAsync(filename, options, [queue, wrap, filt, callback](Image * loaded_image, bool success)
+			{
+				if (success)
+					queue->Enqueue(loaded_image, wrap, filt, callback);
+				else
+				{
+					queue->ReleaseStagingImage(loaded_image);
+					queue->Enqueue(nullptr, wrap, filt, callback);
+				}
+			});
+		}
+		void Renderer::ProcessTextureUploads(f32 budget_seconds)
+		{
+			if (texture_upload_queue_)
+				texture_upload_queue_->Process(budget_seconds);
+		}
+		TextureUploadQueue * Renderer::texture_upload_queue()
+		{
+			if (texture_upload_queue_ == nullptr)
+			{
+				texture_upload_queue_ = new TextureUploadQueue(context_,
+					[this](int w, int h, Image::Format fmt, Texture::Wrap wrap, Texture::Filter filt)
+				{
+					Texture * texture = nullptr;
+					ApiAddTextureStorage(texture, w, h, fmt, wrap, filt);
+					return texture;
+				});
+			}
+			return texture_upload_queue_;
+		}
+		RingBuffer * Renderer::ring_buffer()
+		{
+			if (ring_buffer_ == nullptr)
+				ring_buffer_ = new RingBuffer(context_, kRingBufferSize);
+			return ring_buffer_;
+		}
+		void Renderer::EndFrame()
+		{
+			if (ring_buffer_)
+				ring_buffer_->EndFrame();
+			if (screenshot_queue_)
+				screenshot_queue_->EndFrame(width_, height_);
+			if (render_target_pool_)
+				render_target_pool_->EndFrame();
+			residency_manager_->EndFrame();
+		}
+		void Renderer::ReleaseRingBuffer()
+		{
+			if (ring_buffer_)
+			{
+				delete ring_buffer_;
+				ring_buffer_ = nullptr;
+			}
+		}
+		RenderTargetPool * Renderer::render_target_pool()
+		{
+			if (render_target_pool_ == nullptr)
+			{
+				render_target_pool_ = new RenderTargetPool(
+					[this](const RenderTargetDesc& desc) -> Texture*
+					{
+						// Multisampled targets aren't supported by renderer yet
+						assert(desc.samples <= 1);
+						Texture * texture = nullptr;
+						switch (desc.format)
+						{
+						case Image::Format::kDepth16: CreateTextureDepth(texture, desc.width, desc.height, 16); break;
+						case Image::Format::kDepth24: CreateTextureDepth(texture, desc.width, desc.height, 24); break;
+						case Image::Format::kDepth32: CreateTextureDepth(texture, desc.width, desc.height, 32); break;
+						default: AddRenderTarget(texture, desc.width, desc.height, desc.format); break;
+						}
+						return texture;
+					},
+					[this](Texture * texture)
+					{
+						DeleteTexture(texture);
+					});
+			}
+			return render_target_pool_;
+		}
+		void Renderer::ReleaseRenderTargetPool()
+		{
+			if (render_target_pool_)
+			{
+				render_target_pool_->Clear();
+				delete render_target_pool_;
+				render_target_pool_ = nullptr;
+			}
+		}
+		void Renderer::ReleaseScreenshotQueue()
+		{
+			if (screenshot_queue_)
+			{
+				delete screenshot_queue_;
+				screenshot_queue_ = nullptr;
+			}
+		}
+		void Renderer::RegisterTexture(Texture * texture)
+		{
+			textures_.push_back(texture);
+			residency_manager_->Add(texture);
+		}
 		bool Renderer::AddTextureCubemap(Texture* &texture, const char* filename, CubemapFillType fill_type, int desired_width)
 		{
 			texture = nullptr;
@@ -202,16 +352,8 @@ namespace sht {
 			if (!face_filler)
 				return false;
 
-			bool succeed = true;
 			Image *images = new Image[6];
-			for (int face = 0; face < 6; ++face)
-			{
-				if (!face_filler->Fill(face, images + face))
-				{
-					succeed = false;
-					break;
-				}
-			}
+			bool succeed = face_filler->FillAll(images);
 			if (succeed)
 				ApiAddTextureCubemap(texture, images);
 			delete[] images;
@@ -0,0 +1,255 @@
+#include "../../include/renderer/residency_manager.h"
+#include "../../include/renderer/context.h"
+
+#include <algorithm>
+#include <assert.h>
+#include <cstring>
+
+namespace sht {
+	namespace graphics {
+
+		ResidencyManager::ResidencyManager(Context * context)
+		: context_(context)
+		, budget_(0)
+		, used_bytes_(0)
+		, max_restores_per_frame_(1)
+		, num_demoted_(0)
+		, frame_(0)
+		{
+			memset(&counters_, 0, sizeof(counters_));
+		}
+		ResidencyManager::~ResidencyManager()
+		{
+		}
+		void ResidencyManager::Add(Texture * texture)
+		{
+			assert(entries_.find(texture) == entries_.end());
+			Entry& entry = entries_[texture];
+			entry.last_used_frame = frame_;
+			entry.full_width = texture->width_;
+			entry.full_height = texture->height_;
+			entry.mip_bias = 0;
+			entry.evictable = false;
+			entry.restore_requested = false;
+			used_bytes_ += texture->GetSize();
+		}
+		void ResidencyManager::Remove(Texture * texture)
+		{
+			auto it = entries_.find(texture);
+			if (it == entries_.end())
+				return;
+			Entry& entry = it->second;
+			if (entry.evictable)
+				lru_.erase(entry.lru_position);
+			if (entry.mip_bias > 0)
+				--num_demoted_;
+			if (entry.restore_requested)
+				restore_requests_.erase(std::find(restore_requests_.begin(), restore_requests_.end(), texture));
+			used_bytes_ -= texture->GetSize();
+			entries_.erase(it);
+		}
+		void ResidencyManager::Clear()
+		{
+			entries_.clear();
+			lru_.clear();
+			restore_requests_.clear();
+			used_bytes_ = 0;
+			num_demoted_ = 0;
+		}
+		void ResidencyManager::SetEvictable(Texture * texture, const LoadFunction& load)
+		{
+			auto it = entries_.find(texture);
+			assert(it != entries_.end());
+			Entry& entry = it->second;
+			entry.load = load;
+			if (!entry.evictable)
+			{
+				entry.evictable = true;
+				entry.lru_position = lru_.insert(lru_.end(), texture);
+			}
+		}
+		void ResidencyManager::Touch(Texture * texture)
+		{
+			auto it = entries_.find(texture);
+			if (it == entries_.end())
+				return;
+			Entry& entry = it->second;
+			entry.last_used_frame = frame_;
+			if (!entry.evictable)
+				return;
+			lru_.splice(lru_.end(), lru_, entry.lru_position);
+			if (entry.mip_bias > 0 && !entry.restore_requested)
+			{
+				entry.restore_requested = true;
+				restore_requests_.push_back(texture);
+			}
+		}
+		void ResidencyManager::EndFrame()
+		{
+			ResetFrameCounters();
+
+			// Restores go first, so unused textures give way to the ones in use
+			u32 num_restores = 0;
+			for (auto it = restore_requests_.begin(); it != restore_requests_.end(); )
+			{
+				if (num_restores == max_restores_per_frame_)
+					break;
+				Texture * texture = *it;
+				Entry& entry = entries_[texture];
+				if (entry.last_used_frame != frame_)
+				{
+					// Texture isn't needed anymore
+					entry.restore_requested = false;
+					it = restore_requests_.erase(it);
+					continue;
+				}
+				const u64 size = texture->GetSize();
+				const u64 bytes_per_pixel = size / static_cast<u64>(texture->width_ * texture->height_);
+				const u64 full_size = bytes_per_pixel * static_cast<u64>(entry.full_width) * static_cast<u64>(entry.full_height);
+				MakeRoom(full_size - size);
+				if (OverBudget(full_size - size) || !Restore(texture, entry))
+				{
+					++counters_.failed_restores;
+					++it;
+					continue;
+				}
+				entry.restore_requested = false;
+				it = restore_requests_.erase(it);
+				++num_restores;
+			}
+
+			MakeRoom(0);
+			if (OverBudget(0))
+				++counters_.over_budget_frames;
+			++frame_;
+		}
+		void ResidencyManager::set_budget(u64 bytes)
+		{
+			budget_ = bytes;
+		}
+		void ResidencyManager::set_max_restores_per_frame(u32 count)
+		{
+			max_restores_per_frame_ = count;
+		}
+		u64 ResidencyManager::budget() const
+		{
+			return budget_;
+		}
+		u64 ResidencyManager::used_bytes() const
+		{
+			return used_bytes_;
+		}
+		u32 ResidencyManager::num_textures() const
+		{
+			return static_cast<u32>(entries_.size());
+		}
+		u32 ResidencyManager::num_evictable() const
+		{
+			return static_cast<u32>(lru_.size());
+		}
+		u32 ResidencyManager::num_demoted() const
+		{
+			return num_demoted_;
+		}
+		u32 ResidencyManager::frame() const
+		{
+			return frame_;
+		}
+		int ResidencyManager::mip_bias(Texture * texture) const
+		{
+			auto it = entries_.find(texture);
+			return (it == entries_.end()) ? 0 : it->second.mip_bias;
+		}
+		const ResidencyManager::Counters& ResidencyManager::counters() const
+		{
+			return counters_;
+		}
+		bool ResidencyManager::Demote(Texture * texture, Entry& entry)
+		{
+			const int width = texture->width_;
+			const int height = texture->height_;
+			if (width == 1 && height == 1)
+				return false;
+			const int new_width = std::max(width >> 1, 1);
+			const int new_height = std::max(height >> 1, 1);
+
+			// Level 1 becomes the new base level
+			const u32 old_size = texture->GetSize();
+			const u32 bytes_per_pixel = old_size / (width * height);
+			staging_.resize(static_cast<size_t>(new_width) * new_height * bytes_per_pixel);
+			context_->BindTexture(texture->target_, texture->texture_id_);
+			context_->GetTextureImage(texture->target_, 1, texture->GetSrcFormat(), texture->GetSrcType(), &staging_[0]);
+			context_->TextureImage2D(texture->target_, 0, texture->GetInternalFormat(), new_width, new_height,
+				texture->GetSrcFormat(), texture->GetSrcType(), &staging_[0]);
+			context_->GenerateMipmap(texture->target_);
+
+			texture->width_ = new_width;
+			texture->height_ = new_height;
+			const u32 new_size = texture->GetSize();
+			used_bytes_ -= old_size - new_size;
+			counters_.freed_bytes += old_size - new_size;
+			++counters_.demotions;
+			if (entry.mip_bias == 0)
+				++num_demoted_;
+			++entry.mip_bias;
+			if (new_width == 1 && new_height == 1)
+				++counters_.evictions;
+			return true;
+		}
+		bool ResidencyManager::Restore(Texture * texture, Entry& entry)
+		{
+			Image image;
+			if (!entry.load || !entry.load(&image))
+				return false;
+			if (image.format() != texture->format_ ||
+				image.width() != entry.full_width || image.height() != entry.full_height)
+			{
+				assert(!"Source image doesn't match texture");
+				return false;
+			}
+			const u32 old_size = texture->GetSize();
+			context_->BindTexture(texture->target_, texture->texture_id_);
+			context_->TextureImage2D(texture->target_, 0, texture->GetInternalFormat(), image.width(), image.height(),
+				texture->GetSrcFormat(), texture->GetSrcType(), image.pixels());
+			context_->GenerateMipmap(texture->target_);
+
+			texture->width_ = entry.full_width;
+			texture->height_ = entry.full_height;
+			const u32 new_size = texture->GetSize();
+			used_bytes_ += new_size - old_size;
+			counters_.loaded_bytes += new_size;
+			++counters_.restores;
+			entry.mip_bias = 0;
+			--num_demoted_;
+			return true;
+		}
+		void ResidencyManager::MakeRoom(u64 extra_bytes)
+		{
+			auto it = lru_.begin();
+			while (OverBudget(extra_bytes) && it != lru_.end())
+			{
+				Texture * texture = *it;
+				Entry& entry = entries_[texture];
+				// The rest of textures have been used in this frame too
+				if (entry.last_used_frame == frame_)
+					break;
+				if (!Demote(texture, entry))
+					++it;
+			}
+		}
+		bool ResidencyManager::OverBudget(u64 extra_bytes) const
+		{
+			return budget_ != 0 && used_bytes_ + extra_bytes > budget_;
+		}
+		void ResidencyManager::ResetFrameCounters()
+		{
+			counters_.demotions = 0;
+			counters_.evictions = 0;
+			counters_.restores = 0;
+			counters_.failed_restores = 0;
+			counters_.freed_bytes = 0;
+			counters_.loaded_bytes = 0;
+		}
+
+	} // namespace graphics
+} // namespace sht
@@ -0,0 +1,150 @@
+#include "../../include/renderer/ring_buffer.h"
+
+#include <cstring>
+#include <assert.h>
+
+namespace sht {
+    namespace graphics {
+        
+        namespace {
+            
+            const u64 kWaitTimeout = 1000000000ULL; // 1 second
+            
+        } // namespace
+        
+        RingBuffer::RingBuffer(Context * context, u32 size)
+        : context_(context)
+        , size_(size)
+        , mapped_(false)
+        , head_(0)
+        , frame_begin_(0)
+        , frame_(0)
+        {
+            memset(&stats_, 0, sizeof(stats_));
+            context_->GenVertexBuffer(id_);
+            context_->BindVertexBuffer(id_);
+            persistent_data_ = reinterpret_cast<u8*>(context_->MapVertexBufferPersistent(size_));
+            if (persistent_data_ == nullptr)
+                context_->VertexBufferData(size_, nullptr, BufferUsage::kStreamDraw);
+            
+            SyncObject sync = context_->FenceSync();
+            use_fences_ = (sync != nullptr);
+            if (use_fences_)
+                context_->DeleteSync(sync);
+        }
+        RingBuffer::~RingBuffer()
+        {
+            Unmap();
+            for (auto& frame : frames_)
+                context_->DeleteSync(frame.fence);
+            context_->DeleteVertexBuffer(id_);
+        }
+        RingAllocation RingBuffer::Map(u32 size, u32 alignment)
+        {
+            assert(!mapped_);
+            assert(alignment != 0 && size_ % alignment == 0);
+            RingAllocation allocation = { nullptr, 0 };
+            
+            u64 begin = (head_ + alignment - 1) / alignment * alignment;
+            if ((begin % size_) + size > size_)
+                begin = (begin / size_ + 1) * size_;
+            
+            // Data of the current frame can't be overwritten
+            if (begin + size - frame_begin_ > size_)
+            {
+                assert(!"frame data doesn't fit into ring buffer");
+                return allocation;
+            }
+            if (use_fences_)
+            {
+                // Wait until GPU has finished with regions we are going to overwrite
+                while (!frames_.empty() && begin + size - frames_.front().begin > size_)
+                {
+                    if (!context_->ClientWaitSync(frames_.front().fence, 0))
+                    {
+                        ++stats_.num_waits;
+                        context_->ClientWaitSync(frames_.front().fence, kWaitTimeout);
+                    }
+                    RetireFrame();
+                }
+            }
+            else
+            {
+                const u64 last_lap = (head_ == 0) ? 0 : (head_ - 1) / size_;
+                if (begin / size_ > last_lap)
+                {
+                    // Driver gives new storage and keeps the old one while it's in use
+                    assert(persistent_data_ == nullptr);
+                    context_->BindVertexBuffer(id_);
+                    context_->VertexBufferData(size_, nullptr, BufferUsage::kStreamDraw);
+                    ++stats_.num_orphans;
+                }
+            }
+            
+            head_ = begin + size;
+            ++stats_.num_allocations;
+            allocation.offset = static_cast<u32>(begin % size_);
+            if (persistent_data_)
+                allocation.pointer = persistent_data_ + allocation.offset;
+            else
+            {
+                context_->BindVertexBuffer(id_);
+                allocation.pointer = context_->MapVertexBufferRange(allocation.offset, size);
+                mapped_ = (allocation.pointer != nullptr);
+            }
+            return allocation;
+        }
+        void RingBuffer::Unmap()
+        {
+            if (!mapped_)
+                return;
+            context_->BindVertexBuffer(id_);
+            context_->UnmapVertexBufferData();
+            mapped_ = false;
+        }
+        void RingBuffer::EndFrame()
+        {
+            assert(!mapped_);
+            if (head_ != frame_begin_ && use_fences_)
+            {
+                Frame frame;
+                frame.fence = context_->FenceSync();
+                frame.begin = frame_begin_;
+                frame.end = head_;
+                frames_.push_back(frame);
+            }
+            frame_begin_ = head_;
+            ++frame_;
+            
+            // Release fences that have been signaled already
+            while (!frames_.empty() && context_->ClientWaitSync(frames_.front().fence, 0))
+                RetireFrame();
+        }
+        void RingBuffer::Bind()
+        {
+            context_->BindVertexBuffer(id_);
+        }
+        u32 RingBuffer::size() const
+        {
+            return size_;
+        }
+        u32 RingBuffer::frame() const
+        {
+            return frame_;
+        }
+        bool RingBuffer::persistent() const
+        {
+            return persistent_data_ != nullptr;
+        }
+        const RingBuffer::Stats& RingBuffer::stats() const
+        {
+            return stats_;
+        }
+        void RingBuffer::RetireFrame()
+        {
+            context_->DeleteSync(frames_.front().fence);
+            frames_.pop_front();
+        }
+        
+    } // namespace graphics
+} // namespace sht
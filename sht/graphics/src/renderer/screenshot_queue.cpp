@@ -0,0 +1,258 @@
+#include "../../include/renderer/screenshot_queue.h"
+#include "../../../system/include/filesystem/directory.h"
+#include "../../../system/include/tasks/service_pool.h"
+#include "../../../system/include/tasks/service_task_interface.h"
+
+#include <cstdio>
+#include <cstring>
+#include <assert.h>
+
+namespace {
+
+	// Readback format, the same as Renderer::ReadPixels has
+	const u32 kFormatRGB = 0x1907;			// GL_RGB
+	const u32 kTypeUnsignedByte = 0x1401;	// GL_UNSIGNED_BYTE
+	const u64 kWaitTimeout = 1000000000ULL;	// one second
+
+} // namespace
+
+namespace sht {
+	namespace graphics {
+
+		//! Task that saves captured image on service pool thread
+		class ScreenshotQueue::EncodeTask : public system::ServiceTaskInterface {
+		public:
+			EncodeTask(ScreenshotQueue * queue, Image * image, const std::string& filename)
+			: queue_(queue)
+			, image_(image)
+			, filename_(filename)
+			{
+			}
+			bool Execute() final
+			{
+				return image_->Save(filename_.c_str());
+			}
+			void Notify(bool success) final
+			{
+				queue_->OnEncoded(image_, success);
+			}
+
+		private:
+			ScreenshotQueue * queue_;
+			Image * image_;
+			std::string filename_;
+		};
+
+		ScreenshotQueue::ScreenshotQueue(Context * context, u32 num_buffers)
+		: context_(context)
+		, slots_(num_buffers)
+		, frame_(0)
+		, delay_(num_buffers > 1 ? num_buffers - 1 : 1)
+		, pending_encodes_(0)
+		, max_pending_encodes_(4)
+		, sequence_index_(0)
+		, sequence_active_(false)
+		{
+			assert(num_buffers > 0);
+			memset(&stats_, 0, sizeof(stats_));
+			for (auto& slot : slots_)
+			{
+				slot.buffer = 0;
+				slot.size = 0;
+				slot.fence = nullptr;
+				slot.width = 0;
+				slot.height = 0;
+				slot.frame = 0;
+				slot.busy = false;
+			}
+		}
+		ScreenshotQueue::~ScreenshotQueue()
+		{
+			Flush();
+			for (auto& slot : slots_)
+				if (slot.buffer)
+					context_->DeletePixelBuffer(slot.buffer);
+			for (auto image : images_)
+				delete image;
+		}
+		void ScreenshotQueue::Capture(int w, int h, const char * filename)
+		{
+			Slot * slot = AcquireSlot();
+			const u32 size = static_cast<u32>(w) * static_cast<u32>(h) * 3;
+			if (slot->buffer == 0)
+				context_->GenPixelBuffer(slot->buffer);
+			context_->BindPixelPackBuffer(slot->buffer);
+			if (slot->size < size)
+			{
+				context_->PixelPackBufferData(size);
+				slot->size = size;
+			}
+			context_->ReadPixels(0, 0, w, h, kFormatRGB, kTypeUnsignedByte, nullptr);
+			context_->BindPixelPackBuffer(0);
+			slot->fence = context_->FenceSync();
+			slot->width = w;
+			slot->height = h;
+			slot->filename = filename;
+			slot->frame = frame_;
+			slot->busy = true;
+
+			std::lock_guard<std::mutex> guard(mutex_);
+			++stats_.captured;
+		}
+		void ScreenshotQueue::StartSequence(const char * directory, const char * prefix, const char * extension)
+		{
+			system::CreateDirectory(directory); // create directory if it doesn't exist
+			sequence_prefix_ = directory;
+			sequence_prefix_ += system::GetPathDelimeter();
+			sequence_prefix_ += prefix;
+			sequence_extension_ = extension;
+			sequence_index_ = 0;
+			sequence_active_ = true;
+		}
+		void ScreenshotQueue::StopSequence()
+		{
+			sequence_active_ = false;
+		}
+		bool ScreenshotQueue::sequence_active() const
+		{
+			return sequence_active_;
+		}
+		void ScreenshotQueue::EndFrame(int w, int h)
+		{
+			if (sequence_active_)
+			{
+				char number[16];
+				sprintf(number, "_%06u.", sequence_index_++);
+				Capture(w, h, (sequence_prefix_ + number + sequence_extension_).c_str());
+			}
+			// Readbacks are finished in the order they've been issued
+			for (;;)
+			{
+				Slot * oldest = nullptr;
+				for (auto& slot : slots_)
+					if (slot.busy && (oldest == nullptr || slot.frame < oldest->frame))
+						oldest = &slot;
+				if (oldest == nullptr || !FinishSlot(oldest, frame_ - oldest->frame >= delay_))
+					break;
+			}
+			++frame_;
+		}
+		void ScreenshotQueue::Flush()
+		{
+			for (;;)
+			{
+				Slot * oldest = nullptr;
+				for (auto& slot : slots_)
+					if (slot.busy && (oldest == nullptr || slot.frame < oldest->frame))
+						oldest = &slot;
+				if (oldest == nullptr)
+					break;
+				FinishSlot(oldest, true);
+			}
+			std::unique_lock<std::mutex> lock(mutex_);
+			condition_.wait(lock, [this]{ return pending_encodes_ == 0; });
+		}
+		void ScreenshotQueue::set_max_pending_encodes(u32 count)
+		{
+			max_pending_encodes_ = (count > 0) ? count : 1;
+		}
+		u32 ScreenshotQueue::num_pending_readbacks() const
+		{
+			u32 count = 0;
+			for (const auto& slot : slots_)
+				if (slot.busy)
+					++count;
+			return count;
+		}
+		u32 ScreenshotQueue::num_pending_encodes()
+		{
+			std::lock_guard<std::mutex> guard(mutex_);
+			return pending_encodes_;
+		}
+		ScreenshotQueue::Stats ScreenshotQueue::stats()
+		{
+			std::lock_guard<std::mutex> guard(mutex_);
+			return stats_;
+		}
+		ScreenshotQueue::Slot * ScreenshotQueue::AcquireSlot()
+		{
+			Slot * oldest = nullptr;
+			for (auto& slot : slots_)
+			{
+				if (!slot.busy)
+					return &slot;
+				if (oldest == nullptr || slot.frame < oldest->frame)
+					oldest = &slot;
+			}
+			FinishSlot(oldest, true);
+			return oldest;
+		}
+		bool ScreenshotQueue::FinishSlot(Slot * slot, bool wait)
+		{
+			// Without fences the frame delay is the only guarantee
+			if (slot->fence != nullptr)
+			{
+				if (!context_->ClientWaitSync(slot->fence, 0))
+				{
+					if (!wait)
+						return false;
+					{
+						std::lock_guard<std::mutex> guard(mutex_);
+						++stats_.stalls;
+					}
+					context_->ClientWaitSync(slot->fence, kWaitTimeout);
+				}
+				context_->DeleteSync(slot->fence);
+				slot->fence = nullptr;
+			}
+			else if (!wait)
+				return false;
+
+			Image * image = AcquireImage();
+			u8 * pixels = image->Allocate(slot->width, slot->height, Image::Format::kRGB8);
+			const u32 size = static_cast<u32>(slot->width) * static_cast<u32>(slot->height) * 3;
+			context_->BindPixelPackBuffer(slot->buffer);
+			const void * data = context_->MapPixelPackBuffer(size);
+			if (data)
+				memcpy(pixels, data, size);
+			context_->UnmapPixelPackBuffer();
+			context_->BindPixelPackBuffer(0);
+			slot->busy = false;
+
+			if (data == nullptr)
+			{
+				OnEncoded(image, false);
+				return true;
+			}
+			system::ServicePool::GetShared()->AddTask(new EncodeTask(this, image, slot->filename));
+			return true;
+		}
+		Image * ScreenshotQueue::AcquireImage()
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			condition_.wait(lock, [this]{ return pending_encodes_ < max_pending_encodes_; });
+			++pending_encodes_;
+			if (!free_images_.empty())
+			{
+				Image * image = free_images_.back();
+				free_images_.pop_back();
+				return image;
+			}
+			Image * image = new Image();
+			images_.push_back(image);
+			return image;
+		}
+		void ScreenshotQueue::OnEncoded(Image * image, bool success)
+		{
+			std::lock_guard<std::mutex> guard(mutex_);
+			if (success)
+				++stats_.encoded;
+			else
+				++stats_.failed;
+			free_images_.push_back(image);
+			--pending_encodes_;
+			condition_.notify_all();
+		}
+
+	} // namespace graphics
+} // namespace sht
@@ -1,7 +1,8 @@
 #include "../../include/renderer/shader.h"
-#include "opengl/opengl_include.h"
-#include "../../../system/include/stream/file_stream.h"
-#include <string>
+#include "../../../utility/include/string_id.h"
+#include <algorithm>
+#include <cstring>
+#include <assert.h>
 
 namespace sht {
     namespace graphics {
@@ -25,191 +26,284 @@ namespace sht {
         }
         void Shader::Uniform1i(const char *name, int x)
         {
-            context_->Uniform1i(program_, name, x);
+            UniformHandle handle = GetUniformHandle(name);
+            if (handle.valid())
+                Uniform1i(handle, x);
+            else
+                context_->Uniform1i(program_, name, x);
         }
         void Shader::Uniform2i(const char *name, int x, int y)
         {
-            context_->Uniform2i(program_, name, x, y);
+            UniformHandle handle = GetUniformHandle(name);
+            if (handle.valid())
+                Uniform2i(handle, x, y);
+            else
+                context_->Uniform2i(program_, name, x, y);
         }
         void Shader::Uniform3i(const char *name, int x, int y, int z)
         {
-            context_->Uniform3i(program_, name, x, y, z);
+            UniformHandle handle = GetUniformHandle(name);
+            if (handle.valid())
+                Uniform3i(handle, x, y, z);
+            else
+                context_->Uniform3i(program_, name, x, y, z);
         }
         void Shader::Uniform4i(const char *name, int x, int y, int z, int w)
         {
-            context_->Uniform4i(program_, name, x, y, z, w);
+            UniformHandle handle = GetUniformHandle(name);
+            if (handle.valid())
+                Uniform4i(handle, x, y, z, w);
+            else
+                context_->Uniform4i(program_, name, x, y, z, w);
         }
         void Shader::Uniform1f(const char *name, float x)
         {
-            context_->Uniform1f(program_, name, x);
+            UniformHandle handle = GetUniformHandle(name);
+            if (handle.valid())
+                Uniform1f(handle, x);
+            else
+                context_->Uniform1f(program_, name, x);
         }
         void Shader::Uniform2f(const char *name, float x, float y)
         {
-            context_->Uniform2f(program_, name, x, y);
+            UniformHandle handle = GetUniformHandle(name);
+            if (handle.valid())
+                Uniform2f(handle, x, y);
+            else
+                context_->Uniform2f(program_, name, x, y);
         }
         void Shader::Uniform3f(const char *name, float x, float y, float z)
         {
-            context_->Uniform3f(program_, name, x, y, z);
+            UniformHandle handle = GetUniformHandle(name);
+            if (handle.valid())
+                Uniform3f(handle, x, y, z);
+            else
+                context_->Uniform3f(program_, name, x, y, z);
         }
         void Shader::Uniform4f(const char *name, float x, float y, float z, float w)
         {
-            context_->Uniform4f(program_, name, x, y, z, w);
+            UniformHandle handle = GetUniformHandle(name);
+            if (handle.valid())
+                Uniform4f(handle, x, y, z, w);
+            else
+                context_->Uniform4f(program_, name, x, y, z, w);
         }
         void Shader::Uniform1fv(const char *name, const float *v, int n)
         {
-            context_->Uniform1fv(program_, name, v, n);
+            UniformHandle handle = GetUniformHandle(name);
+            if (handle.valid())
+                Uniform1fv(handle, v, n);
+            else
+                context_->Uniform1fv(program_, name, v, n);
         }
         void Shader::Uniform2fv(const char *name, const float *v, int n)
         {
-            context_->Uniform2fv(program_, name, v, n);
+            UniformHandle handle = GetUniformHandle(name);
+            if (handle.valid())
+                Uniform2fv(handle, v, n);
+            else
+                context_->Uniform2fv(program_, name, v, n);
         }
         void Shader::Uniform3fv(const char *name, const float *v, int n)
         {
-            context_->Uniform3fv(program_, name, v, n);
+            UniformHandle handle = GetUniformHandle(name);
+            if (handle.valid())
+                Uniform3fv(handle, v, n);
+            else
+                context_->Uniform3fv(program_, name, v, n);
         }
         void Shader::Uniform4fv(const char *name, const float *v, int n)
         {
-            context_->Uniform4fv(program_, name, v, n);
+            UniformHandle handle = GetUniformHandle(name);
+            if (handle.valid())
+                Uniform4fv(handle, v, n);
+            else
+                context_->Uniform4fv(program_, name, v, n);
         }
         void Shader::UniformMatrix2fv(const char *name, const float *v, bool trans, int n)
         {
-            context_->UniformMatrix2fv(program_, name, v, trans, n);
+            UniformHandle handle = GetUniformHandle(name);
+            if (handle.valid())
+                UniformMatrix2fv(handle, v, trans, n);
+            else
+                context_->UniformMatrix2fv(program_, name, v, trans, n);
         }
         void Shader::UniformMatrix3fv(const char *name, const float *v, bool trans, int n)
         {
-            context_->UniformMatrix3fv(program_, name, v, trans, n);
+            UniformHandle handle = GetUniformHandle(name);
+            if (handle.valid())
+                UniformMatrix3fv(handle, v, trans, n);
+            else
+                context_->UniformMatrix3fv(program_, name, v, trans, n);
         }
         void Shader::UniformMatrix4fv(const char *name, const float *v, bool trans, int n)
         {
-            context_->UniformMatrix4fv(program_, name, v, trans, n);
+            UniformHandle handle = GetUniformHandle(name);
+            if (handle.valid())
+                UniformMatrix4fv(handle, v, trans, n);
+            else
+                context_->UniformMatrix4fv(program_, name, v, trans, n);
         }
-        Shader * Shader::Create(Context * context, const char *filename, const char **attribs, u32 n_attribs)
+        UniformHandle Shader::GetUniformHandle(const char *name) const
         {
-            Shader * shader = new Shader(context);
-            
-            GLint success;
-            system::FileStream stream;
-            std::string shader_source;
-            std::string shader_filename;
-            
-            u32 vertex_shader, fragment_shader;
-            
-            // Vertex program
-            shader_filename = filename;
-            shader_filename += ".vs";
-            if (stream.Open(shader_filename.c_str(), system::StreamAccess::kReadBinary))
-            {
-                shader_source.resize(stream.Length());
-                if (!stream.Read(&shader_source[0], shader_source.size()))
-                {
-                    context->ErrorHandler("Failed to read from vertex shader file");
-                    delete shader;
-                    return nullptr;
-                }
-                stream.Close();
-                
-                vertex_shader = glCreateShader(GL_VERTEX_SHADER);
-                const char * source = shader_source.c_str();
-                glShaderSource(vertex_shader, 1, &source, NULL);
-                glCompileShader(vertex_shader);
-                glGetShaderiv(vertex_shader, GL_COMPILE_STATUS, &success);
-                if (!success)
-                {
-                    char infoLog[2048];
-                    glGetShaderInfoLog(vertex_shader, 2048, NULL, infoLog);
-                    char temp[100];
-                    sprintf(temp, "%s %s", "Error in vertex shader compilation in", filename);
-                    context->ErrorHandler(temp);
-                    context->ErrorHandler(infoLog);
-                    glDeleteShader(vertex_shader);
-                    delete shader;
-                    return nullptr;
-                }
-                context->CheckForErrors();
-            }
-            else
-            {
-                context->ErrorHandler("Failed to open vertex shader file");
-                delete shader;
-                return nullptr;
-            }
+            UniformHandle handle;
+            const u32 hash = RuntimeStringId(name);
+            auto it = std::lower_bound(uniforms_.begin(), uniforms_.end(), hash,
+                [](const Uniform& uniform, u32 value){ return uniform.hash < value; });
+            if (it != uniforms_.end() && it->hash == hash)
+                handle.index = static_cast<s32>(it - uniforms_.begin());
+            return handle;
+        }
+        void Shader::Uniform1i(UniformHandle handle, int x)
+        {
+            const int values[1] = { x };
+            if (NeedsUpdate(handle, values, sizeof(values)))
+                context_->SetUniform1i(uniforms_[handle.index].location, x);
+        }
+        void Shader::Uniform2i(UniformHandle handle, int x, int y)
+        {
+            const int values[2] = { x, y };
+            if (NeedsUpdate(handle, values, sizeof(values)))
+                context_->SetUniform2i(uniforms_[handle.index].location, x, y);
+        }
+        void Shader::Uniform3i(UniformHandle handle, int x, int y, int z)
+        {
+            const int values[3] = { x, y, z };
+            if (NeedsUpdate(handle, values, sizeof(values)))
+                context_->SetUniform3i(uniforms_[handle.index].location, x, y, z);
+        }
+        void Shader::Uniform4i(UniformHandle handle, int x, int y, int z, int w)
+        {
+            const int values[4] = { x, y, z, w };
+            if (NeedsUpdate(handle, values, sizeof(values)))
+                context_->SetUniform4i(uniforms_[handle.index].location, x, y, z, w);
+        }
+        void Shader::Uniform1f(UniformHandle handle, float x)
+        {
+            const float values[1] = { x };
+            if (NeedsUpdate(handle, values, sizeof(values)))
+                context_->SetUniform1f(uniforms_[handle.index].location, x);
+        }
+        void Shader::Uniform2f(UniformHandle handle, float x, float y)
+        {
+            const float values[2] = { x, y };
+            if (NeedsUpdate(handle, values, sizeof(values)))
+                context_->SetUniform2f(uniforms_[handle.index].location, x, y);
+        }
+        void Shader::Uniform3f(UniformHandle handle, float x, float y, float z)
+        {
+            const float values[3] = { x, y, z };
+            if (NeedsUpdate(handle, values, sizeof(values)))
+                context_->SetUniform3f(uniforms_[handle.index].location, x, y, z);
+        }
+        void Shader::Uniform4f(UniformHandle handle, float x, float y, float z, float w)
+        {
+            const float values[4] = { x, y, z, w };
+            if (NeedsUpdate(handle, values, sizeof(values)))
+                context_->SetUniform4f(uniforms_[handle.index].location, x, y, z, w);
+        }
+        void Shader::Uniform1fv(UniformHandle handle, const float *v, int n)
+        {
+            if (NeedsUpdate(handle, v, sizeof(float) * 1 * n))
+                context_->SetUniform1fv(uniforms_[handle.index].location, v, n);
+        }
+        void Shader::Uniform2fv(UniformHandle handle, const float *v, int n)
+        {
+            if (NeedsUpdate(handle, v, sizeof(float) * 2 * n))
+                context_->SetUniform2fv(uniforms_[handle.index].location, v, n);
+        }
+        void Shader::Uniform3fv(UniformHandle handle, const float *v, int n)
+        {
+            if (NeedsUpdate(handle, v, sizeof(float) * 3 * n))
+                context_->SetUniform3fv(uniforms_[handle.index].location, v, n);
+        }
+        void Shader::Uniform4fv(UniformHandle handle, const float *v, int n)
+        {
+            if (NeedsUpdate(handle, v, sizeof(float) * 4 * n))
+                context_->SetUniform4fv(uniforms_[handle.index].location, v, n);
+        }
+        void Shader::UniformMatrix2fv(UniformHandle handle, const float *v, bool trans, int n)
+        {
+            // Transposed values aren't cached
+            if (trans ? ForgetValue(handle) : NeedsUpdate(handle, v, sizeof(float) * 4 * n))
+                context_->SetUniformMatrix2fv(uniforms_[handle.index].location, v, trans, n);
+        }
+        void Shader::UniformMatrix3fv(UniformHandle handle, const float *v, bool trans, int n)
+        {
+            // Transposed values aren't cached
+            if (trans ? ForgetValue(handle) : NeedsUpdate(handle, v, sizeof(float) * 9 * n))
+                context_->SetUniformMatrix3fv(uniforms_[handle.index].location, v, trans, n);
+        }
+        void Shader::UniformMatrix4fv(UniformHandle handle, const float *v, bool trans, int n)
+        {
+            // Transposed values aren't cached
+            if (trans ? ForgetValue(handle) : NeedsUpdate(handle, v, sizeof(float) * 16 * n))
+                context_->SetUniformMatrix4fv(uniforms_[handle.index].location, v, trans, n);
+        }
+        bool Shader::BindUniformBlock(const char *name, u32 binding)
+        {
+            s32 block_index = context_->GetUniformBlockIndex(program_, name);
+            if (block_index < 0)
+                return false;
+            context_->UniformBlockBinding(program_, static_cast<u32>(block_index), binding);
+            return true;
+        }
+        void Shader::ReflectUniforms()
+        {
+            std::vector<UniformInfo> infos;
+            context_->GetActiveUniforms(program_, &infos);
             
-            // Fragment program
-            shader_filename = filename;
-            shader_filename += ".fs";
-            if (stream.Open(shader_filename.c_str(), system::StreamAccess::kReadBinary))
+            uniforms_.clear();
+            uniforms_.reserve(infos.size());
+            u32 values_size = 0;
+            for (const auto& info : infos)
             {
-                shader_source.resize(stream.Length());
-                if (!stream.Read(&shader_source[0], shader_source.size()))
-                {
-                    context->ErrorHandler("Failed to read from fragment shader file");
-                    delete shader;
-                    return nullptr;
-                }
-                stream.Close();
-                
-                fragment_shader = glCreateShader(GL_FRAGMENT_SHADER);
-                const char * source = shader_source.c_str();
-                glShaderSource(fragment_shader, 1, &source, NULL);
-                glCompileShader(fragment_shader);
-                glGetShaderiv(fragment_shader, GL_COMPILE_STATUS, &success);
-                if (!success)
-                {
-                    char infoLog[2048];
-                    glGetShaderInfoLog(fragment_shader, 2048, NULL, infoLog);
-                    char temp[100];
-                    sprintf(temp, "%s %s", "Error in fragment shader compilation in", filename);
-                    context->ErrorHandler(temp);
-                    context->ErrorHandler(infoLog);
-                    glDeleteShader(fragment_shader);
-                    glDeleteShader(vertex_shader);
-                    delete shader;
-                    return nullptr;
-                }
-                context->CheckForErrors();
+                Uniform uniform;
+                uniform.hash = RuntimeStringId(info.name.c_str());
+                uniform.location = info.location;
+                uniform.size = info.size * info.count;
+                uniform.offset = values_size;
+                uniform.valid_size = 0;
+                values_size += uniform.size;
+                uniforms_.push_back(uniform);
             }
-            else
+            std::sort(uniforms_.begin(), uniforms_.end(), [](const Uniform& a, const Uniform& b){
+                return a.hash < b.hash;
+            });
+            for (size_t i = 1; i < uniforms_.size(); ++i)
+                assert(uniforms_[i - 1].hash != uniforms_[i].hash && "uniform names hash collision");
+            values_.assign(values_size, 0);
+        }
+        bool Shader::ForgetValue(UniformHandle handle)
+        {
+            if (!handle.valid())
             {
-                context->ErrorHandler("Failed to open fragment shader file");
-                delete shader;
-                return nullptr;
+                assert(!"uniform handle is invalid");
+                return false;
             }
-            
-            // Create program object, attach shader, then link
-            shader->program_ = glCreateProgram();
-            glAttachShader(shader->program_, vertex_shader);
-            glAttachShader(shader->program_, fragment_shader);
-            for (u32 i = 0; i < n_attribs; ++i)
+            uniforms_[handle.index].valid_size = 0;
+            return true;
+        }
+        bool Shader::NeedsUpdate(UniformHandle handle, const void *data, u32 size)
+        {
+            if (!handle.valid())
             {
-                if (attribs[i])
-                {
-                    glBindAttribLocation(shader->program_, i, attribs[i]);
-                    context->CheckForErrors();
-                }
+                assert(!"uniform handle is invalid");
+                return false;
             }
-            glLinkProgram(shader->program_);
-            glGetProgramiv(shader->program_, GL_LINK_STATUS, &success);
-            if (!success)
+            Uniform& uniform = uniforms_[handle.index];
+            if (size > uniform.size)
             {
-                char infoLog[2048];
-                glGetProgramInfoLog(shader->program_, 2048, NULL, infoLog);
-                char temp[100];
-                sprintf(temp, "%s %s", "Error in shader linkage in", filename);
-                context->ErrorHandler(temp);
-                context->ErrorHandler(infoLog);
-                glDeleteProgram(shader->program_);
-                glDeleteShader(vertex_shader);
-                glDeleteShader(fragment_shader);
-                delete shader;
-                return nullptr;
+                // Unknown type or too many elements, don't cache
+                uniform.valid_size = 0;
+                return true;
             }
-            context->CheckForErrors();
-            
-            // After linkage these objects may be deleted
-            glDeleteShader(vertex_shader);
-            glDeleteShader(fragment_shader);
-            
-            return shader;
+            u8 * value = &values_[uniform.offset];
+            if (size <= uniform.valid_size && memcmp(value, data, size) == 0)
+                return false;
+            memcpy(value, data, size);
+            uniform.valid_size = std::max(uniform.valid_size, size);
+            return true;
         }
         
     } // namespace graphics
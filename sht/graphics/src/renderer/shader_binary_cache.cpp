@@ -0,0 +1,81 @@
+#include "../../include/renderer/shader_binary_cache.h"
+#include "../../../system/include/stream/file_stream.h"
+
+#include <cstdio>
+
+namespace {
+
+    const u32 kMagic = 0x43424853; // "SHBC"
+    const u32 kVersion = 1;
+
+    struct FileHeader {
+        u32 magic;
+        u32 version;
+        u64 key;        //!< protects from renamed files
+        u32 format;     //!< driver binary format
+        u32 size;
+    };
+
+} // namespace
+
+namespace sht {
+    namespace graphics {
+
+        ShaderBinaryCache::ShaderBinaryCache(const char *directory)
+        : directory_(directory)
+        {
+        }
+        bool ShaderBinaryCache::Load(u64 key, u32 * format, std::vector<u8> * binary) const
+        {
+            system::FileStream stream;
+            if (!stream.Open(GetFilename(key).c_str(), system::StreamAccess::kReadBinary))
+                return false;
+            FileHeader header;
+            bool result = stream.Length() >= sizeof(header) && stream.Read(&header, sizeof(header)) &&
+                header.magic == kMagic && header.version == kVersion && header.key == key && header.size != 0 &&
+                stream.Length() == sizeof(header) + header.size;
+            if (result)
+            {
+                binary->resize(header.size);
+                result = stream.Read(&(*binary)[0], header.size);
+                *format = header.format;
+            }
+            stream.Close();
+            return result;
+        }
+        bool ShaderBinaryCache::Store(u64 key, u32 format, const std::vector<u8>& binary) const
+        {
+            if (binary.empty())
+                return false;
+            system::FileStream stream;
+            if (!stream.Open(GetFilename(key).c_str(), system::StreamAccess::kWriteBinary))
+                return false;
+            FileHeader header;
+            header.magic = kMagic;
+            header.version = kVersion;
+            header.key = key;
+            header.format = format;
+            header.size = static_cast<u32>(binary.size());
+            bool result = stream.Write(&header, sizeof(header)) && stream.Write(&binary[0], binary.size());
+            stream.Close();
+            if (!result)
+                Remove(key);
+            return result;
+        }
+        void ShaderBinaryCache::Remove(u64 key) const
+        {
+            std::remove(GetFilename(key).c_str());
+        }
+        std::string ShaderBinaryCache::GetFilename(u64 key) const
+        {
+            char name[32];
+            sprintf(name, "%08x%08x.bin", static_cast<u32>(key >> 32), static_cast<u32>(key));
+            return directory_.empty() ? std::string(name) : directory_ + "/" + name;
+        }
+        const std::string& ShaderBinaryCache::directory() const
+        {
+            return directory_;
+        }
+
+    } // namespace graphics
+} // namespace sht
@@ -0,0 +1,293 @@
+#include "../../include/renderer/shader_manager.h"
+#include "opengl/opengl_include.h"
+#include "../../../system/include/filesystem/directory.h"
+
+#include <cstring>
+
+// KHR_parallel_shader_compile isn't declared by all headers
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+namespace sht {
+    namespace graphics {
+
+        ShaderManager::ShaderManager(Context * context)
+        : context_(context)
+        , cache_(nullptr)
+        , driver_queried_(false)
+        , parallel_compile_(false)
+        , binaries_supported_(false)
+        {
+            memset(&stats_, 0, sizeof(stats_));
+        }
+        ShaderManager::~ShaderManager()
+        {
+            for (auto& job : jobs_)
+                DeleteObjects(job);
+            delete cache_;
+        }
+        void ShaderManager::set_cache_directory(const char *directory)
+        {
+            delete cache_;
+            cache_ = nullptr;
+            if (directory[0] != '\0')
+            {
+                system::CreateDirectory(directory);
+                cache_ = new ShaderBinaryCache(directory);
+            }
+        }
+        void ShaderManager::Add(Shader* &shader, const char *filename, const char **attribs, u32 n_attribs)
+        {
+            shader = nullptr;
+            Job job;
+            job.shader = &shader;
+            job.filename = filename;
+            for (u32 i = 0; i < n_attribs; ++i)
+                job.attribs.push_back(attribs[i] ? attribs[i] : "");
+            job.key = 0;
+            job.vertex_shader = 0;
+            job.fragment_shader = 0;
+            job.program = 0;
+            job.issued = false;
+            job.failed = false;
+            job.from_cache = false;
+            jobs_.push_back(job);
+        }
+        void ShaderManager::Compile()
+        {
+            QueryDriver();
+
+            // Compiles go first, so the driver has all of them before we wait for any
+            std::vector<Job*> to_link;
+            for (auto& job : jobs_)
+            {
+                if (job.issued)
+                    continue;
+                job.issued = true;
+                if (!Prepare(job) || job.from_cache)
+                    continue;
+                IssueCompile(job);
+                to_link.push_back(&job);
+            }
+            for (auto job : to_link)
+                IssueLink(*job);
+        }
+        bool ShaderManager::IsReady()
+        {
+            QueryDriver();
+            if (!parallel_compile_)
+                return true;
+            for (auto& job : jobs_)
+            {
+                if (!job.issued)
+                    return false;
+                if (job.program == 0)
+                    continue;
+                GLint completed = GL_FALSE;
+                glGetProgramiv(job.program, GL_COMPLETION_STATUS_KHR, &completed);
+                if (completed == GL_FALSE)
+                    return false;
+            }
+            return true;
+        }
+        bool ShaderManager::Finish(std::vector<Shader*> * shaders)
+        {
+            Compile();
+            bool result = true;
+            for (auto& job : jobs_)
+            {
+                ++stats_.num_programs;
+                if (job.failed || !CheckStatus(job))
+                {
+                    ++stats_.num_failed;
+                    DeleteObjects(job);
+                    result = false;
+                    continue;
+                }
+                if (job.from_cache)
+                    ++stats_.num_cache_hits;
+                else
+                    ++stats_.num_compiled;
+
+                // After linkage shader objects may be deleted
+                if (job.vertex_shader)
+                    glDeleteShader(job.vertex_shader);
+                if (job.fragment_shader)
+                    glDeleteShader(job.fragment_shader);
+
+                if (cache_ && binaries_supported_ && !job.from_cache)
+                {
+                    GLint length = 0;
+                    glGetProgramiv(job.program, GL_PROGRAM_BINARY_LENGTH, &length);
+                    if (length > 0)
+                    {
+                        std::vector<u8> binary(length);
+                        GLenum format = 0;
+                        glGetProgramBinary(job.program, length, nullptr, &format, &binary[0]);
+                        cache_->Store(job.key, format, binary);
+                    }
+                }
+
+                Shader * shader = new Shader(context_);
+                shader->program_ = job.program;
+                shader->ReflectUniforms();
+                *job.shader = shader;
+                shaders->push_back(shader);
+            }
+            jobs_.clear();
+            context_->CheckForErrors();
+            return result;
+        }
+        ShaderPreprocessor * ShaderManager::preprocessor()
+        {
+            return &preprocessor_;
+        }
+        bool ShaderManager::parallel_compile_supported()
+        {
+            QueryDriver();
+            return parallel_compile_;
+        }
+        u32 ShaderManager::num_pending() const
+        {
+            return static_cast<u32>(jobs_.size());
+        }
+        const ShaderManager::Stats& ShaderManager::stats() const
+        {
+            return stats_;
+        }
+        void ShaderManager::QueryDriver()
+        {
+            if (driver_queried_)
+                return;
+            driver_queried_ = true;
+
+            const char * strings[3] = {
+                reinterpret_cast<const char*>(glGetString(GL_VENDOR)),
+                reinterpret_cast<const char*>(glGetString(GL_RENDERER)),
+                reinterpret_cast<const char*>(glGetString(GL_VERSION))
+            };
+            for (auto str : strings)
+            {
+                if (str)
+                    driver_ += str;
+                driver_ += '\n';
+            }
+
+            GLint num_formats = 0;
+            glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &num_formats);
+            binaries_supported_ = num_formats > 0;
+
+            GLint num_extensions = 0;
+            glGetIntegerv(GL_NUM_EXTENSIONS, &num_extensions);
+            for (GLint i = 0; i < num_extensions; ++i)
+            {
+                const char * name = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+                if (name && (strcmp(name, "GL_KHR_parallel_shader_compile") == 0 ||
+                             strcmp(name, "GL_ARB_parallel_shader_compile") == 0))
+                {
+                    parallel_compile_ = true;
+                    break;
+                }
+            }
+        }
+        bool ShaderManager::Prepare(Job& job)
+        {
+            if (!preprocessor_.Process((job.filename + ".vs").c_str(), &job.vertex_source) ||
+                !preprocessor_.Process((job.filename + ".fs").c_str(), &job.fragment_source))
+            {
+                context_->ErrorHandler(preprocessor_.error().c_str());
+                job.failed = true;
+                return false;
+            }
+            job.key = ShaderPreprocessor::ComputeKey(job.vertex_source, job.fragment_source, job.attribs, driver_);
+
+            u32 format;
+            std::vector<u8> binary;
+            if (cache_ && binaries_supported_ && cache_->Load(job.key, &format, &binary))
+            {
+                job.program = glCreateProgram();
+                glProgramBinary(job.program, format, &binary[0], static_cast<GLsizei>(binary.size()));
+                job.from_cache = true;
+            }
+            return true;
+        }
+        void ShaderManager::IssueCompile(Job& job)
+        {
+            const char * source = job.vertex_source.c_str();
+            job.vertex_shader = glCreateShader(GL_VERTEX_SHADER);
+            glShaderSource(job.vertex_shader, 1, &source, NULL);
+            glCompileShader(job.vertex_shader);
+
+            source = job.fragment_source.c_str();
+            job.fragment_shader = glCreateShader(GL_FRAGMENT_SHADER);
+            glShaderSource(job.fragment_shader, 1, &source, NULL);
+            glCompileShader(job.fragment_shader);
+        }
+        void ShaderManager::IssueLink(Job& job)
+        {
+            job.program = glCreateProgram();
+            glAttachShader(job.program, job.vertex_shader);
+            glAttachShader(job.program, job.fragment_shader);
+            for (size_t i = 0; i < job.attribs.size(); ++i)
+            {
+                if (!job.attribs[i].empty())
+                    glBindAttribLocation(job.program, static_cast<GLuint>(i), job.attribs[i].c_str());
+            }
+            if (cache_ && binaries_supported_)
+                glProgramParameteri(job.program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+            glLinkProgram(job.program);
+        }
+        bool ShaderManager::CheckStatus(Job& job)
+        {
+            GLint success;
+            glGetProgramiv(job.program, GL_LINK_STATUS, &success);
+            if (!success && job.from_cache)
+            {
+                // Binary has been rejected by driver, it's replaced after compilation from sources
+                cache_->Remove(job.key);
+                glDeleteProgram(job.program);
+                job.from_cache = false;
+                IssueCompile(job);
+                IssueLink(job);
+                glGetProgramiv(job.program, GL_LINK_STATUS, &success);
+            }
+            if (success)
+                return true;
+
+            char info_log[2048];
+            const u32 stages[2] = { job.vertex_shader, job.fragment_shader };
+            const char * stage_names[2] = { "vertex", "fragment" };
+            for (int i = 0; i < 2; ++i)
+            {
+                glGetShaderiv(stages[i], GL_COMPILE_STATUS, &success);
+                if (!success)
+                {
+                    glGetShaderInfoLog(stages[i], sizeof(info_log), NULL, info_log);
+                    std::string message = std::string("Error in ") + stage_names[i] + " shader compilation in " + job.filename;
+                    context_->ErrorHandler(message.c_str());
+                    context_->ErrorHandler(info_log);
+                    return false;
+                }
+            }
+            glGetProgramInfoLog(job.program, sizeof(info_log), NULL, info_log);
+            std::string message = "Error in shader linkage in " + job.filename;
+            context_->ErrorHandler(message.c_str());
+            context_->ErrorHandler(info_log);
+            return false;
+        }
+        void ShaderManager::DeleteObjects(Job& job)
+        {
+            if (job.program)
+                glDeleteProgram(job.program);
+            if (job.vertex_shader)
+                glDeleteShader(job.vertex_shader);
+            if (job.fragment_shader)
+                glDeleteShader(job.fragment_shader);
+            job.program = 0;
+            job.vertex_shader = 0;
+            job.fragment_shader = 0;
+        }
+
+    } // namespace graphics
+} // namespace sht
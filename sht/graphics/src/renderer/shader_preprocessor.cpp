@@ -0,0 +1,193 @@
+#include "../../include/renderer/shader_preprocessor.h"
+#include "../../../system/include/stream/file_stream.h"
+#include "../../../system/include/string/filename.h"
+
+#include <cstring>
+
+namespace {
+
+    bool LoadFile(const char *filename, std::string * source)
+    {
+        sht::system::FileStream stream;
+        if (!stream.Open(filename, sht::system::StreamAccess::kReadBinary))
+            return false;
+        source->resize(stream.Length());
+        bool result = source->empty() || stream.Read(&(*source)[0], source->size());
+        stream.Close();
+        return result;
+    }
+
+    //! Collapses "dir/.." and "." parts, so the same file is always known under the same name
+    std::string NormalizePath(const std::string& path)
+    {
+        std::vector<std::string> parts;
+        size_t start = 0;
+        while (start <= path.size())
+        {
+            size_t end = path.find_first_of("/\\", start);
+            if (end == std::string::npos)
+                end = path.size();
+            std::string part = path.substr(start, end - start);
+            if (part == "..")
+            {
+                if (!parts.empty() && parts.back() != "..")
+                    parts.pop_back();
+                else
+                    parts.push_back(part);
+            }
+            else if (!part.empty() && part != ".")
+                parts.push_back(part);
+            start = end + 1;
+        }
+        std::string result = (!path.empty() && path[0] == '/') ? "/" : "";
+        for (size_t i = 0; i < parts.size(); ++i)
+        {
+            if (i > 0)
+                result += '/';
+            result += parts[i];
+        }
+        return result;
+    }
+
+    //! Returns true if line is #include directive and extracts file name
+    bool ParseInclude(const char *line, const char *end, std::string * name)
+    {
+        while (line != end && (*line == ' ' || *line == '\t'))
+            ++line;
+        if (line == end || *line != '#')
+            return false;
+        ++line;
+        while (line != end && (*line == ' ' || *line == '\t'))
+            ++line;
+        const size_t kDirectiveLength = 7;
+        if (static_cast<size_t>(end - line) < kDirectiveLength || strncmp(line, "include", kDirectiveLength) != 0)
+            return false;
+        line += kDirectiveLength;
+        while (line != end && (*line == ' ' || *line == '\t'))
+            ++line;
+        if (line == end || *line != '"')
+            return false;
+        const char *name_end = static_cast<const char*>(memchr(line + 1, '"', end - line - 1));
+        if (name_end == nullptr)
+            return false;
+        name->assign(line + 1, name_end);
+        return true;
+    }
+
+    // 64-bit FNV-1a
+    const u64 kHashOffset = 14695981039346656037ULL;
+    const u64 kHashPrime = 1099511628211ULL;
+
+    u64 HashBytes(u64 hash, const void *data, size_t size)
+    {
+        const u8 *bytes = static_cast<const u8*>(data);
+        for (size_t i = 0; i < size; ++i)
+        {
+            hash ^= bytes[i];
+            hash *= kHashPrime;
+        }
+        return hash;
+    }
+    u64 HashString(u64 hash, const std::string& str)
+    {
+        // Terminating zero separates strings, so ("ab", "c") and ("a", "bc") give different keys
+        return HashBytes(hash, str.c_str(), str.size() + 1);
+    }
+
+} // namespace
+
+namespace sht {
+    namespace graphics {
+
+        ShaderPreprocessor::ShaderPreprocessor()
+        : load_(LoadFile)
+        , num_loads_(0)
+        {
+        }
+        ShaderPreprocessor::ShaderPreprocessor(const LoadFunction& load)
+        : load_(load)
+        , num_loads_(0)
+        {
+        }
+        bool ShaderPreprocessor::Process(const char *filename, std::string * source)
+        {
+            std::set<std::string> included;
+            source->clear();
+            error_.clear();
+            return ProcessFile(NormalizePath(filename), &included, source);
+        }
+        void ShaderPreprocessor::ClearCache()
+        {
+            cache_.clear();
+        }
+        u32 ShaderPreprocessor::num_cached_files() const
+        {
+            return static_cast<u32>(cache_.size());
+        }
+        u32 ShaderPreprocessor::num_loads() const
+        {
+            return num_loads_;
+        }
+        const std::string& ShaderPreprocessor::error() const
+        {
+            return error_;
+        }
+        u64 ShaderPreprocessor::ComputeKey(const std::string& vertex_source, const std::string& fragment_source,
+            const std::vector<std::string>& attribs, const std::string& driver)
+        {
+            u64 hash = kHashOffset;
+            hash = HashString(hash, driver);
+            hash = HashString(hash, vertex_source);
+            hash = HashString(hash, fragment_source);
+            for (const auto& attrib : attribs)
+                hash = HashString(hash, attrib);
+            return hash;
+        }
+        bool ShaderPreprocessor::ProcessFile(const std::string& filename, std::set<std::string> * included,
+            std::string * output)
+        {
+            if (!included->insert(filename).second)
+                return true;
+            const std::string * source = Load(filename);
+            if (source == nullptr)
+            {
+                error_ = "Failed to load shader source " + filename;
+                return false;
+            }
+            const std::string directory = system::Filename(filename.c_str()).ExtractPath();
+            std::string name;
+            size_t start = 0;
+            while (start < source->size())
+            {
+                size_t end = source->find('\n', start);
+                end = (end == std::string::npos) ? source->size() : end + 1;
+                const char *line = source->c_str() + start;
+                if (ParseInclude(line, line + (end - start), &name))
+                {
+                    const std::string path = NormalizePath(directory.empty() ? name : directory + "/" + name);
+                    if (!ProcessFile(path, included, output))
+                        return false;
+                    // Included file may lack the last line break
+                    if (!output->empty() && output->back() != '\n')
+                        *output += '\n';
+                }
+                else
+                    output->append(line, end - start);
+                start = end;
+            }
+            return true;
+        }
+        const std::string * ShaderPreprocessor::Load(const std::string& filename)
+        {
+            auto it = cache_.find(filename);
+            if (it != cache_.end())
+                return &it->second;
+            ++num_loads_;
+            std::string source;
+            if (!load_ || !load_(filename.c_str(), &source))
+                return nullptr;
+            return &(cache_[filename] = source);
+        }
+
+    } // namespace graphics
+} // namespace sht
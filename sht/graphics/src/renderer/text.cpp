@@ -1,6 +1,7 @@
 #include "../../include/renderer/text.h"
 #include <cstdarg>
 #include <cwchar>
+#include <cstring>
 
 #ifdef TARGET_MAC
 #define my_vswprintf vswprintf
@@ -159,12 +160,9 @@ namespace sht {
             renderer_->context()->BindVertexArrayObject(vertex_array_object_);
             renderer_->context()->CheckForErrors();
             
-            AllocateVertexBuffer();
+            bool allocated = AllocateVertexBuffer();
             renderer_->context()->CheckForErrors();
-            if (vertex_buffer_ == nullptr) return false;
-            
-            // Free all data in memory
-            FreeArrays();
+            if (!allocated) return false;
             
             // There is only one attribute
             const char* base = (char*)0;
@@ -283,9 +281,14 @@ namespace sht {
                 return nullptr;
             }
         }
-        void StaticText::AllocateVertexBuffer()
+        bool StaticText::AllocateVertexBuffer()
         {
             renderer_->AddVertexBuffer(vertex_buffer_, num_vertices_ * vertex_format_->vertex_size(), vertices_array_, BufferUsage::kStaticDraw);
+            
+            // Free all data in memory
+            FreeArrays();
+            
+            return vertex_buffer_ != nullptr;
         }
         void StaticText::AllocateBuffer()
         {
@@ -305,6 +308,9 @@ namespace sht {
         }
         DynamicText::DynamicText(Renderer * renderer, u32 buffer_size)
         : Text(renderer, buffer_size)
+        , dirty_(true)
+        , upload_frame_(0xFFFFFFFF)
+        , first_vertex_(0)
         {
             num_vertices_ = static_cast<u32>(GetVerticesPerPrimitive() * text_buffer_size_);
         }
@@ -355,35 +361,52 @@ namespace sht {
             wcsncpy(text_buffer_, str, text_buffer_size_);
             return SetTextInternal(font, x, y, scale);
         }
-        void DynamicText::AllocateVertexBuffer()
+        void DynamicText::Render()
+        {
+            if (num_vertices_ == 0)
+                return;
+            
+            // Ring buffer keeps data for one frame only
+            RingBuffer * ring_buffer = renderer_->ring_buffer();
+            if (dirty_ || upload_frame_ != ring_buffer->frame())
+            {
+                const u32 vertex_size = vertex_format_->vertex_size();
+                RingAllocation allocation = ring_buffer->Map(num_vertices_ * vertex_size, vertex_size);
+                if (allocation.pointer == nullptr)
+                    return;
+                memcpy(allocation.pointer, vertices_array_, num_vertices_ * vertex_size);
+                ring_buffer->Unmap();
+                first_vertex_ = allocation.offset / vertex_size;
+                upload_frame_ = ring_buffer->frame();
+                dirty_ = false;
+            }
+            
+            renderer_->ChangeTexture(font_->texture());
+            renderer_->context()->BindVertexArrayObject(vertex_array_object_);
+            renderer_->context()->DrawArrays(PrimitiveType::kTriangles, first_vertex_, num_vertices_);
+            renderer_->context()->BindVertexArrayObject(0);
+        }
+        bool DynamicText::AllocateVertexBuffer()
         {
-            renderer_->AddVertexBuffer(vertex_buffer_, num_vertices_ * vertex_format_->vertex_size(), nullptr, BufferUsage::kDynamicDraw);
+            // Vertices are kept in memory, attributes point to the shared ring buffer
+            vertices_array_ = new u8[num_vertices_ * vertex_format_->vertex_size()];
+            num_vertices_ = 0;
+            renderer_->ring_buffer()->Bind();
+            return true;
         }
         void DynamicText::AllocateBuffer()
         {
-            assert(vertex_buffer_);
+            assert(vertices_array_);
             size_t text_length = wcslen(text_buffer_);
             num_vertices_ = static_cast<u32>(GetVerticesPerPrimitive() * text_length);
         }
         void* DynamicText::LockBuffer()
         {
-            if (vertex_buffer_)
-            {
-                renderer_->context()->BindVertexArrayObject(0);
-                vertex_buffer_->Bind();
-                return vertex_buffer_->Lock(DataAccessType::kWrite);
-            }
-            else
-                return vertices_array_;
+            return vertices_array_;
         }
         void DynamicText::UnlockBuffer()
         {
-            if (vertex_buffer_)
-            {
-                vertex_buffer_->Unlock();
-                renderer_->context()->CheckForErrors();
-                vertex_buffer_->Unbind();
-            }
+            dirty_ = true;
         }
         
     } // namespace graphics
@@ -0,0 +1,143 @@
+#include "../../include/renderer/texture_upload_queue.h"
+#include "../../include/renderer/context.h"
+
+#include <algorithm>
+
+namespace sht {
+	namespace graphics {
+
+		TextureUploadQueue::TextureUploadQueue(Context * context, const CreateFunction& create_function)
+		: context_(context)
+		, create_function_(create_function)
+		, slice_size_(1 << 20)
+		{
+		}
+		TextureUploadQueue::~TextureUploadQueue()
+		{
+			Clear();
+			for (auto image : images_)
+				delete image;
+		}
+		Image * TextureUploadQueue::AcquireStagingImage()
+		{
+			std::lock_guard<std::mutex> guard(mutex_);
+			if (!free_images_.empty())
+			{
+				Image * image = free_images_.back();
+				free_images_.pop_back();
+				return image;
+			}
+			Image * image = new Image();
+			images_.push_back(image);
+			return image;
+		}
+		void TextureUploadQueue::ReleaseStagingImage(Image * image)
+		{
+			std::lock_guard<std::mutex> guard(mutex_);
+			free_images_.push_back(image);
+		}
+		void TextureUploadQueue::Enqueue(Image * image, Texture::Wrap wrap, Texture::Filter filt, const ReadyCallback& callback)
+		{
+			Job job;
+			job.image = image;
+			job.texture = nullptr;
+			job.wrap = wrap;
+			job.filter = filt;
+			job.callback = callback;
+			job.next_row = 0;
+
+			std::lock_guard<std::mutex> guard(mutex_);
+			incoming_jobs_.push_back(job);
+		}
+		void TextureUploadQueue::Process(f32 budget_seconds)
+		{
+			{//---
+				std::lock_guard<std::mutex> guard(mutex_);
+				jobs_.splice(jobs_.end(), incoming_jobs_);
+			}//---
+
+			clock_.MakeStartPoint();
+			bool first_slice = true;
+			while (!jobs_.empty())
+			{
+				if (!first_slice && clock_.GetTime() >= budget_seconds)
+					break;
+				first_slice = false;
+
+				Job& job = jobs_.front();
+				if (job.image == nullptr)
+				{
+					// Loading has failed
+					if (job.callback)
+						job.callback(nullptr);
+					jobs_.pop_front();
+					continue;
+				}
+				if (job.texture == nullptr)
+				{
+					// Texture storage creation counts as a slice
+					job.texture = create_function_(job.image->width(), job.image->height(),
+						job.image->format(), job.wrap, job.filter);
+					if (job.texture == nullptr)
+					{
+						ReleaseStagingImage(job.image);
+						if (job.callback)
+							job.callback(nullptr);
+						jobs_.pop_front();
+					}
+					continue;
+				}
+				UploadSlice(job);
+				if (job.next_row >= job.image->height())
+				{
+					context_->GenerateMipmap(job.texture->target_);
+					ReleaseStagingImage(job.image);
+					if (job.callback)
+						job.callback(job.texture);
+					jobs_.pop_front();
+				}
+			}
+		}
+		void TextureUploadQueue::Clear()
+		{
+			{//---
+				std::lock_guard<std::mutex> guard(mutex_);
+				jobs_.splice(jobs_.end(), incoming_jobs_);
+			}//---
+			for (auto& job : jobs_)
+				if (job.image)
+					ReleaseStagingImage(job.image);
+			jobs_.clear();
+		}
+		void TextureUploadQueue::set_slice_size(u32 bytes)
+		{
+			slice_size_ = bytes;
+		}
+		u32 TextureUploadQueue::num_pending()
+		{
+			std::lock_guard<std::mutex> guard(mutex_);
+			return static_cast<u32>(jobs_.size() + incoming_jobs_.size());
+		}
+		u32 TextureUploadQueue::num_staging_images()
+		{
+			std::lock_guard<std::mutex> guard(mutex_);
+			return static_cast<u32>(images_.size());
+		}
+		void TextureUploadQueue::UploadSlice(Job& job)
+		{
+			Image * image = job.image;
+			Texture * texture = job.texture;
+			const u32 row_size = static_cast<u32>(image->width() * image->bpp());
+			const int rows_per_slice = std::max(1, static_cast<int>(slice_size_ / std::max(row_size, 1U)));
+			const int num_rows = std::min(rows_per_slice, image->height() - job.next_row);
+
+			// Memory row order matches the one used by texture creation from image
+			context_->BindTexture(texture->target_, texture->texture_id_);
+			context_->TextureSubImage2D(texture->target_, 0, 0, job.next_row, image->width(), num_rows,
+				texture->GetSrcFormat(), texture->GetSrcType(),
+				image->pixels() + static_cast<size_t>(job.next_row) * row_size);
+			job.next_row += num_rows;
+		}
+
+	} // namespace graphics
+} // namespace sht
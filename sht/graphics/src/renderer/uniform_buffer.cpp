@@ -0,0 +1,78 @@
+#include "../../include/renderer/uniform_buffer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <assert.h>
+
+namespace sht {
+    namespace graphics {
+        
+        UniformBuffer::UniformBuffer(Context * context, u32 size)
+        : context_(context)
+        , shadow_(size, 0)
+        , dirty_begin_(0)
+        , dirty_end_(0)
+        {
+            context_->GenUniformBuffer(id_);
+            context_->BindUniformBuffer(id_);
+            context_->UniformBufferData(size, shadow_.empty() ? nullptr : &shadow_[0], BufferUsage::kDynamicDraw);
+        }
+        UniformBuffer::~UniformBuffer()
+        {
+            context_->DeleteUniformBuffer(id_);
+        }
+        void UniformBuffer::SetData(u32 offset, u32 size, const void *data)
+        {
+            assert(offset + size <= shadow_.size());
+            u8 * dst = &shadow_[offset];
+            const u8 * src = reinterpret_cast<const u8*>(data);
+            
+            // Narrow range down to the changed bytes
+            u32 begin = 0;
+            while (begin < size && dst[begin] == src[begin])
+                ++begin;
+            if (begin == size)
+                return;
+            u32 end = size;
+            while (dst[end - 1] == src[end - 1])
+                --end;
+            memcpy(dst + begin, src + begin, end - begin);
+            
+            // Keep range aligned to 4 byte words
+            begin = (offset + begin) & ~3U;
+            end = std::min((offset + end + 3U) & ~3U, static_cast<u32>(shadow_.size()));
+            if (dirty_begin_ == dirty_end_)
+            {
+                dirty_begin_ = begin;
+                dirty_end_ = end;
+            }
+            else
+            {
+                dirty_begin_ = std::min(dirty_begin_, begin);
+                dirty_end_ = std::max(dirty_end_, end);
+            }
+        }
+        void UniformBuffer::Flush()
+        {
+            if (dirty_begin_ == dirty_end_)
+                return;
+            context_->BindUniformBuffer(id_);
+            context_->UniformBufferSubData(dirty_begin_, dirty_end_ - dirty_begin_, &shadow_[dirty_begin_]);
+            dirty_begin_ = dirty_end_ = 0;
+        }
+        void UniformBuffer::Bind(u32 binding)
+        {
+            Flush();
+            context_->BindUniformBufferBase(binding, id_);
+        }
+        u32 UniformBuffer::size() const
+        {
+            return static_cast<u32>(shadow_.size());
+        }
+        const u8 * UniformBuffer::data() const
+        {
+            return shadow_.empty() ? nullptr : &shadow_[0];
+        }
+        
+    } // namespace graphics
+} // namespace sht
@@ -30,7 +30,7 @@ namespace sht {
         }
         void VertexBuffer::SubData(u32 size, const void *data)
         {
-            context_->VertexBufferSubData(size, data);
+            context_->VertexBufferSubData(0, size, data);
         }
         void* VertexBuffer::Lock(DataAccessType access)
         {
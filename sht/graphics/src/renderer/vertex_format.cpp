@@ -1,4 +1,5 @@
 #include "../../include/renderer/vertex_format.h"
+#include "../../include/renderer/vertex_packing.h"
 #include <cstring>
 #include <assert.h>
 
@@ -50,15 +51,16 @@ namespace sht {
                 case VertexAttribute::kTexcoord:
 				case VertexAttribute::kNormal:
 				case VertexAttribute::kColor:
-					generic_[i].size = attribs[i].size;
+					generic_[i].size = GetStoredComponents(attribs[i].format, attribs[i].size);
 					generic_[i].offset = vertex_size_;
+					generic_[i].format = attribs[i].format;
 					++max_generic_;
 					break;
 				default:
 					assert(!"Unkown vertex attribute");
 				}
 
-				vertex_size_ += attribs[i].size * sizeof(float);
+				vertex_size_ += GetAttributeSize(attribs[i].format, attribs[i].size);
 			}
 		}
 
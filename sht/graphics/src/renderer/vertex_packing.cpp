@@ -0,0 +1,310 @@
+#include "../../include/renderer/vertex_packing.h"
+
+#include <algorithm>
+#include <assert.h>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+    float Clamp(float value, float min_value, float max_value)
+    {
+        return (value < min_value) ? min_value : ((value > max_value) ? max_value : value);
+    }
+    int Round(float value)
+    {
+        return static_cast<int>(floorf(value + 0.5f));
+    }
+    //! Sign that treats zero as positive, so folded vectors never collapse
+    float SignNotZero(float value)
+    {
+        return (value >= 0.0f) ? 1.0f : -1.0f;
+    }
+    s16 PackSnorm16(float value)
+    {
+        return static_cast<s16>(Round(Clamp(value, -1.0f, 1.0f) * 32767.0f));
+    }
+    float UnpackSnorm16(s16 value)
+    {
+        // Both -32768 and -32767 map to -1
+        return std::max(static_cast<float>(value) / 32767.0f, -1.0f);
+    }
+
+} // namespace
+
+namespace sht {
+    namespace graphics {
+        
+        u32 GetStoredComponents(VertexAttribute::Format format, u32 size)
+        {
+            switch (format)
+            {
+            case VertexAttribute::kSnorm10:
+                assert(size <= 3);
+                return 4;
+            case VertexAttribute::kOctahedral16:
+                assert(size == 3);
+                return 2;
+            default:
+                return size;
+            }
+        }
+        u32 GetAttributeSize(VertexAttribute::Format format, u32 size)
+        {
+            u32 bytes;
+            switch (format)
+            {
+            case VertexAttribute::kFloat:
+                bytes = size * sizeof(f32);
+                break;
+            case VertexAttribute::kHalf:
+            case VertexAttribute::kSnorm16:
+            case VertexAttribute::kUnorm16:
+                bytes = size * sizeof(u16);
+                break;
+            case VertexAttribute::kSnorm8:
+            case VertexAttribute::kUnorm8:
+                bytes = size;
+                break;
+            case VertexAttribute::kSnorm10:
+            case VertexAttribute::kOctahedral16:
+                bytes = 4;
+                break;
+            default:
+                assert(!"Unknown vertex attribute format");
+                bytes = size * sizeof(f32);
+            }
+            return (bytes + 3) & ~3u;
+        }
+        DataType GetAttributeDataType(VertexAttribute::Format format)
+        {
+            switch (format)
+            {
+            case VertexAttribute::kHalf:            return DataType::kHalfFloat;
+            case VertexAttribute::kSnorm16:         return DataType::kShort;
+            case VertexAttribute::kUnorm16:         return DataType::kUnsignedShort;
+            case VertexAttribute::kSnorm8:          return DataType::kByte;
+            case VertexAttribute::kUnorm8:          return DataType::kUnsignedByte;
+            case VertexAttribute::kSnorm10:         return DataType::kInt2101010Rev;
+            case VertexAttribute::kOctahedral16:    return DataType::kShort;
+            default:                                return DataType::kFloat;
+            }
+        }
+        bool IsAttributeNormalized(VertexAttribute::Format format)
+        {
+            return format != VertexAttribute::kFloat && format != VertexAttribute::kHalf;
+        }
+        void PackAttribute(VertexAttribute::Format format, const f32 * values, u32 size, u8 * data)
+        {
+            memset(data, 0, GetAttributeSize(format, size));
+            switch (format)
+            {
+            case VertexAttribute::kFloat:
+                memcpy(data, values, size * sizeof(f32));
+                break;
+            case VertexAttribute::kHalf:
+                for (u32 i = 0; i < size; ++i)
+                {
+                    u16 value = FloatToHalf(values[i]);
+                    memcpy(data + i * sizeof(u16), &value, sizeof(u16));
+                }
+                break;
+            case VertexAttribute::kSnorm16:
+                for (u32 i = 0; i < size; ++i)
+                {
+                    s16 value = PackSnorm16(values[i]);
+                    memcpy(data + i * sizeof(s16), &value, sizeof(s16));
+                }
+                break;
+            case VertexAttribute::kUnorm16:
+                for (u32 i = 0; i < size; ++i)
+                {
+                    u16 value = static_cast<u16>(Round(Clamp(values[i], 0.0f, 1.0f) * 65535.0f));
+                    memcpy(data + i * sizeof(u16), &value, sizeof(u16));
+                }
+                break;
+            case VertexAttribute::kSnorm8:
+                for (u32 i = 0; i < size; ++i)
+                    data[i] = static_cast<u8>(static_cast<s8>(Round(Clamp(values[i], -1.0f, 1.0f) * 127.0f)));
+                break;
+            case VertexAttribute::kUnorm8:
+                for (u32 i = 0; i < size; ++i)
+                    data[i] = static_cast<u8>(Round(Clamp(values[i], 0.0f, 1.0f) * 255.0f));
+                break;
+            case VertexAttribute::kSnorm10:
+                {
+                    u32 packed = 0;
+                    for (u32 i = 0; i < size; ++i)
+                    {
+                        const int value = Round(Clamp(values[i], -1.0f, 1.0f) * 511.0f);
+                        packed |= (static_cast<u32>(value) & 0x3ff) << (10 * i);
+                    }
+                    memcpy(data, &packed, sizeof(packed));
+                }
+                break;
+            case VertexAttribute::kOctahedral16:
+                {
+                    f32 x, y;
+                    EncodeOctahedral(values, &x, &y);
+                    s16 packed[2] = { PackSnorm16(x), PackSnorm16(y) };
+                    memcpy(data, packed, sizeof(packed));
+                }
+                break;
+            default:
+                assert(!"Unknown vertex attribute format");
+            }
+        }
+        void UnpackAttribute(VertexAttribute::Format format, const u8 * data, u32 size, f32 * values)
+        {
+            switch (format)
+            {
+            case VertexAttribute::kFloat:
+                memcpy(values, data, size * sizeof(f32));
+                break;
+            case VertexAttribute::kHalf:
+                for (u32 i = 0; i < size; ++i)
+                {
+                    u16 value;
+                    memcpy(&value, data + i * sizeof(u16), sizeof(u16));
+                    values[i] = HalfToFloat(value);
+                }
+                break;
+            case VertexAttribute::kSnorm16:
+                for (u32 i = 0; i < size; ++i)
+                {
+                    s16 value;
+                    memcpy(&value, data + i * sizeof(s16), sizeof(s16));
+                    values[i] = UnpackSnorm16(value);
+                }
+                break;
+            case VertexAttribute::kUnorm16:
+                for (u32 i = 0; i < size; ++i)
+                {
+                    u16 value;
+                    memcpy(&value, data + i * sizeof(u16), sizeof(u16));
+                    values[i] = static_cast<f32>(value) / 65535.0f;
+                }
+                break;
+            case VertexAttribute::kSnorm8:
+                for (u32 i = 0; i < size; ++i)
+                    values[i] = std::max(static_cast<f32>(static_cast<s8>(data[i])) / 127.0f, -1.0f);
+                break;
+            case VertexAttribute::kUnorm8:
+                for (u32 i = 0; i < size; ++i)
+                    values[i] = static_cast<f32>(data[i]) / 255.0f;
+                break;
+            case VertexAttribute::kSnorm10:
+                {
+                    u32 packed;
+                    memcpy(&packed, data, sizeof(packed));
+                    for (u32 i = 0; i < size; ++i)
+                    {
+                        // Sign extension of 10-bit value
+                        int value = static_cast<int>((packed >> (10 * i)) & 0x3ff);
+                        if (value & 0x200)
+                            value -= 0x400;
+                        values[i] = std::max(static_cast<f32>(value) / 511.0f, -1.0f);
+                    }
+                }
+                break;
+            case VertexAttribute::kOctahedral16:
+                {
+                    s16 packed[2];
+                    memcpy(packed, data, sizeof(packed));
+                    DecodeOctahedral(UnpackSnorm16(packed[0]), UnpackSnorm16(packed[1]), values);
+                }
+                break;
+            default:
+                assert(!"Unknown vertex attribute format");
+            }
+        }
+        u16 FloatToHalf(f32 value)
+        {
+            u32 bits;
+            memcpy(&bits, &value, sizeof(bits));
+            const u32 sign = (bits >> 16) & 0x8000;
+            const u32 magnitude = bits & 0x7fffffff;
+            if (magnitude >= 0x7f800000) // infinity or NaN
+                return static_cast<u16>(sign | 0x7c00 | ((magnitude > 0x7f800000) ? 0x200 : 0));
+            if (magnitude >= 0x477ff000) // rounds to value above 65504
+                return static_cast<u16>(sign | 0x7c00);
+            if (magnitude < 0x38800000) // below 2^-14, denormalized half
+            {
+                if (magnitude < 0x33000000) // below 2^-25, rounds to zero
+                    return static_cast<u16>(sign);
+                const u32 exponent = magnitude >> 23;
+                const u32 mantissa = (magnitude & 0x7fffff) | 0x800000;
+                const u32 shift = 126 - exponent;
+                u32 result = mantissa >> shift;
+                const u32 remainder = mantissa & ((1u << shift) - 1);
+                const u32 halfway = 1u << (shift - 1);
+                if (remainder > halfway || (remainder == halfway && (result & 1)))
+                    ++result;
+                return static_cast<u16>(sign | result);
+            }
+            // Rebias exponent, mantissa carry correctly increments exponent
+            u32 result = (magnitude - 0x38000000) >> 13;
+            const u32 remainder = magnitude & 0x1fff;
+            if (remainder > 0x1000 || (remainder == 0x1000 && (result & 1)))
+                ++result;
+            return static_cast<u16>(sign | result);
+        }
+        f32 HalfToFloat(u16 value)
+        {
+            const u32 sign = static_cast<u32>(value & 0x8000) << 16;
+            const u32 exponent = (value >> 10) & 0x1f;
+            const u32 mantissa = value & 0x3ff;
+            u32 bits;
+            if (exponent == 0)
+            {
+                const f32 result = static_cast<f32>(mantissa) * (1.0f / 16777216.0f);
+                return sign ? -result : result;
+            }
+            else if (exponent == 31)
+                bits = sign | 0x7f800000 | (mantissa << 13);
+            else
+                bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+            f32 result;
+            memcpy(&result, &bits, sizeof(result));
+            return result;
+        }
+        void EncodeOctahedral(const f32 * vector, f32 * x, f32 * y)
+        {
+            const f32 norm = fabsf(vector[0]) + fabsf(vector[1]) + fabsf(vector[2]);
+            if (norm == 0.0f)
+            {
+                *x = 0.0f;
+                *y = 0.0f;
+                return;
+            }
+            f32 u = vector[0] / norm;
+            f32 v = vector[1] / norm;
+            if (vector[2] < 0.0f)
+            {
+                // Lower hemisphere is folded over diagonals
+                const f32 folded_u = (1.0f - fabsf(v)) * SignNotZero(u);
+                const f32 folded_v = (1.0f - fabsf(u)) * SignNotZero(v);
+                u = folded_u;
+                v = folded_v;
+            }
+            *x = u;
+            *y = v;
+        }
+        void DecodeOctahedral(f32 x, f32 y, f32 * vector)
+        {
+            f32 z = 1.0f - fabsf(x) - fabsf(y);
+            if (z < 0.0f)
+            {
+                const f32 unfolded_x = (1.0f - fabsf(y)) * SignNotZero(x);
+                const f32 unfolded_y = (1.0f - fabsf(x)) * SignNotZero(y);
+                x = unfolded_x;
+                y = unfolded_y;
+            }
+            const f32 length = sqrtf(x * x + y * y + z * z);
+            vector[0] = x / length;
+            vector[1] = y / length;
+            vector[2] = z / length;
+        }
+        
+    } // namespace graphics
+} // namespace sht
@@ -272,6 +272,21 @@ namespace math {
         }
         return true;
     }
+    bool Frustum::IsCasterBoxIn(const BoundingBox& bb) const
+    {
+        for (int i = 0; i < 6; ++i)
+        {
+            if (i == FRUSTUM_NEAR)
+                continue;
+            float d = (planes_[i].normal & bb.center) + planes_[i].offset;
+            float extent_toward_plane = std::abs(bb.extent.x * planes_[i].normal.x)
+                                      + std::abs(bb.extent.y * planes_[i].normal.y)
+                                      + std::abs(bb.extent.z * planes_[i].normal.z);
+            if (d < -extent_toward_plane)
+                return false;
+        }
+        return true;
+    }
     CullInfo Frustum::ComputeBoxVisibility(const vec3& center, const vec3& extent, CullInfo in) const
     {
         // Check the box against each active frustum plane.
@@ -44,6 +44,10 @@ namespace math {
         bool IsBoxIn(const BoundingBox& bb) const;
         bool IsPlaneIn(float sx, float sz, float ex, float ez, float h) const;
 
+        //! Light-space test of shadow caster against orthographic light frustum.
+        //! Near plane is ignored, objects between light and frustum still throw shadows into it.
+        bool IsCasterBoxIn(const BoundingBox& bb) const;
+
         //! optimized algorithm for terrain quadtree
         /* Usage:
         int TerrainChunk::Render(CullInfo cull_info)
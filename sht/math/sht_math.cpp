@@ -7,6 +7,32 @@ namespace sht {
         float Sign(float x)
         {
             return (x < 0.0f) ? -1.0f : 1.0f;
+        }
+        float FastAtan2(float y, float x)
+        {
+            float ax = fabsf(x);
+            float ay = fabsf(y);
+            float mx = (ax > ay) ? ax : ay;
+            if (mx == 0.0f)
+                return 0.0f;
+            float mn = (ax > ay) ? ay : ax;
+            float a = mn / mx; // [0; 1]
+            float s = a * a;
+            // Minimax polynomial for atan on [0; 1]
+            float r = ((((-0.0117212f * s + 0.05265332f) * s - 0.11643287f) * s
+                + 0.19354346f) * s - 0.33262347f) * s * a + 0.99997726f * a;
+            if (ay > ax)
+                r = 1.5707963268f - r;
+            if (x < 0.0f)
+                r = kPi - r;
+            if (y < 0.0f)
+                r = -r;
+            return r;
+        }
+        float FastAsin(float x)
+        {
+            float c = 1.0f - x * x;
+            return FastAtan2(x, (c > 0.0f) ? sqrtf(c) : 0.0f);
         }
 		Vector3 ClosestPointOnLine(const Vector3& a, const Vector3& b, const Vector3& p)
 		{
@@ -18,6 +18,10 @@ namespace sht {
         // Sign function (returns -1 if negative, 1 otherwise)
         float Sign(float x);
 
+        // Fast polynomial approximations (max error is about 1e-5 radians)
+        float FastAtan2(float y, float x);
+        float FastAsin(float x);
+
         // Clamp function
         template <typename T>
         inline T Clamp(T x, T a, T b)
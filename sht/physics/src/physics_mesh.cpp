@@ -21,11 +21,13 @@ namespace sht {
 			graphics::MeshVerticesInfo vertices_info;
 			while (enumerator->GetNextObject(&vertices_info))
 			{
-				for (unsigned int i = 0; i < vertices_info.num_vertices; i += 3)
+				const unsigned int * indices = vertices_info.indices;
+				const unsigned int count = indices ? vertices_info.num_indices : vertices_info.num_vertices;
+				for (unsigned int i = 0; i < count; i += 3)
 				{
-					math::Vector3 mesh_vertex0 = vertices_info.vertices[i + 0].position;
-					math::Vector3 mesh_vertex1 = vertices_info.vertices[i + 1].position;
-					math::Vector3 mesh_vertex2 = vertices_info.vertices[i + 2].position;
+					math::Vector3 mesh_vertex0 = vertices_info.vertices[indices ? indices[i + 0] : i + 0].position;
+					math::Vector3 mesh_vertex1 = vertices_info.vertices[indices ? indices[i + 1] : i + 1].position;
+					math::Vector3 mesh_vertex2 = vertices_info.vertices[indices ? indices[i + 2] : i + 2].position;
 					if (unit_conversion_ && unit_conversion_->linear_to)
 					{
 						unit_conversion_->linear_to(&mesh_vertex0.x);
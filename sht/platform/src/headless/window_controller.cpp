@@ -0,0 +1,124 @@
+#include "../../include/window_controller.h"
+#include "../platform_inner.h"
+
+#include "../../../application/application.h"
+
+// Platform layer without window and graphics device.
+// Link it instead of the windowed one to run headless application on any machine.
+
+namespace {
+	struct HeadlessWindow {
+		bool need_quit;
+		float cursor_x;
+		float cursor_y;
+		std::string clipboard;
+	};
+	HeadlessWindow g_window;
+}
+
+bool PlatformInit()
+{
+	g_window.need_quit = false;
+	g_window.cursor_x = 0.0f;
+	g_window.cursor_y = 0.0f;
+	return true;
+}
+void PlatformTerminate()
+{
+}
+bool PlatformWindowCreate()
+{
+	return true;
+}
+void PlatformWindowDestroy()
+{
+}
+bool PlatformNeedQuit()
+{
+	return g_window.need_quit;
+}
+void PlatformPollEvents()
+{
+}
+void PlatformWindowMakeWindowed()
+{
+}
+bool PlatformWindowMakeFullscreen()
+{
+	return true;
+}
+void PlatformWindowCenter()
+{
+}
+void PlatformWindowResize(int width, int height)
+{
+	sht::Application::GetInstance()->OnSize(width, height);
+}
+void PlatformWindowSetTitle(const char *title)
+{
+}
+void PlatformWindowIconify()
+{
+}
+void PlatformWindowRestore()
+{
+}
+void PlatformWindowShow()
+{
+}
+void PlatformWindowHide()
+{
+}
+void PlatformWindowTerminate()
+{
+	g_window.need_quit = true;
+}
+bool PlatformInitOpenGLContext(int color_bits, int depth_bits, int stencil_bits)
+{
+	return false; // there is no graphics device
+}
+void PlatformDeinitOpenGLContext()
+{
+}
+void PlatformSwapBuffers()
+{
+}
+void PlatformMakeContextCurrent()
+{
+}
+void PlatformSwapInterval(int interval)
+{
+}
+void PlatformSetCursorPos(float x, float y)
+{
+	g_window.cursor_x = x;
+	g_window.cursor_y = y;
+}
+void PlatformGetCursorPos(float& x, float& y)
+{
+	x = g_window.cursor_x;
+	y = g_window.cursor_y;
+}
+void PlatformMouseToCenter()
+{
+	sht::Application * app = sht::Application::GetInstance();
+	g_window.cursor_x = 0.5f * static_cast<float>(app->width());
+	g_window.cursor_y = 0.5f * static_cast<float>(app->height());
+}
+void PlatformShowCursor()
+{
+}
+void PlatformHideCursor()
+{
+}
+void PlatformSetClipboardText(const char *text)
+{
+	g_window.clipboard = text;
+}
+std::string PlatformGetClipboardText()
+{
+	return g_window.clipboard;
+}
+void PlatformChangeDirectoryToResources()
+{
+}
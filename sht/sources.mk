@@ -3,6 +3,7 @@
 SRC_DIRS = \
 	$(ROOT_PATH)/sht/application \
 	$(ROOT_PATH)/sht/application/opengl \
+	$(ROOT_PATH)/sht/application/headless \
 	$(ROOT_PATH)/sht/common \
 	$(ROOT_PATH)/sht/containers \
 	$(ROOT_PATH)/sht/geo/src \
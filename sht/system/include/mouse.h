@@ -36,7 +36,7 @@ namespace sht {
         float y_;
         float delta_x_;
         float delta_y_;
-        EnumTable<MouseButton, bool> button_down_table_;
+        EnumArray<MouseButton, bool> button_down_table_;
     };
     
 } // namespace sht
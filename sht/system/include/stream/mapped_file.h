@@ -0,0 +1,36 @@
+#pragma once
+#ifndef __SHT_SYSTEM_STREAM_MAPPED_FILE_H__
+#define __SHT_SYSTEM_STREAM_MAPPED_FILE_H__
+
+#include "../../../common/types.h"
+
+#include <stddef.h>
+
+namespace sht {
+	namespace system {
+
+		//! Read-only file mapped into memory, pages are loaded on first access
+		class MappedFile {
+		public:
+			MappedFile();
+			~MappedFile();
+
+			bool Open(const char *filename);
+			void Close();
+
+			const u8 * data() const;	//!< page aligned, null if file isn't open
+			size_t size() const;
+
+		private:
+			MappedFile(const MappedFile&) = delete;
+			void operator = (const MappedFile&) = delete;
+
+			const u8 * data_;
+			size_t size_;
+			void * mapping_;			//!< mapping object on Windows
+		};
+
+	} // namespace system
+} // namespace sht
+
+#endif
@@ -0,0 +1,21 @@
+#pragma once
+#ifndef __SHT_SYSTEM_PARALLEL_FOR_H__
+#define __SHT_SYSTEM_PARALLEL_FOR_H__
+
+#include <functional>
+
+namespace sht {
+	namespace system {
+
+		//! Returns number of worker threads used for parallel loops
+		int GetWorkerThreadCount();
+
+		//! Splits range [begin, end) into contiguous chunks and processes them on worker threads.
+		//! Function receives chunk bounds [chunk_begin, chunk_end). Calling thread takes part in work.
+		//! Ranges smaller than min_chunk_size are processed on the calling thread.
+		void ParallelFor(int begin, int end, const std::function<void(int, int)>& func, int min_chunk_size = 1);
+
+	} // namespace system
+} // namespace sht
+
+#endif
@@ -0,0 +1,52 @@
+#pragma once
+#ifndef __SHT_SYSTEM_SERVICE_POOL_H__
+#define __SHT_SYSTEM_SERVICE_POOL_H__
+
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <list>
+#include <vector>
+
+namespace sht {
+	namespace system {
+
+		class ServiceTaskInterface;
+
+		//! Service that executes tasks from a single queue on several threads.
+		//! Tasks are deleted after execution like in Service.
+		class ServicePool {
+		public:
+			explicit ServicePool(int num_threads = 0); //!< zero means number of worker threads
+			~ServicePool();
+
+			static ServicePool * GetShared(); //!< pool shared by engine subsystems
+
+			void RunService();
+			void StopService();
+
+			void AddTask(ServiceTaskInterface * task);
+			void WaitIdle();	//!< waits until queue is empty and no task is running
+
+			int num_threads() const;
+
+		private:
+			ServicePool(const ServicePool&) = delete;
+			ServicePool& operator=(const ServicePool&) = delete;
+
+			void ThreadFunc();
+
+			std::mutex mutex_;
+			std::condition_variable condition_variable_;
+			std::condition_variable idle_condition_variable_;
+			std::vector<std::thread> threads_;
+			std::list<ServiceTaskInterface*> tasks_;
+			int num_threads_;
+			int num_running_;
+			bool finishing_;
+		};
+
+	} // namespace system
+} // namespace sht
+
+#endif
@@ -1,16 +1,10 @@
 #include "../include/mouse.h"
-#include <assert.h>
 
 namespace sht {
     
     Mouse::Mouse()
     : x_(0), y_(0)
     {
-        button_down_table_[MouseButton::kUnknown] = false;
-        button_down_table_[MouseButton::kLeft] = false;
-        button_down_table_[MouseButton::kMiddle] = false;
-        button_down_table_[MouseButton::kRight] = false;
-        assert(button_down_table_.size() == (size_t)MouseButton::kCount);
     }
     Mouse::~Mouse()
     {
@@ -0,0 +1,97 @@
+#include "../../include/stream/mapped_file.h"
+
+#include "../../../common/platform.h"
+
+#ifndef TARGET_WINDOWS
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif // !TARGET_WINDOWS
+
+namespace sht {
+	namespace system {
+
+		MappedFile::MappedFile()
+		: data_(nullptr)
+		, size_(0)
+		, mapping_(nullptr)
+		{
+		}
+		MappedFile::~MappedFile()
+		{
+			Close();
+		}
+		bool MappedFile::Open(const char *filename)
+		{
+			Close();
+#ifdef TARGET_WINDOWS
+			HANDLE file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+				FILE_ATTRIBUTE_NORMAL, NULL);
+			if (file == INVALID_HANDLE_VALUE)
+				return false;
+			LARGE_INTEGER file_size;
+			if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0)
+			{
+				CloseHandle(file);
+				return false;
+			}
+			HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+			// Mapping keeps file open by itself
+			CloseHandle(file);
+			if (mapping == NULL)
+				return false;
+			void * data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+			if (data == NULL)
+			{
+				CloseHandle(mapping);
+				return false;
+			}
+			mapping_ = mapping;
+			data_ = static_cast<const u8*>(data);
+			size_ = static_cast<size_t>(file_size.QuadPart);
+#else
+			int file = open(filename, O_RDONLY);
+			if (file < 0)
+				return false;
+			struct stat file_stat;
+			if (fstat(file, &file_stat) != 0 || file_stat.st_size == 0)
+			{
+				close(file);
+				return false;
+			}
+			void * data = mmap(nullptr, static_cast<size_t>(file_stat.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+			// Mapping keeps file open by itself
+			close(file);
+			if (data == MAP_FAILED)
+				return false;
+			data_ = static_cast<const u8*>(data);
+			size_ = static_cast<size_t>(file_stat.st_size);
+#endif // TARGET_WINDOWS
+			return true;
+		}
+		void MappedFile::Close()
+		{
+			if (data_ == nullptr)
+				return;
+#ifdef TARGET_WINDOWS
+			UnmapViewOfFile(data_);
+			CloseHandle(static_cast<HANDLE>(mapping_));
+#else
+			munmap(const_cast<u8*>(data_), size_);
+#endif // TARGET_WINDOWS
+			data_ = nullptr;
+			size_ = 0;
+			mapping_ = nullptr;
+		}
+		const u8 * MappedFile::data() const
+		{
+			return data_;
+		}
+		size_t MappedFile::size() const
+		{
+			return size_;
+		}
+
+	} // namespace system
+} // namespace sht
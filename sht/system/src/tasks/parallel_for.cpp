@@ -0,0 +1,50 @@
+#include "../../include/tasks/parallel_for.h"
+
+#include <thread>
+#include <vector>
+#include <algorithm>
+
+namespace sht {
+	namespace system {
+
+		int GetWorkerThreadCount()
+		{
+			unsigned int count = std::thread::hardware_concurrency();
+			return (count == 0) ? 1 : static_cast<int>(count);
+		}
+		void ParallelFor(int begin, int end, const std::function<void(int, int)>& func, int min_chunk_size)
+		{
+			int count = end - begin;
+			if (count <= 0)
+				return;
+			if (min_chunk_size < 1)
+				min_chunk_size = 1;
+
+			int num_chunks = std::min(GetWorkerThreadCount(), (count + min_chunk_size - 1) / min_chunk_size);
+			if (num_chunks <= 1)
+			{
+				func(begin, end);
+				return;
+			}
+
+			int chunk_size = count / num_chunks;
+			int remainder = count % num_chunks;
+
+			std::vector<std::thread> threads;
+			threads.reserve(num_chunks - 1);
+			int chunk_begin = begin;
+			for (int i = 0; i < num_chunks; ++i)
+			{
+				int chunk_end = chunk_begin + chunk_size + ((i < remainder) ? 1 : 0);
+				if (i == num_chunks - 1)
+					func(chunk_begin, chunk_end); // last chunk is processed by the calling thread
+				else
+					threads.push_back(std::thread(func, chunk_begin, chunk_end));
+				chunk_begin = chunk_end;
+			}
+			for (auto& thread : threads)
+				thread.join();
+		}
+
+	} // namespace system
+} // namespace sht
@@ -0,0 +1,98 @@
+#include "../../include/tasks/service_pool.h"
+#include "../../include/tasks/service_task_interface.h"
+#include "../../include/tasks/parallel_for.h"
+
+namespace sht {
+	namespace system {
+
+		ServicePool::ServicePool(int num_threads)
+		: num_threads_((num_threads > 0) ? num_threads : GetWorkerThreadCount())
+		, num_running_(0)
+		, finishing_(false)
+		{
+		}
+		ServicePool::~ServicePool()
+		{
+			if (!threads_.empty())
+				StopService();
+		}
+		ServicePool * ServicePool::GetShared()
+		{
+			static ServicePool pool;
+			static std::once_flag flag;
+			// Threads are started on first use
+			std::call_once(flag, [](){ pool.RunService(); });
+			return &pool;
+		}
+		void ServicePool::RunService()
+		{
+			finishing_ = false;
+			threads_.reserve(num_threads_);
+			for (int i = 0; i < num_threads_; ++i)
+				threads_.push_back(std::thread(&ServicePool::ThreadFunc, this));
+		}
+		void ServicePool::StopService()
+		{
+			{//---
+				std::unique_lock<std::mutex> guard(mutex_);
+				finishing_ = true;
+				condition_variable_.notify_all();
+			}//---
+			for (auto& thread : threads_)
+				thread.join();
+			threads_.clear();
+
+			// Don't forget to clear tasks
+			while (!tasks_.empty())
+			{
+				delete tasks_.front();
+				tasks_.pop_front();
+			}
+		}
+		void ServicePool::AddTask(ServiceTaskInterface * task)
+		{
+			std::unique_lock<std::mutex> guard(mutex_);
+			tasks_.push_back(task);
+			condition_variable_.notify_one();
+		}
+		void ServicePool::WaitIdle()
+		{
+			std::unique_lock<std::mutex> guard(mutex_);
+			while (!tasks_.empty() || num_running_ != 0)
+				idle_condition_variable_.wait(guard);
+		}
+		int ServicePool::num_threads() const
+		{
+			return num_threads_;
+		}
+		void ServicePool::ThreadFunc()
+		{
+			for (;;)
+			{
+				ServiceTaskInterface * task = nullptr;
+				{//---
+					std::unique_lock<std::mutex> guard(mutex_);
+					while (!finishing_ && tasks_.empty())
+						condition_variable_.wait(guard);
+					if (finishing_)
+						break;
+					// Dequeue front task
+					task = tasks_.front();
+					tasks_.pop_front();
+					++num_running_;
+				}//---
+
+				task->Notify(task->Execute());
+				delete task;
+
+				{//---
+					std::lock_guard<std::mutex> guard(mutex_);
+					--num_running_;
+					if (tasks_.empty() && num_running_ == 0)
+						idle_condition_variable_.notify_all();
+				}//---
+			}
+		}
+
+	} // namespace system
+} // namespace sht
@@ -60,6 +60,22 @@ namespace sht {
 				virtual void FillVertices() override;
 			};
 
+			//! Button with atlas images, it is drawn by sprite batch together with other sprites
+			class ButtonSprite : public Button {
+			public:
+				ButtonSprite(SpriteBatch * batch, sht::graphics::Texture * texture,
+					const sht::graphics::AtlasRegion& normal_region, const sht::graphics::AtlasRegion& touch_region,
+					f32 x, f32 y, f32 width, f32 height, u32 flags);
+
+				virtual void Render() override;		//!< adds itself to batch, batch should be flushed later
+
+			private:
+				SpriteBatch * batch_;
+				sht::graphics::Texture * texture_;	//!< atlas page containing both regions
+				sht::graphics::AtlasRegion normal_region_;
+				sht::graphics::AtlasRegion touch_region_;
+			};
+
 		} // namespace ui
 	} // namespace utility
 } // namespace sht
@@ -4,6 +4,7 @@
 
 #include "widget.h"
 #include "drawable.h"
+#include "sprite_batch.h"
 
 namespace sht {
 	namespace utility {
@@ -59,6 +60,22 @@ namespace sht {
 				virtual void FillVertices() override;
 			};
 
+			//! Rectangle with atlas image, it is drawn by sprite batch together with other sprites
+			class RectSprite : public Rect {
+			public:
+				RectSprite(SpriteBatch * batch, sht::graphics::Texture * texture,
+					const sht::graphics::AtlasRegion& region, f32 x, f32 y, f32 width, f32 height, u32 flags);
+
+				virtual void Render() override;		//!< adds itself to batch, batch should be flushed later
+
+				void set_region(const sht::graphics::AtlasRegion& region);
+
+			private:
+				SpriteBatch * batch_;
+				sht::graphics::Texture * texture_;
+				sht::graphics::AtlasRegion region_;
+			};
+
 		} // namespace ui
 	} // namespace utility
 } // namespace sht
@@ -0,0 +1,54 @@
+#pragma once
+#ifndef __SHT_UI_SPRITE_BATCH_H__
+#define __SHT_UI_SPRITE_BATCH_H__
+
+#include "../../../graphics/include/renderer/renderer.h"
+#include "../../../graphics/include/image/texture_atlas.h"
+
+#include <vector>
+
+namespace sht {
+	namespace utility {
+		namespace ui {
+
+			//! Collects textured rectangles and draws them with one draw call per run of the same texture.
+			//! Widgets sharing an atlas page therefore cost a single draw call.
+			//! Vertices go through the renderer's ring buffer, shader is expected to be gui_textured one.
+			class SpriteBatch {
+			public:
+				SpriteBatch(sht::graphics::Renderer * renderer, sht::graphics::Shader * shader);
+				~SpriteBatch();
+
+				//! Adds rectangle with texture coordinates of atlas region
+				void Add(sht::graphics::Texture * texture, f32 x, f32 y, f32 width, f32 height,
+					const sht::graphics::AtlasRegion& region);
+				//! Adds rectangle with texture coordinates in range [u0,u1]x[v0,v1]
+				void Add(sht::graphics::Texture * texture, f32 x, f32 y, f32 width, f32 height,
+					f32 u0, f32 v0, f32 u1, f32 v1);
+
+				void Flush();					//!< draws all added rectangles
+
+				u32 num_sprites() const;		//!< sprites waiting for flush
+				u32 num_draw_calls() const;		//!< draw calls made by the last flush
+
+			private:
+				//! Consecutive sprites with the same texture
+				struct Run {
+					sht::graphics::Texture * texture;
+					u32 first_vertex;
+					u32 num_vertices;
+				};
+
+				sht::graphics::Renderer * renderer_;
+				sht::graphics::Shader * shader_;
+				u32 vertex_array_object_;
+				std::vector<vec4> vertices_;	//!< x, y, tx, ty
+				std::vector<Run> runs_;
+				u32 num_draw_calls_;
+			};
+
+		} // namespace ui
+	} // namespace utility
+} // namespace sht
+
+#endif
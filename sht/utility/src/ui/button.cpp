@@ -161,6 +161,24 @@ namespace sht {
 				vertices[3].w = 1.0f;
 			}
 
+			ButtonSprite::ButtonSprite(SpriteBatch * batch, sht::graphics::Texture * texture,
+					const sht::graphics::AtlasRegion& normal_region, const sht::graphics::AtlasRegion& touch_region,
+					f32 x, f32 y, f32 width, f32 height, u32 flags)
+			: Button(x, y, width, height, flags)
+			, batch_(batch)
+			, texture_(texture)
+			, normal_region_(normal_region)
+			, touch_region_(touch_region)
+			{
+			}
+			void ButtonSprite::Render()
+			{
+				vec2 position;
+				ObtainGlobalPosition(&position);
+				batch_->Add(texture_, position.x, position.y, width_, height_,
+					(is_touched_) ? touch_region_ : normal_region_);
+			}
+
 		} // namespace ui
 	} // namespace utility
 } // namespace sht
\ No newline at end of file
@@ -154,6 +154,24 @@ namespace sht {
 				vertices[3].w = 1.0f;
 			}
 
+			RectSprite::RectSprite(SpriteBatch * batch, sht::graphics::Texture * texture,
+					const sht::graphics::AtlasRegion& region, f32 x, f32 y, f32 width, f32 height, u32 flags)
+			: Rect(x, y, width, height, flags)
+			, batch_(batch)
+			, texture_(texture)
+			, region_(region)
+			{
+			}
+			void RectSprite::Render()
+			{
+				vec2 position;
+				ObtainGlobalPosition(&position);
+				batch_->Add(texture_, position.x, position.y, width_, height_, region_);
+			}
+			void RectSprite::set_region(const sht::graphics::AtlasRegion& region)
+			{
+				region_ = region;
+			}
 		} // namespace ui
 	} // namespace utility
 } // namespace sht
\ No newline at end of file
@@ -0,0 +1,99 @@
+#include "../../include/ui/sprite_batch.h"
+
+#include <cstring>
+
+namespace sht {
+	namespace utility {
+		namespace ui {
+
+			SpriteBatch::SpriteBatch(sht::graphics::Renderer * renderer, sht::graphics::Shader * shader)
+			: renderer_(renderer)
+			, shader_(shader)
+			, vertex_array_object_(0)
+			, num_draw_calls_(0)
+			{
+				// Attributes point to the shared ring buffer
+				renderer_->context()->GenVertexArrayObject(vertex_array_object_);
+				renderer_->context()->BindVertexArrayObject(vertex_array_object_);
+				renderer_->ring_buffer()->Bind();
+				const char* base = (char*)0;
+				renderer_->context()->VertexAttribPointer(0, 4, sht::graphics::DataType::kFloat, sizeof(vec4), base);
+				renderer_->context()->EnableVertexAttribArray(0);
+				renderer_->context()->BindVertexArrayObject(0);
+				renderer_->context()->CheckForErrors();
+			}
+			SpriteBatch::~SpriteBatch()
+			{
+				if (vertex_array_object_)
+					renderer_->context()->DeleteVertexArrayObject(vertex_array_object_);
+			}
+			void SpriteBatch::Add(sht::graphics::Texture * texture, f32 x, f32 y, f32 width, f32 height,
+				const sht::graphics::AtlasRegion& region)
+			{
+				Add(texture, x, y, width, height, region.u0, region.v0, region.u1, region.v1);
+			}
+			void SpriteBatch::Add(sht::graphics::Texture * texture, f32 x, f32 y, f32 width, f32 height,
+				f32 u0, f32 v0, f32 u1, f32 v1)
+			{
+				const u32 first_vertex = static_cast<u32>(vertices_.size());
+				// Two triangles, there is no index buffer in the ring
+				vertices_.push_back(vec4(x, y, u0, v0));
+				vertices_.push_back(vec4(x + width, y, u1, v0));
+				vertices_.push_back(vec4(x, y + height, u0, v1));
+				vertices_.push_back(vec4(x, y + height, u0, v1));
+				vertices_.push_back(vec4(x + width, y, u1, v0));
+				vertices_.push_back(vec4(x + width, y + height, u1, v1));
+				if (runs_.empty() || runs_.back().texture != texture)
+				{
+					Run run = { texture, first_vertex, 0 };
+					runs_.push_back(run);
+				}
+				runs_.back().num_vertices += 6;
+			}
+			void SpriteBatch::Flush()
+			{
+				num_draw_calls_ = 0;
+				if (vertices_.empty())
+					return;
+
+				sht::graphics::RingBuffer * ring_buffer = renderer_->ring_buffer();
+				const u32 vertex_size = sizeof(vec4);
+				const u32 size = static_cast<u32>(vertices_.size()) * vertex_size;
+				sht::graphics::RingAllocation allocation = ring_buffer->Map(size, vertex_size);
+				if (allocation.pointer != nullptr)
+				{
+					memcpy(allocation.pointer, &vertices_[0], size);
+					ring_buffer->Unmap();
+					const u32 base_vertex = allocation.offset / vertex_size;
+
+					// Vertices are already in screen space
+					shader_->Bind();
+					shader_->Uniform1i("u_texture", 0);
+					shader_->Uniform1f("u_aspect_ratio", renderer_->aspect_ratio());
+					shader_->Uniform2f("u_position", 0.0f, 0.0f);
+					renderer_->context()->BindVertexArrayObject(vertex_array_object_);
+					for (const auto& run : runs_)
+					{
+						renderer_->ChangeTexture(run.texture);
+						renderer_->context()->DrawArrays(sht::graphics::PrimitiveType::kTriangles,
+							base_vertex + run.first_vertex, run.num_vertices);
+						++num_draw_calls_;
+					}
+					renderer_->context()->BindVertexArrayObject(0);
+					shader_->Unbind();
+				}
+				vertices_.clear();
+				runs_.clear();
+			}
+			u32 SpriteBatch::num_sprites() const
+			{
+				return static_cast<u32>(vertices_.size() / 6);
+			}
+			u32 SpriteBatch::num_draw_calls() const
+			{
+				return num_draw_calls_;
+			}
+
+		} // namespace ui
+	} // namespace utility
+} // namespace sht
@@ -0,0 +1,258 @@
+#include "sht/graphics/include/image/image.h"
+#include "sht/graphics/include/renderer/null_context.h"
+#include "sht/graphics/include/renderer/texture_upload_queue.h"
+#include "sht/system/include/tasks/service_pool.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <atomic>
+#include <future>
+#include <vector>
+
+using sht::graphics::Image;
+using sht::graphics::Texture;
+using sht::graphics::TextureUploadQueue;
+
+/*
+Test for asynchronous image loading and time sliced texture uploads.
+Decoding runs on the shared service pool, uploads are checked against a context
+that records texture calls instead of issuing them.
+*/
+
+static int g_failures = 0;
+
+#define CHECK(condition) \
+	do { if (!(condition)) { printf("  FAILED: %s (line %d)\n", #condition, __LINE__); ++g_failures; } } while (0)
+
+//! Texture that doesn't own any API object
+class FakeTexture : public Texture {
+public:
+	FakeTexture(int w, int h, Image::Format fmt, u32 id)
+	{
+		width_ = w;
+		height_ = h;
+		format_ = fmt;
+		texture_id_ = id;
+		ChooseTarget();
+	}
+	~FakeTexture()
+	{
+	}
+	u32 GetSrcFormat() { return 0x1908; }
+	u32 GetSrcType() { return 0x1401; }
+	s32 GetInternalFormat() { return 0x8058; }
+	u32 id() const { return texture_id_; }
+
+protected:
+	void ChooseTarget() { target_ = 0x0DE1; }
+};
+
+//! Context that records texture calls
+class RecordingContext : public sht::graphics::NullContext {
+public:
+	RecordingContext()
+	: num_binds(0), num_uploads(0), num_mipmaps(0), bound_texture(0), next_row(0), rows_in_order(true)
+	{
+	}
+	void TextureSubImage2D(u32 target, s32 level, s32 x, s32 y, s32 w, s32 h,
+		u32 format, u32 type, const void *data)
+	{
+		++num_uploads;
+		if (y != next_row || x != 0 || level != 0 || data == nullptr)
+			rows_in_order = false;
+		next_row = y + h;
+	}
+	void GenerateMipmap(u32 target)
+	{
+		++num_mipmaps;
+		next_row = 0;
+	}
+
+	int num_binds;
+	int num_uploads;
+	int num_mipmaps;
+	u32 bound_texture;
+	int next_row;
+	bool rows_in_order;
+
+protected:
+	void ApiBindTexture(u32 target, u32 obj)
+	{
+		++num_binds;
+		bound_texture = obj;
+	}
+};
+
+static void FillImage(Image * image, int w, int h, Image::Format fmt)
+{
+	u8 * pixels = image->Allocate(w, h, fmt);
+	const int size = w * h * image->bpp();
+	for (int i = 0; i < size; ++i)
+		pixels[i] = static_cast<u8>((i * 7) ^ (i >> 5));
+}
+
+static void TestLoadAsync()
+{
+	printf("LoadAsync\n");
+	Image source;
+	FillImage(&source, 320, 200, Image::Format::kRGBA8);
+	CHECK(source.Save("async_test.png"));
+	FillImage(&source, 320, 200, Image::Format::kRGB8);
+	CHECK(source.Save("async_test.jpg"));
+
+	// Future only
+	Image png;
+	std::future<bool> png_future = png.LoadAsync("async_test.png");
+	CHECK(png_future.get());
+	CHECK(png.width() == 320 && png.height() == 200 && png.format() == Image::Format::kRGBA8);
+
+	// Callback runs on worker thread before the future is ready
+	Image jpg;
+	std::atomic<int> num_callbacks(0);
+	Image * callback_image = nullptr;
+	std::future<bool> jpg_future = jpg.LoadAsync("async_test.jpg", Image::DecodeOptions(),
+		[&num_callbacks, &callback_image](Image * image, bool success)
+	{
+		if (success)
+			callback_image = image;
+		++num_callbacks;
+	});
+	CHECK(jpg_future.get());
+	CHECK(num_callbacks == 1 && callback_image == &jpg);
+	CHECK(jpg.width() == 320 && jpg.height() == 200);
+
+	// Decode options are passed through
+	Image region;
+	Image::DecodeOptions options;
+	options.region_x = 16;
+	options.region_y = 8;
+	options.region_width = 64;
+	options.region_height = 32;
+	CHECK(region.LoadAsync("async_test.png", options).get());
+	CHECK(region.width() == 64 && region.height() == 32);
+
+	// Missing file
+	Image missing;
+	bool reported_failure = false;
+	CHECK(!missing.LoadAsync("async_missing_file.png", Image::DecodeOptions(),
+		[&reported_failure](Image * image, bool success) { reported_failure = !success; }).get());
+	CHECK(reported_failure);
+
+	// Many loads at once
+	const int kNumImages = 16;
+	std::vector<Image> images(kNumImages);
+	std::vector<std::future<bool>> futures;
+	for (int i = 0; i < kNumImages; ++i)
+		futures.push_back(images[i].LoadAsync((i & 1) ? "async_test.jpg" : "async_test.png"));
+	for (int i = 0; i < kNumImages; ++i)
+		CHECK(futures[i].get() && images[i].width() == 320);
+	sht::system::ServicePool::GetShared()->WaitIdle();
+}
+
+static void TestUploadQueue()
+{
+	printf("TextureUploadQueue\n");
+	RecordingContext context;
+	std::vector<FakeTexture*> textures;
+	u32 last_id = 0;
+	TextureUploadQueue queue(&context, [&textures, &last_id](int w, int h, Image::Format fmt,
+		Texture::Wrap wrap, Texture::Filter filt)
+	{
+		FakeTexture * texture = new FakeTexture(w, h, fmt, ++last_id);
+		textures.push_back(texture);
+		return texture;
+	});
+
+	// 64 rows of 256 RGBA texels with 16 rows per slice
+	const int kWidth = 256, kHeight = 64;
+	queue.set_slice_size(kWidth * 4 * 16);
+	Image * staging = queue.AcquireStagingImage();
+	FillImage(staging, kWidth, kHeight, Image::Format::kRGBA8);
+	Texture * ready_texture = nullptr;
+	int num_ready = 0;
+	queue.Enqueue(staging, Texture::Wrap::kRepeat, Texture::Filter::kTrilinear,
+		[&ready_texture, &num_ready](Texture * texture) { ready_texture = texture; ++num_ready; });
+	CHECK(queue.num_pending() == 1);
+
+	// Zero budget makes exactly one step per frame: creation and then 4 slices
+	int frames = 0;
+	while (queue.num_pending() != 0 && frames < 100)
+	{
+		queue.Process(0.0f);
+		++frames;
+		CHECK(context.num_uploads <= frames);
+	}
+	CHECK(frames == 5);
+	CHECK(context.num_uploads == 4 && context.num_binds == 4);
+	CHECK(context.rows_in_order);
+	CHECK(context.num_mipmaps == 1);
+	CHECK(num_ready == 1 && ready_texture == textures[0]);
+	CHECK(context.bound_texture == textures[0]->id());
+	CHECK(ready_texture->width() == kWidth && ready_texture->height() == kHeight);
+
+	// Staging image memory is reused
+	const u8 * old_pixels = staging->pixels();
+	Image * reused = queue.AcquireStagingImage();
+	CHECK(reused == staging);
+	FillImage(reused, kWidth, kHeight / 2, Image::Format::kRGBA8);
+	CHECK(reused->pixels() == old_pixels);
+	CHECK(queue.num_staging_images() == 1);
+
+	// Large budget finishes all uploads in one call, failed loads are reported
+	context.num_uploads = 0;
+	Image * second = queue.AcquireStagingImage();
+	FillImage(second, 100, 10, Image::Format::kRGB8);
+	int num_failed = 0;
+	queue.Enqueue(reused, Texture::Wrap::kClamp, Texture::Filter::kLinear, [&num_ready](Texture * texture) { ++num_ready; });
+	queue.Enqueue(nullptr, Texture::Wrap::kClamp, Texture::Filter::kLinear,
+		[&num_failed](Texture * texture) { if (!texture) ++num_failed; });
+	queue.Enqueue(second, Texture::Wrap::kClamp, Texture::Filter::kLinear, [&num_ready](Texture * texture) { ++num_ready; });
+	queue.Process(10.0f);
+	CHECK(queue.num_pending() == 0);
+	CHECK(num_ready == 3 && num_failed == 1);
+	CHECK(context.num_uploads == 3); // 2 slices and a single small one
+	CHECK(context.num_mipmaps == 3);
+	CHECK(queue.num_staging_images() == 2);
+
+	// Images enqueued from decode threads
+	const int kNumLoads = 8;
+	std::atomic<int> num_loaded(0);
+	for (int i = 0; i < kNumLoads; ++i)
+	{
+		Image * image = queue.AcquireStagingImage();
+		image->LoadAsync("async_test.png", Image::DecodeOptions(), [&queue, &num_loaded](Image * loaded_image, bool success)
+		{
+			if (success)
+				queue.Enqueue(loaded_image, Texture::Wrap::kRepeat, Texture::Filter::kTrilinear,
+					[&num_loaded](Texture * texture) { if (texture) ++num_loaded; });
+			else
+				queue.ReleaseStagingImage(loaded_image);
+		});
+	}
+	sht::system::ServicePool::GetShared()->WaitIdle();
+	frames = 0;
+	while (queue.num_pending() != 0 && frames < 1000)
+	{
+		queue.Process(0.001f);
+		++frames;
+	}
+	CHECK(num_loaded == kNumLoads);
+	CHECK(context.rows_in_order);
+	CHECK(queue.num_staging_images() <= kNumLoads + 2);
+	printf("  %d images uploaded in %d frames\n", kNumLoads, frames);
+
+	for (auto texture : textures)
+		delete texture;
+}
+
+int main()
+{
+	TestLoadAsync();
+	TestUploadQueue();
+
+	if (g_failures)
+		printf("%d checks failed\n", g_failures);
+	else
+		printf("All checks passed\n");
+	return g_failures ? 1 : 0;
+}
@@ -0,0 +1,27 @@
+#!/bin/sh
+# Builds asynchronous image loading test together with bundled codec libraries
+SHT=../../sht
+THIRDPARTY=$SHT/thirdparty
+mkdir -p obj
+for f in $(sed -n 's/.*LIB_PATH)\/\([a-z0-9_]*\.c\).*/\1/p' $THIRDPARTY/libjpeg/sources.mk); do
+	gcc -O2 -c $THIRDPARTY/libjpeg/src/$f -I$THIRDPARTY/libjpeg/include -I$THIRDPARTY/libjpeg/src -o obj/$f.o
+done
+for f in $(sed -n 's/.*LIB_PATH)\/\([a-z0-9_]*\.c\).*/\1/p' $THIRDPARTY/libpng/sources.mk); do
+	gcc -O2 -c $THIRDPARTY/libpng/src/$f -I$THIRDPARTY/libpng/include -I$THIRDPARTY/libpng/src -I$THIRDPARTY/zlib/include -DPNG_USER_WIDTH_MAX=16384 -DPNG_USER_HEIGHT_MAX=16384 -o obj/$f.o
+done
+for f in $THIRDPARTY/zlib/src/*.c; do
+	gcc -O2 -c $f -I$THIRDPARTY/zlib/include -I$THIRDPARTY/zlib/src -o obj/$(basename $f).o
+done
+g++ main.cpp \
+	$SHT/graphics/src/image/*.cpp \
+	$SHT/graphics/src/renderer/context.cpp \
+	$SHT/graphics/src/renderer/null_context.cpp \
+	$SHT/graphics/src/renderer/texture.cpp \
+	$SHT/graphics/src/renderer/texture_upload_queue.cpp \
+	$SHT/system/src/stream/*.cpp \
+	$SHT/system/src/string/filename.cpp \
+	$SHT/system/src/tasks/parallel_for.cpp \
+	$SHT/system/src/tasks/service_pool.cpp \
+	$SHT/system/src/time/clock.cpp \
+	obj/*.o \
+	-O2 -std=c++11 -pthread -I../../ -I$SHT -I$THIRDPARTY/libjpeg/include -I$THIRDPARTY/libpng/include -o async_image_loading
@@ -0,0 +1,186 @@
+#include "sht/graphics/include/renderer/cascaded_shadows.h"
+
+#include <stdio.h>
+#include <cmath>
+#include <vector>
+
+using sht::graphics::CascadedShadows;
+using sht::math::BoundingBox;
+using sht::math::Matrix4;
+using sht::math::Vector3;
+
+/*
+Test for cascaded shadows fitting and caster culling.
+Checks that cascades cover the view frustum, stay still under small camera movements
+and that casters are culled in light space.
+*/
+
+static int g_failures = 0;
+
+#define CHECK(condition) \
+	do { if (!(condition)) { printf("  FAILED: %s (line %d)\n", #condition, __LINE__); ++g_failures; } } while (0)
+
+const int kNumCascades = 4;
+const int kResolution = 1024;
+const float kFov = 45.0f;
+const float kAspect = 16.0f / 9.0f;
+const float kNear = 0.1f;
+const float kFar = 100.0f;
+
+static BoundingBox MakeBox(const Vector3& center, float extent)
+{
+	BoundingBox box;
+	box.center = center;
+	box.extent = Vector3(extent);
+	return box;
+}
+
+//! Corners of view frustum slice in world space
+static void SliceCorners(const Matrix4& view, float znear, float zfar, Vector3 corners[8])
+{
+	const Matrix4 world = view.GetInverse();
+	const float tan_half_fov = tanf(0.5f * kFov * 0.0174532925f);
+	const float distances[2] = { znear, zfar };
+	for (int d = 0; d < 2; ++d)
+	{
+		float h = distances[d] * tan_half_fov;
+		float w = h * kAspect;
+		corners[d * 4 + 0] = world.TransformPoint(Vector3(-w, -h, -distances[d]));
+		corners[d * 4 + 1] = world.TransformPoint(Vector3( w, -h, -distances[d]));
+		corners[d * 4 + 2] = world.TransformPoint(Vector3( w,  h, -distances[d]));
+		corners[d * 4 + 3] = world.TransformPoint(Vector3(-w,  h, -distances[d]));
+	}
+}
+
+int main()
+{
+	CascadedShadows shadows(kNumCascades, kResolution);
+	const Vector3 light_direction = Vector3(-1.0f, -2.0f, -0.5f).GetNormalized();
+	const Vector3 eye(3.0f, 2.0f, 5.0f);
+	Matrix4 view = sht::math::LookAt(eye, Vector3(0.0f));
+	shadows.Update(view, kFov, kAspect, kNear, kFar, light_direction);
+
+	// Splits cover the whole depth range in increasing order
+	CHECK(shadows.cascade(0).split_near == kNear);
+	CHECK(shadows.cascade(kNumCascades - 1).split_far == kFar);
+	for (int i = 0; i < kNumCascades; ++i)
+	{
+		const CascadedShadows::Cascade& cascade = shadows.cascade(i);
+		CHECK(cascade.split_near < cascade.split_far);
+		if (i > 0)
+			CHECK(cascade.split_near == shadows.cascade(i - 1).split_far);
+		printf("cascade %d: %.2f - %.2f, radius %.3f\n", i, cascade.split_near, cascade.split_far, cascade.radius);
+	}
+	CHECK(shadows.SelectCascade(kNear) == 0);
+	CHECK(shadows.SelectCascade(kFar) == kNumCascades - 1);
+	CHECK(shadows.SelectCascade(0.5f * (shadows.cascade(1).split_near + shadows.cascade(1).split_far)) == 1);
+
+	// Every slice is inside its cascade and maps into shadow map range
+	for (int i = 0; i < kNumCascades; ++i)
+	{
+		const CascadedShadows::Cascade& cascade = shadows.cascade(i);
+		Vector3 corners[8];
+		SliceCorners(view, cascade.split_near, cascade.split_far, corners);
+		const Matrix4 shadow_matrix = shadows.GetShadowMatrix(i);
+		for (int c = 0; c < 8; ++c)
+		{
+			CHECK(cascade.frustum.IsPointIn(corners[c]));
+			Vector3 coord = shadow_matrix * corners[c];
+			CHECK(coord.x >= 0.0f && coord.x <= 1.0f && coord.y >= 0.0f && coord.y <= 1.0f);
+			CHECK(coord.z >= 0.0f && coord.z <= 1.0f);
+		}
+		// Projection is snapped to texels
+		const float texel_size = 2.0f * cascade.radius / kResolution;
+		const float texels = cascade.center.x / texel_size;
+		CHECK(fabsf(texels - floorf(texels + 0.5f)) < 1e-2f);
+	}
+
+	// Camera rotation keeps cascade sizes
+	Matrix4 rotated_view = sht::math::LookAt(eye, Vector3(4.0f, 1.0f, -3.0f));
+	CascadedShadows rotated(kNumCascades, kResolution);
+	rotated.Update(rotated_view, kFov, kAspect, kNear, kFar, light_direction);
+	for (int i = 0; i < kNumCascades; ++i)
+		CHECK(rotated.cascade(i).radius == shadows.cascade(i).radius);
+
+	// Static casters survive subpixel movements of camera and are rerendered after bigger ones
+	for (int i = 0; i < kNumCascades; ++i)
+	{
+		CHECK(!shadows.cascade(i).static_valid);
+		shadows.MarkStaticRendered(i);
+	}
+	int still_valid = 0;
+	for (int step = 1; step <= 10; ++step)
+	{
+		Vector3 moved_eye = eye + Vector3(1e-4f * step, 0.0f, 0.0f);
+		shadows.Update(sht::math::LookAt(moved_eye, Vector3(0.0f) + Vector3(1e-4f * step, 0.0f, 0.0f)),
+			kFov, kAspect, kNear, kFar, light_direction);
+		still_valid += shadows.cascade(kNumCascades - 1).static_valid ? 1 : 0;
+	}
+	printf("far cascade kept static casters in %d of 10 frames\n", still_valid);
+	CHECK(still_valid >= 8);
+	shadows.Update(sht::math::LookAt(eye + Vector3(5.0f, 0.0f, 0.0f), Vector3(5.0f, 0.0f, 0.0f)),
+		kFov, kAspect, kNear, kFar, light_direction);
+	for (int i = 0; i < kNumCascades; ++i)
+		CHECK(!shadows.cascade(i).static_valid);
+	shadows.Update(view, kFov, kAspect, kNear, kFar, light_direction);
+	shadows.MarkStaticRendered(0);
+	CHECK(shadows.cascade(0).static_valid);
+	shadows.InvalidateStatic();
+	CHECK(!shadows.cascade(0).static_valid);
+
+	// Caster culling in light space
+	const CascadedShadows::Cascade& nearest = shadows.cascade(0);
+	const Matrix4 light_world = nearest.view.GetInverse();
+	std::vector<BoundingBox> boxes;
+	// 0: at the cascade center
+	boxes.push_back(MakeBox(light_world.TransformPoint(nearest.center), 0.1f));
+	// 1: between light and cascade, beyond the depth range but throws shadow into it
+	boxes.push_back(MakeBox(light_world.TransformPoint(nearest.center) - light_direction * (nearest.radius + 100.0f), 0.1f));
+	// 2: beside the cascade
+	boxes.push_back(MakeBox(light_world.TransformPoint(nearest.center + Vector3(3.0f * nearest.radius, 0.0f, 0.0f)), 0.1f));
+	// 3: behind the cascade, its shadow falls further away
+	boxes.push_back(MakeBox(light_world.TransformPoint(nearest.center) + light_direction * (nearest.radius + 1.0f), 0.1f));
+	CHECK(nearest.frustum.IsBoxIn(boxes[0]));
+	CHECK(!nearest.frustum.IsBoxIn(boxes[1]));
+	CHECK(shadows.IsCasterVisible(0, boxes[1]));
+	CHECK(!shadows.IsCasterVisible(0, boxes[2]));
+	CHECK(!shadows.IsCasterVisible(0, boxes[3]));
+	std::vector<u32> visible;
+	CHECK(shadows.CullCasters(0, boxes.data(), static_cast<u32>(boxes.size()), &visible) == 2);
+	CHECK(visible.size() == 2 && visible[0] == 0 && visible[1] == 1);
+
+	// Straight down light, the default one, gives valid cascades too
+	CascadedShadows overhead(kNumCascades, kResolution);
+	overhead.Update(view, kFov, kAspect, kNear, kFar, Vector3(0.0f, -1.0f, 0.0f));
+	for (int i = 0; i < kNumCascades; ++i)
+	{
+		const Matrix4 shadow_matrix = overhead.GetShadowMatrix(i);
+		bool finite = true;
+		for (int e = 0; e < 16; ++e)
+			finite = finite && std::isfinite(shadow_matrix.sa[e]);
+		CHECK(finite);
+		Vector3 corners[8];
+		SliceCorners(view, overhead.cascade(i).split_near, overhead.cascade(i).split_far, corners);
+		for (int c = 0; c < 8; ++c)
+		{
+			Vector3 coord = shadow_matrix * corners[c];
+			CHECK(coord.x >= 0.0f && coord.x <= 1.0f && coord.y >= 0.0f && coord.y <= 1.0f);
+			CHECK(coord.z >= 0.0f && coord.z <= 1.0f);
+		}
+	}
+
+	// Casters per cascade for a grid of objects
+	std::vector<BoundingBox> grid;
+	for (int z = -20; z <= 20; ++z)
+		for (int x = -20; x <= 20; ++x)
+			grid.push_back(MakeBox(Vector3(x * 2.0f, 0.0f, z * 2.0f), 0.5f));
+	for (int i = 0; i < kNumCascades; ++i)
+		printf("cascade %d: %u of %u casters\n", i,
+			shadows.CullCasters(i, grid.data(), static_cast<u32>(grid.size()), &visible), static_cast<u32>(grid.size()));
+
+	if (g_failures == 0)
+		printf("All checks passed\n");
+	else
+		printf("%d checks failed\n", g_failures);
+	return g_failures == 0 ? 0 : 1;
+}
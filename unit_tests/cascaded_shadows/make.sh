@@ -0,0 +1,7 @@
+#!/bin/sh
+# Builds cascaded shadows test
+SHT=../../sht
+g++ main.cpp \
+	$SHT/math/*.cpp \
+	$SHT/graphics/src/renderer/cascaded_shadows.cpp \
+	-O2 -std=c++11 -I../../ -I$SHT -o cascaded_shadows
@@ -0,0 +1,120 @@
+#include "sht/graphics/include/renderer/null_context.h"
+
+#include <stdio.h>
+
+using sht::graphics::CullFaceType;
+
+/*
+Test for redundant state changes filtering in context.
+Simulates UI rendering where every widget sets blend and depth states.
+*/
+
+static int g_failures = 0;
+
+#define CHECK(condition) \
+	do { if (!(condition)) { printf("  FAILED: %s (line %d)\n", #condition, __LINE__); ++g_failures; } } while (0)
+
+//! Context that counts calls reaching the API
+class RecordingContext : public sht::graphics::NullContext {
+public:
+	RecordingContext()
+	: num_api_calls(0), num_index_binds(0), bound_program(0)
+	{
+	}
+
+	int num_api_calls;
+	int num_index_binds;
+	u32 bound_program;
+
+protected:
+	void ApiEnableBlend() { ++num_api_calls; }
+	void ApiDisableBlend() { ++num_api_calls; }
+	void ApiEnableDepthTest() { ++num_api_calls; }
+	void ApiDisableDepthTest() { ++num_api_calls; }
+	void ApiEnableDepthWrite() { ++num_api_calls; }
+	void ApiDisableDepthWrite() { ++num_api_calls; }
+	void ApiCullFace(CullFaceType mode) { ++num_api_calls; }
+	void ApiViewport(int w, int h) { ++num_api_calls; }
+	void ApiBindVertexArrayObject(u32 obj) { ++num_api_calls; }
+	void ApiBindVertexBuffer(u32 obj) { ++num_api_calls; }
+	void ApiBindIndexBuffer(u32 obj) { ++num_api_calls; ++num_index_binds; }
+	void ApiBindProgram(u32 program) { ++num_api_calls; bound_program = program; }
+};
+
+//! Each widget sets its states and doesn't know what previous one has set
+static void RenderWidgets(RecordingContext * context, u32 program, int num_widgets)
+{
+	for (int i = 0; i < num_widgets; ++i)
+	{
+		context->BindProgram(program);
+		context->EnableBlend();
+		context->DisableDepthTest();
+		context->DisableDepthWrite();
+		context->BindVertexBuffer(1 + (i & 1));
+	}
+	context->EnableDepthTest();
+	context->EnableDepthWrite();
+	context->DisableBlend();
+}
+
+int main()
+{
+	RecordingContext context;
+	const int kNumWidgets = 200;
+
+	// First frame issues every state once per change
+	context.Viewport(800, 600);
+	context.CullFace(CullFaceType::kBack);
+	RenderWidgets(&context, 7, kNumWidgets);
+	context.NewFrame();
+	const int total_calls = 2 + kNumWidgets * 5 + 3;
+	// Viewport, cull face, program, blend, depth test, depth write, buffer per widget and restore
+	const int expected_issued = 2 + 4 + kNumWidgets + 3;
+	CHECK(context.num_api_calls == expected_issued);
+	CHECK((int)context.state_counters().issued == expected_issued);
+	CHECK((int)context.state_counters().filtered == total_calls - expected_issued);
+	printf("%d state calls, %d issued, %d filtered\n", total_calls,
+		context.state_counters().issued, context.state_counters().filtered);
+
+	// Counters are per frame
+	context.num_api_calls = 0;
+	context.Viewport(800, 600);
+	context.NewFrame();
+	CHECK(context.num_api_calls == 0);
+	CHECK(context.state_counters().issued == 0 && context.state_counters().filtered == 1);
+
+	// State changed outside of context
+	context.InvalidateState();
+	context.BindProgram(7);
+	context.EnableDepthTest();
+	CHECK(context.num_api_calls == 2);
+
+	// Index buffer binding belongs to vertex array object
+	context.BindVertexArrayObject(3);
+	context.BindIndexBuffer(5);
+	context.BindIndexBuffer(5);
+	CHECK(context.num_index_binds == 1);
+	context.BindVertexArrayObject(4);
+	context.BindIndexBuffer(5);
+	CHECK(context.num_index_binds == 2);
+
+	// Deleted bound objects are unbound
+	u32 buffer = 5;
+	context.DeleteIndexBuffer(buffer);
+	context.BindIndexBuffer(0);
+	CHECK(context.num_index_binds == 2);
+
+	// Program name may be reused after deletion
+	context.DeleteProgram(7);
+	context.BindProgram(7);
+	CHECK(context.bound_program == 7);
+	const int calls = context.num_api_calls;
+	context.BindProgram(7);
+	CHECK(context.num_api_calls == calls);
+
+	if (g_failures)
+		printf("%d checks failed\n", g_failures);
+	else
+		printf("All checks passed\n");
+	return g_failures ? 1 : 0;
+}
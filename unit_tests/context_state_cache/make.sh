@@ -0,0 +1,7 @@
+#!/bin/sh
+# Builds context state cache test
+SHT=../../sht
+g++ main.cpp \
+	$SHT/graphics/src/renderer/context.cpp \
+	$SHT/graphics/src/renderer/null_context.cpp \
+	-O2 -std=c++11 -I../../ -I$SHT -o context_state_cache
@@ -0,0 +1,102 @@
+#include "gl_stubs.h"
+
+#include <stddef.h>
+
+/*
+Stubbed OpenGL entry points used by OpenGlContext.
+Draw related functions count calls, the rest do nothing.
+*/
+
+GlCalls g_gl_calls;
+
+extern "C" {
+
+void glActiveTexture() {}
+void glBindAttribLocation() {}
+void glBindBuffer() {}
+void glBindBufferBase() {}
+void glBindTexture() {}
+void glBindVertexArray(unsigned int array)
+{
+	++g_gl_calls.vertex_array_binds;
+}
+void glBufferData(unsigned int target, ptrdiff_t size, const void * data, unsigned int usage)
+{
+	++g_gl_calls.buffer_uploads;
+	g_gl_calls.last_usage = usage;
+}
+void glBufferSubData() {}
+unsigned int glCheckFramebufferStatusEXT() { return 0; }
+void glClear() {}
+void glClearColor() {}
+void glClearStencil() {}
+unsigned int glClientWaitSync() { return 0x911A; } // GL_ALREADY_SIGNALED
+void glCullFace() {}
+void glDeleteBuffers() {}
+void glDeleteProgram() {}
+void glDeleteSync() {}
+void glDeleteTextures() {}
+void glDeleteVertexArrays() {}
+void glDepthMask() {}
+void glDisable() {}
+void glDrawArrays(unsigned int mode, int first, int count)
+{
+	++g_gl_calls.draws;
+	g_gl_calls.last_mode = mode;
+}
+void glDrawArraysInstanced() {}
+void glDrawElements(unsigned int mode, int count, unsigned int type, const void * indices)
+{
+	++g_gl_calls.draws;
+	g_gl_calls.last_mode = mode;
+	g_gl_calls.last_type = type;
+}
+void glDrawElementsBaseVertex() {}
+void glDrawElementsInstanced() {}
+void glEnable() {}
+void glEnableVertexAttribArray() {}
+void * glFenceSync() { return 0; }
+void glGenBuffers() {}
+void glGenVertexArrays() {}
+void glGenerateMipmap() {}
+void glGetActiveUniform() {}
+int glGetAttribLocation() { return -1; }
+unsigned int glGetError() { return 0; }
+void glGetProgramiv() {}
+void glGetTexImage() {}
+unsigned int glGetUniformBlockIndex() { return 0xFFFFFFFFu; }
+int glGetUniformLocation() { return -1; }
+void * glMapBuffer() { return 0; }
+void * glMapBufferRange() { return 0; }
+void glMultiDrawElementsBaseVertex() {}
+void glPolygonMode() {}
+void glStencilMask() {}
+void glTexImage2D() {}
+void glTexSubImage2D() {}
+void glUniform1f() {}
+void glUniform1fv() {}
+void glUniform1i() {}
+void glUniform2f() {}
+void glUniform2fv() {}
+void glUniform2i() {}
+void glUniform3f() {}
+void glUniform3fv() {}
+void glUniform3i() {}
+void glUniform4f() {}
+void glUniform4fv() {}
+void glUniform4i() {}
+void glUniformBlockBinding() {}
+void glUniformMatrix2fv() {}
+void glUniformMatrix3fv() {}
+void glUniformMatrix4fv() {}
+unsigned char glUnmapBuffer() { return 1; }
+void glUseProgram() {}
+void glVertexAttribDivisor() {}
+void glVertexAttribPointer(unsigned int index, int size, unsigned int type, unsigned char normalized, int stride, const void * pointer)
+{
+	++g_gl_calls.attrib_pointers;
+	g_gl_calls.last_type = type;
+}
+void glViewport() {}
+
+} // extern "C"
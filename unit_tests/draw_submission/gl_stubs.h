@@ -0,0 +1,18 @@
+#pragma once
+#ifndef __SHT_UNIT_TESTS_GL_STUBS_H__
+#define __SHT_UNIT_TESTS_GL_STUBS_H__
+
+//! Counters of stubbed API calls
+struct GlCalls {
+	unsigned long draws;
+	unsigned long attrib_pointers;
+	unsigned long buffer_uploads;
+	unsigned long vertex_array_binds;
+	unsigned int last_mode;		//!< primitive type of the last draw
+	unsigned int last_type;		//!< data type of the last draw or attribute
+	unsigned int last_usage;	//!< usage of the last buffer upload
+};
+
+extern GlCalls g_gl_calls;
+
+#endif
@@ -0,0 +1,139 @@
+#include "sht/graphics/include/renderer/opengl/opengl_context.h"
+#include "sht/common/table.h"
+#include "gl_stubs.h"
+
+#include <stdio.h>
+#include <chrono>
+
+using sht::graphics::BufferUsage;
+using sht::graphics::DataType;
+using sht::graphics::PrimitiveType;
+
+/*
+Micro-benchmark of draw call submission overhead through OpenGlContext.
+OpenGL is stubbed, so measured time is spent in context itself: virtual calls,
+enum translation and state filtering.
+*/
+
+static int g_failures = 0;
+
+#define CHECK(condition) \
+	do { if (!(condition)) { printf("  FAILED: %s (line %d)\n", #condition, __LINE__); ++g_failures; } } while (0)
+
+static_assert(EnumArray<PrimitiveType, u32>::size() == static_cast<size_t>(PrimitiveType::kCount), "table size");
+static_assert(EnumArray<BufferUsage, u32>::size() == static_cast<size_t>(BufferUsage::kCount), "table size");
+
+const int kNumCalls = 4000000;
+const int kNumKeys = 1024;
+
+//! Prints time per call of the scope
+class ScopeTimer {
+public:
+	ScopeTimer(const char * name, int num_calls)
+	: name_(name)
+	, num_calls_(num_calls)
+	, start_(std::chrono::steady_clock::now())
+	{
+	}
+	~ScopeTimer()
+	{
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_).count();
+		printf("  %-32s %8.2f ns/call\n", name_, seconds * 1e9 / static_cast<double>(num_calls_));
+	}
+
+private:
+	const char * name_;
+	int num_calls_;
+	std::chrono::steady_clock::time_point start_;
+};
+
+static void BenchmarkLookups(const PrimitiveType * keys)
+{
+	EnumTable<PrimitiveType, u32> table;
+	EnumArray<PrimitiveType, u32> array;
+	for (int i = 0; i < static_cast<int>(PrimitiveType::kCount); ++i)
+	{
+		table[static_cast<PrimitiveType>(i)] = static_cast<u32>(i + 1);
+		array[static_cast<PrimitiveType>(i)] = static_cast<u32>(i + 1);
+	}
+	volatile u32 sink = 0;
+	u32 table_sum = 0, array_sum = 0;
+	printf("enum lookups:\n");
+	{
+		ScopeTimer timer("EnumTable", kNumCalls);
+		for (int i = 0; i < kNumCalls; ++i)
+			table_sum += table[keys[i & (kNumKeys - 1)]];
+		sink = table_sum;
+	}
+	{
+		ScopeTimer timer("EnumArray", kNumCalls);
+		for (int i = 0; i < kNumCalls; ++i)
+			array_sum += array[keys[i & (kNumKeys - 1)]];
+		sink = array_sum;
+	}
+	(void)sink;
+	CHECK(table_sum == array_sum);
+}
+
+int main()
+{
+	PrimitiveType keys[kNumKeys];
+	for (int i = 0; i < kNumKeys; ++i)
+		keys[i] = static_cast<PrimitiveType>((i * 7 + 3) % static_cast<int>(PrimitiveType::kCount));
+
+	BenchmarkLookups(keys);
+
+	sht::graphics::OpenGlContext context;
+	sht::graphics::Context * base = &context;
+	printf("context calls:\n");
+	{
+		ScopeTimer timer("DrawElements", kNumCalls);
+		for (int i = 0; i < kNumCalls; ++i)
+			base->DrawElements(keys[i & (kNumKeys - 1)], 36, DataType::kUnsignedShort);
+	}
+	{
+		ScopeTimer timer("VertexAttribPointer", kNumCalls);
+		for (int i = 0; i < kNumCalls; ++i)
+			base->VertexAttribPointer(i & 7, 3, DataType::kFloat, 32, nullptr);
+	}
+	{
+		ScopeTimer timer("VertexBufferData", kNumCalls);
+		for (int i = 0; i < kNumCalls; ++i)
+			base->VertexBufferData(64, nullptr, BufferUsage::kStreamDraw);
+	}
+	{
+		// Typical submission: objects sorted by mesh, so vertex array changes every 16 draws
+		ScopeTimer timer("BindVertexArray + DrawElements", kNumCalls);
+		for (int i = 0; i < kNumCalls; ++i)
+		{
+			base->BindVertexArrayObject(1 + (i >> 4));
+			base->DrawElements(PrimitiveType::kTriangles, 36, DataType::kUnsignedInt);
+		}
+	}
+
+	CHECK(g_gl_calls.draws == 2UL * kNumCalls);
+	CHECK(g_gl_calls.attrib_pointers == static_cast<unsigned long>(kNumCalls));
+	CHECK(g_gl_calls.buffer_uploads == static_cast<unsigned long>(kNumCalls));
+	CHECK(g_gl_calls.vertex_array_binds == static_cast<unsigned long>(kNumCalls / 16));
+
+	// Tables translate enums into API values
+	base->DrawArrays(PrimitiveType::kLineStrip, 0, 2);
+	CHECK(g_gl_calls.last_mode == 0x0003); // GL_LINE_STRIP
+	base->DrawElements(PrimitiveType::kTriangleStrip, 4, DataType::kUnsignedShort);
+	CHECK(g_gl_calls.last_mode == 0x0005); // GL_TRIANGLE_STRIP
+	CHECK(g_gl_calls.last_type == 0x1403); // GL_UNSIGNED_SHORT
+	base->VertexAttribPointer(0, 3, DataType::kFloat, 12, nullptr);
+	CHECK(g_gl_calls.last_type == 0x1406); // GL_FLOAT
+	base->VertexBufferData(16, nullptr, BufferUsage::kStaticDraw);
+	CHECK(g_gl_calls.last_usage == 0x88E4); // GL_STATIC_DRAW
+	base->VertexBufferData(16, nullptr, BufferUsage::kStreamCopy);
+	CHECK(g_gl_calls.last_usage == 0x88E2); // GL_STREAM_COPY
+	base->VertexBufferData(16, nullptr, BufferUsage::kDynamicRead);
+	CHECK(g_gl_calls.last_usage == 0x88E9); // GL_DYNAMIC_READ
+
+	if (g_failures)
+		printf("%d checks failed\n", g_failures);
+	else
+		printf("All checks passed\n");
+	return g_failures ? 1 : 0;
+}
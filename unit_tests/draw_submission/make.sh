@@ -0,0 +1,7 @@
+#!/bin/sh
+# Builds draw submission benchmark, OpenGL headers are needed (macOS) but functions are stubbed
+SHT=../../sht
+g++ main.cpp gl_stubs.cpp \
+	$SHT/graphics/src/renderer/context.cpp \
+	$SHT/graphics/src/renderer/opengl/opengl_context.cpp \
+	-O2 -std=c++11 -I../../ -I$SHT -o draw_submission
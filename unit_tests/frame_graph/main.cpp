@@ -0,0 +1,225 @@
+#include "sht/graphics/include/renderer/null_context.h"
+#include "sht/graphics/include/renderer/frame_graph.h"
+
+#include <stdio.h>
+#include <set>
+#include <vector>
+
+using sht::graphics::FrameGraph;
+using sht::graphics::Image;
+using sht::graphics::RenderTargetDesc;
+using sht::graphics::RenderTargetPool;
+using sht::graphics::Texture;
+
+/*
+Test for frame graph and render target pool.
+Graph of a deferred frame is compiled to check culling, lifetimes and aliasing,
+then executed over a few frames to check that pooled targets are reused and expire.
+*/
+
+static int g_failures = 0;
+
+#define CHECK(condition) \
+	do { if (!(condition)) { printf("  FAILED: %s (line %d)\n", #condition, __LINE__); ++g_failures; } } while (0)
+
+const int kWidth = 640;
+const int kHeight = 480;
+
+class FakeTexture : public Texture {
+public:
+	FakeTexture(u32 id, int w, int h, Image::Format fmt)
+	{
+		width_ = w;
+		height_ = h;
+		format_ = fmt;
+		texture_id_ = id;
+		ChooseTarget();
+	}
+	~FakeTexture()
+	{
+	}
+	u32 GetSrcFormat() { return 0x1908; }
+	u32 GetSrcType() { return 0x1401; }
+	s32 GetInternalFormat() { return 0x8058; }
+
+protected:
+	void ChooseTarget() { target_ = 0x0DE1; }
+};
+
+//! Creates textures with ids from null context and keeps track of live ones
+class TextureFactory {
+public:
+	RenderTargetPool::CreateFunction create_function()
+	{
+		return [this](const RenderTargetDesc& desc) -> Texture*
+		{
+			FakeTexture * texture = new FakeTexture(context.GenObjectId(), desc.width, desc.height, desc.format);
+			live.insert(texture);
+			return texture;
+		};
+	}
+	RenderTargetPool::DeleteFunction delete_function()
+	{
+		return [this](Texture * texture)
+		{
+			live.erase(texture);
+			delete static_cast<FakeTexture*>(texture);
+		};
+	}
+
+	sht::graphics::NullContext context;
+	std::set<Texture*> live;
+};
+
+struct Targets {
+	FrameGraph::ResourceId shadow_map;
+	FrameGraph::ResourceId albedo;
+	FrameGraph::ResourceId depth;
+	FrameGraph::ResourceId hdr;
+	FrameGraph::ResourceId bloom;
+	FrameGraph::ResourceId debug;
+	FrameGraph::ResourceId backbuffer;
+	FrameGraph::PassId debug_pass;
+};
+
+//! Builds graph of deferred frame, every pass records textures it sees
+Targets BuildGraph(FrameGraph& graph, Texture * backbuffer, std::vector<std::vector<Texture*> > * seen)
+{
+	const RenderTargetDesc color(kWidth, kHeight, Image::Format::kRGBA8);
+	Targets t;
+	t.shadow_map = graph.CreateTarget("shadow_map", RenderTargetDesc(1024, 1024, Image::Format::kDepth24));
+	t.albedo = graph.CreateTarget("albedo", color);
+	t.depth = graph.CreateTarget("depth", RenderTargetDesc(kWidth, kHeight, Image::Format::kDepth24));
+	t.hdr = graph.CreateTarget("hdr", RenderTargetDesc(kWidth, kHeight, Image::Format::kRGBA16));
+	t.bloom = graph.CreateTarget("bloom", color);
+	t.debug = graph.CreateTarget("debug", color);
+	t.backbuffer = graph.ImportTarget("backbuffer", backbuffer);
+
+	seen->assign(6, std::vector<Texture*>());
+	auto record = [seen](u32 pass, std::vector<FrameGraph::ResourceId> ids)
+	{
+		return [seen, pass, ids](FrameGraph& g)
+		{
+			for (auto id : ids)
+				(*seen)[pass].push_back(g.GetTexture(id));
+		};
+	};
+	FrameGraph::PassId pass;
+	pass = graph.AddPass("shadows", record(0, { t.shadow_map }));
+	graph.Write(pass, t.shadow_map);
+	pass = graph.AddPass("gbuffer", record(1, { t.albedo, t.depth }));
+	graph.Write(pass, t.albedo);
+	graph.Write(pass, t.depth);
+	pass = graph.AddPass("lighting", record(2, { t.albedo, t.depth, t.shadow_map, t.hdr }));
+	graph.Read(pass, t.albedo);
+	graph.Read(pass, t.depth);
+	graph.Read(pass, t.shadow_map);
+	graph.Write(pass, t.hdr);
+	pass = graph.AddPass("bloom", record(3, { t.hdr, t.bloom }));
+	graph.Read(pass, t.hdr);
+	graph.Write(pass, t.bloom);
+	pass = graph.AddPass("tonemap", record(4, { t.hdr, t.bloom, t.backbuffer }));
+	graph.Read(pass, t.hdr);
+	graph.Read(pass, t.bloom);
+	graph.Write(pass, t.backbuffer);
+	// Nobody reads debug output
+	t.debug_pass = graph.AddPass("debug", record(5, { t.debug }));
+	graph.Read(t.debug_pass, t.depth);
+	graph.Write(t.debug_pass, t.debug);
+	return t;
+}
+
+int main()
+{
+	TextureFactory factory;
+	RenderTargetPool pool(factory.create_function(), factory.delete_function());
+	FakeTexture backbuffer(1, kWidth, kHeight, Image::Format::kRGBA8);
+	FrameGraph graph;
+	std::vector<std::vector<Texture*> > seen;
+
+	// Compilation
+	Targets t = BuildGraph(graph, &backbuffer, &seen);
+	CHECK(graph.Compile());
+	CHECK(graph.num_passes() == 6);
+	CHECK(graph.num_resources() == 7);
+	CHECK(graph.pass_culled(t.debug_pass));
+	for (u32 i = 0; i < 5; ++i)
+		CHECK(!graph.pass_culled(i));
+	CHECK(graph.first_use(t.albedo) == 1 && graph.last_use(t.albedo) == 2);
+	CHECK(graph.first_use(t.depth) == 1 && graph.last_use(t.depth) == 2);
+	CHECK(graph.first_use(t.hdr) == 2 && graph.last_use(t.hdr) == 4);
+	CHECK(graph.first_use(t.bloom) == 3 && graph.last_use(t.bloom) == 4);
+	CHECK(graph.first_use(t.debug) == FrameGraph::kInvalidIndex);
+	CHECK(graph.physical_index(t.debug) == FrameGraph::kInvalidIndex);
+	CHECK(graph.physical_index(t.backbuffer) == FrameGraph::kInvalidIndex);
+	// Bloom starts after albedo is dead and takes its memory
+	CHECK(graph.physical_index(t.albedo) == graph.physical_index(t.bloom));
+	CHECK(graph.physical_index(t.albedo) != graph.physical_index(t.depth));
+	CHECK(graph.num_physical_targets() == 4);
+	printf("%u passes, %u targets, %u physical targets\n",
+		graph.num_passes(), graph.num_resources(), graph.num_physical_targets());
+
+	// Execution
+	graph.Execute(&pool);
+	CHECK(seen[5].empty());
+	CHECK(seen[2].size() == 4);
+	std::set<Texture*> lighting(seen[2].begin(), seen[2].end());
+	CHECK(lighting.size() == 4 && lighting.count(nullptr) == 0);
+	CHECK(seen[1][0] == seen[2][0]);	// albedo
+	CHECK(seen[3][1] == seen[1][0]);	// bloom aliases albedo
+	CHECK(seen[4][2] == &backbuffer);
+	CHECK(pool.stats().created == 4);
+	CHECK(pool.num_targets() == 4);
+	CHECK(pool.num_free_targets() == 4);
+	CHECK(factory.live.size() == 4);
+	CHECK(graph.GetTexture(t.hdr) == nullptr);	// released after the last use
+	const u32 expected_bytes = 1024 * 1024 * 3 + kWidth * kHeight * (4 + 3 + 8);
+	CHECK(pool.used_bytes() == expected_bytes);
+	pool.EndFrame();
+
+	// Graph is rebuilt next frame and gets the same targets
+	graph.Clear();
+	t = BuildGraph(graph, &backbuffer, &seen);
+	CHECK(graph.Compile());
+	graph.Execute(&pool);
+	CHECK(pool.stats().created == 4);
+	CHECK(pool.stats().reused == 4);
+	CHECK(std::set<Texture*>(seen[2].begin(), seen[2].end()) == lighting);
+	pool.EndFrame();
+
+	// Pool serves by description, sample count is a part of it
+	Texture * msaa = pool.Acquire(RenderTargetDesc(kWidth, kHeight, Image::Format::kRGBA8, 4));
+	Texture * plain = pool.Acquire(RenderTargetDesc(kWidth, kHeight, Image::Format::kRGBA8));
+	CHECK(msaa != plain);
+	CHECK(pool.stats().created == 5);
+	CHECK(pool.stats().reused == 5);
+	pool.Release(plain);
+	pool.Release(msaa);
+
+	// Unused targets expire
+	pool.set_max_unused_frames(2);
+	for (int i = 0; i < 3; ++i)
+		pool.EndFrame();
+	CHECK(pool.num_targets() == 0);
+	CHECK(pool.stats().destroyed == 5);
+	CHECK(factory.live.empty());
+
+	// Reading target nobody has written is an error
+	graph.Clear();
+	FrameGraph::ResourceId orphan = graph.CreateTarget("orphan", RenderTargetDesc(64, 64, Image::Format::kR8));
+	FrameGraph::ResourceId output = graph.ImportTarget("output", &backbuffer);
+	FrameGraph::PassId pass = graph.AddPass("broken", FrameGraph::ExecuteFunction());
+	graph.Read(pass, orphan);
+	graph.Write(pass, output);
+	CHECK(!graph.Compile());
+	CHECK(!graph.error().empty());
+	printf("expected error: %s\n", graph.error().c_str());
+
+	pool.Clear();
+
+	if (g_failures == 0)
+		printf("All checks passed\n");
+	else
+		printf("%d checks failed\n", g_failures);
+	return g_failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,10 @@
+#!/bin/sh
+# Builds frame graph test
+SHT=../../sht
+g++ main.cpp \
+	$SHT/graphics/src/renderer/context.cpp \
+	$SHT/graphics/src/renderer/null_context.cpp \
+	$SHT/graphics/src/renderer/texture.cpp \
+	$SHT/graphics/src/renderer/render_target_pool.cpp \
+	$SHT/graphics/src/renderer/frame_graph.cpp \
+	-O2 -std=c++11 -I../../ -I$SHT -o frame_graph
@@ -0,0 +1,157 @@
+#include "sht/application/headless/headless_application.h"
+#include "sht/graphics/include/renderer/recording_context.h"
+
+#include <stdio.h>
+
+using sht::graphics::BufferUsage;
+using sht::graphics::PrimitiveType;
+using sht::graphics::RecordingContext;
+
+/*
+Test for headless application.
+Application is linked with headless platform layer, frames go through null renderer into
+recording context, so the main loop order and frame statistics are checked without window.
+*/
+
+static int g_failures = 0;
+
+#define CHECK(condition) \
+	do { if (!(condition)) { printf("  FAILED: %s (line %d)\n", #condition, __LINE__); ++g_failures; } } while (0)
+
+const int kNumFrames = 5;
+
+class TestApp : public sht::HeadlessApplication {
+public:
+	TestApp()
+	: vertex_buffer_(nullptr)
+	, num_renders_(0)
+	, num_updates_(0)
+	, num_physics_updates_(0)
+	, physics_time_(0.0f)
+	, loaded_(false)
+	, unloaded_(false)
+	{
+	}
+	bool Load()
+	{
+		loaded_ = recording_context() != nullptr && renderer_ != nullptr;
+		float vertices[9] = { 0.0f };
+		renderer_->AddVertexBuffer(vertex_buffer_, sizeof(vertices), vertices, BufferUsage::kStaticDraw);
+		return vertex_buffer_ != nullptr;
+	}
+	void Unload()
+	{
+		if (vertex_buffer_)
+			renderer_->DeleteVertexBuffer(vertex_buffer_);
+		unloaded_ = true;
+	}
+	void Update()
+	{
+		++num_updates_;
+	}
+	void UpdatePhysics(float sec)
+	{
+		++num_physics_updates_;
+		physics_time_ += sec;
+	}
+	void Render()
+	{
+		++num_renders_;
+		renderer_->ClearColorAndDepthBuffers();
+		renderer_->context()->DrawArrays(PrimitiveType::kTriangles, 0, 3);
+		// Second frame draws twice
+		if (num_renders_ == 2)
+			renderer_->context()->DrawArrays(PrimitiveType::kTriangles, 0, 3);
+	}
+
+	sht::graphics::VertexBuffer * vertex_buffer_;
+	int num_renders_;
+	int num_updates_;
+	int num_physics_updates_;
+	float physics_time_;
+	bool loaded_;
+	bool unloaded_;
+};
+
+//! Keeps statistics of every finished frame
+class StatsApp : public TestApp {
+public:
+	StatsApp()
+	: num_frames_(0)
+	{
+	}
+	void Update()
+	{
+		TestApp::Update();
+		// Frame has been finished by EndFrame before update
+		RecordingContext * context = recording_context();
+		if (context->num_frames() > num_frames_ && num_frames_ < kNumFrames)
+			stats_[num_frames_++] = context->frame_stats(context->num_frames() - 1);
+	}
+
+	RecordingContext::FrameStats stats_[kNumFrames];
+	u32 num_frames_;
+};
+
+class FailingApp : public sht::HeadlessApplication {
+public:
+	bool Load() final
+	{
+		return false;
+	}
+};
+
+int main()
+{
+	// Frames are recorded
+	{
+		TestApp app;
+		CHECK(app.RunFrames(kNumFrames, 640, 480) == 0);
+		CHECK(sht::Application::GetInstance() == &app);
+		CHECK(app.loaded_ && app.unloaded_);
+		CHECK(app.width() == 640 && app.height() == 480);
+		CHECK(app.num_renders_ == kNumFrames);
+		CHECK(app.num_updates_ == kNumFrames);
+		CHECK(app.num_physics_updates_ == kNumFrames);
+		CHECK(app.physics_time_ > kNumFrames * app.GetFrameTime() * 0.99f);
+		CHECK(app.physics_time_ < kNumFrames * app.GetFrameTime() * 1.01f);
+		CHECK(app.elapsed_seconds() >= 0.0f);
+		CHECK(app.recording_context() == nullptr); // deleted with renderer
+	}
+
+	// Statistics of recorded frames
+	{
+		StatsApp app;
+		CHECK(app.RunFrames(kNumFrames) == 0);
+		CHECK(app.num_frames_ == (u32)kNumFrames);
+		if (app.num_frames_ == (u32)kNumFrames)
+		{
+			for (int i = 0; i < kNumFrames; ++i)
+			{
+				u32 draws = (i == 1) ? 2 : 1;
+				CHECK(app.stats_[i].draw_calls == draws);
+				CHECK(app.stats_[i].vertices == 3 * draws);
+				CHECK(app.stats_[i].commands > app.stats_[i].draw_calls);
+			}
+			// Vertex buffer uploaded on load is counted in the first frame
+			CHECK(app.stats_[0].uploaded_bytes == 9 * sizeof(float));
+			CHECK(app.stats_[1].uploaded_bytes == 0);
+			// Frames are the same except for the extra draw
+			CHECK(app.stats_[3].commands == app.stats_[2].commands);
+			CHECK(app.stats_[1].commands == app.stats_[2].commands + 1);
+		}
+	}
+
+	// Failed load
+	{
+		FailingApp app;
+		CHECK(app.RunFrames(kNumFrames) == 3);
+		CHECK(app.recording_context() == nullptr);
+	}
+
+	if (g_failures == 0)
+		printf("All checks passed\n");
+	else
+		printf("%d checks failed\n", g_failures);
+	return g_failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,58 @@
+#!/bin/sh
+# Builds headless application test with headless platform layer instead of the windowed one
+# together with bundled codec and font libraries
+SHT=../../sht
+THIRDPARTY=$SHT/thirdparty
+mkdir -p obj
+for f in $(sed -n 's/.*LIB_PATH)\/\([a-z0-9_]*\.c\).*/\1/p' $THIRDPARTY/libjpeg/sources.mk); do
+	gcc -O2 -c $THIRDPARTY/libjpeg/src/$f -I$THIRDPARTY/libjpeg/include -I$THIRDPARTY/libjpeg/src -o obj/$f.o
+done
+for f in $(sed -n 's/.*LIB_PATH)\/\([a-z0-9_]*\.c\).*/\1/p' $THIRDPARTY/libpng/sources.mk); do
+	gcc -O2 -c $THIRDPARTY/libpng/src/$f -I$THIRDPARTY/libpng/include -I$THIRDPARTY/libpng/src -I$THIRDPARTY/zlib/include -DPNG_USER_WIDTH_MAX=16384 -DPNG_USER_HEIGHT_MAX=16384 -o obj/$f.o
+done
+for f in $THIRDPARTY/zlib/src/*.c; do
+	gcc -O2 -c $f -I$THIRDPARTY/zlib/include -I$THIRDPARTY/zlib/src -o obj/$(basename $f).o
+done
+for f in $(sed -n 's/.*LIB_PATH)\/\([a-z0-9_]*\/[a-z0-9_]*\.c\).*/\1/p' $THIRDPARTY/freetype/sources.mk); do
+	gcc -O2 -c $THIRDPARTY/freetype/src/$f -I$THIRDPARTY/freetype/include -DFT2_BUILD_LIBRARY -o obj/$(basename $f).o
+done
+g++ main.cpp \
+	$SHT/application/application.cpp \
+	$SHT/application/headless/headless_application.cpp \
+	$SHT/platform/src/main_wrapper.cpp \
+	$SHT/platform/src/headless/window_controller.cpp \
+	$SHT/graphics/src/renderer/context.cpp \
+	$SHT/graphics/src/renderer/cubemap_face_filler.cpp \
+	$SHT/graphics/src/renderer/font.cpp \
+	$SHT/graphics/src/renderer/index_buffer.cpp \
+	$SHT/graphics/src/renderer/null_context.cpp \
+	$SHT/graphics/src/renderer/null_renderer.cpp \
+	$SHT/graphics/src/renderer/recording_context.cpp \
+	$SHT/graphics/src/renderer/render_target_pool.cpp \
+	$SHT/graphics/src/renderer/renderer.cpp \
+	$SHT/graphics/src/renderer/residency_manager.cpp \
+	$SHT/graphics/src/renderer/ring_buffer.cpp \
+	$SHT/graphics/src/renderer/screenshot_queue.cpp \
+	$SHT/graphics/src/renderer/shader.cpp \
+	$SHT/graphics/src/renderer/shader_binary_cache.cpp \
+	$SHT/graphics/src/renderer/shader_preprocessor.cpp \
+	$SHT/graphics/src/renderer/texture.cpp \
+	$SHT/graphics/src/renderer/texture_upload_queue.cpp \
+	$SHT/graphics/src/renderer/vertex_buffer.cpp \
+	$SHT/graphics/src/renderer/vertex_format.cpp \
+	$SHT/graphics/src/renderer/vertex_packing.cpp \
+	$SHT/graphics/src/renderer/video_memory_buffer.cpp \
+	$SHT/graphics/src/image/*.cpp \
+	$SHT/system/src/keys.cpp \
+	$SHT/system/src/memory_leaks.cpp \
+	$SHT/system/src/mouse.cpp \
+	$SHT/system/src/filesystem/directory.cpp \
+	$SHT/system/src/stream/*.cpp \
+	$SHT/system/src/string/filename.cpp \
+	$SHT/system/src/tasks/*.cpp \
+	$SHT/system/src/time/*.cpp \
+	$SHT/utility/src/resource_manager.cpp \
+	$SHT/utility/src/string_id.cpp \
+	$SHT/math/*.cpp \
+	obj/*.o \
+	-O2 -std=c++11 -pthread -I../../ -I$SHT -I$THIRDPARTY/libjpeg/include -I$THIRDPARTY/libpng/include -I$THIRDPARTY/freetype/include -o headless_application
@@ -0,0 +1,475 @@
+#include "sht/graphics/include/image/image.h"
+#include "sht/graphics/include/image/normal_map_builder.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <atomic>
+#include <chrono>
+#include <new>
+#include <vector>
+
+using sht::graphics::Image;
+using sht::graphics::NormalMapBuilder;
+
+/*
+Benchmark and conformance test for image codecs and image operations.
+Reports throughput in MB/s of decoded data and number of C++ heap allocations
+(codec libraries allocate with malloc and aren't counted).
+*/
+
+static std::atomic<unsigned long> g_allocations(0);
+static std::atomic<unsigned long> g_allocated_bytes(0);
+
+void* operator new(size_t size)
+{
+	++g_allocations;
+	g_allocated_bytes += static_cast<unsigned long>(size);
+	void * ptr = malloc(size ? size : 1);
+	if (!ptr)
+		throw std::bad_alloc();
+	return ptr;
+}
+void* operator new[](size_t size)
+{
+	return operator new(size);
+}
+void operator delete(void* ptr) noexcept
+{
+	free(ptr);
+}
+void operator delete[](void* ptr) noexcept
+{
+	free(ptr);
+}
+
+static int g_failures = 0;
+static const char * kTempDir = "./";
+
+#define CHECK(condition) \
+	do { if (!(condition)) { printf("  FAILED: %s (line %d)\n", #condition, __LINE__); ++g_failures; } } while (0)
+
+//! Measures time and allocations of a scope
+class Measure {
+public:
+	explicit Measure(const char * name)
+	: name_(name)
+	, allocations_(g_allocations)
+	, bytes_(g_allocated_bytes)
+	, start_(std::chrono::steady_clock::now())
+	{
+	}
+	void Report(size_t processed_bytes, int iterations)
+	{
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_).count();
+		double megabytes = static_cast<double>(processed_bytes) * iterations / (1024.0 * 1024.0);
+		printf("  %-32s %8.1f MB/s %8.2f ms %6lu allocs %10lu bytes\n", name_,
+			(seconds > 0.0) ? megabytes / seconds : 0.0,
+			seconds * 1000.0 / iterations,
+			(g_allocations - allocations_) / iterations,
+			(g_allocated_bytes - bytes_) / iterations);
+	}
+private:
+	const char * name_;
+	unsigned long allocations_;
+	unsigned long bytes_;
+	std::chrono::steady_clock::time_point start_;
+};
+
+static size_t ImageSize(const Image& image)
+{
+	return static_cast<size_t>(image.width() * image.height() * image.bpp());
+}
+static double Psnr(const Image& a, const Image& b)
+{
+	if (a.width() != b.width() || a.height() != b.height() || a.bpp() != b.bpp())
+		return 0.0;
+	const size_t size = ImageSize(a);
+	double sum = 0.0;
+	for (size_t i = 0; i < size; ++i)
+	{
+		double diff = static_cast<double>(a.pixels()[i]) - static_cast<double>(b.pixels()[i]);
+		sum += diff * diff;
+	}
+	if (sum == 0.0)
+		return 1000.0; // identical
+	double mse = sum / static_cast<double>(size);
+	return 10.0 * log10(255.0 * 255.0 / mse);
+}
+static bool PixelsEqual(const Image& a, const Image& b)
+{
+	return a.width() == b.width() && a.height() == b.height() && a.bpp() == b.bpp() &&
+		memcmp(a.pixels(), b.pixels(), ImageSize(a)) == 0;
+}
+static bool ReadFile(const char * filename, std::vector<u8> * data)
+{
+	FILE * file = fopen(filename, "rb");
+	if (!file)
+		return false;
+	fseek(file, 0, SEEK_END);
+	long length = ftell(file);
+	fseek(file, 0, SEEK_SET);
+	data->resize(static_cast<size_t>(length));
+	bool result = fread(&(*data)[0], 1, data->size(), file) == data->size();
+	fclose(file);
+	return result;
+}
+//! Smooth pattern that lossy codecs are able to keep with high PSNR
+static void MakeTestImage(Image * image, int width, int height, Image::Format format)
+{
+	u8 * pixels = image->Allocate(width, height, format);
+	const int bpp = image->bpp();
+	for (int y = 0; y < height; ++y)
+		for (int x = 0; x < width; ++x)
+		{
+			u8 * pixel = pixels + (y * width + x) * bpp;
+			pixel[0] = static_cast<u8>(x * 255 / width);
+			pixel[1] = static_cast<u8>(y * 255 / height);
+			pixel[2] = static_cast<u8>(128.0f + 100.0f * sinf(x * 0.05f) * cosf(y * 0.07f));
+			if (bpp == 4)
+				pixel[3] = 255; // PNG loader expands to RGBA with opaque alpha
+		}
+}
+//! Writes uncompressed Radiance HDR file, returns source values as floats
+static bool WriteHdr(const char * filename, int width, int height, std::vector<float> * values)
+{
+	FILE * file = fopen(filename, "wb");
+	if (!file)
+		return false;
+	fprintf(file, "#?RADIANCE\nFORMAT=32-bit_rle_rgbe\n\n-Y %d +X %d\n", height, width);
+	values->resize(width * height * 3);
+	for (int y = 0; y < height; ++y)
+		for (int x = 0; x < width; ++x)
+		{
+			// Mantissa is at least 128, so flat scanlines aren't mistaken for RLE
+			u8 rgbe[4] = {
+				static_cast<u8>(128 + x % 128),
+				static_cast<u8>(128 + y % 128),
+				static_cast<u8>(200),
+				static_cast<u8>(128 + 1 + (x + y) % 4)
+			};
+			fwrite(rgbe, 1, 4, file);
+			float scale = ldexpf(1.0f, rgbe[3] - 128) / 256.0f;
+			float * value = &(*values)[(y * width + x) * 3];
+			value[0] = rgbe[0] * scale;
+			value[1] = rgbe[1] * scale;
+			value[2] = rgbe[2] * scale;
+		}
+	fclose(file);
+	return true;
+}
+
+//! Format support in current implementation, unsupported ones are skipped
+struct FormatInfo {
+	Image::FileFormat format;
+	const char * extension;
+	bool can_save;
+	bool can_load_file;
+	bool can_load_buffer;
+	bool lossless;
+};
+static const FormatInfo kFormats[] = {
+	{ Image::FileFormat::kBmp, "bmp", false, false, false, true },
+	{ Image::FileFormat::kJpg, "jpg", true, true, true, false },
+	{ Image::FileFormat::kPng, "png", true, true, true, true },
+	{ Image::FileFormat::kTga, "tga", false, false, false, true },
+	{ Image::FileFormat::kTif, "tif", false, false, false, true },
+	{ Image::FileFormat::kHdr, "hdr", false, true, false, false },
+};
+
+static void TestCodec(const FormatInfo& info, int iterations)
+{
+	printf("%s:\n", info.extension);
+	char filename[256];
+	sprintf(filename, "%scorpus.%s", kTempDir, info.extension);
+
+	if (info.format == Image::FileFormat::kHdr)
+	{
+		std::vector<float> values;
+		CHECK(WriteHdr(filename, 256, 128, &values));
+		Image image;
+		Measure measure("load file");
+		for (int i = 0; i < iterations; ++i)
+			CHECK(image.LoadFromFile(filename));
+		measure.Report(ImageSize(image), iterations);
+		CHECK(image.width() == 256 && image.height() == 128);
+		CHECK(image.data_type() == Image::DataType::kFloat);
+		const float * loaded = reinterpret_cast<const float*>(image.pixels());
+		float max_error = 0.0f;
+		for (size_t i = 0; i < values.size(); ++i)
+			max_error = fmaxf(max_error, fabsf(loaded[i] - values[i]));
+		CHECK(max_error < 1e-6f);
+		printf("  skipped: save and load from buffer (not implemented)\n");
+		return;
+	}
+	if (!info.can_save)
+	{
+		printf("  skipped: not implemented\n");
+		return;
+	}
+
+	// PNG is always loaded as RGBA
+	Image source;
+	MakeTestImage(&source, 1024, 768, info.lossless ? Image::Format::kRGBA8 : Image::Format::kRGB8);
+	{
+		Measure measure("save");
+		for (int i = 0; i < iterations; ++i)
+			CHECK(source.Save(filename));
+		measure.Report(ImageSize(source), iterations);
+	}
+
+	Image from_file;
+	{
+		Measure measure("load file");
+		for (int i = 0; i < iterations; ++i)
+			CHECK(from_file.LoadFromFile(filename));
+		measure.Report(ImageSize(from_file), iterations);
+	}
+	if (info.lossless)
+		CHECK(PixelsEqual(source, from_file));
+	else
+	{
+		double psnr = Psnr(source, from_file);
+		printf("  PSNR %.2f dB\n", psnr);
+		CHECK(psnr > 30.0);
+	}
+
+	std::vector<u8> data;
+	CHECK(ReadFile(filename, &data));
+	CHECK(Image::DetectFileFormat(&data[0], data.size()) == info.format);
+	Image from_buffer;
+	{
+		Measure measure("load buffer");
+		for (int i = 0; i < iterations; ++i)
+			CHECK(from_buffer.LoadFromBuffer(&data[0], data.size()));
+		measure.Report(ImageSize(from_buffer), iterations);
+	}
+	CHECK(PixelsEqual(from_file, from_buffer));
+
+	// Region decode should be pixel exact against crop of full image
+	Image::DecodeOptions region_options;
+	region_options.region_x = 100;
+	region_options.region_y = 50;
+	region_options.region_width = 256;
+	region_options.region_height = 128;
+	Image region;
+	{
+		Measure measure("load region 256x128");
+		for (int i = 0; i < iterations; ++i)
+			CHECK(region.LoadFromBuffer(&data[0], data.size(), region_options));
+		measure.Report(ImageSize(region), iterations);
+	}
+	CHECK(region.width() == 256 && region.height() == 128);
+	bool region_equal = true;
+	const int bpp = from_file.bpp();
+	for (int y = 0; y < region.height() && region_equal; ++y)
+	{
+		// Both images have inverted row order
+		const u8 * full_row = from_file.pixels() +
+			((from_file.height() - 1 - (y + 50)) * from_file.width() + 100) * bpp;
+		const u8 * region_row = region.pixels() + (region.height() - 1 - y) * region.width() * bpp;
+		region_equal = memcmp(full_row, region_row, region.width() * bpp) == 0;
+	}
+	CHECK(region_equal);
+
+	// Scaled decode into caller buffer, compared with bilinear rescale of full image
+	Image::DecodeOptions scale_options;
+	scale_options.target_width = 256;
+	scale_options.target_height = 192;
+	std::vector<u8> buffer(256 * 192 * 4);
+	scale_options.buffer = &buffer[0];
+	scale_options.buffer_size = buffer.size();
+	Image scaled;
+	{
+		Measure measure("load scaled 1/4");
+		for (int i = 0; i < iterations; ++i)
+			CHECK(scaled.LoadFromBuffer(&data[0], data.size(), scale_options));
+		measure.Report(ImageSize(scaled), iterations);
+	}
+	CHECK(scaled.width() == 256 && scaled.height() == 192);
+	CHECK(scaled.pixels() == &buffer[0]);
+	Image reference(from_file);
+	reference.Rescale(256, 192);
+	double psnr = Psnr(reference, scaled);
+	printf("  scaled PSNR %.2f dB\n", psnr);
+	CHECK(psnr > 28.0);
+}
+
+static void TestOperations(int iterations)
+{
+	printf("operations:\n");
+	Image source;
+	MakeTestImage(&source, 1000, 600, Image::Format::kRGB8);
+
+	// Rescale to the same size is a no-op, constant image stays constant
+	Image image(source);
+	{
+		Measure measure("Rescale 1000x600->512x512");
+		for (int i = 0; i < iterations; ++i)
+		{
+			image.Copy(source);
+			image.Rescale(512, 512);
+		}
+		measure.Report(ImageSize(source), iterations);
+	}
+	CHECK(image.width() == 512 && image.height() == 512);
+	Image constant;
+	u8 * pixels = constant.Allocate(33, 17, Image::Format::kRGB8);
+	memset(pixels, 77, 33 * 17 * 3);
+	Image resized(constant);
+	resized.Rescale(64, 8);
+	bool is_constant = true;
+	for (int i = 0; i < 64 * 8 * 3; ++i)
+		is_constant = is_constant && resized.pixels()[i] == 77;
+	CHECK(is_constant);
+	resized.Copy(constant);
+	resized.Rescale(33, 17);
+	CHECK(PixelsEqual(resized, constant));
+
+	{
+		Measure measure("MakePowerOfTwo 1000x600");
+		for (int i = 0; i < iterations; ++i)
+		{
+			image.Copy(source);
+			image.MakePowerOfTwo();
+		}
+		measure.Report(ImageSize(source), iterations);
+	}
+	CHECK(image.width() == 1024 && image.height() == 1024);
+
+	// Cross layout: +Y at (0,1), +Z +X -Z -X at row 2, -Y at (0,3)
+	Image faces[6];
+	for (int i = 0; i < 6; ++i)
+	{
+		u8 * face = faces[i].Allocate(64, 64, Image::Format::kRGB8);
+		memset(face, 10 + i * 40, 64 * 64 * 3);
+	}
+	Image cube;
+	{
+		Measure measure("CreateCube 6x64x64");
+		for (int i = 0; i < iterations; ++i)
+			Image::CreateCube(faces, &cube);
+		measure.Report(ImageSize(faces[0]) * 6, iterations);
+	}
+	CHECK(cube.width() == 256 && cube.height() == 256);
+	const int kCellX[6] = { 1, 3, 0, 0, 0, 2 };
+	const int kCellY[6] = { 2, 2, 1, 3, 2, 2 };
+	for (int i = 0; i < 6; ++i)
+	{
+		const u8 * pixel = cube.pixels() + ((kCellY[i] * 64 + 32) * 256 + kCellX[i] * 64 + 32) * 3;
+		CHECK(pixel[0] == 10 + i * 40);
+	}
+	CHECK(cube.pixels()[0] == 0); // unused cells are black
+}
+
+static void TestNormalMaps(int iterations)
+{
+	printf("normal maps:\n");
+	const int kSize = 1024;
+
+	// Flat height map gives straight up normals with any kernel
+	Image flat;
+	memset(flat.Allocate(64, 64, Image::Format::kR8), 100, 64 * 64);
+	const NormalMapBuilder::Kernel kKernels[3] = {
+		NormalMapBuilder::Kernel::kForward,
+		NormalMapBuilder::Kernel::kCentral,
+		NormalMapBuilder::Kernel::kSobel
+	};
+	for (int k = 0; k < 3; ++k)
+	{
+		NormalMapBuilder builder;
+		builder.set_kernel(kKernels[k]);
+		Image normals;
+		CHECK(builder.Build(flat, &normals));
+		bool straight = true;
+		for (int i = 0; i < 64 * 64; ++i)
+		{
+			const u8 * n = normals.pixels() + i * 3;
+			straight = straight && n[0] == 128 && n[1] == 128 && n[2] == 255;
+		}
+		CHECK(straight);
+	}
+
+	// Linear ramp along X without wrapping has constant slope in the interior
+	Image ramp;
+	float * heights = reinterpret_cast<float*>(ramp.Allocate(64, 64, Image::Format::kR32));
+	for (int y = 0; y < 64; ++y)
+		for (int x = 0; x < 64; ++x)
+			heights[y * 64 + x] = x * 0.01f;
+	for (int k = 0; k < 3; ++k)
+	{
+		NormalMapBuilder builder;
+		builder.set_kernel(kKernels[k]);
+		builder.set_strength(10.0f);
+		builder.set_wrap(false, false);
+		Image normals;
+		CHECK(builder.Build(ramp, &normals));
+		// Slope 0.1 gives normal (0, 0.1, 1) / |(0, 0.1, 1)|
+		const float inv_len = 1.0f / sqrtf(1.0f + 0.01f);
+		const u8 * n = normals.pixels() + (32 * 64 + 32) * 3;
+		CHECK(n[0] == 128);
+		CHECK(abs(n[1] - static_cast<int>(128.0f + 127.0f * 0.1f * inv_len)) <= 1);
+		CHECK(abs(n[2] - static_cast<int>(128.0f + 127.0f * inv_len)) <= 1);
+	}
+
+	// Same heights in different data types give the same result
+	Image height8, height16, height32;
+	u8 * h8 = height8.Allocate(kSize, kSize, Image::Format::kR8);
+	u16 * h16 = reinterpret_cast<u16*>(height16.Allocate(kSize, kSize, Image::Format::kR16));
+	float * h32 = reinterpret_cast<float*>(height32.Allocate(kSize, kSize, Image::Format::kR32));
+	for (int i = 0; i < kSize * kSize; ++i)
+	{
+		int x = i % kSize, y = i / kSize;
+		h8[i] = static_cast<u8>(128.0f + 120.0f * sinf(x * 0.02f) * sinf(y * 0.03f));
+		h16[i] = static_cast<u16>(h8[i] * 257);
+		h32[i] = h8[i] / 255.0f;
+	}
+	const Image * sources[3] = { &height8, &height16, &height32 };
+	const char * names[3] = { "Sobel RG8 from R8", "Sobel RG8 from R16", "Sobel RG8 from R32F" };
+	Image results[3];
+	for (int t = 0; t < 3; ++t)
+	{
+		NormalMapBuilder builder;
+		builder.set_output(NormalMapBuilder::Output::kRG8);
+		Measure measure(names[t]);
+		for (int i = 0; i < iterations; ++i)
+			CHECK(builder.Build(*sources[t], &results[t]));
+		measure.Report(ImageSize(*sources[t]), iterations);
+	}
+	CHECK(results[0].channels() == 2);
+	CHECK(Psnr(results[0], results[1]) > 45.0);
+	CHECK(Psnr(results[0], results[2]) > 45.0);
+
+	NormalMapBuilder builder;
+	builder.set_output(NormalMapBuilder::Output::kRGBA8);
+	Image normal_height;
+	{
+		Measure measure("Sobel RGBA8 from R8");
+		for (int i = 0; i < iterations; ++i)
+			CHECK(builder.Build(height8, &normal_height));
+		measure.Report(ImageSize(height8), iterations);
+	}
+	bool height_kept = true;
+	for (int i = 0; i < kSize * kSize; ++i)
+		height_kept = height_kept && normal_height.pixels()[i * 4 + 3] == h8[i];
+	CHECK(height_kept);
+}
+
+int main(int argc, char ** argv)
+{
+	int iterations = (argc > 1) ? atoi(argv[1]) : 5;
+	if (iterations < 1)
+		iterations = 1;
+
+	for (size_t i = 0; i < sizeof(kFormats) / sizeof(kFormats[0]); ++i)
+		TestCodec(kFormats[i], iterations);
+	TestOperations(iterations);
+	TestNormalMaps(iterations);
+
+	if (g_failures)
+		printf("%d checks failed\n", g_failures);
+	else
+		printf("All checks passed\n");
+	return g_failures ? 1 : 0;
+}
@@ -0,0 +1,160 @@
+#include "sht/graphics/include/renderer/null_context.h"
+#include "sht/graphics/include/renderer/instance_batch.h"
+
+#include <stdio.h>
+#include <vector>
+
+using sht::graphics::BufferUsage;
+using sht::graphics::DataType;
+using sht::graphics::InstanceBatch;
+using sht::graphics::PrimitiveType;
+
+/*
+Test for instanced rendering.
+Scene of identical balls is drawn once per object and then with a single instanced call.
+*/
+
+static int g_failures = 0;
+
+#define CHECK(condition) \
+	do { if (!(condition)) { printf("  FAILED: %s (line %d)\n", #condition, __LINE__); ++g_failures; } } while (0)
+
+const int kNumBalls = 5000;
+const u32 kMeshAttributes = 3; // position, normal, texcoord
+
+//! Context that records calls related to instancing
+class RecordingContext : public sht::graphics::NullContext {
+public:
+	struct Attribute {
+		s32 size;
+		u32 stride;
+		size_t offset;
+		u32 divisor;
+		bool enabled;
+	};
+
+	RecordingContext()
+	: num_draws(0), num_instances(0), num_uploads(0), bound_buffer(0)
+	{
+	}
+	void DrawElements(PrimitiveType mode, u32 num_indices, DataType index_type)
+	{
+		++num_draws;
+		num_instances += 1;
+	}
+	void DrawElementsInstanced(PrimitiveType mode, u32 num_indices, DataType index_type, u32 count)
+	{
+		++num_draws;
+		num_instances += count;
+	}
+	void VertexBufferData(u32 size, const void *data, BufferUsage usage)
+	{
+		++num_uploads;
+		const u8 * bytes = reinterpret_cast<const u8*>(data);
+		uploaded.assign(bytes, bytes + size);
+	}
+	void VertexAttribPointer(u32 index, s32 size, DataType type, u32 stride, const void* ptr, bool normalized)
+	{
+		Attribute& attribute = attributes[index];
+		attribute.size = size;
+		attribute.stride = stride;
+		attribute.offset = reinterpret_cast<size_t>(ptr);
+		attribute_buffers[index] = bound_buffer;
+	}
+	void EnableVertexAttribArray(u32 index)
+	{
+		attributes[index].enabled = true;
+	}
+	void VertexAttribDivisor(u32 index, u32 divisor)
+	{
+		attributes[index].divisor = divisor;
+	}
+
+	int num_draws;
+	u32 num_instances;
+	int num_uploads;
+	u32 bound_buffer;
+	std::vector<u8> uploaded;
+	Attribute attributes[16] = {};
+	u32 attribute_buffers[16] = {};
+
+protected:
+	void ApiBindVertexBuffer(u32 obj) { bound_buffer = obj; }
+};
+
+static sht::math::Matrix4 Translation(float x, float y, float z)
+{
+	return sht::math::Matrix4(
+		1.0f, 0.0f, 0.0f, 0.0f,
+		0.0f, 1.0f, 0.0f, 0.0f,
+		0.0f, 0.0f, 1.0f, 0.0f,
+		x, y, z, 1.0f);
+}
+
+int main()
+{
+	RecordingContext context;
+	InstanceBatch batch(&context);
+
+	// Instance attributes follow mesh attributes and advance once per instance
+	batch.Attach(kMeshAttributes);
+	const u32 instance_buffer = context.attribute_buffers[kMeshAttributes];
+	CHECK(instance_buffer != 0);
+	for (u32 i = 0; i < InstanceBatch::kNumLocations; ++i)
+	{
+		const RecordingContext::Attribute& attribute = context.attributes[kMeshAttributes + i];
+		CHECK(attribute.enabled);
+		CHECK(attribute.divisor == 1);
+		CHECK(attribute.size == 4);
+		CHECK(attribute.stride == 80);
+		CHECK(attribute.offset == i * 16);
+		CHECK(context.attribute_buffers[kMeshAttributes + i] == instance_buffer);
+	}
+	CHECK(!context.attributes[kMeshAttributes - 1].enabled);
+
+	// Old way: one draw per ball
+	for (int i = 0; i < kNumBalls; ++i)
+		context.DrawElements(PrimitiveType::kTriangles, 960, DataType::kUnsignedShort);
+	const int draws_per_object = context.num_draws;
+
+	// Instanced: one upload and one draw per frame
+	context.num_draws = 0;
+	context.num_instances = 0;
+	for (int frame = 0; frame < 3; ++frame)
+	{
+		batch.Clear();
+		for (int i = 0; i < kNumBalls; ++i)
+			batch.Add(Translation(static_cast<float>(i), static_cast<float>(frame), 0.0f),
+				vec4(1.0f, 0.5f, 0.25f, 1.0f));
+		batch.Upload();
+		context.DrawElementsInstanced(PrimitiveType::kTriangles, 960, DataType::kUnsignedShort, batch.num_instances());
+	}
+	printf("%d balls: %d draws per frame without instancing, %d with instancing\n",
+		kNumBalls, draws_per_object, context.num_draws / 3);
+	CHECK(context.num_draws == 3);
+	CHECK(context.num_instances == 3 * kNumBalls);
+	CHECK(context.num_uploads == 3);
+	CHECK(context.uploaded.size() == kNumBalls * 80);
+
+	// Uploaded data contains matrix columns followed by color
+	const float * data = reinterpret_cast<const float*>(&context.uploaded[0]);
+	const float * last = data + (kNumBalls - 1) * 20;
+	CHECK(last[0] == 1.0f && last[5] == 1.0f && last[15] == 1.0f);
+	CHECK(last[12] == static_cast<float>(kNumBalls - 1));
+	CHECK(last[13] == 2.0f);
+	CHECK(last[16] == 1.0f && last[17] == 0.5f && last[18] == 0.25f && last[19] == 1.0f);
+
+	// Unchanged instances aren't uploaded again
+	batch.Upload();
+	CHECK(context.num_uploads == 3);
+	batch.Clear();
+	batch.Upload();
+	CHECK(context.num_uploads == 4);
+	CHECK(batch.num_instances() == 0);
+
+	if (g_failures)
+		printf("%d checks failed\n", g_failures);
+	else
+		printf("All checks passed\n");
+	return g_failures ? 1 : 0;
+}
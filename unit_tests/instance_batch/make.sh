@@ -0,0 +1,9 @@
+#!/bin/sh
+# Builds instanced rendering test
+SHT=../../sht
+g++ main.cpp \
+	$SHT/graphics/src/renderer/context.cpp \
+	$SHT/graphics/src/renderer/instance_batch.cpp \
+	$SHT/graphics/src/renderer/null_context.cpp \
+	$SHT/math/*.cpp \
+	-O2 -std=c++11 -I../../ -I$SHT -o instance_batch
@@ -0,0 +1,187 @@
+#include "sht/graphics/include/model/mesh_optimizer.h"
+#include "sht/system/include/time/clock.h"
+
+#include <stdio.h>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+using sht::graphics::MeshOptimizationStats;
+using sht::graphics::Vertex;
+
+/*
+Test for mesh optimizer.
+Grid is built as shuffled triangle soup like OBJ import makes, then it is welded and reordered.
+Triangles must stay the same while vertex count and cache misses drop.
+*/
+
+static int g_failures = 0;
+
+#define CHECK(condition) \
+	do { if (!(condition)) { printf("  FAILED: %s (line %d)\n", #condition, __LINE__); ++g_failures; } } while (0)
+
+static Vertex MakeVertex(float x, float y, float z)
+{
+	Vertex v;
+	memset(&v, 0, sizeof(v));
+	v.position = vec3(x, y, z);
+	v.normal = vec3(0.0f, 0.0f, 1.0f);
+	v.texcoord = vec2(x, y);
+	return v;
+}
+
+//! Appends grid of size x size quads in plane z as triangle soup
+static void AddGridSoup(int size, float z, std::vector<Vertex> * vertices)
+{
+	for (int j = 0; j < size; ++j)
+		for (int i = 0; i < size; ++i)
+		{
+			Vertex a = MakeVertex((float)i, (float)j, z);
+			Vertex b = MakeVertex((float)i + 1, (float)j, z);
+			Vertex c = MakeVertex((float)i + 1, (float)j + 1, z);
+			Vertex d = MakeVertex((float)i, (float)j + 1, z);
+			vertices->push_back(a); vertices->push_back(b); vertices->push_back(c);
+			vertices->push_back(a); vertices->push_back(c); vertices->push_back(d);
+		}
+}
+
+static void ShuffleTriangles(std::vector<Vertex> * vertices)
+{
+	const size_t num_triangles = vertices->size() / 3;
+	for (size_t i = num_triangles - 1; i > 0; --i)
+	{
+		size_t j = static_cast<size_t>(rand()) % (i + 1);
+		for (int k = 0; k < 3; ++k)
+			std::swap((*vertices)[3 * i + k], (*vertices)[3 * j + k]);
+	}
+}
+
+//! Triangles as sorted position triples with preserved winding
+struct Triangle {
+	float p[9];
+	bool operator < (const Triangle& other) const
+	{
+		return memcmp(p, other.p, sizeof(p)) < 0;
+	}
+	bool operator == (const Triangle& other) const
+	{
+		return memcmp(p, other.p, sizeof(p)) == 0;
+	}
+};
+
+static std::vector<Triangle> CollectTriangles(const std::vector<Vertex>& vertices, const std::vector<u32>& indices)
+{
+	std::vector<Triangle> triangles(indices.size() / 3);
+	for (size_t t = 0; t < triangles.size(); ++t)
+	{
+		// Rotate so the smallest corner goes first, winding is kept
+		const Vertex * corners[3] = { &vertices[indices[3*t]], &vertices[indices[3*t+1]], &vertices[indices[3*t+2]] };
+		int first = 0;
+		for (int k = 1; k < 3; ++k)
+			if (memcmp(&corners[k]->position, &corners[first]->position, sizeof(vec3)) < 0)
+				first = k;
+		for (int k = 0; k < 3; ++k)
+			memcpy(&triangles[t].p[3 * k], &corners[(first + k) % 3]->position, sizeof(vec3));
+	}
+	std::sort(triangles.begin(), triangles.end());
+	return triangles;
+}
+
+int main()
+{
+	srand(3);
+	const int kGridSize = 100;
+
+	// Weld of triangle soup
+	{
+		std::vector<Vertex> vertices;
+		AddGridSoup(4, 0.0f, &vertices);
+		std::vector<u32> indices;
+		u32 num_unique = sht::graphics::WeldVertices(&vertices, &indices);
+		CHECK(num_unique == 25);
+		CHECK(vertices.size() == 25);
+		CHECK(indices.size() == 4 * 4 * 6);
+		CHECK(indices[0] == 0 && indices[1] == 1 && indices[3] == 0);
+	}
+
+	// Full pipeline on shuffled grid
+	{
+		std::vector<Vertex> soup;
+		AddGridSoup(kGridSize, 0.0f, &soup);
+		ShuffleTriangles(&soup);
+		std::vector<u32> soup_indices(soup.size());
+		for (size_t i = 0; i < soup.size(); ++i)
+			soup_indices[i] = static_cast<u32>(i);
+		const std::vector<Triangle> reference = CollectTriangles(soup, soup_indices);
+
+		std::vector<Vertex> vertices = soup;
+		std::vector<u32> indices;
+		MeshOptimizationStats stats;
+		sht::system::Clock clock;
+		clock.MakeStartPoint();
+		sht::graphics::OptimizeMesh(&vertices, &indices, sht::graphics::kOptimizeDefault, &stats);
+		float time = clock.GetTime();
+
+		CHECK(stats.num_triangles == kGridSize * kGridSize * 2);
+		CHECK(stats.num_vertices_before == soup.size());
+		CHECK(stats.num_vertices_after == (kGridSize + 1) * (kGridSize + 1));
+		CHECK(stats.acmr_before == 3.0f);
+		CHECK(stats.acmr_after < 0.8f);
+		CHECK(CollectTriangles(vertices, indices) == reference);
+
+		// Welded but shuffled indices for comparison
+		std::vector<Vertex> welded = soup;
+		std::vector<u32> welded_indices;
+		sht::graphics::WeldVertices(&welded, &welded_indices);
+		float welded_acmr = sht::graphics::AnalyzeVertexCache(&welded_indices[0], welded_indices.size(), (u32)welded.size());
+		CHECK(stats.acmr_after < welded_acmr);
+
+		// Vertices follow first use
+		u32 next = 0;
+		bool ordered = true;
+		for (auto index : indices)
+		{
+			if (index > next)
+				ordered = false;
+			if (index == next)
+				++next;
+		}
+		CHECK(ordered);
+		CHECK(next == vertices.size());
+
+		printf("%u triangles: vertices %u -> %u, ACMR %.3f (welded %.3f) -> %.3f, %.2f ms\n",
+			stats.num_triangles, stats.num_vertices_before, stats.num_vertices_after,
+			stats.acmr_before, welded_acmr, stats.acmr_after, time * 1000.0f);
+	}
+
+	// Overdraw ordering, back layer is drawn first in the source
+	{
+		std::vector<Vertex> vertices;
+		AddGridSoup(32, -1.0f, &vertices);
+		AddGridSoup(32, 1.0f, &vertices);
+		std::vector<u32> indices;
+		MeshOptimizationStats stats;
+		sht::graphics::OptimizeMesh(&vertices, &indices, sht::graphics::kOptimizeAll, &stats);
+		float acmr = sht::graphics::AnalyzeVertexCache(&indices[0], indices.size(), (u32)vertices.size());
+		printf("overdraw %.3f -> %.3f, ACMR %.3f\n", stats.overdraw_before, stats.overdraw_after, acmr);
+		CHECK(stats.overdraw_before > 1.9f);
+		CHECK(stats.overdraw_after < 1.1f);
+		CHECK(stats.acmr_after == acmr);
+
+		// Same without overdraw ordering keeps the same cache efficiency
+		std::vector<Vertex> vertices2;
+		AddGridSoup(32, -1.0f, &vertices2);
+		AddGridSoup(32, 1.0f, &vertices2);
+		std::vector<u32> indices2;
+		MeshOptimizationStats stats2;
+		sht::graphics::OptimizeMesh(&vertices2, &indices2, sht::graphics::kOptimizeDefault, &stats2);
+		CHECK(stats.acmr_after <= stats2.acmr_after + 0.01f);
+	}
+
+	if (g_failures == 0)
+		printf("All checks passed\n");
+	else
+		printf("%d checks failed\n", g_failures);
+	return g_failures == 0 ? 0 : 1;
+}
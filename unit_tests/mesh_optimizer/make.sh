@@ -0,0 +1,8 @@
+#!/bin/sh
+# Builds mesh optimizer test
+SHT=../../sht
+g++ main.cpp \
+	$SHT/graphics/src/model/mesh_optimizer.cpp \
+	$SHT/math/*.cpp \
+	$SHT/system/src/time/clock.cpp \
+	-O2 -std=c++11 -I../../ -I$SHT -o mesh_optimizer
@@ -0,0 +1,224 @@
+#include "sht/graphics/include/renderer/null_context.h"
+#include "sht/graphics/include/renderer/mesh_pool.h"
+
+#include <stdio.h>
+#include <cstring>
+#include <vector>
+
+using sht::graphics::BufferUsage;
+using sht::graphics::DataType;
+using sht::graphics::MeshPool;
+using sht::graphics::PrimitiveType;
+using sht::graphics::VertexAttribute;
+
+/*
+Test for static mesh pool.
+Many small meshes are placed into shared buffers and drawn with base vertex calls,
+data fetched through recorded draws is compared with source meshes.
+*/
+
+static int g_failures = 0;
+
+#define CHECK(condition) \
+	do { if (!(condition)) { printf("  FAILED: %s (line %d)\n", #condition, __LINE__); ++g_failures; } } while (0)
+
+const int kNumMeshes = 200;
+const int kNumMaterials = 10;
+
+//! Context that keeps buffer contents and records draws
+class RecordingContext : public sht::graphics::NullContext {
+public:
+	struct Draw {
+		u32 num_indices;
+		u32 first_index;
+		s32 base_vertex;
+	};
+
+	RecordingContext()
+	: num_calls(0), num_vertex_array_binds(0), bound_vertex_array(0)
+	{
+	}
+	void DrawElementsBaseVertex(PrimitiveType mode, u32 num_indices, DataType index_type,
+		u32 first_index, s32 base_vertex)
+	{
+		++num_calls;
+		Draw draw = { num_indices, first_index, base_vertex };
+		draws.push_back(draw);
+	}
+	void MultiDrawElementsBaseVertex(PrimitiveType mode, const u32 * num_indices, DataType index_type,
+		const u32 * first_indices, const s32 * base_vertices, u32 draw_count)
+	{
+		++num_calls;
+		for (u32 i = 0; i < draw_count; ++i)
+		{
+			Draw draw = { num_indices[i], first_indices[i], base_vertices[i] };
+			draws.push_back(draw);
+		}
+	}
+	void VertexBufferData(u32 size, const void *data, BufferUsage usage)
+	{
+		vertex_data.assign(size, 0);
+	}
+	void VertexBufferSubData(u32 offset, u32 size, const void *data)
+	{
+		memcpy(&vertex_data[offset], data, size);
+	}
+	void IndexBufferData(u32 size, const void *data, BufferUsage usage)
+	{
+		index_data.assign(size, 0);
+	}
+	void IndexBufferSubData(u32 offset, u32 size, const void *data)
+	{
+		memcpy(&index_data[offset], data, size);
+	}
+
+	//! Returns vertex position fetched by draw
+	const float * Fetch(const Draw& draw, u32 i, u32 vertex_size) const
+	{
+		const u32 * indices = reinterpret_cast<const u32*>(&index_data[0]);
+		const u32 vertex = indices[draw.first_index + i] + draw.base_vertex;
+		return reinterpret_cast<const float*>(&vertex_data[vertex * vertex_size]);
+	}
+
+	int num_calls;
+	int num_vertex_array_binds;
+	u32 bound_vertex_array;
+	std::vector<Draw> draws;
+	std::vector<u8> vertex_data;
+	std::vector<u8> index_data;
+
+protected:
+	void ApiBindVertexArrayObject(u32 obj)
+	{
+		bound_vertex_array = obj;
+		if (obj != 0)
+			++num_vertex_array_binds;
+	}
+};
+
+//! Fan of triangles, first vertex component holds mesh number
+struct TestMesh {
+	std::vector<float> vertices;    // position and texcoord
+	std::vector<u16> indices;
+
+	TestMesh(int number, int num_vertices)
+	{
+		for (int i = 0; i < num_vertices; ++i)
+		{
+			const float vertex[5] = { static_cast<float>(number), static_cast<float>(i), 0.0f, 0.0f, 1.0f };
+			vertices.insert(vertices.end(), vertex, vertex + 5);
+		}
+		for (int i = 1; i + 1 < num_vertices; ++i)
+		{
+			indices.push_back(0);
+			indices.push_back(static_cast<u16>(i));
+			indices.push_back(static_cast<u16>(i + 1));
+		}
+	}
+};
+
+int main()
+{
+	const VertexAttribute attribs[2] = {
+		VertexAttribute(VertexAttribute::kVertex, 3),
+		VertexAttribute(VertexAttribute::kTexcoord, 2)
+	};
+	RecordingContext context;
+	MeshPool pool(&context, attribs, 2, 1 << 14, 1 << 16);
+	CHECK(pool.vertex_size() == 20);
+
+	std::vector<TestMesh> meshes;
+	std::vector<MeshPool::Handle> handles;
+	for (int i = 0; i < kNumMeshes; ++i)
+	{
+		meshes.push_back(TestMesh(i, 4 + i % 13));
+		const TestMesh& mesh = meshes.back();
+		handles.push_back(pool.Add(&mesh.vertices[0], static_cast<u32>(mesh.vertices.size() / 5),
+			&mesh.indices[0], static_cast<u32>(mesh.indices.size()), DataType::kUnsignedShort));
+		CHECK(handles.back() != MeshPool::kInvalidHandle);
+	}
+	CHECK(context.bound_vertex_array == 0);
+
+	MeshPool::Stats stats = pool.GetStats();
+	CHECK(stats.num_meshes == kNumMeshes);
+	CHECK(stats.fragmentation == 0.0f);
+	CHECK(stats.num_free_ranges == 2);
+
+	// Meshes grouped by material are drawn with a single call per group
+	context.num_vertex_array_binds = 0;
+	pool.Bind();
+	for (int material = 0; material < kNumMaterials; ++material)
+	{
+		std::vector<MeshPool::Handle> group;
+		for (int i = material; i < kNumMeshes; i += kNumMaterials)
+			group.push_back(handles[i]);
+		pool.DrawBatch(&group[0], static_cast<u32>(group.size()), PrimitiveType::kTriangles);
+	}
+	pool.Unbind();
+	printf("%d meshes: %d draw calls, %d vertex array binds\n",
+		kNumMeshes, context.num_calls, context.num_vertex_array_binds);
+	CHECK(context.num_calls == kNumMaterials);
+	CHECK(context.num_vertex_array_binds == 1);
+	CHECK(context.draws.size() == kNumMeshes);
+
+	// Every draw fetches vertices of its own mesh
+	for (size_t n = 0; n < context.draws.size(); ++n)
+	{
+		const RecordingContext::Draw& draw = context.draws[n];
+		const int number = static_cast<int>((n % (kNumMeshes / kNumMaterials)) * kNumMaterials + n / (kNumMeshes / kNumMaterials));
+		const TestMesh& mesh = meshes[number];
+		CHECK(draw.num_indices == mesh.indices.size());
+		for (u32 i = 0; i < draw.num_indices; ++i)
+		{
+			const float * position = context.Fetch(draw, i, pool.vertex_size());
+			if (position[0] != static_cast<float>(number) || position[1] != static_cast<float>(mesh.indices[i]))
+			{
+				CHECK(!"wrong vertex fetched");
+				break;
+			}
+		}
+	}
+
+	// Removing every other mesh fragments free space, freed ranges get reused
+	for (int i = 0; i < kNumMeshes; i += 2)
+		pool.Remove(handles[i]);
+	stats = pool.GetStats();
+	printf("after removal: %u/%u vertices, %u/%u indices used, %u free ranges, fragmentation %.2f\n",
+		stats.vertices_used, stats.vertex_capacity, stats.indices_used, stats.index_capacity,
+		stats.num_free_ranges, stats.fragmentation);
+	CHECK(stats.num_meshes == kNumMeshes / 2);
+	CHECK(stats.num_free_ranges > kNumMeshes / 2);
+	CHECK(stats.fragmentation > 0.0f && stats.fragmentation < 1.0f);
+	MeshPool::Handle reused = pool.Add(&meshes[0].vertices[0], 4, &meshes[0].indices[0],
+		static_cast<u32>(meshes[0].indices.size()), DataType::kUnsignedShort);
+	CHECK(reused == handles[kNumMeshes - 2]);
+	context.draws.clear();
+	pool.Draw(reused, PrimitiveType::kTriangles);
+	CHECK(context.draws.back().base_vertex == 0); // first fit
+
+	// Removing the rest coalesces free space back
+	pool.Remove(reused);
+	for (int i = 1; i < kNumMeshes; i += 2)
+		pool.Remove(handles[i]);
+	stats = pool.GetStats();
+	CHECK(stats.num_meshes == 0);
+	CHECK(stats.vertices_used == 0 && stats.indices_used == 0);
+	CHECK(stats.num_free_ranges == 2);
+	CHECK(stats.fragmentation == 0.0f);
+
+	// Mesh that doesn't fit isn't added
+	std::vector<float> big((1 << 14) * 5 + 5, 0.0f);
+	CHECK(pool.Add(&big[0], (1 << 14) + 1, nullptr, 0, DataType::kUnsignedInt) == MeshPool::kInvalidHandle);
+	CHECK(pool.GetStats().vertices_used == 0);
+
+	// Non-indexed mesh gets sequential indices
+	MeshPool::Handle sequential = pool.Add(&big[0], 6, nullptr, 0, DataType::kUnsignedInt);
+	CHECK(sequential != MeshPool::kInvalidHandle);
+	CHECK(pool.GetStats().indices_used == 6);
+
+	if (g_failures)
+		printf("%d checks failed\n", g_failures);
+	else
+		printf("All checks passed\n");
+	return g_failures ? 1 : 0;
+}
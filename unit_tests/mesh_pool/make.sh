@@ -0,0 +1,9 @@
+#!/bin/sh
+# Builds mesh pool test
+SHT=../../sht
+g++ main.cpp \
+	$SHT/graphics/src/renderer/context.cpp \
+	$SHT/graphics/src/renderer/mesh_pool.cpp \
+	$SHT/graphics/src/renderer/null_context.cpp \
+	$SHT/graphics/src/renderer/vertex_packing.cpp \
+	-O2 -std=c++11 -I../../ -I$SHT -o mesh_pool
@@ -0,0 +1,225 @@
+#include "sht/graphics/include/model/mesh_simplifier.h"
+#include "sht/system/include/time/clock.h"
+
+#include <stdio.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+using sht::graphics::MeshLod;
+using sht::graphics::Vertex;
+
+/*
+Test for mesh simplifier.
+Flat grid must collapse with no error keeping its borders, sphere levels must lose triangles
+with growing error that stays close to real deviation from the sphere. Big sphere is a benchmark.
+*/
+
+static int g_failures = 0;
+
+#define CHECK(condition) \
+	do { if (!(condition)) { printf("  FAILED: %s (line %d)\n", #condition, __LINE__); ++g_failures; } } while (0)
+
+static Vertex MakeVertex(const vec3& position, const vec3& normal, const vec2& texcoord)
+{
+	Vertex v;
+	memset(&v, 0, sizeof(v));
+	v.position = position;
+	v.normal = normal;
+	v.texcoord = texcoord;
+	return v;
+}
+
+//! Indexed grid of size x size quads in plane z = 0
+static void MakeGrid(int size, std::vector<Vertex> * vertices, std::vector<u32> * indices)
+{
+	for (int j = 0; j <= size; ++j)
+		for (int i = 0; i <= size; ++i)
+			vertices->push_back(MakeVertex(vec3((float)i, (float)j, 0.0f), vec3(0.0f, 0.0f, 1.0f),
+				vec2((float)i / size, (float)j / size)));
+	for (int j = 0; j < size; ++j)
+		for (int i = 0; i < size; ++i)
+		{
+			u32 a = j * (size + 1) + i;
+			u32 b = a + 1;
+			u32 c = a + size + 2;
+			u32 d = a + size + 1;
+			u32 quad[6] = { a, b, c, a, c, d };
+			indices->insert(indices->end(), quad, quad + 6);
+		}
+}
+
+//! Unit sphere with texture seam and poles made of separate vertices like exported models have
+static void MakeSphere(int slices, int stacks, std::vector<Vertex> * vertices, std::vector<u32> * indices)
+{
+	const float kPi = 3.1415926535f;
+	for (int j = 0; j <= stacks; ++j)
+		for (int i = 0; i <= slices; ++i)
+		{
+			float theta = kPi * (float)j / stacks;
+			float phi = 2.0f * kPi * (float)i / slices;
+			vec3 normal(sinf(theta) * cosf(phi), cosf(theta), sinf(theta) * sinf(phi));
+			if (i == slices) // seam must match exactly
+				normal = (*vertices)[j * (slices + 1)].normal;
+			if (j == 0 || j == stacks)
+				normal = vec3(0.0f, (j == 0) ? 1.0f : -1.0f, 0.0f);
+			vertices->push_back(MakeVertex(normal, normal, vec2((float)i / slices, (float)j / stacks)));
+		}
+	for (int j = 0; j < stacks; ++j)
+		for (int i = 0; i < slices; ++i)
+		{
+			u32 a = j * (slices + 1) + i;
+			u32 b = a + 1;
+			u32 c = a + slices + 2;
+			u32 d = a + slices + 1;
+			if (j != 0)
+			{
+				u32 triangle[3] = { a, b, d };
+				indices->insert(indices->end(), triangle, triangle + 3);
+			}
+			if (j != stacks - 1)
+			{
+				u32 triangle[3] = { b, c, d };
+				indices->insert(indices->end(), triangle, triangle + 3);
+			}
+		}
+}
+
+static float TotalArea(const std::vector<Vertex>& vertices, const std::vector<u32>& indices)
+{
+	float area = 0.0f;
+	for (size_t i = 0; i < indices.size(); i += 3)
+	{
+		const vec3& p0 = vertices[indices[i]].position;
+		vec3 normal = (vertices[indices[i + 1]].position - p0) ^ (vertices[indices[i + 2]].position - p0);
+		CHECK(normal.z > 0.0f); // no flipped triangles
+		area += 0.5f * normal.Length();
+	}
+	return area;
+}
+
+//! Maximum distance of triangle centers from unit sphere
+static float SphereDeviation(const std::vector<Vertex>& vertices, const std::vector<u32>& indices)
+{
+	float deviation = 0.0f;
+	for (size_t i = 0; i < indices.size(); i += 3)
+	{
+		vec3 center = (vertices[indices[i]].position + vertices[indices[i + 1]].position +
+			vertices[indices[i + 2]].position) / 3.0f;
+		deviation = std::max(deviation, 1.0f - center.Length());
+	}
+	return deviation;
+}
+
+//! Maximum difference of texture coordinates in a triangle, it is big if triangle crosses seam
+static float MaxTexcoordSpan(const std::vector<Vertex>& vertices, const std::vector<u32>& indices)
+{
+	float span = 0.0f;
+	for (size_t i = 0; i < indices.size(); i += 3)
+		for (int k = 0; k < 3; ++k)
+		{
+			const vec2& t0 = vertices[indices[i + k]].texcoord;
+			const vec2& t1 = vertices[indices[i + (k + 1) % 3]].texcoord;
+			span = std::max(span, std::max(fabsf(t0.x - t1.x), fabsf(t0.y - t1.y)));
+		}
+	return span;
+}
+
+int main()
+{
+	// Flat grid collapses to a few triangles without error, borders stay
+	{
+		const int kSize = 32;
+		std::vector<Vertex> vertices;
+		std::vector<u32> indices;
+		MakeGrid(kSize, &vertices, &indices);
+		std::vector<u32> result;
+		float error = sht::graphics::SimplifyMesh(vertices, &indices[0], indices.size(), 0, 0.01f, &result);
+		printf("grid: %u -> %u triangles, error %g\n", (u32)indices.size() / 3, (u32)result.size() / 3, error);
+		CHECK(result.size() % 3 == 0);
+		CHECK(result.size() * 20 < indices.size());
+		CHECK(error < 1e-3f);
+		CHECK(fabsf(TotalArea(vertices, result) - kSize * kSize) < 1e-2f);
+		// Corners are still used
+		u32 corners[4] = { 0, kSize, (kSize + 1) * kSize, (kSize + 1) * (kSize + 1) - 1 };
+		for (int k = 0; k < 4; ++k)
+			CHECK(std::find(result.begin(), result.end(), corners[k]) != result.end());
+	}
+
+	// Target error stops simplification of curved surface
+	{
+		std::vector<Vertex> vertices;
+		std::vector<u32> indices;
+		MakeSphere(32, 16, &vertices, &indices);
+		std::vector<u32> result;
+		float error = sht::graphics::SimplifyMesh(vertices, &indices[0], indices.size(), 0, 1e-4f, &result);
+		CHECK(error <= 1e-4f);
+		CHECK(result.size() * 10 > indices.size() * 9);
+	}
+
+	// Levels of sphere
+	{
+		std::vector<Vertex> vertices;
+		std::vector<u32> indices;
+		MakeSphere(64, 32, &vertices, &indices);
+		std::vector<MeshLod> lods;
+		sht::graphics::GenerateLods(vertices, indices, 4, 0.05f, &lods);
+		CHECK(lods.size() == 4);
+		size_t previous_count = indices.size();
+		float previous_error = 0.0f;
+		for (size_t i = 0; i < lods.size(); ++i)
+		{
+			const MeshLod& lod = lods[i];
+			float deviation = SphereDeviation(vertices, lod.indices);
+			printf("sphere lod %u: %u triangles (%.1f%%), error %.5f, deviation %.5f\n", (u32)i + 1,
+				(u32)lod.indices.size() / 3, 100.0f * lod.indices.size() / indices.size(), lod.error, deviation);
+			CHECK(lod.indices.size() < previous_count);
+			CHECK(lod.indices.size() * 3 >= previous_count); // about a half, not much less
+			CHECK(lod.error >= previous_error);
+			CHECK(lod.error <= 0.05f * 2.0f * sqrtf(3.0f));
+			// Quadric error is an estimate, but it should follow the real one
+			CHECK(deviation <= 3.0f * lod.error + 1e-3f);
+			CHECK(MaxTexcoordSpan(vertices, lod.indices) < 0.5f);
+			previous_count = lod.indices.size();
+			previous_error = lod.error;
+		}
+
+		// Selection by screen size
+		CHECK(sht::graphics::SelectLod(lods, 1e6f, 1.0f) == 0);
+		CHECK(sht::graphics::SelectLod(lods, 1e-3f, 1.0f) == lods.size());
+		u32 previous_lod = 0;
+		for (float size = 4096.0f; size >= 4.0f; size *= 0.5f)
+		{
+			u32 lod = sht::graphics::SelectLod(lods, size / 2.0f, 1.0f);
+			CHECK(lod >= previous_lod);
+			previous_lod = lod;
+		}
+		CHECK(previous_lod == lods.size());
+		float screen_size = sht::graphics::ComputeScreenSize(2.0f, 10.0f, 0.5f * 3.1415926535f, 1000.0f);
+		CHECK(fabsf(screen_size - 100.0f) < 1e-2f);
+	}
+
+	// Benchmark
+	{
+		std::vector<Vertex> vertices;
+		std::vector<u32> indices;
+		MakeSphere(512, 256, &vertices, &indices);
+		std::vector<MeshLod> lods;
+		sht::system::Clock clock;
+		clock.MakeStartPoint();
+		sht::graphics::GenerateLods(vertices, indices, 4, 0.05f, &lods);
+		float time = clock.GetTime();
+		CHECK(lods.size() == 4);
+		printf("%u triangles, 4 levels in %.1f ms:", (u32)indices.size() / 3, time * 1000.0f);
+		for (const auto& lod : lods)
+			printf(" %u (error %.5f)", (u32)lod.indices.size() / 3, lod.error);
+		printf("\n");
+	}
+
+	if (g_failures == 0)
+		printf("All checks passed\n");
+	else
+		printf("%d checks failed\n", g_failures);
+	return g_failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,275 @@
+#include "sht/graphics/include/model/obj_file.h"
+#include "sht/system/include/tasks/parallel_for.h"
+#include "sht/system/include/time/clock.h"
+
+#include <stdio.h>
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using sht::graphics::ObjMesh;
+using sht::graphics::ObjMeshData;
+using sht::graphics::ObjReader;
+using sht::graphics::ObjWriter;
+using sht::graphics::Vertex;
+
+/*
+Test for OBJ reader and writer.
+Small file checks syntax, materials and relative indices, big files check that chunks parsed
+in parallel give the same result, written sphere must come back. 1M triangles sphere is a benchmark.
+*/
+
+static int g_failures = 0;
+
+#define CHECK(condition) \
+	do { if (!(condition)) { printf("  FAILED: %s (line %d)\n", #condition, __LINE__); ++g_failures; } } while (0)
+
+static void WriteText(const char * filename, const std::string& text)
+{
+	FILE * file = fopen(filename, "wb");
+	fwrite(text.data(), 1, text.size(), file);
+	fclose(file);
+}
+
+static bool Near(const vec3& a, const vec3& b, float tolerance)
+{
+	return fabsf(a.x - b.x) <= tolerance && fabsf(a.y - b.y) <= tolerance && fabsf(a.z - b.z) <= tolerance;
+}
+
+static const ObjMesh * FindMesh(ObjReader& reader, u32 material_index)
+{
+	for (const auto& mesh : reader.meshes())
+		if (mesh.material_index == material_index)
+			return &mesh;
+	return nullptr;
+}
+
+static void MakeSphere(int slices, int stacks, std::vector<Vertex> * vertices, std::vector<u32> * indices)
+{
+	const float kPi = 3.1415926535f;
+	for (int j = 0; j <= stacks; ++j)
+		for (int i = 0; i <= slices; ++i)
+		{
+			float theta = kPi * (float)j / stacks;
+			float phi = 2.0f * kPi * (float)i / slices;
+			Vertex v = Vertex();
+			v.normal = vec3(sinf(theta) * cosf(phi), cosf(theta), sinf(theta) * sinf(phi));
+			v.position = v.normal * 3.0f;
+			v.texcoord = vec2((float)i / slices, (float)j / stacks);
+			vertices->push_back(v);
+		}
+	for (int j = 0; j < stacks; ++j)
+		for (int i = 0; i < slices; ++i)
+		{
+			u32 a = j * (slices + 1) + i;
+			u32 quad[6] = { a, a + 1, a + slices + 2, a, a + slices + 2, a + slices + 1 };
+			indices->insert(indices->end(), quad, quad + 6);
+		}
+}
+
+int main()
+{
+	// Syntax, materials and indices
+	{
+		WriteText("test.mtl",
+			"# materials\n"
+			"newmtl red\nKd 1 0 0\nNs 10\nd 0.5\n\n"
+			"newmtl green\r\nKd 0 1 0\r\nTr 0.25\r\n");
+		WriteText("test.obj",
+			"# comment\n"
+			"mtllib test.mtl\n"
+			"o object\n"
+			"v 0 0 0\nv 1 0 0\nv 1 1 0\nv 0 1 0\n"
+			"vt 0 0\nvt 1 0\nvt 1 1\nvt 0 1\n"
+			"vn 0 0 1\n"
+			"f 1 2 3\n"                          // no material yet
+			"usemtl red\n"
+			"g group\ns 1\n"
+			"f 1/1/1 2/2/1 3/3/1 4/4/1\n"          // quad
+			"usemtl green\r\n"
+			"\tv  1e-3 -2.5E+2 .5 \r\n"
+			"v 123456789012345678901234 -0 +7.\r\n"
+			"f -6//-1 -5//-1 -2//-1\r\n"           // relative indices
+			"usemtl red\n"
+			"f 1/1/1 3/3/1 4/4/1");                // no line end at the end of file
+		ObjReader reader;
+		CHECK(reader.Open("test.obj"));
+		CHECK(reader.materials().size() == 3);
+		CHECK(reader.meshes().size() == 3);
+		if (reader.materials().size() == 3 && reader.meshes().size() == 3)
+		{
+			CHECK(reader.materials()[0].diffuse.x == 1.0f && reader.materials()[0].shininess == 10.0f);
+			CHECK(reader.materials()[0].dissolve == 0.5f);
+			CHECK(reader.materials()[1].diffuse.y == 1.0f && reader.materials()[1].dissolve == 0.75f);
+			CHECK(reader.materials()[2].diffuse.x == 0.6f); // default one
+
+			const ObjMesh * red = FindMesh(reader, 0);
+			const ObjMesh * green = FindMesh(reader, 1);
+			const ObjMesh * none = FindMesh(reader, 2);
+			CHECK(red != nullptr && green != nullptr && none != nullptr);
+			if (red != nullptr && green != nullptr && none != nullptr)
+			{
+				// Quad fan and the last triangle share corners
+				CHECK(red->indices.size() == 9);
+				CHECK(red->vertices.size() == 4);
+				CHECK(red->indices.size() == 9 && red->indices[6] == red->indices[0] && red->indices[7] == red->indices[2]);
+				CHECK(red->vertices.size() == 4 && red->vertices[2].texcoord.x == 1.0f && red->vertices[2].normal.z == 1.0f);
+				CHECK(none->indices.size() == 3 && none->vertices.size() == 3);
+				CHECK(none->vertices.size() == 3 && none->vertices[1].position.x == 1.0f && none->vertices[1].normal.z == 0.0f);
+				CHECK(green->vertices.size() == 3);
+				if (green->vertices.size() == 3)
+				{
+					CHECK(green->vertices[0].position.x == 0.0f && green->vertices[1].position.x == 1.0f);
+					CHECK(green->vertices[2].position.x == 1e-3f);
+					CHECK(green->vertices[2].position.y == -250.0f && green->vertices[2].position.z == 0.5f);
+					CHECK(green->vertices[0].normal.z == 1.0f);
+				}
+			}
+			CHECK(Near(reader.bounding_box().center, vec3(0.5f, -124.5f, 0.25f), 1e-5f));
+		}
+
+		// Broken files
+		WriteText("test.obj", "v 0 0 0\nv 1 0 0\nv 0 1 0\nf 1 2 4\n");
+		CHECK(!reader.Open("test.obj"));
+		WriteText("test.obj", "v 0 0 0\nv 1 0 0\nf 1 2\n");
+		CHECK(!reader.Open("test.obj"));
+		WriteText("test.obj", "v 0 0 0\nv 1 0 0\nv 0 1 0\nf 1/1 2/1 3/1\n");
+		CHECK(!reader.Open("test.obj"));
+		WriteText("test.obj", "v 0 x 0\n");
+		CHECK(!reader.Open("test.obj"));
+		CHECK(!reader.Open("missing.obj"));
+		remove("test.mtl");
+	}
+
+	// Relative indices across chunks of big file
+	{
+		const int kNumTriangles = 100000;
+		std::string text;
+		char line[128];
+		for (int i = 0; i < kNumTriangles; ++i)
+		{
+			for (int k = 0; k < 3; ++k)
+			{
+				snprintf(line, sizeof(line), "v %d.%d %d 0.25\n", i, k, k);
+				text += line;
+			}
+			text += (i % 2) ? "f -3 -2 -1\n" : "vt 0.5 0.5\nvn 0 0 1\nf -3/-1/-1 -2/-1/-1 -1/-1/-1\n";
+		}
+		WriteText("test.obj", text);
+		ObjReader reader;
+		CHECK(reader.Open("test.obj"));
+		CHECK(reader.meshes().size() == 1);
+		if (reader.meshes().size() == 1)
+		{
+			const ObjMesh& mesh = reader.meshes()[0];
+			CHECK(mesh.vertices.size() == 3 * kNumTriangles && mesh.indices.size() == 3 * kNumTriangles);
+			bool valid = mesh.vertices.size() == 3 * kNumTriangles && mesh.indices.size() == 3 * kNumTriangles;
+			for (int i = 0; i < kNumTriangles && valid; ++i)
+				for (int k = 0; k < 3 && valid; ++k)
+				{
+					const Vertex& v = mesh.vertices[mesh.indices[3 * i + k]];
+					snprintf(line, sizeof(line), "%d.%d", i, k);
+					valid = v.position.x == (float)atof(line) && v.position.y == (float)k && v.position.z == 0.25f;
+					// Only even triangles have normals
+					valid = valid && v.normal.z == ((i % 2 == 0) ? 1.0f : 0.0f);
+				}
+			CHECK(valid);
+		}
+	}
+
+	// Written file comes back
+	{
+		std::vector<Vertex> vertices;
+		std::vector<u32> indices;
+		MakeSphere(64, 32, &vertices, &indices);
+		ObjWriter writer;
+		sht::graphics::Material material = sht::graphics::Material();
+		material.diffuse = vec3(0.25f, 0.5f, 0.75f);
+		material.dissolve = 1.0f;
+		writer.AddMaterial(material);
+		writer.AddMaterial(material);
+		ObjMeshData data = { 1, &vertices[0], (u32)vertices.size(), &indices[0], (u32)indices.size() };
+		writer.AddMesh(data);
+		data.material_index = 0;
+		data.indices = nullptr;
+		data.num_vertices = 30;
+		writer.AddMesh(data);
+		CHECK(writer.Save("test.obj"));
+		ObjReader reader;
+		CHECK(reader.Open("test.obj"));
+		CHECK(reader.materials().size() == 2 && reader.materials()[1].diffuse.z == 0.75f);
+		const ObjMesh * sphere = FindMesh(reader, 1);
+		const ObjMesh * triangles = FindMesh(reader, 0);
+		CHECK(sphere != nullptr && triangles != nullptr);
+		if (sphere != nullptr && triangles != nullptr)
+		{
+			// Vertices are numbered in order of use, so corners are compared
+			CHECK(sphere->vertices.size() == vertices.size());
+			CHECK(sphere->indices.size() == indices.size());
+			bool same = sphere->indices.size() == indices.size();
+			for (size_t i = 0; i < indices.size() && same; ++i)
+				same = memcmp(&sphere->vertices[sphere->indices[i]], &vertices[indices[i]], sizeof(Vertex)) == 0;
+			CHECK(same);
+			CHECK(triangles->indices.size() == 30 && triangles->vertices.size() == 30);
+		}
+		remove("test.mtl");
+	}
+
+	// Library name longer than line buffer of writer
+	{
+		std::vector<Vertex> vertices;
+		std::vector<u32> indices;
+		MakeSphere(4, 2, &vertices, &indices);
+		ObjWriter writer;
+		sht::graphics::Material material = sht::graphics::Material();
+		material.diffuse = vec3(0.5f);
+		writer.AddMaterial(material);
+		ObjMeshData data = { 0, &vertices[0], (u32)vertices.size(), &indices[0], (u32)indices.size() };
+		writer.AddMesh(data);
+		const std::string name = "test_" + std::string(200, 'x');
+		CHECK(writer.Save((name + ".obj").c_str()));
+		ObjReader reader;
+		CHECK(reader.Open((name + ".obj").c_str()));
+		CHECK(reader.materials().size() == 1 && reader.materials()[0].diffuse.x == 0.5f);
+		remove((name + ".obj").c_str());
+		remove((name + ".mtl").c_str());
+	}
+
+	// Benchmark
+	{
+		std::vector<Vertex> vertices;
+		std::vector<u32> indices;
+		MakeSphere(1024, 512, &vertices, &indices);
+		ObjWriter writer;
+		sht::graphics::Material material = sht::graphics::Material();
+		writer.AddMaterial(material);
+		ObjMeshData data = { 0, &vertices[0], (u32)vertices.size(), &indices[0], (u32)indices.size() };
+		writer.AddMesh(data);
+		sht::system::Clock clock;
+		clock.MakeStartPoint();
+		CHECK(writer.Save("test.obj"));
+		float save_time = clock.GetTime();
+		FILE * file = fopen("test.obj", "rb");
+		fseek(file, 0, SEEK_END);
+		long size = ftell(file);
+		fclose(file);
+		clock.MakeStartPoint();
+		ObjReader reader;
+		CHECK(reader.Open("test.obj"));
+		float load_time = clock.GetTime();
+		CHECK(reader.meshes().size() == 1 && reader.meshes()[0].indices.size() == indices.size() &&
+			reader.meshes()[0].vertices.size() == vertices.size());
+		printf("%u triangles, %.1f MB: save %.1f ms, load %.1f ms (%.0f MB/s, %d threads)\n",
+			(u32)indices.size() / 3, size / 1048576.0f, save_time * 1000.0f, load_time * 1000.0f,
+			size / 1048576.0f / load_time, sht::system::GetWorkerThreadCount());
+		remove("test.mtl");
+	}
+	remove("test.obj");
+
+	if (g_failures == 0)
+		printf("All checks passed\n");
+	else
+		printf("%d checks failed\n", g_failures);
+	return g_failures == 0 ? 0 : 1;
+}
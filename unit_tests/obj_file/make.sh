@@ -0,0 +1,12 @@
+#!/bin/sh
+# Builds OBJ file test
+SHT=../../sht
+g++ main.cpp \
+	$SHT/graphics/src/model/obj_file.cpp \
+	$SHT/system/src/stream/*.cpp \
+	$SHT/system/src/string/filename.cpp \
+	$SHT/system/src/filesystem/directory.cpp \
+	$SHT/system/src/tasks/parallel_for.cpp \
+	$SHT/system/src/time/clock.cpp \
+	$SHT/math/*.cpp \
+	-O2 -std=c++11 -pthread -I../../ -I$SHT -o obj_file
@@ -0,0 +1,183 @@
+#include "sht/graphics/include/renderer/null_context.h"
+#include "sht/graphics/include/renderer/occlusion_culler.h"
+#include "sht/graphics/include/renderer/render_queue.h"
+
+#include <stdio.h>
+#include <cmath>
+#include <vector>
+
+using sht::graphics::CommandBuffer;
+using sht::graphics::DataType;
+using sht::graphics::OcclusionCuller;
+using sht::graphics::PrimitiveType;
+using sht::graphics::RenderQueue;
+using sht::graphics::Shader;
+using sht::math::BoundingBox;
+using sht::math::Matrix4;
+using sht::math::Vector3;
+
+/*
+Test for software occlusion culling.
+Camera looks at a wall, boxes behind it must be culled and the others kept.
+A maze-like scene checks the statistics and that results feed render queue.
+*/
+
+static int g_failures = 0;
+
+#define CHECK(condition) \
+	do { if (!(condition)) { printf("  FAILED: %s (line %d)\n", #condition, __LINE__); ++g_failures; } } while (0)
+
+const int kWidth = 256;
+const int kHeight = 128;
+
+static BoundingBox MakeBox(const Vector3& center, const Vector3& extent)
+{
+	BoundingBox box;
+	box.center = center;
+	box.extent = extent;
+	return box;
+}
+
+//! Shader with program created outside
+class TestShader : public Shader {
+public:
+	TestShader(sht::graphics::Context * context, u32 program)
+	: Shader(context)
+	{
+		program_ = program;
+	}
+	~TestShader()
+	{
+	}
+};
+
+//! Box mesh with 8 vertices and 12 triangles
+static void AddBoxOccluder(OcclusionCuller& culler, const Vector3& center, const Vector3& extent)
+{
+	Vector3 vertices[8];
+	for (int i = 0; i < 8; ++i)
+		vertices[i] = Vector3(
+			center.x + ((i & 1) ? extent.x : -extent.x),
+			center.y + ((i & 2) ? extent.y : -extent.y),
+			center.z + ((i & 4) ? extent.z : -extent.z));
+	const u32 indices[36] = {
+		0, 1, 3, 0, 3, 2,	// -z
+		4, 6, 7, 4, 7, 5,	// +z
+		0, 2, 6, 0, 6, 4,	// -x
+		1, 5, 7, 1, 7, 3,	// +x
+		0, 4, 5, 0, 5, 1,	// -y
+		2, 3, 7, 2, 7, 6	// +y
+	};
+	culler.AddOccluder(vertices, 8, indices, 36, sht::math::Identity4());
+}
+
+int main()
+{
+	const Matrix4 projection = sht::math::PerspectiveMatrix(60.0f, kWidth, kHeight, 0.5f, 200.0f);
+	const Matrix4 view = sht::math::LookAt(Vector3(0.0f), Vector3(0.0f, 0.0f, -1.0f));
+	const Matrix4 projection_view = projection * view;
+
+	OcclusionCuller culler(kWidth, kHeight);
+	CHECK(culler.width() == kWidth && culler.height() == kHeight);
+	CHECK(culler.num_levels() == 9);
+
+	// Wall in front of camera, covers central part of the screen
+	culler.BeginFrame(projection_view);
+	AddBoxOccluder(culler, Vector3(0.0f, 0.0f, -10.0f), Vector3(4.0f, 3.0f, 0.5f));
+	culler.Rasterize();
+	CHECK(culler.stats().num_occluders == 1);
+	CHECK(culler.stats().num_triangles > 0);
+
+	// Depth of the wall face matches projection
+	const Vector3 face_point = projection_view * Vector3(0.0f, 0.0f, -9.5f);
+	const float center_depth = culler.depth_buffer()[(kHeight / 2) * kWidth + kWidth / 2];
+	CHECK(fabsf(center_depth - (face_point.z * 0.5f + 0.5f)) < 1e-4f);
+	CHECK(culler.depth_buffer()[0] == 1.0f);
+
+	const Vector3 small(0.5f);
+	CHECK(!culler.IsVisible(MakeBox(Vector3(0.0f, 0.0f, -20.0f), small)));		// right behind the wall
+	CHECK(!culler.IsVisible(MakeBox(Vector3(1.0f, 1.0f, -50.0f), Vector3(2.0f))));	// far behind
+	CHECK(culler.IsVisible(MakeBox(Vector3(0.0f, 0.0f, -5.0f), small)));			// in front of the wall
+	CHECK(culler.IsVisible(MakeBox(Vector3(12.0f, 0.0f, -20.0f), small)));		// beside the wall
+	CHECK(culler.IsVisible(MakeBox(Vector3(8.0f, 0.0f, -20.0f), Vector3(2.0f))));	// peeks from behind the edge
+	CHECK(culler.IsVisible(MakeBox(Vector3(0.0f), Vector3(1.0f))));			// crosses near plane
+	CHECK(!culler.IsVisible(MakeBox(Vector3(0.0f, 0.0f, 20.0f), small)));		// behind camera
+	CHECK(!culler.IsVisible(MakeBox(Vector3(500.0f, 0.0f, -20.0f), small)));	// out of screen
+
+	// Wall seen from the side at grazing angle must not hide boxes in front of it
+	culler.BeginFrame(projection_view);
+	AddBoxOccluder(culler, Vector3(3.0f, 0.0f, -30.0f), Vector3(0.1f, 5.0f, 25.0f));
+	culler.Rasterize();
+	CHECK(culler.IsVisible(MakeBox(Vector3(2.0f, 0.0f, -10.0f), small)));
+	CHECK(!culler.IsVisible(MakeBox(Vector3(10.0f, 0.0f, -40.0f), small)));
+
+	// Maze: rows of walls with gaps, grid of objects behind them
+	culler.BeginFrame(projection_view);
+	for (int row = 0; row < 4; ++row)
+		for (int segment = -3; segment <= 3; ++segment)
+			if ((segment + row) % 3 != 0)
+				AddBoxOccluder(culler, Vector3(segment * 6.0f, 0.0f, -12.0f - row * 15.0f), Vector3(2.5f, 4.0f, 0.5f));
+	culler.Rasterize();
+	std::vector<BoundingBox> objects;
+	for (int z = 0; z < 40; ++z)
+		for (int x = -25; x <= 25; ++x)
+			objects.push_back(MakeBox(Vector3(x * 1.5f, 0.0f, -8.0f - z * 2.0f), Vector3(0.4f)));
+	std::vector<u8> visible;
+	const u32 num_visible = culler.TestBoxes(objects.data(), static_cast<u32>(objects.size()), &visible);
+	const OcclusionCuller::Stats& stats = culler.stats();
+	CHECK(stats.num_tested == objects.size());
+	CHECK(stats.num_culled == objects.size() - num_visible);
+	CHECK(num_visible > 0 && num_visible < objects.size());
+	u32 mismatches = 0;
+	for (size_t i = 0; i < objects.size(); ++i)
+		if ((visible[i] != 0) != culler.IsVisible(objects[i]))
+			++mismatches;
+	CHECK(mismatches == 0);
+	printf("%u occluders, %u triangles: rasterized in %.3f ms, %u of %u boxes culled in %.3f ms\n",
+		stats.num_occluders, stats.num_triangles, stats.rasterize_seconds * 1000.0f,
+		stats.num_culled, stats.num_tested, stats.test_seconds * 1000.0f);
+
+	// Only visible objects reach render queue, packets without box are always drawn
+	sht::graphics::NullContext context;
+	TestShader shader(&context, 1);
+	RenderQueue queue(&context);
+	CommandBuffer * buffer = queue.AcquireCommandBuffer();
+	for (size_t i = 0; i < objects.size(); ++i)
+	{
+		buffer->AddDrawElements(RenderQueue::MakeOpaqueKey(0, 0, 0, -objects[i].center.z), &shader, 1,
+			PrimitiveType::kTriangles, 36, DataType::kUnsignedShort);
+		buffer->SetBoundingBox(objects[i]);
+	}
+	buffer = queue.AcquireCommandBuffer();
+	buffer->AddDrawArrays(0, &shader, 2, PrimitiveType::kTriangles, 0, 3);
+	queue.Cull(&culler);
+	CHECK(queue.stats().num_culled == objects.size() - num_visible);
+	queue.Sort();
+	CHECK(queue.num_packets() == num_visible + 1);
+	bool sorted_visible = true;
+	for (u32 i = 0; i < queue.num_packets(); ++i)
+	{
+		const sht::graphics::DrawPacket * packet = queue.sorted_packet(i);
+		sorted_visible = sorted_visible && packet->visible;
+	}
+	CHECK(sorted_visible);
+	queue.Submit();
+	CHECK(queue.stats().num_draws == num_visible + 1);
+	CHECK(queue.stats().num_culled == objects.size() - num_visible);
+	queue.Reset();
+	CHECK(queue.stats().num_culled == 0);
+
+	// Timing of a bigger occluder set
+	culler.BeginFrame(projection_view);
+	for (int i = 0; i < 200; ++i)
+		AddBoxOccluder(culler, Vector3((i % 20 - 10) * 3.0f, (i / 20 - 5) * 2.0f, -15.0f - (i % 7) * 5.0f), Vector3(1.0f));
+	culler.Rasterize();
+	printf("%u occluders, %u triangles: rasterized in %.3f ms\n",
+		culler.stats().num_occluders, culler.stats().num_triangles, culler.stats().rasterize_seconds * 1000.0f);
+
+	if (g_failures == 0)
+		printf("All checks passed\n");
+	else
+		printf("%d checks failed\n", g_failures);
+	return g_failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,16 @@
+#!/bin/sh
+# Builds occlusion culling test
+SHT=../../sht
+g++ main.cpp \
+	$SHT/math/*.cpp \
+	$SHT/graphics/src/renderer/context.cpp \
+	$SHT/graphics/src/renderer/null_context.cpp \
+	$SHT/graphics/src/renderer/occlusion_culler.cpp \
+	$SHT/graphics/src/renderer/render_queue.cpp \
+	$SHT/graphics/src/renderer/shader.cpp \
+	$SHT/graphics/src/renderer/texture.cpp \
+	$SHT/system/src/stream/*.cpp \
+	$SHT/system/src/tasks/parallel_for.cpp \
+	$SHT/system/src/time/clock.cpp \
+	$SHT/utility/src/string_id.cpp \
+	-O2 -std=c++11 -pthread -I../../ -I$SHT -o occlusion_culling
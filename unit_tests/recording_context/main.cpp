@@ -0,0 +1,160 @@
+#include "sht/graphics/include/renderer/recording_context.h"
+
+#include <stdio.h>
+#include <cstring>
+#include <string>
+
+using sht::graphics::BufferUsage;
+using sht::graphics::DataType;
+using sht::graphics::PrimitiveType;
+using sht::graphics::RecordingContext;
+
+/*
+Test for recording context.
+The same frames are recorded in different modes, replayed onto another context and compared,
+so statistics, payloads and replay are checked without graphics device.
+*/
+
+static int g_failures = 0;
+
+#define CHECK(condition) \
+	do { if (!(condition)) { printf("  FAILED: %s (line %d)\n", #condition, __LINE__); ++g_failures; } } while (0)
+
+const u32 kProgram = 100;
+const u32 kTexture = 200;
+
+//! Records two frames, color parameter lets make a different stream
+void RecordFrames(RecordingContext * context, float color)
+{
+	float vertices[16];
+	for (int i = 0; i < 16; ++i)
+		vertices[i] = static_cast<float>(i);
+	u32 vertex_buffer, index_buffer;
+
+	// Frame 1: resources creation and a couple of draws
+	context->NewFrame();
+	context->ClearColor(0.1f, 0.2f, 0.3f, 1.0f);
+	context->ClearColorAndDepthBuffers();
+	context->Viewport(640, 480);
+	context->GenVertexBuffer(vertex_buffer);
+	context->BindVertexBuffer(vertex_buffer);
+	context->VertexBufferData(sizeof(vertices), vertices, BufferUsage::kStaticDraw);
+	context->GenIndexBuffer(index_buffer);
+	context->BindIndexBuffer(index_buffer);
+	context->IndexBufferData(12, nullptr, BufferUsage::kDynamicDraw);
+	context->VertexAttribPointer(0, 4, DataType::kFloat, 16, nullptr);
+	context->EnableVertexAttribArray(0);
+	context->BindProgram(kProgram);
+	context->Uniform4f(kProgram, "u_color", color, 0.0f, 0.0f, 1.0f);
+	context->DrawArrays(PrimitiveType::kTriangles, 0, 3);
+	context->DrawElementsInstanced(PrimitiveType::kTriangles, 6, DataType::kUnsignedShort, 10);
+	context->EndFrame();
+
+	// Frame 2: redundant state, mapped buffer, texture upload and multi draw
+	context->NewFrame();
+	context->Viewport(640, 480);
+	context->BindVertexBuffer(vertex_buffer);
+	float * mapped = reinterpret_cast<float*>(context->MapVertexBufferRange(16, 16));
+	for (int i = 0; i < 4; ++i)
+		mapped[i] = color + i;
+	context->UnmapVertexBufferData();
+	const u8 pixels[4 * 4 * 4] = { 0 };
+	context->ActiveTexture(1);
+	context->BindTexture(0x0DE1, kTexture);
+	context->TextureImage2D(0x0DE1, 0, 0x1908, 4, 4, 0x1908, 0x1401, pixels);
+	const float matrix[16] = { 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f };
+	context->SetUniformMatrix4fv(3, matrix);
+	const u32 counts[2] = { 3, 6 };
+	const u32 firsts[2] = { 0, 3 };
+	const s32 bases[2] = { 0, 4 };
+	context->MultiDrawElementsBaseVertex(PrimitiveType::kTriangles, counts, DataType::kUnsignedShort, firsts, bases, 2);
+	context->EndFrame();
+}
+
+int main()
+{
+	RecordingContext recorded;
+	RecordFrames(&recorded, 0.5f);
+
+	// Statistics per frame
+	CHECK(recorded.num_frames() == 2);
+	const RecordingContext::FrameStats& first = recorded.frame_stats(0);
+	CHECK(first.draw_calls == 2);
+	CHECK(first.vertices == 3 + 6 * 10);
+	CHECK(first.binds == 3);
+	CHECK(first.state_changes == 4); // clear color, viewport, attrib pointer and attrib array
+	CHECK(first.uniform_uploads == 1);
+	CHECK(first.uploaded_bytes == 64);
+	const RecordingContext::FrameStats& second = recorded.frame_stats(1);
+	CHECK(second.draw_calls == 1);
+	CHECK(second.vertices == 9);
+	CHECK(second.binds == 1); // vertex buffer is still bound, only texture bind reaches backend
+	CHECK(second.state_changes == 1); // viewport is cached, active texture is not
+	CHECK(second.uniform_uploads == 1);
+	CHECK(second.uploaded_bytes == 16 + 64);
+	const RecordingContext::FrameStats total = recorded.GetTotalStats();
+	CHECK(total.commands == first.commands + second.commands);
+	CHECK(total.commands == recorded.num_commands());
+	printf("recorded %u commands, %u draws, %u bytes uploaded\n",
+		total.commands, total.draw_calls, static_cast<u32>(total.uploaded_bytes));
+
+	// Payloads and description
+	bool found_uniform = false;
+	for (u32 i = 0; i < recorded.num_commands(); ++i)
+	{
+		if (recorded.command(i).type == RecordingContext::CommandType::kUniform)
+		{
+			found_uniform = true;
+			CHECK(strcmp(reinterpret_cast<const char*>(recorded.command_data(i)), "u_color") == 0);
+			const std::string text = recorded.DescribeCommand(i);
+			CHECK(text.find("Uniform(100") == 0);
+			CHECK(text.find("\"u_color\"") != std::string::npos);
+		}
+	}
+	CHECK(found_uniform);
+
+	// Replay gives the same stream
+	RecordingContext replayed;
+	recorded.Replay(&replayed);
+	u32 difference = 0;
+	CHECK(replayed.num_commands() == recorded.num_commands());
+	CHECK(recorded.Compare(replayed, &difference));
+
+	// Different uniform value and mapped data are detected
+	RecordingContext changed;
+	RecordFrames(&changed, 0.25f);
+	CHECK(!recorded.Compare(changed, &difference));
+	CHECK(recorded.command(difference).type == RecordingContext::CommandType::kUniform);
+
+	// Without data stream is smaller and replay doesn't touch missing payloads
+	RecordingContext commands_only;
+	commands_only.set_mode(RecordingContext::Mode::kCommands);
+	RecordFrames(&commands_only, 0.5f);
+	CHECK(commands_only.num_commands() == recorded.num_commands());
+	CHECK(!recorded.Compare(commands_only, &difference));
+	RecordingContext replayed_commands;
+	commands_only.Replay(&replayed_commands);
+	CHECK(replayed_commands.num_commands() == commands_only.num_commands());
+
+	// Statistics mode keeps counters only
+	RecordingContext statistics;
+	statistics.set_mode(RecordingContext::Mode::kStatistics);
+	RecordFrames(&statistics, 0.5f);
+	CHECK(statistics.num_commands() == 0);
+	const RecordingContext::FrameStats stats_total = statistics.GetTotalStats();
+	CHECK(stats_total.commands == total.commands);
+	CHECK(stats_total.draw_calls == total.draw_calls);
+	CHECK(stats_total.vertices == total.vertices);
+	CHECK(stats_total.binds == total.binds);
+	CHECK(stats_total.uploaded_bytes == total.uploaded_bytes);
+
+	// Clear starts from scratch
+	recorded.Clear();
+	CHECK(recorded.num_commands() == 0 && recorded.num_frames() == 0);
+
+	if (g_failures)
+		printf("%d checks failed\n", g_failures);
+	else
+		printf("All checks passed\n");
+	return g_failures ? 1 : 0;
+}
@@ -0,0 +1,8 @@
+#!/bin/sh
+# Builds recording context test
+SHT=../../sht
+g++ main.cpp \
+	$SHT/graphics/src/renderer/context.cpp \
+	$SHT/graphics/src/renderer/null_context.cpp \
+	$SHT/graphics/src/renderer/recording_context.cpp \
+	-O2 -std=c++11 -I../../ -I$SHT -o recording_context
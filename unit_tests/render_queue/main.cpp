@@ -0,0 +1,221 @@
+#include "sht/graphics/include/renderer/null_context.h"
+#include "sht/graphics/include/renderer/render_queue.h"
+#include "sht/system/include/tasks/parallel_for.h"
+
+#include <stdio.h>
+#include <vector>
+
+using sht::graphics::CommandBuffer;
+using sht::graphics::DataType;
+using sht::graphics::DrawPacket;
+using sht::graphics::Image;
+using sht::graphics::PrimitiveType;
+using sht::graphics::RenderQueue;
+using sht::graphics::Shader;
+using sht::graphics::Texture;
+using sht::graphics::UniformHandle;
+using sht::graphics::UniformInfo;
+
+/*
+Test for sort-key based render queue.
+Objects of a scene are recorded in random order from several threads,
+queue has to group them by shader and material and draw translucent objects back to front.
+*/
+
+static int g_failures = 0;
+
+#define CHECK(condition) \
+	do { if (!(condition)) { printf("  FAILED: %s (line %d)\n", #condition, __LINE__); ++g_failures; } } while (0)
+
+enum {
+	kModel = 1,
+	kAlpha
+};
+
+const int kNumShaders = 8;
+const int kNumMaterials = 16;
+const int kNumOpaque = 4000;
+const int kNumTranslucent = 500;
+
+//! Context that counts calls reaching the API
+class RecordingContext : public sht::graphics::NullContext {
+public:
+	RecordingContext()
+	: num_program_binds(0), num_texture_binds(0), num_draws(0), num_uniforms(0)
+	{
+	}
+	void GetActiveUniforms(u32 program, std::vector<UniformInfo> * uniforms)
+	{
+		const UniformInfo kUniforms[] = {
+			{ "u_model", kModel, 0, 64, 1 },
+			{ "u_alpha", kAlpha, 0, 4, 1 },
+		};
+		uniforms->assign(kUniforms, kUniforms + sizeof(kUniforms) / sizeof(kUniforms[0]));
+	}
+	void SetUniform1f(s32 location, float x) { ++num_uniforms; }
+	void SetUniformMatrix4fv(s32 location, const float *v, bool trans, int n) { ++num_uniforms; }
+	void DrawArrays(PrimitiveType mode, s32 first, u32 count) { ++num_draws; }
+	void DrawElements(PrimitiveType mode, u32 num_indices, DataType index_type) { ++num_draws; }
+
+	int num_program_binds;
+	int num_texture_binds;
+	int num_draws;
+	int num_uniforms;
+
+protected:
+	void ApiBindProgram(u32 program) { ++num_program_binds; }
+	void ApiBindTexture(u32 target, u32 obj) { ++num_texture_binds; }
+};
+
+//! Shader with program created outside
+class TestShader : public Shader {
+public:
+	TestShader(sht::graphics::Context * context, u32 program)
+	: Shader(context)
+	{
+		program_ = program;
+		ReflectUniforms();
+	}
+	~TestShader()
+	{
+	}
+};
+
+class FakeTexture : public Texture {
+public:
+	explicit FakeTexture(u32 id)
+	{
+		width_ = 1;
+		height_ = 1;
+		format_ = Image::Format::kRGBA8;
+		texture_id_ = id;
+		ChooseTarget();
+	}
+	~FakeTexture()
+	{
+	}
+	u32 GetSrcFormat() { return 0x1908; }
+	u32 GetSrcType() { return 0x1401; }
+	s32 GetInternalFormat() { return 0x8058; }
+
+protected:
+	void ChooseTarget() { target_ = 0x0DE1; }
+};
+
+//! Deterministic pseudo random order of objects
+static int Shuffle(int index, int count)
+{
+	return static_cast<int>((static_cast<u64>(index) * 7919ULL + 13ULL) % static_cast<u64>(count));
+}
+
+static void RecordScene(RenderQueue * queue, const std::vector<Shader*>& shaders,
+	const std::vector<Texture*>& textures, UniformHandle model, UniformHandle alpha)
+{
+	float matrix[16] = { 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f,
+		0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f };
+	sht::system::ParallelFor(0, kNumOpaque + kNumTranslucent, [&](int begin, int end)
+	{
+		CommandBuffer * buffer = queue->AcquireCommandBuffer();
+		for (int i = begin; i < end; ++i)
+		{
+			if (i < kNumOpaque)
+			{
+				int object = Shuffle(i, kNumOpaque);
+				int shader = object % kNumShaders;
+				int material = (object / kNumShaders) % kNumMaterials;
+				f32 depth = static_cast<f32>(object) / static_cast<f32>(kNumOpaque);
+				u64 key = RenderQueue::MakeOpaqueKey(0, shader, material, depth);
+				buffer->AddDrawElements(key, shaders[shader], 1 + shader, PrimitiveType::kTriangles,
+					36, DataType::kUnsignedShort);
+				buffer->SetTexture(0, textures[material]);
+				buffer->UniformMatrix4fv(model, matrix);
+			}
+			else
+			{
+				// Translucent object index is stored as first vertex to check the order
+				int object = Shuffle(i - kNumOpaque, kNumTranslucent);
+				f32 depth = static_cast<f32>(object) / static_cast<f32>(kNumTranslucent);
+				u64 key = RenderQueue::MakeTranslucentKey(1, depth, 0, object % kNumMaterials);
+				buffer->AddDrawArrays(key, shaders[0], 1, PrimitiveType::kTriangles, object, 6);
+				buffer->SetTexture(0, textures[object % kNumMaterials]);
+				buffer->Uniform1f(alpha, 0.5f);
+			}
+		}
+	}, 256);
+}
+
+int main()
+{
+	RecordingContext context;
+	std::vector<Shader*> shaders;
+	for (int i = 0; i < kNumShaders; ++i)
+		shaders.push_back(new TestShader(&context, 100 + i));
+	std::vector<Texture*> textures;
+	for (int i = 0; i < kNumMaterials; ++i)
+		textures.push_back(new FakeTexture(200 + i));
+	UniformHandle model = shaders[0]->GetUniformHandle("u_model");
+	UniformHandle alpha = shaders[0]->GetUniformHandle("u_alpha");
+	CHECK(model.valid() && alpha.valid());
+
+	RenderQueue queue(&context);
+	for (int frame = 0; frame < 2; ++frame)
+	{
+		context.NewFrame();
+		context.InvalidateState();
+		context.num_program_binds = 0;
+		context.num_texture_binds = 0;
+		context.num_draws = 0;
+
+		RecordScene(&queue, shaders, textures, model, alpha);
+		queue.Sort();
+		CHECK(queue.num_packets() == kNumOpaque + kNumTranslucent);
+
+		// Keys are ordered
+		bool ordered = true;
+		for (u32 i = 1; i < queue.num_packets(); ++i)
+			if (queue.sorted_packet(i - 1)->key > queue.sorted_packet(i)->key)
+				ordered = false;
+		CHECK(ordered);
+
+		// Translucent objects go after opaque ones back to front
+		bool back_to_front = true;
+		for (u32 i = kNumOpaque; i < queue.num_packets(); ++i)
+		{
+			const DrawPacket * packet = queue.sorted_packet(i);
+			if (packet->indexed || packet->first != static_cast<s32>(kNumTranslucent - 1 - (i - kNumOpaque)))
+				back_to_front = false;
+		}
+		CHECK(back_to_front);
+
+		queue.Submit();
+		const RenderQueue::Stats& stats = queue.stats();
+		printf("frame %d: %u draws, %d program binds, %d texture binds\n",
+			frame, stats.num_draws, context.num_program_binds, context.num_texture_binds);
+		CHECK(stats.num_draws == kNumOpaque + kNumTranslucent);
+		CHECK(context.num_draws == kNumOpaque + kNumTranslucent);
+		// Each shader is bound once for opaque pass, translucent pass uses first one
+		CHECK(context.num_program_binds == kNumShaders + 1);
+		// Materials are contiguous within a shader group
+		CHECK(context.num_texture_binds <= kNumShaders * kNumMaterials + kNumTranslucent);
+
+		queue.Reset();
+		CHECK(queue.num_packets() == 0);
+	}
+
+	// Depth is clamped
+	CHECK(RenderQueue::MakeOpaqueKey(0, 1, 1, -1.0f) == RenderQueue::MakeOpaqueKey(0, 1, 1, 0.0f));
+	CHECK(RenderQueue::MakeOpaqueKey(0, 1, 1, 2.0f) == RenderQueue::MakeOpaqueKey(0, 1, 1, 1.0f));
+	// Pass has priority over everything else
+	CHECK(RenderQueue::MakeOpaqueKey(0, 4095, 65535, 1.0f) < RenderQueue::MakeTranslucentKey(1, 1.0f, 0, 0));
+
+	for (auto texture : textures)
+		delete static_cast<FakeTexture*>(texture);
+	for (auto shader : shaders)
+		delete static_cast<TestShader*>(shader);
+
+	if (g_failures)
+		printf("%d checks failed\n", g_failures);
+	else
+		printf("All checks passed\n");
+	return g_failures ? 1 : 0;
+}
@@ -0,0 +1,186 @@
+#include "sht/graphics/include/renderer/null_context.h"
+#include "sht/graphics/include/renderer/ring_buffer.h"
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <map>
+#include <vector>
+
+using sht::graphics::BufferUsage;
+using sht::graphics::RingAllocation;
+using sht::graphics::RingBuffer;
+using sht::graphics::SyncObject;
+
+/*
+Test for ring buffer of transient vertex data.
+GPU is simulated by context: it finishes frame after given number of frames,
+ring buffer must never hand out memory that GPU may still read.
+*/
+
+static int g_failures = 0;
+
+#define CHECK(condition) \
+	do { if (!(condition)) { printf("  FAILED: %s (line %d)\n", #condition, __LINE__); ++g_failures; } } while (0)
+
+//! Context that simulates GPU latency
+class GpuContext : public sht::graphics::NullContext {
+public:
+	GpuContext(u32 latency, bool fences, bool persistent)
+	: latency(latency), fences(fences), persistent(persistent)
+	, cpu_frame(0), forced_frame(-1), num_maps(0), num_orphans(0), last_fence(0)
+	{
+	}
+	void VertexBufferData(u32 size, const void *data, BufferUsage usage)
+	{
+		NullContext::VertexBufferData(size, data, usage);
+		++num_orphans;
+	}
+	void* MapVertexBufferRange(u32 offset, u32 size)
+	{
+		++num_maps;
+		return NullContext::MapVertexBufferRange(offset, size);
+	}
+	void* MapVertexBufferPersistent(u32 size)
+	{
+		if (!persistent)
+			return nullptr;
+		storage.resize(size);
+		return &storage[0];
+	}
+	SyncObject FenceSync()
+	{
+		if (!fences)
+			return nullptr;
+		fence_frames[++last_fence] = cpu_frame;
+		return reinterpret_cast<SyncObject>(static_cast<uintptr_t>(last_fence));
+	}
+	bool ClientWaitSync(SyncObject sync, u64 timeout_ns)
+	{
+		int frame = fence_frames[reinterpret_cast<uintptr_t>(sync)];
+		if (IsFinished(frame))
+			return true;
+		if (timeout_ns == 0)
+			return false;
+		// Waiting lets GPU finish the frame
+		if (frame > forced_frame)
+			forced_frame = frame;
+		return true;
+	}
+	void DeleteSync(SyncObject sync)
+	{
+		fence_frames.erase(reinterpret_cast<uintptr_t>(sync));
+	}
+	bool IsFinished(int frame) const
+	{
+		return frame + static_cast<int>(latency) <= cpu_frame || frame <= forced_frame;
+	}
+
+	u32 latency;
+	bool fences;
+	bool persistent;
+	int cpu_frame;
+	int forced_frame;
+	int num_maps;
+	int num_orphans;
+	uintptr_t last_fence;
+	std::map<uintptr_t, int> fence_frames;
+	std::vector<u8> storage;
+};
+
+struct Region {
+	int frame;
+	u32 offset;
+	u32 size;
+};
+
+//! Runs frames with given allocation sizes and checks that regions in use are never reused
+static bool RunFrames(GpuContext * context, RingBuffer * ring, int num_frames, const std::vector<u32>& sizes)
+{
+	std::vector<Region> regions;
+	bool valid = true;
+	for (int frame = 0; frame < num_frames; ++frame)
+	{
+		for (u32 size : sizes)
+		{
+			RingAllocation allocation = ring->Map(size);
+			if (allocation.pointer == nullptr)
+				return false;
+			if (allocation.offset + size > ring->size() || allocation.offset % 16 != 0)
+				valid = false;
+			memset(allocation.pointer, frame & 0xFF, size);
+			ring->Unmap();
+			if (context->fences)
+				for (const auto& region : regions)
+					if (!context->IsFinished(region.frame) &&
+						allocation.offset < region.offset + region.size &&
+						region.offset < allocation.offset + size)
+						valid = false;
+			Region region = { context->cpu_frame, allocation.offset, size };
+			regions.push_back(region);
+		}
+		ring->EndFrame();
+		++context->cpu_frame;
+	}
+	return valid;
+}
+
+int main()
+{
+	const std::vector<u32> kTextSizes = { 1000, 3000, 200 };
+
+	// Enough space for frames in flight: no waits at all
+	{
+		GpuContext context(2, true, false);
+		RingBuffer ring(&context, 16384);
+		CHECK(!ring.persistent());
+		CHECK(RunFrames(&context, &ring, 100, kTextSizes));
+		printf("fenced: %u allocations, %u waits\n", ring.stats().num_allocations, ring.stats().num_waits);
+		CHECK(ring.stats().num_allocations == 300);
+		CHECK(ring.stats().num_waits == 0);
+		CHECK(ring.stats().num_orphans == 0);
+		CHECK(context.num_maps == 300);
+		CHECK(ring.frame() == 100);
+		// Signaled fences are released at the end of frame
+		CHECK(context.fence_frames.size() <= 2);
+	}
+	// Small buffer: CPU has to wait for GPU but never overwrites data in use
+	{
+		GpuContext context(3, true, false);
+		RingBuffer ring(&context, 8192);
+		CHECK(RunFrames(&context, &ring, 100, kTextSizes));
+		printf("small fenced: %u allocations, %u waits\n", ring.stats().num_allocations, ring.stats().num_waits);
+		CHECK(ring.stats().num_waits > 0);
+	}
+	// Persistent mapping: no map calls
+	{
+		GpuContext context(2, true, true);
+		RingBuffer ring(&context, 16384);
+		CHECK(ring.persistent());
+		CHECK(RunFrames(&context, &ring, 10, kTextSizes));
+		CHECK(context.num_maps == 0);
+		RingAllocation allocation = ring.Map(64);
+		CHECK(allocation.pointer == &context.storage[allocation.offset]);
+		ring.Unmap();
+		ring.EndFrame();
+	}
+	// Without fences buffer is orphaned on wrap
+	{
+		GpuContext context(2, false, false);
+		RingBuffer ring(&context, 16384);
+		context.num_orphans = 0;
+		CHECK(RunFrames(&context, &ring, 100, kTextSizes));
+		printf("orphaning: %u allocations, %u orphans\n", ring.stats().num_allocations, ring.stats().num_orphans);
+		CHECK(ring.stats().num_waits == 0);
+		CHECK(ring.stats().num_orphans > 0);
+		CHECK(static_cast<u32>(context.num_orphans) == ring.stats().num_orphans);
+		// Each lap holds at least three frames
+		CHECK(ring.stats().num_orphans <= 100 / 3);
+	}
+
+	if (g_failures)
+		printf("%d checks failed\n", g_failures);
+	else
+		printf("All checks passed\n");
+	return g_failures ? 1 : 0;
+}
@@ -0,0 +1,8 @@
+#!/bin/sh
+# Builds ring buffer test
+SHT=../../sht
+g++ main.cpp \
+	$SHT/graphics/src/renderer/context.cpp \
+	$SHT/graphics/src/renderer/null_context.cpp \
+	$SHT/graphics/src/renderer/ring_buffer.cpp \
+	-O2 -std=c++11 -I../../ -I$SHT -o ring_buffer
@@ -0,0 +1,291 @@
+#include "sht/graphics/include/model/scm_file.h"
+#include "sht/graphics/include/renderer/vertex_packing.h"
+#include "sht/system/include/stream/mapped_file.h"
+#include "sht/system/include/time/clock.h"
+
+#include <stdio.h>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+using sht::graphics::ScmCompression;
+using sht::graphics::ScmLod;
+using sht::graphics::ScmMesh;
+using sht::graphics::ScmNode;
+using sht::graphics::ScmReader;
+using sht::graphics::ScmWriter;
+using sht::graphics::Vertex;
+using sht::graphics::VertexAttribute;
+using sht::graphics::VertexPacker;
+
+/*
+Test for SCM version 2 files.
+Data must come back exactly for every compression, uncompressed sections must be aligned
+and used right from mapped file, hierarchy must cover all meshes. Big mesh is a benchmark.
+*/
+
+static int g_failures = 0;
+
+#define CHECK(condition) \
+	do { if (!(condition)) { printf("  FAILED: %s (line %d)\n", #condition, __LINE__); ++g_failures; } } while (0)
+
+static const char * kFilename = "test.scm";
+
+//! Packed sphere data as it would be stored
+struct PackedMesh {
+	std::vector<VertexAttribute> attribs;
+	u32 vertex_size;
+	sht::graphics::VertexQuantization quantization;
+	std::vector<u8> vertices;
+	u32 num_vertices;
+	std::vector<u8> indices;
+	u32 index_size;
+	u32 num_indices;
+};
+
+static void MakeSphere(int slices, int stacks, u32 compression, PackedMesh * mesh)
+{
+	const float kPi = 3.1415926535f;
+	std::vector<Vertex> vertices;
+	for (int j = 0; j <= stacks; ++j)
+		for (int i = 0; i <= slices; ++i)
+		{
+			float theta = kPi * (float)j / stacks;
+			float phi = 2.0f * kPi * (float)i / slices;
+			Vertex v = Vertex();
+			v.normal = vec3(sinf(theta) * cosf(phi), cosf(theta), sinf(theta) * sinf(phi));
+			v.position = v.normal * 10.0f;
+			v.texcoord = vec2((float)i / slices, (float)j / stacks);
+			v.tangent = vec3(-sinf(phi), 0.0f, cosf(phi));
+			v.binormal = v.normal ^ v.tangent;
+			vertices.push_back(v);
+		}
+	std::vector<u32> indices;
+	for (int j = 0; j < stacks; ++j)
+		for (int i = 0; i < slices; ++i)
+		{
+			u32 a = j * (slices + 1) + i;
+			u32 quad[6] = { a, a + 1, a + slices + 2, a, a + slices + 2, a + slices + 1 };
+			indices.insert(indices.end(), quad, quad + 6);
+		}
+
+	mesh->attribs.clear();
+	mesh->attribs.push_back(VertexAttribute(VertexAttribute::kVertex, 3));
+	mesh->attribs.push_back(VertexAttribute(VertexAttribute::kNormal, 3));
+	mesh->attribs.push_back(VertexAttribute(VertexAttribute::kTexcoord, 2));
+	mesh->attribs.push_back(VertexAttribute(VertexAttribute::kTangent, 3));
+	VertexPacker packer(compression);
+	packer.AddVertices(vertices);
+	packer.ChooseFormats(&mesh->attribs);
+	mesh->quantization = packer.quantization();
+	mesh->vertex_size = 0;
+	for (const auto& a : mesh->attribs)
+		mesh->vertex_size += sht::graphics::GetAttributeSize(a.format, a.size);
+	mesh->num_vertices = (u32)vertices.size();
+	mesh->vertices.resize(vertices.size() * mesh->vertex_size);
+	packer.Pack(vertices, mesh->attribs, mesh->vertex_size, &mesh->vertices[0]);
+	mesh->num_indices = (u32)indices.size();
+	mesh->index_size = (vertices.size() > 0x10000) ? sizeof(u32) : sizeof(u16);
+	mesh->indices.resize(indices.size() * mesh->index_size);
+	for (size_t i = 0; i < indices.size(); ++i)
+	{
+		if (mesh->index_size == sizeof(u16))
+			reinterpret_cast<u16*>(&mesh->indices[0])[i] = static_cast<u16>(indices[i]);
+		else
+			reinterpret_cast<u32*>(&mesh->indices[0])[i] = indices[i];
+	}
+}
+
+static ScmMesh DescribeMesh(const PackedMesh& mesh, const vec3& center, u32 material_index)
+{
+	ScmMesh data;
+	data.material_index = material_index;
+	data.primitive_mode = 0;
+	data.bounding_box.center = center;
+	data.bounding_box.extent = vec3(10.0f);
+	data.vertices = &mesh.vertices[0];
+	data.num_vertices = mesh.num_vertices;
+	data.indices = &mesh.indices[0];
+	data.num_indices = mesh.num_indices;
+	data.index_size = mesh.index_size;
+	// Second level reuses half of indices
+	ScmLod lods[2] = { { 0, mesh.num_indices, 0.0f, 0 }, { 0, mesh.num_indices / 6 * 3, 0.5f, 0 } };
+	data.lods.assign(lods, lods + 2);
+	return data;
+}
+
+static bool Save(const PackedMesh& mesh, ScmCompression compression, int num_meshes)
+{
+	ScmWriter writer;
+	writer.set_compression(compression);
+	writer.SetVertexFormat(mesh.attribs, mesh.vertex_size, mesh.quantization);
+	sht::math::BoundingBox box;
+	box.center = vec3(0.0f);
+	box.extent = vec3(10.0f + 30.0f * num_meshes);
+	writer.SetBoundingBox(box);
+	sht::graphics::Material material = sht::graphics::Material();
+	material.diffuse = vec3(0.5f, 0.25f, 1.0f);
+	material.dissolve = 1.0f;
+	writer.AddMaterial(material);
+	for (int i = 0; i < num_meshes; ++i)
+		writer.AddMesh(DescribeMesh(mesh, vec3(30.0f * i, 0.0f, 0.0f), 0));
+	return writer.Save(kFilename);
+}
+
+static u64 FileSize()
+{
+	sht::system::MappedFile file;
+	if (!file.Open(kFilename))
+		return 0;
+	return file.size();
+}
+
+//! Checks hierarchy of random boxes: every mesh is met once and parents contain children
+static void CheckHierarchy(int num_boxes)
+{
+	std::vector<sht::math::BoundingBox> boxes(num_boxes);
+	for (auto& box : boxes)
+	{
+		box.center = vec3((float)(rand() % 1000), (float)(rand() % 100), (float)(rand() % 1000));
+		box.extent = vec3(1.0f + (float)(rand() % 10));
+	}
+	std::vector<ScmNode> nodes;
+	sht::graphics::BuildScmHierarchy(boxes, &nodes);
+	CHECK(nodes.size() == 2 * boxes.size() - 1);
+	std::vector<int> met(boxes.size(), 0);
+	for (size_t i = 0; i < nodes.size(); ++i)
+	{
+		const ScmNode& node = nodes[i];
+		CHECK(node.skip > i && node.skip <= nodes.size());
+		if (node.mesh >= 0)
+		{
+			CHECK(node.skip == i + 1);
+			++met[node.mesh];
+		}
+		// Every node of subtree is inside
+		vec3 min = node.bounding_box.center - node.bounding_box.extent - vec3(1e-3f);
+		vec3 max = node.bounding_box.center + node.bounding_box.extent + vec3(1e-3f);
+		for (size_t j = i + 1; j < node.skip; ++j)
+		{
+			vec3 child_min = nodes[j].bounding_box.center - nodes[j].bounding_box.extent;
+			vec3 child_max = nodes[j].bounding_box.center + nodes[j].bounding_box.extent;
+			CHECK(child_min.x >= min.x && child_min.y >= min.y && child_min.z >= min.z);
+			CHECK(child_max.x <= max.x && child_max.y <= max.y && child_max.z <= max.z);
+		}
+	}
+	for (size_t i = 0; i < met.size(); ++i)
+		CHECK(met[i] == 1);
+}
+
+int main()
+{
+	const ScmCompression kCompressions[3] = { ScmCompression::kNone, ScmCompression::kDeflate, ScmCompression::kFiltered };
+	const char * kCompressionNames[3] = { "none", "deflate", "filtered" };
+
+	// Round trip of every compression with float and compact vertex formats
+	for (u32 vertex_compression = 0; vertex_compression <= sht::graphics::kCompressAll; vertex_compression += 7)
+	{
+		PackedMesh mesh;
+		MakeSphere(64, 32, vertex_compression, &mesh);
+		CHECK(mesh.index_size == sizeof(u16));
+		for (int c = 0; c < 3; ++c)
+		{
+			CHECK(Save(mesh, kCompressions[c], 3));
+			ScmReader reader;
+			CHECK(reader.Open(kFilename));
+			CHECK(reader.vertex_size() == mesh.vertex_size);
+			CHECK(reader.attribs().size() == mesh.attribs.size());
+			for (size_t i = 0; i < reader.attribs().size() && i < mesh.attribs.size(); ++i)
+			{
+				CHECK(reader.attribs()[i].type == mesh.attribs[i].type);
+				CHECK(reader.attribs()[i].size == mesh.attribs[i].size);
+				CHECK(reader.attribs()[i].format == mesh.attribs[i].format);
+			}
+			CHECK(reader.quantization().scale == mesh.quantization.scale);
+			CHECK(reader.materials().size() == 1 && reader.materials()[0].diffuse.y == 0.25f);
+			CHECK(reader.meshes().size() == 3);
+			CHECK(reader.hierarchy().size() == 5);
+			for (const auto& data : reader.meshes())
+			{
+				CHECK(data.num_vertices == mesh.num_vertices);
+				CHECK(data.num_indices == mesh.num_indices);
+				CHECK(data.index_size == sizeof(u16));
+				CHECK(memcmp(data.vertices, &mesh.vertices[0], mesh.vertices.size()) == 0);
+				CHECK(memcmp(data.indices, &mesh.indices[0], mesh.indices.size()) == 0);
+				CHECK(data.lods.size() == 2 && data.lods[1].error == 0.5f);
+				if (kCompressions[c] == ScmCompression::kNone)
+				{
+					CHECK(reinterpret_cast<size_t>(data.vertices) % sht::graphics::kScmAlignment == 0);
+					CHECK(reinterpret_cast<size_t>(data.indices) % sht::graphics::kScmAlignment == 0);
+				}
+			}
+			// Uncompressed data is not copied at all
+			if (kCompressions[c] == ScmCompression::kNone)
+				CHECK(reader.num_decompressed_bytes() == 0);
+			else
+				CHECK(reader.num_decompressed_bytes() == 3 * (mesh.vertices.size() + mesh.indices.size()));
+			printf("vertex size %2u, %-8s: %u bytes\n", mesh.vertex_size, kCompressionNames[c], (u32)FileSize());
+		}
+	}
+
+	// Wide indices
+	{
+		PackedMesh mesh;
+		MakeSphere(512, 256, sht::graphics::kCompressNone, &mesh);
+		CHECK(mesh.index_size == sizeof(u32));
+		CHECK(Save(mesh, ScmCompression::kFiltered, 1));
+		ScmReader reader;
+		CHECK(reader.Open(kFilename));
+		CHECK(reader.meshes().size() == 1 && reader.meshes()[0].index_size == sizeof(u32));
+		CHECK(reader.meshes().size() == 1 &&
+			memcmp(reader.meshes()[0].indices, &mesh.indices[0], mesh.indices.size()) == 0);
+	}
+
+	// Broken and foreign files are rejected
+	{
+		FILE * file = fopen(kFilename, "wb");
+		const char kText[] = "v 0 0 0\nv 1 0 0\nv 0 1 0\nf 1 2 3\n";
+		fwrite(kText, 1, sizeof(kText), file);
+		fclose(file);
+		ScmReader reader;
+		CHECK(!reader.Open(kFilename));
+		CHECK(ScmReader::ReadVersion(kFilename) == 0);
+		CHECK(!reader.Open("missing.scm"));
+	}
+
+	CheckHierarchy(1);
+	CheckHierarchy(2);
+	CheckHierarchy(100);
+
+	// Benchmark
+	{
+		PackedMesh mesh;
+		MakeSphere(1024, 512, sht::graphics::kCompressAll, &mesh);
+		const u64 raw_size = mesh.vertices.size() + mesh.indices.size();
+		printf("%u vertices, %u triangles, %u bytes of data\n", mesh.num_vertices, mesh.num_indices / 3, (u32)raw_size);
+		for (int c = 0; c < 3; ++c)
+		{
+			sht::system::Clock clock;
+			clock.MakeStartPoint();
+			CHECK(Save(mesh, kCompressions[c], 1));
+			float save_time = clock.GetTime();
+			clock.MakeStartPoint();
+			ScmReader reader;
+			CHECK(reader.Open(kFilename));
+			float load_time = clock.GetTime();
+			CHECK(reader.meshes().size() == 1 &&
+				memcmp(reader.meshes()[0].vertices, &mesh.vertices[0], mesh.vertices.size()) == 0);
+			u64 file_size = FileSize();
+			printf("%-8s: %.1f%% of data, save %.1f ms, load %.2f ms\n", kCompressionNames[c],
+				100.0f * (float)file_size / (float)raw_size, save_time * 1000.0f, load_time * 1000.0f);
+		}
+	}
+	remove(kFilename);
+
+	if (g_failures == 0)
+		printf("All checks passed\n");
+	else
+		printf("%d checks failed\n", g_failures);
+	return g_failures == 0 ? 0 : 1;
+}
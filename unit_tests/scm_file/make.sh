@@ -0,0 +1,17 @@
+#!/bin/sh
+# Builds SCM file test together with bundled zlib
+SHT=../../sht
+THIRDPARTY=$SHT/thirdparty
+mkdir -p obj
+for f in $THIRDPARTY/zlib/src/*.c; do
+	gcc -O2 -c $f -I$THIRDPARTY/zlib/include -I$THIRDPARTY/zlib/src -o obj/$(basename $f).o
+done
+g++ main.cpp \
+	$SHT/graphics/src/model/scm_file.cpp \
+	$SHT/graphics/src/model/vertex_packer.cpp \
+	$SHT/graphics/src/renderer/vertex_packing.cpp \
+	$SHT/system/src/stream/*.cpp \
+	$SHT/system/src/time/clock.cpp \
+	$SHT/math/*.cpp \
+	obj/*.o \
+	-O2 -std=c++11 -I../../ -I$SHT -o scm_file
@@ -0,0 +1,168 @@
+#include "sht/graphics/include/image/image.h"
+#include "sht/graphics/include/renderer/null_context.h"
+#include "sht/graphics/include/renderer/screenshot_queue.h"
+#include "sht/system/include/filesystem/directory.h"
+#include "sht/system/include/time/clock.h"
+
+#include <stdio.h>
+#include <cstdint>
+#include <cstring>
+#include <map>
+
+using sht::graphics::Image;
+using sht::graphics::ScreenshotQueue;
+using sht::graphics::SyncObject;
+
+/*
+Test and benchmark for asynchronous screenshots.
+Context simulates GPU latency with fences that are signaled by the test,
+mapped pixels are generated, so encode and queue part can be measured without graphics device.
+*/
+
+static int g_failures = 0;
+
+#define CHECK(condition) \
+	do { if (!(condition)) { printf("  FAILED: %s (line %d)\n", #condition, __LINE__); ++g_failures; } } while (0)
+
+const int kWidth = 1920;
+const int kHeight = 1080;
+const char * kDirectory = "screenshot_output";
+
+//! Context with fences signaled by test and pixel buffers filled with frame number
+class ReadbackContext : public sht::graphics::NullContext {
+public:
+	ReadbackContext()
+	: completed_fence(0), num_reads(0), num_maps(0), num_waits(0), last_fence_(0), bound_buffer_(0)
+	{
+	}
+	SyncObject FenceSync()
+	{
+		return reinterpret_cast<SyncObject>(static_cast<uintptr_t>(++last_fence_));
+	}
+	bool ClientWaitSync(SyncObject sync, u64 timeout_ns)
+	{
+		const u32 fence = static_cast<u32>(reinterpret_cast<uintptr_t>(sync));
+		if (fence <= completed_fence)
+			return true;
+		if (timeout_ns == 0)
+			return false;
+		++num_waits; // GPU is forced to finish
+		completed_fence = fence;
+		return true;
+	}
+	void BindPixelPackBuffer(u32 obj)
+	{
+		bound_buffer_ = obj;
+	}
+	void ReadPixels(s32 x, s32 y, s32 w, s32 h, u32 format, u32 type, void *data)
+	{
+		++num_reads;
+		buffer_values_[bound_buffer_] = static_cast<u8>(num_reads);
+	}
+	const void* MapPixelPackBuffer(u32 size)
+	{
+		++num_maps;
+		mapped_buffer_.assign(size, buffer_values_[bound_buffer_]);
+		return &mapped_buffer_[0];
+	}
+
+	u32 completed_fence;
+	int num_reads;
+	int num_maps;
+	int num_waits;
+
+private:
+	u32 last_fence_;
+	u32 bound_buffer_;
+	std::map<u32, u8> buffer_values_;	//!< pixel value by buffer, the number of read
+};
+
+int main()
+{
+	sht::system::CreateDirectory(kDirectory);
+
+	// Readback is delayed until fence is signaled or the delay is over
+	{
+		ReadbackContext context;
+		ScreenshotQueue queue(&context, 3);
+		queue.Capture(64, 32, "screenshot_output/single.jpg");
+		CHECK(context.num_reads == 1);
+		queue.EndFrame(64, 32);
+		CHECK(context.num_maps == 0);
+		CHECK(queue.num_pending_readbacks() == 1);
+		context.completed_fence = 1;
+		queue.EndFrame(64, 32);
+		CHECK(context.num_maps == 1);
+		CHECK(queue.num_pending_readbacks() == 0);
+		queue.Flush();
+		CHECK(queue.stats().encoded == 1);
+		CHECK(queue.stats().stalls == 0);
+		Image image;
+		CHECK(image.LoadFromFile("screenshot_output/single.jpg"));
+		CHECK(image.width() == 64 && image.height() == 32);
+		CHECK(image.pixels() != nullptr && image.pixels()[0] <= 2); // value of the first read, lossy format
+
+		// GPU that never finishes on its own is waited for after the delay
+		queue.Capture(64, 32, "screenshot_output/late.jpg");
+		queue.EndFrame(64, 32);
+		queue.EndFrame(64, 32);
+		CHECK(context.num_maps == 1);
+		queue.EndFrame(64, 32);
+		CHECK(context.num_maps == 2);
+		CHECK(context.num_waits == 1);
+		queue.Flush();
+		CHECK(queue.stats().stalls == 1);
+		CHECK(queue.stats().encoded == 2);
+	}
+
+	// Continuous capture at 1080p: frames per second of readback hand-off and encoding
+	{
+		const int kNumFrames = 30;
+		ReadbackContext context;
+		ScreenshotQueue queue(&context, 3);
+		queue.set_max_pending_encodes(8);
+		sht::system::Clock clock;
+		const float start_time = clock.GetTime();
+		queue.StartSequence(kDirectory, "frame", "jpg");
+		CHECK(queue.sequence_active());
+		for (int frame = 0; frame < kNumFrames; ++frame)
+		{
+			// GPU is one frame behind
+			context.completed_fence = static_cast<u32>(frame);
+			queue.EndFrame(kWidth, kHeight);
+		}
+		const float queue_time = clock.GetTime() - start_time;
+		queue.StopSequence();
+		queue.Flush();
+		const float total_time = clock.GetTime() - start_time;
+		const ScreenshotQueue::Stats stats = queue.stats();
+		printf("%dx%d: %d frames queued in %.3f s, encoded at %.1f frames per second, %u stalls\n",
+			kWidth, kHeight, kNumFrames, queue_time, kNumFrames / total_time, stats.stalls);
+		CHECK(stats.captured == static_cast<u32>(kNumFrames));
+		CHECK(stats.encoded == static_cast<u32>(kNumFrames));
+		CHECK(stats.failed == 0);
+		CHECK(stats.stalls <= 1); // only the final flush may wait for GPU
+		CHECK(queue.num_pending_encodes() == 0);
+
+		// Files are numbered in capture order
+		Image image;
+		CHECK(image.LoadFromFile("screenshot_output/frame_000000.jpg"));
+		CHECK(image.width() == kWidth && image.height() == kHeight);
+		CHECK(image.LoadFromFile("screenshot_output/frame_000029.jpg"));
+		for (int frame = 0; frame < kNumFrames; ++frame)
+		{
+			char filename[64];
+			sprintf(filename, "screenshot_output/frame_%06d.jpg", frame);
+			remove(filename);
+		}
+	}
+	remove("screenshot_output/single.jpg");
+	remove("screenshot_output/late.jpg");
+	sht::system::RemoveDirectory(kDirectory);
+
+	if (g_failures)
+		printf("%d checks failed\n", g_failures);
+	else
+		printf("All checks passed\n");
+	return g_failures ? 1 : 0;
+}
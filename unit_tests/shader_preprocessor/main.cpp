@@ -0,0 +1,110 @@
+#include "sht/graphics/include/renderer/shader_preprocessor.h"
+#include "sht/graphics/include/renderer/shader_binary_cache.h"
+
+#include <stdio.h>
+#include <map>
+#include <string>
+#include <vector>
+
+using sht::graphics::ShaderBinaryCache;
+using sht::graphics::ShaderPreprocessor;
+
+/*
+Test for shader preprocessing and program binary cache.
+Sources are served from memory, so include resolution and source caching can be checked without GL.
+*/
+
+static int g_failures = 0;
+
+#define CHECK(condition) \
+	do { if (!(condition)) { printf("  FAILED: %s (line %d)\n", #condition, __LINE__); ++g_failures; } } while (0)
+
+int main()
+{
+	std::map<std::string, std::string> files;
+	files["shaders/common/light.glsl"] = "#include \"math.glsl\"\nvec3 light();\n";
+	files["shaders/common/math.glsl"] = "#include \"light.glsl\"\nfloat sqr(float x);"; // circular, no line break at the end
+	files["shaders/object.vs"] = "#version 330 core\n  #  include \"common/light.glsl\"\n#include \"common/math.glsl\"\nvoid main() {}\n";
+	files["shaders/object.fs"] = "#version 330 core\r\n#include \"common/../common/light.glsl\"\r\nvoid main() {}\r\n";
+	files["shaders/broken.vs"] = "#include \"missing.glsl\"\n";
+
+	std::vector<std::string> loaded;
+	ShaderPreprocessor preprocessor([&files, &loaded](const char *filename, std::string * source)
+	{
+		loaded.push_back(filename);
+		auto it = files.find(filename);
+		if (it == files.end())
+			return false;
+		*source = it->second;
+		return true;
+	});
+
+	// Includes are resolved relative to including file and inlined once
+	std::string vertex_source;
+	CHECK(preprocessor.Process("shaders/object.vs", &vertex_source));
+	CHECK(vertex_source == "#version 330 core\nfloat sqr(float x);\nvec3 light();\nvoid main() {}\n");
+	CHECK(preprocessor.num_loads() == 3);
+
+	// Shared files come from cache, paths are normalized
+	std::string fragment_source;
+	CHECK(preprocessor.Process("./shaders/object.fs", &fragment_source));
+	CHECK(fragment_source == "#version 330 core\r\nfloat sqr(float x);\nvec3 light();\nvoid main() {}\r\n");
+	CHECK(preprocessor.num_loads() == 4);
+	CHECK(preprocessor.num_cached_files() == 4);
+	CHECK(loaded.back() == "shaders/object.fs");
+
+	// Missing include fails with the file name
+	std::string broken_source;
+	CHECK(!preprocessor.Process("shaders/broken.vs", &broken_source));
+	CHECK(preprocessor.error().find("shaders/missing.glsl") != std::string::npos);
+
+	// Cache is dropped on demand, e.g. after files have been changed
+	files["shaders/common/math.glsl"] = "float sqr(float x) { return x * x; }\n";
+	std::string stale_source;
+	CHECK(preprocessor.Process("shaders/object.vs", &stale_source));
+	CHECK(stale_source == vertex_source);
+	preprocessor.ClearCache();
+	CHECK(preprocessor.num_cached_files() == 0);
+	std::string fresh_source;
+	CHECK(preprocessor.Process("shaders/object.vs", &fresh_source));
+	CHECK(fresh_source != vertex_source);
+
+	// Key is stable and depends on every input
+	const std::vector<std::string> attribs = { "position", "texcoord" };
+	const std::string driver = "vendor\nrenderer\n4.1\n";
+	const u64 key = ShaderPreprocessor::ComputeKey(vertex_source, fragment_source, attribs, driver);
+	printf("key %08x%08x\n", static_cast<u32>(key >> 32), static_cast<u32>(key));
+	CHECK(key == ShaderPreprocessor::ComputeKey(vertex_source, fragment_source, attribs, driver));
+	CHECK(key != ShaderPreprocessor::ComputeKey(fresh_source, fragment_source, attribs, driver));
+	CHECK(key != ShaderPreprocessor::ComputeKey(fragment_source, vertex_source, attribs, driver));
+	CHECK(key != ShaderPreprocessor::ComputeKey(vertex_source, fragment_source, { "position" }, driver));
+	CHECK(key != ShaderPreprocessor::ComputeKey(vertex_source, fragment_source, { "texcoord", "position" }, driver));
+	CHECK(key != ShaderPreprocessor::ComputeKey(vertex_source, fragment_source, attribs, "vendor\nrenderer\n4.2\n"));
+	CHECK(ShaderPreprocessor::ComputeKey("ab", "c", attribs, driver) != ShaderPreprocessor::ComputeKey("a", "bc", attribs, driver));
+
+	// Binaries round trip through files named by key
+	ShaderBinaryCache cache("");
+	CHECK(cache.GetFilename(0x0123456789abcdefULL) == "0123456789abcdef.bin");
+	std::vector<u8> binary;
+	for (int i = 0; i < 1000; ++i)
+		binary.push_back(static_cast<u8>(i * 7));
+	CHECK(cache.Store(key, 0x8741, binary));
+	u32 format = 0;
+	std::vector<u8> loaded_binary;
+	CHECK(cache.Load(key, &format, &loaded_binary));
+	CHECK(format == 0x8741);
+	CHECK(loaded_binary == binary);
+	CHECK(!cache.Load(key + 1, &format, &loaded_binary));
+
+	// File under wrong name is rejected
+	rename(cache.GetFilename(key).c_str(), cache.GetFilename(key + 1).c_str());
+	CHECK(!cache.Load(key + 1, &format, &loaded_binary));
+	cache.Remove(key + 1);
+	CHECK(!cache.Load(key, &format, &loaded_binary));
+
+	if (g_failures)
+		printf("%d checks failed\n", g_failures);
+	else
+		printf("All checks passed\n");
+	return g_failures ? 1 : 0;
+}
@@ -0,0 +1,8 @@
+#!/bin/sh
+SHT=../../sht
+g++ main.cpp \
+	$SHT/graphics/src/renderer/shader_binary_cache.cpp \
+	$SHT/graphics/src/renderer/shader_preprocessor.cpp \
+	$SHT/system/src/stream/*.cpp \
+	$SHT/system/src/string/filename.cpp \
+	-O2 -std=c++11 -I../../ -I$SHT -o shader_preprocessor
@@ -0,0 +1,218 @@
+#include "sht/graphics/include/image/texture_atlas.h"
+#include "sht/system/include/time/clock.h"
+
+#include <stdio.h>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using sht::graphics::AtlasRegion;
+using sht::graphics::Image;
+using sht::graphics::TextureAtlas;
+
+/*
+Test for texture atlas packer.
+Checks that regions don't overlap with borders, border pixels replicate image edges,
+baked atlas survives save and load, then measures occupancy and packing speed.
+*/
+
+static int g_failures = 0;
+
+#define CHECK(condition) \
+	do { if (!(condition)) { printf("  FAILED: %s (line %d)\n", #condition, __LINE__); ++g_failures; } } while (0)
+
+//! Image filled with single color, every pixel of a sprite should come from it
+static void MakeImage(Image * image, int width, int height, u8 value)
+{
+	image->Allocate(width, height, Image::Format::kRGBA8);
+	u8 * pixels = image->pixels();
+	for (int i = 0; i < width * height; ++i)
+	{
+		pixels[4 * i + 0] = value;
+		pixels[4 * i + 1] = static_cast<u8>(i % width);	// column helps to check borders
+		pixels[4 * i + 2] = static_cast<u8>(i / width);	// row
+		pixels[4 * i + 3] = 255;
+	}
+}
+
+static bool Overlap(const AtlasRegion& a, const AtlasRegion& b, int padding)
+{
+	if (a.page != b.page)
+		return false;
+	return a.x - padding < b.x + b.width + padding && b.x - padding < a.x + a.width + padding &&
+		a.y - padding < b.y + b.height + padding && b.y - padding < a.y + a.height + padding;
+}
+
+static bool CheckRegions(const TextureAtlas& atlas)
+{
+	const int padding = atlas.padding();
+	for (u32 i = 0; i < atlas.num_regions(); ++i)
+	{
+		const AtlasRegion& a = atlas.region(i);
+		if (a.x - padding < 0 || a.y - padding < 0 ||
+			a.x + a.width + padding > atlas.page_width() || a.y + a.height + padding > atlas.page_height())
+			return false;
+		for (u32 j = i + 1; j < atlas.num_regions(); ++j)
+			if (Overlap(a, atlas.region(j), padding))
+				return false;
+	}
+	return true;
+}
+
+static const u8 * Pixel(const Image& image, int x, int y)
+{
+	return image.pixels() + (static_cast<size_t>(y) * image.width() + x) * image.bpp();
+}
+
+//! Random sizes similar to icons and glyphs
+static void MakeRandomImages(int count, std::vector<Image> * images, std::vector<std::string> * names)
+{
+	images->resize(count);
+	names->resize(count);
+	srand(1);
+	for (int i = 0; i < count; ++i)
+	{
+		MakeImage(&(*images)[i], 8 + rand() % 56, 8 + rand() % 56, static_cast<u8>(i));
+		char name[16];
+		sprintf(name, "sprite%d", i);
+		(*names)[i] = name;
+	}
+}
+
+int main()
+{
+	// Incremental insertion
+	{
+		TextureAtlas atlas(256, 256, 2);
+		Image a, b, c;
+		MakeImage(&a, 30, 20, 1);
+		MakeImage(&b, 50, 40, 2);
+		MakeImage(&c, 10, 60, 3);
+		CHECK(atlas.Insert("a", a) == 0);
+		CHECK(atlas.Insert("b", b) == 1);
+		CHECK(atlas.Insert("c", c) == 2);
+		CHECK(atlas.Insert("a", b) < 0);				// name is taken
+		Image big;
+		MakeImage(&big, 254, 10, 4);
+		CHECK(atlas.Insert("big", big) < 0);			// doesn't fit with borders
+		Image gray;
+		gray.Allocate(4, 4, Image::Format::kA8);
+		gray.FillWithZeroes();
+		CHECK(atlas.Insert("gray", gray) < 0);			// other format
+		CHECK(atlas.num_pages() == 1);
+		CHECK(atlas.page_dirty(0));
+		atlas.ClearDirty();
+		CHECK(!atlas.page_dirty(0));
+		CHECK(CheckRegions(atlas));
+
+		int index = atlas.Find("b");
+		CHECK(index == 1);
+		CHECK(atlas.Find("missing") < 0);
+		const AtlasRegion& region = atlas.region(index);
+		CHECK(region.width == 50 && region.height == 40);
+		CHECK(region.u0 == region.x / 256.0f && region.v1 == (region.y + region.height) / 256.0f);
+
+		// Image and its borders
+		const Image& page = atlas.page(region.page);
+		CHECK(Pixel(page, region.x + 5, region.y + 7)[0] == 2);
+		CHECK(Pixel(page, region.x + 5, region.y + 7)[1] == 5);
+		CHECK(Pixel(page, region.x + 5, region.y + 7)[2] == 7);
+		CHECK(Pixel(page, region.x - 2, region.y + 7)[1] == 0);			// left column replicated
+		CHECK(Pixel(page, region.x + 51, region.y + 7)[1] == 49);		// right column
+		CHECK(Pixel(page, region.x + 5, region.y - 1)[2] == 0);			// bottom row
+		CHECK(Pixel(page, region.x + 5, region.y + 41)[2] == 39);		// top row
+		CHECK(Pixel(page, region.x - 1, region.y - 1)[0] == 2);			// corner
+		CHECK(Pixel(page, region.x + 51, region.y + 41)[1] == 49);
+
+		// Filling the page starts a new one
+		for (int i = 0; i < 40; ++i)
+		{
+			char name[16];
+			sprintf(name, "fill%d", i);
+			CHECK(atlas.Insert(name, b) >= 0);
+		}
+		CHECK(atlas.num_pages() > 1);
+		CHECK(!atlas.page_dirty(0) || atlas.num_pages() > 1);
+		CHECK(atlas.page_dirty(atlas.num_pages() - 1));
+		CHECK(CheckRegions(atlas));
+	}
+
+	// Offline build, bake and load
+	{
+		std::vector<Image> images;
+		std::vector<std::string> names;
+		MakeRandomImages(300, &images, &names);
+		std::vector<const Image*> pointers;
+		for (const auto& image : images)
+			pointers.push_back(&image);
+
+		TextureAtlas atlas(512, 512, 1);
+		CHECK(atlas.Build(names, pointers));
+		CHECK(atlas.num_regions() == 300);
+		CHECK(CheckRegions(atlas));
+		for (int i = 0; i < 300; ++i)
+		{
+			const AtlasRegion& region = atlas.region(atlas.Find(names[i].c_str()));
+			CHECK(region.width == images[i].width() && region.height == images[i].height());
+			CHECK(Pixel(atlas.page(region.page), region.x + region.width - 1, region.y)[0] == static_cast<u8>(i));
+		}
+
+		const char * filename = "atlas_test.bin";
+		const u64 key = 0x1234;
+		CHECK(atlas.Save(filename, key));
+		TextureAtlas loaded;
+		CHECK(!loaded.Load(filename, key + 1));		// built from other sources
+		CHECK(loaded.Load(filename, key));
+		CHECK(loaded.num_pages() == atlas.num_pages());
+		CHECK(loaded.num_regions() == atlas.num_regions());
+		CHECK(loaded.page_width() == 512 && loaded.padding() == 1);
+		bool same = true;
+		for (u32 i = 0; i < atlas.num_regions(); ++i)
+		{
+			const AtlasRegion& a = atlas.region(atlas.Find(names[i].c_str()));
+			const AtlasRegion& b = loaded.region(loaded.Find(names[i].c_str()));
+			same = same && a.page == b.page && a.x == b.x && a.y == b.y && a.u1 == b.u1 && a.v1 == b.v1;
+		}
+		CHECK(same);
+		for (u32 i = 0; i < atlas.num_pages(); ++i)
+			CHECK(memcmp(atlas.page(i).pixels(), loaded.page(i).pixels(), 512 * 512 * 4) == 0);
+		remove(filename);
+		CHECK(!loaded.Load(filename, key));
+	}
+
+	// Packing quality and speed
+	{
+		std::vector<Image> images;
+		std::vector<std::string> names;
+		MakeRandomImages(2000, &images, &names);
+		std::vector<const Image*> pointers;
+		for (const auto& image : images)
+			pointers.push_back(&image);
+
+		sht::system::Clock clock;
+		TextureAtlas incremental(1024, 1024, 2);
+		clock.MakeStartPoint();
+		for (size_t i = 0; i < images.size(); ++i)
+			incremental.Insert(names[i].c_str(), images[i]);
+		float incremental_time = clock.GetTime();
+
+		TextureAtlas sorted(1024, 1024, 2);
+		clock.MakeStartPoint();
+		CHECK(sorted.Build(names, pointers));
+		float sorted_time = clock.GetTime();
+		CHECK(CheckRegions(sorted));
+		CHECK(sorted.occupancy() > 0.7f);
+
+		printf("%u sprites, incremental: %u pages, occupancy %.1f%%, %.2f ms\n", incremental.num_regions(),
+			incremental.num_pages(), incremental.occupancy() * 100.0f, incremental_time * 1000.0f);
+		printf("%u sprites, sorted: %u pages, occupancy %.1f%%, %.2f ms\n", sorted.num_regions(),
+			sorted.num_pages(), sorted.occupancy() * 100.0f, sorted_time * 1000.0f);
+	}
+
+	if (g_failures == 0)
+		printf("All checks passed\n");
+	else
+		printf("%d checks failed\n", g_failures);
+	return g_failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,226 @@
+#include "sht/graphics/include/renderer/null_context.h"
+#include "sht/graphics/include/renderer/residency_manager.h"
+
+#include <stdio.h>
+#include <cstring>
+#include <map>
+#include <vector>
+
+using sht::graphics::Image;
+using sht::graphics::ResidencyManager;
+using sht::graphics::Texture;
+
+/*
+Test for texture residency manager.
+Context simulates video memory allocations, so the manager accounting can be checked against it
+while textures are demoted under budget and restored on use.
+*/
+
+static int g_failures = 0;
+
+#define CHECK(condition) \
+	do { if (!(condition)) { printf("  FAILED: %s (line %d)\n", #condition, __LINE__); ++g_failures; } } while (0)
+
+const int kNumTextures = 8;
+const int kTextureSize = 256;
+const u64 kTextureBytes = kTextureSize * kTextureSize * 4;
+
+//! Context that keeps size of base level of every texture
+class AllocatingContext : public sht::graphics::NullContext {
+public:
+	struct Level {
+		s32 width;
+		s32 height;
+		s32 bytes_per_pixel;
+	};
+
+	AllocatingContext()
+	: bound_texture(0), num_readbacks(0), readback_bytes(0)
+	{
+	}
+	void TextureImage2D(u32 target, s32 level, s32 internal_format, s32 w, s32 h,
+		u32 format, u32 type, const void *data)
+	{
+		if (level != 0)
+			return;
+		Level& base = levels[bound_texture];
+		base.width = w;
+		base.height = h;
+		base.bytes_per_pixel = (format == 0x1907) ? 3 : 4; // GL_RGB or GL_RGBA
+	}
+	void GetTextureImage(u32 target, s32 level, u32 format, u32 type, void *data)
+	{
+		++num_readbacks;
+		const Level& base = levels[bound_texture];
+		const s32 w = (base.width >> level) > 0 ? (base.width >> level) : 1;
+		const s32 h = (base.height >> level) > 0 ? (base.height >> level) : 1;
+		// Like OpenGL context does with pack alignment of 1
+		readback_bytes = static_cast<size_t>(w) * h * base.bytes_per_pixel;
+		memset(data, 0x7F, readback_bytes);
+	}
+	u64 allocated_bytes() const
+	{
+		u64 bytes = 0;
+		for (const auto& pair : levels)
+			bytes += static_cast<u64>(pair.second.width) * pair.second.height * pair.second.bytes_per_pixel;
+		return bytes;
+	}
+
+	u32 bound_texture;
+	int num_readbacks;
+	size_t readback_bytes;
+	std::map<u32, Level> levels;
+
+protected:
+	void ApiBindTexture(u32 target, u32 obj) { bound_texture = obj; }
+};
+
+class FakeTexture : public Texture {
+public:
+	FakeTexture(AllocatingContext * context, u32 id, int size, Image::Format format = Image::Format::kRGBA8)
+	{
+		width_ = size;
+		height_ = size;
+		format_ = format;
+		texture_id_ = id;
+		ChooseTarget();
+		context->BindTexture(target_, texture_id_);
+		context->TextureImage2D(target_, 0, GetInternalFormat(), size, size, GetSrcFormat(), GetSrcType(), nullptr);
+	}
+	~FakeTexture()
+	{
+	}
+	u32 GetSrcFormat() { return (format_ == Image::Format::kRGB8) ? 0x1907 : 0x1908; }
+	u32 GetSrcType() { return 0x1401; }
+	s32 GetInternalFormat() { return (format_ == Image::Format::kRGB8) ? 0x8051 : 0x8058; }
+
+protected:
+	void ChooseTarget() { target_ = 0x0DE1; }
+};
+
+int main()
+{
+	AllocatingContext context;
+	ResidencyManager manager(&context);
+
+	int num_loads = 0;
+	ResidencyManager::LoadFunction load = [&num_loads](Image * image)
+	{
+		++num_loads;
+		image->Allocate(kTextureSize, kTextureSize, Image::Format::kRGBA8);
+		return true;
+	};
+
+	// Evictable textures and a render target that is never touched by eviction
+	std::vector<FakeTexture*> textures;
+	for (int i = 0; i < kNumTextures; ++i)
+	{
+		textures.push_back(new FakeTexture(&context, 100 + i, kTextureSize));
+		manager.Add(textures.back());
+		manager.SetEvictable(textures.back(), load);
+	}
+	FakeTexture * render_target = new FakeTexture(&context, 200, 2 * kTextureSize);
+	manager.Add(render_target);
+	CHECK(manager.num_textures() == kNumTextures + 1);
+	CHECK(manager.num_evictable() == kNumTextures);
+	CHECK(manager.used_bytes() == (kNumTextures + 4) * kTextureBytes);
+	CHECK(manager.used_bytes() == context.allocated_bytes());
+
+	// Without budget nothing is evicted
+	manager.EndFrame();
+	CHECK(manager.counters().demotions == 0);
+
+	// Half of textures hasn't been used in the frame and gives its memory away
+	const u64 budget = (kNumTextures + 2) * kTextureBytes;
+	manager.set_budget(budget);
+	for (int i = kNumTextures / 2; i < kNumTextures; ++i)
+		manager.Touch(textures[i]);
+	manager.Touch(render_target);
+	manager.EndFrame();
+	const ResidencyManager::Counters& counters = manager.counters();
+	printf("budget %u KB: %u demotions, %u evictions, %u KB freed, %u KB used\n",
+		static_cast<u32>(budget >> 10), counters.demotions, counters.evictions,
+		static_cast<u32>(counters.freed_bytes >> 10), static_cast<u32>(manager.used_bytes() >> 10));
+	CHECK(manager.used_bytes() <= budget);
+	CHECK(manager.used_bytes() == context.allocated_bytes());
+	CHECK(counters.freed_bytes >= 2 * kTextureBytes);
+	CHECK(counters.demotions == static_cast<u32>(context.num_readbacks));
+	CHECK(counters.over_budget_frames == 0);
+	// Least recently used texture goes first and reaches minimal size, then the next one drops mips
+	CHECK(textures[0]->width() == 1 && textures[0]->height() == 1);
+	CHECK(manager.mip_bias(textures[0]) == 8);
+	CHECK(counters.evictions >= 1);
+	CHECK(manager.mip_bias(textures[2]) > 0);
+	for (int i = kNumTextures / 2; i < kNumTextures; ++i)
+		CHECK(manager.mip_bias(textures[i]) == 0);
+	CHECK(render_target->width() == 2 * kTextureSize);
+	CHECK(manager.num_demoted() >= 3);
+
+	// Used demoted texture is restored from source, unused ones give way
+	manager.Touch(textures[0]);
+	for (int i = kNumTextures / 2; i < kNumTextures; ++i)
+		manager.Touch(textures[i]);
+	manager.EndFrame();
+	CHECK(counters.restores == 1);
+	CHECK(num_loads == 1);
+	CHECK(textures[0]->width() == kTextureSize);
+	CHECK(manager.mip_bias(textures[0]) == 0);
+	CHECK(manager.used_bytes() <= budget);
+	CHECK(manager.used_bytes() == context.allocated_bytes());
+
+	// Restore that can't fit budget even after demotions is postponed
+	manager.set_budget(kNumTextures * kTextureBytes);
+	for (int i = 0; i < kNumTextures; ++i)
+		manager.Touch(textures[i]);
+	manager.Touch(render_target);
+	const u32 num_demoted = manager.num_demoted();
+	manager.EndFrame();
+	CHECK(num_demoted > 0);
+	CHECK(counters.restores == 0);
+	CHECK(counters.failed_restores == num_demoted);
+	CHECK(counters.over_budget_frames == 1);
+	CHECK(num_loads == 1);
+
+	// Request is dropped when texture isn't used anymore
+	manager.set_budget(0);
+	manager.EndFrame();
+	CHECK(counters.failed_restores == 0 && counters.restores == 0);
+
+	// Removal keeps accounting consistent
+	for (auto texture : textures)
+		manager.Remove(texture);
+	CHECK(manager.num_textures() == 1);
+	CHECK(manager.num_evictable() == 0);
+	CHECK(manager.num_demoted() == 0);
+	CHECK(manager.used_bytes() == 4 * kTextureBytes);
+
+	for (auto texture : textures)
+		delete texture;
+	delete render_target;
+
+	// Rows of RGB levels aren't multiple of four bytes, staging must hold exactly what is read back
+	{
+		AllocatingContext rgb_context;
+		ResidencyManager rgb_manager(&rgb_context);
+		FakeTexture * rgb_texture = new FakeTexture(&rgb_context, 300, 6, Image::Format::kRGB8);
+		rgb_manager.Add(rgb_texture);
+		rgb_manager.SetEvictable(rgb_texture, load);
+		CHECK(rgb_manager.used_bytes() == 6 * 6 * 3);
+		rgb_manager.EndFrame();
+		rgb_manager.set_budget(64);
+		rgb_manager.EndFrame();
+		CHECK(rgb_texture->width() == 3 && rgb_texture->height() == 3);
+		CHECK(rgb_context.num_readbacks == 1);
+		CHECK(rgb_context.readback_bytes == 3 * 3 * 3);
+		CHECK(rgb_manager.used_bytes() == 3 * 3 * 3);
+		CHECK(rgb_manager.used_bytes() == rgb_context.allocated_bytes());
+		rgb_manager.Remove(rgb_texture);
+		delete rgb_texture;
+	}
+
+	if (g_failures)
+		printf("%d checks failed\n", g_failures);
+	else
+		printf("All checks passed\n");
+	return g_failures ? 1 : 0;
+}
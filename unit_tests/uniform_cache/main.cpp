@@ -0,0 +1,340 @@
+#include "sht/graphics/include/renderer/null_context.h"
+#include "sht/graphics/include/renderer/shader.h"
+#include "sht/graphics/include/renderer/uniform_buffer.h"
+
+#include <stdio.h>
+#include <stddef.h>
+#include <string.h>
+#include <map>
+#include <vector>
+
+using sht::graphics::Shader;
+using sht::graphics::UniformHandle;
+using sht::graphics::UniformInfo;
+
+/*
+Test for shader uniforms cache and uniform buffers.
+Counts driver calls per frame of planet-like tile rendering: each tile sets five uniforms,
+some of them are the same for all tiles of a face.
+*/
+
+static int g_failures = 0;
+
+#define CHECK(condition) \
+	do { if (!(condition)) { printf("  FAILED: %s (line %d)\n", #condition, __LINE__); ++g_failures; } } while (0)
+
+enum {
+	kStuvScale = 1,
+	kStuvPosition,
+	kSkirtHeight,
+	kFaceTransform,
+	kColor,
+	kLights
+};
+
+//! Context that counts driver calls and remembers values set by location
+class RecordingContext : public sht::graphics::NullContext {
+public:
+	RecordingContext()
+	: num_calls(0), num_location_queries(0), num_buffer_updates(0), updated_bytes(0)
+	{
+	}
+	void GetActiveUniforms(u32 program, std::vector<UniformInfo> * uniforms)
+	{
+		const UniformInfo kUniforms[] = {
+			{ "u_stuv_scale", kStuvScale, 0, 16, 1 },
+			{ "u_stuv_position", kStuvPosition, 0, 16, 1 },
+			{ "u_skirt_height", kSkirtHeight, 0, 4, 1 },
+			{ "u_face_transform", kFaceTransform, 0, 36, 1 },
+			{ "u_color", kColor, 0, 16, 1 },
+			{ "u_lights", kLights, 0, 16, 4 },
+		};
+		uniforms->assign(kUniforms, kUniforms + sizeof(kUniforms) / sizeof(kUniforms[0]));
+	}
+	// Name based functions query location each time
+	void Uniform1f(u32 program, const char *name, float x)
+	{
+		num_calls += 2;
+		++num_location_queries;
+	}
+	void Uniform4fv(u32 program, const char *name, const float *v, int n)
+	{
+		num_calls += 2;
+		++num_location_queries;
+	}
+	void UniformMatrix3fv(u32 program, const char *name, const float *v, bool trans, int n)
+	{
+		num_calls += 2;
+		++num_location_queries;
+	}
+	void SetUniform1f(s32 location, float x)
+	{
+		++num_calls;
+		Store(location, &x, 1);
+	}
+	void SetUniform4fv(s32 location, const float *v, int n)
+	{
+		++num_calls;
+		Store(location, v, 4 * n);
+	}
+	void SetUniformMatrix3fv(s32 location, const float *v, bool trans, int n)
+	{
+		++num_calls;
+		Store(location, v, 9 * n);
+	}
+	void BindUniformBuffer(u32 obj)
+	{
+		++num_calls;
+	}
+	void UniformBufferSubData(u32 offset, u32 size, const void *data)
+	{
+		++num_calls;
+		++num_buffer_updates;
+		updated_bytes += size;
+		last_offset = offset;
+	}
+	void BindUniformBufferBase(u32 binding, u32 obj)
+	{
+		++num_calls;
+	}
+
+	int num_calls;
+	int num_location_queries;
+	int num_buffer_updates;
+	u32 updated_bytes;
+	u32 last_offset;
+	std::map<s32, std::vector<float>> values;
+
+private:
+	void Store(s32 location, const float *v, int count)
+	{
+		values[location].assign(v, v + count);
+	}
+};
+
+//! Shader with program created outside
+class TestShader : public Shader {
+public:
+	TestShader(sht::graphics::Context * context, u32 program)
+	: Shader(context)
+	{
+		program_ = program;
+		ReflectUniforms();
+	}
+	~TestShader()
+	{
+	}
+};
+
+struct Tile {
+	float stuv_scale[4];
+	float stuv_position[4];
+	float skirt_height;
+	int face;
+	float color[4];
+};
+
+static std::vector<Tile> MakeTiles(int frame)
+{
+	std::vector<Tile> tiles;
+	for (int face = 0; face < 6; ++face)
+		for (int i = 0; i < 16; ++i)
+		{
+			Tile tile;
+			for (int k = 0; k < 4; ++k)
+			{
+				tile.stuv_scale[k] = 0.25f;
+				tile.stuv_position[k] = static_cast<float>(i * 4 + k + frame);
+				tile.color[k] = 1.0f;
+			}
+			tile.skirt_height = 0.01f;
+			tile.face = face;
+			tiles.push_back(tile);
+		}
+	return tiles;
+}
+static void FaceTransform(int face, float * matrix)
+{
+	for (int k = 0; k < 9; ++k)
+		matrix[k] = static_cast<float>((k % 4 == 0) ? face + 1 : 0);
+}
+
+//! Renders tiles the way it has been done before uniforms cache
+static void RenderFrameByName(RecordingContext * context, u32 program, const std::vector<Tile>& tiles)
+{
+	float matrix[9];
+	for (const auto& tile : tiles)
+	{
+		FaceTransform(tile.face, matrix);
+		context->Uniform4fv(program, "u_stuv_scale", tile.stuv_scale, 1);
+		context->Uniform4fv(program, "u_stuv_position", tile.stuv_position, 1);
+		context->Uniform1f(program, "u_skirt_height", tile.skirt_height);
+		context->UniformMatrix3fv(program, "u_face_transform", matrix, false, 1);
+		context->Uniform4fv(program, "u_color", tile.color, 1);
+	}
+}
+static void RenderFrameShaderNames(Shader * shader, const std::vector<Tile>& tiles)
+{
+	float matrix[9];
+	for (const auto& tile : tiles)
+	{
+		FaceTransform(tile.face, matrix);
+		shader->Uniform4fv("u_stuv_scale", tile.stuv_scale);
+		shader->Uniform4fv("u_stuv_position", tile.stuv_position);
+		shader->Uniform1f("u_skirt_height", tile.skirt_height);
+		shader->UniformMatrix3fv("u_face_transform", matrix);
+		shader->Uniform4fv("u_color", tile.color);
+	}
+}
+static void RenderFrameHandles(Shader * shader, const UniformHandle * handles, const std::vector<Tile>& tiles)
+{
+	float matrix[9];
+	for (const auto& tile : tiles)
+	{
+		FaceTransform(tile.face, matrix);
+		shader->Uniform4fv(handles[0], tile.stuv_scale);
+		shader->Uniform4fv(handles[1], tile.stuv_position);
+		shader->Uniform1f(handles[2], tile.skirt_height);
+		shader->UniformMatrix3fv(handles[3], matrix);
+		shader->Uniform4fv(handles[4], tile.color);
+	}
+}
+
+static void TestUniformCache()
+{
+	printf("Uniforms cache\n");
+	RecordingContext context;
+	TestShader shader(&context, 1);
+	const u32 program = 1;
+
+	UniformHandle handles[5] = {
+		shader.GetUniformHandle("u_stuv_scale"),
+		shader.GetUniformHandle("u_stuv_position"),
+		shader.GetUniformHandle("u_skirt_height"),
+		shader.GetUniformHandle("u_face_transform"),
+		shader.GetUniformHandle("u_color"),
+	};
+	for (int i = 0; i < 5; ++i)
+		CHECK(handles[i].valid());
+	CHECK(!shader.GetUniformHandle("u_missing").valid());
+
+	const std::vector<Tile> tiles = MakeTiles(0);
+	const int num_tiles = static_cast<int>(tiles.size());
+
+	RenderFrameByName(&context, program, tiles);
+	const int calls_before = context.num_calls;
+	CHECK(calls_before == num_tiles * 5 * 2);
+
+	context.num_calls = 0;
+	context.num_location_queries = 0;
+	RenderFrameShaderNames(&shader, tiles);
+	const int calls_names = context.num_calls;
+	CHECK(context.num_location_queries == 0);
+
+	// Second frame: only tile positions change
+	const std::vector<Tile> next_tiles = MakeTiles(1);
+	context.num_calls = 0;
+	RenderFrameHandles(&shader, handles, next_tiles);
+	const int calls_handles = context.num_calls;
+	// Position per tile, face transform per face and nothing else
+	CHECK(calls_handles == num_tiles + 6);
+
+	printf("  driver calls per frame: %d by name, %d cached by name, %d with handles\n",
+		calls_before, calls_names, calls_handles);
+	CHECK(calls_names < calls_before && calls_handles < calls_names);
+
+	// Last sent values match the last tile
+	const Tile& last = next_tiles.back();
+	CHECK(context.values[kStuvPosition].size() == 4 &&
+		memcmp(&context.values[kStuvPosition][0], last.stuv_position, sizeof(last.stuv_position)) == 0);
+	float matrix[9];
+	FaceTransform(last.face, matrix);
+	CHECK(memcmp(&context.values[kFaceTransform][0], matrix, sizeof(matrix)) == 0);
+
+	// Transposed matrices aren't cached
+	context.num_calls = 0;
+	shader.UniformMatrix3fv(handles[3], matrix, true);
+	shader.UniformMatrix3fv(handles[3], matrix, false);
+	CHECK(context.num_calls == 2);
+
+	// Arrays are cached up to their size
+	UniformHandle lights = shader.GetUniformHandle("u_lights");
+	CHECK(lights.valid());
+	float light_values[20] = { 0.0f };
+	light_values[0] = 1.0f;
+	context.num_calls = 0;
+	shader.Uniform4fv(lights, light_values, 4);
+	shader.Uniform4fv(lights, light_values, 4);
+	shader.Uniform4fv(lights, light_values, 2);
+	CHECK(context.num_calls == 1);
+	light_values[7] = 2.0f;
+	shader.Uniform4fv(lights, light_values, 4);
+	CHECK(context.num_calls == 2);
+
+	// Missing uniforms use name based functions
+	context.num_location_queries = 0;
+	shader.Uniform1f("u_missing", 1.0f);
+	CHECK(context.num_location_queries == 1);
+}
+
+struct FrameData {
+	float view_projection[16];
+	float light_direction[4];
+	float time[4];
+};
+
+static void TestUniformBuffer()
+{
+	printf("Uniform buffer\n");
+	RecordingContext context;
+	sht::graphics::TypedUniformBuffer<FrameData> buffer(&context);
+	CHECK(buffer.size() == sizeof(FrameData));
+
+	FrameData data;
+	memset(&data, 0, sizeof(data));
+	for (int i = 0; i < 16; ++i)
+		data.view_projection[i] = static_cast<float>(i);
+
+	// Initial contents are zero, only changed range is sent
+	buffer.Set(data);
+	context.num_buffer_updates = 0;
+	context.updated_bytes = 0;
+	buffer.Bind(0);
+	CHECK(context.num_buffer_updates == 1);
+	CHECK(context.updated_bytes == sizeof(float) * 15 && context.last_offset == sizeof(float));
+
+	// Unchanged data isn't sent again
+	context.num_buffer_updates = 0;
+	for (int frame = 0; frame < 10; ++frame)
+	{
+		buffer.Set(data);
+		buffer.Bind(0);
+	}
+	CHECK(context.num_buffer_updates == 0);
+
+	// Member update sends changed words of member only
+	const float time[4] = { 1.0f, 0.0f, 0.0f, 0.0f };
+	buffer.Set(&FrameData::time, time);
+	context.updated_bytes = 0;
+	buffer.Flush();
+	CHECK(context.num_buffer_updates == 1);
+	CHECK(context.last_offset == offsetof(FrameData, time) && context.updated_bytes == sizeof(float));
+	CHECK(buffer.value().time[0] == 1.0f);
+
+	// Uniform blocks aren't reported by null context
+	RecordingContext shader_context;
+	TestShader shader(&shader_context, 1);
+	CHECK(!shader.BindUniformBlock("FrameData", 0));
+}
+
+int main()
+{
+	TestUniformCache();
+	TestUniformBuffer();
+
+	if (g_failures)
+		printf("%d checks failed\n", g_failures);
+	else
+		printf("All checks passed\n");
+	return g_failures ? 1 : 0;
+}
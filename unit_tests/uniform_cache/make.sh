@@ -0,0 +1,11 @@
+#!/bin/sh
+# Builds uniforms cache test
+SHT=../../sht
+g++ main.cpp \
+	$SHT/graphics/src/renderer/context.cpp \
+	$SHT/graphics/src/renderer/null_context.cpp \
+	$SHT/graphics/src/renderer/shader.cpp \
+	$SHT/graphics/src/renderer/uniform_buffer.cpp \
+	$SHT/system/src/stream/*.cpp \
+	$SHT/utility/src/string_id.cpp \
+	-O2 -std=c++11 -I../../ -I$SHT -o uniform_cache
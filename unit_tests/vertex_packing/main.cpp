@@ -0,0 +1,279 @@
+#include "sht/graphics/include/renderer/vertex_packing.h"
+#include "sht/graphics/include/model/vertex_packer.h"
+
+#include <stdio.h>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+using sht::graphics::Vertex;
+using sht::graphics::VertexAttribute;
+using sht::graphics::VertexPacker;
+
+/*
+Test for vertex attribute packing.
+Every format is checked against its documented error bound on random and edge values,
+then packer is checked to choose compact formats and to shrink standard vertex.
+*/
+
+static int g_failures = 0;
+
+#define CHECK(condition) \
+	do { if (!(condition)) { printf("  FAILED: %s (line %d)\n", #condition, __LINE__); ++g_failures; } } while (0)
+
+static float Random(float min_value, float max_value)
+{
+	return min_value + (max_value - min_value) * static_cast<float>(rand()) / static_cast<float>(RAND_MAX);
+}
+
+static vec3 RandomDirection()
+{
+	vec3 v;
+	do {
+		v = vec3(Random(-1.0f, 1.0f), Random(-1.0f, 1.0f), Random(-1.0f, 1.0f));
+	} while (v.Sqr() < 1e-4f || v.Sqr() > 1.0f);
+	v.Normalize();
+	return v;
+}
+
+//! Returns maximum absolute error of round trip
+static float MeasureError(VertexAttribute::Format format, float min_value, float max_value, u32 size)
+{
+	float max_error = 0.0f;
+	u8 data[16];
+	float values[4], decoded[4];
+	for (int n = 0; n < 10000; ++n)
+	{
+		for (u32 i = 0; i < size; ++i)
+			values[i] = Random(min_value, max_value);
+		if (n < 2) // range bounds
+			for (u32 i = 0; i < size; ++i)
+				values[i] = (n == 0) ? min_value : max_value;
+		sht::graphics::PackAttribute(format, values, size, data);
+		sht::graphics::UnpackAttribute(format, data, size, decoded);
+		for (u32 i = 0; i < size; ++i)
+			max_error = std::max(max_error, fabsf(decoded[i] - values[i]));
+	}
+	return max_error;
+}
+
+static void TestHalf()
+{
+	using sht::graphics::FloatToHalf;
+	using sht::graphics::HalfToFloat;
+	CHECK(FloatToHalf(0.0f) == 0x0000);
+	CHECK(FloatToHalf(-0.0f) == 0x8000);
+	CHECK(FloatToHalf(1.0f) == 0x3c00);
+	CHECK(FloatToHalf(-2.0f) == 0xc000);
+	CHECK(FloatToHalf(65504.0f) == 0x7bff);
+	CHECK(FloatToHalf(65520.0f) == 0x7c00);			// overflow rounds to infinity
+	CHECK(FloatToHalf(1e10f) == 0x7c00);
+	CHECK(FloatToHalf(5.9604645e-8f) == 0x0001);	// smallest denormal
+	CHECK(FloatToHalf(2.0e-8f) == 0x0000);
+	CHECK(FloatToHalf(1.0f + 1.0f / 2048.0f) == 0x3c00);	// tie rounds to even
+	CHECK(FloatToHalf(1.0f + 3.0f / 2048.0f) == 0x3c02);
+	CHECK((FloatToHalf(NAN) & 0x7c00) == 0x7c00 && (FloatToHalf(NAN) & 0x3ff) != 0);
+	CHECK(HalfToFloat(0x3c00) == 1.0f);
+	CHECK(HalfToFloat(0x0001) == 5.9604645e-8f);
+	CHECK(std::isinf(HalfToFloat(0x7c00)));
+
+	// Every finite half survives round trip
+	bool exact = true;
+	for (u32 h = 0; h < 0x10000; ++h)
+	{
+		if ((h & 0x7c00) == 0x7c00)
+			continue;
+		if (FloatToHalf(HalfToFloat(static_cast<u16>(h))) != h)
+			exact = false;
+	}
+	CHECK(exact);
+
+	// Relative error is half of ulp
+	float max_relative = 0.0f;
+	for (int n = 0; n < 100000; ++n)
+	{
+		float value = Random(-1000.0f, 1000.0f);
+		if (fabsf(value) < 1e-3f)
+			continue;
+		float decoded = HalfToFloat(FloatToHalf(value));
+		max_relative = std::max(max_relative, fabsf(decoded - value) / fabsf(value));
+	}
+	CHECK(max_relative <= 1.0f / 2048.0f);
+	printf("half: relative error %g\n", max_relative);
+}
+
+static void TestNormalized()
+{
+	struct Case {
+		VertexAttribute::Format format;
+		const char * name;
+		float min_value;
+		float max_value;
+		u32 size;
+		float bound;
+	};
+	const Case cases[] = {
+		{ VertexAttribute::kSnorm16, "snorm16", -1.0f, 1.0f, 3, 1.0f / 65534.0f },
+		{ VertexAttribute::kUnorm16, "unorm16", 0.0f, 1.0f, 2, 1.0f / 131070.0f },
+		{ VertexAttribute::kSnorm8, "snorm8", -1.0f, 1.0f, 4, 1.0f / 254.0f },
+		{ VertexAttribute::kUnorm8, "unorm8", 0.0f, 1.0f, 4, 1.0f / 510.0f },
+		{ VertexAttribute::kSnorm10, "snorm10", -1.0f, 1.0f, 3, 1.0f / 1022.0f },
+	};
+	for (const auto& c : cases)
+	{
+		float error = MeasureError(c.format, c.min_value, c.max_value, c.size);
+		printf("%s: error %g, bound %g\n", c.name, error, c.bound);
+		CHECK(error <= c.bound * 1.01f);		// float arithmetic adds a little
+	}
+
+	// Out of range values are clamped, negative zero of snorm is exact
+	u8 data[8];
+	float value = 2.0f, decoded = 0.0f;
+	sht::graphics::PackAttribute(VertexAttribute::kSnorm16, &value, 1, data);
+	sht::graphics::UnpackAttribute(VertexAttribute::kSnorm16, data, 1, &decoded);
+	CHECK(decoded == 1.0f);
+	value = -1.0f;
+	sht::graphics::PackAttribute(VertexAttribute::kSnorm10, &value, 1, data);
+	sht::graphics::UnpackAttribute(VertexAttribute::kSnorm10, data, 1, &decoded);
+	CHECK(decoded == -1.0f);
+
+	// 10-10-10-2 keeps components apart and w is zero
+	float normal[3] = { -1.0f, 0.5f, 1.0f };
+	sht::graphics::PackAttribute(VertexAttribute::kSnorm10, normal, 3, data);
+	u32 packed;
+	memcpy(&packed, data, sizeof(packed));
+	CHECK((packed >> 30) == 0);
+	CHECK((packed & 0x3ff) == 0x201);		// -511
+	CHECK(((packed >> 20) & 0x3ff) == 511);
+}
+
+static void TestOctahedral()
+{
+	float max_error = 0.0f;
+	u8 data[4];
+	float decoded[3];
+	const vec3 axes[] = { vec3(1.0f, 0.0f, 0.0f), vec3(0.0f, -1.0f, 0.0f), vec3(0.0f, 0.0f, 1.0f), vec3(0.0f, 0.0f, -1.0f) };
+	for (int n = 0; n < 100000; ++n)
+	{
+		vec3 v = (n < 4) ? axes[n] : RandomDirection();
+		sht::graphics::PackAttribute(VertexAttribute::kOctahedral16, v, 3, data);
+		sht::graphics::UnpackAttribute(VertexAttribute::kOctahedral16, data, 3, decoded);
+		for (int i = 0; i < 3; ++i)
+			max_error = std::max(max_error, fabsf(decoded[i] - v[i]));
+	}
+	printf("octahedral16: error %g\n", max_error);
+	CHECK(max_error < 6e-5f);
+}
+
+static void TestPacker()
+{
+	std::vector<Vertex> vertices(1000);
+	for (auto& v : vertices)
+	{
+		v.position = vec3(Random(-10.0f, 30.0f), Random(0.0f, 5.0f), Random(-2.0f, 2.0f));
+		v.normal = RandomDirection();
+		v.texcoord = vec2(Random(0.0f, 1.0f), Random(0.0f, 1.0f));
+		v.tangent = RandomDirection();
+		v.binormal = v.normal ^ v.tangent;
+	}
+	std::vector<VertexAttribute> attribs;
+	attribs.push_back(VertexAttribute(VertexAttribute::kVertex, 3));
+	attribs.push_back(VertexAttribute(VertexAttribute::kNormal, 3));
+	attribs.push_back(VertexAttribute(VertexAttribute::kTexcoord, 2));
+	attribs.push_back(VertexAttribute(VertexAttribute::kTangent, 3));
+	attribs.push_back(VertexAttribute(VertexAttribute::kBinormal, 3));
+
+	// Without compression data is plain floats
+	{
+		std::vector<VertexAttribute> plain = attribs;
+		VertexPacker packer;
+		packer.AddVertices(vertices);
+		packer.ChooseFormats(&plain);
+		u32 vertex_size = 0;
+		for (const auto& a : plain)
+		{
+			CHECK(a.format == VertexAttribute::kFloat);
+			vertex_size += sht::graphics::GetAttributeSize(a.format, a.size);
+		}
+		CHECK(vertex_size == 56);
+		std::vector<u8> data(vertices.size() * vertex_size);
+		packer.Pack(vertices, plain, vertex_size, &data[0]);
+		CHECK(memcmp(&data[56 * 7 + 12], &vertices[7].normal, 12) == 0);
+	}
+
+	// Full compression
+	VertexPacker packer(sht::graphics::kCompressAll);
+	packer.AddVertices(vertices);
+	std::vector<VertexAttribute> packed = attribs;
+	packed[3].format = VertexAttribute::kOctahedral16;		// explicit format is kept
+	packer.ChooseFormats(&packed);
+	CHECK(packed[0].format == VertexAttribute::kSnorm16);
+	CHECK(packed[1].format == VertexAttribute::kSnorm10);
+	CHECK(packed[2].format == VertexAttribute::kUnorm16);
+	CHECK(packed[3].format == VertexAttribute::kOctahedral16);
+	CHECK(packed[4].format == VertexAttribute::kSnorm10);
+	u32 vertex_size = 0;
+	for (const auto& a : packed)
+		vertex_size += sht::graphics::GetAttributeSize(a.format, a.size);
+	CHECK(vertex_size == 24);
+	printf("vertex size: 56 -> %u bytes\n", vertex_size);
+
+	const sht::graphics::VertexQuantization& q = packer.quantization();
+	CHECK(fabsf(q.scale - 20.0f) < 0.2f);
+	std::vector<u8> data(vertices.size() * vertex_size);
+	packer.Pack(vertices, packed, vertex_size, &data[0]);
+	float max_position_error = 0.0f;
+	float max_normal_error = 0.0f;
+	float max_texcoord_error = 0.0f;
+	for (size_t n = 0; n < vertices.size(); ++n)
+	{
+		const u8 * ptr = &data[n * vertex_size];
+		float values[3];
+		sht::graphics::UnpackAttribute(packed[0].format, ptr, 3, values);
+		vec3 position = vec3(values[0], values[1], values[2]) * q.scale + q.offset;
+		max_position_error = std::max(max_position_error, (position - vertices[n].position).Length());
+		ptr += 8;
+		sht::graphics::UnpackAttribute(packed[1].format, ptr, 3, values);
+		max_normal_error = std::max(max_normal_error, (vec3(values[0], values[1], values[2]) - vertices[n].normal).Length());
+		ptr += 4;
+		sht::graphics::UnpackAttribute(packed[2].format, ptr, 2, values);
+		max_texcoord_error = std::max(max_texcoord_error, (vec2(values[0], values[1]) - vertices[n].texcoord).Length());
+	}
+	printf("quantized position error %g, normal error %g, texcoord error %g\n",
+		max_position_error, max_normal_error, max_texcoord_error);
+	CHECK(max_position_error <= q.scale * 0.5f / 32767.0f * 1.7321f * 1.001f);
+	CHECK(max_normal_error <= 1.7321f / 1022.0f);
+	CHECK(max_texcoord_error <= 1.4143f / 131070.0f);
+
+	// Texcoords out of [0,1]
+	vertices[0].texcoord = vec2(-0.5f, 0.5f);
+	VertexPacker signed_packer(sht::graphics::kCompressTexcoords);
+	signed_packer.AddVertices(vertices);
+	std::vector<VertexAttribute> texcoords = attribs;
+	signed_packer.ChooseFormats(&texcoords);
+	CHECK(texcoords[0].format == VertexAttribute::kFloat);
+	CHECK(texcoords[2].format == VertexAttribute::kSnorm16);
+	CHECK(signed_packer.quantization().scale == 1.0f);
+	vertices[0].texcoord = vec2(8.0f, 0.5f);
+	VertexPacker tiled_packer(sht::graphics::kCompressTexcoords);
+	tiled_packer.AddVertices(vertices);
+	texcoords = attribs;
+	tiled_packer.ChooseFormats(&texcoords);
+	CHECK(texcoords[2].format == VertexAttribute::kHalf);
+}
+
+int main()
+{
+	srand(7);
+	TestHalf();
+	TestNormalized();
+	TestOctahedral();
+	TestPacker();
+
+	if (g_failures == 0)
+		printf("All checks passed\n");
+	else
+		printf("%d checks failed\n", g_failures);
+	return g_failures == 0 ? 0 : 1;
+}
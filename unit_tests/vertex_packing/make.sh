@@ -0,0 +1,8 @@
+#!/bin/sh
+# Builds vertex packing test
+SHT=../../sht
+g++ main.cpp \
+	$SHT/graphics/src/renderer/vertex_packing.cpp \
+	$SHT/graphics/src/model/vertex_packer.cpp \
+	$SHT/math/*.cpp \
+	-O2 -std=c++11 -I../../ -I$SHT -o vertex_packing